@@ -32,6 +32,7 @@
 #define XN_PLATFORM_STRING "MacOSX"
 
 #define XN_PLATFORM_HAS_NO_TIMED_OPS
+#define XN_PLATFORM_HAS_NO_FUTEX
 #define XN_PLATFORM_HAS_NO_CLOCK_GETTIME
 #define XN_PLATFORM_HAS_NO_SCHED_PARAM
 #define XN_PLATFORM_HAS_BUILTIN_SEMUN
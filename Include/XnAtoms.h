@@ -0,0 +1,83 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_ATOMS_H_
+#define _XN_ATOMS_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/**
+* An interned string. Every distinct string is given one atom, which stays valid for the lifetime of
+* the process, so comparing two atoms is the same as comparing the strings they were interned from.
+* Atoms are meant for names that are looked up over and over again (node names, property names), so
+* that code on a per-frame path can key its tables by an integer instead of hashing strings.
+*/
+typedef XnUInt32 XnAtom;
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** An atom no string is interned to. */
+#define XN_INVALID_ATOM		((XnAtom)0)
+
+//---------------------------------------------------------------------------
+// Exported Function Declaration
+//---------------------------------------------------------------------------
+
+/**
+* Gets the atom of a string, interning it if this is the first time it is seen. Interning a string
+* that already has an atom takes no lock.
+*
+* @param	strName	[in]	The string to intern.
+* @param	pAtom	[out]	The atom of the string.
+*/
+XN_C_API XnStatus XN_C_DECL xnAtomIntern(const XnChar* strName, XnAtom* pAtom);
+
+/**
+* Gets the atom of a string without interning it. Takes no lock, and may be called from any thread.
+*
+* @param	strName	[in]	The string to look for.
+* @param	pAtom	[out]	The atom of the string.
+*
+* @returns XN_STATUS_NO_MATCH if the string was never interned.
+*/
+XN_C_API XnStatus XN_C_DECL xnAtomFind(const XnChar* strName, XnAtom* pAtom);
+
+/**
+* Gets the string an atom was interned from. The string is never freed.
+*
+* @param	atom	[in]	The atom.
+*
+* @returns NULL if @a atom is not a valid atom.
+*/
+XN_C_API const XnChar* XN_C_DECL xnAtomGetString(XnAtom atom);
+
+/**
+* Gets the number of strings interned so far. Valid atoms are 1 to this number.
+*/
+XN_C_API XnUInt32 XN_C_DECL xnAtomGetCount();
+
+#endif //_XN_ATOMS_H_
@@ -28,6 +28,9 @@
 #define XN_CODEC_JPEG				XN_CODEC_ID('J','P','E','G')
 #define XN_CODEC_16Z				XN_CODEC_ID('1','6','z','P')
 #define XN_CODEC_16Z_EMB_TABLES		XN_CODEC_ID('1','6','z','T')
+#define XN_CODEC_16Z_ANS			XN_CODEC_ID('1','6','z','A')
 #define XN_CODEC_8Z					XN_CODEC_ID('I','m','8','z')
+#define XN_CODEC_IMAGE_LOSSLESS		XN_CODEC_ID('I','m','L','L')
+#define XN_CODEC_AUDIO_LOSSLESS		XN_CODEC_ID('A','u','L','L')
 
 #endif // __NICODECIDS_H__
@@ -331,6 +331,37 @@ XN_C_API XnStatus XN_C_DECL xnCreateMockNodeBasedOn(
 	XnNodeHandle* phMockNode
 	);
 
+/**
+ * @brief Creates a filter node. A filter is a depth or image generator which, on each update, transforms the 
+ * current frame of another generator of the same type (its input) by running a chain of built-in stages. 
+ * The filter is updated after its input, and other nodes (including recorders) can use it as any other 
+ * generator of its type.
+ *
+ * Stages are separated by ';', and parameters by ','. Stages are applied in order:
+ * - <tt>crop:x,y,width,height</tt> - keeps a rectangle of the map.
+ * - <tt>downscale:factor</tt> - keeps every factor-th pixel in each direction (factor up to 16).
+ * - <tt>mirror</tt> - flips the map horizontally.
+ * - <tt>threshold:min,max</tt> - zeroes depth values outside [min, max]. Depth only.
+ * - <tt>median[:frames]</tt> - per-pixel median of the last frames (up to 9, default 3). Depth only.
+ * - <tt>holefill</tt> - replaces zero depth values with the last valid value of that pixel. Depth only.
+ *
+ * For example, <tt>"crop:0,0,320,240;threshold:500,3000;median:5"</tt>. The stages can be changed later by 
+ * setting the @ref XN_PROP_FILTER_STAGES string property of the filter.
+ *
+ * @param	pContext		[in]		OpenNI context.
+ * @param	hInput			[in]		The depth or image generator to filter.
+ * @param	strStages		[in]		Optional. The stages to run. NULL or an empty string passes the input through.
+ * @param	strName			[in]		Optional. The name of the node. If set to NULL, a name will be generated based on the name of hInput.
+ * @param	phFilter		[out]		A handle to the newly created filter.
+ */
+XN_C_API XnStatus XN_C_DECL xnCreateFilter(
+	XnContext* pContext,
+	XnNodeHandle hInput,
+	const XnChar* strStages,
+	const XnChar* strName,
+	XnNodeHandle* phFilter
+	);
+
 /**
  * @brief References a production node, increasing its reference count by 1.
  *
@@ -455,6 +486,11 @@ XN_C_API XnStatus XN_C_DECL xnWaitAnyUpdateAll(XnContext* pContext);
  * @brief Updates all generator nodes in the context, without any waiting. If a node has new data,
  * it will be updated.
  *
+ * When the context plays several recordings at once, the next frames (in timestamp order) are played 
+ * by the calling thread, and only if every player already read its next frame. Otherwise nothing is 
+ * played, and the call should be repeated. Frames are still held back on the calling thread to keep
+ * the playback speed.
+ *
  * @param	pContext		[in]	OpenNI context.
  */
 XN_C_API XnStatus XN_C_DECL xnWaitNoneUpdateAll(XnContext* pContext);
@@ -561,6 +597,58 @@ XN_C_API XnStatus XN_C_DECL xnRegisterToNodeDestruction
 XN_C_API void XN_C_DECL xnUnregisterFromNodeDestruction
 	(XnContext* pContext, XnCallbackHandle hCallback);
 
+/**
+ * @brief Takes a snapshot of the counters OpenNI keeps for the context and for each of its nodes. The
+ * counters are always kept (they do not depend on logging), and updating them takes no lock.
+ *
+ * @param	pContext	[in]		OpenNI context.
+ * @param	pMetrics	[out]		Context-wide counters.
+ * @param	aNodes		[out]		Optional. An array to be filled with the counters of each node.
+ * @param	pnNodes		[in/out]	Optional. In: the size of @a aNodes. Out: the number of nodes written.
+ *
+ * @returns XN_STATUS_OUTPUT_BUFFER_OVERFLOW if @a aNodes is too small for all nodes. In that case, the array
+ * is filled, and @a pMetrics holds the actual number of nodes.
+ */
+XN_C_API XnStatus XN_C_DECL xnGetContextMetrics(XnContext* pContext, XnContextMetrics* pMetrics, XnNodeMetrics* aNodes, XnUInt32* pnNodes);
+
+/**
+ * @brief Takes a snapshot of the counters OpenNI keeps for a single node.
+ *
+ * @param	hNode		[in]	A handle to the node.
+ * @param	pMetrics	[out]	The node's counters.
+ */
+XN_C_API XnStatus XN_C_DECL xnGetNodeMetrics(XnNodeHandle hNode, XnNodeMetrics* pMetrics);
+
+/**
+ * @brief Writes the context's counters in the Prometheus text exposition format.
+ *
+ * @param	pContext	[in]	OpenNI context.
+ * @param	csBuffer	[in]	A buffer to be filled.
+ * @param	nBufferSize	[in]	The size of the buffer.
+ * @param	pnWritten	[out]	The number of characters written, not including the terminating null.
+ *
+ * @returns XN_STATUS_OUTPUT_BUFFER_OVERFLOW if the buffer is too small.
+ */
+XN_C_API XnStatus XN_C_DECL xnFormatContextMetrics(XnContext* pContext, XnChar* csBuffer, XnUInt32 nBufferSize, XnUInt32* pnWritten);
+
+/**
+ * @brief Starts serving the context's counters on a local (Unix domain) socket, so that monitoring agents
+ * can scrape them. Each connection gets a single HTTP response holding the output of 
+ * @ref xnFormatContextMetrics(), and is then closed. Serving is done by a separate thread. 
+ *
+ * @param	pContext		[in]	OpenNI context.
+ * @param	strSocketPath	[in]	File name of the socket. An existing socket with that name is replaced.
+ */
+XN_C_API XnStatus XN_C_DECL xnStartMetricsExporter(XnContext* pContext, const XnChar* strSocketPath);
+
+/**
+ * @brief Stops serving the context's counters, and removes the socket. Done automatically when the context 
+ * is destroyed.
+ *
+ * @param	pContext		[in]	OpenNI context.
+ */
+XN_C_API XnStatus XN_C_DECL xnStopMetricsExporter(XnContext* pContext);
+
 /// @}
 
 /** @} */
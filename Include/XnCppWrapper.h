@@ -3285,6 +3285,58 @@ namespace xn
 		}
 	};
 
+	/**
+	 * @ingroup cppref_prd_func
+	 * <b>Purpose:</b> The FrameLeaseCapability lets the application keep frames of a generator
+	 * node after the node is updated, without copying them. See @ref framelease.
+	 *
+	 * <b>Usage:</b> Do not instantiate directly. Instead, use @ref Generator::GetFrameLeaseCap()
+	 * to obtain an instance. Most applications should hold frames with a @ref FrameRef, which
+	 * releases the lease when it goes out of scope.
+	 */
+	class FrameLeaseCapability : public Capability
+	{
+	public:
+		inline FrameLeaseCapability(XnNodeHandle hNode) : Capability(hNode) {}
+		FrameLeaseCapability(const NodeWrapper& node) : Capability(node) {}
+
+		/**
+		 * @copybrief xnAcquireFrame
+		 * For full details and usage, see @ref xnAcquireFrame
+		 */
+		inline XnStatus AcquireFrame(XnFrameLease& lease)
+		{
+			return xnAcquireFrame(GetHandle(), &lease);
+		}
+
+		/**
+		 * @copybrief xnReleaseFrame
+		 * For full details and usage, see @ref xnReleaseFrame
+		 */
+		inline XnStatus ReleaseFrame(const XnFrameLease& lease)
+		{
+			return xnReleaseFrame(GetHandle(), &lease);
+		}
+
+		/**
+		 * @copybrief xnSetFramePoolPolicy
+		 * For full details and usage, see @ref xnSetFramePoolPolicy
+		 */
+		inline XnStatus SetFramePoolPolicy(const XnFramePoolPolicy& policy)
+		{
+			return xnSetFramePoolPolicy(GetHandle(), &policy);
+		}
+
+		/**
+		 * @copybrief xnGetFramePoolPolicy
+		 * For full details and usage, see @ref xnGetFramePoolPolicy
+		 */
+		inline XnStatus GetFramePoolPolicy(XnFramePoolPolicy& policy) const
+		{
+			return xnGetFramePoolPolicy(GetHandle(), &policy);
+		}
+	};
+
 	/**
 	 * @ingroup cppref_prd_func
 	 * <b>Purpose:</b> A generator node produces some type of data. This is in addition
@@ -3656,6 +3708,118 @@ namespace xn
 		{
 			return FrameSyncCapability(GetHandle());
 		}
+
+		/**
+		 * Gets an @ref FrameLeaseCapability object for accessing Frame Lease functionality.
+		 *
+		 * <b>Remarks:</b>
+		 *
+		 * It is the application's responsibility to check first if
+		 * @ref XN_CAPABILITY_FRAME_LEASE is supported
+		 * by calling @ref xn::Generator::IsCapabilitySupported().
+		 */
+		inline const FrameLeaseCapability GetFrameLeaseCap() const
+		{
+			return FrameLeaseCapability(GetHandle());
+		}
+
+		/**
+		 * Gets an @ref FrameLeaseCapability object for accessing Frame Lease functionality.
+		 *
+		 * <b>Remarks:</b>
+		 *
+		 * It is the application's responsibility to check first if
+		 * @ref XN_CAPABILITY_FRAME_LEASE is supported
+		 * by calling @ref xn::Generator::IsCapabilitySupported().
+		 */
+		inline FrameLeaseCapability GetFrameLeaseCap()
+		{
+			return FrameLeaseCapability(GetHandle());
+		}
+	};
+
+	/**
+	 * @ingroup cppref_prd_func
+	 * <b>Purpose:</b> Holds a frame leased from a generator (see @ref framelease). The frame
+	 * stays valid while the FrameRef holds it, regardless of updates to the generator, and is
+	 * released when the FrameRef is destroyed or reused.
+	 *
+	 * <b>Usage:</b> Call @ref Acquire() after the generator was updated, then pass the FrameRef
+	 * (or its data) to whoever processes the frame. A FrameRef also keeps a reference to the
+	 * generator node, so the node outlives its leased frames.
+	 *
+	 * <b>Remarks:</b> A FrameRef is not copyable. Each one holds its own lease.
+	 */
+	class FrameRef
+	{
+	public:
+		inline FrameRef() : m_bLeased(FALSE)
+		{
+			xnOSMemSet(&m_lease, 0, sizeof(m_lease));
+		}
+
+		inline ~FrameRef()
+		{
+			Release();
+		}
+
+		/**
+		 * @brief Leases the current frame of a generator, releasing the frame held so far (if any).
+		 *
+		 * @param [in]	generator	The generator to lease the frame from.
+		 */
+		inline XnStatus Acquire(Generator& generator)
+		{
+			Release();
+
+			XnStatus nRetVal = xnAcquireFrame(generator.GetHandle(), &m_lease);
+			XN_IS_STATUS_OK(nRetVal);
+
+			m_generator = generator;
+			m_bLeased = TRUE;
+
+			return (XN_STATUS_OK);
+		}
+
+		/**
+		 * @brief Releases the held frame. Does nothing if no frame is held.
+		 */
+		inline void Release()
+		{
+			if (m_bLeased)
+			{
+				xnReleaseFrame(m_generator.GetHandle(), &m_lease);
+				m_generator.Release();
+				xnOSMemSet(&m_lease, 0, sizeof(m_lease));
+				m_bLeased = FALSE;
+			}
+		}
+
+		/** Returns TRUE if a frame is held. */
+		inline XnBool IsValid() const { return m_bLeased; }
+
+		/** Gets the frame data. */
+		inline const void* GetData() const { return m_lease.pData; }
+
+		/** Gets the size of the frame data, in bytes. */
+		inline XnUInt32 GetDataSize() const { return m_lease.nDataSize; }
+
+		/** Gets the frame timestamp. */
+		inline XnUInt64 GetTimestamp() const { return m_lease.nTimestamp; }
+
+		/** Gets the frame ID. */
+		inline XnUInt32 GetFrameID() const { return m_lease.nFrameID; }
+
+		/** Gets the generator the frame was leased from. */
+		inline const Generator& GetGenerator() const { return m_generator; }
+
+	private:
+		FrameRef(const FrameRef&);
+		FrameRef& operator=(const FrameRef&);
+
+		Generator m_generator;
+		XnFrameLease m_lease;
+		XnBool m_bLeased;
 	};
 
 	/**
@@ -3725,16 +3889,27 @@ namespace xn
 		/**
 		 * @brief Specifies to where the recorder must send its recording. Typically this is a disk file of a particular file type.
 		 *
-		 * @param [in]	destType 	The type of medium to record to. Currently only XN_RECORD_MEDIUM_FILE
-		 * 							is supported.
+		 * @param [in]	destType 	The type of medium to record to.
 		 * @param [in]	strDest 	Recording destination. If destType is XN_RECORD_MEDIUM_FILE,
-		 * 							this specifies a file name.
+		 * 							this specifies a file name. If destType is XN_RECORD_MEDIUM_NETWORK,
+		 * 							this specifies the "host:port" of a listening player.
 		 */
 		inline XnStatus SetDestination(XnRecordMedium destType, const XnChar* strDest)
 		{
 			return xnSetRecorderDestination(GetHandle(), destType, strDest);
 		}
 
+		/**
+		 * @brief Sets how the recorder writes files (segmenting, buffering and direct I/O). Must be called
+		 * before @ref SetDestination().
+		 *
+		 * @param [in]	options 	The options to use. See @ref XnRecorderFileOptions.
+		 */
+		inline XnStatus SetFileOptions(const XnRecorderFileOptions& options)
+		{
+			return xnSetRecorderFileOptions(GetHandle(), &options);
+		}
+
 		/**
 		 * @brief Gets the destination medium for the Recorder node to record to.
 		 *
@@ -3869,6 +4044,24 @@ namespace xn
 			return xnSetPlayerSource(GetHandle(), sourceType, strSource);
 		}
 
+		/**
+		 * @copybrief xnSetPlayerNetworkOptions
+		 * For full details and usage, see @ref xnSetPlayerNetworkOptions
+		 */
+		inline XnStatus SetNetworkOptions(const XnPlayerNetworkOptions& options)
+		{
+			return xnSetPlayerNetworkOptions(GetHandle(), &options);
+		}
+
+		/**
+		 * @copybrief xnAbortPlayerSource
+		 * For full details and usage, see @ref xnAbortPlayerSource
+		 */
+		inline XnStatus AbortSource()
+		{
+			return xnAbortPlayerSource(GetHandle());
+		}
+
 		/**
 		 * @brief Gets the player's source, that is, the type and name of the medium
 		 * that the recording is played back from.
@@ -4082,6 +4275,26 @@ namespace xn
 		{
 			return xnGetPlaybackSpeed(GetHandle());
 		}
+
+		/**
+		 * @brief Turns real-time playback (dropping frames that are already late) on or off.
+		 *
+		 * For full details and usage, see @ref xnSetPlayerRealTime.
+		 */
+		inline XnStatus SetRealTime(XnBool bRealTime)
+		{
+			return xnSetPlayerRealTime(GetHandle(), bRealTime);
+		}
+
+		/**
+		 * @brief Checks if the player is in real-time mode.
+		 *
+		 * For full details and usage, see @ref xnIsPlayerRealTime.
+		 */
+		inline XnBool IsRealTime() const
+		{
+			return xnIsPlayerRealTime(GetHandle());
+		}
 	};
 
 	/**
@@ -4737,6 +4950,18 @@ namespace xn
 		 */
 		inline XnStatus Create(Context& context, Query* pQuery = NULL, EnumerationErrors* pErrors = NULL);
 
+		/**
+		 * @brief Creates a filter node that transforms the output of this node. The filter is itself a
+		 * DepthGenerator, which can be used (and recorded) like any other.
+		 *
+		 * For full details and usage, see @ref xnCreateFilter
+		 *
+		 * @param [in]	strStages	The stages to run. See @ref xnCreateFilter for the syntax.
+		 * @param [out]	filter		The created filter node.
+		 * @param [in]	strName		Optional. The name of the new node.
+		 */
+		inline XnStatus CreateFilter(const XnChar* strStages, DepthGenerator& filter, const XnChar* strName = NULL);
+
 		/**
 		 * @brief Gets the depth generator node's latest @ref glos_frame_object "frame object", saving
 		 * it in the @ref xn::DepthMetaData object. This @ref glos_frame_object "frame object" is a
@@ -4980,6 +5205,18 @@ namespace xn
 		 */
 		inline XnStatus Create(Context& context, Query* pQuery = NULL, EnumerationErrors* pErrors = NULL);
 
+		/**
+		 * @brief Creates a filter node that transforms the output of this node. The filter is itself a
+		 * ImageGenerator, which can be used (and recorded) like any other.
+		 *
+		 * For full details and usage, see @ref xnCreateFilter
+		 *
+		 * @param [in]	strStages	The stages to run. See @ref xnCreateFilter for the syntax.
+		 * @param [out]	filter		The created filter node.
+		 * @param [in]	strName		Optional. The name of the new node.
+		 */
+		inline XnStatus CreateFilter(const XnChar* strStages, ImageGenerator& filter, const XnChar* strName = NULL);
+
 		/**
 		 * @brief Gets the image generator node's latest @ref glos_frame_object "frame object", saving
 		 * it in the @ref xn::ImageMetaData object. This @ref glos_frame_object "frame object" is a
@@ -9464,6 +9701,10 @@ private:
 		 * A node that does not have new data available does not update its application
 		 * buffer.
 		 *
+		 * When the context plays several recordings at once, the merged playback runs on the
+		 * calling thread, and a call only plays frames that all players already read. A call
+		 * made while one of them is still reading plays nothing (see @ref xnWaitNoneUpdateAll()).
+		 *
 		 * See @ref conc_updating_data__summary_of_wait_fns for an overview to the @ref
 		 * conc_updating_data "'WaitXUpdateAll'" methods and how to read the data from the
 		 * nodes.
@@ -9473,6 +9714,33 @@ private:
 			return xnWaitNoneUpdateAll(m_pContext);
 		}
 
+		/**
+		 * @copybrief xnGetContextMetrics
+		 * For full details and usage, see @ref xnGetContextMetrics
+		 */
+		inline XnStatus GetMetrics(XnContextMetrics& metrics, XnNodeMetrics* aNodes = NULL, XnUInt32* pnNodes = NULL) const
+		{
+			return xnGetContextMetrics(m_pContext, &metrics, aNodes, pnNodes);
+		}
+
+		/**
+		 * @copybrief xnStartMetricsExporter
+		 * For full details and usage, see @ref xnStartMetricsExporter
+		 */
+		inline XnStatus StartMetricsExporter(const XnChar* strSocketPath)
+		{
+			return xnStartMetricsExporter(m_pContext, strSocketPath);
+		}
+
+		/**
+		 * @copybrief xnStopMetricsExporter
+		 * For full details and usage, see @ref xnStopMetricsExporter
+		 */
+		inline XnStatus StopMetricsExporter()
+		{
+			return xnStopMetricsExporter(m_pContext);
+		}
+
 		/**
 		 * @copybrief xnAutoEnumerateOverSingleInput
 		 * For full details and usage, see @ref xnAutoEnumerateOverSingleInput
@@ -9833,6 +10101,17 @@ private:
 		return (XN_STATUS_OK);
 	}
 
+	inline XnStatus DepthGenerator::CreateFilter(const XnChar* strStages, DepthGenerator& filter, const XnChar* strName /* = NULL */)
+	{
+		Context context;
+		GetContext(context);
+		XnNodeHandle hNode;
+		XnStatus nRetVal = xnCreateFilter(context.GetUnderlyingObject(), GetHandle(), strStages, strName, &hNode);
+		XN_IS_STATUS_OK(nRetVal);
+		filter.TakeOwnership(hNode);
+		return (XN_STATUS_OK);
+	}
+
 	inline XnStatus MockDepthGenerator::Create(Context& context, const XnChar* strName /* = NULL */)
 	{
 		XnNodeHandle hNode;
@@ -9862,6 +10141,17 @@ private:
 		return (XN_STATUS_OK);
 	}
 
+	inline XnStatus ImageGenerator::CreateFilter(const XnChar* strStages, ImageGenerator& filter, const XnChar* strName /* = NULL */)
+	{
+		Context context;
+		GetContext(context);
+		XnNodeHandle hNode;
+		XnStatus nRetVal = xnCreateFilter(context.GetUnderlyingObject(), GetHandle(), strStages, strName, &hNode);
+		XN_IS_STATUS_OK(nRetVal);
+		filter.TakeOwnership(hNode);
+		return (XN_STATUS_OK);
+	}
+
 	inline XnStatus MockImageGenerator::Create(Context& context, const XnChar* strName /* = NULL */)
 	{
 		XnNodeHandle hNode;
@@ -0,0 +1,96 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_DEPTH_REGISTRATION_H_
+#define _XN_DEPTH_REGISTRATION_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include <XnTypes.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_DEPTH_REGISTRATION "DepthRegistration"
+
+/** Maximum number of threads a registration engine may use, including the calling one. */
+#define XN_DEPTH_REGISTRATION_MAX_THREADS 8
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+struct XnDepthRegistration; // forward declaration
+typedef struct XnDepthRegistration XnDepthRegistration;
+
+//---------------------------------------------------------------------------
+// Exported Function Declaration
+//---------------------------------------------------------------------------
+
+/**
+* Creates a depth registration engine, which warps depth maps into the view point of an image sensor.
+* The ray of every depth pixel is transformed into the image sensor's coordinates once, here, so that
+* registering a frame only costs a few vector operations per pixel, plus a z-buffered store (when
+* several depth pixels fall on the same output pixel, the closest one wins).
+*
+* @param	pCalibration	[in]	Intrinsics of both sensors, and the transformation between them.
+* @param	nDepthXRes		[in]	Number of columns in the depth maps to register.
+* @param	nDepthYRes		[in]	Number of rows in the depth maps to register.
+* @param	nOutputXRes		[in]	Number of columns in registered maps. The image intrinsics are scaled to it.
+* @param	nOutputYRes		[in]	Number of rows in registered maps.
+* @param	bMirror			[in]	TRUE if both the depth maps and the images are mirrored.
+* @param	nThreads		[in]	Number of threads to register with, including the calling one. 0 uses one
+*									per CPU, up to @ref XN_DEPTH_REGISTRATION_MAX_THREADS.
+* @param	ppRegistration	[out]	Upon successful return, holds a handle to the created engine.
+*/
+XN_C_API XnStatus XN_C_DECL xnDepthRegistrationCreate(const XnRegistrationCalibration* pCalibration, XnUInt32 nDepthXRes, XnUInt32 nDepthYRes, XnUInt32 nOutputXRes, XnUInt32 nOutputYRes, XnBool bMirror, XnUInt32 nThreads, XnDepthRegistration** ppRegistration);
+
+/**
+* Destroys a depth registration engine, and stops its threads.
+*
+* @param	ppRegistration	[in/out]	A pointer to the engine to be destroyed.
+*/
+XN_C_API XnStatus XN_C_DECL xnDepthRegistrationDestroy(XnDepthRegistration** ppRegistration);
+
+/**
+* Registers a depth map into the image sensor's view point. Depth values are kept as measured. Output
+* pixels no depth pixel falls on are set to 0.
+*
+* @param	pRegistration	[in]	The engine.
+* @param	pDepth			[in]	Depth map, in the resolution the engine was created for.
+* @param	pRegistered		[out]	Registered depth map, in the output resolution. May be the same buffer
+*									as @a pDepth if both resolutions are the same.
+*/
+XN_C_API XnStatus XN_C_DECL xnDepthRegistrationRegister(XnDepthRegistration* pRegistration, const XnDepthPixel* pDepth, XnDepthPixel* pRegistered);
+
+/**
+* Maps depth pixels to image pixel coordinates, without rounding them. Points that have no depth, or
+* that are behind the image sensor, get a Z of 0. Other points keep their depth, and may fall outside
+* the image.
+*
+* @param	pRegistration	[in]	The engine.
+* @param	nCount			[in]	Number of points to map.
+* @param	aDepthPoints	[in]	Points in depth map projective coordinates (X and Y in pixels, Z in millimeters).
+* @param	aImagePoints	[out]	Mapped points, in output resolution pixels. May be the same array as @a aDepthPoints.
+*/
+XN_C_API XnStatus XN_C_DECL xnDepthRegistrationMapPoints(XnDepthRegistration* pRegistration, XnUInt32 nCount, const XnPoint3D* aDepthPoints, XnPoint3D* aImagePoints);
+
+#endif //_XN_DEPTH_REGISTRATION_H_
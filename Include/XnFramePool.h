@@ -0,0 +1,286 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_FRAME_POOL_H_
+#define _XN_FRAME_POOL_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnOS.h"
+#include "XnTypes.h"
+#include "XnArray.h"
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+
+/**
+* A pool of frame buffers, for generators that implement the frame lease interface.
+*
+* One buffer holds the current frame, and another receives the next one. Advance() makes the next frame
+* the current one, and picks a buffer that is neither leased nor current to receive the one after it
+* (with no leases, this just exchanges the two). Leased buffers stay out of the way until released, and
+* the pool grows or drops frames according to its policy when all of them are leased.
+*
+* The pool does not lock. Leases may be released from any thread, so its owner should protect it.
+*/
+class XnFramePool
+{
+public:
+	struct Frame
+	{
+		void* pData;
+		XnUInt32 nAllocatedSize;
+		XnUInt32 nDataSize;
+		XnUInt64 nTimestamp;
+		XnUInt32 nFrameID;
+		XnUInt32 nLeaseCount;
+	};
+
+	XnFramePool(XnUInt32 nFrames, XnUInt32 nMaxFrames) : m_nCurrentIdx(0), m_nNextIdx(1)
+	{
+		m_policy.nFrames = nFrames;
+		m_policy.nMaxFrames = nMaxFrames;
+		m_policy.overflow = XN_FRAME_POOL_GROW;
+
+		m_frames.SetSize(m_policy.nFrames, EmptyFrame());
+	}
+
+	~XnFramePool()
+	{
+		for (XnUInt32 i = 0; i < m_frames.GetSize(); ++i)
+		{
+			xnOSFreeAligned(m_frames[i].pData);
+		}
+	}
+
+	XnUInt32 GetSize() const { return m_frames.GetSize(); }
+	Frame& Current() { return m_frames[m_nCurrentIdx]; }
+	Frame& Next() { return m_frames[m_nNextIdx]; }
+
+	/**
+	* Makes sure a frame's buffer can hold nSize bytes. Its contents are lost if it has to be reallocated.
+	*/
+	static XnStatus Allocate(Frame& frame, XnUInt32 nSize)
+	{
+		if (nSize > frame.nAllocatedSize)
+		{
+			xnOSFreeAligned(frame.pData);
+			frame.nAllocatedSize = 0;
+			frame.pData = xnOSMallocAligned(nSize, XN_DEFAULT_MEM_ALIGN);
+			XN_VALIDATE_ALLOC_PTR(frame.pData);
+			frame.nAllocatedSize = nSize;
+		}
+
+		return (XN_STATUS_OK);
+	}
+
+	/**
+	* Makes the next frame current.
+	*
+	* @returns FALSE if there is no free buffer to receive the frame after it. Nothing changes in that case,
+	*          so the caller should drop the next frame (it will be overwritten).
+	*/
+	XnBool Advance()
+	{
+		XnUInt32 nFreeIdx = 0;
+		if (!FindFree(nFreeIdx))
+		{
+			return FALSE;
+		}
+
+		m_nCurrentIdx = m_nNextIdx;
+		m_nNextIdx = nFreeIdx;
+
+		return TRUE;
+	}
+
+	/**
+	* Leases the current frame.
+	*
+	* @returns XN_STATUS_INVALID_OPERATION if there is no current frame yet.
+	*/
+	XnStatus Lease(XnFrameLease& lease)
+	{
+		Frame& current = Current();
+		if (current.pData == NULL)
+		{
+			return (XN_STATUS_INVALID_OPERATION);
+		}
+
+		++current.nLeaseCount;
+
+		lease.pData = current.pData;
+		lease.nDataSize = current.nDataSize;
+		lease.nTimestamp = current.nTimestamp;
+		lease.nFrameID = current.nFrameID;
+
+		return (XN_STATUS_OK);
+	}
+
+	/**
+	* Releases a lease taken with Lease(). Leases are matched by data pointer, as buffers may move.
+	*
+	* @returns XN_STATUS_NO_MATCH if the frame was not leased from this pool.
+	*/
+	XnStatus Release(const XnFrameLease& lease)
+	{
+		for (XnUInt32 i = 0; i < m_frames.GetSize(); ++i)
+		{
+			if (m_frames[i].pData == lease.pData && m_frames[i].nLeaseCount != 0)
+			{
+				--m_frames[i].nLeaseCount;
+				return (XN_STATUS_OK);
+			}
+		}
+
+		return (XN_STATUS_NO_MATCH);
+	}
+
+	/**
+	* Sets the pool policy. The pool grows to the new size at once, and frees the free buffers beyond it
+	* (leased ones are kept until released, and freed by later calls).
+	*/
+	XnStatus SetPolicy(const XnFramePoolPolicy& policy)
+	{
+		XnStatus nRetVal = XN_STATUS_OK;
+
+		m_policy = policy;
+
+		if (m_frames.GetSize() < m_policy.nFrames)
+		{
+			nRetVal = m_frames.SetSize(m_policy.nFrames, EmptyFrame());
+			XN_IS_STATUS_OK(nRetVal);
+		}
+		else
+		{
+			Shrink();
+		}
+
+		return (XN_STATUS_OK);
+	}
+
+	const XnFramePoolPolicy& GetPolicy() const { return m_policy; }
+
+private:
+	static Frame EmptyFrame()
+	{
+		Frame frame;
+		xnOSMemSet(&frame, 0, sizeof(frame));
+		return frame;
+	}
+
+	XnBool IsInUse(XnUInt32 nIndex)
+	{
+		return (nIndex == m_nCurrentIdx || nIndex == m_nNextIdx || m_frames[nIndex].nLeaseCount != 0);
+	}
+
+	// finds a buffer to receive the frame after the next one, once the current one is replaced
+	XnBool FindFree(XnUInt32& nIndex)
+	{
+		// prefer the current buffer (which is what happens when nothing is leased)
+		if (m_frames[m_nCurrentIdx].nLeaseCount == 0)
+		{
+			nIndex = m_nCurrentIdx;
+			return TRUE;
+		}
+
+		for (XnUInt32 i = 0; i < m_frames.GetSize(); ++i)
+		{
+			if (!IsInUse(i))
+			{
+				nIndex = i;
+				return TRUE;
+			}
+		}
+
+		// no free buffer. See if we may add one.
+		XnUInt32 nLimit = m_policy.nFrames;
+		if (m_policy.overflow == XN_FRAME_POOL_GROW)
+		{
+			nLimit = (m_policy.nMaxFrames == 0) ? XN_MAX_UINT32 : m_policy.nMaxFrames;
+		}
+
+		if (m_frames.GetSize() >= nLimit || m_frames.AddLast(EmptyFrame()) != XN_STATUS_OK)
+		{
+			return FALSE;
+		}
+
+		nIndex = m_frames.GetSize() - 1;
+		return TRUE;
+	}
+
+	void Shrink()
+	{
+		// move the buffers in use to the front
+		XnUInt32 nInUse = 0;
+		for (XnUInt32 i = 0; i < m_frames.GetSize(); ++i)
+		{
+			if (!IsInUse(i))
+			{
+				continue;
+			}
+
+			if (i != nInUse)
+			{
+				Frame temp = m_frames[nInUse];
+				m_frames[nInUse] = m_frames[i];
+				m_frames[i] = temp;
+
+				MoveIndex(m_nCurrentIdx, i, nInUse);
+				MoveIndex(m_nNextIdx, i, nInUse);
+			}
+
+			++nInUse;
+		}
+
+		// and free the free ones beyond the pool size
+		XnUInt32 nNewSize = XN_MAX(nInUse, m_policy.nFrames);
+		for (XnUInt32 i = nNewSize; i < m_frames.GetSize(); ++i)
+		{
+			xnOSFreeAligned(m_frames[i].pData);
+		}
+		if (nNewSize < m_frames.GetSize())
+		{
+			m_frames.SetSize(nNewSize, EmptyFrame());
+		}
+	}
+
+	// keeps an index pointing at its buffer, when the buffers at nFrom and nTo are exchanged
+	static void MoveIndex(XnUInt32& nIndex, XnUInt32 nFrom, XnUInt32 nTo)
+	{
+		if (nIndex == nFrom)
+		{
+			nIndex = nTo;
+		}
+		else if (nIndex == nTo)
+		{
+			nIndex = nFrom;
+		}
+	}
+
+	XnArray<Frame> m_frames;
+	XnUInt32 m_nCurrentIdx;
+	XnUInt32 m_nNextIdx;
+	XnFramePoolPolicy m_policy;
+};
+
+#endif // _XN_FRAME_POOL_H_
@@ -22,5 +22,6 @@
 #define __NIINTERNALDEFS_H__
 
 #define XN_MOCK_NODE_NAME "Mock"
+#define XN_FILTER_NODE_NAME "Filter"
 
 #endif // __NIINTERNALDEFS_H__
\ No newline at end of file
@@ -546,6 +546,42 @@ void XN_CALLBACK_TYPE __ModuleUnregisterFromFrameSyncChange(XnModuleNodeHandle h
 	pInterface->UnregisterFromFrameSyncChange(hCallback);
 }
 
+XnStatus XN_CALLBACK_TYPE __ModuleAcquireFrame(XnModuleNodeHandle hGenerator, XnFrameLease* pLease)
+{
+	ModuleProductionNode* pProdNode = (ModuleProductionNode*)hGenerator;
+	ModuleGenerator* pNode = dynamic_cast<ModuleGenerator*>(pProdNode);
+	ModuleFrameLeaseInterface* pInterface = pNode->GetFrameLeaseInterface();
+	_XN_VALIDATE_CAPABILITY_INTERFACE(pInterface);
+	return pInterface->AcquireFrame(*pLease);
+}
+
+XnStatus XN_CALLBACK_TYPE __ModuleReleaseFrame(XnModuleNodeHandle hGenerator, const XnFrameLease* pLease)
+{
+	ModuleProductionNode* pProdNode = (ModuleProductionNode*)hGenerator;
+	ModuleGenerator* pNode = dynamic_cast<ModuleGenerator*>(pProdNode);
+	ModuleFrameLeaseInterface* pInterface = pNode->GetFrameLeaseInterface();
+	_XN_VALIDATE_CAPABILITY_INTERFACE(pInterface);
+	return pInterface->ReleaseFrame(*pLease);
+}
+
+XnStatus XN_CALLBACK_TYPE __ModuleSetFramePoolPolicy(XnModuleNodeHandle hGenerator, const XnFramePoolPolicy* pPolicy)
+{
+	ModuleProductionNode* pProdNode = (ModuleProductionNode*)hGenerator;
+	ModuleGenerator* pNode = dynamic_cast<ModuleGenerator*>(pProdNode);
+	ModuleFrameLeaseInterface* pInterface = pNode->GetFrameLeaseInterface();
+	_XN_VALIDATE_CAPABILITY_INTERFACE(pInterface);
+	return pInterface->SetFramePoolPolicy(*pPolicy);
+}
+
+XnStatus XN_CALLBACK_TYPE __ModuleGetFramePoolPolicy(XnModuleNodeHandle hGenerator, XnFramePoolPolicy* pPolicy)
+{
+	ModuleProductionNode* pProdNode = (ModuleProductionNode*)hGenerator;
+	ModuleGenerator* pNode = dynamic_cast<ModuleGenerator*>(pProdNode);
+	ModuleFrameLeaseInterface* pInterface = pNode->GetFrameLeaseInterface();
+	_XN_VALIDATE_CAPABILITY_INTERFACE(pInterface);
+	return pInterface->GetFramePoolPolicy(*pPolicy);
+}
+
 XnStatus XN_CALLBACK_TYPE __ModuleStartGenerating(XnModuleNodeHandle hGenerator)
 {
 	ModuleProductionNode* pProdNode = (ModuleProductionNode*)hGenerator;
@@ -1714,6 +1750,14 @@ void XN_CALLBACK_TYPE __ModuleGetFrameSyncInterface(XnModuleFrameSyncInterface*
 	pInterface->UnregisterFromFrameSyncChange = __ModuleUnregisterFromFrameSyncChange;
 }
 
+void XN_CALLBACK_TYPE __ModuleGetFrameLeaseInterface(XnModuleFrameLeaseInterface* pInterface)
+{
+	pInterface->AcquireFrame = __ModuleAcquireFrame;
+	pInterface->ReleaseFrame = __ModuleReleaseFrame;
+	pInterface->SetFramePoolPolicy = __ModuleSetFramePoolPolicy;
+	pInterface->GetFramePoolPolicy = __ModuleGetFramePoolPolicy;
+}
+
 void XN_CALLBACK_TYPE __ModuleGetGeneratorInterface(XnModuleGeneratorInterface* pInterface)
 {
 	__ModuleGetProductionNodeInterface(pInterface->pProductionNodeInterface);
@@ -1733,6 +1777,7 @@ void XN_CALLBACK_TYPE __ModuleGetGeneratorInterface(XnModuleGeneratorInterface*
 	__ModuleGetMirrorInterface(pInterface->pMirrorInterface);
 	__ModuleGetAlternativeViewPointInterface(pInterface->pAlternativeViewPointInterface);
 	__ModuleGetFrameSyncInterface(pInterface->pFrameSyncInterface);
+	__ModuleGetFrameLeaseInterface(pInterface->pFrameLeaseInterface);
 }
 
 void XN_CALLBACK_TYPE __ModuleGetNodeNotificationsInterface(XnNodeNotifications *pInterface)
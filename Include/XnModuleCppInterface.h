@@ -231,6 +231,15 @@ namespace xn
 		virtual void UnregisterFromFrameSyncChange(XnCallbackHandle hCallback) = 0;
 	};
 
+	class ModuleFrameLeaseInterface
+	{
+	public:
+		virtual XnStatus AcquireFrame(XnFrameLease& lease) = 0;
+		virtual XnStatus ReleaseFrame(const XnFrameLease& lease) = 0;
+		virtual XnStatus SetFramePoolPolicy(const XnFramePoolPolicy& policy) = 0;
+		virtual XnStatus GetFramePoolPolicy(XnFramePoolPolicy& policy) = 0;
+	};
+
 	class ModuleGenerator : virtual public ModuleProductionNode
 	{
 	public:
@@ -254,6 +263,7 @@ namespace xn
 		virtual ModuleMirrorInterface* GetMirrorInterface() { return NULL; }
 		virtual ModuleAlternativeViewPointInterface* GetAlternativeViewPointInterface() { return NULL; }
 		virtual ModuleFrameSyncInterface* GetFrameSyncInterface() { return NULL; }
+		virtual ModuleFrameLeaseInterface* GetFrameLeaseInterface() { return NULL; }
 	};
 
 	class ModuleNodeNotifications
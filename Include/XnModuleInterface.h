@@ -580,6 +580,42 @@ typedef struct XnModuleFrameSyncInterface
 
 } XnModuleFrameSyncInterface;
 
+typedef struct XnModuleFrameLeaseInterface
+{
+	/**
+	 * Leases the current frame. The frame buffer must not be reused until the lease is released.
+	 *
+	 * @param	hGenerator	[in]	A handle to the instance.
+	 * @param	pLease		[out]	Filled with the leased frame.
+	 */
+	XnStatus (XN_CALLBACK_TYPE* AcquireFrame)(XnModuleNodeHandle hGenerator, XnFrameLease* pLease);
+
+	/**
+	 * Releases a lease received from @ref AcquireFrame(). May be called from any thread.
+	 *
+	 * @param	hGenerator	[in]	A handle to the instance.
+	 * @param	pLease		[in]	The lease to release.
+	 */
+	XnStatus (XN_CALLBACK_TYPE* ReleaseFrame)(XnModuleNodeHandle hGenerator, const XnFrameLease* pLease);
+
+	/**
+	 * Sets the policy of the frame pool.
+	 *
+	 * @param	hGenerator	[in]	A handle to the instance.
+	 * @param	pPolicy		[in]	The new policy.
+	 */
+	XnStatus (XN_CALLBACK_TYPE* SetFramePoolPolicy)(XnModuleNodeHandle hGenerator, const XnFramePoolPolicy* pPolicy);
+
+	/**
+	 * Gets the policy of the frame pool.
+	 *
+	 * @param	hGenerator	[in]	A handle to the instance.
+	 * @param	pPolicy		[out]	Filled with the current policy.
+	 */
+	XnStatus (XN_CALLBACK_TYPE* GetFramePoolPolicy)(XnModuleNodeHandle hGenerator, XnFramePoolPolicy* pPolicy);
+
+} XnModuleFrameLeaseInterface;
+
 /** The interface of a generator. */
 typedef struct XnModuleGeneratorInterface
 {
@@ -705,6 +741,9 @@ typedef struct XnModuleGeneratorInterface
 	 */
 	const void* (XN_CALLBACK_TYPE* GetData)(XnModuleNodeHandle hGenerator);
 
+	//Note: The frame lease capability was added after GetData(). Older modules leave it empty.
+	XnModuleFrameLeaseInterface* pFrameLeaseInterface;
+
 } XnModuleGeneratorInterface;
 
 typedef struct XnModuleRecorderInterface
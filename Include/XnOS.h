@@ -88,6 +88,11 @@ extern XnOSTimer g_xnOSHighResGlobalTimer;
 #define XN_OS_FILE_APPEND			0x10
 /** All writes will be immediately written to disk */ 
 #define XN_OS_FILE_AUTO_FLUSH		0x20
+/** Bypass the OS file cache. Buffers, sizes and offsets of writes must be multiples of XN_OS_FILE_DIRECT_ALIGNMENT */ 
+#define XN_OS_FILE_DIRECT			0x40
+
+/** Alignment required for files opened with XN_OS_FILE_DIRECT */ 
+#define XN_OS_FILE_DIRECT_ALIGNMENT	4096
 
 // Seek types
 /** The seek type enum list. */ 
@@ -109,7 +114,9 @@ typedef enum {
 	/** UDP socket. */ 
 	XN_OS_UDP_SOCKET = 0,
 	/** TCP socket. */ 
-	XN_OS_TCP_SOCKET
+	XN_OS_TCP_SOCKET,
+	/** Local (Unix domain) stream socket. The address is a file name, and the port is ignored. Not supported on Windows. */ 
+	XN_OS_LOCAL_SOCKET
 } XnOSSocketType;
 
 #define XN_OS_NETWORK_LOCAL_HOST	"127.0.0.1"
@@ -360,6 +367,51 @@ XN_C_API void XN_C_DECL xnOSLogMemFree(const void* pMemBlock);
 */
 XN_C_API void XN_C_DECL xnOSWriteMemoryReport(const XnChar* csFileName);
 
+/** Average number of allocated bytes between two samples, used when profiling starts implicitly. */
+#define XN_MEM_PROF_DEFAULT_SAMPLING_INTERVAL	(512 * 1024)
+
+typedef struct XnMemProfilerStats
+{
+	/** Average number of allocated bytes between two samples. */
+	XnUInt32 nSamplingInterval;
+	/** Number of allocations that were sampled since profiling started. */
+	XnUInt64 nSampledAllocations;
+	/** Number of sampled allocations that were not freed yet. */
+	XnUInt32 nLiveSamples;
+	/** Estimated number of bytes held by allocations that were not freed yet. */
+	XnUInt64 nEstimatedLiveBytes;
+	/** Number of distinct call sites seen by the sampler. */
+	XnUInt32 nCallSites;
+	/** Number of samples that were discarded because the profiler's tables were full (the sum of the two below). */
+	XnUInt64 nDroppedSamples;
+	/** Samples dropped because the call site table was full. */
+	XnUInt64 nDroppedForCallSites;
+	/** Samples dropped because too many live samples hashed to the same stripe. */
+	XnUInt64 nDroppedForSampleSlots;
+} XnMemProfilerStats;
+
+/**
+* Memory Profiling - Starts (or re-configures) the sampling allocation profiler. On average, one allocation
+* is sampled every @a nSamplingInterval bytes, so the cost of profiling does not depend on the allocation rate.
+*/
+XN_C_API XnStatus XN_C_DECL xnOSMemProfilerStart(XnUInt32 nSamplingInterval);
+/**
+* Memory Profiling - Stops the sampling allocation profiler and discards its samples.
+*/
+XN_C_API XnStatus XN_C_DECL xnOSMemProfilerStop();
+XN_C_API XnBool XN_C_DECL xnOSMemProfilerIsActive();
+XN_C_API XnStatus XN_C_DECL xnOSMemProfilerGetStats(XnMemProfilerStats* pStats);
+/**
+* Memory Profiling - Writes estimated live memory per call site, and its growth since the previous snapshot.
+* Call stacks are only symbolized at this point.
+*/
+XN_C_API XnStatus XN_C_DECL xnOSMemProfilerWriteSnapshot(const XnChar* strFileName);
+/**
+* Memory Profiling - Writes a snapshot named <strFilePrefix>-<N>.txt every @a nIntervalMs milliseconds.
+*/
+XN_C_API XnStatus XN_C_DECL xnOSMemProfilerStartPeriodicSnapshots(const XnChar* strFilePrefix, XnUInt32 nIntervalMs);
+XN_C_API XnStatus XN_C_DECL xnOSMemProfilerStopPeriodicSnapshots();
+
 // for memory profiling, replace all malloc/calloc/free/new/delete calls
 #if (defined XN_MEM_PROFILING) && (!defined(XN_OS_IMPL))
 	#ifdef _MSC_VER 
@@ -447,6 +499,7 @@ XN_C_API XnStatus XN_C_DECL xnOSGetFileList(const XnChar* cpSearchPattern, const
 XN_C_API XnStatus XN_C_DECL xnOSOpenFile(const XnChar* cpFileName, const XnUInt32 nFlags, XN_FILE_HANDLE* pFile);
 XN_C_API XnStatus XN_C_DECL xnOSCloseFile(XN_FILE_HANDLE* pFile);
 XN_C_API XnStatus XN_C_DECL xnOSReadFile(const XN_FILE_HANDLE File, void* pBuffer, XnUInt32* pnBufferSize);
+XN_C_API XnStatus XN_C_DECL xnOSReadFileAt(const XN_FILE_HANDLE File, XnUInt64 nOffset, void* pBuffer, XnUInt32* pnBufferSize);
 XN_C_API XnStatus XN_C_DECL xnOSWriteFile(const XN_FILE_HANDLE File, const void* pBuffer, const XnUInt32 nBufferSize);
 XN_C_API XnStatus XN_API_DEPRECATED("Use xnOSSeekFile64() instead") XN_C_DECL 
 			    xnOSSeekFile  (const XN_FILE_HANDLE File, const XnOSSeekType SeekType, const XnInt32 nOffset);
@@ -455,6 +508,8 @@ XN_C_API XnStatus XN_API_DEPRECATED("Use xnOSTellFile64() instead") XN_C_DECL
 			    xnOSTellFile  (const XN_FILE_HANDLE File, XnUInt32* nFilePos);
 XN_C_API XnStatus XN_C_DECL xnOSTellFile64(const XN_FILE_HANDLE File, XnUInt64* nFilePos);
 XN_C_API XnStatus XN_C_DECL xnOSFlushFile(const XN_FILE_HANDLE File);
+XN_C_API XnStatus XN_C_DECL xnOSPreallocateFile(const XN_FILE_HANDLE File, XnUInt64 nSize);
+XN_C_API XnStatus XN_C_DECL xnOSTruncateFile(const XN_FILE_HANDLE File, XnUInt64 nSize);
 XN_C_API XnStatus XN_C_DECL xnOSDoesFileExist(const XnChar* cpFileName, XnBool* pbResult);
 XN_C_API XnStatus XN_C_DECL xnOSDoesDirecotyExist(const XnChar* cpDirName, XnBool* pbResult);
 XN_C_API XnStatus XN_C_DECL xnOSLoadFile(const XnChar* cpFileName, void* pBuffer, const XnUInt32 nBufferSize);
@@ -499,6 +554,12 @@ XN_C_API XnStatus XN_C_DECL xnOSGetEpochTime(XnUInt32* nEpochTime);
 XN_C_API XnStatus XN_C_DECL xnOSGetTimeStamp(XnUInt64* nTimeStamp);
 XN_C_API XnStatus XN_C_DECL xnOSGetHighResTimeStamp(XnUInt64* nTimeStamp);
 XN_C_API XnStatus XN_C_DECL xnOSSleep(XnUInt32 nMilliseconds);
+/**
+* Sleeps until the high resolution timestamp (see @ref xnOSGetHighResTimeStamp()) reaches nTimeStamp.
+* Returns immediately if it already did. Sleeping to an absolute deadline (rather than for a duration)
+* means oversleeping once does not delay all the following deadlines.
+*/
+XN_C_API XnStatus XN_C_DECL xnOSSleepUntilHighResTimeStamp(XnUInt64 nTimeStamp);
 XN_C_API XnStatus XN_C_DECL xnOSStartTimer(XnOSTimer* pTimer);
 XN_C_API XnStatus XN_C_DECL xnOSStartHighResTimer(XnOSTimer* pTimer);
 XN_C_API XnStatus XN_C_DECL xnOSQueryTimer(XnOSTimer Timer, XnUInt64* pnTimeSinceStart);
@@ -523,6 +584,60 @@ XN_C_API XnStatus XN_C_DECL xnOSWaitForThreadExit(XN_THREAD_HANDLE ThreadHandle,
 XN_C_API XnStatus XN_C_DECL xnOSSetThreadPriority(XN_THREAD_HANDLE ThreadHandle, XnThreadPriority nPriority);
 XN_C_API XnStatus XN_C_DECL xnOSGetCurrentThreadID(XN_THREAD_ID* pThreadID);
 XN_C_API XnStatus XN_C_DECL xnOSWaitAndTerminateThread(XN_THREAD_HANDLE* pThreadHandle, XnUInt32 nMilliseconds);
+XN_C_API XnStatus XN_C_DECL xnOSSetThreadAffinity(XN_THREAD_HANDLE ThreadHandle, XnUInt64 nCPUMask);
+XN_C_API XnStatus XN_C_DECL xnOSSetThreadName(XN_THREAD_HANDLE ThreadHandle, const XnChar* strName);
+
+// Atomic Operations
+/** Full memory barrier: no load or store is moved across it, by the compiler or by the CPU. */
+XN_C_API void XN_C_DECL xnOSMemoryBarrier();
+/** Atomically adds nValue to *pValue, and returns the new value. Also a full memory barrier. */
+XN_C_API XnInt32 XN_C_DECL xnOSAtomicAdd32(volatile XnInt32* pValue, XnInt32 nValue);
+/** Atomically sets *pValue to nNew if it is nExpected. Returns TRUE if it did. Also a full memory barrier. */
+XN_C_API XnBool XN_C_DECL xnOSAtomicCompareAndSwap32(volatile XnInt32* pValue, XnInt32 nExpected, XnInt32 nNew);
+
+// One-Time Initialization
+typedef volatile XnInt32 XN_ONCE;
+/** Initial value of an @ref XN_ONCE (so that it can be statically initialized). */
+#define XN_ONCE_INIT	0
+typedef XnStatus (XN_CALLBACK_TYPE* XnOnceFunc)(void* pCookie);
+/** 
+* Runs pFunc the first time it is called with pOnce. Other threads calling it meanwhile wait until pFunc returns.
+* If pFunc fails, its error is returned, and the next call runs it again.
+*/
+XN_C_API XnStatus XN_C_DECL xnOSRunOnce(XN_ONCE* pOnce, XnOnceFunc pFunc, void* pCookie);
+
+// Thread Policies
+/** Roles of the threads OpenNI creates internally. Policies are looked up by role. */
+#define XN_THREAD_ROLE_USB_READ				"USBRead"
+#define XN_THREAD_ROLE_USB_EVENTS			"USBEvents"
+#define XN_THREAD_ROLE_USB_DEVICE			"USBDevice"
+#define XN_THREAD_ROLE_PLAYBACK				"Playback"
+#define XN_THREAD_ROLE_PLAYER_READ_AHEAD	"PlayerReadAhead"
+#define XN_THREAD_ROLE_SCHEDULER			"Scheduler"
+#define XN_THREAD_ROLE_PROFILING			"Profiling"
+#define XN_THREAD_ROLE_MEM_PROFILER			"MemProfiler"
+#define XN_THREAD_ROLE_REGISTRATION			"Registration"
+#define XN_THREAD_ROLE_METRICS				"Metrics"
+
+#define XN_THREAD_ROLE_MAX_LENGTH			32
+#define XN_THREAD_POLICY_MAX_ROLES			32
+
+typedef struct XnThreadPolicy
+{
+	/** CPUs the thread may run on (bit i stands for CPU i). 0 leaves the affinity unchanged. */
+	XnUInt64 nAffinityMask;
+	/** When TRUE, nPriority replaces the priority the thread was created with. */
+	XnBool bOverridePriority;
+	XnThreadPriority nPriority;
+} XnThreadPolicy;
+
+XN_C_API XnStatus XN_C_DECL xnOSSetThreadPolicy(const XnChar* strRole, const XnThreadPolicy* pPolicy);
+XN_C_API XnStatus XN_C_DECL xnOSGetThreadPolicy(const XnChar* strRole, XnThreadPolicy* pPolicy);
+XN_C_API XnStatus XN_C_DECL xnOSClearThreadPolicies();
+XN_C_API XnStatus XN_C_DECL xnOSParseThreadPolicy(const XnChar* strAffinity, const XnChar* strPriority, XnThreadPolicy* pPolicy);
+XN_C_API XnStatus XN_C_DECL xnOSApplyThreadPolicy(XN_THREAD_HANDLE ThreadHandle, const XnChar* strRole, const XnChar* strName);
+XN_C_API XnStatus XN_C_DECL xnOSLoadThreadPoliciesFromINI(const XnChar* strINIFile, const XnChar* strSection);
+XN_C_API XnStatus XN_C_DECL xnOSLoadThreadPoliciesFromXmlFile(const XnChar* strFileName);
 
 // Processes
 XN_C_API XnStatus XN_C_DECL xnOSGetCurrentProcessID(XN_PROCESS_ID* pProcID);
@@ -637,6 +752,10 @@ XN_C_API XnChar XN_C_DECL xnOSReadCharFromInput();
 
 // Debug Utilities
 XN_C_API XnStatus XN_C_DECL xnOSGetCurrentCallStack(XnUInt32 nFramesToSkip, XnChar** astrFrames, XnUInt32 nMaxNameLength, XnUInt32* pnFrames);
+/** Captures raw return addresses only (no symbol lookup), so it is cheap enough for sampling. */
+XN_C_API XnStatus XN_C_DECL xnOSGetCurrentCallStackAddresses(XnUInt32 nFramesToSkip, void** apFrames, XnUInt32* pnFrames);
+/** Resolves addresses captured by xnOSGetCurrentCallStackAddresses() to printable frame names. */
+XN_C_API XnStatus XN_C_DECL xnOSResolveCallStackAddresses(void* const* apFrames, XnUInt32 nFrames, XnChar** astrFrames, XnUInt32 nMaxNameLength);
 
 XN_STATUS_MESSAGE_MAP_START(XN_ERROR_GROUP_OS)
 XN_STATUS_MESSAGE(XN_STATUS_ALLOC_FAILED, "Memory allocation failed!")
@@ -781,6 +900,10 @@ XN_STATUS_MESSAGE(XN_STATUS_OS_INVALID_SEMAPHORE, "This Xiron OS semaphore is in
 XN_STATUS_MESSAGE(XN_STATUS_OS_ENV_VAR_NOT_FOUND, "The environment variable could not be found!")
 XN_STATUS_MESSAGE(XN_STATUS_USB_NO_REQUEST_PENDING, "There is no request pending!")
 XN_STATUS_MESSAGE(XN_STATUS_OS_FAILED_TO_DELETE_DIR, "Failed to delete a directory!")
+XN_STATUS_MESSAGE(XN_STATUS_OS_THREAD_SET_AFFINITY_FAILED, "Xiron OS failed to set a thread's CPU affinity!")
+XN_STATUS_MESSAGE(XN_STATUS_OS_THREAD_SET_NAME_FAILED, "Xiron OS failed to set a thread's name!")
+XN_STATUS_MESSAGE(XN_STATUS_OS_THREAD_POLICY_TABLE_FULL, "Too many thread policies were defined!")
+XN_STATUS_MESSAGE(XN_STATUS_OS_THREAD_POLICY_INVALID, "Thread policy has an invalid affinity or priority!")
 XN_STATUS_MESSAGE_MAP_END(XN_ERROR_GROUP_OS)
 
 #endif //__XN_OS_H__
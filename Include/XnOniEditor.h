@@ -0,0 +1,85 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_ONI_EDITOR_H_
+#define _XN_ONI_EDITOR_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include <XnTypes.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_ONI_EDITOR "OniEditor"
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+struct XnOniEditor; // forward declaration
+typedef struct XnOniEditor XnOniEditor;
+
+//---------------------------------------------------------------------------
+// Exported Function Declaration
+//---------------------------------------------------------------------------
+
+/**
+* Creates a new .oni file, to be filled with parts of existing recordings. Frames are copied as they are
+* stored (still compressed), without decoding or re-encoding them, so editing runs at disk speed.
+*
+* @param	strFileName	[in]	Name of the file to create. An existing file is overwritten.
+* @param	ppEditor	[out]	Upon successful return, holds a handle to the editor.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniEditorCreate(const XnChar* strFileName, XnOniEditor** ppEditor);
+
+/**
+* Appends (part of) a recording to the file. Nodes are matched to the ones already in the file by name,
+* and must have the same type and codec. Other nodes are added. Node IDs, frame numbers, undo positions
+* and seek tables are rewritten. Timestamps are shifted, so that the copied part starts right after
+* everything appended before it (the first one starts at 0), unless @ref XnOniCopyOptions::bKeepTimestamps
+* is set.
+*
+* @param	pEditor			[in]	The editor.
+* @param	strSourceFile	[in]	The .oni file to copy from. Segmented recordings should be appended one
+*									segment at a time.
+* @param	pOptions		[in]	Optional. The range and nodes to copy. NULL copies everything.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniEditorAppend(XnOniEditor* pEditor, const XnChar* strSourceFile, const XnOniCopyOptions* pOptions);
+
+/**
+* Finalizes the file (writes its seek tables and header), closes it, and destroys the editor.
+*
+* @param	ppEditor	[in/out]	A pointer to the editor to be closed.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniEditorClose(XnOniEditor** ppEditor);
+
+/**
+* Copies part of a recording into a new file. A shortcut for creating an editor, appending one recording
+* to it and closing it.
+*
+* @param	strSourceFile	[in]	The .oni file to copy from.
+* @param	strDestFile		[in]	Name of the file to create.
+* @param	pOptions		[in]	Optional. The range and nodes to copy. NULL copies everything.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniEditorCopy(const XnChar* strSourceFile, const XnChar* strDestFile, const XnOniCopyOptions* pOptions);
+
+#endif //_XN_ONI_EDITOR_H_
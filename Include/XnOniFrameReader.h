@@ -0,0 +1,116 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_ONI_FRAME_READER_H_
+#define _XN_ONI_FRAME_READER_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include <XnTypes.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_ONI_FRAME_READER "OniFrameReader"
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+struct XnOniFrameReader; // forward declaration
+typedef struct XnOniFrameReader XnOniFrameReader;
+
+//---------------------------------------------------------------------------
+// Exported Function Declaration
+//---------------------------------------------------------------------------
+
+/**
+* Opens a .oni file for random access to its frames, without a context or a player. The file is indexed
+* once, here. After that, any frame can be read from any number of threads at the same time: reads do not
+* share a file position or any playback state, so they need no locking.
+*
+* @param	strFileName	[in]	The .oni file to read. Recordings that were not closed are read up to their
+*								last complete frame.
+* @param	ppReader	[out]	Upon successful return, holds a handle to the reader.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniFrameReaderOpen(const XnChar* strFileName, XnOniFrameReader** ppReader);
+
+/**
+* Closes the file and destroys the reader. No read may be in progress.
+*
+* @param	ppReader	[in/out]	A pointer to the reader to be closed.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniFrameReaderClose(XnOniFrameReader** ppReader);
+
+/**
+* Gets the number of nodes in the recording. Nodes are numbered from 0 to this number minus 1.
+*
+* @param	pReader	[in]	The reader.
+*/
+XN_C_API XnUInt32 XN_C_DECL xnOniFrameReaderGetNodeCount(const XnOniFrameReader* pReader);
+
+/**
+* Gets the number of a node by its name.
+*
+* @param	pReader		[in]	The reader.
+* @param	strNodeName	[in]	The name of the node.
+* @param	pnNode		[out]	The number of the node.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniFrameReaderFindNode(const XnOniFrameReader* pReader, const XnChar* strNodeName, XnUInt32* pnNode);
+
+/**
+* Gets information about a node.
+*
+* @param	pReader	[in]	The reader.
+* @param	nNode	[in]	The number of the node.
+* @param	pInfo	[out]	Information about the node.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniFrameReaderGetNodeInfo(const XnOniFrameReader* pReader, XnUInt32 nNode, XnOniNodeInfo* pInfo);
+
+/**
+* Reads a frame and decodes it. Can be called from several threads at the same time.
+*
+* Frames stored uncompressed, or with one of the lossless codecs (16z, 16z with embedded tables, 8z) are
+* decoded. For other codecs, XN_STATUS_NOT_IMPLEMENTED is returned, and @ref xnOniFrameReaderReadRawFrame
+* should be used instead.
+*
+* @param	pReader		[in]	The reader.
+* @param	nNode		[in]	The number of the node.
+* @param	nFrame		[in]	The index of the frame in the node, from 0 to its number of frames minus 1.
+* @param	pBuffer		[out]	A buffer to decode the frame into.
+* @param	nBufferSize	[in]	The size of the buffer. The node's nMaxFrameSize is always enough.
+* @param	pFrameInfo	[out]	Optional. Information about the frame.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniFrameReaderReadFrame(XnOniFrameReader* pReader, XnUInt32 nNode, XnUInt32 nFrame, void* pBuffer, XnUInt32 nBufferSize, XnOniFrameInfo* pFrameInfo);
+
+/**
+* Reads a frame as it is stored, without decoding it. Can be called from several threads at the same time.
+*
+* @param	pReader		[in]	The reader.
+* @param	nNode		[in]	The number of the node.
+* @param	nFrame		[in]	The index of the frame in the node, from 0 to its number of frames minus 1.
+* @param	pBuffer		[out]	A buffer to read the frame into.
+* @param	nBufferSize	[in]	The size of the buffer.
+* @param	pFrameInfo	[out]	Optional. Information about the frame. Its data size is the stored size.
+*/
+XN_C_API XnStatus XN_C_DECL xnOniFrameReaderReadRawFrame(XnOniFrameReader* pReader, XnUInt32 nNode, XnUInt32 nFrame, void* pBuffer, XnUInt32 nBufferSize, XnOniFrameInfo* pFrameInfo);
+
+#endif //_XN_ONI_FRAME_READER_H_
@@ -800,6 +800,57 @@ XN_C_API void XN_C_DECL xnUnregisterFromFrameSyncChange(XnNodeHandle hInstance,
 
 /** @} */
 
+//---------------------------------------------------------------------------
+// FrameLease Capability
+//---------------------------------------------------------------------------
+
+/** 
+ * @ingroup generator
+ * @defgroup framelease Frame Lease Capability
+ * The Frame Lease capability (@ref XN_CAPABILITY_FRAME_LEASE) lets an application hold on to a frame after the
+ * generator was updated, without copying it. The generator keeps a pool of frame buffers, and a leased buffer 
+ * is not reused until the lease is released. This allows handing frames to other threads for processing.
+ *
+ * When all buffers are leased, the generator either grows the pool or drops new frames, as set by 
+ * @ref xnSetFramePoolPolicy.
+ * @{
+ */
+
+/**
+ * @brief Leases the current frame of the generator. The frame stays valid until @ref xnReleaseFrame() is called,
+ * even if the generator is updated meanwhile. The node must not be destroyed while it has leased frames.
+ *
+ * @param	hInstance	[in]	A handle to the instance.
+ * @param	pLease		[out]	Filled with the leased frame.
+ */
+XN_C_API XnStatus XN_C_DECL xnAcquireFrame(XnNodeHandle hInstance, XnFrameLease* pLease);
+
+/**
+ * @brief Releases a frame leased with @ref xnAcquireFrame(). Can be called from any thread.
+ *
+ * @param	hInstance	[in]	A handle to the instance.
+ * @param	pLease		[in]	The lease to release.
+ */
+XN_C_API XnStatus XN_C_DECL xnReleaseFrame(XnNodeHandle hInstance, const XnFrameLease* pLease);
+
+/**
+ * @brief Sets the size of the frame pool, and what happens when all of its buffers are leased.
+ *
+ * @param	hInstance	[in]	A handle to the instance.
+ * @param	pPolicy		[in]	The pool policy.
+ */
+XN_C_API XnStatus XN_C_DECL xnSetFramePoolPolicy(XnNodeHandle hInstance, const XnFramePoolPolicy* pPolicy);
+
+/**
+ * @brief Gets the current frame pool policy.
+ *
+ * @param	hInstance	[in]	A handle to the instance.
+ * @param	pPolicy		[out]	Filled with the pool policy.
+ */
+XN_C_API XnStatus XN_C_DECL xnGetFramePoolPolicy(XnNodeHandle hInstance, XnFramePoolPolicy* pPolicy);
+
+/** @} */
+
 //---------------------------------------------------------------------------
 // Map Generators
 //---------------------------------------------------------------------------
@@ -2344,11 +2395,21 @@ XN_C_API XnStatus XN_C_DECL xnCreateRecorder(XnContext* pContext, const XnChar*
  * @brief Tells the recorder where to record.
  *
  * @param	hRecorder	[in]	A handle to the recorder
- * @param	destType	[in]	The type of medium to record to. Currently only XN_RECORD_MEDIUM_FILE is supported.
+ * @param	destType	[in]	The type of medium to record to.
  * @param	strDest		[in]	Recording destination. If destType is XN_RECORD_MEDIUM_FILE, this specifies a file name.
+ *								If destType is XN_RECORD_MEDIUM_NETWORK, this specifies the "host:port" of a listening player.
  */
 XN_C_API XnStatus XN_C_DECL xnSetRecorderDestination(XnNodeHandle hRecorder, XnRecordMedium destType, const XnChar* strDest);
 
+/**
+ * @brief Sets how the recorder writes files (segmenting, buffering and direct I/O). Must be called before
+ * @ref xnSetRecorderDestination.
+ *
+ * @param	hRecorder	[in]	A handle to the recorder
+ * @param	pOptions	[in]	The options to use. See @ref XnRecorderFileOptions.
+ */
+XN_C_API XnStatus XN_C_DECL xnSetRecorderFileOptions(XnNodeHandle hRecorder, const XnRecorderFileOptions* pOptions);
+
 /**
  * @brief Returns the recoder's destination
  *
@@ -2431,16 +2492,37 @@ XN_C_API XnStatus XN_C_DECL xnSetPlayerRepeat(XnNodeHandle hPlayer, XnBool bRepe
 /**
  * @brief Sets the source for the player, i.e. where the played events will come from. 
  
- * The only supported source type at this point is a file.
+ * Supported source types are a file and a network connection. A network source is live: it cannot
+ * be seeked, and playback speed is governed by the remote recorder.
  *
  * @param	hPlayer		[in]	A handle to the player.
- * @param	sourceType	[in]	The type of source to set. Currently only XN_RECORD_MEDIUM_FILE is supported.
+ * @param	sourceType	[in]	The type of source to set.
  * @param	strSource	[in]	The source from which to play. If sourceType is XN_RECORD_MEDIUM_FILE, strSource specifies a file name.
+ *							If sourceType is XN_RECORD_MEDIUM_NETWORK, strSource specifies the local "host:port" to listen on.
  *
  * @sa xnGetPlayerSource()
  */
 XN_C_API XnStatus XN_C_DECL xnSetPlayerSource(XnNodeHandle hPlayer, XnRecordMedium sourceType, const XnChar* strSource);
 
+/**
+ * @brief Sets how the player receives a network source (connect timeout, queue size and latency limit). Must
+ * be called before @ref xnSetPlayerSource.
+ *
+ * @param	hPlayer		[in]	A handle to the player.
+ * @param	pOptions	[in]	The options to use. See @ref XnPlayerNetworkOptions.
+ */
+XN_C_API XnStatus XN_C_DECL xnSetPlayerNetworkOptions(XnNodeHandle hPlayer, const XnPlayerNetworkOptions* pOptions);
+
+/**
+ * @brief Stops waiting for a network source. May be called from any thread.
+ *
+ * A pending @ref xnSetPlayerSource() call that waits for a recorder to connect fails with 
+ * XN_STATUS_OS_EVENT_CANCELED, and a connected source behaves as if the recorder disconnected.
+ *
+ * @param	hPlayer		[in]	A handle to the player.
+ */
+XN_C_API XnStatus XN_C_DECL xnAbortPlayerSource(XnNodeHandle hPlayer);
+
 /**
  * @brief Gets the player's source, i.e where the played events come from.
  *
@@ -2603,6 +2685,26 @@ XN_C_API XnStatus XN_C_DECL xnSetPlaybackSpeed(XnNodeHandle hInstance, XnDouble
  */
 XN_C_API XnDouble XN_C_DECL xnGetPlaybackSpeed(XnNodeHandle hInstance);
 
+/**
+ * @brief Turns real-time playback on or off.
+ * By default, every recorded frame is decoded and played, so a machine that cannot decode as fast as
+ * the recording rate falls further and further behind. In real-time mode, the player keeps up with the
+ * wall clock instead: a frame is not decoded (and is never played) if the next frame of the same node
+ * is already due. Has no effect when the playback speed is XN_PLAYBACK_SPEED_FASTEST, and frames can only
+ * be dropped if the recording has seek tables.
+ *
+ * @param	hInstance	[in]	A handle to the player.
+ * @param	bRealTime	[in]	TRUE to drop late frames, FALSE to play all of them.
+ */
+XN_C_API XnStatus XN_C_DECL xnSetPlayerRealTime(XnNodeHandle hInstance, XnBool bRealTime);
+
+/**
+ * @brief Checks if the player is in real-time mode. see @ref xnSetPlayerRealTime() for more details.
+ *
+ * @param	hInstance	[in]	A handle to the player.
+ */
+XN_C_API XnBool XN_C_DECL xnIsPlayerRealTime(XnNodeHandle hInstance);
+
 /** @} */
 
 //---------------------------------------------------------------------------
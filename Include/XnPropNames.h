@@ -52,10 +52,18 @@
 #define XN_PROP_SUPPORTED_USER_POSITIONS_COUNT "xnSupportedUserPositionsCount" //int
 #define XN_PROP_USER_POSITIONS "xnUserPositions" //general
 #define XN_PROP_FIELD_OF_VIEW "xnFOV" // general (XnFieldOfView)
+#define XN_PROP_REGISTRATION_CALIBRATION "xnRegistrationCalibration" // general (XnRegistrationCalibration). Lets mock nodes register depth into an image's view point.
 
 //AudioGenerator
 #define XN_PROP_WAVE_OUTPUT_MODE "xnWaveOutputMode" //general
 #define XN_PROP_WAVE_SUPPORTED_OUTPUT_MODES_COUNT "xnWaveSupportedOutputModesCount" //int
 #define XN_PROP_WAVE_SUPPORTED_OUTPUT_MODES "xnWaveSupportedOutputModes" //general
 
+//Player
+#define XN_PROP_PLAYBACK_CLOCK "xnPlaybackClock" //general (XnPlaybackClock). Set on player modules in real-time mode.
+#define XN_PROP_SEGMENTED_INPUT_STREAM "xnSegmentedInputStream" //general (XnPlayerSegmentedInputStreamInterface). Set on player modules before the input stream of a segmented recording.
+
+//Filter
+#define XN_PROP_FILTER_STAGES "xnFilterStages" //string. The stage chain of a filter node (see xnCreateFilter).
+
 #endif //__XN_PROP_NAMES_H__
@@ -0,0 +1,190 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_TRACE_H_
+#define _XN_TRACE_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Default number of events kept per thread. **/
+#define XN_TRACE_DEFAULT_EVENTS_PER_THREAD	16384
+
+/** Maximum length of an object name kept in an event (longer names are truncated). **/
+#define XN_TRACE_OBJECT_NAME_LENGTH			20
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/** The stages in the life of a frame that can be traced. **/
+typedef enum XnTraceEventType
+{
+	/** A USB transfer was completed, and its data handed to the device. Size is the number of bytes. **/
+	XN_TRACE_USB_TRANSFER,
+	/** A generator reported new data is available. Frame ID is the number of the report (see @ref xnTraceReportNewData). **/
+	XN_TRACE_NEW_DATA_AVAILABLE,
+	/** The application waited for new data (ends when it wakes up). **/
+	XN_TRACE_WAIT,
+	/** 
+	 * A generator updated its data. The beginning's frame ID is the number of the new data report the update 
+	 * consumes (see @ref xnTraceConsumeNewData), and the end's is the ID of the updated frame.
+	 */
+	XN_TRACE_UPDATE_DATA,
+	/** A codec compressed a frame. Size is the number of input bytes. **/
+	XN_TRACE_ENCODE,
+	/** A codec decompressed a frame. Size is the number of input bytes. **/
+	XN_TRACE_DECODE,
+	/** A recorder recorded a frame. **/
+	XN_TRACE_RECORD,
+	/** A player read the next piece of its recording. **/
+	XN_TRACE_PLAYBACK,
+
+	XN_TRACE_EVENT_TYPE_COUNT,
+} XnTraceEventType;
+
+typedef enum XnTracePhase
+{
+	XN_TRACE_PHASE_BEGIN,
+	XN_TRACE_PHASE_END,
+	XN_TRACE_PHASE_INSTANT,
+} XnTracePhase;
+
+/** A single traced event. Events are fixed-size, so that recording one is just a few stores. **/
+typedef struct XnTraceEvent
+{
+	/** Time of the event, in microseconds (see @ref xnOSGetHighResTimeStamp). **/
+	XnUInt64 nTime;
+	/** Timestamp of the frame this event refers to, if any. **/
+	XnUInt64 nDataTimestamp;
+	/** ID of the frame this event refers to, if any. **/
+	XnUInt32 nFrameID;
+	/** Number of bytes processed, if relevant. **/
+	XnUInt32 nSize;
+	/** An @ref XnTraceEventType value. **/
+	XnUInt16 nType;
+	/** An @ref XnTracePhase value. **/
+	XnUInt16 nPhase;
+	/** Name of the object (node, endpoint) the event refers to. **/
+	XnChar strObject[XN_TRACE_OBJECT_NAME_LENGTH];
+} XnTraceEvent;
+
+//---------------------------------------------------------------------------
+// Exported Function Declaration
+//---------------------------------------------------------------------------
+
+/**
+* Starts tracing. Events are kept in a ring buffer per thread, so that recording an event takes no lock. Once
+* a thread's buffer is full, its oldest events are overwritten. Starting a new trace discards all events
+* of the previous one.
+*
+* @param	nEventsPerThread	[in]	Size of each thread's buffer, in events. Rounded up to a power of two. Zero
+*										means @ref XN_TRACE_DEFAULT_EVENTS_PER_THREAD.
+*/
+XN_C_API XnStatus XN_C_DECL xnTraceStart(XnUInt32 nEventsPerThread);
+
+/**
+* Stops tracing. Events recorded so far are kept, and can still be exported, but the threads' buffers are freed
+* (until tracing is started again).
+*/
+XN_C_API XnStatus XN_C_DECL xnTraceStop();
+
+/**
+* Returns TRUE if tracing is active, or FALSE otherwise.
+*/
+XN_C_API XnBool XN_C_DECL xnTraceIsActive();
+
+/**
+* Records an event for the current thread. This function is not meant to be used directly. Please use the 
+* XN_TRACE_BEGIN, XN_TRACE_END and XN_TRACE_INSTANT macros.
+*
+* @param	type			[in]	Type of the event.
+* @param	phase			[in]	Phase of the event.
+* @param	strObject		[in]	Name of the object the event refers to. Can be NULL.
+* @param	nDataTimestamp	[in]	Timestamp of the frame the event refers to, or 0.
+* @param	nFrameID		[in]	ID of the frame the event refers to, or 0.
+* @param	nSize			[in]	Number of bytes processed, or 0.
+*/
+XN_C_API void XN_C_DECL xnTraceWrite(XnTraceEventType type, XnTracePhase phase, const XnChar* strObject, XnUInt64 nDataTimestamp, XnUInt32 nFrameID, XnUInt32 nSize);
+
+/**
+* Numbers a new data report of an object, so that the export can connect it to the update that consumes it.
+* Returns the number of the report (counting from 1 in each session), or 0 if tracing is not active.
+*
+* @param	strObject	[in]	Name of the object that reported new data.
+*/
+XN_C_API XnUInt32 XN_C_DECL xnTraceReportNewData(const XnChar* strObject);
+
+/**
+* Returns the number of the last new data report of an object, unless an update already consumed it, or 
+* tracing is not active, in which case it returns 0.
+*
+* @param	strObject	[in]	Name of the object being updated.
+*/
+XN_C_API XnUInt32 XN_C_DECL xnTraceConsumeNewData(const XnChar* strObject);
+
+/**
+* Gets the name of an event type.
+*
+* @param	type	[in]	The event type.
+*/
+XN_C_API const XnChar* XN_C_DECL xnTraceEventTypeToString(XnTraceEventType type);
+
+/**
+* Writes all recorded events to a file, in the Chrome trace-event JSON format (which can be opened by 
+* chrome://tracing and by Perfetto). A new-data-available event is connected to the update that consumed the 
+* data by a flow arrow. Can be called while tracing is active.
+*
+* @param	strFileName	[in]	Name of the file to create.
+*/
+XN_C_API XnStatus XN_C_DECL xnTraceExportChromeJSON(const XnChar* strFileName);
+
+/**
+* Records the beginning of a traced stage, if tracing is active.
+*/
+#define XN_TRACE_BEGIN(type, strObject, nDataTimestamp, nFrameID, nSize)						\
+	if (xnTraceIsActive())																		\
+	{																							\
+		xnTraceWrite(type, XN_TRACE_PHASE_BEGIN, strObject, nDataTimestamp, nFrameID, nSize);	\
+	}
+
+/**
+* Records the end of a traced stage, if tracing is active.
+*/
+#define XN_TRACE_END(type, strObject, nDataTimestamp, nFrameID, nSize)							\
+	if (xnTraceIsActive())																		\
+	{																							\
+		xnTraceWrite(type, XN_TRACE_PHASE_END, strObject, nDataTimestamp, nFrameID, nSize);		\
+	}
+
+/**
+* Records a point in time, if tracing is active.
+*/
+#define XN_TRACE_INSTANT(type, strObject, nDataTimestamp, nFrameID, nSize)						\
+	if (xnTraceIsActive())																		\
+	{																							\
+		xnTraceWrite(type, XN_TRACE_PHASE_INSTANT, strObject, nDataTimestamp, nFrameID, nSize);	\
+	}
+
+#endif //_XN_TRACE_H_
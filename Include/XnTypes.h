@@ -343,6 +343,7 @@ typedef XnUInt16 XnLabel;
 #define XN_CAPABILITY_LOW_LIGHT_COMPENSATION	"LowLightCompensation"
 #define XN_CAPABILITY_ANTI_FLICKER				"AntiFlicker"
 #define XN_CAPABILITY_HAND_TOUCHING_FOV_EDGE	"Hands::HandTouchingFOVEdge"
+#define XN_CAPABILITY_FRAME_LEASE				"FrameLease"
 
 // Backwards compatibility - typo was fixed
 #define XN_CAPABILITY_ANTI_FILCKER				XN_CAPABILITY_ANTI_FLICKER
@@ -511,6 +512,42 @@ typedef struct XnFieldOfView
 	XnDouble fVFOV;
 } XnFieldOfView;
 
+/**
+ * Pinhole camera intrinsics. They are given for a reference resolution, and scale linearly to other
+ * resolutions with the same field of view.
+ */
+typedef struct XnCameraIntrinsics
+{
+	/** Number of columns the parameters refer to. */
+	XnUInt32 nXRes;
+	/** Number of rows the parameters refer to. */
+	XnUInt32 nYRes;
+	/** Horizontal focal length, in pixels. */
+	XnDouble fFocalLengthX;
+	/** Vertical focal length, in pixels. */
+	XnDouble fFocalLengthY;
+	/** Principal point column, in pixels. */
+	XnDouble fPrincipalPointX;
+	/** Principal point row, in pixels. */
+	XnDouble fPrincipalPointY;
+} XnCameraIntrinsics;
+
+/**
+ * Calibration of a depth sensor against an image sensor, needed to register depth into the image 
+ * sensor's view point.
+ */
+typedef struct XnRegistrationCalibration
+{
+	/** Intrinsics of the depth sensor. */
+	XnCameraIntrinsics depth;
+	/** Intrinsics of the image sensor. */
+	XnCameraIntrinsics image;
+	/** Rotation from depth sensor coordinates to image sensor coordinates (row-major). */
+	XnDouble aRotation[9];
+	/** Translation from depth sensor coordinates to image sensor coordinates, in millimeters. */
+	XnDouble aTranslation[3];
+} XnRegistrationCalibration;
+
 typedef enum XnPixelFormat
 {
 	XN_PIXEL_FORMAT_RGB24 = 1,
@@ -531,6 +568,45 @@ typedef struct XnSupportedPixelFormats
 	XnUInt m_nReserved : 24;
 } XnSupportedPixelFormats;
 
+/** 
+ * A frame leased from a generator using @ref xnAcquireFrame. The data stays valid (and unchanged) until the
+ * lease is returned with @ref xnReleaseFrame, no matter how many times the generator is updated meanwhile.
+ **/
+typedef struct XnFrameLease
+{
+	/** The frame data. **/
+	const void* pData;
+	/** Size of the data, in bytes. **/
+	XnUInt32 nDataSize;
+	/** Timestamp of the frame, in microseconds. **/
+	XnUInt64 nTimestamp;
+	/** Frame ID of the frame. **/
+	XnUInt32 nFrameID;
+} XnFrameLease;
+
+/** What a generator does when it needs a buffer for new data, and all buffers in its frame pool are leased. **/
+typedef enum XnFramePoolOverflow
+{
+	/** Allocate another buffer, up to @ref XnFramePoolPolicy::nMaxFrames. Frames are dropped beyond that. **/
+	XN_FRAME_POOL_GROW = 0,
+	/** Keep the pool at its size and drop new frames until a lease is released. **/
+	XN_FRAME_POOL_DROP = 1,
+} XnFramePoolOverflow;
+
+/** Controls the pool of frame buffers a generator leases frames from. See @ref xnSetFramePoolPolicy. **/
+typedef struct XnFramePoolPolicy
+{
+	/** 
+	 * Number of buffers in the pool. At least 2, as the generator needs one for the current frame and one to
+	 * fill with the next frame. So the pool can hold nFrames-2 leased frames besides the current one.
+	 **/
+	XnUInt32 nFrames;
+	/** Maximum number of buffers the pool may grow to when overflow is @ref XN_FRAME_POOL_GROW. 0 for no limit. **/
+	XnUInt32 nMaxFrames;
+	/** What to do when all buffers are leased. **/
+	XnFramePoolOverflow overflow;
+} XnFramePoolPolicy;
+
 typedef enum XnPlayerSeekOrigin
 {
 	XN_PLAYER_SEEK_SET = 0,
@@ -836,14 +912,99 @@ typedef enum XnRecordMedium
 {
 	/** Recording medium is a file **/
 	XN_RECORD_MEDIUM_FILE = 0,
+	/** Recording medium is a TCP connection. The medium name is of the form "host:port". **/
+	XN_RECORD_MEDIUM_NETWORK = 1,
 } XnRecordMedium;
 
+/** 
+ * Options for recording to a file (@ref XN_RECORD_MEDIUM_FILE). See @ref xnSetRecorderFileOptions.
+ *
+ * When a segment limit is set, the recording is split into self-contained .oni segments, and the destination 
+ * file holds a manifest listing them. Opening the manifest with a player plays the segments as one recording:
+ * frame numbers, frame counts and seeking span all segments.
+ **/
+typedef struct XnRecorderFileOptions
+{
+	/** Start a new segment after this many seconds of recorded data. 0 for no time limit. **/
+	XnUInt32 nSegmentSeconds;
+	/** Start a new segment once the current one reaches this many bytes. 0 for no size limit. **/
+	XnUInt64 nSegmentBytes;
+	/** Size of the buffer records are coalesced into before being written. 0 for the default. **/
+	XnUInt32 nWriteBufferSize;
+	/** TRUE to bypass the OS file cache when writing (O_DIRECT). Falls back to cached writes if not supported. **/
+	XnBool bDirectIO;
+} XnRecorderFileOptions;
+
+/** 
+ * Options for playing from a network connection (@ref XN_RECORD_MEDIUM_NETWORK). See @ref xnSetPlayerNetworkOptions.
+ *
+ * Received data waits in a bounded queue until it is played. When the queue is full, TCP flow control slows the 
+ * recorder down. When data waited longer than the latency limit, the player drops frames (without decoding them)
+ * until it catches up.
+ **/
+typedef struct XnPlayerNetworkOptions
+{
+	/** How long to wait for a recorder to connect, in milliseconds. 0 for the default (30 seconds). **/
+	XnUInt32 nAcceptTimeout;
+	/** Size of the receive queue, in bytes. 0 for the default (4 MB). **/
+	XnUInt32 nReceiveQueueSize;
+	/** Longest time received data may wait before being played, in milliseconds. 0 for no limit. **/
+	XnUInt32 nMaxLatency;
+} XnPlayerNetworkOptions;
+
+/** 
+ * What to copy from a recording when editing .oni files. See @ref xnOniEditorAppend. A zeroed struct copies
+ * everything.
+ **/
+typedef struct XnOniCopyOptions
+{
+	/** Start of the copied range, in microseconds from the beginning of the source recording. **/
+	XnUInt64 nStartTime;
+	/** End of the copied range (inclusive), in microseconds from the beginning of the source recording. 0 copies up to its end. **/
+	XnUInt64 nEndTime;
+	/** Names of the nodes to copy. NULL copies all of them. **/
+	const XnChar** astrNodeNames;
+	/** Number of names in astrNodeNames. **/
+	XnUInt32 nNodeNames;
+	/** 
+	 * TRUE to keep the recorded timestamps. By default they are shifted, so that the copied part starts right 
+	 * after what was appended before it (or at 0). Kept timestamps must start after the end of the file.
+	 **/
+	XnBool bKeepTimestamps;
+} XnOniCopyOptions;
+
 /** An ID of a codec. See @ref xnCreateCodec. **/
 typedef XnUInt32 XnCodecID;
 
 /** Define a Codec ID by 4 characters, e.g. XN_CODEC_ID('J','P','E','G') **/
 #define XN_CODEC_ID(c1, c2, c3, c4) (XnCodecID)((c4 << 24) | (c3 << 16) | (c2 << 8) | c1)
 
+/** A node of a recording opened with @ref xnOniFrameReaderOpen. **/
+typedef struct XnOniNodeInfo
+{
+	XnChar strName[XN_MAX_NAME_LENGTH];
+	XnProductionNodeType type;
+	/** The codec its frames are stored with. **/
+	XnCodecID codec;
+	XnUInt32 nFrames;
+	XnUInt64 nMinTimestamp;
+	XnUInt64 nMaxTimestamp;
+	/** Size, in bytes, of a buffer any of its frames fits into once decoded. **/
+	XnUInt32 nMaxFrameSize;
+} XnOniNodeInfo;
+
+/** A frame read by @ref xnOniFrameReaderReadFrame. **/
+typedef struct XnOniFrameInfo
+{
+	XnUInt32 nFrameID;
+	XnUInt64 nTimestamp;
+	/** Number of bytes written to the buffer. **/
+	XnUInt32 nDataSize;
+	/** Resolution of the frame, after cropping (map nodes only, 0 otherwise). **/
+	XnUInt32 nXRes;
+	XnUInt32 nYRes;
+} XnOniFrameInfo;
+
 /** 
  * An interface used for communication between OpenNI and a recorder module. This interface is used by a recorder
  * module to send recorded data to OpenNI, which then knows how to store them according to one of the values of
@@ -870,7 +1031,8 @@ typedef struct XnRecorderOutputStreamInterface
 		const void* pData, XnUInt32 nSize);
 
 	/**
-	 * Sets the stream's pointer to the specified position.
+	 * Sets the stream's pointer to the specified position. May be NULL if the medium does not support
+	 * seeking (e.g. @ref XN_RECORD_MEDIUM_NETWORK).
 	 *
 	 * @param	pCookie		 [in]	A cookie that was received with this interface.
 	 * @param	seekType	 [in]	Specifies how to seek - according to current position, end or beginning.
@@ -897,6 +1059,7 @@ typedef struct XnRecorderOutputStreamInterface
 
 	/**
 	 * Sets the stream's pointer to the specified position. (64bit version, for large files)
+	 * May be NULL if the medium does not support seeking.
 	 *
 	 * @param	pCookie		 [in]	A cookie that was received with this interface.
 	 * @param	seekType	 [in]	Specifies how to seek - according to current position, end or beginning.
@@ -942,7 +1105,8 @@ typedef struct XnPlayerInputStreamInterface
 	XnStatus (XN_CALLBACK_TYPE* Read)(void* pCookie, void* pBuffer, XnUInt32 nSize, XnUInt32* pnBytesRead);
 
 	/**
-	 * Sets the stream's pointer to the specified position.
+	 * Sets the stream's pointer to the specified position. May be NULL if the medium does not support
+	 * seeking (e.g. @ref XN_RECORD_MEDIUM_NETWORK).
 	 *
 	 * @param	pCookie		 [in]	A cookie that was received with this interface.
 	 * @param	seekType	 [in]	Specifies how to seek - according to current position, end or beginning.
@@ -968,6 +1132,7 @@ typedef struct XnPlayerInputStreamInterface
 
 	/**
 	 * Sets the stream's pointer to the specified position. (64bit version, for large files)
+	 * May be NULL if the medium does not support seeking.
 	 *
 	 * @param	pCookie		 [in]	A cookie that was received with this interface.
 	 * @param	seekType	 [in]	Specifies how to seek - according to current position, end or beginning.
@@ -987,6 +1152,64 @@ typedef struct XnPlayerInputStreamInterface
 
 } XnPlayerInputStreamInterface;
 
+/** The version of @ref XnPlayerSegmentedInputStreamInterface declared by this header. */
+#define XN_PLAYER_SEGMENTED_INPUT_STREAM_VERSION	1
+
+/**
+ * Lets a player module play a segmented recording (see @ref XnRecorderFileOptions) as one stream. It is passed
+ * to player modules by setting the @ref XN_PROP_SEGMENTED_INPUT_STREAM property on them, before the input stream
+ * is set. The input stream starts out on the first segment.
+ *
+ * Later versions only add members at the end. A module checks nVersion before using members it knows of.
+ */
+typedef struct XnPlayerSegmentedInputStreamInterface
+{
+	/** The version of this interface the caller implements. @ref XN_PLAYER_SEGMENTED_INPUT_STREAM_VERSION or above. */
+	XnUInt32 nVersion;
+
+	/** A cookie to be passed to every call. */
+	void* pCookie;
+
+	/**
+	 * Gets the number of segments in the recording.
+	 *
+	 * @param	pCookie		[in]	The cookie that was passed along with this interface.
+	 */
+	XnUInt32 (XN_CALLBACK_TYPE* GetSegmentCount)(void* pCookie);
+
+	/**
+	 * Re-opens the input stream on another segment, positioned at its beginning.
+	 *
+	 * @param	pCookie		[in]	The cookie that was passed along with this interface.
+	 * @param	nSegment	[in]	Zero-based index of the segment to open.
+	 *
+	 * @returns XN_STATUS_NO_MATCH if there is no such segment.
+	 */
+	XnStatus (XN_CALLBACK_TYPE* OpenSegment)(void* pCookie, XnUInt32 nSegment);
+
+} XnPlayerSegmentedInputStreamInterface;
+
+/**
+ * Lets a player module ask how far playback has progressed, so it can drop frames that are already late.
+ * It is passed to player modules by setting the @ref XN_PROP_PLAYBACK_CLOCK property on them.
+ *
+ * For a live source (one that cannot seek), there is no next frame to compare with, and the clock is asked
+ * about the frame being read: it is due if its data waited too long to still be played.
+ */
+typedef struct XnPlaybackClock
+{
+	/**
+	 * Checks if data with the given timestamp should already be playing.
+	 *
+	 * @param	pCookie		[in]	The cookie that was passed along with this interface.
+	 * @param	nTimestamp	[in]	A timestamp, in recording time.
+	 */
+	XnBool (XN_CALLBACK_TYPE* IsTimestampDue)(void* pCookie, XnUInt64 nTimestamp);
+
+	/** A cookie to be passed to every call. */
+	void* pCookie;
+} XnPlaybackClock;
+
 /** 
  * An interface that is used for notifications about node events.
  **/
@@ -1184,6 +1407,69 @@ typedef struct XnSceneMetaData
 	const XnLabel* pData;
 } XnSceneMetaData;
 
+//---------------------------------------------------------------------------
+// Metrics
+//---------------------------------------------------------------------------
+
+/** Accumulated durations of a repeated operation. All times are in microseconds. **/
+typedef struct XnLatencyMetrics
+{
+	/** Number of times the operation was measured. **/
+	XnUInt64 nCount;
+	/** Sum of all measured durations. **/
+	XnUInt64 nTotal;
+	/** Longest measured duration. **/
+	XnUInt64 nMax;
+} XnLatencyMetrics;
+
+/** 
+ * A snapshot of the counters OpenNI keeps for a single node. Counters only grow, from the moment the node
+ * was created, so rates are calculated from the difference between two snapshots.
+ **/
+typedef struct XnNodeMetrics
+{
+	/** The name of the node. **/
+	XnChar strName[XN_MAX_NAME_LENGTH];
+	/** The type of the node. **/
+	XnProductionNodeType type;
+
+	/** Generators: number of times the node reported new data. **/
+	XnUInt64 nFramesGenerated;
+	/** Generators: number of frames the application received by updating the node. **/
+	XnUInt64 nFramesConsumed;
+	/** Generators: number of frames that were replaced by newer ones before the node was updated (by frame ID). **/
+	XnUInt64 nFramesSkipped;
+	/** Generators: total size of the frames the application received. **/
+	XnUInt64 nBytesConsumed;
+	/** Generators: time spent updating the node's data. **/
+	XnLatencyMetrics updateLatency;
+	/** Generators: time from the node reporting new data until it was updated. **/
+	XnLatencyMetrics dataLatency;
+
+	/** Codecs: time spent compressing data. **/
+	XnLatencyMetrics encodeLatency;
+	/** Codecs: time spent decompressing data. **/
+	XnLatencyMetrics decodeLatency;
+
+	/** Recorders: time spent recording a frame. **/
+	XnLatencyMetrics recordLatency;
+	/** Recorders: number of bytes recorded but not yet written to the destination. **/
+	XnUInt64 nQueuedBytes;
+	/** Recorders: highest value @ref nQueuedBytes had. **/
+	XnUInt64 nMaxQueuedBytes;
+} XnNodeMetrics;
+
+/** A snapshot of the counters OpenNI keeps for a context. **/
+typedef struct XnContextMetrics
+{
+	/** When the snapshot was taken (see @ref xnOSGetHighResTimeStamp), in microseconds. **/
+	XnUInt64 nTimestamp;
+	/** Number of nodes in the context. **/
+	XnUInt32 nNodeCount;
+	/** Time the application spent waiting for data in one of the xnWaitXUpdateAll() functions. **/
+	XnLatencyMetrics waitLatency;
+} XnContextMetrics;
+
 #if XN_PLATFORM != XN_PLATFORM_ARC
 #pragma pack (pop)
 #endif
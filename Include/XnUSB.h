@@ -25,6 +25,13 @@
 // Includes
 //---------------------------------------------------------------------------
 #include "XnOS.h"
+#include "XnTypes.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Environment variable holding the read thread mode endpoints are opened in ("ordered" or "completion"). */
+#define XN_USB_READ_THREAD_MODE_ENV "XN_USB_READ_THREAD_MODE"
 
 //---------------------------------------------------------------------------
 // Structures & Enums
@@ -57,6 +64,41 @@ typedef enum {
 	XN_USB_EVENT_DEVICE_DISCONNECT,
 } XnUSBEventType;
 
+/** How the transfers of an endpoint read thread are processed. */
+typedef enum {
+	/** A dedicated thread waits for the transfers one after the other, in the order they were submitted. */
+	XN_USB_READ_THREAD_MODE_ORDERED = 0,
+	/** 
+	* Transfers are passed to the read callback and resubmitted by the thread that completes them, in the 
+	* order they complete. The callback runs on the USB events thread, which all endpoints share, so it should 
+	* return quickly.
+	*/
+	XN_USB_READ_THREAD_MODE_COMPLETION,
+} XnUSBReadThreadMode;
+
+/** Counters of an endpoint read thread, since it was started. All times are in microseconds. */
+typedef struct XnUSBEndPointStatistics
+{
+	/** Number of transfers that returned, successfully or not. */
+	XnUInt64 nTransfers;
+	/** Number of bytes passed to the read callback. */
+	XnUInt64 nBytes;
+	/** Number of transfers that timed out. */
+	XnUInt64 nTimeouts;
+	/** Number of transfers that failed for any other reason. */
+	XnUInt64 nFailedTransfers;
+	/** Number of isochronous packets that failed. */
+	XnUInt64 nFailedPackets;
+	/** Number of times a transfer could not be submitted. */
+	XnUInt64 nSubmitFailures;
+	/** From submitting a transfer until it returned. */
+	XnLatencyMetrics transferLatency;
+	/** From a transfer returning until its data was passed to the read callback. */
+	XnLatencyMetrics dispatchLatency;
+	/** Time spent in the read callback. */
+	XnLatencyMetrics callbackDuration;
+} XnUSBEndPointStatistics;
+
 struct XnUSBDeviceHandle;
 struct XnUSBEndPointHandle;
 
@@ -65,7 +107,19 @@ typedef XnChar XnUSBConnectionString[XN_FILE_MAX_PATH];
 typedef XnUSBDeviceHandle*  XN_USB_DEV_HANDLE;
 typedef XnUSBEndPointHandle* XN_USB_EP_HANDLE;
 
+/** A packet received by a read thread. */
+typedef struct XnUSBPacket
+{
+	/** Data of the packet, where it was received. Only valid during the callback. */
+	XnUChar* pData;
+	/** Number of bytes received. 0 if the packet was empty, or failed. */
+	XnUInt32 nSize;
+	/** XN_STATUS_OK, or the reason the packet failed. */
+	XnStatus nStatus;
+} XnUSBPacket;
+
 typedef XnBool (XN_CALLBACK_TYPE* XnUSBReadCallbackFunctionPtr)(XnUChar* pBuffer, XnUInt32 nBufferSize, void* pCallbackData);
+typedef XnBool (XN_CALLBACK_TYPE* XnUSBReadPacketsCallbackFunctionPtr)(const XnUSBPacket* aPackets, XnUInt32 nCount, void* pCallbackData);
 typedef XnBool (XN_CALLBACK_TYPE* XnUSBEventCallbackFunctionPtr)(XnUSBEventType USBEventType, XnChar* cpDevPath, void* pCallbackData);
 
 typedef struct XnUSBEventArgs
@@ -119,6 +173,26 @@ XN_C_API XnStatus XN_C_DECL xnUSBFinishReadEndPoint(XN_USB_EP_HANDLE pEPHandle,
 XN_C_API XnStatus XN_C_DECL xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, void* pCallbackData);
 XN_C_API XnStatus XN_C_DECL xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle);
 
+/**
+* Starts a read thread that passes the packets of each transfer to the callback where they were received. 
+* @ref xnUSBInitReadThread moves the packets of isochronous transfers together before calling its callback, 
+* which parsers that handle one packet at a time do not need. Bulk and interrupt transfers are passed as a 
+* single packet. The callback is only called for transfers that received some data. The read thread is 
+* stopped with @ref xnUSBShutdownReadThread.
+*/
+XN_C_API XnStatus XN_C_DECL xnUSBInitPacketReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadPacketsCallbackFunctionPtr pCallbackFunction, void* pCallbackData);
+
+/**
+* Sets how the read thread of an endpoint will process its transfers. Must be called before the read thread 
+* is started. Endpoints are opened in the mode @ref XN_USB_READ_THREAD_MODE_ENV names, or in ordered mode if 
+* it is not set.
+*/
+XN_C_API XnStatus XN_C_DECL xnUSBSetReadThreadMode(XN_USB_EP_HANDLE pEPHandle, XnUSBReadThreadMode mode);
+XN_C_API XnStatus XN_C_DECL xnUSBGetReadThreadMode(XN_USB_EP_HANDLE pEPHandle, XnUSBReadThreadMode* pMode);
+
+/** Gets the counters of an endpoint read thread. They are reset whenever the read thread is started. */
+XN_C_API XnStatus XN_C_DECL xnUSBGetEndPointStatistics(XN_USB_EP_HANDLE pEPHandle, XnUSBEndPointStatistics* pStatistics);
+
 XN_C_API XnStatus XN_API_DEPRECATED("Use xnUSBRegisterToConnectivityEvents() instead") XN_C_DECL xnUSBSetCallbackHandler(XnUInt16 nVendorID, XnUInt16 nProductID, void* pExtraParam, XnUSBEventCallbackFunctionPtr pCallbackFunction, void* pCallbackData);
 
 XN_C_API XnStatus XN_C_DECL xnUSBRegisterToConnectivityEvents(XnUInt16 nVendorID, XnUInt16 nProductID, XnUSBDeviceCallbackFunctionPtr pFunc, void* pCookie, XnRegistrationHandle* phRegistration);
@@ -0,0 +1,156 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_USB_SIMULATOR_H_
+#define _XN_USB_SIMULATOR_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnUSB.h"
+
+//---------------------------------------------------------------------------
+// Structures & Enums
+//---------------------------------------------------------------------------
+/** 
+* Describes a simulated endpoint. IN endpoints send a counting pattern: byte k of the stream one sends is 
+* (k % @ref XN_USB_SIMULATOR_PATTERN_PERIOD). OUT endpoints accept whatever is written to them, at once.
+*/
+typedef struct XnUSBSimulatedEndPointConfig
+{
+	/** Address of the endpoint. The IN bit (0x80) sets its direction. */
+	XnUInt16 nEndPointID;
+	XnUSBEndPointType nType;
+	/** Maximum packet size. Read threads of isochronous endpoints put as many packets in a buffer as fit in it. */
+	XnUInt32 nMaxPacketSize;
+	/** 
+	* Rate at which the device produces data, in bytes per second. Data produced while no transfer is queued is 
+	* lost. 0 completes transfers as soon as they are submitted.
+	*/
+	XnUInt32 nBytesPerSecond;
+	/** Bytes the device puts in each isochronous packet, or in each bulk or interrupt transfer. 0 fills them. */
+	XnUInt32 nBytesPerPacket;
+	/** 
+	* Longest delay, in microseconds, added to the completion of each transfer. Every transfer gets a random 
+	* delay up to it. The simulator sleeps in whole milliseconds, so shorter delays are rounded up.
+	*/
+	XnUInt32 nJitter;
+	/** 
+	* Out of every million isochronous packets (or bulk and interrupt transfers), how many are lost. Lost packets 
+	* return empty, with an error, and their data never arrives. 
+	*/
+	XnUInt32 nLossPerMillion;
+	/** The device is disconnected once this endpoint sent this many bytes. 0 never disconnects it. */
+	XnUInt64 nDisconnectAfterBytes;
+	/** Seeds the random delays and losses, so runs can be repeated. */
+	XnUInt32 nSeed;
+} XnUSBSimulatedEndPointConfig;
+
+#define XN_USB_SIMULATOR_PATTERN_PERIOD 251
+
+/** Paths of simulated devices start with this prefix. */
+#define XN_USB_SIMULATOR_PATH_PREFIX "sim:"
+
+/** 
+* Answers a control transfer sent to a simulated device.
+*
+* @param	nType			[in]		Type of the request.
+* @param	nDirection		[in]		@ref XN_USB_DIRECTION_IN if the host receives data.
+* @param	nRequest		[in]		The request.
+* @param	nValue			[in]		The value of the request.
+* @param	nIndex			[in]		The index of the request.
+* @param	pBuffer			[in/out]	Data sent by the host, or to be filled with the data it receives.
+* @param	nBufferSize		[in]		Size of the buffer.
+* @param	pnBytes			[out]		Bytes received by the host (IN transfers only).
+* @param	pCookie			[in]		The cookie the device was connected with.
+*
+* @returns	XN_STATUS_OK, or an error, which stalls the transfer.
+*/
+typedef XnStatus (XN_CALLBACK_TYPE* XnUSBSimulatedControlHandler)(XnUSBControlType nType, XnUSBDirectionType nDirection, XnUInt8 nRequest, XnUInt16 nValue, XnUInt16 nIndex, XnUChar* pBuffer, XnUInt32 nBufferSize, XnUInt32* pnBytes, void* pCookie);
+
+/** Describes a simulated device. It has a single interface, whose alternate settings all have the same endpoints. */
+typedef struct XnUSBSimulatedDeviceConfig
+{
+	XnUInt16 nVendorID;
+	XnUInt16 nProductID;
+	XnUSBDeviceSpeed nSpeed;
+	/** The endpoints of the device. */
+	const XnUSBSimulatedEndPointConfig* aEndPoints;
+	XnUInt32 nEndPoints;
+	/** Answers control transfers. When NULL, IN transfers receive the data of the last OUT transfer. */
+	XnUSBSimulatedControlHandler pControlHandler;
+	void* pControlCookie;
+} XnUSBSimulatedDeviceConfig;
+
+/** What happened to the data of a simulated endpoint, as seen from the device. */
+typedef struct XnUSBSimulatedEndPointStatistics
+{
+	/** Bytes that reached the host (IN), or that the host wrote (OUT). */
+	XnUInt64 nBytesTransferred;
+	/** Bytes the device produced while no transfer was queued, which were dropped (paced IN endpoints only). */
+	XnUInt64 nBytesOverrun;
+	/** Packets (or bulk and interrupt transfers) lost on the way. */
+	XnUInt64 nPacketsLost;
+	/** Bytes in the lost packets. */
+	XnUInt64 nBytesLost;
+} XnUSBSimulatedEndPointStatistics;
+
+//---------------------------------------------------------------------------
+// Exported Function Declaration
+//---------------------------------------------------------------------------
+/**
+* Opens a simulated IN endpoint, which needs no USB hardware, nor a device to open it from. Transfers submitted 
+* by its read thread (see @ref xnUSBInitReadThread) are completed by a thread of the simulator, much like the USB 
+* events thread completes the transfers of real devices. The endpoints of simulated devices work the same way. 
+* When the endpoint is configured to disconnect, it is disconnected alone. It is closed with 
+* @ref xnUSBCloseEndPoint.
+*
+* @param	pConfig			[in]	Describes the endpoint.
+* @param	pEPHandlePtr	[out]	The opened endpoint.
+*/
+XN_C_API XnStatus XN_C_DECL xnUSBSimulatorOpenEndPoint(const XnUSBSimulatedEndPointConfig* pConfig, XN_USB_EP_HANDLE* pEPHandlePtr);
+
+/**
+* Connects a simulated device. From then on it is enumerated, and opened, like a real device is (see 
+* @ref xnUSBEnumerateDevices, @ref xnUSBOpenDeviceByPath and @ref xnUSBOpenDevice), until it is disconnected.
+*
+* @param	pConfig			[in]	Describes the device. The endpoint configurations are copied.
+* @param	strDevicePath	[out]	The path of the connected device.
+*/
+XN_C_API XnStatus XN_C_DECL xnUSBSimulatorConnectDevice(const XnUSBSimulatedDeviceConfig* pConfig, XnUSBConnectionString strDevicePath);
+
+/**
+* Disconnects a simulated device, as if it was unplugged. Queued transfers return, and everything else fails, 
+* as they would with a real device. Handles that are still open must still be closed.
+*
+* @param	strDevicePath	[in]	The path the device was connected with.
+*/
+XN_C_API XnStatus XN_C_DECL xnUSBSimulatorDisconnectDevice(const XnUSBConnectionString strDevicePath);
+
+/**
+* Gets the statistics of a simulated endpoint. The read thread of the endpoint keeps its own 
+* (see @ref xnUSBGetEndPointStatistics).
+*
+* @param	pEPHandle		[in]	An endpoint of a simulated device, or one opened with @ref xnUSBSimulatorOpenEndPoint.
+* @param	pStatistics		[out]	The statistics.
+*/
+XN_C_API XnStatus XN_C_DECL xnUSBSimulatorGetEndPointStatistics(XN_USB_EP_HANDLE pEPHandle, XnUSBSimulatedEndPointStatistics* pStatistics);
+
+#endif //_XN_USB_SIMULATOR_H_
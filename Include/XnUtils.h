@@ -118,6 +118,113 @@ XN_C_API XnUInt32 XN_C_DECL xnGetBytesPerPixelForPixelFormat(XnPixelFormat forma
 
 /// @}
 
+/**
+ * @name Pixel Conversion Utilities
+ * These functions use the best SIMD instruction set available on the running CPU, and produce the
+ * same output regardless of which one was picked.
+ * @{
+ */
+
+/**
+ * Converts YUV422 (UYVY) pixels to RGB24, using integer BT.601 coefficients.
+ *
+ * @param	pSrc	[in]	Source buffer, 2 bytes per pixel.
+ * @param	pDst	[out]	Destination buffer, 3 bytes per pixel.
+ * @param	nPixels	[in]	Number of pixels to convert.
+ */
+XN_C_API XnStatus XN_C_DECL xnConvertYUV422ToRGB24(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels);
+
+/**
+ * Converts YUV422 (UYVY) pixels to RGBA32 (with an alpha of 255), using integer BT.601 coefficients.
+ *
+ * @param	pSrc	[in]	Source buffer, 2 bytes per pixel.
+ * @param	pDst	[out]	Destination buffer, 4 bytes per pixel.
+ * @param	nPixels	[in]	Number of pixels to convert.
+ */
+XN_C_API XnStatus XN_C_DECL xnConvertYUV422ToRGBA32(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels);
+
+/**
+ * Converts YUV422 (UYVY) pixels to 8-bit grayscale, by expanding the luma to full range.
+ *
+ * @param	pSrc	[in]	Source buffer, 2 bytes per pixel.
+ * @param	pDst	[out]	Destination buffer, 1 byte per pixel.
+ * @param	nPixels	[in]	Number of pixels to convert.
+ */
+XN_C_API XnStatus XN_C_DECL xnConvertYUV422ToGray8(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels);
+
+/**
+ * Finds the smallest and largest values in a 16-bit grayscale buffer.
+ *
+ * @param	pSrc	[in]	Source buffer.
+ * @param	nPixels	[in]	Number of pixels in the buffer.
+ * @param	pnMin	[out]	Smallest value found.
+ * @param	pnMax	[out]	Largest value found.
+ */
+XN_C_API XnStatus XN_C_DECL xnGetGray16Range(const XnUInt16* pSrc, XnUInt32 nPixels, XnUInt16* pnMin, XnUInt16* pnMax);
+
+/**
+ * Converts 16-bit grayscale pixels to 8-bit ones, linearly mapping the window [nMin, nMax] to
+ * [0, 255]. Values outside the window are clamped.
+ *
+ * @param	pSrc	[in]	Source buffer.
+ * @param	pDst	[out]	Destination buffer.
+ * @param	nPixels	[in]	Number of pixels to convert.
+ * @param	nMin	[in]	Value mapped to 0.
+ * @param	nMax	[in]	Value mapped to 255.
+ */
+XN_C_API XnStatus XN_C_DECL xnConvertGray16ToGray8(const XnUInt16* pSrc, XnUInt8* pDst, XnUInt32 nPixels, XnUInt16 nMin, XnUInt16 nMax);
+
+/**
+ * Calculates the cumulative depth histogram of a depth map. For every depth value, the histogram
+ * holds the fraction of valid pixels that are farther than it, so that close objects get values
+ * near 1. Entry 0 (no sample) is always 0. Depth values outside the histogram are ignored.
+ *
+ * @param	pDepth			[in]	Depth map.
+ * @param	nPixels			[in]	Number of pixels in the depth map.
+ * @param	pHistogram		[out]	Histogram to fill.
+ * @param	nHistogramSize	[in]	Number of entries in the histogram, usually max depth + 1.
+ */
+XN_C_API XnStatus XN_C_DECL xnCalculateDepthHistogram(const XnDepthPixel* pDepth, XnUInt32 nPixels, XnFloat* pHistogram, XnUInt32 nHistogramSize);
+
+/**
+ * Colors a depth map by a histogram calculated using @ref xnCalculateDepthHistogram(). Each pixel
+ * gets the given color, scaled by the histogram value of its depth.
+ *
+ * @param	pDepth			[in]	Depth map.
+ * @param	nPixels			[in]	Number of pixels in the depth map.
+ * @param	pHistogram		[in]	Depth histogram.
+ * @param	nHistogramSize	[in]	Number of entries in the histogram.
+ * @param	color			[in]	Color of the closest pixels.
+ * @param	pDst			[out]	Destination buffer, 3 bytes per pixel.
+ */
+XN_C_API XnStatus XN_C_DECL xnColorizeDepthToRGB24(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8* pDst);
+
+/**
+ * Colors a depth map by a histogram calculated using @ref xnCalculateDepthHistogram(). Each pixel
+ * gets the given color, scaled by the histogram value of its depth. Pixels with no depth get an
+ * alpha of 0, all others get nAlpha.
+ *
+ * @param	pDepth			[in]	Depth map.
+ * @param	nPixels			[in]	Number of pixels in the depth map.
+ * @param	pHistogram		[in]	Depth histogram.
+ * @param	nHistogramSize	[in]	Number of entries in the histogram.
+ * @param	color			[in]	Color of the closest pixels.
+ * @param	nAlpha			[in]	Alpha of pixels with depth.
+ * @param	pDst			[out]	Destination buffer, 4 bytes per pixel.
+ */
+XN_C_API XnStatus XN_C_DECL xnColorizeDepthToRGBA32(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8 nAlpha, XnUInt8* pDst);
+
+/**
+ * Limits the instruction set the functions above may use, replacing the limit of the
+ * XN_PIXEL_CONVERSION_SIMD environment variable. Meant for testing and benchmarking the
+ * different implementations against each other - applications should not need it.
+ *
+ * @param	strLimit	[in]	"none" for scalar code only, "sse2", or NULL for the best available.
+ */
+XN_C_API XnStatus XN_C_DECL xnSetPixelConversionSIMDLimit(const XnChar* strLimit);
+
+/// @}
+
 /**
  * @name Resolution Utilities
  * @{
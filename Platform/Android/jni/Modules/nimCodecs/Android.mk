@@ -11,6 +11,7 @@ MY_PREFIX := $(LOCAL_PATH)/../../../../../Source/
 # list all source files
 MY_SRC_FILES := \
 	$(MY_PREFIX)Modules/nimCodecs/*.cpp \
+	$(MY_PREFIX)Modules/Common/XnLosslessCompression.cpp \
 	$(MY_PREFIX)../Externals/LibJPEG/*.c
 
 # expand the wildcards
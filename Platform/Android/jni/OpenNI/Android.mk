@@ -12,6 +12,8 @@ MY_PREFIX := $(LOCAL_PATH)/../../../../Source/OpenNI/
 MY_SRC_FILES := \
 	$(MY_PREFIX)*.cpp \
 	$(MY_PREFIX)Linux/*.cpp \
+	$(MY_PREFIX)../Modules/Common/DataRecords.cpp \
+	$(MY_PREFIX)../Modules/Common/XnLosslessCompression.cpp \
 	$(MY_PREFIX)../../Externals/TinyXml/*.cpp
 
 # expand the wildcards
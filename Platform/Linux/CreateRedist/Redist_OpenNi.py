@@ -312,6 +312,7 @@ shutil.copy("Bin/" + PLATFORM + "-Release/libOpenNI.jni"+LIBS_TYPE, REDIST_DIR +
 MonoDetected = 0
 shutil.copy("Bin/" + PLATFORM + "-Release/niReg", REDIST_DIR + "/Bin")
 shutil.copy("Bin/" + PLATFORM + "-Release/niLicense", REDIST_DIR + "/Bin")
+shutil.copy("Bin/" + PLATFORM + "-Release/niOniEdit", REDIST_DIR + "/Bin")
 if PLATFORM == 'x86' or PLATFORM == 'x64':
     if (os.path.exists("/usr/bin/gmcs")):
         shutil.copy("Bin/" + PLATFORM + "-Release/OpenNI.net.dll", REDIST_DIR + "/Bin")
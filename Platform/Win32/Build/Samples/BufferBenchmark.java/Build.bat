@@ -0,0 +1 @@
+@%0\..\..\..\BuildJava.py "%1" "%0\.." ..\..\..\..\..\Samples\BufferBenchmark.java\org\openni\Samples\BufferBenchmark org.openni.Samples.BufferBenchmark org.openni.jar org.openni.Samples.BufferBenchmark.BufferBenchmark
@@ -143,6 +143,7 @@ class RedistOpenNI(redist_base.RedistBase):
         os.system ("copy " + self.bin_dir + "\\Release\\nimRecorder*.dll Redist\\" + self.bin_dir)
         os.system ("copy " + self.bin_dir + "\\Release\\niReg*.exe Redist\\" + self.bin_dir)
         os.system ("copy " + self.bin_dir + "\\Release\\niLicense*.exe Redist\\" + self.bin_dir)
+        os.system ("copy " + self.bin_dir + "\\Release\\niOniEdit*.exe Redist\\" + self.bin_dir)
         os.system ("copy " + self.bin_dir + "\\Release\\OpenNI.jni.dll Redist\\" + self.bin_dir)
         os.system ("copy " + self.bin_dir + "\\Release\\org.openni.jar Redist\\" + self.bin_dir)
 
@@ -0,0 +1,196 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+package org.openni.Samples.BufferBenchmark;
+
+import java.lang.management.GarbageCollectorMXBean;
+import java.lang.management.ManagementFactory;
+import java.nio.ByteBuffer;
+
+import org.openni.*;
+
+/**
+ * Compares the cost of getting frame data into Java: a freshly allocated copy per frame,
+ * a copy into a pooled buffer, a zero-copy view of the current frame, and a leased frame.
+ * 
+ * Usage: BufferBenchmark <recording.oni> [frames]
+ */
+public class BufferBenchmark
+{
+	private static final int WARMUP_FRAMES = 100;
+	private static final int READ_STRIDE = 4096;
+	
+	private interface Variant
+	{
+		String getName();
+		long run(Generator generator) throws StatusException;
+	}
+	
+	public static void main(String[] args)
+	{
+		if (args.length < 1)
+		{
+			System.out.println("Usage: BufferBenchmark <recording.oni> [frames]");
+			System.exit(1);
+		}
+		
+		int frames = (args.length > 1) ? Integer.parseInt(args[1]) : 1000;
+		
+		try
+		{
+			Context context = new Context();
+			Player player = context.openFileRecordingEx(args[0]);
+			player.setRepeat(true);
+			
+			Generator generator = findGenerator(context);
+			System.out.printf("Reading %d frames of %d bytes from '%s'\n", frames, generator.getDataSize(), generator.getName());
+			
+			final ByteBufferPool pool = new ByteBufferPool(4);
+			
+			Variant[] variants = new Variant[] 
+			{
+				new Variant()
+				{
+					public String getName() { return "copy"; }
+					public long run(Generator generator)
+					{
+						return consume(generator.createDataByteBuffer());
+					}
+				},
+				new Variant()
+				{
+					public String getName() { return "pooled copy"; }
+					public long run(Generator generator)
+					{
+						ByteBuffer buffer = generator.createDataByteBuffer(pool);
+						long sum = consume(buffer);
+						pool.release(buffer);
+						return sum;
+					}
+				},
+				new Variant()
+				{
+					public String getName() { return "zero-copy"; }
+					public long run(Generator generator)
+					{
+						return consume(generator.wrapDataByteBuffer());
+					}
+				},
+				new Variant()
+				{
+					public String getName() { return "lease"; }
+					public long run(Generator generator) throws StatusException
+					{
+						FrameLease lease = generator.acquireFrame();
+						long sum = consume(lease.getData());
+						lease.release();
+						return sum;
+					}
+				},
+			};
+			
+			System.out.printf("%-12s %12s %12s %12s\n", "variant", "us/frame", "MB/s", "GC runs");
+			
+			for (Variant variant : variants)
+			{
+				if (variant.getName().equals("lease") && !generator.isCapabilitySupported(Capability.FrameLease.getName()))
+				{
+					System.out.printf("%-12s %12s\n", variant.getName(), "unsupported");
+					continue;
+				}
+				
+				runVariant(context, generator, variant, frames);
+			}
+			
+			context.release();
+		}
+		catch (Throwable e)
+		{
+			e.printStackTrace();
+			System.exit(1);
+		}
+	}
+	
+	private static Generator findGenerator(Context context) throws GeneralException
+	{
+		try
+		{
+			return (Generator)context.findExistingNode(NodeType.DEPTH);
+		}
+		catch (StatusException e)
+		{
+			return (Generator)context.findExistingNode(NodeType.IMAGE);
+		}
+	}
+	
+	private static void runVariant(Context context, Generator generator, Variant variant, int frames) throws StatusException
+	{
+		long checksum = 0;
+		
+		for (int i = 0; i < WARMUP_FRAMES; ++i)
+		{
+			context.waitOneUpdateAll(generator);
+			checksum += variant.run(generator);
+		}
+		
+		long gcBefore = getCollectionCount();
+		long totalNanos = 0;
+		long totalBytes = 0;
+		
+		for (int i = 0; i < frames; ++i)
+		{
+			context.waitOneUpdateAll(generator);
+			
+			// only time getting the data, not reading the recording
+			long start = System.nanoTime();
+			checksum += variant.run(generator);
+			totalNanos += System.nanoTime() - start;
+			totalBytes += generator.getDataSize();
+		}
+		
+		long gcRuns = getCollectionCount() - gcBefore;
+		
+		double usPerFrame = totalNanos / 1000.0 / frames;
+		double mbPerSec = (totalBytes / (1024.0 * 1024.0)) / (totalNanos / 1e9);
+		
+		// print the checksum so the reads can't be optimized away
+		System.out.printf("%-12s %12.2f %12.1f %12d   (checksum %d)\n", variant.getName(), usPerFrame, mbPerSec, gcRuns, checksum);
+	}
+	
+	private static long consume(ByteBuffer buffer)
+	{
+		long sum = 0;
+		for (int i = 0; i < buffer.limit(); i += READ_STRIDE)
+		{
+			sum += buffer.get(i);
+		}
+		return sum;
+	}
+	
+	private static long getCollectionCount()
+	{
+		long count = 0;
+		for (GarbageCollectorMXBean gc : ManagementFactory.getGarbageCollectorMXBeans())
+		{
+			count += Math.max(0, gc.getCollectionCount());
+		}
+		return count;
+	}
+}
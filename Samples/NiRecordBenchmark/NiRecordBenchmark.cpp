@@ -0,0 +1,193 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOpenNI.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define BENCHMARK_X_RES				640
+#define BENCHMARK_Y_RES				480
+#define BENCHMARK_FPS				30
+#define BENCHMARK_DEFAULT_MB		512
+#define BENCHMARK_SEGMENT_BYTES		(128 * 1024 * 1024)
+
+//---------------------------------------------------------------------------
+// Macros
+//---------------------------------------------------------------------------
+#define CHECK_RC(rc, what)											\
+	if (rc != XN_STATUS_OK)											\
+	{																\
+		printf("%s failed: %s\n", what, xnGetStatusString(rc));		\
+		return rc;													\
+	}
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+
+using namespace xn;
+
+XnStatus createMockDepth(Context& context, MockDepthGenerator& mockDepth)
+{
+	XnStatus nRetVal = mockDepth.Create(context, "BenchmarkDepth");
+	CHECK_RC(nRetVal, "Create mock depth node");
+
+	// the recorder needs the node to look like a real depth generator
+	XnMapOutputMode mode = { BENCHMARK_X_RES, BENCHMARK_Y_RES, BENCHMARK_FPS };
+	nRetVal = mockDepth.SetMapOutputMode(mode);
+	CHECK_RC(nRetVal, "Set output mode");
+	mockDepth.SetIntProperty(XN_CAPABILITY_MIRROR, FALSE);
+	mockDepth.SetIntProperty(XN_CAPABILITY_FRAME_SYNC, FALSE);
+	mockDepth.SetIntProperty(XN_CAPABILITY_EXTENDED_SERIALIZATION, FALSE);
+	mockDepth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1);
+	mockDepth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode);
+	mockDepth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000);
+	nRetVal = mockDepth.SetIntProperty(XN_PROP_STATE_READY, TRUE);
+	CHECK_RC(nRetVal, "Set mock node state");
+
+	return XN_STATUS_OK;
+}
+
+void deleteRecording(const XnChar* strFileName, const XnChar* strStem)
+{
+	xnOSDeleteFile(strFileName);
+
+	// and its segments, if any
+	for (XnUInt32 i = 0; ; ++i)
+	{
+		XnChar strSegment[XN_FILE_MAX_PATH];
+		XnUInt32 nCharsWritten = 0;
+		xnOSStrFormat(strSegment, sizeof(strSegment), &nCharsWritten, "%s-%05u.oni", strStem, i);
+		if (xnOSDeleteFile(strSegment) != XN_STATUS_OK)
+		{
+			break;
+		}
+	}
+}
+
+XnStatus runBenchmark(const XnChar* strName, const XnChar* strDir, XnUInt32 nMegabytes, const XnRecorderFileOptions& options)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnChar strStem[XN_FILE_MAX_PATH];
+	XnChar strFileName[XN_FILE_MAX_PATH];
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(strStem, sizeof(strStem), &nCharsWritten, "%s%sNiRecordBenchmark-%s", strDir, XN_FILE_DIR_SEP, strName);
+	xnOSStrFormat(strFileName, sizeof(strFileName), &nCharsWritten, "%s.oni", strStem);
+
+	Context context;
+	nRetVal = context.Init();
+	CHECK_RC(nRetVal, "Init");
+
+	MockDepthGenerator mockDepth;
+	nRetVal = createMockDepth(context, mockDepth);
+	XN_IS_STATUS_OK(nRetVal);
+
+	Recorder recorder;
+	nRetVal = recorder.Create(context);
+	CHECK_RC(nRetVal, "Create recorder");
+
+	nRetVal = recorder.SetFileOptions(options);
+	CHECK_RC(nRetVal, "Set recorder file options");
+
+	nRetVal = recorder.SetDestination(XN_RECORD_MEDIUM_FILE, strFileName);
+	CHECK_RC(nRetVal, "Set recorder destination file");
+
+	// uncompressed, so that we measure the disk and not the codec
+	nRetVal = recorder.AddNodeToRecording(mockDepth, XN_CODEC_UNCOMPRESSED);
+	CHECK_RC(nRetVal, "Add node to recording");
+
+	const XnUInt32 nFrameSize = BENCHMARK_X_RES * BENCHMARK_Y_RES * sizeof(XnDepthPixel);
+	const XnUInt32 nFrames = (XnUInt32)(((XnUInt64)nMegabytes * 1024 * 1024 + nFrameSize - 1) / nFrameSize);
+
+	XnDepthPixel* pFrame = (XnDepthPixel*)xnOSMalloc(nFrameSize);
+	XN_VALIDATE_ALLOC_PTR(pFrame);
+	for (XnUInt32 i = 0; i < BENCHMARK_X_RES * BENCHMARK_Y_RES; ++i)
+	{
+		pFrame[i] = (XnDepthPixel)(i % 10000);
+	}
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	for (XnUInt32 i = 1; i <= nFrames; ++i)
+	{
+		pFrame[0] = (XnDepthPixel)i;
+		nRetVal = mockDepth.SetData(i, (XnUInt64)i * 1000000 / BENCHMARK_FPS, nFrameSize, pFrame);
+		CHECK_RC(nRetVal, "Set mock node new data");
+
+		nRetVal = recorder.Record();
+		CHECK_RC(nRetVal, "Record");
+	}
+
+	// closing the recording writes whatever is left, so it is part of the measurement
+	recorder.Release();
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	XnDouble dSeconds = (nEnd - nStart) / 1e6;
+	XnDouble dMegabytes = (XnDouble)nFrames * nFrameSize / (1024 * 1024);
+	printf("%-10s %6u frames %9.1f MB %8.2f s %9.1f MB/s\n", strName, nFrames, dMegabytes, dSeconds, dMegabytes / dSeconds);
+
+	xnOSFree(pFrame);
+	mockDepth.Release();
+	context.Release();
+
+	deleteRecording(strFileName, strStem);
+
+	return XN_STATUS_OK;
+}
+
+int main(int argc, char* argv[])
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (argc < 2)
+	{
+		printf("usage: %s <outputDir> [MB to record, default %u]\n", argv[0], BENCHMARK_DEFAULT_MB);
+		return -1;
+	}
+
+	const XnChar* strDir = argv[1];
+	XnUInt32 nMegabytes = (argc > 2) ? (XnUInt32)atoi(argv[2]) : BENCHMARK_DEFAULT_MB;
+
+	XnRecorderFileOptions options;
+	xnOSMemSet(&options, 0, sizeof(options));
+
+	nRetVal = runBenchmark("cached", strDir, nMegabytes, options);
+	XN_IS_STATUS_OK(nRetVal);
+
+	options.bDirectIO = TRUE;
+	nRetVal = runBenchmark("direct", strDir, nMegabytes, options);
+	XN_IS_STATUS_OK(nRetVal);
+
+	options.nSegmentBytes = BENCHMARK_SEGMENT_BYTES;
+	nRetVal = runBenchmark("segmented", strDir, nMegabytes, options);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return 0;
+}
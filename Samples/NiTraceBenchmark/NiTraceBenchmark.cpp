@@ -0,0 +1,179 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOpenNI.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnTrace.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define BENCHMARK_X_RES				640
+#define BENCHMARK_Y_RES				480
+#define BENCHMARK_FPS				30
+#define BENCHMARK_DEFAULT_FRAMES	3000
+#define BENCHMARK_EVENTS			(10 * 1000 * 1000)
+// runs are interleaved, so that both modes see the same machine load, and the fastest run of each mode is kept
+#define BENCHMARK_ROUNDS			10
+
+//---------------------------------------------------------------------------
+// Macros
+//---------------------------------------------------------------------------
+#define CHECK_RC(rc, what)											\
+	if (rc != XN_STATUS_OK)											\
+	{																\
+		printf("%s failed: %s\n", what, xnGetStatusString(rc));		\
+		return rc;													\
+	}
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+
+using namespace xn;
+
+// keeps the compiler from dropping the reads of the data
+volatile XnUInt32 g_nChecksum = 0;
+
+/** Measures the cost of a single event, in nanoseconds. **/
+XnDouble measureEvent(XnBool bActive)
+{
+	if (bActive)
+	{
+		xnTraceStart(0);
+	}
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	for (XnUInt32 i = 0; i < BENCHMARK_EVENTS; ++i)
+	{
+		XN_TRACE_INSTANT(XN_TRACE_USB_TRANSFER, "Benchmark", 0, i, 0);
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	xnTraceStop();
+
+	return (nEnd - nStart) * 1000.0 / BENCHMARK_EVENTS;
+}
+
+/** Pushes frames through a depth node and reads them, the way an application does. Returns the time it took, in seconds. **/
+XnStatus measurePipeline(Context& context, MockDepthGenerator& mockDepth, XnDepthPixel* pFrame, XnUInt32 nFrames, XnBool bTrace, XnDouble& dSeconds)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	const XnUInt32 nFrameSize = BENCHMARK_X_RES * BENCHMARK_Y_RES * sizeof(XnDepthPixel);
+	XnUInt32 nChecksum = 0;
+
+	if (bTrace)
+	{
+		nRetVal = xnTraceStart(0);
+		CHECK_RC(nRetVal, "Start tracing");
+	}
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	for (XnUInt32 i = 1; i <= nFrames; ++i)
+	{
+		pFrame[0] = (XnDepthPixel)i;
+		nRetVal = mockDepth.SetData(i, (XnUInt64)i * 1000000 / BENCHMARK_FPS, nFrameSize, pFrame);
+		CHECK_RC(nRetVal, "Set mock node new data");
+
+		nRetVal = context.WaitNoneUpdateAll();
+		CHECK_RC(nRetVal, "Update");
+
+		// touch the data, like any consumer would
+		const XnDepthPixel* pDepth = mockDepth.GetDepthMap();
+		for (XnUInt32 j = 0; j < BENCHMARK_X_RES * BENCHMARK_Y_RES; j += 64)
+		{
+			nChecksum += pDepth[j];
+		}
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	xnTraceStop();
+
+	g_nChecksum = nChecksum;
+	dSeconds = (nEnd - nStart) / 1e6;
+
+	return (XN_STATUS_OK);
+}
+
+int main(int argc, char* argv[])
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt32 nFrames = (argc > 1) ? (XnUInt32)atoi(argv[1]) : BENCHMARK_DEFAULT_FRAMES;
+
+	printf("Event cost:  %6.1f ns (tracing stopped)  %6.1f ns (tracing)\n", measureEvent(FALSE), measureEvent(TRUE));
+
+	Context context;
+	nRetVal = context.Init();
+	CHECK_RC(nRetVal, "Init");
+
+	MockDepthGenerator mockDepth;
+	nRetVal = mockDepth.Create(context, "BenchmarkDepth");
+	CHECK_RC(nRetVal, "Create mock depth node");
+
+	XnMapOutputMode mode = { BENCHMARK_X_RES, BENCHMARK_Y_RES, BENCHMARK_FPS };
+	nRetVal = mockDepth.SetMapOutputMode(mode);
+	CHECK_RC(nRetVal, "Set output mode");
+
+	XnDepthPixel* pFrame = (XnDepthPixel*)xnOSMalloc(BENCHMARK_X_RES * BENCHMARK_Y_RES * sizeof(XnDepthPixel));
+	XN_VALIDATE_ALLOC_PTR(pFrame);
+	for (XnUInt32 i = 0; i < BENCHMARK_X_RES * BENCHMARK_Y_RES; ++i)
+	{
+		pFrame[i] = (XnDepthPixel)(i % 10000);
+	}
+
+	XnDouble dPlain = 1e9;
+	XnDouble dTraced = 1e9;
+	for (XnUInt32 nRound = 0; nRound < BENCHMARK_ROUNDS; ++nRound)
+	{
+		XnDouble dSeconds = 0;
+		nRetVal = measurePipeline(context, mockDepth, pFrame, nFrames, FALSE, dSeconds);
+		XN_IS_STATUS_OK(nRetVal);
+		dPlain = XN_MIN(dPlain, dSeconds);
+
+		nRetVal = measurePipeline(context, mockDepth, pFrame, nFrames, TRUE, dSeconds);
+		XN_IS_STATUS_OK(nRetVal);
+		dTraced = XN_MIN(dTraced, dSeconds);
+	}
+
+	// frames here cost far less than the time between two frames of a real device, so this is an upper bound
+	printf("Frame cost:  %6.1f us (tracing stopped)  %6.1f us (tracing)\n", dPlain * 1e6 / nFrames, dTraced * 1e6 / nFrames);
+	printf("Overhead:    %6.2f%% (%.3f%% of a %u FPS frame period)\n", (dTraced - dPlain) * 100 / dPlain, 
+		(dTraced - dPlain) * 100 / nFrames * BENCHMARK_FPS, BENCHMARK_FPS);
+
+	xnOSFree(pFrame);
+	mockDepth.Release();
+	context.Release();
+
+	return 0;
+}
@@ -104,6 +104,10 @@ void captureInit()
 	g_DepthFormat.pIndexToName[nIndex] = "PS Compression (16z ET)";
 	nIndex++;
 
+	g_DepthFormat.pValues[nIndex] = XN_CODEC_16Z_ANS;
+	g_DepthFormat.pIndexToName[nIndex] = "Entropy Coded (16z ANS)";
+	nIndex++;
+
 	g_DepthFormat.pValues[nIndex] = XN_CODEC_UNCOMPRESSED;
 	g_DepthFormat.pIndexToName[nIndex] = "Uncompressed";
 	nIndex++;
@@ -125,6 +129,10 @@ void captureInit()
 	g_ImageFormat.pIndexToName[nIndex] = "JPEG";
 	nIndex++;
 
+	g_ImageFormat.pValues[nIndex] = XN_CODEC_IMAGE_LOSSLESS;
+	g_ImageFormat.pIndexToName[nIndex] = "Lossless";
+	nIndex++;
+
 	g_ImageFormat.pValues[nIndex] = XN_CODEC_UNCOMPRESSED;
 	g_ImageFormat.pIndexToName[nIndex] = "Uncompressed";
 	nIndex++;
@@ -159,6 +167,10 @@ void captureInit()
 	g_AudioFormat.pIndexToName[nIndex] = "Auto-Choose";
 	nIndex++;
 
+	g_AudioFormat.pValues[nIndex] = XN_CODEC_AUDIO_LOSSLESS;
+	g_AudioFormat.pIndexToName[nIndex] = "Lossless";
+	nIndex++;
+
 	g_AudioFormat.pValues[nIndex] = XN_CODEC_UNCOMPRESSED;
 	g_AudioFormat.pIndexToName[nIndex] = "Uncompressed";
 	nIndex++;
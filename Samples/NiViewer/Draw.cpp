@@ -35,28 +35,6 @@
 #include "Statistics.h"
 #include "MouseInput.h"
 
-#if (XN_PLATFORM == XN_PLATFORM_WIN32)
-	#ifdef __INTEL_COMPILER
-		#include <ia32intrin.h>
-	#else
-		#include <intrin.h>
-	#endif
-#endif
-
-// --------------------------------
-// Defines
-// --------------------------------
-#define YUV422_U  0
-#define YUV422_Y1 1
-#define YUV422_V  2
-#define YUV422_Y2 3
-#define YUV422_BPP 4
-#define YUV_RED   0
-#define YUV_GREEN 1
-#define YUV_BLUE  2
-#define YUV_ALPHA  3
-#define YUV_RGBA_BPP 4
-
 // --------------------------------
 // Types
 // --------------------------------
@@ -101,6 +79,10 @@ XnUInt8 PalletIntsB [256] = {0};
 unsigned short g_nMaxGrayscale16Value = 0;
 /* Linear Depth Histogram */
 float* g_pDepthHist;
+XnUInt32 g_nDepthHistSize = 0;
+/* One line of a 16-bit grayscale image, scaled down to 8 bits */
+XnUInt8* g_pGrayscale8Line = NULL;
+XnUInt32 g_nGrayscale8LineSize = 0;
 
 const char* g_DepthColoring[NUM_OF_DEPTH_TYPES];
 const char* g_ImageColoring[NUM_OF_IMAGE_TYPES];
@@ -556,198 +538,15 @@ void calculateHistogram()
 	if (g_pDepthHist == NULL)
 	{
 		g_pDepthHist = new float[nZRes];
+		g_nDepthHistSize = nZRes;
 	}
 
-	xnOSMemSet(g_pDepthHist, 0, nZRes*sizeof(float));
-	int nNumberOfPoints = 0;
-
-	XnDepthPixel nValue;
-
-	const XnDepthPixel* pDepth = pDepthGen->GetDepthMap();
-	const XnDepthPixel* pDepthEnd = pDepth + (pDepthGen->GetDataSize() / sizeof(XnDepthPixel));
-
-	while (pDepth != pDepthEnd)
-	{
-		nValue = *pDepth;
-
-		XN_ASSERT(nValue <= nZRes);
-
-		if (nValue != 0)
-		{
-			g_pDepthHist[nValue]++;
-			nNumberOfPoints++;
-		}
-
-		pDepth++;
-	}
-
-	XnUInt32 nIndex;
-	for (nIndex = 1; nIndex < nZRes; nIndex++)
-	{
-		g_pDepthHist[nIndex] += g_pDepthHist[nIndex-1];
-	}
-	for (nIndex = 1; nIndex < nZRes; nIndex++)
-	{
-		if (g_pDepthHist[nIndex] != 0)
-		{
-			g_pDepthHist[nIndex] = (nNumberOfPoints-g_pDepthHist[nIndex]) / nNumberOfPoints;
-		}
-	}
+	xnCalculateDepthHistogram(pDepthGen->GetDepthMap(), pDepthGen->GetDataSize() / sizeof(XnDepthPixel), g_pDepthHist, g_nDepthHistSize);
 }
 
 // --------------------------------
 // Drawing
 // --------------------------------
-#if (XN_PLATFORM == XN_PLATFORM_WIN32)
-
-void YUV422ToRGB888(const XnUInt8* pYUVImage, XnUInt8* pRGBAImage, XnUInt32 nYUVSize, XnUInt32 nRGBSize)
-{
-	const XnUInt8* pYUVLast = pYUVImage + nYUVSize - 8;
-	XnUInt8* pRGBLast = pRGBAImage + nRGBSize - 16;
-
-	const __m128 minus128 = _mm_set_ps1(-128);
-	const __m128 plus113983 = _mm_set_ps1(1.13983F);
-	const __m128 minus039466 = _mm_set_ps1(-0.39466F);
-	const __m128 minus058060 = _mm_set_ps1(-0.58060F);
-	const __m128 plus203211 = _mm_set_ps1(2.03211F);
-	const __m128 zero = _mm_set_ps1(0);
-	const __m128 plus255 = _mm_set_ps1(255);
-
-	// define YUV floats
-	__m128 y;
-	__m128 u;
-	__m128 v;
-
-	__m128 temp;
-
-	// define RGB floats
-	__m128 r;
-	__m128 g;
-	__m128 b;
-
-	// define RGB integers
-	__m128i iR;
-	__m128i iG;
-	__m128i iB;
-
-	XnUInt32* piR = (XnUInt32*)&iR;
-	XnUInt32* piG = (XnUInt32*)&iG;
-	XnUInt32* piB = (XnUInt32*)&iB;
-
-	while (pYUVImage <= pYUVLast && pRGBAImage <= pRGBLast)
-	{
-		// process 4 pixels at once (values should be ordered backwards)
-		y = _mm_set_ps(pYUVImage[YUV422_Y2 + YUV422_BPP], pYUVImage[YUV422_Y1 + YUV422_BPP], pYUVImage[YUV422_Y2], pYUVImage[YUV422_Y1]);
-		u = _mm_set_ps(pYUVImage[YUV422_U + YUV422_BPP],  pYUVImage[YUV422_U + YUV422_BPP],  pYUVImage[YUV422_U],  pYUVImage[YUV422_U]);
-		v = _mm_set_ps(pYUVImage[YUV422_V + YUV422_BPP],  pYUVImage[YUV422_V + YUV422_BPP],  pYUVImage[YUV422_V],  pYUVImage[YUV422_V]);
-
-		u = _mm_add_ps(u, minus128); // u -= 128
-		v = _mm_add_ps(v, minus128); // v -= 128
-
-		/*
-
-		http://en.wikipedia.org/wiki/YUV
-
-		From YUV to RGB:
-		R =     Y + 1.13983 V
-		G =     Y - 0.39466 U - 0.58060 V
-		B =     Y + 2.03211 U
-
-		*/ 
-
-		temp = _mm_mul_ps(plus113983, v);
-		r = _mm_add_ps(y, temp);
-
-		temp = _mm_mul_ps(minus039466, u);
-		g = _mm_add_ps(y, temp);
-		temp = _mm_mul_ps(minus058060, v);
-		g = _mm_add_ps(g, temp);
-
-		temp = _mm_mul_ps(plus203211, u);
-		b = _mm_add_ps(y, temp);
-
-		// make sure no value is smaller than 0
-		r = _mm_max_ps(r, zero);
-		g = _mm_max_ps(g, zero);
-		b = _mm_max_ps(b, zero);
-
-		// make sure no value is bigger than 255
-		r = _mm_min_ps(r, plus255);
-		g = _mm_min_ps(g, plus255);
-		b = _mm_min_ps(b, plus255);
-
-		// convert floats to int16 (there is no conversion to uint8, just to int8).
-		iR = _mm_cvtps_epi32(r);
-		iG = _mm_cvtps_epi32(g);
-		iB = _mm_cvtps_epi32(b);
-
-		// extract the 4 pixels RGB values.
-		// because we made sure values are between 0 and 255, we can just take the lower byte
-		// of each INT16
-		pRGBAImage[0] = piR[0];
-		pRGBAImage[1] = piG[0];
-		pRGBAImage[2] = piB[0];
-		pRGBAImage[3] = 255;
-
-		pRGBAImage[4] = piR[1];
-		pRGBAImage[5] = piG[1];
-		pRGBAImage[6] = piB[1];
-		pRGBAImage[7] = 255;
-
-		pRGBAImage[8] = piR[2];
-		pRGBAImage[9] = piG[2];
-		pRGBAImage[10] = piB[2];
-		pRGBAImage[11] = 255;
-
-		pRGBAImage[12] = piR[3];
-		pRGBAImage[13] = piG[3];
-		pRGBAImage[14] = piB[3];
-		pRGBAImage[15] = 255;
-
-		// advance the streams
-		pYUVImage += 8;
-		pRGBAImage += 16;
-	}
-}
-
-#else // not Win32
-
-void YUV444ToRGBA(XnUInt8 cY, XnUInt8 cU, XnUInt8 cV,
-					XnUInt8& cR, XnUInt8& cG, XnUInt8& cB, XnUInt8& cA)
-{
-	XnInt32 nC = cY - 16;
-	XnInt16 nD = cU - 128;
-	XnInt16 nE = cV - 128;
-
-	nC = nC * 298 + 128;
-
-	cR = XN_MIN(XN_MAX((nC            + 409 * nE) >> 8, 0), 255);
-	cG = XN_MIN(XN_MAX((nC - 100 * nD - 208 * nE) >> 8, 0), 255);
-	cB = XN_MIN(XN_MAX((nC + 516 * nD           ) >> 8, 0), 255);
-	cA = 255;
-}
-
-void YUV422ToRGB888(const XnUInt8* pYUVImage, XnUInt8* pRGBImage, XnUInt32 nYUVSize, XnUInt32 nRGBSize)
-{
-	const XnUInt8* pCurrYUV = pYUVImage;
-	XnUInt8* pCurrRGB = pRGBImage;
-	const XnUInt8* pLastYUV = pYUVImage + nYUVSize - YUV422_BPP;
-	XnUInt8* pLastRGB = pRGBImage + nRGBSize - YUV_RGBA_BPP;
-
-	while (pCurrYUV <= pLastYUV && pCurrRGB <= pLastRGB)
-	{
-		YUV444ToRGBA(pCurrYUV[YUV422_Y1], pCurrYUV[YUV422_U], pCurrYUV[YUV422_V],
-						pCurrRGB[YUV_RED], pCurrRGB[YUV_GREEN], pCurrRGB[YUV_BLUE], pCurrRGB[YUV_ALPHA]);
-		pCurrRGB += YUV_RGBA_BPP;
-		YUV444ToRGBA(pCurrYUV[YUV422_Y2], pCurrYUV[YUV422_U], pCurrYUV[YUV422_V],
-						pCurrRGB[YUV_RED], pCurrRGB[YUV_GREEN], pCurrRGB[YUV_BLUE], pCurrRGB[YUV_ALPHA]);
-		pCurrRGB += YUV_RGBA_BPP;
-		pCurrYUV += YUV422_BPP;
-	}
-}
-
-#endif
-
 void drawClosedStream(IntRect* pLocation, const char* csStreamName)
 {
 	char csMessage[512];
@@ -800,20 +599,21 @@ void drawColorImage(IntRect* pLocation, IntPair* pPointer, int pointerRed, int p
 
 	const DepthMetaData* pDepthMetaData = getDepthMetaData();
 
-	double grayscale16Factor = 1.0;
 	if (pImageMD->PixelFormat() == XN_PIXEL_FORMAT_GRAYSCALE_16_BIT)
 	{
-		int nPixelsCount = pImageMD->XRes()*pImageMD->YRes();
-		XnUInt16* pPixel = (XnUInt16*)pImage;
-		for (int i = 0; i < nPixelsCount; ++i,++pPixel)
+		XnUInt16 nMin;
+		XnUInt16 nMax;
+		if (xnGetGray16Range((const XnUInt16*)pImage, pImageMD->XRes()*pImageMD->YRes(), &nMin, &nMax) == XN_STATUS_OK &&
+			nMax > g_nMaxGrayscale16Value)
 		{
-			if (*pPixel > g_nMaxGrayscale16Value)
-				g_nMaxGrayscale16Value = *pPixel;
+			g_nMaxGrayscale16Value = nMax;
 		}
 
-		if (g_nMaxGrayscale16Value > 0)
+		if (g_nGrayscale8LineSize < pImageMD->XRes())
 		{
-			grayscale16Factor = 255.0 / g_nMaxGrayscale16Value;
+			delete[] g_pGrayscale8Line;
+			g_pGrayscale8Line = new XnUInt8[pImageMD->XRes()];
+			g_nGrayscale8LineSize = pImageMD->XRes();
 		}
 	}
 
@@ -823,11 +623,17 @@ void drawColorImage(IntRect* pLocation, IntPair* pPointer, int pointerRed, int p
 
 		if (pImageMD->PixelFormat() == XN_PIXEL_FORMAT_YUV422)
 		{
-			YUV422ToRGB888(pImage, pTexture, pImageMD->XRes()*2, g_texImage.Size.X*g_texImage.nBytesPerPixel);
+			xnConvertYUV422ToRGBA32(pImage, pTexture, pImageMD->XRes());
 			pImage += pImageMD->XRes()*2;
 		}
 		else
 		{
+			const XnUInt8* pGrayscale8 = g_pGrayscale8Line;
+			if (pImageMD->PixelFormat() == XN_PIXEL_FORMAT_GRAYSCALE_16_BIT)
+			{
+				xnConvertGray16ToGray8((const XnUInt16*)pImage, g_pGrayscale8Line, pImageMD->XRes(), 0, g_nMaxGrayscale16Value);
+			}
+
 			for (XnUInt16 nX = 0; nX < pImageMD->XRes(); nX++, pTexture+=4)
 			{
 				XnInt32 nDepthIndex = 0;
@@ -863,10 +669,7 @@ void drawColorImage(IntRect* pLocation, IntPair* pPointer, int pointerRed, int p
 					pImage+=1; 
 					break;
 				case XN_PIXEL_FORMAT_GRAYSCALE_16_BIT:
-					XnUInt16* p16 = (XnUInt16*)pImage;
-					XnUInt8 textureValue = 0;
-					textureValue = (XnUInt8)((*p16) * grayscale16Factor);
-					pTexture[0] = pTexture[1] = pTexture[2] = textureValue;
+					pTexture[0] = pTexture[1] = pTexture[2] = *pGrayscale8++;
 					pImage+=2; 
 					break;
 				}
@@ -928,6 +731,18 @@ void drawDepth(IntRect* pLocation, IntPair* pPointer)
 				}
 			}
 		}
+		else if (g_DrawConfig.Streams.Depth.Coloring == LINEAR_HISTOGRAM)
+		{
+			XnRGB24Pixel yellow = { 255, 255, 0 };
+			XnUInt8 nAlpha = g_DrawConfig.Streams.Depth.fTransparency*255;
+
+			for (XnUInt16 nY = pDepthMD->YOffset(); nY < pDepthMD->YRes() + pDepthMD->YOffset(); nY++)
+			{
+				XnUInt8* pTexture = TextureMapGetLine(&g_texDepth, nY) + pDepthMD->XOffset()*4;
+				xnColorizeDepthToRGBA32(pDepth, pDepthMD->XRes(), g_pDepthHist, g_nDepthHistSize, yellow, nAlpha, pTexture);
+				pDepth += pDepthMD->XRes();
+			}
+		}
 		else
 		{
 			// copy depth into texture-map
@@ -945,9 +760,6 @@ void drawDepth(IntRect* pLocation, IntPair* pPointer)
 
 					switch (g_DrawConfig.Streams.Depth.Coloring)
 					{
-					case LINEAR_HISTOGRAM:
-						nRed = nGreen = g_pDepthHist[*pDepth]*255;
-						break;
 					case PSYCHEDELIC_SHADES:
 						nAlpha *= (((XnFloat)(*pDepth % 10) / 20) + 0.5);
 					case PSYCHEDELIC:
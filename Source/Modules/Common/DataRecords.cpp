@@ -26,7 +26,7 @@
 const RecordingHeader DEFAULT_RECORDING_HEADER = 
 {
 	{'N','I','1','0'}, //Magic
-	{1, 0, 1, 0}, //Version
+	{1, 0, 2, 0}, //Version
 	0, //Global max timestamp
 	0 //Max node id
 };
@@ -1020,6 +1020,65 @@ XnStatus DataIndexRecordHeader::AsString(XnChar* strDest, XnUInt32 nSize, XnUInt
 	return XN_STATUS_OK;
 }
 
+/******************************/
+/* DataIndexChunkRecordHeader */
+/******************************/
+DataIndexChunkRecordHeader::DataIndexChunkRecordHeader(XnUInt8* pData, XnUInt32 nMaxSize, XnBool bUseOld32Header) :
+	Record(pData, nMaxSize, bUseOld32Header),
+	m_nFirstFrame(0)
+{
+}
+
+DataIndexChunkRecordHeader::DataIndexChunkRecordHeader(const Record& record) :
+	Record(record),
+	m_nFirstFrame(0)
+{
+}
+
+void DataIndexChunkRecordHeader::SetFirstFrame(XnUInt32 nFirstFrame)
+{
+	m_nFirstFrame = nFirstFrame;
+}
+
+XnUInt32 DataIndexChunkRecordHeader::GetFirstFrame() const
+{
+	return m_nFirstFrame;
+}
+
+XnStatus DataIndexChunkRecordHeader::Encode()
+{
+	XnStatus nRetVal = StartWrite(RECORD_SEEK_TABLE_CHUNK);
+	XN_IS_STATUS_OK(nRetVal);
+	nRetVal = Write(&m_nFirstFrame, sizeof(m_nFirstFrame));
+	XN_IS_STATUS_OK(nRetVal);
+	//No call to FinishWrite() - this record is not done yet
+	return XN_STATUS_OK;
+}
+
+XnStatus DataIndexChunkRecordHeader::Decode()
+{
+	XnStatus nRetVal = StartRead();
+	XN_IS_STATUS_OK(nRetVal);
+	nRetVal = Read(&m_nFirstFrame, sizeof(m_nFirstFrame));
+	XN_IS_STATUS_OK(nRetVal);
+	//No call to FinishRead() - this record is not done yet
+	return XN_STATUS_OK;
+}
+
+XnStatus DataIndexChunkRecordHeader::AsString(XnChar* strDest, XnUInt32 nSize, XnUInt32& nCharsWritten)
+{
+	XnUInt32 nTempCharsWritten = 0;
+	nCharsWritten = 0;
+	XnStatus nRetVal = Record::AsString(strDest, nSize, nTempCharsWritten);
+	XN_IS_STATUS_OK(nRetVal);
+	nCharsWritten += nTempCharsWritten;
+	nRetVal = xnOSStrFormat(strDest + nCharsWritten, nSize - nCharsWritten, &nTempCharsWritten, 
+		" FirstFrame=%u", m_nFirstFrame);
+	XN_IS_STATUS_OK(nRetVal);
+	nCharsWritten += nTempCharsWritten;
+	return XN_STATUS_OK;
+}
+
 /*************/
 /* EndRecord */
 /*************/
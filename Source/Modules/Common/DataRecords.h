@@ -44,6 +44,7 @@ enum RecordType
 	RECORD_NODE_ADDED_1_0_0_5		= 0x0C,
 	RECORD_NODE_ADDED				= 0x0D,
 	RECORD_SEEK_TABLE               = 0x0E,
+	RECORD_SEEK_TABLE_CHUNK         = 0x0F,
 };
 
 #define INVALID_NODE_ID ((XnUInt32)-1)
@@ -375,6 +376,26 @@ public:
 	XnStatus AsString(XnChar* strDest, XnUInt32 nSize, XnUInt32& nCharsWritten);
 };
 
+/*A part of a node's data index, written while recording. Chunks of a node are chained backwards: the undo
+  record position of each chunk points to the previous one (0 for the first), and the node added record
+  points to the last one written.*/
+class DataIndexChunkRecordHeader : public Record
+{
+public:
+	DataIndexChunkRecordHeader(XnUInt8* pData, XnUInt32 nMaxSize, XnBool bUseOld32Header);
+	DataIndexChunkRecordHeader(const Record& record);
+
+	void SetFirstFrame(XnUInt32 nFirstFrame);
+	XnUInt32 GetFirstFrame() const;
+
+	XnStatus Encode();
+	XnStatus Decode();
+	XnStatus AsString(XnChar* strDest, XnUInt32 nSize, XnUInt32& nCharsWritten);
+
+private:
+	XnUInt32 m_nFirstFrame;
+};
+
 class EndRecord : public Record
 {
 public:
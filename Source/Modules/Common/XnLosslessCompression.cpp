@@ -0,0 +1,2697 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnLosslessCompression.h"
+#include "XnRans.h"
+#include <XnLog.h>
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+	#define XN_LOSSLESS_SSE2
+	#include <emmintrin.h>
+#endif
+
+#define XN_MASK_STREAM_COMPRESSION "xnStreamCompression"
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+XnStatus XnStreamCompressDepth16Z(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	// Local function variables
+	const XnUInt16* pInputEnd = pInput + (nInputSize / sizeof(XnUInt16));
+	XnUInt8* pOrigOutput = pOutput;
+	XnUInt16 nCurrValue = 0;
+	XnUInt16 nLastValue = 0;
+	XnUInt16 nAbsDiffValue = 0;
+	XnInt16 nDiffValue = 0;
+	XnUInt8 cOutStage = 0;
+	XnUInt8 cOutChar = 0;
+	XnUInt8 cZeroCounter = 0;
+
+	// Note: this function does not make sure it stay within the output memory boundaries!
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize == 0)
+	{
+		*pnOutputSize = 0;
+		return XN_STATUS_OK;
+	}
+
+	// Encode the data...
+	nLastValue = *pInput;
+	*(XnUInt16*)pOutput = nLastValue;
+	pInput++;
+	pOutput+=2;
+
+	while (pInput != pInputEnd)
+	{	
+		nCurrValue = *pInput;
+
+		nDiffValue = (nLastValue - nCurrValue);
+		nAbsDiffValue = (XnUInt16)abs(nDiffValue);
+
+		if (nAbsDiffValue <= 6)
+		{
+			nDiffValue += 6;
+
+			if (cOutStage == 0)
+			{
+				cOutChar = (XnUInt8)(nDiffValue << 4);
+
+				cOutStage = 1;
+			}
+			else
+			{
+				cOutChar += (XnUInt8)nDiffValue;
+
+				if (cOutChar == 0x66)
+				{
+					cZeroCounter++;
+
+					if (cZeroCounter == 15)
+					{
+						*pOutput = 0xEF;
+						pOutput++;
+
+						cZeroCounter = 0;
+					}
+				}
+				else
+				{
+					if (cZeroCounter != 0)
+					{
+						*pOutput = 0xE0 + cZeroCounter;
+						pOutput++;
+
+						cZeroCounter = 0;
+					}
+
+					*pOutput = cOutChar;
+					pOutput++;
+				}
+
+				cOutStage = 0;
+			}
+		}
+		else
+		{
+			if (cZeroCounter != 0)
+			{
+				*pOutput = 0xE0 + cZeroCounter;
+				pOutput++;
+
+				cZeroCounter = 0;				
+			}
+
+			if (cOutStage == 0)
+			{
+				cOutChar = 0xFF;				
+			}
+			else
+			{
+				cOutChar += 0x0F;
+				cOutStage = 0;
+			}
+
+			*pOutput = cOutChar;
+			pOutput++;		
+
+			if (nAbsDiffValue <= 63)
+			{
+				nDiffValue += 192;
+
+				*pOutput = (XnUInt8)nDiffValue;
+				pOutput++;
+			}
+			else
+			{
+				*(XnUInt16*)pOutput = (nCurrValue << 8) + (nCurrValue >> 8);
+				pOutput+=2;
+			}
+		}
+
+		nLastValue = nCurrValue;
+		pInput++;
+	}
+
+	if (cOutStage != 0)
+	{
+		*pOutput = cOutChar + 0x0D;
+		pOutput++;
+	}
+
+	if (cZeroCounter != 0)
+	{
+		*pOutput = 0xE0 + cZeroCounter;
+		pOutput++;
+	}
+
+	*pnOutputSize = (XnUInt32)(pOutput - pOrigOutput);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamCompressDepth16ZWithEmbTable(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize, XnUInt16 nMaxValue)
+{
+	// Local function variables
+	const XnUInt16* pInputEnd = pInput + (nInputSize / sizeof(XnUInt16));
+	const XnUInt16* pOrigInput = pInput;
+	const XnUInt8* pOrigOutput = pOutput;
+	XnUInt16 nCurrValue = 0;
+	XnUInt16 nLastValue = 0;
+	XnUInt16 nAbsDiffValue = 0;
+	XnInt16 nDiffValue = 0;
+	XnUInt8 cOutStage = 0;
+	XnUInt8 cOutChar = 0;
+	XnUInt8 cZeroCounter = 0;
+	static XnUInt16 nEmbTable[XN_MAX_UINT16];
+	XnUInt16 nEmbTableIdx=0;
+
+	// Note: this function does not make sure it stay within the output memory boundaries!
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	// Create the embedded value translation table...
+	pOutput+=2;
+	xnOSMemSet(&nEmbTable[0], 0, nMaxValue*sizeof(XnUInt16));
+
+	while (pInput != pInputEnd)
+	{
+		nEmbTable[*pInput] = 1;
+		pInput++;
+	}
+
+	for (XnUInt32 i=0; i<nMaxValue; i++)
+	{
+		if (nEmbTable[i] == 1)
+		{
+			nEmbTable[i] = nEmbTableIdx;
+			nEmbTableIdx++;
+			*(XnUInt16*)pOutput = XN_PREPARE_VAR16_IN_BUFFER(XnUInt16(i));
+			pOutput+=2;
+		}
+	}
+
+	*(XnUInt16*)(pOrigOutput) = XN_PREPARE_VAR16_IN_BUFFER(nEmbTableIdx);
+
+	// Encode the data...
+	pInput = pOrigInput;
+	nLastValue = nEmbTable[*pInput];
+	*(XnUInt16*)pOutput = XN_PREPARE_VAR16_IN_BUFFER(nLastValue);
+	pInput++;
+	pOutput+=2;
+
+// 	for (XnUInt32 i = 0; i < nEmbTableIdx; i++)
+// 		nEmbTable[i] = XN_PREPARE_VAR16_IN_BUFFER(nEmbTable[i]);
+
+
+	while (pInput < pInputEnd)
+	{	
+		nCurrValue = nEmbTable[*pInput];
+
+		nDiffValue = (nLastValue - nCurrValue);
+		nAbsDiffValue = (XnUInt16)abs(nDiffValue);
+
+		if (nAbsDiffValue <= 6)
+		{
+			nDiffValue += 6;
+
+			if (cOutStage == 0)
+			{
+				cOutChar = (XnUInt8)(nDiffValue << 4);
+
+				cOutStage = 1;
+			}
+			else
+			{
+				cOutChar += (XnUInt8)nDiffValue;
+
+				if (cOutChar == 0x66)
+				{
+					cZeroCounter++;
+
+					if (cZeroCounter == 15)
+					{
+						*pOutput = 0xEF;
+						pOutput++;
+
+						cZeroCounter = 0;
+					}
+				}
+				else
+				{
+					if (cZeroCounter != 0)
+					{
+						*pOutput = 0xE0 + cZeroCounter;
+						pOutput++;
+
+						cZeroCounter = 0;
+					}
+
+					*pOutput = cOutChar;
+					pOutput++;
+				}
+
+				cOutStage = 0;
+			}
+		}
+		else
+		{
+			if (cZeroCounter != 0)
+			{
+				*pOutput = 0xE0 + cZeroCounter;
+				pOutput++;
+
+				cZeroCounter = 0;				
+			}
+
+			if (cOutStage == 0)
+			{
+				cOutChar = 0xFF;				
+			}
+			else
+			{
+				cOutChar += 0x0F;
+				cOutStage = 0;
+			}
+
+			*pOutput = cOutChar;
+			pOutput++;		
+
+			if (nAbsDiffValue <= 63)
+			{
+				nDiffValue += 192;
+
+				*pOutput = (XnUInt8)nDiffValue;
+				pOutput++;
+			}
+			else
+			{
+				*(XnUInt16*)pOutput = XN_PREPARE_VAR16_IN_BUFFER((nCurrValue << 8) + (nCurrValue >> 8));
+				pOutput+=2;
+			}
+		}
+
+		nLastValue = nCurrValue;
+		pInput++;
+	}
+
+	if (cOutStage != 0)
+	{
+		*pOutput = cOutChar + 0x0D;
+		pOutput++;
+	}
+
+	if (cZeroCounter != 0)
+	{
+		*pOutput = 0xE0 + cZeroCounter;
+		pOutput++;
+	}
+
+	*pnOutputSize = (XnUInt32)(pOutput - pOrigOutput);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamUncompressDepth16Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize)
+{
+	// Local function variables
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	XnUInt16* pOutputEnd = 0;
+	const XnUInt16* pOrigOutput = pOutput;
+	XnUInt16 nLastFullValue = 0;
+	XnUInt8 cInput = 0;
+	XnUInt8 cZeroCounter = 0;
+	XnInt8 cInData1 = 0;
+	XnInt8 cInData2 = 0;
+	XnUInt8 cInData3 = 0;
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnUInt16))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	pOutputEnd = pOutput + (*pnOutputSize / sizeof(XnUInt16));
+
+	// Decode the data...
+	nLastFullValue = *(XnUInt16*)pInput;
+	*pOutput = nLastFullValue;
+	pInput+=2;
+	pOutput++;
+
+	while (pInput != pInputEnd)
+	{
+		cInput = *pInput;
+
+		if (cInput < 0xE0)
+		{		
+			cInData1 = cInput >> 4;
+			cInData2 = (cInput & 0x0f);		
+
+			nLastFullValue -= (cInData1 - 6);
+			XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+			*pOutput = nLastFullValue;
+			pOutput++;
+
+			if (cInData2 != 0x0f) 
+			{
+				if (cInData2 != 0x0d)
+				{
+					nLastFullValue -= (cInData2 - 6);
+					XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+					*pOutput = nLastFullValue;
+					pOutput++;
+				}
+
+				pInput++;
+			}
+			else
+			{
+				pInput++;
+
+				cInData3 = *pInput;
+				if (cInData3 & 0x80)
+				{
+					nLastFullValue -= (cInData3 - 192);
+
+					XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+					*pOutput = nLastFullValue;
+
+					pOutput++;
+					pInput++;
+				}
+				else
+				{
+					nLastFullValue = cInData3 << 8;
+					pInput++;
+					nLastFullValue += *pInput;
+
+					XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+					*pOutput = nLastFullValue;
+
+					pOutput++;
+					pInput++;
+				}
+			}
+		}
+		else if (cInput == 0xFF)
+		{
+			pInput++;
+
+			cInData3 = *pInput;
+
+			if (cInData3 & 0x80)
+			{
+				nLastFullValue -= (cInData3 - 192);
+
+				XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+				*pOutput = nLastFullValue;
+
+				pInput++;
+				pOutput++;
+			}
+			else
+			{
+				nLastFullValue = cInData3 << 8;
+				pInput++;
+				nLastFullValue += *pInput;
+
+				XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+				*pOutput = nLastFullValue;
+
+				pInput++;
+				pOutput++;
+			}
+		}
+		else //It must be 0xE?
+		{
+			cZeroCounter = cInput - 0xE0;
+
+			while (cZeroCounter != 0)
+			{
+				XN_CHECK_OUTPUT_OVERFLOW(pOutput+1, pOutputEnd);
+				*pOutput = nLastFullValue;						
+				pOutput++;
+
+				*pOutput = nLastFullValue;						
+				pOutput++;
+
+				cZeroCounter--;
+			}
+
+			pInput++;
+		}			
+	}
+
+	*pnOutputSize = (XnUInt32)((pOutput - pOrigOutput) * sizeof(XnUInt16));
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamUncompressDepth16ZWithEmbTable(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize)
+{
+	// Local function variables
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	XnUInt16* pOutputEnd = 0;
+	XnUInt16* pOrigOutput = pOutput;
+	XnUInt16 nLastFullValue = 0;
+	XnUInt8 cInput = 0;
+	XnUInt8 cZeroCounter = 0;
+	XnInt8 cInData1 = 0;
+	XnInt8 cInData2 = 0;
+	XnUInt8 cInData3 = 0;
+	XnUInt16* pEmbTable = NULL;
+	XnUInt16 nEmbTableIdx = 0;
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnUInt16))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	nEmbTableIdx = XN_PREPARE_VAR16_IN_BUFFER(*(XnUInt16*)pInput);
+	pInput+=2;
+	pEmbTable = (XnUInt16*)pInput;
+	pInput+=nEmbTableIdx * 2;
+	for (XnUInt32 i = 0; i < nEmbTableIdx; i++)
+		pEmbTable[i] = XN_PREPARE_VAR16_IN_BUFFER(pEmbTable[i]);
+
+	pOutputEnd = pOutput + (*pnOutputSize / sizeof(XnUInt16));
+
+	// Decode the data...
+	nLastFullValue = XN_PREPARE_VAR16_IN_BUFFER(*(XnUInt16*)pInput);
+	*pOutput = pEmbTable[nLastFullValue];
+	pInput+=2;
+	pOutput++;
+
+	while (pInput != pInputEnd)
+	{
+		cInput = *pInput;
+
+		if (cInput < 0xE0)
+		{		
+			cInData1 = cInput >> 4;
+			cInData2 = (cInput & 0x0f);		
+
+			nLastFullValue -= (cInData1 - 6);
+			XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+			*pOutput =  pEmbTable[nLastFullValue];
+			pOutput++;
+
+			if (cInData2 != 0x0f) 
+			{
+				if (cInData2 != 0x0d)
+				{
+					nLastFullValue -= (cInData2 - 6);
+					XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+					*pOutput =  pEmbTable[nLastFullValue];
+					pOutput++;
+				}
+
+				pInput++;
+			}
+			else
+			{
+				pInput++;
+
+				cInData3 = *pInput;
+				if (cInData3 & 0x80)
+				{
+					nLastFullValue -= (cInData3 - 192);
+
+					XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+					*pOutput =  pEmbTable[nLastFullValue];
+
+					pOutput++;
+					pInput++;
+				}
+				else
+				{
+					nLastFullValue = cInData3 << 8;
+					pInput++;
+					nLastFullValue += *pInput;
+
+					XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+					*pOutput =  pEmbTable[nLastFullValue];
+
+					pOutput++;
+					pInput++;
+				}
+			}
+		}
+		else if (cInput == 0xFF)
+		{
+			pInput++;
+
+			cInData3 = *pInput;
+
+			if (cInData3 & 0x80)
+			{
+				nLastFullValue -= (cInData3 - 192);
+
+				XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+				*pOutput =  pEmbTable[nLastFullValue];
+
+				pInput++;
+				pOutput++;
+			}
+			else
+			{
+				nLastFullValue = cInData3 << 8;
+				pInput++;
+				nLastFullValue += *pInput;
+
+				XN_CHECK_OUTPUT_OVERFLOW(pOutput, pOutputEnd);
+				*pOutput =  pEmbTable[nLastFullValue];
+
+				pInput++;
+				pOutput++;
+			}
+		}
+		else //It must be 0xE?
+		{
+			cZeroCounter = cInput - 0xE0;
+
+			while (cZeroCounter != 0)
+			{
+				XN_CHECK_OUTPUT_OVERFLOW(pOutput+1, pOutputEnd);
+				*pOutput =  pEmbTable[nLastFullValue];
+				pOutput++;
+
+				*pOutput =  pEmbTable[nLastFullValue];
+				pOutput++;
+
+				cZeroCounter--;
+			}
+
+			pInput++;
+		}			
+	}
+
+	*pnOutputSize = (XnUInt32)((pOutput - pOrigOutput) * sizeof(XnUInt16));
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamCompressImage8Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	// Local function variables
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	const XnUInt8* pOrigOutput = pOutput;
+	XnUInt8 nCurrValue = 0;
+	XnUInt8 nLastValue = 0;
+	XnUInt8 nAbsDiffValue = 0;
+	XnInt8 nDiffValue = 0;
+	XnUInt8 cOutStage = 0;
+	XnUInt8 cOutChar = 0;
+	XnUInt8 cZeroCounter = 0;
+	XnBool bFlag = FALSE;
+
+	// Note: this function does not make sure it stay within the output memory boundaries!
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	// Encode the data...
+	nLastValue = *pInput;
+	*pOutput = nLastValue;
+	pInput++;
+	pOutput++;
+
+	while (pInput != pInputEnd)
+	{	
+		nCurrValue = *pInput;
+
+		nDiffValue = (nLastValue - nCurrValue);
+		nAbsDiffValue = (XnUInt8)abs(nDiffValue);
+
+		if (nAbsDiffValue <= 6)
+		{
+			nDiffValue += 6;
+
+			if (cOutStage == 0)
+			{
+				cOutChar = nDiffValue << 4;
+
+				cOutStage = 1;
+			}
+			else
+			{
+				cOutChar += nDiffValue;
+
+				if ((cOutChar == 0x66) && (bFlag == FALSE))
+				{
+					cZeroCounter++;
+
+					if (cZeroCounter == 15)
+					{
+						*pOutput = 0xEF;
+						pOutput++;
+
+						cZeroCounter = 0;
+					}
+				}
+				else
+				{
+					if (cZeroCounter != 0)
+					{
+						*pOutput = 0xE0 + cZeroCounter;
+						pOutput++;
+
+						cZeroCounter = 0;
+					}
+
+					*pOutput = cOutChar;
+					pOutput++;
+
+					bFlag = FALSE;
+				}
+
+				cOutStage = 0;
+			}
+		}
+		else
+		{
+			if (cZeroCounter != 0)
+			{
+				*pOutput = 0xE0 + cZeroCounter;
+				pOutput++;
+
+				cZeroCounter = 0;				
+			}
+
+			if (cOutStage == 0)
+			{
+				cOutChar = 0xF0;		
+				cOutChar += nCurrValue >> 4;
+
+				*pOutput = cOutChar;
+				pOutput++;		
+
+				cOutChar = (nCurrValue & 0xF) << 4;
+				cOutStage = 1;
+
+				bFlag = TRUE;
+			}
+			else
+			{
+				cOutChar += 0x0F;
+				cOutStage = 0;
+
+				*pOutput = cOutChar;
+				pOutput++;		
+
+				*pOutput = nCurrValue;
+				pOutput++;
+			}
+		}
+
+		nLastValue = nCurrValue;
+		pInput++;
+	}
+
+	if (cOutStage != 0)
+	{
+		*pOutput = cOutChar + 0x0D;
+		pOutput++;
+	}
+
+	if (cZeroCounter != 0)
+	{
+		*pOutput = 0xE0 + cZeroCounter;
+		pOutput++;
+	}
+
+	*pnOutputSize = (XnUInt32)(pOutput - pOrigOutput);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamUncompressImage8Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	const XnUInt8* pOrigOutput = pOutput;
+	XnUInt8 nLastFullValue = 0;
+	XnUInt8 cInput = 0;
+	XnUInt8 cZeroCounter = 0;
+	XnInt8 cInData1 = 0;
+	XnInt8 cInData2 = 0;
+
+	// Note: this function does not make sure it stay within the output memory boundaries!
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnUInt8))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	// Decode the data...
+	nLastFullValue = *pInput;
+	*pOutput = nLastFullValue;
+	pInput++;
+	pOutput++;
+
+	while (pInput != pInputEnd)
+	{
+		cInput = *pInput;
+
+		if (cInput < 0xE0)
+		{		
+			cInData1 = cInput >> 4;
+			cInData2 = (cInput & 0x0f);		
+
+			nLastFullValue -= (cInData1 - 6);
+			*pOutput = nLastFullValue;
+			pOutput++;
+
+			if (cInData2 != 0x0f) 
+			{
+				if (cInData2 != 0x0d)
+				{
+					nLastFullValue -= (cInData2 - 6);
+					*pOutput = nLastFullValue;
+					pOutput++;
+				}
+			}
+			else
+			{
+				pInput++;
+				nLastFullValue = *pInput;
+				*pOutput = nLastFullValue;
+				pOutput++;
+			}
+
+			pInput++;
+		}
+		else if (cInput >= 0xF0)
+		{
+			cInData1 = cInput << 4;		
+
+			pInput++;
+			cInput = *pInput;
+
+			nLastFullValue = cInData1 + (cInput >> 4);	
+
+			*pOutput = nLastFullValue;
+			pOutput++;
+
+			cInData2 = cInput & 0xF;
+
+			if (cInData2 == 0x0F) 
+			{
+				pInput++;
+				nLastFullValue = *pInput;
+				*pOutput = nLastFullValue;
+				pOutput++;
+				pInput++;
+			}
+			else
+			{
+				if (cInData2 != 0x0D)
+				{
+					nLastFullValue -= (cInData2 - 6);
+					*pOutput = nLastFullValue;
+					pOutput++;
+				}
+
+				pInput++;
+			}
+		}
+		else //It must be 0xE?
+		{
+			cZeroCounter = cInput - 0xE0;
+
+			while (cZeroCounter != 0)
+			{
+				*pOutput = nLastFullValue;						
+				pOutput++;
+
+				*pOutput = nLastFullValue;						
+				pOutput++;
+
+				cZeroCounter--;
+			}
+
+			pInput++;
+		}			
+	}
+
+	*pnOutputSize = (XnUInt32)(pOutput - pOrigOutput);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamCompressConf4(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	// Local function variables
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	const XnUInt8* pOrigOutput = pOutput;
+
+	// Note: this function does not make sure it stay within the output memory boundaries!
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	// Encode the data...
+	while (pInput != pInputEnd)
+	{
+		*pOutput = *pInput << 4;
+		pInput++;
+		
+		*pOutput += *pInput;
+		pInput++;
+
+		pOutput++;
+	}
+
+	*pnOutputSize = (XnUInt32)(pOutput - pOrigOutput);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamUncompressConf4(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	// Local function variables
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	const XnUInt8* pOutputEnd = 0;
+	const XnUInt8* pOrigOutput = pOutput;
+	XnUInt8 nValue1;
+	XnUInt8 nValue2;
+
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnUInt8))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	if (nInputSize % 2 != 0)
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size not word-aligned");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	pOutputEnd = pOutput + *pnOutputSize;
+
+	XN_CHECK_OUTPUT_OVERFLOW(pOutput + (nInputSize * 2), pOutputEnd);
+
+	while (pInput != pInputEnd)
+	{
+		nValue1 = pInput[0];
+		nValue2 = pInput[1];
+
+		pOutput[0] = nValue1 >> 4;
+		pOutput[1] = nValue1 & 0xF;
+		pOutput[2] = nValue2 >> 4;
+		pOutput[3] = nValue2 & 0xF;
+
+		pOutput+=4;
+		pInput+=2;
+	}
+
+	*pnOutputSize = (XnUInt32)(pOutput - pOrigOutput);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
+//---------------------------------------------------------------------------
+// Entropy Coded Depth
+//---------------------------------------------------------------------------
+#define XN_DEPTH16Z_ANS_MODE_RAW			0
+#define XN_DEPTH16Z_ANS_MODE_RANS			1
+/* Pixels are modeled separately by how busy their neighborhood is. */
+#define XN_ANS_CONTEXTS					6
+/* Residuals below this are their own token. Larger ones are split into a token and raw low bits. */
+#define XN_ANS_DIRECT_TOKENS				16
+
+#pragma pack(push, 1)
+typedef struct XnDepth16ZAnsHeader
+{
+	XnUInt8 nMode;
+	XnUInt8 nReserved[3];
+	XnUInt32 nWidth;
+	XnUInt32 nPixels;
+	XnUInt32 nRawBitsSize;
+} XnDepth16ZAnsHeader;
+#pragma pack(pop)
+
+/* The LOCO-I median edge detector. Predicts a pixel from its left (a), upper (b) and upper-left (c) neighbors. */
+static inline XnInt32 XnAnsMedPredict(XnInt32 a, XnInt32 b, XnInt32 c)
+{
+	XnInt32 nMin = XN_MIN(a, b);
+	XnInt32 nMax = XN_MAX(a, b);
+	if (c >= nMax)
+	{
+		return nMin;
+	}
+	else if (c <= nMin)
+	{
+		return nMax;
+	}
+	else
+	{
+		return a + b - c;
+	}
+}
+
+/* Picks the context of a pixel by how busy its neighborhood is. */
+static inline XnUInt32 XnAnsGradientContext(XnInt32 a, XnInt32 b, XnInt32 c)
+{
+	XnInt32 nGradient = abs(a - c) + abs(b - c);
+	return (nGradient == 0) ? 0 : (nGradient <= 2) ? 1 : (nGradient <= 6) ? 2 : (nGradient <= 18) ? 3 : (nGradient <= 60) ? 4 : 5;
+}
+
+/* Maps a zigzagged residual to a token, and the raw bits that complete it. 16 bit residuals take up to 64 tokens. */
+static inline XnUInt32 XnAnsTokenize(XnUInt32 nZigzag, XnUInt32* pnRawBits, XnUInt32* pnRawBitsCount)
+{
+	if (nZigzag < XN_ANS_DIRECT_TOKENS)
+	{
+		*pnRawBitsCount = 0;
+		return nZigzag;
+	}
+
+	// the token holds the position of the top bit, and the two bits below it
+	XnUInt32 nTopBit = 4;
+	while ((nZigzag >> (nTopBit + 1)) != 0)
+	{
+		nTopBit++;
+	}
+
+	*pnRawBitsCount = nTopBit - 2;
+	*pnRawBits = nZigzag & ((1 << (nTopBit - 2)) - 1);
+	return XN_ANS_DIRECT_TOKENS + ((nTopBit - 4) << 2) + ((nZigzag >> (nTopBit - 2)) & 3);
+}
+
+static inline XnUInt32 XnAnsDetokenize(XnUInt32 nToken, XnRawBitReader* pRawBits)
+{
+	if (nToken < XN_ANS_DIRECT_TOKENS)
+	{
+		return nToken;
+	}
+
+	XnUInt32 nTopBit = 4 + ((nToken - XN_ANS_DIRECT_TOKENS) >> 2);
+	return (1 << nTopBit) | (((nToken - XN_ANS_DIRECT_TOKENS) & 3) << (nTopBit - 2)) | xnRawBitReaderGet(pRawBits, nTopBit - 2);
+}
+
+/* Predicts a depth pixel from its neighbors, treating the ones outside the frame like the closest one inside. */
+static inline XnUInt16 XnDepth16ZAnsPredict(const XnUInt16* pPixel, XnUInt32 nWidth, XnUInt32 nX, XnBool bFirstRow, XnUInt32* pnContext)
+{
+	XnInt32 a;
+	XnInt32 b;
+	XnInt32 c;
+	if (bFirstRow)
+	{
+		a = (nX == 0) ? 0 : pPixel[-1];
+		b = a;
+		c = a;
+	}
+	else if (nX == 0)
+	{
+		b = pPixel[-(XnInt32)nWidth];
+		a = b;
+		c = b;
+	}
+	else
+	{
+		a = pPixel[-1];
+		b = pPixel[-(XnInt32)nWidth];
+		c = pPixel[-(XnInt32)nWidth - 1];
+	}
+
+	*pnContext = XnAnsGradientContext(a, b, c);
+	return (XnUInt16)XnAnsMedPredict(a, b, c);
+}
+
+/* Tokenizes the residual of a depth pixel, modulo 2^16 and zigzagged. */
+static inline XnUInt32 XnDepth16ZAnsTokenize(XnUInt16 nValue, XnUInt16 nPrediction, XnUInt32* pnRawBits, XnUInt32* pnRawBitsCount)
+{
+	XnInt16 nResidual = (XnInt16)(nValue - nPrediction);
+	XnUInt32 nZigzag = (nResidual >= 0) ? ((XnUInt32)nResidual << 1) : (((XnUInt32)(-(XnInt32)nResidual) << 1) - 1);
+	return XnAnsTokenize(nZigzag, pnRawBits, pnRawBitsCount);
+}
+
+static inline XnUInt16 XnDepth16ZAnsDetokenize(XnUInt32 nToken, XnUInt16 nPrediction, XnRawBitReader* pRawBits)
+{
+	XnUInt32 nZigzag = XnAnsDetokenize(nToken, pRawBits);
+	XnInt32 nResidual = ((nZigzag & 1) == 0) ? (XnInt32)(nZigzag >> 1) : -(XnInt32)((nZigzag + 1) >> 1);
+	return (XnUInt16)(nPrediction + nResidual);
+}
+
+/* Returns the size of the entropy coded frame, or 0 if it doesn't fit in nCapacity. */
+static XnUInt32 XnDepth16ZAnsEncode(const XnUInt16* pInput, XnUInt32 nPixels, XnUInt32 nWidth, XnUInt8* pOutput, XnUInt32 nCapacity)
+{
+	const XnUInt8* pOutputEnd = pOutput + nCapacity;
+	XnUInt8* pRawBitsStart = pOutput + sizeof(XnDepth16ZAnsHeader);
+	if (pRawBitsStart > pOutputEnd)
+	{
+		return 0;
+	}
+
+	// first pass: count tokens, and write the raw bits
+	XnUInt32 anCounts[XN_ANS_CONTEXTS][XN_RANS_MAX_SYMBOLS];
+	xnOSMemSet(anCounts, 0, sizeof(anCounts));
+
+	XnRawBitWriter rawBits;
+	xnRawBitWriterInit(&rawBits, pRawBitsStart, pOutputEnd);
+
+	for (XnUInt32 i = 0, nX = 0; i < nPixels; ++i)
+	{
+		XnUInt32 nContext;
+		XnUInt16 nPrediction = XnDepth16ZAnsPredict(pInput + i, nWidth, nX, i < nWidth, &nContext);
+		XnUInt32 nRawBits = 0;
+		XnUInt32 nRawBitsCount = 0;
+		XnUInt32 nToken = XnDepth16ZAnsTokenize(pInput[i], nPrediction, &nRawBits, &nRawBitsCount);
+		anCounts[nContext][nToken]++;
+		if (nRawBitsCount != 0 && !xnRawBitWriterPut(&rawBits, nRawBits, nRawBitsCount))
+		{
+			return 0;
+		}
+
+		if (++nX == nWidth)
+		{
+			nX = 0;
+		}
+	}
+
+	XnUInt8* pModels = xnRawBitWriterFlush(&rawBits);
+	if (pModels == NULL || pOutputEnd - pModels < (XnInt32)(XN_ANS_CONTEXTS * xnRansModelMaxSize()))
+	{
+		return 0;
+	}
+
+	XnDepth16ZAnsHeader* pHeader = (XnDepth16ZAnsHeader*)pOutput;
+	pHeader->nMode = XN_DEPTH16Z_ANS_MODE_RANS;
+	pHeader->nReserved[0] = pHeader->nReserved[1] = pHeader->nReserved[2] = 0;
+	pHeader->nWidth = XN_PREPARE_VAR32_IN_BUFFER(nWidth);
+	pHeader->nPixels = XN_PREPARE_VAR32_IN_BUFFER(nPixels);
+	pHeader->nRawBitsSize = XN_PREPARE_VAR32_IN_BUFFER((XnUInt32)(pModels - pRawBitsStart));
+
+	XnRansEncSymbol aSymbols[XN_ANS_CONTEXTS][XN_RANS_MAX_SYMBOLS];
+	XnUInt8* pStreamStart = pModels;
+	for (XnUInt32 nContext = 0; nContext < XN_ANS_CONTEXTS; ++nContext)
+	{
+		XnRansModel model;
+		xnRansModelBuild(&model, anCounts[nContext], XN_RANS_MAX_SYMBOLS);
+		xnRansEncSymbolsInit(&model, aSymbols[nContext]);
+		pStreamStart = xnRansModelWrite(&model, pStreamStart);
+	}
+
+	// second pass: rANS works backwards, from the end of the output buffer
+	XnUInt32 anStates[XN_RANS_LANES];
+	for (XnUInt32 i = 0; i < XN_RANS_LANES; ++i)
+	{
+		anStates[i] = XN_RANS_STATE_LOW;
+	}
+
+	XnUInt8* pStream = (XnUInt8*)pOutputEnd;
+	XnUInt32 nX = (nPixels == 0) ? 0 : (nPixels - 1) % nWidth;
+	for (XnUInt32 i = nPixels; i-- > 0; )
+	{
+		XnUInt32 nContext;
+		XnUInt16 nPrediction = XnDepth16ZAnsPredict(pInput + i, nWidth, nX, i < nWidth, &nContext);
+		XnUInt32 nRawBits;
+		XnUInt32 nRawBitsCount;
+		XnUInt32 nToken = XnDepth16ZAnsTokenize(pInput[i], nPrediction, &nRawBits, &nRawBitsCount);
+		if (!xnRansEncPut(&anStates[i % XN_RANS_LANES], &pStream, pStreamStart, &aSymbols[nContext][nToken]))
+		{
+			return 0;
+		}
+
+		nX = (nX == 0) ? nWidth - 1 : nX - 1;
+	}
+
+	for (XnUInt32 i = XN_RANS_LANES; i-- > 0; )
+	{
+		if (!xnRansEncFlush(anStates[i], &pStream, pStreamStart))
+		{
+			return 0;
+		}
+	}
+
+	XnUInt32 nStreamSize = (XnUInt32)(pOutputEnd - pStream);
+	xnOSMemMove(pStreamStart, pStream, nStreamSize);
+	return (XnUInt32)(pStreamStart + nStreamSize - pOutput);
+}
+
+XnStatus XnStreamCompressDepth16ZAns(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt32 nWidth, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	XnUInt32 nPixels = nInputSize / sizeof(XnUInt16);
+	XnUInt32 nRawSize = sizeof(XnDepth16ZAnsHeader) + nPixels * sizeof(XnUInt16);
+	if (nRawSize > *pnOutputSize)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small for %u pixels", nPixels);
+	}
+
+	// data that isn't made of whole rows is predicted as one long row
+	if (nWidth == 0 || nPixels % nWidth != 0)
+	{
+		nWidth = XN_MAX(nPixels, 1);
+	}
+
+	// never bigger than the raw data, so noise costs nothing over uncompressed
+	XnUInt32 nSize = XnDepth16ZAnsEncode(pInput, nPixels, nWidth, pOutput, nRawSize);
+	if (nSize == 0)
+	{
+		XnDepth16ZAnsHeader* pHeader = (XnDepth16ZAnsHeader*)pOutput;
+		pHeader->nMode = XN_DEPTH16Z_ANS_MODE_RAW;
+		pHeader->nReserved[0] = pHeader->nReserved[1] = pHeader->nReserved[2] = 0;
+		pHeader->nWidth = XN_PREPARE_VAR32_IN_BUFFER(nWidth);
+		pHeader->nPixels = XN_PREPARE_VAR32_IN_BUFFER(nPixels);
+		pHeader->nRawBitsSize = 0;
+
+		XnUInt16* pRaw = (XnUInt16*)(pOutput + sizeof(XnDepth16ZAnsHeader));
+		for (XnUInt32 i = 0; i < nPixels; ++i)
+		{
+			pRaw[i] = XN_PREPARE_VAR16_IN_BUFFER(pInput[i]);
+		}
+		nSize = nRawSize;
+	}
+
+	*pnOutputSize = nSize;
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamUncompressDepth16ZAns(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize)
+{
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnDepth16ZAnsHeader))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	const XnDepth16ZAnsHeader* pHeader = (const XnDepth16ZAnsHeader*)pInput;
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	const XnUInt8* pData = pInput + sizeof(XnDepth16ZAnsHeader);
+	XnUInt32 nWidth = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nWidth);
+	XnUInt32 nPixels = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nPixels);
+	XnUInt32 nRawBitsSize = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nRawBitsSize);
+
+	if (nPixels > *pnOutputSize / sizeof(XnUInt16))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small for %u pixels", nPixels);
+	}
+
+	if (pHeader->nMode == XN_DEPTH16Z_ANS_MODE_RAW)
+	{
+		if ((XnUInt32)(pInputEnd - pData) < nPixels * sizeof(XnUInt16))
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Raw depth frame is truncated");
+		}
+
+		const XnUInt16* pRaw = (const XnUInt16*)pData;
+		for (XnUInt32 i = 0; i < nPixels; ++i)
+		{
+			pOutput[i] = XN_PREPARE_VAR16_IN_BUFFER(pRaw[i]);
+		}
+
+		*pnOutputSize = nPixels * sizeof(XnUInt16);
+		return (XN_STATUS_OK);
+	}
+
+	if (pHeader->nMode != XN_DEPTH16Z_ANS_MODE_RANS || nWidth == 0 || (nPixels % nWidth) != 0 || nRawBitsSize > (XnUInt32)(pInputEnd - pData))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Invalid entropy coded depth header");
+	}
+
+	XnRawBitReader rawBits;
+	xnRawBitReaderInit(&rawBits, pData, pData + nRawBitsSize);
+
+	XnRansDecTable aTables[XN_ANS_CONTEXTS];
+	const XnUInt8* pStream = pData + nRawBitsSize;
+	for (XnUInt32 nContext = 0; nContext < XN_ANS_CONTEXTS; ++nContext)
+	{
+		XnRansModel model;
+		pStream = xnRansModelRead(&model, XN_RANS_MAX_SYMBOLS, pStream, pInputEnd);
+		if (pStream == NULL)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Invalid entropy coded depth model");
+		}
+		xnRansDecTableInit(&model, &aTables[nContext]);
+	}
+
+	XnUInt32 anStates[XN_RANS_LANES];
+	for (XnUInt32 i = 0; i < XN_RANS_LANES; ++i)
+	{
+		if (!xnRansDecInit(&anStates[i], &pStream, pInputEnd))
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Entropy coded depth frame is truncated");
+		}
+	}
+
+	for (XnUInt32 i = 0, nX = 0; i < nPixels; ++i)
+	{
+		XnUInt32 nContext;
+		XnUInt16 nPrediction = XnDepth16ZAnsPredict(pOutput + i, nWidth, nX, i < nWidth, &nContext);
+		XnUInt32 nToken = xnRansDecGet(&anStates[i % XN_RANS_LANES], &pStream, pInputEnd, &aTables[nContext]);
+		pOutput[i] = XnDepth16ZAnsDetokenize(nToken, nPrediction, &rawBits);
+
+		if (++nX == nWidth)
+		{
+			nX = 0;
+		}
+	}
+
+	// the encoder started all lanes from the same state, so any corruption shows here
+	XnBool bValid = !xnRansDecOverrun(pStream, pInputEnd) && !xnRawBitReaderOverrun(&rawBits);
+	for (XnUInt32 i = 0; i < XN_RANS_LANES; ++i)
+	{
+		bValid = bValid && (anStates[i] == XN_RANS_STATE_LOW);
+	}
+
+	if (!bValid)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Entropy coded depth frame is corrupt");
+	}
+
+	*pnOutputSize = nPixels * sizeof(XnUInt16);
+	return (XN_STATUS_OK);
+}
+
+//---------------------------------------------------------------------------
+// Lossless Image
+//---------------------------------------------------------------------------
+#define XN_IMAGE_LOSSLESS_MODE_RAW			0
+#define XN_IMAGE_LOSSLESS_MODE_RANS			1
+#define XN_IMAGE_LOSSLESS_MAX_PLANES		3
+/* 8 bit residuals take the direct tokens, and 4 more for each of the top bits 4 to 7. */
+#define XN_IMAGE_LOSSLESS_TOKENS			32
+
+#pragma pack(push, 1)
+typedef struct XnImageLosslessHeader
+{
+	XnUInt8 nMode;
+	XnUInt8 nFormat;
+	XnUInt8 nReserved[2];
+	XnUInt32 nWidth;
+	XnUInt32 nHeight;
+	XnUInt32 nRawBitsSize;
+} XnImageLosslessHeader;
+#pragma pack(pop)
+
+/*
+* Samples of one color component, as found in the rows of the image. A plane with a reference is coded as its
+* difference from the reference sample of the same pixel (R - G and B - G), which removes most of what color
+* components have in common.
+*/
+typedef struct XnImageLosslessPlane
+{
+	XnUInt32 nOffset;
+	XnUInt32 nStep;
+	XnUInt32 nWidth;
+	XnBool bHasReference;
+	XnInt32 nReferenceDelta;
+} XnImageLosslessPlane;
+
+/* Returns the number of planes, or 0 if the format isn't supported. */
+static XnUInt32 XnImageLosslessGetPlanes(XnPixelFormat format, XnUInt32 nWidth, XnImageLosslessPlane* aPlanes, XnUInt32* pnBytesPerPixel)
+{
+	xnOSMemSet(aPlanes, 0, sizeof(XnImageLosslessPlane) * XN_IMAGE_LOSSLESS_MAX_PLANES);
+
+	switch (format)
+	{
+	case XN_PIXEL_FORMAT_GRAYSCALE_8_BIT:
+		*pnBytesPerPixel = 1;
+		aPlanes[0].nStep = 1;
+		aPlanes[0].nWidth = nWidth;
+		return 1;
+	case XN_PIXEL_FORMAT_RGB24:
+		// green first, so red and blue can be coded relative to it
+		*pnBytesPerPixel = 3;
+		aPlanes[0].nOffset = 1;
+		aPlanes[1].nOffset = 0;
+		aPlanes[1].bHasReference = TRUE;
+		aPlanes[1].nReferenceDelta = 1;
+		aPlanes[2].nOffset = 2;
+		aPlanes[2].bHasReference = TRUE;
+		aPlanes[2].nReferenceDelta = -1;
+		for (XnUInt32 i = 0; i < 3; ++i)
+		{
+			aPlanes[i].nStep = 3;
+			aPlanes[i].nWidth = nWidth;
+		}
+		return 3;
+	case XN_PIXEL_FORMAT_YUV422:
+		// U Y1 V Y2. Luma is at full resolution, chroma at half.
+		*pnBytesPerPixel = 2;
+		aPlanes[0].nOffset = 1;
+		aPlanes[0].nStep = 2;
+		aPlanes[0].nWidth = nWidth;
+		aPlanes[1].nOffset = 0;
+		aPlanes[1].nStep = 4;
+		aPlanes[1].nWidth = nWidth / 2;
+		aPlanes[2].nOffset = 2;
+		aPlanes[2].nStep = 4;
+		aPlanes[2].nWidth = nWidth / 2;
+		return 3;
+	default:
+		return 0;
+	}
+}
+
+/* Copies the samples of a plane from a row of the image, applying the color transform. */
+static void XnImageLosslessGatherRow(const XnUInt8* pRow, const XnImageLosslessPlane& plane, XnUInt8* pSamples)
+{
+	const XnUInt8* pSample = pRow + plane.nOffset;
+	if (plane.bHasReference)
+	{
+		for (XnUInt32 x = 0; x < plane.nWidth; ++x, pSample += plane.nStep)
+		{
+			pSamples[x] = (XnUInt8)(pSample[0] - pSample[plane.nReferenceDelta]);
+		}
+	}
+	else if (plane.nStep == 1)
+	{
+		xnOSMemCopy(pSamples, pSample, plane.nWidth);
+	}
+	else
+	{
+		for (XnUInt32 x = 0; x < plane.nWidth; ++x, pSample += plane.nStep)
+		{
+			pSamples[x] = *pSample;
+		}
+	}
+}
+
+/* The inverse of XnImageLosslessGatherRow. References must already be in place. */
+static void XnImageLosslessScatterRow(const XnUInt8* pSamples, const XnImageLosslessPlane& plane, XnUInt8* pRow)
+{
+	XnUInt8* pSample = pRow + plane.nOffset;
+	if (plane.bHasReference)
+	{
+		for (XnUInt32 x = 0; x < plane.nWidth; ++x, pSample += plane.nStep)
+		{
+			pSample[0] = (XnUInt8)(pSamples[x] + pSample[plane.nReferenceDelta]);
+		}
+	}
+	else
+	{
+		for (XnUInt32 x = 0; x < plane.nWidth; ++x, pSample += plane.nStep)
+		{
+			*pSample = pSamples[x];
+		}
+	}
+}
+
+/* Gets the neighbors of a sample, treating the ones outside the plane like the closest one inside. */
+static inline void XnImageLosslessNeighbors(const XnUInt8* pRow, const XnUInt8* pPrevRow, XnUInt32 x, XnInt32* pa, XnInt32* pb, XnInt32* pc)
+{
+	if (pPrevRow == NULL)
+	{
+		*pa = (x == 0) ? 0 : pRow[x - 1];
+		*pb = *pa;
+		*pc = *pa;
+	}
+	else if (x == 0)
+	{
+		*pb = pPrevRow[0];
+		*pa = *pb;
+		*pc = *pb;
+	}
+	else
+	{
+		*pa = pRow[x - 1];
+		*pb = pPrevRow[x];
+		*pc = pPrevRow[x - 1];
+	}
+}
+
+static inline void XnImageLosslessResidual(const XnUInt8* pRow, const XnUInt8* pPrevRow, XnUInt32 x, XnUInt8* pZigzags, XnUInt8* pContexts)
+{
+	XnInt32 a;
+	XnInt32 b;
+	XnInt32 c;
+	XnImageLosslessNeighbors(pRow, pPrevRow, x, &a, &b, &c);
+	pContexts[x] = (XnUInt8)XnAnsGradientContext(a, b, c);
+	XnInt32 nResidual = (XnInt8)(pRow[x] - XnAnsMedPredict(a, b, c));
+	pZigzags[x] = (XnUInt8)((nResidual << 1) ^ (nResidual >> 7));
+}
+
+/*
+* Computes the zigzagged residual and the context of every sample in a row. Unlike decoding, this only depends
+* on the original samples, so whole rows are predicted at once.
+*/
+static void XnImageLosslessResidualRow(const XnUInt8* pRow, const XnUInt8* pPrevRow, XnUInt32 nWidth, XnUInt8* pZigzags, XnUInt8* pContexts)
+{
+	XnUInt32 x = 0;
+	if (pPrevRow == NULL || nWidth == 0)
+	{
+		for (; x < nWidth; ++x)
+		{
+			XnImageLosslessResidual(pRow, pPrevRow, x, pZigzags, pContexts);
+		}
+		return;
+	}
+
+	XnImageLosslessResidual(pRow, pPrevRow, 0, pZigzags, pContexts);
+	x = 1;
+
+#ifdef XN_LOSSLESS_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i contexts = _mm_set1_epi8(5);
+	const __m128i threshold2 = _mm_set1_epi8(2);
+	const __m128i threshold6 = _mm_set1_epi8(6);
+	const __m128i threshold18 = _mm_set1_epi8(18);
+	const __m128i threshold60 = _mm_set1_epi8(60);
+
+	for (; x + 16 <= nWidth; x += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(pRow + x));
+		__m128i a = _mm_loadu_si128((const __m128i*)(pRow + x - 1));
+		__m128i b = _mm_loadu_si128((const __m128i*)(pPrevRow + x));
+		__m128i c = _mm_loadu_si128((const __m128i*)(pPrevRow + x - 1));
+
+		// median edge detector: min(a, b) if c >= max(a, b), max(a, b) if c <= min(a, b), a + b - c otherwise
+		__m128i minAB = _mm_min_epu8(a, b);
+		__m128i maxAB = _mm_max_epu8(a, b);
+		__m128i cAboveMax = _mm_cmpeq_epi8(_mm_max_epu8(c, maxAB), c);
+		__m128i cBelowMin = _mm_cmpeq_epi8(_mm_min_epu8(c, minAB), c);
+		__m128i plane = _mm_sub_epi8(_mm_add_epi8(a, b), c);
+		__m128i prediction = _mm_or_si128(_mm_and_si128(cBelowMin, maxAB), _mm_andnot_si128(cBelowMin, plane));
+		prediction = _mm_or_si128(_mm_and_si128(cAboveMax, minAB), _mm_andnot_si128(cAboveMax, prediction));
+
+		__m128i residual = _mm_sub_epi8(v, prediction);
+		__m128i zigzag = _mm_xor_si128(_mm_add_epi8(residual, residual), _mm_cmplt_epi8(residual, zero));
+		_mm_storeu_si128((__m128i*)(pZigzags + x), zigzag);
+
+		// gradients only need to be told apart up to 60, so saturating is fine. Each threshold the
+		// gradient doesn't exceed takes one off the busiest context.
+		__m128i gradientAC = _mm_or_si128(_mm_subs_epu8(a, c), _mm_subs_epu8(c, a));
+		__m128i gradientBC = _mm_or_si128(_mm_subs_epu8(b, c), _mm_subs_epu8(c, b));
+		__m128i gradient = _mm_adds_epu8(gradientAC, gradientBC);
+		__m128i context = _mm_add_epi8(contexts, _mm_cmpeq_epi8(gradient, zero));
+		context = _mm_add_epi8(context, _mm_cmpeq_epi8(_mm_subs_epu8(gradient, threshold2), zero));
+		context = _mm_add_epi8(context, _mm_cmpeq_epi8(_mm_subs_epu8(gradient, threshold6), zero));
+		context = _mm_add_epi8(context, _mm_cmpeq_epi8(_mm_subs_epu8(gradient, threshold18), zero));
+		context = _mm_add_epi8(context, _mm_cmpeq_epi8(_mm_subs_epu8(gradient, threshold60), zero));
+		_mm_storeu_si128((__m128i*)(pContexts + x), context);
+	}
+#endif
+
+	for (; x < nWidth; ++x)
+	{
+		XnImageLosslessResidual(pRow, pPrevRow, x, pZigzags, pContexts);
+	}
+}
+
+/*
+* Returns the size of the entropy coded image, or 0 if it doesn't fit in nCapacity. pRowBuffers must have
+* room for 4 rows of the widest plane.
+*/
+static XnUInt32 XnImageLosslessEncode(const XnUInt8* pInput, XnPixelFormat format, XnUInt32 nWidth, XnUInt32 nHeight, XnUInt8* pRowBuffers, XnUInt8* pOutput, XnUInt32 nCapacity)
+{
+	XnImageLosslessPlane aPlanes[XN_IMAGE_LOSSLESS_MAX_PLANES];
+	XnUInt32 nBytesPerPixel = 0;
+	XnUInt32 nPlanes = XnImageLosslessGetPlanes(format, nWidth, aPlanes, &nBytesPerPixel);
+	XnUInt32 nRowSize = nWidth * nBytesPerPixel;
+
+	XnUInt8* apRows[2] = { pRowBuffers, pRowBuffers + nWidth };
+	XnUInt8* pZigzags = pRowBuffers + 2 * nWidth;
+	XnUInt8* pContexts = pRowBuffers + 3 * nWidth;
+
+	const XnUInt8* pOutputEnd = pOutput + nCapacity;
+	XnUInt8* pRawBitsStart = pOutput + sizeof(XnImageLosslessHeader);
+	if (pRawBitsStart > pOutputEnd)
+	{
+		return 0;
+	}
+
+	// tokens of all 256 residuals, looked up rather than computed per sample
+	XnUInt8 anTokens[256];
+	XnUInt8 anRawBitsCounts[256];
+	XnUInt8 anRawBits[256];
+	for (XnUInt32 i = 0; i < 256; ++i)
+	{
+		XnUInt32 nRawBits = 0;
+		XnUInt32 nRawBitsCount = 0;
+		anTokens[i] = (XnUInt8)XnAnsTokenize(i, &nRawBits, &nRawBitsCount);
+		anRawBitsCounts[i] = (XnUInt8)nRawBitsCount;
+		anRawBits[i] = (XnUInt8)nRawBits;
+	}
+
+	// first pass: count tokens, and write the raw bits
+	XnUInt32 anCounts[XN_IMAGE_LOSSLESS_MAX_PLANES * XN_ANS_CONTEXTS][XN_IMAGE_LOSSLESS_TOKENS];
+	xnOSMemSet(anCounts, 0, sizeof(anCounts));
+
+	XnRawBitWriter rawBits;
+	xnRawBitWriterInit(&rawBits, pRawBitsStart, pOutputEnd);
+
+	for (XnUInt32 nPlane = 0; nPlane < nPlanes; ++nPlane)
+	{
+		const XnImageLosslessPlane& plane = aPlanes[nPlane];
+		XnUInt32 (*anPlaneCounts)[XN_IMAGE_LOSSLESS_TOKENS] = anCounts + nPlane * XN_ANS_CONTEXTS;
+
+		for (XnUInt32 y = 0; y < nHeight; ++y)
+		{
+			XnUInt8* pRow = apRows[y & 1];
+			XnImageLosslessGatherRow(pInput + y * nRowSize, plane, pRow);
+			XnImageLosslessResidualRow(pRow, (y == 0) ? NULL : apRows[(y - 1) & 1], plane.nWidth, pZigzags, pContexts);
+
+			for (XnUInt32 x = 0; x < plane.nWidth; ++x)
+			{
+				XnUInt32 nZigzag = pZigzags[x];
+				anPlaneCounts[pContexts[x]][anTokens[nZigzag]]++;
+				if (anRawBitsCounts[nZigzag] != 0 && !xnRawBitWriterPut(&rawBits, anRawBits[nZigzag], anRawBitsCounts[nZigzag]))
+				{
+					return 0;
+				}
+			}
+		}
+	}
+
+	XnUInt8* pModels = xnRawBitWriterFlush(&rawBits);
+	if (pModels == NULL || pOutputEnd - pModels < (XnInt32)(nPlanes * XN_ANS_CONTEXTS * xnRansModelMaxSize()))
+	{
+		return 0;
+	}
+
+	XnImageLosslessHeader* pHeader = (XnImageLosslessHeader*)pOutput;
+	pHeader->nMode = XN_IMAGE_LOSSLESS_MODE_RANS;
+	pHeader->nFormat = (XnUInt8)format;
+	pHeader->nReserved[0] = pHeader->nReserved[1] = 0;
+	pHeader->nWidth = XN_PREPARE_VAR32_IN_BUFFER(nWidth);
+	pHeader->nHeight = XN_PREPARE_VAR32_IN_BUFFER(nHeight);
+	pHeader->nRawBitsSize = XN_PREPARE_VAR32_IN_BUFFER((XnUInt32)(pModels - pRawBitsStart));
+
+	XnRansEncSymbol aSymbols[XN_IMAGE_LOSSLESS_MAX_PLANES * XN_ANS_CONTEXTS][XN_IMAGE_LOSSLESS_TOKENS];
+	XnUInt8* pStreamStart = pModels;
+	for (XnUInt32 nModel = 0; nModel < nPlanes * XN_ANS_CONTEXTS; ++nModel)
+	{
+		XnRansModel model;
+		xnRansModelBuild(&model, anCounts[nModel], XN_IMAGE_LOSSLESS_TOKENS);
+		xnRansEncSymbolsInit(&model, aSymbols[nModel]);
+		pStreamStart = xnRansModelWrite(&model, pStreamStart);
+	}
+
+	// second pass: rANS works backwards, from the last sample of the last plane
+	XnUInt32 anStates[XN_RANS_LANES];
+	for (XnUInt32 i = 0; i < XN_RANS_LANES; ++i)
+	{
+		anStates[i] = XN_RANS_STATE_LOW;
+	}
+
+	XnUInt32 nSamples = 0;
+	for (XnUInt32 nPlane = 0; nPlane < nPlanes; ++nPlane)
+	{
+		nSamples += aPlanes[nPlane].nWidth * nHeight;
+	}
+
+	XnUInt8* pStream = (XnUInt8*)pOutputEnd;
+	for (XnUInt32 nPlane = nPlanes; nPlane-- > 0; )
+	{
+		const XnImageLosslessPlane& plane = aPlanes[nPlane];
+		XnRansEncSymbol (*aPlaneSymbols)[XN_IMAGE_LOSSLESS_TOKENS] = aSymbols + nPlane * XN_ANS_CONTEXTS;
+
+		if (nHeight != 0)
+		{
+			XnImageLosslessGatherRow(pInput + (nHeight - 1) * nRowSize, plane, apRows[(nHeight - 1) & 1]);
+		}
+
+		for (XnUInt32 y = nHeight; y-- > 0; )
+		{
+			XnUInt8* pPrevRow = NULL;
+			if (y != 0)
+			{
+				pPrevRow = apRows[(y - 1) & 1];
+				XnImageLosslessGatherRow(pInput + (y - 1) * nRowSize, plane, pPrevRow);
+			}
+			XnImageLosslessResidualRow(apRows[y & 1], pPrevRow, plane.nWidth, pZigzags, pContexts);
+
+			for (XnUInt32 x = plane.nWidth; x-- > 0; )
+			{
+				--nSamples;
+				if (!xnRansEncPut(&anStates[nSamples % XN_RANS_LANES], &pStream, pStreamStart, &aPlaneSymbols[pContexts[x]][anTokens[pZigzags[x]]]))
+				{
+					return 0;
+				}
+			}
+		}
+	}
+
+	for (XnUInt32 i = XN_RANS_LANES; i-- > 0; )
+	{
+		if (!xnRansEncFlush(anStates[i], &pStream, pStreamStart))
+		{
+			return 0;
+		}
+	}
+
+	XnUInt32 nStreamSize = (XnUInt32)(pOutputEnd - pStream);
+	xnOSMemMove(pStreamStart, pStream, nStreamSize);
+	return (XnUInt32)(pStreamStart + nStreamSize - pOutput);
+}
+
+XnStatus XnStreamCompressImageLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnPixelFormat format, XnUInt32 nWidth, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (*pnOutputSize < sizeof(XnImageLosslessHeader))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small");
+	}
+
+	XnImageLosslessHeader* pHeader = (XnImageLosslessHeader*)pOutput;
+
+	// grayscale 16 is depth-like, and is coded just like depth, after the header
+	if (format == XN_PIXEL_FORMAT_GRAYSCALE_16_BIT)
+	{
+		XnUInt32 nPixels = nInputSize / sizeof(XnUInt16);
+		pHeader->nMode = XN_IMAGE_LOSSLESS_MODE_RANS;
+		pHeader->nFormat = (XnUInt8)format;
+		pHeader->nReserved[0] = pHeader->nReserved[1] = 0;
+		pHeader->nRawBitsSize = 0;
+		pHeader->nWidth = XN_PREPARE_VAR32_IN_BUFFER(nWidth);
+		pHeader->nHeight = XN_PREPARE_VAR32_IN_BUFFER((nWidth == 0) ? 0 : nPixels / nWidth);
+
+		XnUInt32 nSize = *pnOutputSize - sizeof(XnImageLosslessHeader);
+		nRetVal = XnStreamCompressDepth16ZAns((const XnUInt16*)pInput, nInputSize, nWidth, pOutput + sizeof(XnImageLosslessHeader), &nSize);
+		XN_IS_STATUS_OK(nRetVal);
+
+		*pnOutputSize = sizeof(XnImageLosslessHeader) + nSize;
+		return (XN_STATUS_OK);
+	}
+
+	XnImageLosslessPlane aPlanes[XN_IMAGE_LOSSLESS_MAX_PLANES];
+	XnUInt32 nBytesPerPixel = 0;
+	if (XnImageLosslessGetPlanes(format, nWidth, aPlanes, &nBytesPerPixel) == 0)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_STREAM_COMPRESSION, "Lossless image compression doesn't support pixel format %d", format);
+	}
+
+	// data that isn't made of whole rows is coded as one long row. YUV422 pixels come in pairs.
+	XnUInt32 nPixelAlignment = (format == XN_PIXEL_FORMAT_YUV422) ? 2 : 1;
+	if (nInputSize % (nBytesPerPixel * nPixelAlignment) != 0)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_STREAM_COMPRESSION, "Input size %u is not a whole number of pixels", nInputSize);
+	}
+
+	XnUInt32 nPixels = nInputSize / nBytesPerPixel;
+	if (nWidth == 0 || nWidth % nPixelAlignment != 0 || nPixels % nWidth != 0)
+	{
+		nWidth = XN_MAX(nPixels, nPixelAlignment);
+	}
+	XnUInt32 nHeight = nPixels / nWidth;
+
+	XnUInt32 nRawSize = sizeof(XnImageLosslessHeader) + nInputSize;
+	if (nRawSize > *pnOutputSize)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small for %u bytes", nInputSize);
+	}
+
+	XnUInt8* pRowBuffers = (XnUInt8*)xnOSMalloc(4 * nWidth);
+	XN_VALIDATE_ALLOC_PTR(pRowBuffers);
+
+	// never bigger than the raw data, so noise costs nothing over uncompressed
+	XnUInt32 nSize = XnImageLosslessEncode(pInput, format, nWidth, nHeight, pRowBuffers, pOutput, nRawSize);
+	xnOSFree(pRowBuffers);
+
+	if (nSize == 0)
+	{
+		pHeader->nMode = XN_IMAGE_LOSSLESS_MODE_RAW;
+		pHeader->nFormat = (XnUInt8)format;
+		pHeader->nReserved[0] = pHeader->nReserved[1] = 0;
+		pHeader->nWidth = XN_PREPARE_VAR32_IN_BUFFER(nWidth);
+		pHeader->nHeight = XN_PREPARE_VAR32_IN_BUFFER(nHeight);
+		pHeader->nRawBitsSize = 0;
+		xnOSMemCopy(pOutput + sizeof(XnImageLosslessHeader), pInput, nInputSize);
+		nSize = nRawSize;
+	}
+
+	*pnOutputSize = nSize;
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnStreamUncompressImageLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnImageLosslessHeader))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	const XnImageLosslessHeader* pHeader = (const XnImageLosslessHeader*)pInput;
+	const XnUInt8* pInputEnd = pInput + nInputSize;
+	const XnUInt8* pData = pInput + sizeof(XnImageLosslessHeader);
+	XnPixelFormat format = (XnPixelFormat)pHeader->nFormat;
+	XnUInt32 nWidth = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nWidth);
+	XnUInt32 nHeight = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nHeight);
+	XnUInt32 nRawBitsSize = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nRawBitsSize);
+
+	if (format == XN_PIXEL_FORMAT_GRAYSCALE_16_BIT)
+	{
+		return XnStreamUncompressDepth16ZAns(pData, (XnUInt32)(pInputEnd - pData), (XnUInt16*)pOutput, pnOutputSize);
+	}
+
+	XnImageLosslessPlane aPlanes[XN_IMAGE_LOSSLESS_MAX_PLANES];
+	XnUInt32 nBytesPerPixel = 0;
+	XnUInt32 nPlanes = XnImageLosslessGetPlanes(format, nWidth, aPlanes, &nBytesPerPixel);
+	if (nPlanes == 0 || nWidth > *pnOutputSize || (format == XN_PIXEL_FORMAT_YUV422 && nWidth % 2 != 0))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Invalid lossless image header");
+	}
+
+	XnUInt64 nImageSize = (XnUInt64)nWidth * nHeight * nBytesPerPixel;
+	if (nImageSize > *pnOutputSize)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small for a %ux%u image", nWidth, nHeight);
+	}
+
+	if (pHeader->nMode == XN_IMAGE_LOSSLESS_MODE_RAW)
+	{
+		if ((XnUInt64)(pInputEnd - pData) < nImageSize)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Raw image is truncated");
+		}
+
+		xnOSMemCopy(pOutput, pData, (XnUInt32)nImageSize);
+		*pnOutputSize = (XnUInt32)nImageSize;
+		return (XN_STATUS_OK);
+	}
+
+	if (pHeader->nMode != XN_IMAGE_LOSSLESS_MODE_RANS || nRawBitsSize > (XnUInt32)(pInputEnd - pData))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Invalid lossless image header");
+	}
+
+	XnRawBitReader rawBits;
+	xnRawBitReaderInit(&rawBits, pData, pData + nRawBitsSize);
+
+	XnRansModel aModels[XN_IMAGE_LOSSLESS_MAX_PLANES * XN_ANS_CONTEXTS];
+	const XnUInt8* pStream = pData + nRawBitsSize;
+	for (XnUInt32 nModel = 0; nModel < nPlanes * XN_ANS_CONTEXTS; ++nModel)
+	{
+		pStream = xnRansModelRead(&aModels[nModel], XN_IMAGE_LOSSLESS_TOKENS, pStream, pInputEnd);
+		if (pStream == NULL)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Invalid lossless image model");
+		}
+	}
+
+	XnUInt32 anStates[XN_RANS_LANES];
+	for (XnUInt32 i = 0; i < XN_RANS_LANES; ++i)
+	{
+		if (!xnRansDecInit(&anStates[i], &pStream, pInputEnd))
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Lossless image is truncated");
+		}
+	}
+
+	XnUInt8* pRowBuffers = (XnUInt8*)xnOSMalloc(2 * XN_MAX(nWidth, 1));
+	XN_VALIDATE_ALLOC_PTR(pRowBuffers);
+	XnUInt8* apRows[2] = { pRowBuffers, pRowBuffers + nWidth };
+	XnUInt32 nRowSize = nWidth * nBytesPerPixel;
+	XnUInt32 nSample = 0;
+
+	// planes are decoded one after the other, so only one plane's tables are needed at a time
+	XnRansDecTable aTables[XN_ANS_CONTEXTS];
+	for (XnUInt32 nPlane = 0; nPlane < nPlanes; ++nPlane)
+	{
+		const XnImageLosslessPlane& plane = aPlanes[nPlane];
+		for (XnUInt32 nContext = 0; nContext < XN_ANS_CONTEXTS; ++nContext)
+		{
+			xnRansDecTableInit(&aModels[nPlane * XN_ANS_CONTEXTS + nContext], &aTables[nContext]);
+		}
+
+		for (XnUInt32 y = 0; y < nHeight; ++y)
+		{
+			XnUInt8* pRow = apRows[y & 1];
+			const XnUInt8* pPrevRow = (y == 0) ? NULL : apRows[(y - 1) & 1];
+			for (XnUInt32 x = 0; x < plane.nWidth; ++x, ++nSample)
+			{
+				XnInt32 a;
+				XnInt32 b;
+				XnInt32 c;
+				XnImageLosslessNeighbors(pRow, pPrevRow, x, &a, &b, &c);
+				XnUInt32 nContext = XnAnsGradientContext(a, b, c);
+				XnUInt32 nToken = xnRansDecGet(&anStates[nSample % XN_RANS_LANES], &pStream, pInputEnd, &aTables[nContext]);
+				XnUInt32 nZigzag = XnAnsDetokenize(nToken, &rawBits);
+				XnInt32 nResidual = ((nZigzag & 1) == 0) ? (XnInt32)(nZigzag >> 1) : -(XnInt32)((nZigzag + 1) >> 1);
+				pRow[x] = (XnUInt8)(XnAnsMedPredict(a, b, c) + nResidual);
+			}
+
+			XnImageLosslessScatterRow(pRow, plane, pOutput + y * nRowSize);
+		}
+	}
+
+	xnOSFree(pRowBuffers);
+
+	// the encoder started all lanes from the same state, so any corruption shows here
+	XnBool bValid = !xnRansDecOverrun(pStream, pInputEnd) && !xnRawBitReaderOverrun(&rawBits);
+	for (XnUInt32 i = 0; i < XN_RANS_LANES; ++i)
+	{
+		bValid = bValid && (anStates[i] == XN_RANS_STATE_LOW);
+	}
+
+	if (!bValid)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Lossless image is corrupt");
+	}
+
+	*pnOutputSize = (XnUInt32)nImageSize;
+	return (XN_STATUS_OK);
+}
+
+//---------------------------------------------------------------------------
+// Lossless Audio
+//---------------------------------------------------------------------------
+#define XN_AUDIO_LOSSLESS_MODE_RAW				0
+#define XN_AUDIO_LOSSLESS_MODE_LPC				1
+#define XN_AUDIO_LOSSLESS_PREDICTOR_VERBATIM	0
+#define XN_AUDIO_LOSSLESS_PREDICTOR_FIXED		1
+#define XN_AUDIO_LOSSLESS_PREDICTOR_LPC			2
+#define XN_AUDIO_LOSSLESS_MAX_FIXED_ORDER		4
+#define XN_AUDIO_LOSSLESS_LPC_ORDER				8
+/* Coefficients are signed 12 bit, so with 16 bit samples and 8 of them the prediction fits in 32 bits. */
+#define XN_AUDIO_LOSSLESS_LPC_PRECISION			12
+#define XN_AUDIO_LOSSLESS_MAX_LPC_SHIFT			15
+#define XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER	6
+/* Partitions smaller than this aren't worth the bits of their Rice parameter. */
+#define XN_AUDIO_LOSSLESS_MIN_PARTITION_SIZE	32
+#define XN_AUDIO_LOSSLESS_MAX_RICE_PARAM		30
+/* A quotient this large is written as this many zeros and a one, followed by the whole value. */
+#define XN_AUDIO_LOSSLESS_RICE_ESCAPE			31
+
+#pragma pack(push, 1)
+typedef struct XnAudioLosslessHeader
+{
+	XnUInt8 nMode;
+	XnUInt8 nChannels;
+	XnUInt8 nBitsPerSample;
+	XnUInt8 nReserved;
+	XnUInt32 nSize;
+	XnUInt32 nChecksum;
+} XnAudioLosslessHeader;
+#pragma pack(pop)
+
+/* How a channel is coded. Chosen per channel and per frame, by the number of bits it takes. */
+typedef struct XnAudioLosslessPlan
+{
+	XnUInt32 nPredictor;
+	XnUInt32 nOrder;
+	XnUInt32 nShift;
+	XnInt32 anCoeffs[XN_AUDIO_LOSSLESS_LPC_ORDER];
+	XnUInt32 nPartitionOrder;
+	XnUInt8 anRiceParams[1 << XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER];
+	XnUInt64 nBits;
+} XnAudioLosslessPlan;
+
+static XnUInt32 XnAudioLosslessChecksum(const XnUInt8* pData, XnUInt32 nSize)
+{
+	XnUInt32 nChecksum = 2166136261U;
+	const XnUInt16* pSamples = (const XnUInt16*)pData;
+	for (XnUInt32 i = 0; i < nSize / sizeof(XnUInt16); ++i)
+	{
+		nChecksum = (nChecksum ^ pSamples[i]) * 16777619U;
+	}
+	for (XnUInt32 i = nSize & ~1U; i < nSize; ++i)
+	{
+		nChecksum = (nChecksum ^ pData[i]) * 16777619U;
+	}
+	return nChecksum;
+}
+
+static inline XnUInt32 XnAudioLosslessZigzag(XnInt32 nResidual)
+{
+	return ((XnUInt32)nResidual << 1) ^ (XnUInt32)(nResidual >> 31);
+}
+
+/* Residuals of the fixed polynomial predictors of orders 0 to 4, as in FLAC. */
+static void XnAudioLosslessFixedResiduals(const XnInt16* pSamples, XnUInt32 nSamples, XnUInt32 nOrder, XnInt32* pResiduals)
+{
+	for (XnUInt32 n = nOrder; n < nSamples; ++n)
+	{
+		const XnInt16* x = pSamples + n;
+		switch (nOrder)
+		{
+		case 0:
+			pResiduals[n] = x[0];
+			break;
+		case 1:
+			pResiduals[n] = x[0] - x[-1];
+			break;
+		case 2:
+			pResiduals[n] = x[0] - 2 * x[-1] + x[-2];
+			break;
+		case 3:
+			pResiduals[n] = x[0] - 3 * x[-1] + 3 * x[-2] - x[-3];
+			break;
+		default:
+			pResiduals[n] = x[0] - 4 * x[-1] + 6 * x[-2] - 4 * x[-3] + x[-4];
+			break;
+		}
+	}
+}
+
+/* Picks the fixed predictor order with the smallest sum of absolute residuals. */
+static XnUInt32 XnAudioLosslessChooseFixedOrder(const XnInt16* pSamples, XnUInt32 nSamples)
+{
+	XnUInt64 anSums[XN_AUDIO_LOSSLESS_MAX_FIXED_ORDER + 1] = { 0 };
+	for (XnUInt32 n = XN_AUDIO_LOSSLESS_MAX_FIXED_ORDER; n < nSamples; ++n)
+	{
+		XnInt32 e0 = pSamples[n];
+		XnInt32 e1 = e0 - pSamples[n - 1];
+		XnInt32 e2 = e1 - (pSamples[n - 1] - pSamples[n - 2]);
+		XnInt32 e3 = e2 - (pSamples[n - 1] - 2 * pSamples[n - 2] + pSamples[n - 3]);
+		XnInt32 e4 = e3 - (pSamples[n - 1] - 3 * pSamples[n - 2] + 3 * pSamples[n - 3] - pSamples[n - 4]);
+		anSums[0] += abs(e0);
+		anSums[1] += abs(e1);
+		anSums[2] += abs(e2);
+		anSums[3] += abs(e3);
+		anSums[4] += abs(e4);
+	}
+
+	XnUInt32 nBest = 0;
+	for (XnUInt32 i = 1; i <= XN_AUDIO_LOSSLESS_MAX_FIXED_ORDER; ++i)
+	{
+		if (anSums[i] < anSums[nBest])
+		{
+			nBest = i;
+		}
+	}
+	return nBest;
+}
+
+/*
+* Finds linear prediction coefficients with the autocorrelation method (Welch window, Levinson-Durbin), and
+* quantizes them. Returns FALSE if the signal can't be predicted this way (e.g. silence).
+*/
+static XnBool XnAudioLosslessComputeLpc(const XnInt16* pSamples, XnUInt32 nSamples, XnDouble* pWindowed, XnAudioLosslessPlan* pPlan)
+{
+	const XnUInt32 nOrder = XN_AUDIO_LOSSLESS_LPC_ORDER;
+	if (nSamples <= nOrder * 2)
+	{
+		return FALSE;
+	}
+
+	XnDouble dHalf = (nSamples - 1) / 2.0;
+	XnDouble dScale = (nSamples + 1) / 2.0;
+	for (XnUInt32 i = 0; i < nSamples; ++i)
+	{
+		XnDouble w = (i - dHalf) / dScale;
+		pWindowed[i] = pSamples[i] * (1.0 - w * w);
+	}
+
+	XnDouble adAutocorrelation[XN_AUDIO_LOSSLESS_LPC_ORDER + 1];
+	for (XnUInt32 nLag = 0; nLag <= nOrder; ++nLag)
+	{
+		XnDouble dSum = 0;
+		for (XnUInt32 i = nLag; i < nSamples; ++i)
+		{
+			dSum += pWindowed[i] * pWindowed[i - nLag];
+		}
+		adAutocorrelation[nLag] = dSum;
+	}
+
+	if (adAutocorrelation[0] <= 0)
+	{
+		return FALSE;
+	}
+
+	// a tiny bit of white noise keeps the recursion stable on perfectly predictable signals
+	adAutocorrelation[0] *= 1.0 + 1e-9;
+
+	XnDouble adCoeffs[XN_AUDIO_LOSSLESS_LPC_ORDER] = { 0 };
+	XnDouble dError = adAutocorrelation[0];
+	for (XnUInt32 i = 0; i < nOrder; ++i)
+	{
+		XnDouble dAcc = adAutocorrelation[i + 1];
+		for (XnUInt32 j = 0; j < i; ++j)
+		{
+			dAcc -= adCoeffs[j] * adAutocorrelation[i - j];
+		}
+		XnDouble dReflection = dAcc / dError;
+
+		XnDouble adPrevious[XN_AUDIO_LOSSLESS_LPC_ORDER];
+		xnOSMemCopy(adPrevious, adCoeffs, sizeof(adCoeffs));
+		for (XnUInt32 j = 0; j < i; ++j)
+		{
+			adCoeffs[j] = adPrevious[j] - dReflection * adPrevious[i - 1 - j];
+		}
+		adCoeffs[i] = dReflection;
+
+		dError *= (1.0 - dReflection * dReflection);
+		if (dError <= 0)
+		{
+			return FALSE;
+		}
+	}
+
+	XnDouble dMax = 0;
+	for (XnUInt32 i = 0; i < nOrder; ++i)
+	{
+		dMax = XN_MAX(dMax, fabs(adCoeffs[i]));
+	}
+
+	const XnInt32 nMaxCoeff = (1 << (XN_AUDIO_LOSSLESS_LPC_PRECISION - 1)) - 1;
+	XnInt32 nShift = XN_AUDIO_LOSSLESS_MAX_LPC_SHIFT;
+	while (nShift >= 0 && dMax * (1 << nShift) > nMaxCoeff)
+	{
+		nShift--;
+	}
+	if (nShift < 0)
+	{
+		return FALSE;
+	}
+
+	// carrying the rounding error over to the next coefficient keeps the filter's response closer
+	XnDouble dCarry = 0;
+	for (XnUInt32 i = 0; i < nOrder; ++i)
+	{
+		XnDouble dScaled = adCoeffs[i] * (1 << nShift) + dCarry;
+		XnInt32 nCoeff = (XnInt32)floor(dScaled + 0.5);
+		nCoeff = XN_MAX(-nMaxCoeff - 1, XN_MIN(nMaxCoeff, nCoeff));
+		dCarry = dScaled - nCoeff;
+		pPlan->anCoeffs[i] = nCoeff;
+	}
+
+	pPlan->nPredictor = XN_AUDIO_LOSSLESS_PREDICTOR_LPC;
+	pPlan->nOrder = nOrder;
+	pPlan->nShift = (XnUInt32)nShift;
+	return TRUE;
+}
+
+static inline XnInt32 XnAudioLosslessLpcPredict(const XnInt16* pSamples, XnUInt32 n, const XnInt32* anCoeffs, XnUInt32 nOrder, XnUInt32 nShift)
+{
+	XnInt32 nSum = 0;
+	for (XnUInt32 i = 0; i < nOrder; ++i)
+	{
+		nSum += anCoeffs[i] * pSamples[n - 1 - i];
+	}
+	return nSum >> nShift;
+}
+
+/*
+* Residuals of a linear predictor. The predictions of all samples only depend on the input, so 8 of them are
+* made at once: pairs of neighboring samples are multiplied by pairs of coefficients and summed in one step.
+*/
+static void XnAudioLosslessLpcResiduals(const XnInt16* pSamples, XnUInt32 nSamples, const XnAudioLosslessPlan& plan, XnInt32* pResiduals)
+{
+	XnUInt32 n = plan.nOrder;
+
+#ifdef XN_LOSSLESS_SSE2
+	XnInt32 anCoeffs[XN_AUDIO_LOSSLESS_LPC_ORDER] = { 0 };
+	for (XnUInt32 i = 0; i < plan.nOrder; ++i)
+	{
+		anCoeffs[i] = plan.anCoeffs[i];
+	}
+
+	__m128i aCoeffPairs[XN_AUDIO_LOSSLESS_LPC_ORDER / 2];
+	for (XnUInt32 j = 0; j < XN_AUDIO_LOSSLESS_LPC_ORDER / 2; ++j)
+	{
+		aCoeffPairs[j] = _mm_set1_epi32((XnInt32)((anCoeffs[2 * j] & 0xFFFF) | ((XnUInt32)anCoeffs[2 * j + 1] << 16)));
+	}
+	const __m128i shift = _mm_cvtsi32_si128((XnInt32)plan.nShift);
+
+	for (; n < XN_AUDIO_LOSSLESS_LPC_ORDER && n < nSamples; ++n)
+	{
+		pResiduals[n] = pSamples[n] - XnAudioLosslessLpcPredict(pSamples, n, plan.anCoeffs, plan.nOrder, plan.nShift);
+	}
+
+	for (; n + 8 <= nSamples; n += 8)
+	{
+		__m128i sumLow = _mm_setzero_si128();
+		__m128i sumHigh = _mm_setzero_si128();
+		for (XnUInt32 j = 0; j < XN_AUDIO_LOSSLESS_LPC_ORDER / 2; ++j)
+		{
+			// (x[n + k - 1 - 2j], x[n + k - 2 - 2j]) for k = 0..7
+			__m128i newer = _mm_loadu_si128((const __m128i*)(pSamples + n - 1 - 2 * j));
+			__m128i older = _mm_loadu_si128((const __m128i*)(pSamples + n - 2 - 2 * j));
+			sumLow = _mm_add_epi32(sumLow, _mm_madd_epi16(_mm_unpacklo_epi16(newer, older), aCoeffPairs[j]));
+			sumHigh = _mm_add_epi32(sumHigh, _mm_madd_epi16(_mm_unpackhi_epi16(newer, older), aCoeffPairs[j]));
+		}
+
+		__m128i samples = _mm_loadu_si128((const __m128i*)(pSamples + n));
+		__m128i samplesLow = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		__m128i samplesHigh = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+		_mm_storeu_si128((__m128i*)(pResiduals + n), _mm_sub_epi32(samplesLow, _mm_sra_epi32(sumLow, shift)));
+		_mm_storeu_si128((__m128i*)(pResiduals + n + 4), _mm_sub_epi32(samplesHigh, _mm_sra_epi32(sumHigh, shift)));
+	}
+#endif
+
+	for (; n < nSamples; ++n)
+	{
+		pResiduals[n] = pSamples[n] - XnAudioLosslessLpcPredict(pSamples, n, plan.anCoeffs, plan.nOrder, plan.nShift);
+	}
+}
+
+/* Partition i of 2^nPartitionOrder covers samples [i * nSamples >> order, (i + 1) * nSamples >> order). */
+static inline XnUInt32 XnAudioLosslessPartitionStart(XnUInt32 nSamples, XnUInt32 nPartitionOrder, XnUInt32 i)
+{
+	return (XnUInt32)(((XnUInt64)i * nSamples) >> nPartitionOrder);
+}
+
+/* Picks the partitioning and Rice parameters of the residuals, and fills in the number of bits they take. */
+static void XnAudioLosslessPlanRice(const XnInt32* pResiduals, XnUInt32 nSamples, XnAudioLosslessPlan* pPlan)
+{
+	XnUInt32 nMaxOrder = 0;
+	while (nMaxOrder < XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER && (nSamples >> (nMaxOrder + 1)) >= XN_AUDIO_LOSSLESS_MIN_PARTITION_SIZE)
+	{
+		nMaxOrder++;
+	}
+
+	// sums at the finest partitioning, merged pairwise for the coarser ones
+	XnUInt64 anSums[1 << XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER];
+	XnUInt32 anCounts[1 << XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER];
+	for (XnUInt32 i = 0; i < (1U << nMaxOrder); ++i)
+	{
+		XnUInt32 nStart = XN_MAX(XnAudioLosslessPartitionStart(nSamples, nMaxOrder, i), pPlan->nOrder);
+		XnUInt32 nEnd = XnAudioLosslessPartitionStart(nSamples, nMaxOrder, i + 1);
+		anSums[i] = 0;
+		anCounts[i] = (nEnd > nStart) ? nEnd - nStart : 0;
+		for (XnUInt32 n = nStart; n < nEnd; ++n)
+		{
+			anSums[i] += XnAudioLosslessZigzag(pResiduals[n]);
+		}
+	}
+
+	pPlan->nBits = ~0ULL;
+	for (XnInt32 nOrder = (XnInt32)nMaxOrder; nOrder >= 0; --nOrder)
+	{
+		if (nOrder != (XnInt32)nMaxOrder)
+		{
+			for (XnUInt32 i = 0; i < (1U << nOrder); ++i)
+			{
+				anSums[i] = anSums[2 * i] + anSums[2 * i + 1];
+				anCounts[i] = anCounts[2 * i] + anCounts[2 * i + 1];
+			}
+		}
+
+		XnUInt8 anParams[1 << XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER];
+		XnUInt64 nBits = 3;
+		for (XnUInt32 i = 0; i < (1U << nOrder); ++i)
+		{
+			// the best parameter is about log2 of the mean
+			XnUInt32 k = 0;
+			while (k < XN_AUDIO_LOSSLESS_MAX_RICE_PARAM && ((XnUInt64)anCounts[i] << (k + 1)) < anSums[i])
+			{
+				k++;
+			}
+			anParams[i] = (XnUInt8)k;
+			nBits += 5 + (XnUInt64)anCounts[i] * (k + 1) + (anSums[i] >> k);
+		}
+
+		if (nBits < pPlan->nBits)
+		{
+			pPlan->nBits = nBits;
+			pPlan->nPartitionOrder = (XnUInt32)nOrder;
+			xnOSMemCopy(pPlan->anRiceParams, anParams, sizeof(anParams));
+		}
+	}
+}
+
+static void XnAudioLosslessComputeResiduals(const XnInt16* pSamples, XnUInt32 nSamples, const XnAudioLosslessPlan& plan, XnInt32* pResiduals)
+{
+	if (plan.nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_LPC)
+	{
+		XnAudioLosslessLpcResiduals(pSamples, nSamples, plan, pResiduals);
+	}
+	else
+	{
+		XnAudioLosslessFixedResiduals(pSamples, nSamples, plan.nOrder, pResiduals);
+	}
+}
+
+/* Finds the cheapest way to code a channel. pResiduals and pWindowed are scratch space. */
+static void XnAudioLosslessPlanChannel(const XnInt16* pSamples, XnUInt32 nSamples, XnInt32* pResiduals, XnDouble* pWindowed, XnAudioLosslessPlan* pPlan)
+{
+	// verbatim is the fallback, at 16 bits a sample
+	pPlan->nPredictor = XN_AUDIO_LOSSLESS_PREDICTOR_VERBATIM;
+	pPlan->nOrder = 0;
+	pPlan->nBits = (XnUInt64)nSamples * 16;
+
+	XnAudioLosslessPlan candidate;
+	xnOSMemSet(&candidate, 0, sizeof(candidate));
+	candidate.nPredictor = XN_AUDIO_LOSSLESS_PREDICTOR_FIXED;
+	candidate.nOrder = XN_MIN(XnAudioLosslessChooseFixedOrder(pSamples, nSamples), nSamples);
+	XnAudioLosslessComputeResiduals(pSamples, nSamples, candidate, pResiduals);
+	XnAudioLosslessPlanRice(pResiduals, nSamples, &candidate);
+	candidate.nBits += 3 + candidate.nOrder * 16;
+	if (candidate.nBits < pPlan->nBits)
+	{
+		*pPlan = candidate;
+	}
+
+	if (XnAudioLosslessComputeLpc(pSamples, nSamples, pWindowed, &candidate))
+	{
+		XnAudioLosslessComputeResiduals(pSamples, nSamples, candidate, pResiduals);
+		XnAudioLosslessPlanRice(pResiduals, nSamples, &candidate);
+		candidate.nBits += 7 + candidate.nOrder * (XN_AUDIO_LOSSLESS_LPC_PRECISION + 16);
+		if (candidate.nBits < pPlan->nBits)
+		{
+			*pPlan = candidate;
+		}
+	}
+}
+
+static XnBool XnAudioLosslessWriteChannel(XnRawBitWriter* pWriter, const XnInt16* pSamples, XnUInt32 nSamples, const XnAudioLosslessPlan& plan, XnInt32* pResiduals)
+{
+	XnBool bOK = xnRawBitWriterPut(pWriter, plan.nPredictor, 2);
+	if (plan.nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_VERBATIM)
+	{
+		for (XnUInt32 n = 0; n < nSamples && bOK; ++n)
+		{
+			bOK = xnRawBitWriterPut(pWriter, (XnUInt16)pSamples[n], 16);
+		}
+		return bOK;
+	}
+
+	if (plan.nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_FIXED)
+	{
+		bOK = bOK && xnRawBitWriterPut(pWriter, plan.nOrder, 3);
+	}
+	else
+	{
+		bOK = bOK && xnRawBitWriterPut(pWriter, plan.nOrder - 1, 3);
+		bOK = bOK && xnRawBitWriterPut(pWriter, plan.nShift, 4);
+		for (XnUInt32 i = 0; i < plan.nOrder; ++i)
+		{
+			bOK = bOK && xnRawBitWriterPut(pWriter, (XnUInt32)plan.anCoeffs[i] & ((1 << XN_AUDIO_LOSSLESS_LPC_PRECISION) - 1), XN_AUDIO_LOSSLESS_LPC_PRECISION);
+		}
+	}
+
+	for (XnUInt32 n = 0; n < plan.nOrder && n < nSamples; ++n)
+	{
+		bOK = bOK && xnRawBitWriterPut(pWriter, (XnUInt16)pSamples[n], 16);
+	}
+
+	XnAudioLosslessComputeResiduals(pSamples, nSamples, plan, pResiduals);
+
+	bOK = bOK && xnRawBitWriterPut(pWriter, plan.nPartitionOrder, 3);
+	for (XnUInt32 i = 0; i < (1U << plan.nPartitionOrder) && bOK; ++i)
+	{
+		XnUInt32 k = plan.anRiceParams[i];
+		bOK = xnRawBitWriterPut(pWriter, k, 5);
+
+		XnUInt32 nStart = XN_MAX(XnAudioLosslessPartitionStart(nSamples, plan.nPartitionOrder, i), plan.nOrder);
+		XnUInt32 nEnd = XnAudioLosslessPartitionStart(nSamples, plan.nPartitionOrder, i + 1);
+		for (XnUInt32 n = nStart; n < nEnd && bOK; ++n)
+		{
+			XnUInt32 nValue = XnAudioLosslessZigzag(pResiduals[n]);
+			XnUInt32 nQuotient = nValue >> k;
+			if (nQuotient < XN_AUDIO_LOSSLESS_RICE_ESCAPE)
+			{
+				bOK = xnRawBitWriterPut(pWriter, 1U << nQuotient, nQuotient + 1);
+				if (k != 0)
+				{
+					bOK = bOK && xnRawBitWriterPut(pWriter, nValue & ((1U << k) - 1), k);
+				}
+			}
+			else
+			{
+				bOK = xnRawBitWriterPut(pWriter, 1U << XN_AUDIO_LOSSLESS_RICE_ESCAPE, XN_AUDIO_LOSSLESS_RICE_ESCAPE + 1);
+				bOK = bOK && xnRawBitWriterPut(pWriter, nValue, 32);
+			}
+		}
+	}
+
+	return bOK;
+}
+
+/* Returns the size of the coded frame, or 0 if it doesn't fit in nCapacity. */
+static XnUInt32 XnAudioLosslessEncode(const XnUInt8* pInput, XnUInt32 nSamples, XnUInt32 nChannels, XnInt16* pChannels, XnInt16* pDifferences, XnInt32* pResiduals, XnDouble* pWindowed, XnUInt8* pOutput, XnUInt32 nCapacity)
+{
+	const XnUInt8* pOutputEnd = pOutput + nCapacity;
+	XnUInt8* pBitsStart = pOutput + sizeof(XnAudioLosslessHeader);
+	if (pBitsStart > pOutputEnd)
+	{
+		return 0;
+	}
+
+	const XnUInt16* pInterleaved = (const XnUInt16*)pInput;
+	for (XnUInt32 c = 0; c < nChannels; ++c)
+	{
+		XnInt16* pChannel = pChannels + c * nSamples;
+		for (XnUInt32 n = 0; n < nSamples; ++n)
+		{
+			pChannel[n] = (XnInt16)XN_PREPARE_VAR16_IN_BUFFER(pInterleaved[n * nChannels + c]);
+		}
+	}
+
+	XnRawBitWriter writer;
+	xnRawBitWriterInit(&writer, pBitsStart, pOutputEnd);
+
+	for (XnUInt32 c = 0; c < nChannels; ++c)
+	{
+		const XnInt16* pChannel = pChannels + c * nSamples;
+		XnAudioLosslessPlan plan;
+		XnAudioLosslessPlanChannel(pChannel, nSamples, pResiduals, pWindowed, &plan);
+
+		// neighboring microphones hear much the same, so a channel may be cheaper as the difference from the
+		// one before it. It must fit in 16 bits, like the samples themselves.
+		XnBool bDifference = FALSE;
+		if (c > 0)
+		{
+			const XnInt16* pPrevious = pChannels + (c - 1) * nSamples;
+			XnBool bFits = TRUE;
+			for (XnUInt32 n = 0; n < nSamples && bFits; ++n)
+			{
+				XnInt32 nDifference = pChannel[n] - pPrevious[n];
+				bFits = (nDifference >= -32768 && nDifference <= 32767);
+				pDifferences[n] = (XnInt16)nDifference;
+			}
+
+			XnAudioLosslessPlan differencePlan;
+			if (bFits)
+			{
+				XnAudioLosslessPlanChannel(pDifferences, nSamples, pResiduals, pWindowed, &differencePlan);
+				if (differencePlan.nBits < plan.nBits)
+				{
+					plan = differencePlan;
+					bDifference = TRUE;
+				}
+			}
+
+			if (!xnRawBitWriterPut(&writer, bDifference, 1))
+			{
+				return 0;
+			}
+		}
+
+		if (!XnAudioLosslessWriteChannel(&writer, bDifference ? pDifferences : pChannel, nSamples, plan, pResiduals))
+		{
+			return 0;
+		}
+	}
+
+	XnUInt8* pEnd = xnRawBitWriterFlush(&writer);
+	if (pEnd == NULL)
+	{
+		return 0;
+	}
+
+	return (XnUInt32)(pEnd - pOutput);
+}
+
+XnStatus XnStreamCompressAudioLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt32 nChannels, XnUInt32 nBitsPerSample, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	XnUInt32 nRawSize = sizeof(XnAudioLosslessHeader) + nInputSize;
+	if (nRawSize > *pnOutputSize)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small for %u bytes", nInputSize);
+	}
+
+	XnAudioLosslessHeader* pHeader = (XnAudioLosslessHeader*)pOutput;
+	pHeader->nMode = XN_AUDIO_LOSSLESS_MODE_LPC;
+	pHeader->nChannels = (XnUInt8)nChannels;
+	pHeader->nBitsPerSample = (XnUInt8)nBitsPerSample;
+	pHeader->nReserved = 0;
+	pHeader->nSize = XN_PREPARE_VAR32_IN_BUFFER(nInputSize);
+	pHeader->nChecksum = XN_PREPARE_VAR32_IN_BUFFER(XnAudioLosslessChecksum(pInput, nInputSize));
+
+	// only 16 bit samples are predicted. Anything else is stored as is.
+	XnUInt32 nSize = 0;
+	if (nInputSize != 0 && nBitsPerSample == 16 && nChannels != 0 && nChannels <= 0xFF && nInputSize % (nChannels * sizeof(XnInt16)) == 0)
+	{
+		XnUInt32 nSamples = nInputSize / (nChannels * sizeof(XnInt16));
+		XnInt16* pChannels = (XnInt16*)xnOSMalloc(nInputSize + nSamples * sizeof(XnInt16));
+		XnInt32* pResiduals = (XnInt32*)xnOSMalloc(nSamples * sizeof(XnInt32));
+		XnDouble* pWindowed = (XnDouble*)xnOSMalloc(nSamples * sizeof(XnDouble));
+		if (pChannels == NULL || pResiduals == NULL || pWindowed == NULL)
+		{
+			xnOSFree(pChannels);
+			xnOSFree(pResiduals);
+			xnOSFree(pWindowed);
+			return (XN_STATUS_ALLOC_FAILED);
+		}
+
+		nSize = XnAudioLosslessEncode(pInput, nSamples, nChannels, pChannels, pChannels + nChannels * nSamples, pResiduals, pWindowed, pOutput, nRawSize);
+
+		xnOSFree(pChannels);
+		xnOSFree(pResiduals);
+		xnOSFree(pWindowed);
+	}
+
+	// never bigger than the raw data
+	if (nSize == 0)
+	{
+		pHeader->nMode = XN_AUDIO_LOSSLESS_MODE_RAW;
+		xnOSMemCopy(pOutput + sizeof(XnAudioLosslessHeader), pInput, nInputSize);
+		nSize = nRawSize;
+	}
+
+	*pnOutputSize = nSize;
+	return (XN_STATUS_OK);
+}
+
+static void XnAudioLosslessReadChannel(XnRawBitReader* pReader, XnInt16* pSamples, XnUInt32 nSamples, XnBool* pbValid)
+{
+	XnUInt32 nPredictor = xnRawBitReaderGet(pReader, 2);
+	if (nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_VERBATIM)
+	{
+		for (XnUInt32 n = 0; n < nSamples; ++n)
+		{
+			pSamples[n] = (XnInt16)xnRawBitReaderGet(pReader, 16);
+		}
+		return;
+	}
+
+	XnAudioLosslessPlan plan;
+	plan.nPredictor = nPredictor;
+	plan.nShift = 0;
+	if (nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_FIXED)
+	{
+		plan.nOrder = xnRawBitReaderGet(pReader, 3);
+	}
+	else if (nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_LPC)
+	{
+		plan.nOrder = xnRawBitReaderGet(pReader, 3) + 1;
+		plan.nShift = xnRawBitReaderGet(pReader, 4);
+		for (XnUInt32 i = 0; i < plan.nOrder; ++i)
+		{
+			// sign extend
+			XnInt32 nCoeff = (XnInt32)(xnRawBitReaderGet(pReader, XN_AUDIO_LOSSLESS_LPC_PRECISION) << (32 - XN_AUDIO_LOSSLESS_LPC_PRECISION));
+			plan.anCoeffs[i] = nCoeff >> (32 - XN_AUDIO_LOSSLESS_LPC_PRECISION);
+		}
+	}
+	else
+	{
+		*pbValid = FALSE;
+		return;
+	}
+
+	if (plan.nOrder > XN_AUDIO_LOSSLESS_LPC_ORDER || (nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_FIXED && plan.nOrder > XN_AUDIO_LOSSLESS_MAX_FIXED_ORDER) || plan.nOrder > nSamples)
+	{
+		*pbValid = FALSE;
+		return;
+	}
+
+	for (XnUInt32 n = 0; n < plan.nOrder; ++n)
+	{
+		pSamples[n] = (XnInt16)xnRawBitReaderGet(pReader, 16);
+	}
+
+	XnUInt32 nPartitionOrder = xnRawBitReaderGet(pReader, 3);
+	if (nPartitionOrder > XN_AUDIO_LOSSLESS_MAX_PARTITION_ORDER)
+	{
+		*pbValid = FALSE;
+		return;
+	}
+
+	for (XnUInt32 i = 0; i < (1U << nPartitionOrder); ++i)
+	{
+		XnUInt32 k = xnRawBitReaderGet(pReader, 5);
+		if (k > XN_AUDIO_LOSSLESS_MAX_RICE_PARAM)
+		{
+			*pbValid = FALSE;
+			return;
+		}
+
+		XnUInt32 nStart = XN_MAX(XnAudioLosslessPartitionStart(nSamples, nPartitionOrder, i), plan.nOrder);
+		XnUInt32 nEnd = XnAudioLosslessPartitionStart(nSamples, nPartitionOrder, i + 1);
+		for (XnUInt32 n = nStart; n < nEnd; ++n)
+		{
+			XnUInt32 nValue = xnRawBitReaderGetUnary(pReader, XN_AUDIO_LOSSLESS_RICE_ESCAPE);
+			if (nValue < XN_AUDIO_LOSSLESS_RICE_ESCAPE)
+			{
+				nValue = (nValue << k) | xnRawBitReaderGet(pReader, k);
+			}
+			else
+			{
+				nValue = xnRawBitReaderGet(pReader, 32);
+			}
+
+			XnInt32 nResidual = (XnInt32)(nValue >> 1) ^ -(XnInt32)(nValue & 1);
+			XnInt32 nPrediction;
+			if (nPredictor == XN_AUDIO_LOSSLESS_PREDICTOR_LPC)
+			{
+				nPrediction = XnAudioLosslessLpcPredict(pSamples, n, plan.anCoeffs, plan.nOrder, plan.nShift);
+			}
+			else
+			{
+				const XnInt16* x = pSamples + n;
+				switch (plan.nOrder)
+				{
+				case 0: nPrediction = 0; break;
+				case 1: nPrediction = x[-1]; break;
+				case 2: nPrediction = 2 * x[-1] - x[-2]; break;
+				case 3: nPrediction = 3 * x[-1] - 3 * x[-2] + x[-3]; break;
+				default: nPrediction = 4 * x[-1] - 6 * x[-2] + 4 * x[-3] - x[-4]; break;
+				}
+			}
+
+			pSamples[n] = (XnInt16)(XnUInt32)((XnUInt32)nPrediction + (XnUInt32)nResidual);
+		}
+	}
+}
+
+XnStatus XnStreamUncompressAudioLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize)
+{
+	XN_VALIDATE_INPUT_PTR(pInput);
+	XN_VALIDATE_INPUT_PTR(pOutput);
+	XN_VALIDATE_INPUT_PTR(pnOutputSize);
+
+	if (nInputSize < sizeof(XnAudioLosslessHeader))
+	{
+		xnLogError(XN_MASK_STREAM_COMPRESSION, "Input size too small");
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	const XnAudioLosslessHeader* pHeader = (const XnAudioLosslessHeader*)pInput;
+	const XnUInt8* pData = pInput + sizeof(XnAudioLosslessHeader);
+	XnUInt32 nDataSize = nInputSize - sizeof(XnAudioLosslessHeader);
+	XnUInt32 nChannels = pHeader->nChannels;
+	XnUInt32 nSize = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nSize);
+	XnUInt32 nChecksum = XN_PREPARE_VAR32_IN_BUFFER(pHeader->nChecksum);
+
+	if (nSize > *pnOutputSize)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, XN_MASK_STREAM_COMPRESSION, "Output buffer too small for %u bytes", nSize);
+	}
+
+	if (pHeader->nMode == XN_AUDIO_LOSSLESS_MODE_RAW)
+	{
+		if (nDataSize < nSize)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Raw audio is truncated");
+		}
+		xnOSMemCopy(pOutput, pData, nSize);
+	}
+	else
+	{
+		if (pHeader->nMode != XN_AUDIO_LOSSLESS_MODE_LPC || pHeader->nBitsPerSample != 16 || nChannels == 0 || nSize % (nChannels * sizeof(XnInt16)) != 0)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Invalid lossless audio header");
+		}
+
+		XnUInt32 nSamples = nSize / (nChannels * sizeof(XnInt16));
+		XnInt16* pChannels = (XnInt16*)xnOSMalloc(2 * nSamples * sizeof(XnInt16) + 1);
+		XN_VALIDATE_ALLOC_PTR(pChannels);
+		XnInt16* apChannels[2] = { pChannels, pChannels + nSamples };
+
+		XnRawBitReader reader;
+		xnRawBitReaderInit(&reader, pData, pData + nDataSize);
+
+		XnBool bValid = TRUE;
+		XnUInt16* pInterleaved = (XnUInt16*)pOutput;
+		for (XnUInt32 c = 0; c < nChannels && bValid; ++c)
+		{
+			XnInt16* pChannel = apChannels[c & 1];
+			XnBool bDifference = (c > 0) && xnRawBitReaderGet(&reader, 1);
+			XnAudioLosslessReadChannel(&reader, pChannel, nSamples, &bValid);
+
+			const XnInt16* pPrevious = apChannels[(c + 1) & 1];
+			for (XnUInt32 n = 0; n < nSamples; ++n)
+			{
+				if (bDifference)
+				{
+					pChannel[n] = (XnInt16)(pChannel[n] + pPrevious[n]);
+				}
+				pInterleaved[n * nChannels + c] = XN_PREPARE_VAR16_IN_BUFFER((XnUInt16)pChannel[n]);
+			}
+		}
+
+		xnOSFree(pChannels);
+
+		if (!bValid || xnRawBitReaderOverrun(&reader))
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Lossless audio is corrupt");
+		}
+	}
+
+	if (XnAudioLosslessChecksum(pOutput, nSize) != nChecksum)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_STREAM_COMPRESSION, "Lossless audio checksum mismatch");
+	}
+
+	*pnOutputSize = nSize;
+	return (XN_STATUS_OK);
+}
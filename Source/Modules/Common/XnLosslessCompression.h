@@ -0,0 +1,95 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_LOSSLESS_COMPRESSION_H_
+#define _XN_LOSSLESS_COMPRESSION_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include <XnTypes.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_STREAM_COMPRESSION_DEPTH16Z_WORSE_RATIO 1.333F
+#define XN_STREAM_COMPRESSION_IMAGE8Z_WORSE_RATIO 1.333F
+#define XN_STREAM_COMPRESSION_CONF4_WORSE_RATIO 0.51F
+/** Entropy coded depth falls back to storing frames as is, behind a small header. */
+#define XN_STREAM_COMPRESSION_DEPTH16Z_ANS_WORSE_RATIO 1.0F
+#define XN_STREAM_COMPRESSION_DEPTH16Z_ANS_OVERHEAD 16
+/** So do lossless images. Grayscale 16 images are depth frames behind a second header. */
+#define XN_STREAM_COMPRESSION_IMAGE_LOSSLESS_WORSE_RATIO 1.0F
+#define XN_STREAM_COMPRESSION_IMAGE_LOSSLESS_OVERHEAD 32
+/** And so does lossless audio. */
+#define XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_WORSE_RATIO 1.0F
+#define XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_OVERHEAD 16
+/** Every coded sample takes at least a bit, so a 16 bit sample frame decodes to at most this many times its size. */
+#define XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_MAX_EXPANSION 16
+
+//---------------------------------------------------------------------------
+// Functions Declaration
+//---------------------------------------------------------------------------
+XnStatus XnStreamCompressDepth16Z(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamCompressDepth16ZWithEmbTable(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize, XnUInt16 nMaxValue);
+XnStatus XnStreamUncompressDepth16Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamUncompressDepth16ZWithEmbTable(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize);
+
+/**
+* Compresses a depth map with a median edge predictor and a rANS entropy coder. Unlike the other functions
+* here, *pnOutputSize must hold the size of the output buffer, which must have room for the raw frame plus
+* XN_STREAM_COMPRESSION_DEPTH16Z_ANS_OVERHEAD bytes.
+*
+* @param	nWidth	[in]	Number of pixels in a row. Predictions along columns need it.
+*/
+XnStatus XnStreamCompressDepth16ZAns(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt32 nWidth, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamUncompressDepth16ZAns(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize);
+
+XnStatus XnStreamCompressImage8Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamUncompressImage8Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+
+/**
+* Compresses an image losslessly. RGB is split into planes of G, R - G and B - G, and YUV422 into planes of
+* Y, U and V. Each sample is predicted from its neighbors in its plane, and the residuals are entropy coded.
+* Supports RGB24, YUV422, grayscale 8 and grayscale 16. As with depth, *pnOutputSize must hold the size of the
+* output buffer, which must have room for the raw image plus XN_STREAM_COMPRESSION_IMAGE_LOSSLESS_OVERHEAD bytes.
+*
+* @param	nWidth	[in]	Number of pixels in a row.
+*/
+XnStatus XnStreamCompressImageLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnPixelFormat format, XnUInt32 nWidth, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamUncompressImageLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+
+/**
+* Compresses 16 bit audio losslessly. Each channel is predicted by a linear predictor (a fixed polynomial one, or
+* one fitted to the frame), optionally after subtracting the channel before it, and the residuals are Rice coded.
+* Other sample sizes are stored as is. As with depth, *pnOutputSize must hold the size of the output buffer, which
+* must have room for the raw samples plus XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_OVERHEAD bytes.
+*
+* @param	nChannels		[in]	Number of interleaved channels.
+* @param	nBitsPerSample	[in]	Size of a sample.
+*/
+XnStatus XnStreamCompressAudioLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt32 nChannels, XnUInt32 nBitsPerSample, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamUncompressAudioLossless(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+
+XnStatus XnStreamCompressConf4(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+XnStatus XnStreamUncompressConf4(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
+
+#endif //_XN_LOSSLESS_COMPRESSION_H_
@@ -0,0 +1,480 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef _XN_RANS_H_
+#define _XN_RANS_H_
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Symbol probabilities are quantized to this many bits. */
+#define XN_RANS_PROB_BITS		12
+#define XN_RANS_PROB_SCALE		(1 << XN_RANS_PROB_BITS)
+/** Lower bound of the coder state. States are kept in [L, 256 * L). */
+#define XN_RANS_STATE_LOW		(1U << 23)
+/** Largest alphabet a context may have. */
+#define XN_RANS_MAX_SYMBOLS		64
+/**
+* Number of coder states that take turns encoding consecutive symbols. Decoding a symbol only depends
+* on the state of its own lane, so the lanes overlap in the CPU pipeline.
+*/
+#define XN_RANS_LANES			4
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/* Everything needed to encode a symbol without dividing by its frequency. */
+typedef struct XnRansEncSymbol
+{
+	XnUInt32 nMax;
+	XnUInt32 nRcpFreq;
+	XnUInt32 nBias;
+	XnUInt16 nCmplFreq;
+	XnUInt16 nRcpShift;
+} XnRansEncSymbol;
+
+/*
+* Frequencies of the symbols of one context, normalized to sum to XN_RANS_PROB_SCALE. A context that never
+* occurs has all frequencies 0.
+*/
+typedef struct XnRansModel
+{
+	XnUInt32 nSymbols;
+	XnUInt16 anFreqs[XN_RANS_MAX_SYMBOLS];
+} XnRansModel;
+
+/* Maps each of the XN_RANS_PROB_SCALE slots of a context to its symbol. */
+typedef struct XnRansDecTable
+{
+	XnUInt8 aSymbols[XN_RANS_PROB_SCALE];
+	XnUInt16 anFreqs[XN_RANS_MAX_SYMBOLS];
+	XnUInt16 anStarts[XN_RANS_MAX_SYMBOLS];
+} XnRansDecTable;
+
+//---------------------------------------------------------------------------
+// Model
+//---------------------------------------------------------------------------
+/** Quantizes symbol counts to frequencies. Every symbol that occurred gets a frequency of at least 1. */
+inline void xnRansModelBuild(XnRansModel* pModel, const XnUInt32* anCounts, XnUInt32 nSymbols)
+{
+	XnUInt64 nTotal = 0;
+	pModel->nSymbols = 0;
+	for (XnUInt32 i = 0; i < nSymbols; ++i)
+	{
+		nTotal += anCounts[i];
+		if (anCounts[i] != 0)
+		{
+			pModel->nSymbols = i + 1;
+		}
+	}
+
+	xnOSMemSet(pModel->anFreqs, 0, sizeof(pModel->anFreqs));
+	if (nTotal == 0)
+	{
+		return;
+	}
+
+	XnInt32 nSum = 0;
+	XnUInt32 nLargest = 0;
+	for (XnUInt32 i = 0; i < pModel->nSymbols; ++i)
+	{
+		if (anCounts[i] != 0)
+		{
+			XnUInt32 nFreq = (XnUInt32)((XnUInt64)anCounts[i] * XN_RANS_PROB_SCALE / nTotal);
+			pModel->anFreqs[i] = (XnUInt16)(nFreq == 0 ? 1 : nFreq);
+			nSum += pModel->anFreqs[i];
+			if (anCounts[i] > anCounts[nLargest])
+			{
+				nLargest = i;
+			}
+		}
+	}
+
+	// rounding leaves the sum a little off. The most frequent symbol absorbs the difference when it can,
+	// since that costs the least.
+	XnInt32 nDiff = XN_RANS_PROB_SCALE - nSum;
+	if (nDiff >= 0 || pModel->anFreqs[nLargest] + nDiff >= 1)
+	{
+		pModel->anFreqs[nLargest] = (XnUInt16)(pModel->anFreqs[nLargest] + nDiff);
+		return;
+	}
+
+	while (nDiff < 0)
+	{
+		XnUInt32 nMax = 0;
+		for (XnUInt32 i = 0; i < pModel->nSymbols; ++i)
+		{
+			if (pModel->anFreqs[i] > pModel->anFreqs[nMax])
+			{
+				nMax = i;
+			}
+		}
+
+		XnInt32 nTake = XN_MIN(-nDiff, pModel->anFreqs[nMax] - 1);
+		pModel->anFreqs[nMax] = (XnUInt16)(pModel->anFreqs[nMax] - nTake);
+		nDiff += nTake;
+	}
+}
+
+/** Gets the number of bytes @ref xnRansModelWrite writes for a model at most. */
+inline XnUInt32 xnRansModelMaxSize()
+{
+	return 1 + XN_RANS_MAX_SYMBOLS * 2;
+}
+
+/** Writes a model as its number of symbols followed by each frequency in one byte (below 128) or two. */
+inline XnUInt8* xnRansModelWrite(const XnRansModel* pModel, XnUInt8* pOutput)
+{
+	*pOutput++ = (XnUInt8)pModel->nSymbols;
+	for (XnUInt32 i = 0; i < pModel->nSymbols; ++i)
+	{
+		XnUInt16 nFreq = pModel->anFreqs[i];
+		if (nFreq < 0x80)
+		{
+			*pOutput++ = (XnUInt8)nFreq;
+		}
+		else
+		{
+			*pOutput++ = (XnUInt8)(0x80 | (nFreq >> 8));
+			*pOutput++ = (XnUInt8)(nFreq & 0xFF);
+		}
+	}
+
+	return pOutput;
+}
+
+/** Reads a model written by @ref xnRansModelWrite. Returns NULL if the input is corrupt. */
+inline const XnUInt8* xnRansModelRead(XnRansModel* pModel, XnUInt32 nMaxSymbols, const XnUInt8* pInput, const XnUInt8* pInputEnd)
+{
+	if (pInput >= pInputEnd || *pInput > nMaxSymbols)
+	{
+		return NULL;
+	}
+
+	xnOSMemSet(pModel->anFreqs, 0, sizeof(pModel->anFreqs));
+	pModel->nSymbols = *pInput++;
+
+	XnUInt32 nSum = 0;
+	for (XnUInt32 i = 0; i < pModel->nSymbols; ++i)
+	{
+		if (pInput >= pInputEnd)
+		{
+			return NULL;
+		}
+
+		XnUInt16 nFreq = *pInput++;
+		if ((nFreq & 0x80) != 0)
+		{
+			if (pInput >= pInputEnd)
+			{
+				return NULL;
+			}
+			nFreq = (XnUInt16)(((nFreq & 0x7F) << 8) | *pInput++);
+		}
+
+		pModel->anFreqs[i] = nFreq;
+		nSum += nFreq;
+	}
+
+	// a context that never occurs has no frequencies at all
+	if (nSum != XN_RANS_PROB_SCALE && !(nSum == 0 && pModel->nSymbols == 0))
+	{
+		return NULL;
+	}
+
+	return pInput;
+}
+
+//---------------------------------------------------------------------------
+// Encoder
+//---------------------------------------------------------------------------
+inline void xnRansEncSymbolsInit(const XnRansModel* pModel, XnRansEncSymbol* aSymbols)
+{
+	XnUInt32 nStart = 0;
+	for (XnUInt32 i = 0; i < pModel->nSymbols; ++i)
+	{
+		XnUInt32 nFreq = pModel->anFreqs[i];
+		XnRansEncSymbol& symbol = aSymbols[i];
+		symbol.nMax = ((XN_RANS_STATE_LOW >> XN_RANS_PROB_BITS) << 8) * nFreq;
+		symbol.nCmplFreq = (XnUInt16)(XN_RANS_PROB_SCALE - nFreq);
+		if (nFreq < 2)
+		{
+			// x / 1 can't be done with a 32 bit reciprocal. This makes the formula below come out right.
+			symbol.nRcpFreq = ~0U;
+			symbol.nRcpShift = 0;
+			symbol.nBias = nStart + XN_RANS_PROB_SCALE - 1;
+		}
+		else
+		{
+			XnUInt32 nShift = 0;
+			while (nFreq > (1U << nShift))
+			{
+				nShift++;
+			}
+			symbol.nRcpFreq = (XnUInt32)(((1ULL << (nShift + 31)) + nFreq - 1) / nFreq);
+			symbol.nRcpShift = (XnUInt16)(nShift - 1);
+			symbol.nBias = nStart;
+		}
+
+		nStart += nFreq;
+	}
+}
+
+/**
+* Encodes one symbol. Symbols are encoded in reverse order, and bytes are written backwards, ending at the
+* initial value of @a pOutput. Returns FALSE if @a pOutputLimit was reached.
+*/
+inline XnBool xnRansEncPut(XnUInt32* pState, XnUInt8** ppOutput, const XnUInt8* pOutputLimit, const XnRansEncSymbol* pSymbol)
+{
+	XnUInt32 x = *pState;
+	while (x >= pSymbol->nMax)
+	{
+		if (*ppOutput == pOutputLimit)
+		{
+			return FALSE;
+		}
+		*--(*ppOutput) = (XnUInt8)(x & 0xFF);
+		x >>= 8;
+	}
+
+	XnUInt32 q = (XnUInt32)(((XnUInt64)x * pSymbol->nRcpFreq) >> 32) >> pSymbol->nRcpShift;
+	*pState = x + pSymbol->nBias + q * pSymbol->nCmplFreq;
+	return TRUE;
+}
+
+/** Writes the final state, so the decoder can start from it. */
+inline XnBool xnRansEncFlush(XnUInt32 nState, XnUInt8** ppOutput, const XnUInt8* pOutputLimit)
+{
+	if (*ppOutput - pOutputLimit < 4)
+	{
+		return FALSE;
+	}
+
+	*ppOutput -= 4;
+	(*ppOutput)[0] = (XnUInt8)(nState);
+	(*ppOutput)[1] = (XnUInt8)(nState >> 8);
+	(*ppOutput)[2] = (XnUInt8)(nState >> 16);
+	(*ppOutput)[3] = (XnUInt8)(nState >> 24);
+	return TRUE;
+}
+
+//---------------------------------------------------------------------------
+// Decoder
+//---------------------------------------------------------------------------
+inline void xnRansDecTableInit(const XnRansModel* pModel, XnRansDecTable* pTable)
+{
+	// a context that never occurs may still be reached by a corrupt stream. Decode it as symbol 0, and let
+	// the final state check catch it.
+	if (pModel->nSymbols == 0)
+	{
+		xnOSMemSet(pTable->aSymbols, 0, sizeof(pTable->aSymbols));
+		pTable->anFreqs[0] = XN_RANS_PROB_SCALE;
+		pTable->anStarts[0] = 0;
+		return;
+	}
+
+	XnUInt32 nStart = 0;
+	for (XnUInt32 nSymbol = 0; nSymbol < pModel->nSymbols; ++nSymbol)
+	{
+		XnUInt32 nFreq = pModel->anFreqs[nSymbol];
+		pTable->anFreqs[nSymbol] = (XnUInt16)nFreq;
+		pTable->anStarts[nSymbol] = (XnUInt16)nStart;
+		xnOSMemSet(pTable->aSymbols + nStart, nSymbol, nFreq);
+		nStart += nFreq;
+	}
+}
+
+inline XnBool xnRansDecInit(XnUInt32* pState, const XnUInt8** ppInput, const XnUInt8* pInputEnd)
+{
+	if (pInputEnd - *ppInput < 4)
+	{
+		return FALSE;
+	}
+
+	const XnUInt8* p = *ppInput;
+	*pState = p[0] | (p[1] << 8) | (p[2] << 16) | ((XnUInt32)p[3] << 24);
+	*ppInput += 4;
+	return TRUE;
+}
+
+/**
+* Decodes one symbol. An exhausted input is read as zeros, so a corrupt stream can't make the decoder read
+* past its end. Callers check @ref xnRansDecOverrun once they are done.
+*/
+inline XnUInt32 xnRansDecGet(XnUInt32* pState, const XnUInt8** ppInput, const XnUInt8* pInputEnd, const XnRansDecTable* pTable)
+{
+	XnUInt32 x = *pState;
+	XnUInt32 nSlot = x & (XN_RANS_PROB_SCALE - 1);
+	XnUInt32 nSymbol = pTable->aSymbols[nSlot];
+	x = pTable->anFreqs[nSymbol] * (x >> XN_RANS_PROB_BITS) + nSlot - pTable->anStarts[nSymbol];
+	while (x < XN_RANS_STATE_LOW)
+	{
+		x = (x << 8) | (*ppInput < pInputEnd ? **ppInput : 0);
+		(*ppInput)++;
+	}
+
+	*pState = x;
+	return nSymbol;
+}
+
+inline XnBool xnRansDecOverrun(const XnUInt8* pInput, const XnUInt8* pInputEnd)
+{
+	return (pInput > pInputEnd);
+}
+
+//---------------------------------------------------------------------------
+// Raw Bits
+//---------------------------------------------------------------------------
+/* Bits that are not worth modeling (e.g. the low bits of large values) are stored as is, LSB first. */
+typedef struct XnRawBitWriter
+{
+	XnUInt8* pOutput;
+	const XnUInt8* pOutputLimit;
+	XnUInt64 nBits;
+	XnUInt32 nCount;
+} XnRawBitWriter;
+
+inline void xnRawBitWriterInit(XnRawBitWriter* pWriter, XnUInt8* pOutput, const XnUInt8* pOutputLimit)
+{
+	pWriter->pOutput = pOutput;
+	pWriter->pOutputLimit = pOutputLimit;
+	pWriter->nBits = 0;
+	pWriter->nCount = 0;
+}
+
+/** Writes up to 32 bits. Returns FALSE if the output is full. */
+inline XnBool xnRawBitWriterPut(XnRawBitWriter* pWriter, XnUInt32 nValue, XnUInt32 nBits)
+{
+	pWriter->nBits |= (XnUInt64)nValue << pWriter->nCount;
+	pWriter->nCount += nBits;
+	if (pWriter->nCount >= 32)
+	{
+		if (pWriter->pOutputLimit - pWriter->pOutput < 4)
+		{
+			return FALSE;
+		}
+		XnUInt32 nWord = (XnUInt32)pWriter->nBits;
+		pWriter->pOutput[0] = (XnUInt8)(nWord);
+		pWriter->pOutput[1] = (XnUInt8)(nWord >> 8);
+		pWriter->pOutput[2] = (XnUInt8)(nWord >> 16);
+		pWriter->pOutput[3] = (XnUInt8)(nWord >> 24);
+		pWriter->pOutput += 4;
+		pWriter->nBits >>= 32;
+		pWriter->nCount -= 32;
+	}
+
+	return TRUE;
+}
+
+/** Writes the last partial bytes. Returns the end of the output, or NULL if the output is full. */
+inline XnUInt8* xnRawBitWriterFlush(XnRawBitWriter* pWriter)
+{
+	while (pWriter->nCount > 0)
+	{
+		if (pWriter->pOutput == pWriter->pOutputLimit)
+		{
+			return NULL;
+		}
+		*pWriter->pOutput++ = (XnUInt8)pWriter->nBits;
+		pWriter->nBits >>= 8;
+		pWriter->nCount = (pWriter->nCount > 8) ? pWriter->nCount - 8 : 0;
+	}
+
+	return pWriter->pOutput;
+}
+
+typedef struct XnRawBitReader
+{
+	const XnUInt8* pInput;
+	const XnUInt8* pInputEnd;
+	XnUInt64 nBits;
+	XnUInt32 nCount;
+} XnRawBitReader;
+
+inline void xnRawBitReaderInit(XnRawBitReader* pReader, const XnUInt8* pInput, const XnUInt8* pInputEnd)
+{
+	pReader->pInput = pInput;
+	pReader->pInputEnd = pInputEnd;
+	pReader->nBits = 0;
+	pReader->nCount = 0;
+}
+
+/** Makes sure at least 57 bits are buffered. Like the rANS decoder, reads zeros past the end of the input. */
+inline void xnRawBitReaderFill(XnRawBitReader* pReader)
+{
+	while (pReader->nCount <= 56)
+	{
+		XnUInt64 nByte = (pReader->pInput < pReader->pInputEnd) ? *pReader->pInput : 0;
+		pReader->nBits |= nByte << pReader->nCount;
+		pReader->pInput++;
+		pReader->nCount += 8;
+	}
+}
+
+/** Reads up to 32 bits. */
+inline XnUInt32 xnRawBitReaderGet(XnRawBitReader* pReader, XnUInt32 nBits)
+{
+	if (pReader->nCount < nBits)
+	{
+		xnRawBitReaderFill(pReader);
+	}
+
+	XnUInt32 nValue = (XnUInt32)(pReader->nBits & ((1ULL << nBits) - 1));
+	pReader->nBits >>= nBits;
+	pReader->nCount -= nBits;
+	return nValue;
+}
+
+/**
+* Reads a unary code, written as zeros ended by a one, and returns the number of zeros. Stops after nMax zeros
+* (at most 31), taking the bit after them as the ending one.
+*/
+inline XnUInt32 xnRawBitReaderGetUnary(XnRawBitReader* pReader, XnUInt32 nMax)
+{
+	if (pReader->nCount < 32)
+	{
+		xnRawBitReaderFill(pReader);
+	}
+
+	XnUInt32 nWord = (XnUInt32)pReader->nBits;
+	XnUInt32 nZeros = 0;
+	while (nZeros < nMax && (nWord & 1) == 0)
+	{
+		nWord >>= 1;
+		nZeros++;
+	}
+
+	pReader->nBits >>= (nZeros + 1);
+	pReader->nCount -= (nZeros + 1);
+	return nZeros;
+}
+
+/** Checks if more bits were read than the input had. */
+inline XnBool xnRawBitReaderOverrun(const XnRawBitReader* pReader)
+{
+	return (pReader->pInput - pReader->pInputEnd > (XnInt32)(pReader->nCount / 8));
+}
+
+#endif //_XN_RANS_H_
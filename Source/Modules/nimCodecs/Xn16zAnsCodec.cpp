@@ -0,0 +1,159 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include "Xn16zAnsCodec.h"
+#include "XnStreamCompression.h"
+#include <XnCodecIDs.h>
+#include <XnLog.h>
+
+/*****************/
+/* Xn16zAnsCodec */
+/*****************/
+Xn16zAnsCodec::Xn16zAnsCodec() :
+	m_nXRes(0),
+	m_hOutputModeCallback(NULL),
+	m_hCroppingCallback(NULL),
+	m_depth(NULL),
+	m_context(NULL)
+{
+	m_strNodeName[0] = '\0';
+}
+
+Xn16zAnsCodec::~Xn16zAnsCodec()
+{
+	// we can assume context still exists, but we'll have to check node still exists
+	DepthGenerator depth;
+	if (XN_STATUS_OK == m_context.GetProductionNodeByName(m_strNodeName, depth))
+	{
+		if (m_hOutputModeCallback)
+		{
+			depth.UnregisterFromMapOutputModeChange(m_hOutputModeCallback);
+		}
+
+		if (m_hCroppingCallback)
+		{
+			depth.GetCroppingCap().UnregisterFromCroppingChange(m_hCroppingCallback);
+		}
+	}
+}
+
+XnCodecID Xn16zAnsCodec::GetCodecID() const
+{
+	return XN_CODEC_16Z_ANS;
+}
+
+XnStatus Xn16zAnsCodec::Init(const ProductionNode& node)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = XnCodec::Init(node);
+	XN_IS_STATUS_OK_LOG_ERROR("Init codec", nRetVal);
+
+	if (node.GetInfo().GetDescription().Type != XN_NODE_TYPE_DEPTH)
+	{
+		XN_LOG_ERROR_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Codec 16z with entropy coding requires a depth node!");
+	}
+
+	strcpy(m_strNodeName, node.GetName());
+
+	DepthGenerator depth(node);
+	depth.GetContext(m_context);
+
+	// the predictor needs the width of the rows, which changes with resolution and cropping
+	nRetVal = depth.RegisterToMapOutputModeChange(NodeConfigurationChangedCallback, this, m_hOutputModeCallback);
+	XN_IS_STATUS_OK_LOG_ERROR("Register to map output mode change", nRetVal);
+
+	if (depth.IsCapabilitySupported(XN_CAPABILITY_CROPPING))
+	{
+		nRetVal = depth.GetCroppingCap().RegisterToCroppingChange(NodeConfigurationChangedCallback, this, m_hCroppingCallback);
+		XN_IS_STATUS_OK_LOG_ERROR("Register to cropping change", nRetVal);
+	}
+
+	m_depth = depth;
+
+	nRetVal = OnNodeConfigurationChanged();
+	XN_IS_STATUS_OK_LOG_ERROR("Handle node configuration change", nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+XnFloat Xn16zAnsCodec::GetWorseCompressionRatio() const
+{
+	return XN_STREAM_COMPRESSION_DEPTH16Z_ANS_WORSE_RATIO;
+}
+
+XnUInt32 Xn16zAnsCodec::GetOverheadSize() const
+{
+	return XN_STREAM_COMPRESSION_DEPTH16Z_ANS_OVERHEAD;
+}
+
+XnStatus Xn16zAnsCodec::CompressImpl(const XnUChar* pData, XnUInt32 nDataSize, XnUChar* pCompressedData, XnUInt32* pnCompressedDataSize) const
+{
+	return XnStreamCompressDepth16ZAns((const XnUInt16*)pData, nDataSize, m_nXRes, pCompressedData, pnCompressedDataSize);
+}
+
+XnStatus Xn16zAnsCodec::DecompressImpl(const XnUChar* pCompressedData, XnUInt32 nCompressedDataSize, XnUChar* pData, XnUInt32* pnDataSize) const
+{
+	return XnStreamUncompressDepth16ZAns(pCompressedData, nCompressedDataSize, (XnUInt16*)pData, pnDataSize);
+}
+
+XnStatus Xn16zAnsCodec::OnNodeConfigurationChanged()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnMapOutputMode outputMode;
+	nRetVal = m_depth.GetMapOutputMode(outputMode);
+	XN_IS_STATUS_OK_LOG_ERROR("Get map output mode", nRetVal);
+
+	m_nXRes = outputMode.nXRes;
+
+	if (m_depth.IsCapabilitySupported(XN_CAPABILITY_CROPPING))
+	{
+		XnCropping cropping;
+		nRetVal = m_depth.GetCroppingCap().GetCropping(cropping);
+		XN_IS_STATUS_OK_LOG_ERROR("Get cropping", nRetVal);
+
+		if (cropping.bEnabled)
+		{
+			m_nXRes = cropping.nXSize;
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+void XN_CALLBACK_TYPE Xn16zAnsCodec::NodeConfigurationChangedCallback(ProductionNode& /*node*/, void* pCookie)
+{
+	Xn16zAnsCodec* pThis = (Xn16zAnsCodec*)pCookie;
+	pThis->OnNodeConfigurationChanged();
+}
+
+/***********************/
+/* Exported16zAnsCodec */
+/***********************/
+Exported16zAnsCodec::Exported16zAnsCodec() : ExportedCodec(XN_CODEC_16Z_ANS)
+{
+
+}
+
+XnCodec* Exported16zAnsCodec::CreateCodec()
+{
+	return XN_NEW(Xn16zAnsCodec);
+}
@@ -0,0 +1,148 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include "XnAudioLosslessCodec.h"
+#include "XnStreamCompression.h"
+#include <XnCodecIDs.h>
+#include <XnLog.h>
+
+/************************/
+/* XnAudioLosslessCodec */
+/************************/
+XnAudioLosslessCodec::XnAudioLosslessCodec() :
+	m_bValid(FALSE),
+	m_hWaveModeCallback(NULL),
+	m_audio(NULL),
+	m_context(NULL)
+{
+	m_strNodeName[0] = '\0';
+	xnOSMemSet(&m_waveMode, 0, sizeof(m_waveMode));
+}
+
+XnAudioLosslessCodec::~XnAudioLosslessCodec()
+{
+	// we can assume context still exists, but we'll have to check node still exists
+	AudioGenerator audio;
+	if (XN_STATUS_OK == m_context.GetProductionNodeByName(m_strNodeName, audio))
+	{
+		if (m_hWaveModeCallback)
+		{
+			audio.UnregisterFromWaveOutputModeChanges(m_hWaveModeCallback);
+		}
+	}
+}
+
+XnCodecID XnAudioLosslessCodec::GetCodecID() const
+{
+	return XN_CODEC_AUDIO_LOSSLESS;
+}
+
+XnStatus XnAudioLosslessCodec::Init(const ProductionNode& node)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = XnCodec::Init(node);
+	XN_IS_STATUS_OK_LOG_ERROR("Init codec", nRetVal);
+
+	if (node.GetInfo().GetDescription().Type != XN_NODE_TYPE_AUDIO)
+	{
+		XN_LOG_ERROR_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Lossless audio codec requires an audio node!");
+	}
+
+	strcpy(m_strNodeName, node.GetName());
+
+	AudioGenerator audio(node);
+	audio.GetContext(m_context);
+
+	// the channels are interleaved, so the encoder needs to know how many there are
+	nRetVal = audio.RegisterToWaveOutputModeChanges(NodeConfigurationChangedCallback, this, m_hWaveModeCallback);
+	XN_IS_STATUS_OK_LOG_ERROR("Register to wave output mode change", nRetVal);
+
+	m_audio = audio;
+
+	nRetVal = OnNodeConfigurationChanged();
+	XN_IS_STATUS_OK_LOG_ERROR("Handle node configuration change", nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+XnFloat XnAudioLosslessCodec::GetWorseCompressionRatio() const
+{
+	return XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_WORSE_RATIO;
+}
+
+XnUInt32 XnAudioLosslessCodec::GetOverheadSize() const
+{
+	return XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_OVERHEAD;
+}
+
+XnStatus XnAudioLosslessCodec::CompressImpl(const XnUChar* pData, XnUInt32 nDataSize, XnUChar* pCompressedData, XnUInt32* pnCompressedDataSize) const
+{
+	if (!m_bValid)
+	{
+		xnLogError(XN_MASK_OPEN_NI, "Codec is not valid");
+		return XN_STATUS_ERROR;
+	}
+
+	return XnStreamCompressAudioLossless(pData, nDataSize, m_waveMode.nChannels, m_waveMode.nBitsPerSample, pCompressedData, pnCompressedDataSize);
+}
+
+XnStatus XnAudioLosslessCodec::DecompressImpl(const XnUChar* pCompressedData, XnUInt32 nCompressedDataSize, XnUChar* pData, XnUInt32* pnDataSize) const
+{
+	return XnStreamUncompressAudioLossless(pCompressedData, nCompressedDataSize, pData, pnDataSize);
+}
+
+XnStatus XnAudioLosslessCodec::OnNodeConfigurationChanged()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	m_bValid = FALSE;
+
+	nRetVal = m_audio.GetWaveOutputMode(m_waveMode);
+	XN_IS_STATUS_OK_LOG_ERROR("Get wave output mode", nRetVal);
+
+	if (m_waveMode.nChannels == 0)
+	{
+		XN_LOG_ERROR_RETURN(XN_STATUS_ERROR, XN_MASK_OPEN_NI, "Lossless audio codec requires at least one channel!");
+	}
+
+	m_bValid = TRUE;
+
+	return (XN_STATUS_OK);
+}
+
+void XN_CALLBACK_TYPE XnAudioLosslessCodec::NodeConfigurationChangedCallback(ProductionNode& /*node*/, void* pCookie)
+{
+	XnAudioLosslessCodec* pThis = (XnAudioLosslessCodec*)pCookie;
+	pThis->OnNodeConfigurationChanged();
+}
+
+/******************************/
+/* ExportedAudioLosslessCodec */
+/******************************/
+ExportedAudioLosslessCodec::ExportedAudioLosslessCodec() : ExportedCodec(XN_CODEC_AUDIO_LOSSLESS)
+{
+
+}
+
+XnCodec* ExportedAudioLosslessCodec::CreateCodec()
+{
+	return XN_NEW(XnAudioLosslessCodec);
+}
@@ -24,13 +24,19 @@
 #include "XnUncompressedCodec.h"
 #include "Xn16zCodec.h"
 #include "Xn16zEmbTablesCodec.h"
+#include "Xn16zAnsCodec.h"
 #include "Xn8zCodec.h"
 #include "XnJpegCodec.h"
+#include "XnImageLosslessCodec.h"
+#include "XnAudioLosslessCodec.h"
 #include <XnModuleCppRegistratration.h>
 
 XN_EXPORT_MODULE(xn::Module)
 XN_EXPORT_CODEC(Exported16zCodec)
 XN_EXPORT_CODEC(Exported16zEmbTablesCodec)
+XN_EXPORT_CODEC(Exported16zAnsCodec)
 XN_EXPORT_CODEC(Exported8zCodec)
 XN_EXPORT_CODEC(ExportedJpegCodec)
+XN_EXPORT_CODEC(ExportedImageLosslessCodec)
+XN_EXPORT_CODEC(ExportedAudioLosslessCodec)
 XN_EXPORT_CODEC(ExportedUncompressedCodec)
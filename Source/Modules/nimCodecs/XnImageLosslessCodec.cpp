@@ -0,0 +1,193 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include "XnImageLosslessCodec.h"
+#include "XnStreamCompression.h"
+#include <XnCodecIDs.h>
+#include <XnLog.h>
+
+/************************/
+/* XnImageLosslessCodec */
+/************************/
+XnImageLosslessCodec::XnImageLosslessCodec() :
+	m_bValid(FALSE),
+	m_pixelFormat(XN_PIXEL_FORMAT_RGB24),
+	m_nXRes(0),
+	m_hOutputModeCallback(NULL),
+	m_hCroppingCallback(NULL),
+	m_hPixelFormatCallback(NULL),
+	m_image(NULL),
+	m_context(NULL)
+{
+	m_strNodeName[0] = '\0';
+}
+
+XnImageLosslessCodec::~XnImageLosslessCodec()
+{
+	// we can assume context still exists, but we'll have to check node still exists
+	ImageGenerator image;
+	if (XN_STATUS_OK == m_context.GetProductionNodeByName(m_strNodeName, image))
+	{
+		if (m_hOutputModeCallback)
+		{
+			image.UnregisterFromMapOutputModeChange(m_hOutputModeCallback);
+		}
+
+		if (m_hCroppingCallback)
+		{
+			image.GetCroppingCap().UnregisterFromCroppingChange(m_hCroppingCallback);
+		}
+
+		if (m_hPixelFormatCallback)
+		{
+			image.UnregisterFromPixelFormatChange(m_hPixelFormatCallback);
+		}
+	}
+}
+
+XnCodecID XnImageLosslessCodec::GetCodecID() const
+{
+	return XN_CODEC_IMAGE_LOSSLESS;
+}
+
+XnStatus XnImageLosslessCodec::Init(const ProductionNode& node)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = XnCodec::Init(node);
+	XN_IS_STATUS_OK_LOG_ERROR("Init codec", nRetVal);
+
+	if (node.GetInfo().GetDescription().Type != XN_NODE_TYPE_IMAGE)
+	{
+		XN_LOG_ERROR_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Lossless image codec requires an image node!");
+	}
+
+	strcpy(m_strNodeName, node.GetName());
+
+	ImageGenerator image(node);
+	image.GetContext(m_context);
+
+	// the predictor needs the width of the rows, and the layout of the pixels
+	nRetVal = image.RegisterToMapOutputModeChange(NodeConfigurationChangedCallback, this, m_hOutputModeCallback);
+	XN_IS_STATUS_OK_LOG_ERROR("Register to map output mode change", nRetVal);
+
+	if (image.IsCapabilitySupported(XN_CAPABILITY_CROPPING))
+	{
+		nRetVal = image.GetCroppingCap().RegisterToCroppingChange(NodeConfigurationChangedCallback, this, m_hCroppingCallback);
+		XN_IS_STATUS_OK_LOG_ERROR("Register to cropping change", nRetVal);
+	}
+
+	nRetVal = image.RegisterToPixelFormatChange(NodeConfigurationChangedCallback, this, m_hPixelFormatCallback);
+	XN_IS_STATUS_OK_LOG_ERROR("Register to pixel format change", nRetVal);
+
+	m_image = image;
+
+	nRetVal = OnNodeConfigurationChanged();
+	XN_IS_STATUS_OK_LOG_ERROR("Handle node configuration change", nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+XnFloat XnImageLosslessCodec::GetWorseCompressionRatio() const
+{
+	return XN_STREAM_COMPRESSION_IMAGE_LOSSLESS_WORSE_RATIO;
+}
+
+XnUInt32 XnImageLosslessCodec::GetOverheadSize() const
+{
+	return XN_STREAM_COMPRESSION_IMAGE_LOSSLESS_OVERHEAD;
+}
+
+XnStatus XnImageLosslessCodec::CompressImpl(const XnUChar* pData, XnUInt32 nDataSize, XnUChar* pCompressedData, XnUInt32* pnCompressedDataSize) const
+{
+	if (!m_bValid)
+	{
+		xnLogError(XN_MASK_OPEN_NI, "Codec is not valid");
+		return XN_STATUS_ERROR;
+	}
+
+	return XnStreamCompressImageLossless(pData, nDataSize, m_pixelFormat, m_nXRes, pCompressedData, pnCompressedDataSize);
+}
+
+XnStatus XnImageLosslessCodec::DecompressImpl(const XnUChar* pCompressedData, XnUInt32 nCompressedDataSize, XnUChar* pData, XnUInt32* pnDataSize) const
+{
+	return XnStreamUncompressImageLossless(pCompressedData, nCompressedDataSize, pData, pnDataSize);
+}
+
+XnStatus XnImageLosslessCodec::OnNodeConfigurationChanged()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	m_bValid = FALSE;
+
+	XnMapOutputMode outputMode;
+	nRetVal = m_image.GetMapOutputMode(outputMode);
+	XN_IS_STATUS_OK_LOG_ERROR("Get map output mode", nRetVal);
+
+	m_nXRes = outputMode.nXRes;
+
+	if (m_image.IsCapabilitySupported(XN_CAPABILITY_CROPPING))
+	{
+		XnCropping cropping;
+		nRetVal = m_image.GetCroppingCap().GetCropping(cropping);
+		XN_IS_STATUS_OK_LOG_ERROR("Get cropping", nRetVal);
+
+		if (cropping.bEnabled)
+		{
+			m_nXRes = cropping.nXSize;
+		}
+	}
+
+	m_pixelFormat = m_image.GetPixelFormat();
+
+	switch (m_pixelFormat)
+	{
+		case XN_PIXEL_FORMAT_RGB24:
+		case XN_PIXEL_FORMAT_YUV422:
+		case XN_PIXEL_FORMAT_GRAYSCALE_8_BIT:
+		case XN_PIXEL_FORMAT_GRAYSCALE_16_BIT:
+			break;
+		default:
+			XN_LOG_ERROR_RETURN(XN_STATUS_ERROR, XN_MASK_OPEN_NI, "Lossless image codec supports only RGB24, YUV422 and Grayscale pixel formats!");
+	}
+
+	m_bValid = TRUE;
+
+	return (XN_STATUS_OK);
+}
+
+void XN_CALLBACK_TYPE XnImageLosslessCodec::NodeConfigurationChangedCallback(ProductionNode& /*node*/, void* pCookie)
+{
+	XnImageLosslessCodec* pThis = (XnImageLosslessCodec*)pCookie;
+	pThis->OnNodeConfigurationChanged();
+}
+
+/******************************/
+/* ExportedImageLosslessCodec */
+/******************************/
+ExportedImageLosslessCodec::ExportedImageLosslessCodec() : ExportedCodec(XN_CODEC_IMAGE_LOSSLESS)
+{
+
+}
+
+XnCodec* ExportedImageLosslessCodec::CreateCodec()
+{
+	return XN_NEW(XnImageLosslessCodec);
+}
@@ -25,16 +25,14 @@
 // Includes
 //---------------------------------------------------------------------------
 #include <XnOS.h>
+#include "../Common/XnLosslessCompression.h"
 #include <jpeglib.h>
 #include <setjmp.h>
 
 //---------------------------------------------------------------------------
 // Defines
 //---------------------------------------------------------------------------
-#define XN_STREAM_COMPRESSION_DEPTH16Z_WORSE_RATIO 1.333F
-#define XN_STREAM_COMPRESSION_IMAGE8Z_WORSE_RATIO 1.333F
 #define XN_STREAM_COMPRESSION_IMAGEJ_WORSE_RATIO 1.2F
-#define XN_STREAM_COMPRESSION_CONF4_WORSE_RATIO 0.51F
 #define XN_STREAM_COMPRESSION_JPEG_DEFAULT_QUALITY 90
 
 #define XN_STREAM_STRING_BAD_FORMAT -1
@@ -73,17 +71,6 @@ typedef struct XnStreamUncompJPEGContext
 //---------------------------------------------------------------------------
 // Functions Declaration
 //---------------------------------------------------------------------------
-XnStatus XnStreamCompressDepth16Z(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
-XnStatus XnStreamCompressDepth16ZWithEmbTable(const XnUInt16* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize, XnUInt16 nMaxValue);
-XnStatus XnStreamUncompressDepth16Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize);
-XnStatus XnStreamUncompressDepth16ZWithEmbTable(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt16* pOutput, XnUInt32* pnOutputSize);
-
-XnStatus XnStreamCompressImage8Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
-XnStatus XnStreamUncompressImage8Z(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
-
-XnStatus XnStreamCompressConf4(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
-XnStatus XnStreamUncompressConf4(const XnUInt8* pInput, const XnUInt32 nInputSize, XnUInt8* pOutput, XnUInt32* pnOutputSize);
-
 void		   XnStreamJPEGCompDummyFunction(struct jpeg_compress_struct* pjCompStruct);
 boolean		   XnStreamJPEGCompDummyFailFunction(struct jpeg_compress_struct* pjCompStruct);
 XnStatus XnStreamInitCompressImageJ(XnStreamCompJPEGContext* pStreamCompJPEGContext);
@@ -28,19 +28,32 @@ MockDepthGenerator::MockDepthGenerator(xn::Context& context, const XnChar* strNa
 	m_nDeviceMaxDepth(0),
 	m_nSupportedUserPositionsCount(0),
 	m_bSupportedUserPositionsCountReceived(FALSE),
-	m_pUserPositions(NULL)
+	m_pUserPositions(NULL),
+	m_bCalibrationReceived(FALSE),
+	m_pRegistration(NULL),
+	m_bRegistrationMirror(FALSE)
 {
 	xnOSMemSet(&m_FOV, 0, sizeof(m_FOV));
+	xnOSMemSet(&m_calibration, 0, sizeof(m_calibration));
+	xnOSMemSet(&m_registrationMode, 0, sizeof(m_registrationMode));
+	m_strViewPoint[0] = '\0';
 }
 
 MockDepthGenerator::~MockDepthGenerator()
 {
 	XN_DELETE_ARR(m_pUserPositions);
+	xnDepthRegistrationDestroy(&m_pRegistration);
 }
 
 XnBool MockDepthGenerator::IsCapabilitySupported(const XnChar* strCapabilityName)
 {
 	//TODO: Support user position interface
+	if (strcmp(strCapabilityName, XN_CAPABILITY_ALTERNATIVE_VIEW_POINT) == 0)
+	{
+		// registration is done by this node, so it only depends on having a calibration
+		return m_bCalibrationReceived;
+	}
+
 	return MockMapGenerator::IsCapabilitySupported(strCapabilityName);
 }
 
@@ -104,6 +117,23 @@ XnStatus MockDepthGenerator::SetGeneralProperty(const XnChar* strName, XnUInt32
 			XN_LOG_ERROR_RETURN(XN_STATUS_ERROR, XN_MASK_OPEN_NI, "got XN_PROP_USER_POSITIONS without XN_PROP_SUPPORTED_USER_POSITIONS_COUNT before it.")
 		}
 	}
+	else if (strcmp(strName, XN_PROP_REGISTRATION_CALIBRATION) == 0)
+	{
+		if (nBufferSize != sizeof(XnRegistrationCalibration))
+		{
+			XN_LOG_ERROR_RETURN(XN_STATUS_INVALID_BUFFER_SIZE, XN_MASK_OPEN_NI, "Cannot set XN_PROP_REGISTRATION_CALIBRATION - buffer size is incorrect");
+		}
+
+		xnOSMemCopy(&m_calibration, pBuffer, sizeof(m_calibration));
+		m_bCalibrationReceived = TRUE;
+
+		// the engine is rebuilt with the new calibration on next use
+		xnDepthRegistrationDestroy(&m_pRegistration);
+
+		// keep it as a general property as well, so it can be read back (and recorded again)
+		nRetVal = MockMapGenerator::SetGeneralProperty(strName, nBufferSize, pBuffer);
+		XN_IS_STATUS_OK(nRetVal);
+	}
 	else
 	{
 		nRetVal = MockMapGenerator::SetGeneralProperty(strName, nBufferSize, pBuffer);
@@ -144,6 +174,163 @@ xn::ModuleUserPositionInterface* MockDepthGenerator::GetUserPositionInterface()
 	return NULL;
 }
 
+xn::ModuleAlternativeViewPointInterface* MockDepthGenerator::GetAlternativeViewPointInterface()
+{
+	// the interface always exists, even if capability is not supported (a calibration may be set later on)
+	return this;
+}
+
+XnBool MockDepthGenerator::IsViewPointSupported(xn::ProductionNode& other)
+{
+	if (!m_bCalibrationReceived || !other.IsValid())
+	{
+		return FALSE;
+	}
+
+	return (other.GetInfo().GetDescription().Type == XN_NODE_TYPE_IMAGE);
+}
+
+XnStatus MockDepthGenerator::SetViewPoint(xn::ProductionNode& other)
+{
+	if (!m_bCalibrationReceived)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_NOT_IMPLEMENTED, XN_MASK_OPEN_NI, "%s: Cannot register depth - no registration calibration was set", m_strName);
+	}
+
+	if (!IsViewPointSupported(other))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "%s: Depth can only be registered to the view point of an image generator", m_strName);
+	}
+
+	return SetViewPointNode(other.GetName());
+}
+
+XnBool MockDepthGenerator::IsViewPointAs(xn::ProductionNode& other)
+{
+	return (other.IsValid() && strcmp(other.GetName(), m_strViewPoint) == 0);
+}
+
+XnStatus MockDepthGenerator::ResetViewPoint()
+{
+	return SetViewPointNode("");
+}
+
+XnStatus MockDepthGenerator::RegisterToViewPointChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback)
+{
+	return m_viewPointChangeEvent.Register(handler, pCookie, hCallback);
+}
+
+void MockDepthGenerator::UnregisterFromViewPointChange(XnCallbackHandle hCallback)
+{
+	m_viewPointChangeEvent.Unregister(hCallback);
+}
+
+XnStatus MockDepthGenerator::GetPixelCoordinatesInViewPoint(xn::ProductionNode& other, XnUInt32 x, XnUInt32 y, XnUInt32& altX, XnUInt32& altY)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (!IsViewPointSupported(other) || x >= m_mapOutputMode.nXRes || y >= m_mapOutputMode.nYRes)
+	{
+		return XN_STATUS_BAD_PARAM;
+	}
+
+	XnMapOutputMode imageMode;
+	nRetVal = xnGetMapOutputMode(other.GetHandle(), &imageMode);
+	XN_IS_STATUS_OK(nRetVal);
+
+	// registered pixels are already in the image view point (only their resolution may differ)
+	XnPoint3D point = { (XnFloat)x, (XnFloat)y, 1 };
+	if (!IsViewPointAs(other))
+	{
+		const XnDepthPixel* pDepth = (const XnDepthPixel*)GetData();
+		point.Z = (pDepth == NULL) ? 0 : pDepth[y * m_mapOutputMode.nXRes + x];
+
+		nRetVal = UpdateRegistration();
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = xnDepthRegistrationMapPoints(m_pRegistration, 1, &point, &point);
+		XN_IS_STATUS_OK(nRetVal);
+
+		// round to the nearest pixel
+		point.X += 0.5f;
+		point.Y += 0.5f;
+	}
+
+	XnFloat fX = point.X * imageMode.nXRes / m_mapOutputMode.nXRes;
+	XnFloat fY = point.Y * imageMode.nYRes / m_mapOutputMode.nYRes;
+	if (point.Z == 0 || fX < 0 || fX >= imageMode.nXRes || fY < 0 || fY >= imageMode.nYRes)
+	{
+		// pixel has no depth, or falls outside the image
+		return XN_STATUS_NO_MATCH;
+	}
+
+	altX = (XnUInt32)fX;
+	altY = (XnUInt32)fY;
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus MockDepthGenerator::SetViewPointNode(const XnChar* strOther)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (strcmp(strOther, m_strViewPoint) != 0)
+	{
+		nRetVal = xnOSStrCopy(m_strViewPoint, strOther, sizeof(m_strViewPoint));
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = m_viewPointChangeEvent.Raise();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus MockDepthGenerator::UpdateRegistration()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnBool bMirror = IsMirrored();
+	if (m_pRegistration != NULL && 
+		m_registrationMode.nXRes == m_mapOutputMode.nXRes && 
+		m_registrationMode.nYRes == m_mapOutputMode.nYRes && 
+		m_bRegistrationMirror == bMirror)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	xnDepthRegistrationDestroy(&m_pRegistration);
+
+	// registered maps keep the depth resolution, like those of devices that register in hardware
+	nRetVal = xnDepthRegistrationCreate(&m_calibration, m_mapOutputMode.nXRes, m_mapOutputMode.nYRes, 
+		m_mapOutputMode.nXRes, m_mapOutputMode.nYRes, bMirror, 0, &m_pRegistration);
+	XN_IS_STATUS_OK(nRetVal);
+
+	m_registrationMode = m_mapOutputMode;
+	m_bRegistrationMirror = bMirror;
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus MockDepthGenerator::OnNewCurrentData(void* pData, XnUInt32 nDataSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (m_strViewPoint[0] == '\0' || pData == NULL ||
+		nDataSize != m_mapOutputMode.nXRes * m_mapOutputMode.nYRes * sizeof(XnDepthPixel))
+	{
+		return (XN_STATUS_OK);
+	}
+
+	nRetVal = UpdateRegistration();
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnDepthRegistrationRegister(m_pRegistration, (const XnDepthPixel*)pData, (XnDepthPixel*)pData);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
 XnStatus MockDepthGenerator::SetFieldOfView(const XnFieldOfView& FOV)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
@@ -23,13 +23,15 @@
 
 #include <XnModuleCppInterface.h>
 #include <XnTypes.h>
+#include <XnDepthRegistration.h>
 #include "MockMapGenerator.h"
 
 XN_PRAGMA_START_DISABLED_WARNING_SECTION(XN_INHERITS_VIA_DOMINANCE_WARNING_ID)
 
 class MockDepthGenerator : 
 	public MockMapGenerator,
-	virtual public xn::ModuleDepthGenerator
+	virtual public xn::ModuleDepthGenerator,
+	virtual public xn::ModuleAlternativeViewPointInterface
 {
 public:
 	MockDepthGenerator(xn::Context& context, const XnChar* strName);
@@ -42,6 +44,7 @@ public:
 
 	/*Generator*/
 	virtual const void* GetData() { return MockMapGenerator::GetData(); }
+	virtual xn::ModuleAlternativeViewPointInterface* GetAlternativeViewPointInterface();
 
 	/*MapGenerator*/
 	virtual XnUInt32 GetBytesPerPixel() { return xn::ModuleDepthGenerator::GetBytesPerPixel(); }
@@ -54,8 +57,18 @@ public:
 	virtual XnDepthPixel GetDeviceMaxDepth();
 	virtual xn::ModuleUserPositionInterface* GetUserPositionInterface();
 
+	/*AlternativeViewPoint*/
+	virtual XnBool IsViewPointSupported(xn::ProductionNode& other);
+	virtual XnStatus SetViewPoint(xn::ProductionNode& other);
+	virtual XnBool IsViewPointAs(xn::ProductionNode& other);
+	virtual XnStatus ResetViewPoint();
+	virtual XnStatus RegisterToViewPointChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
+	virtual void UnregisterFromViewPointChange(XnCallbackHandle hCallback);
+	virtual XnStatus GetPixelCoordinatesInViewPoint(xn::ProductionNode& other, XnUInt32 x, XnUInt32 y, XnUInt32& altX, XnUInt32& altY);
+
 protected:
 	XnStatus SetFieldOfView(const XnFieldOfView& FOV);
+	virtual XnStatus OnNewCurrentData(void* pData, XnUInt32 nDataSize);
 
 	PropChangeEvent m_fieldOfViewChangeEvent;
 
@@ -64,6 +77,19 @@ protected:
 	XnUInt32 m_nSupportedUserPositionsCount;
 	XnBool m_bSupportedUserPositionsCountReceived;
 	XnBoundingBox3D* m_pUserPositions;
+
+private:
+	XnStatus SetViewPointNode(const XnChar* strOther);
+	XnStatus UpdateRegistration();
+
+	PropChangeEvent m_viewPointChangeEvent;
+	XnBool m_bCalibrationReceived;
+	XnRegistrationCalibration m_calibration;
+	XnChar m_strViewPoint[XN_MAX_NAME_LENGTH]; // image node whose view point depth is registered to
+	/* Registration engine, created on demand for the current output mode and mirror. */
+	XnDepthRegistration* m_pRegistration;
+	XnMapOutputMode m_registrationMode;
+	XnBool m_bRegistrationMirror;
 };
 
 XN_PRAGMA_STOP_DISABLED_WARNING_SECTION
@@ -21,25 +21,34 @@
 #include "MockGenerator.h"
 #include <XnPropNames.h>
 #include <XnLog.h>
+#include <XnOSCpp.h>
 
 #define XN_MOCK_LOG_MASK	"Mock"
 
+#define XN_MOCK_FRAME_POOL_DEFAULT_FRAMES		2
+#define XN_MOCK_FRAME_POOL_DEFAULT_MAX_FRAMES	16
+
 MockGenerator::MockGenerator(xn::Context& context, const XnChar* strName, XnBool bAggregateData /* = FALSE */) :
 	MockProductionNode(context, strName),
 	m_bAggregateData(bAggregateData),
 	m_bGenerating(FALSE),
 	m_bMirror(FALSE),
-	m_nCurrentDataIdx(0),
-	m_nNextDataIdx(1),
 	m_bNewDataAvailable(FALSE),
 	m_bMirrorCap(FALSE),
 	m_bFrameSyncCap(FALSE),
 	m_bFrameSyncWithExists(FALSE),
 	m_hNodeCreationCallback(NULL),
-	m_hNodeDestructionCallback(NULL)
+	m_hNodeDestructionCallback(NULL),
+	m_pool(XN_MOCK_FRAME_POOL_DEFAULT_FRAMES, XN_MOCK_FRAME_POOL_DEFAULT_MAX_FRAMES),
+	m_nDroppedFrames(0),
+	m_hPoolLock(NULL)
 {
-	memset(&m_data, 0, sizeof(m_data));
 	m_strFrameSyncWith[0] = '\0';
+
+	if (xnOSCreateCriticalSection(&m_hPoolLock) != XN_STATUS_OK)
+	{
+		xnLogError(XN_MOCK_LOG_MASK, "%s: Failed to create frame pool lock", m_strName);
+	}
 }
 
 MockGenerator::~MockGenerator()
@@ -56,10 +65,7 @@ MockGenerator::~MockGenerator()
 		m_hNodeDestructionCallback = NULL;
 	}
 
-	for (XnUInt32 i = 0; i < NUM_BUFFERS; i++)
-	{
-		xnOSFreeAligned(m_data[i].pData);
-	}
+	xnOSCloseCriticalSection(&m_hPoolLock);
 }
 
 XnBool MockGenerator::IsCapabilitySupported(const XnChar* strCapabilityName)
@@ -72,6 +78,11 @@ XnBool MockGenerator::IsCapabilitySupported(const XnChar* strCapabilityName)
 	{
 		return (!m_bStateReady || m_bFrameSyncCap);
 	}
+	else if (strcmp(strCapabilityName, XN_CAPABILITY_FRAME_LEASE) == 0)
+	{
+		// leasing is done by this node, so it doesn't depend on what was recorded
+		return TRUE;
+	}
 	//TODO: Support alt view cap
 	else
 	{
@@ -89,11 +100,11 @@ XnStatus MockGenerator::SetIntProperty(const XnChar* strName, XnUInt64 nValue)
 	}
 	else if (strcmp(strName, XN_PROP_TIMESTAMP) == 0)
 	{
-		m_data[m_nNextDataIdx].nTimeStamp = nValue;
+		m_pool.Next().nTimestamp = nValue;
 	}
 	else if (strcmp(strName, XN_PROP_FRAME_ID) == 0)
 	{
-		m_data[m_nNextDataIdx].nFrameID = (XnUInt32)nValue;
+		m_pool.Next().nFrameID = (XnUInt32)nValue;
 	}
 	else if (strcmp(strName, XN_CAPABILITY_MIRROR) == 0)
 	{
@@ -158,14 +169,14 @@ XnStatus MockGenerator::SetNextData(const void *pData, XnUInt32 nSize)
 	//Make sure the node is in Generating state so it would be recorded properly
 	SetGenerating(TRUE);
 
-	DataInfo& nextData = m_data[m_nNextDataIdx];
+	XnFramePool::Frame& nextData = m_pool.Next();
 
 	if (!m_bAggregateData)
 	{
 		nextData.nDataSize = 0;
 	}
 
-	nRetVal = ResizeBuffer(m_nNextDataIdx, nextData.nDataSize + nSize);
+	nRetVal = XnFramePool::Allocate(nextData, nextData.nDataSize + nSize);
 	XN_IS_STATUS_OK(nRetVal);
 
 	xnOSMemCopy((XnUChar*)nextData.pData + nextData.nDataSize, pData, nSize);
@@ -227,13 +238,13 @@ XnBool MockGenerator::IsNewDataAvailable(XnUInt64& nTimestamp)
 		// there is no actual frame, so we don't want the timestamp to be checked for sync.
 		// instead, return an "invalid" timestamp. This is allowed, as FrameID 0 is a non-valid
 		// frame.
-		if (m_data[m_nNextDataIdx].nFrameID == 0)
+		if (m_pool.Next().nFrameID == 0)
 		{
 			nTimestamp = XN_MAX_UINT64;
 		}
 		else
 		{
-			nTimestamp = m_data[m_nNextDataIdx].nTimeStamp;
+			nTimestamp = m_pool.Next().nTimestamp;
 		}
 	}
 
@@ -242,35 +253,64 @@ XnBool MockGenerator::IsNewDataAvailable(XnUInt64& nTimestamp)
 
 XnStatus MockGenerator::UpdateData()
 {
+	XnStatus nRetVal = XN_STATUS_OK;
+
 	if (m_bNewDataAvailable)
 	{
-		//Rotate current data and next data
-		m_nCurrentDataIdx = 1 - m_nCurrentDataIdx;
-		m_nNextDataIdx = 1 - m_nNextDataIdx;
-		m_data[m_nNextDataIdx].nDataSize = 0;
+		XnAutoCSLocker locker(m_hPoolLock);
+
+		//Next data becomes current, and a free buffer will receive the next data
+		XnBool bAdvanced = m_pool.Advance();
+		if (bAdvanced)
+		{
+			if (m_nDroppedFrames != 0)
+			{
+				xnLogInfo(XN_MOCK_LOG_MASK, "%s: Frame buffer available again, after dropping %u frames", m_strName, m_nDroppedFrames);
+				m_nDroppedFrames = 0;
+			}
+		}
+		else
+		{
+			// all buffers are leased. Drop the new frame, and keep the current one.
+			if (m_nDroppedFrames == 0)
+			{
+				xnLogWarning(XN_MOCK_LOG_MASK, "%s: All %u frame buffers are leased. Dropping frames until one is released.", m_strName, m_pool.GetSize());
+			}
+			++m_nDroppedFrames;
+		}
+
+		m_pool.Next().nDataSize = 0;
 		m_bNewDataAvailable = FALSE;
+
+		// only once the swap is done, so that a failure leaves the new frame current, and the pool ready for the next one
+		if (bAdvanced)
+		{
+			XnFramePool::Frame& current = m_pool.Current();
+			nRetVal = OnNewCurrentData(current.pData, current.nDataSize);
+			XN_IS_STATUS_OK(nRetVal);
+		}
 	}
 	return XN_STATUS_OK;
 }
 
 const void* MockGenerator::GetData()
 {
-	return m_data[m_nCurrentDataIdx].pData;
+	return m_pool.Current().pData;
 }
 
 XnUInt32 MockGenerator::GetDataSize()
 {
-	return m_data[m_nCurrentDataIdx].nDataSize;
+	return m_pool.Current().nDataSize;
 }
 
 XnUInt64 MockGenerator::GetTimestamp()
 {
-	return m_data[m_nCurrentDataIdx].nTimeStamp;
+	return m_pool.Current().nTimestamp;
 }
 
 XnUInt32 MockGenerator::GetFrameID()
 {
-	return m_data[m_nCurrentDataIdx].nFrameID;
+	return m_pool.Current().nFrameID;
 }
 
 xn::ModuleMirrorInterface* MockGenerator::GetMirrorInterface()
@@ -291,6 +331,57 @@ xn::ModuleFrameSyncInterface* MockGenerator::GetFrameSyncInterface()
 	return this;
 }
 
+xn::ModuleFrameLeaseInterface* MockGenerator::GetFrameLeaseInterface()
+{
+	return this;
+}
+
+XnStatus MockGenerator::AcquireFrame(XnFrameLease& lease)
+{
+	XnAutoCSLocker locker(m_hPoolLock);
+
+	if (m_pool.Lease(lease) != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MOCK_LOG_MASK, "%s: There is no frame to lease", m_strName);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus MockGenerator::ReleaseFrame(const XnFrameLease& lease)
+{
+	XnAutoCSLocker locker(m_hPoolLock);
+
+	if (m_pool.Release(lease) != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_NO_MATCH, XN_MOCK_LOG_MASK, "%s: Frame %u was not leased from this node", m_strName, lease.nFrameID);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus MockGenerator::SetFramePoolPolicy(const XnFramePoolPolicy& policy)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnAutoCSLocker locker(m_hPoolLock);
+
+	nRetVal = m_pool.SetPolicy(policy);
+	XN_IS_STATUS_OK(nRetVal);
+
+	xnLogVerbose(XN_MOCK_LOG_MASK, "%s: Frame pool set to %u frames (max %u, %s on overflow)", m_strName, 
+		policy.nFrames, policy.nMaxFrames, (policy.overflow == XN_FRAME_POOL_GROW) ? "grow" : "drop");
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus MockGenerator::GetFramePoolPolicy(XnFramePoolPolicy& policy)
+{
+	XnAutoCSLocker locker(m_hPoolLock);
+	policy = m_pool.GetPolicy();
+	return (XN_STATUS_OK);
+}
+
 XnStatus MockGenerator::SetMirror(XnBool bMirror)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
@@ -350,10 +441,11 @@ XnStatus MockGenerator::OnStateReady()
 	// allocate current buffer (so the app won't get a NULL pointer)
 	XnUInt32 nNeededSize = GetRequiredBufferSize();
 
-	nRetVal = ResizeBuffer(m_nCurrentDataIdx, nNeededSize);
+	XnFramePool::Frame& current = m_pool.Current();
+	nRetVal = XnFramePool::Allocate(current, nNeededSize);
 	XN_IS_STATUS_OK(nRetVal);
 
-	xnOSMemSet(m_data[m_nCurrentDataIdx].pData, 0, nNeededSize);
+	xnOSMemSet(current.pData, 0, nNeededSize);
 
 	return (XN_STATUS_OK);
 }
@@ -363,17 +455,8 @@ XnUInt32 MockGenerator::GetRequiredBufferSize()
 	return 0;
 }
 
-XnStatus MockGenerator::ResizeBuffer(XnUInt32 nIndex, XnUInt32 nNeededSize)
+XnStatus MockGenerator::OnNewCurrentData(void* /*pData*/, XnUInt32 /*nDataSize*/)
 {
-	DataInfo& dataInfo = m_data[nIndex];
-	if (nNeededSize > dataInfo.nAllocatedSize)
-	{
-		xnOSFreeAligned(dataInfo.pData);
-		dataInfo.pData = xnOSMallocAligned(nNeededSize, XN_DEFAULT_MEM_ALIGN);
-		XN_VALIDATE_ALLOC_PTR(dataInfo.pData);
-		dataInfo.nAllocatedSize = nNeededSize;
-	}
-	
 	return (XN_STATUS_OK);
 }
 
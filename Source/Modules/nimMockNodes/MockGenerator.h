@@ -23,6 +23,7 @@
 
 #include <XnModuleCppInterface.h>
 #include <XnTypes.h>
+#include <XnFramePool.h>
 #include "MockProductionNode.h"
 
 XN_PRAGMA_START_DISABLED_WARNING_SECTION(XN_INHERITS_VIA_DOMINANCE_WARNING_ID)
@@ -31,7 +32,8 @@ class MockGenerator :
 	public MockProductionNode,
 	virtual public xn::ModuleGenerator,
 	virtual public xn::ModuleMirrorInterface,
-	virtual public xn::ModuleFrameSyncInterface
+	virtual public xn::ModuleFrameSyncInterface,
+	virtual public xn::ModuleFrameLeaseInterface
 {
 public:
 	MockGenerator(xn::Context& context, const XnChar* strName, XnBool bAggregateData = FALSE);
@@ -60,6 +62,7 @@ public:
 	virtual xn::ModuleMirrorInterface* GetMirrorInterface();
 	virtual xn::ModuleAlternativeViewPointInterface* GetAlternativeViewPointInterface();
 	virtual xn::ModuleFrameSyncInterface* GetFrameSyncInterface();
+	virtual xn::ModuleFrameLeaseInterface* GetFrameLeaseInterface();
 
 	/*ModuleMirrorInterface*/
 	virtual XnStatus SetMirror(XnBool bMirror);
@@ -75,13 +78,22 @@ public:
 	virtual XnStatus RegisterToFrameSyncChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
 	virtual void UnregisterFromFrameSyncChange(XnCallbackHandle hCallback);
 
+	/*ModuleFrameLeaseInterface*/
+	virtual XnStatus AcquireFrame(XnFrameLease& lease);
+	virtual XnStatus ReleaseFrame(const XnFrameLease& lease);
+	virtual XnStatus SetFramePoolPolicy(const XnFramePoolPolicy& policy);
+	virtual XnStatus GetFramePoolPolicy(XnFramePoolPolicy& policy);
+
 protected:
 	XnStatus OnStateReady();
-	XnStatus ResizeBuffer(XnUInt32 nIndex, XnUInt32 nNeededSize);
 	XnStatus SetNewDataAvailable();
 
 	virtual XnUInt32 GetRequiredBufferSize();
 
+	/** Called by UpdateData() (with the pool lock held) when new data becomes current. The data 
+		is not leased yet, so it may be changed in place. */
+	virtual XnStatus OnNewCurrentData(void* pData, XnUInt32 nDataSize);
+
 private:
 	XnStatus SetNextData(const void *pData, XnUInt32 nSize);
 	XnStatus AppendToNextData(const void *pData, XnUInt32 nSize);
@@ -100,23 +112,12 @@ private:
 	PropChangeEvent m_mirrorChangeEvent;
 	PropChangeEvent m_frameSyncChangeEvent;
 
-	enum {NUM_BUFFERS = 2};
-	struct DataInfo
-	{
-		void *pData;
-		XnUInt32 nAllocatedSize;
-		XnUInt32 nDataSize;
-		XnUInt64 nTimeStamp;
-		XnUInt32 nFrameID;
-	} m_data[NUM_BUFFERS];
-	/*We save two buffers - one for current data and one for next data. The current data is in 
-	  m_data[m_nCurrentDataIdx], and the next data is in m_data[m_nNextDataIdx]. UpdateData just exchanges the
-	  two indices, and so the next data becomes the current data. The next data buffer's contents are not 
-	  interesting anymore, and will be overwritten by the next call to SetNextData().
+	/*The next data buffer's contents will be overwritten by the next call to SetNextData(), and UpdateData
+	  makes it the current data. m_hPoolLock protects the pool, as leases may be released from any thread.
 	*/
-
-	XnUInt32 m_nCurrentDataIdx;
-	XnUInt32 m_nNextDataIdx;
+	XnFramePool m_pool;
+	XnUInt32 m_nDroppedFrames;
+	XN_CRITICAL_SECTION_HANDLE m_hPoolLock;
 
 	XnBool m_bGenerating;
 	XnBool m_bMirror;
@@ -73,7 +73,11 @@ XnStatus MockProductionNode::SetIntProperty(const XnChar* strName, XnUInt64 nVal
 	}
 	else
 	{
-		XnStatus nRetVal = m_intProps.Set(strName, nValue);
+		XnAtom name = XN_INVALID_ATOM;
+		XnStatus nRetVal = xnAtomIntern(strName, &name);
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = m_intProps.Set(name, nValue);
 		XN_IS_STATUS_OK(nRetVal);
 
 		if (m_pNotifications != NULL)
@@ -88,7 +92,11 @@ XnStatus MockProductionNode::SetIntProperty(const XnChar* strName, XnUInt64 nVal
 
 XnStatus MockProductionNode::SetRealProperty(const XnChar* strName, XnDouble dValue)
 {
-	XnStatus nRetVal = m_realProps.Set(strName, dValue);
+	XnAtom name = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomIntern(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = m_realProps.Set(name, dValue);
 	XN_IS_STATUS_OK(nRetVal);
 
 	if (m_pNotifications != NULL)
@@ -102,13 +110,17 @@ XnStatus MockProductionNode::SetRealProperty(const XnChar* strName, XnDouble dVa
 
 XnStatus MockProductionNode::SetStringProperty(const XnChar* strName, const XnChar* strValue)
 {
+	XnAtom name = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomIntern(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
 	const XnChar* strOldVal = NULL;
-	if (m_stringProps.Get(strName, strOldVal) == XN_STATUS_OK)
+	if (m_stringProps.Get(name, strOldVal) == XN_STATUS_OK)
 	{
 		xnOSFree(strOldVal);
 	}
 
-	XnStatus nRetVal = m_stringProps.Set(strName, xnOSStrDup(strValue));
+	nRetVal = m_stringProps.Set(name, xnOSStrDup(strValue));
 	XN_IS_STATUS_OK(nRetVal);
 
 	if (m_pNotifications != NULL)
@@ -125,7 +137,11 @@ XnStatus MockProductionNode::SetGeneralProperty(const XnChar* strName, XnUInt32
 	XnStatus nRetVal = XN_STATUS_OK;
 	XnGeneralBuffer generalBuffer = {NULL, 0};
 
-	m_generalProps.Get(strName, generalBuffer);
+	XnAtom name = XN_INVALID_ATOM;
+	nRetVal = xnAtomIntern(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
+	m_generalProps.Get(name, generalBuffer);
 	//If m_generalProps.Get() failed, generalBuffer is still not allocated, and XnGeneralBufferAlloc will allocate it.
 	if (nBufferSize != generalBuffer.nDataSize)
 	{
@@ -136,7 +152,7 @@ XnStatus MockProductionNode::SetGeneralProperty(const XnChar* strName, XnUInt32
 	}
 	xnOSMemCopy(generalBuffer.pData, pBuffer, nBufferSize);
 
-	nRetVal = m_generalProps.Set(strName, generalBuffer);
+	nRetVal = m_generalProps.Set(name, generalBuffer);
 	if (nRetVal != XN_STATUS_OK)
 	{
 		XnGeneralBufferFree(&generalBuffer);
@@ -158,21 +174,34 @@ XnStatus MockProductionNode::SetGeneralProperty(const XnChar* strName, XnUInt32
 
 XnStatus MockProductionNode::GetIntProperty(const XnChar* strName, XnUInt64& nValue) const
 {
-	return m_intProps.Get(strName, nValue);
+	// a name that was never interned was never set
+	XnAtom name = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomFind(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return m_intProps.Get(name, nValue);
 }
 
 XnStatus MockProductionNode::GetRealProperty(const XnChar* strName, XnDouble& dValue) const
 {
-	return m_realProps.Get(strName, dValue);
+	XnAtom name = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomFind(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return m_realProps.Get(name, dValue);
 }
 
 XnStatus MockProductionNode::GetStringProperty(const XnChar* strName, XnChar* csValue, XnUInt32 nBufSize) const
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
+	XnAtom name = XN_INVALID_ATOM;
+	nRetVal = xnAtomFind(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
 	const XnChar* val;
 
-	nRetVal = m_stringProps.Get(strName, val);
+	nRetVal = m_stringProps.Get(name, val);
 	XN_IS_STATUS_OK(nRetVal);
 
 	if (strlen(val) > nBufSize)
@@ -187,8 +216,12 @@ XnStatus MockProductionNode::GetStringProperty(const XnChar* strName, XnChar* cs
 
 XnStatus MockProductionNode::GetGeneralProperty(const XnChar* strName, XnUInt32 nBufferSize, void* pBuffer) const
 {
+	XnAtom name = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomFind(strName, &name);
+	XN_IS_STATUS_OK(nRetVal);
+
 	XnGeneralBuffer source;
-	XnStatus nRetVal = m_generalProps.Get(strName, source);
+	nRetVal = m_generalProps.Get(name, source);
 	XN_IS_STATUS_OK(nRetVal);
 	XnGeneralBuffer dest = XnGeneralBufferPack(pBuffer, nBufferSize);
 	nRetVal = XnGeneralBufferCopy(&dest, &source);
@@ -203,28 +236,28 @@ XnStatus MockProductionNode::NotifyExState(XnNodeNotifications* pNotifications,
 	// notify int props
 	for (IntProps::ConstIterator it = m_intProps.Begin(); it != m_intProps.End(); ++it)
 	{
-		nRetVal = pNotifications->OnNodeIntPropChanged(pCookie, m_strName, it->Key(), it->Value());
+		nRetVal = pNotifications->OnNodeIntPropChanged(pCookie, m_strName, xnAtomGetString(it->Key()), it->Value());
 		XN_IS_STATUS_OK(nRetVal);
 	}
 
 	// notify real props
 	for (RealProps::ConstIterator it = m_realProps.Begin(); it != m_realProps.End(); ++it)
 	{
-		nRetVal = pNotifications->OnNodeRealPropChanged(pCookie, m_strName, it->Key(), it->Value());
+		nRetVal = pNotifications->OnNodeRealPropChanged(pCookie, m_strName, xnAtomGetString(it->Key()), it->Value());
 		XN_IS_STATUS_OK(nRetVal);
 	}
 
 	// notify string props
 	for (StringProps::ConstIterator it = m_stringProps.Begin(); it != m_stringProps.End(); ++it)
 	{
-		nRetVal = pNotifications->OnNodeStringPropChanged(pCookie, m_strName, it->Key(), it->Value());
+		nRetVal = pNotifications->OnNodeStringPropChanged(pCookie, m_strName, xnAtomGetString(it->Key()), it->Value());
 		XN_IS_STATUS_OK(nRetVal);
 	}
 
 	// notify general props
 	for (GeneralProps::ConstIterator it = m_generalProps.Begin(); it != m_generalProps.End(); ++it)
 	{
-		nRetVal = pNotifications->OnNodeGeneralPropChanged(pCookie, m_strName, it->Key(), it->Value().nDataSize, it->Value().pData);
+		nRetVal = pNotifications->OnNodeGeneralPropChanged(pCookie, m_strName, xnAtomGetString(it->Key()), it->Value().nDataSize, it->Value().pData);
 		XN_IS_STATUS_OK(nRetVal);
 	}
 
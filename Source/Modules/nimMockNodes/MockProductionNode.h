@@ -23,7 +23,8 @@
 
 #include <XnModuleCppInterface.h>
 #include <XnTypes.h>
-#include <XnStringsHashT.h>
+#include <XnHashT.h>
+#include <XnAtoms.h>
 #include <XnGeneralBuffer.h>
 #include <XnEventT.h>
 
@@ -55,10 +56,11 @@ protected:
 
 	virtual XnStatus OnStateReady();
 
-	typedef XnStringsHashT<XnUInt64> IntProps;
-	typedef XnStringsHashT<XnDouble> RealProps;
-	typedef XnStringsHashT<const XnChar*> StringProps;
-	typedef XnStringsHashT<XnGeneralBuffer> GeneralProps;
+	// keyed by property name atom. Names are only hashed once per call, never per lookup.
+	typedef XnHashT<XnAtom, XnUInt64> IntProps;
+	typedef XnHashT<XnAtom, XnDouble> RealProps;
+	typedef XnHashT<XnAtom, const XnChar*> StringProps;
+	typedef XnHashT<XnAtom, XnGeneralBuffer> GeneralProps;
 
 	xn::Context m_context;
 	XnChar m_strName[XN_MAX_NAME_LENGTH];
@@ -68,6 +68,11 @@ const XnUInt64 PlayerNode::RECORD_MAX_SIZE =
 
 const XnVersion PlayerNode::OLDEST_SUPPORTED_FILE_FORMAT_VERSION = {1, 0, 0, 4};
 const XnVersion PlayerNode::FIRST_FILESIZE64BIT_FILE_FORMAT_VERSION = {1, 0, 1, 0};
+//When the header does not tell the max node ID (stream was not finalized), the node table starts with this 
+//size, and grows as nodes are added
+const XnUInt32 PlayerNode::OPEN_ENDED_INITIAL_NODES = 16;
+//Node IDs are assigned sequentially by the recorder, so anything above this is a corrupt stream
+const XnUInt32 PlayerNode::OPEN_ENDED_MAX_NODE_ID = 0xFFFF;
 
 PlayerNode::PlayerNode(xn::Context &context, const XnChar* strName) :
 	m_bOpen(FALSE),
@@ -84,12 +89,20 @@ PlayerNode::PlayerNode(xn::Context &context, const XnChar* strName) :
 	m_pNodeInfoMap(NULL),
 	m_nMaxNodes(0),
 	m_bEOF(FALSE),
+	m_nSegment(0),
+	m_pSegmentFrames(NULL),
+	m_nSegments(0),
+	m_bCanDropFrames(FALSE),
 	m_aSeekTempArray(NULL),
 	m_hSelf(NULL),
 	m_bIs32bitFileFormat(FALSE),
+	m_bSeekable(TRUE),
+	m_bOpenEnded(FALSE),
 	m_pUncompressedData(NULL)
 {
 	xnOSMemSet(&m_fileVersion, 0, sizeof(m_fileVersion));
+	xnOSMemSet(&m_playbackClock, 0, sizeof(m_playbackClock));
+	xnOSMemSet(&m_segmentedStream, 0, sizeof(m_segmentedStream));
 	xnOSStrCopy(m_strName, strName, sizeof(m_strName));
 }
 
@@ -129,6 +142,10 @@ XnStatus PlayerNode::Destroy()
 		m_aSeekTempArray = NULL;
 	}
 
+	XN_DELETE_ARR(m_pSegmentFrames);
+	m_pSegmentFrames = NULL;
+	m_nSegments = 0;
+
 	XN_DELETE_ARR(m_pRecordBuffer);
 	m_pRecordBuffer = NULL;
 	XN_DELETE_ARR(m_pUncompressedData);
@@ -142,6 +159,7 @@ XnStatus PlayerNode::SetInputStream(void *pStreamCookie, XnPlayerInputStreamInte
 	XN_VALIDATE_INPUT_PTR(pStream);
 	m_pStreamCookie = pStreamCookie;
 	m_pInputStream = pStream;
+	m_bSeekable = (pStream->Seek64 != NULL);
 	XnStatus nRetVal = OpenStream();
 	XN_IS_STATUS_OK(nRetVal);
 	return XN_STATUS_OK;
@@ -161,6 +179,39 @@ XnStatus PlayerNode::SetRepeat(XnBool bRepeat)
 	return XN_STATUS_OK;
 }
 
+XnStatus PlayerNode::SetGeneralProperty(const XnChar* strName, XnUInt32 nBufferSize, const void* pBuffer)
+{
+	if (strcmp(strName, XN_PROP_PLAYBACK_CLOCK) == 0)
+	{
+		if (nBufferSize != sizeof(XnPlaybackClock))
+		{
+			return XN_STATUS_INVALID_BUFFER_SIZE;
+		}
+
+		xnOSMemCopy(&m_playbackClock, pBuffer, sizeof(m_playbackClock));
+		return XN_STATUS_OK;
+	}
+	else if (strcmp(strName, XN_PROP_SEGMENTED_INPUT_STREAM) == 0)
+	{
+		// later versions of the interface may be bigger. We only use what we know of.
+		const XnPlayerSegmentedInputStreamInterface* pSegmentedStream = (const XnPlayerSegmentedInputStreamInterface*)pBuffer;
+		if (nBufferSize < sizeof(XnPlayerSegmentedInputStreamInterface) || pSegmentedStream->nVersion < XN_PLAYER_SEGMENTED_INPUT_STREAM_VERSION)
+		{
+			return XN_STATUS_INVALID_BUFFER_SIZE;
+		}
+
+		if (m_bOpen)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Segmented input stream must be set before the input stream");
+		}
+
+		xnOSMemCopy(&m_segmentedStream, pSegmentedStream, sizeof(m_segmentedStream));
+		return XN_STATUS_OK;
+	}
+
+	return ModulePlayer::SetGeneralProperty(strName, nBufferSize, pBuffer);
+}
+
 XnStatus PlayerNode::SeekToTimeStamp(XnInt64 /*nTimeOffset*/, XnPlayerSeekOrigin /*origin*/)
 {
 	/*
@@ -182,6 +233,11 @@ XnStatus PlayerNode::SeekToTimeStamp(XnInt64 /*nTimeOffset*/, XnPlayerSeekOrigin
 XnStatus PlayerNode::SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset, XnPlayerSeekOrigin origin)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
+	if (!m_bSeekable)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Cannot seek in a live stream");
+	}
+
 	XnUInt32 nNodeID = GetPlayerNodeIDByName(strNodeName);
 	if (nNodeID == INVALID_NODE_ID)
 	{
@@ -190,6 +246,11 @@ XnStatus PlayerNode::SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset
 
 	PlayerNodeInfo* pPlayerNodeInfo = &m_pNodeInfoMap[nNodeID];
 
+	// frame numbers span all segments
+	XnUInt32 nFrames = 0;
+	nRetVal = GetNumFrames(strNodeName, nFrames);
+	XN_IS_STATUS_OK(nRetVal);
+
 	XnInt64 nOriginFrame = 0;
 	switch (origin)
 	{
@@ -200,12 +261,12 @@ XnStatus PlayerNode::SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset
 		}
 		case XN_PLAYER_SEEK_CUR:
 		{
-			nOriginFrame = pPlayerNodeInfo->nCurFrame;
+			nOriginFrame = pPlayerNodeInfo->nFrameBase + pPlayerNodeInfo->nCurFrame;
 			break;
 		}
 		case XN_PLAYER_SEEK_END:
 		{
-			nOriginFrame = pPlayerNodeInfo->nFrames;
+			nOriginFrame = nFrames;
 			break;
 		}
 		default:
@@ -214,7 +275,31 @@ XnStatus PlayerNode::SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset
 			XN_LOG_ERROR_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Invalid seek origin: %u", origin);
 		}
 	}
-	XnUInt32 nDestFrame = (XnUInt32)XN_MIN(XN_MAX(1, nOriginFrame + nFrameOffset), pPlayerNodeInfo->nFrames);
+	XnUInt32 nDestFrame = (XnUInt32)XN_MIN(XN_MAX(1, nOriginFrame + nFrameOffset), nFrames);
+
+	if (m_pSegmentFrames != NULL)
+	{
+		XnUInt32 nSegment = 0;
+		XnUInt32 nFrameBase = 0;
+		nRetVal = FindFrameSegment(strNodeName, nDestFrame, nSegment, nFrameBase);
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (nSegment != m_nSegment)
+		{
+			nRetVal = OpenSegment(nSegment);
+			XN_IS_STATUS_OK(nRetVal);
+
+			// node IDs are per segment
+			nNodeID = GetPlayerNodeIDByName(strNodeName);
+			if (nNodeID == INVALID_NODE_ID)
+			{
+				XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Node '%s' is missing from segment %u", strNodeName, nSegment);
+			}
+		}
+
+		nDestFrame -= nFrameBase;
+	}
+
 	nRetVal = SeekToFrameAbsolute(nNodeID, nDestFrame);
 	XN_IS_STATUS_OK(nRetVal);
 
@@ -259,10 +344,14 @@ DataIndexEntry* PlayerNode::FindFrameForSeekPosition(XnUInt32 nNodeID, XnUInt64
 {
 	XN_ASSERT((nNodeID != INVALID_NODE_ID) && (nNodeID < m_nMaxNodes));
 	PlayerNodeInfo* pPlayerNodeInfo = &m_pNodeInfoMap[nNodeID];
+	if (pPlayerNodeInfo->pDataIndex == NULL)
+	{
+		return NULL;
+	}
 	
 	// perform binary search. We're looking for the highest timestamp BEFORE searched timestamp
 	int first = 1;
-	int last = pPlayerNodeInfo->nFrames;
+	int last = pPlayerNodeInfo->nIndexedFrames;
 	int mid;
 	XnUInt64 nMidPos;
 
@@ -297,6 +386,13 @@ DataIndexEntry** PlayerNode::GetSeekLocationsFromDataIndex(XnUInt32 nNodeID, XnU
 		return NULL;
 	}
 
+	if (pPlayerNodeInfo->nCurFrame > pPlayerNodeInfo->nIndexedFrames || nDestFrame > pPlayerNodeInfo->nIndexedFrames)
+	{
+		// recording was not closed, and the seek table does not cover these frames
+		xnLogVerbose(XN_MASK_OPEN_NI, "Seeking from %u to %u: Slow seek being used (frames are not in seek table)", pPlayerNodeInfo->nCurFrame, nDestFrame);
+		return NULL;
+	}
+
 	DataIndexEntry* pCurrentFrame = &pPlayerNodeInfo->pDataIndex[pPlayerNodeInfo->nCurFrame];
 	DataIndexEntry* pDestFrame = &pPlayerNodeInfo->pDataIndex[nDestFrame];
 
@@ -314,6 +410,12 @@ DataIndexEntry** PlayerNode::GetSeekLocationsFromDataIndex(XnUInt32 nNodeID, XnU
 	{
 		if (m_pNodeInfoMap[i].bIsGenerator && i != nNodeID)
 		{
+			if (m_pNodeInfoMap[i].pDataIndex == NULL && m_pNodeInfoMap[i].nFrames > 0)
+			{
+				xnLogVerbose(XN_MASK_OPEN_NI, "Seeking from %u to %u: Slow seek being used (other nodes don't have seek tables)", pPlayerNodeInfo->nCurFrame, nDestFrame);
+				return NULL;
+			}
+
 			m_aSeekTempArray[i] = FindFrameForSeekPosition(i, pDestFrame->nSeekPos);
 			if (m_aSeekTempArray[i] != NULL && m_aSeekTempArray[i]->nConfigurationID != pCurrentFrame->nConfigurationID)
 			{
@@ -562,7 +664,7 @@ XnStatus PlayerNode::TellFrame(const XnChar* strNodeName, XnUInt32& nFrameNumber
 		return XN_STATUS_BAD_NODE_NAME;
 	}
 
-	nFrameNumber = pPlayerNodeInfo->nCurFrame;
+	nFrameNumber = pPlayerNodeInfo->nFrameBase + pPlayerNodeInfo->nCurFrame;
 	return XN_STATUS_OK;
 }
 
@@ -576,7 +678,14 @@ XnUInt32 PlayerNode::GetNumFrames(const XnChar* strNodeName, XnUInt32& nFrames)
 		return XN_STATUS_BAD_NODE_NAME;
 	}
 
-	nFrames = pPlayerNodeInfo->nFrames;
+	if (m_pSegmentFrames == NULL)
+	{
+		nFrames = pPlayerNodeInfo->nFrames;
+		return XN_STATUS_OK;
+	}
+
+	// the frames of all segments. The one being played may have grown since it was scanned, if it's being written.
+	nFrames = XN_MAX(GetSegmentFrameBase(strNodeName, m_nSegments), pPlayerNodeInfo->nFrameBase + pPlayerNodeInfo->nFrames);
 	return XN_STATUS_OK;
 }
 
@@ -602,7 +711,10 @@ void PlayerNode::UnregisterFromEndOfFileReached(XnCallbackHandle hCallback)
 
 XnStatus PlayerNode::ReadNext()
 {
-	return ProcessRecord(TRUE);
+	m_bCanDropFrames = TRUE;
+	XnStatus nRetVal = ProcessRecord(TRUE);
+	m_bCanDropFrames = FALSE;
+	return (nRetVal);
 }
 
 XnStatus PlayerNode::ProcessRecord(XnBool bProcessPayload)
@@ -610,8 +722,17 @@ XnStatus PlayerNode::ProcessRecord(XnBool bProcessPayload)
 	//Read a record and handle it
 	Record record(m_pRecordBuffer, RECORD_MAX_SIZE, m_bIs32bitFileFormat);
 	XnStatus nRetVal = ReadRecord(record);
-	XN_IS_STATUS_OK(nRetVal);
-	nRetVal = HandleRecord(record, bProcessPayload);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = HandleRecord(record, bProcessPayload);
+	}
+
+	if (nRetVal == XN_STATUS_EOF)
+	{
+		// stream ended without an end record (recording was not closed)
+		return HandleEndOfStream();
+	}
+
 	XN_IS_STATUS_OK(nRetVal);
 	return XN_STATUS_OK;
 }
@@ -621,6 +742,34 @@ XnStatus PlayerNode::OpenStream()
 	XN_VALIDATE_INPUT_PTR(m_pInputStream);
 	XnStatus nRetVal = m_pInputStream->Open(m_pStreamCookie);
 	XN_IS_STATUS_OK(nRetVal);
+	m_nSegment = 0;
+	nRetVal = ReadHeader();
+	XN_IS_STATUS_OK(nRetVal);
+	
+	m_bOpen = TRUE;
+
+	if (m_segmentedStream.nVersion != 0)
+	{
+		nRetVal = ScanSegments();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	nRetVal = ProcessUntilFirstData();
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_DELETE_ARR(m_pNodeInfoMap);
+		m_pNodeInfoMap = NULL;
+		xnOSFree(m_aSeekTempArray);
+		m_aSeekTempArray = NULL;
+		return nRetVal;
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus PlayerNode::ReadHeader()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
 	RecordingHeader header;
 	XnUInt32 nBytesRead = 0;
 	
@@ -653,26 +802,220 @@ XnStatus PlayerNode::OpenStream()
 
 	m_fileVersion = header.version;
 	m_nGlobalMaxTimeStamp = header.nGlobalMaxTimeStamp;
-	m_nMaxNodes = header.nMaxNodeID + 1;
+	m_bOpenEnded = (header.nMaxNodeID == INVALID_NODE_ID);
+	if (m_bOpenEnded)
+	{
+		// header is only written when the recording is closed. Frames and timestamps will be learned
+		// as we go.
+		xnLogInfo(XN_MASK_OPEN_NI, "Recording header was not finalized (live stream or unclosed recording)");
+		m_nMaxNodes = OPEN_ENDED_INITIAL_NODES;
+	}
+	else
+	{
+		m_nMaxNodes = header.nMaxNodeID + 1;
+	}
 	XN_ASSERT(m_nMaxNodes > 0);
 	XN_DELETE_ARR(m_pNodeInfoMap);
 	xnOSFree(m_aSeekTempArray);
 	m_pNodeInfoMap = XN_NEW_ARR(PlayerNodeInfo, m_nMaxNodes);
 	XN_VALIDATE_ALLOC_PTR(m_pNodeInfoMap);
 	XN_VALIDATE_CALLOC(m_aSeekTempArray, DataIndexEntry*, m_nMaxNodes);
-	
-	m_bOpen = TRUE;
+
+	return XN_STATUS_OK;
+}
+
+XnStatus PlayerNode::OpenSegment(XnUInt32 nSegment)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (m_segmentedStream.nVersion == 0)
+	{
+		return (XN_STATUS_NO_MATCH);
+	}
+
+	nRetVal = m_segmentedStream.OpenSegment(m_segmentedStream.pCookie, nSegment);
+	XN_IS_STATUS_OK(nRetVal);
+	m_nSegment = nSegment;
+
+	/* Each segment adds its nodes again (they keep playing), but node IDs and codecs are per segment. */
+	for (XnUInt32 i = 0; i < m_nMaxNodes; i++)
+	{
+		if (m_pNodeInfoMap[i].codec.IsValid())
+		{
+			xnRemoveNeededNode(GetSelfNodeHandle(), m_pNodeInfoMap[i].codec);
+			m_pNodeInfoMap[i].codec.Release();
+		}
+		m_pNodeInfoMap[i].Reset();
+	}
+
+	nRetVal = ReadHeader();
+	XN_IS_STATUS_OK(nRetVal);
+
+	m_bDataBegun = FALSE;
+	m_nTimeStamp = 0;
+	m_bEOF = FALSE;
+
 	nRetVal = ProcessUntilFirstData();
-	if (nRetVal != XN_STATUS_OK)
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus PlayerNode::ScanSegments()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// frame numbers go on from one segment to the next, so frame counts of all segments are needed up front
+	XnUInt32 nSegments = m_segmentedStream.GetSegmentCount(m_segmentedStream.pCookie);
+	if (nSegments <= 1)
 	{
-		XN_DELETE_ARR(m_pNodeInfoMap);
-		m_pNodeInfoMap = NULL;
-		xnOSFree(m_aSeekTempArray);
-		m_aSeekTempArray = NULL;
-		return nRetVal;
+		return (XN_STATUS_OK);
 	}
 
-	return XN_STATUS_OK;
+	XN_DELETE_ARR(m_pSegmentFrames);
+	m_pSegmentFrames = XN_NEW_ARR(SegmentFramesMap, nSegments);
+	XN_VALIDATE_ALLOC_PTR(m_pSegmentFrames);
+	m_nSegments = nSegments;
+
+	for (XnUInt32 i = 0; i < nSegments; ++i)
+	{
+		// the first one too, as its header was already read
+		nRetVal = m_segmentedStream.OpenSegment(m_segmentedStream.pCookie, i);
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = ScanSegment(m_pSegmentFrames[i]);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to scan segment %u: %s", i, xnGetStatusString(nRetVal));
+		}
+	}
+
+	// and back to the first one
+	nRetVal = m_segmentedStream.OpenSegment(m_segmentedStream.pCookie, 0);
+	XN_IS_STATUS_OK(nRetVal);
+	m_nSegment = 0;
+
+	return ReadHeader();
+}
+
+XnStatus PlayerNode::ScanSegment(SegmentFramesMap& segmentFrames)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = ReadHeader();
+	XN_IS_STATUS_OK(nRetVal);
+
+	// only record headers are read. Node IDs are per segment, so nodes are matched by name.
+	XnHashT<XnUInt32, XnAtom> nodeNames;
+	Record record(m_pRecordBuffer, RECORD_MAX_SIZE, m_bIs32bitFileFormat);
+	for (;;)
+	{
+		nRetVal = ReadRecord(record);
+		if (nRetVal == XN_STATUS_EOF)
+		{
+			// segment was not closed
+			break;
+		}
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (record.GetType() == RECORD_END)
+		{
+			break;
+		}
+
+		XnUInt32 nNodeFrames = 0;
+		XnAtom nodeName = XN_INVALID_ATOM;
+
+		if (record.GetType() == RECORD_NODE_ADDED)
+		{
+			NodeAddedRecord nodeAddedRecord(record);
+			nRetVal = nodeAddedRecord.Decode();
+			XN_IS_STATUS_OK(nRetVal);
+
+			nRetVal = xnAtomIntern(nodeAddedRecord.GetNodeName(), &nodeName);
+			XN_IS_STATUS_OK(nRetVal);
+			nRetVal = nodeNames.Set(nodeAddedRecord.GetNodeID(), nodeName);
+			XN_IS_STATUS_OK(nRetVal);
+
+			// set when the segment was closed
+			nNodeFrames = nodeAddedRecord.GetNumberOfFrames();
+		}
+		else if (record.GetType() == RECORD_NEW_DATA)
+		{
+			NewDataRecordHeader newDataRecord(record);
+			nRetVal = newDataRecord.Decode();
+			XN_IS_STATUS_OK(nRetVal);
+
+			if (nodeNames.Get(newDataRecord.GetNodeID(), nodeName) != XN_STATUS_OK)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Got data of unknown node %u", newDataRecord.GetNodeID());
+			}
+
+			// in case the segment was not closed
+			nNodeFrames = newDataRecord.GetFrameNumber();
+		}
+
+		if (nodeName != XN_INVALID_ATOM)
+		{
+			XnUInt32 nFrames = 0;
+			segmentFrames.Get(nodeName, nFrames);
+			nRetVal = segmentFrames.Set(nodeName, XN_MAX(nFrames, nNodeFrames));
+			XN_IS_STATUS_OK(nRetVal);
+		}
+
+		nRetVal = SkipRecordPayload(record);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnUInt32 PlayerNode::GetSegmentFrameBase(const XnChar* strNodeName, XnUInt32 nSegment)
+{
+	XnAtom nodeName = XN_INVALID_ATOM;
+	if (m_pSegmentFrames == NULL || xnAtomFind(strNodeName, &nodeName) != XN_STATUS_OK)
+	{
+		return 0;
+	}
+
+	XnUInt32 nFrameBase = 0;
+	for (XnUInt32 i = 0; i < nSegment && i < m_nSegments; ++i)
+	{
+		XnUInt32 nFrames = 0;
+		if (m_pSegmentFrames[i].Get(nodeName, nFrames) == XN_STATUS_OK)
+		{
+			nFrameBase += nFrames;
+		}
+	}
+
+	return nFrameBase;
+}
+
+XnStatus PlayerNode::FindFrameSegment(const XnChar* strNodeName, XnUInt32 nFrame, XnUInt32& nSegment, XnUInt32& nFrameBase)
+{
+	XnAtom nodeName = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomFind(strNodeName, &nodeName);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nFrameBase = 0;
+	for (nSegment = 0; nSegment < m_nSegments; ++nSegment)
+	{
+		XnUInt32 nFrames = 0;
+		m_pSegmentFrames[nSegment].Get(nodeName, nFrames);
+		if (nFrame <= nFrameBase + nFrames)
+		{
+			return (XN_STATUS_OK);
+		}
+
+		nFrameBase += nFrames;
+	}
+
+	// past the scanned frames: the last segment grew since it was scanned (it is still being written)
+	XnUInt32 nLastFrames = 0;
+	nSegment = m_nSegments - 1;
+	m_pSegmentFrames[nSegment].Get(nodeName, nLastFrames);
+	nFrameBase -= nLastFrames;
+	return (XN_STATUS_OK);
 }
 
 XnStatus PlayerNode::Read(void *pData, XnUInt32 nSize, XnUInt32 &nBytesRead)
@@ -692,6 +1035,13 @@ XnStatus PlayerNode::ReadRecordHeader(Record &record)
 	XnStatus nRetVal = Read(record.GetData(), record.HEADER_SIZE, nBytesRead);
 	XN_IS_STATUS_OK(nRetVal);
 
+	if (m_bOpenEnded && (nBytesRead != record.HEADER_SIZE || !record.IsHeaderValid()))
+	{
+		// a recording that was not closed ends wherever writing stopped (possibly in the middle of a record)
+		xnLogInfo(XN_MASK_OPEN_NI, "Recording is truncated at position %llu", TellStream() - nBytesRead);
+		return XN_STATUS_EOF;
+	}
+
 	if (nBytesRead != record.HEADER_SIZE)
 	{
 		XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Incorrect number of bytes read");
@@ -713,6 +1063,10 @@ XnStatus PlayerNode::ReadRecordFields(Record &record)
 	XN_IS_STATUS_OK(nRetVal);
 	if (nBytesRead < nBytesToRead)
 	{
+		if (m_bOpenEnded)
+		{
+			return XN_STATUS_EOF;
+		}
 		XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Incorrect number of bytes read");
 	}
 	return XN_STATUS_OK;
@@ -730,7 +1084,31 @@ XnStatus PlayerNode::ReadRecord(Record &record)
 XnStatus PlayerNode::SeekStream(XnOSSeekType seekType, XnInt64 nOffset)
 {
 	XN_VALIDATE_INPUT_PTR(m_pInputStream);
-	return m_pInputStream->Seek64(m_pStreamCookie, seekType, nOffset);
+	if (m_bSeekable)
+	{
+		return m_pInputStream->Seek64(m_pStreamCookie, seekType, nOffset);
+	}
+
+	// a live stream can only skip forward, by reading and discarding
+	if (seekType != XN_OS_SEEK_CUR || nOffset < 0)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Cannot seek backwards in a live stream");
+	}
+
+	while (nOffset > 0)
+	{
+		XnUInt32 nBytesToRead = (XnUInt32)XN_MIN((XnUInt64)nOffset, DATA_MAX_SIZE);
+		XnUInt32 nBytesRead = 0;
+		XnStatus nRetVal = Read(m_pUncompressedData, nBytesToRead, nBytesRead);
+		XN_IS_STATUS_OK(nRetVal);
+		if (nBytesRead < nBytesToRead)
+		{
+			XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Incorrect number of bytes read");
+		}
+		nOffset -= nBytesRead;
+	}
+
+	return XN_STATUS_OK;
 }
 
 XnUInt64 PlayerNode::TellStream()
@@ -778,6 +1156,8 @@ XnStatus PlayerNode::HandleRecord(Record &record, XnBool bHandlePayload)
 		case RECORD_SEEK_TABLE:
 			// never process this record (it is processed only during node added)
 			return HandleDataIndexRecord(record, FALSE);
+		case RECORD_SEEK_TABLE_CHUNK:
+			return HandleDataIndexChunkRecord(record);
 		case RECORD_END:
 			return HandleEndRecord(record);
 
@@ -793,6 +1173,41 @@ XnStatus PlayerNode::HandleRecord(Record &record, XnBool bHandlePayload)
 	}		
 }
 
+XnStatus PlayerNode::GrowNodeInfoMap(XnUInt32 nNodeID)
+{
+	if (nNodeID > OPEN_ENDED_MAX_NODE_ID)
+	{
+		XN_ASSERT(FALSE);
+		XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Got node ID %u, which is out of range for a stream without a finalized header", nNodeID);
+	}
+
+	XnUInt32 nMaxNodes = XN_MAX(m_nMaxNodes * 2, nNodeID + 1);
+
+	PlayerNodeInfo* pNodeInfoMap = XN_NEW_ARR(PlayerNodeInfo, nMaxNodes);
+	XN_VALIDATE_ALLOC_PTR(pNodeInfoMap);
+	DataIndexEntry** aSeekTempArray = (DataIndexEntry**)xnOSCalloc(nMaxNodes, sizeof(DataIndexEntry*));
+	if (aSeekTempArray == NULL)
+	{
+		XN_DELETE_ARR(pNodeInfoMap);
+		return (XN_STATUS_ALLOC_FAILED);
+	}
+
+	for (XnUInt32 i = 0; i < m_nMaxNodes; ++i)
+	{
+		pNodeInfoMap[i] = m_pNodeInfoMap[i];
+		// the data index now belongs to the new entry
+		m_pNodeInfoMap[i].pDataIndex = NULL;
+	}
+
+	XN_DELETE_ARR(m_pNodeInfoMap);
+	xnOSFree(m_aSeekTempArray);
+	m_pNodeInfoMap = pNodeInfoMap;
+	m_aSeekTempArray = aSeekTempArray;
+	m_nMaxNodes = nMaxNodes;
+
+	return (XN_STATUS_OK);
+}
+
 PlayerNode::PlayerNodeInfo* PlayerNode::GetPlayerNodeInfo(XnUInt32 nNodeID)
 {
 	if (nNodeID >= m_nMaxNodes)
@@ -839,6 +1254,12 @@ XnStatus PlayerNode::HandleNodeAddedImpl(XnUInt32 nNodeID, XnProductionNodeType
 
 	XnStatus nRetVal = XN_STATUS_OK;
 
+	if (m_bOpenEnded && nNodeID >= m_nMaxNodes)
+	{
+		nRetVal = GrowNodeInfoMap(nNodeID);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
 	PlayerNodeInfo* pPlayerNodeInfo = GetPlayerNodeInfo(nNodeID);
 	XN_VALIDATE_PTR(pPlayerNodeInfo, XN_STATUS_CORRUPT_FILE);
 
@@ -855,6 +1276,7 @@ XnStatus PlayerNode::HandleNodeAddedImpl(XnUInt32 nNodeID, XnProductionNodeType
 		pPlayerNodeInfo->bIsGenerator = TRUE;
 		pPlayerNodeInfo->nFrames = nNumberOfFrames;
 		pPlayerNodeInfo->nMaxTimeStamp = nMaxTimestamp;
+		pPlayerNodeInfo->nFrameBase = GetSegmentFrameBase(strName, m_nSegment);
 	}
 
 	//Mark this player node as valid
@@ -862,12 +1284,13 @@ XnStatus PlayerNode::HandleNodeAddedImpl(XnUInt32 nNodeID, XnProductionNodeType
 
 	//Loop until this node's state is ready.
 	//TODO: Check for eof
-	while (!pPlayerNodeInfo->bStateReady)
+	//(the node table may grow while processing, so don't keep pointers into it)
+	while (!m_pNodeInfoMap[nNodeID].bStateReady)
 	{
 		nRetVal = ProcessRecord(TRUE);
 		if (nRetVal != XN_STATUS_OK)
 		{
-			pPlayerNodeInfo->bValid = FALSE;
+			m_pNodeInfoMap[nNodeID].bValid = FALSE;
 			return nRetVal;
 		}
 	}
@@ -977,18 +1400,28 @@ XnStatus PlayerNode::HandleNodeAddedRecord(NodeAddedRecord record)
 	XN_IS_STATUS_OK(nRetVal);
 
 	// get seek table (if exists)
-	if (record.GetNumberOfFrames() > 0 && record.GetSeekTablePosition() != 0)
+	if (record.GetNumberOfFrames() > 0 && record.GetSeekTablePosition() != 0 && m_bSeekable)
 	{
 		XnUInt64 nCurrPos = TellStream();
+		XnUInt32 nNodeID = record.GetNodeID();
+		XnUInt64 nSeekTablePos = record.GetSeekTablePosition();
 
-		nRetVal = SeekStream(XN_OS_SEEK_SET, record.GetSeekTablePosition());
+		nRetVal = SeekStream(XN_OS_SEEK_SET, nSeekTablePos);
 		XN_IS_STATUS_OK(nRetVal);
 
 		DataIndexRecordHeader seekTableHeader(m_pRecordBuffer, RECORD_MAX_SIZE, m_bIs32bitFileFormat);
 		nRetVal = ReadRecord(seekTableHeader);
 		XN_IS_STATUS_OK(nRetVal);
 
-		nRetVal = HandleDataIndexRecord(seekTableHeader, TRUE);
+		if (seekTableHeader.GetType() == RECORD_SEEK_TABLE_CHUNK)
+		{
+			// seek table was written in chunks, and this is the last one
+			nRetVal = ReadDataIndexChunks(nNodeID, nSeekTablePos);
+		}
+		else
+		{
+			nRetVal = HandleDataIndexRecord(seekTableHeader, TRUE);
+		}
 		XN_IS_STATUS_OK(nRetVal);
 
 		// and seek back
@@ -1198,6 +1631,13 @@ XnStatus PlayerNode::HandleStringPropRecord(StringPropRecord record)
 		return XN_STATUS_CORRUPT_FILE;
 	}
 
+	if (strcmp(record.GetPropName(), XN_PROP_FRAME_SYNCED_WITH) == 0)
+	{
+		// (needed to drop frames of synced nodes together)
+		nRetVal = xnOSStrCopy(pPlayerNodeInfo->strFrameSyncedWith, record.GetValue(), sizeof(pPlayerNodeInfo->strFrameSyncedWith));
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
 	nRetVal = m_pNodeNotifications->OnNodeStringPropChanged(m_pNotificationsCookie, 
 		pPlayerNodeInfo->strName,
 		record.GetPropName(),
@@ -1331,8 +1771,14 @@ XnStatus PlayerNode::HandleNewDataRecord(NewDataRecordHeader record, XnBool bRea
 	pPlayerNodeInfo->newDataUndoInfo.nUndoRecordPos = record.GetUndoRecordPos();
 	if (record.GetFrameNumber() > pPlayerNodeInfo->nFrames)
 	{
-		XN_ASSERT(FALSE);
-		return XN_STATUS_CORRUPT_FILE;
+		if (!m_bOpenEnded)
+		{
+			XN_ASSERT(FALSE);
+			return XN_STATUS_CORRUPT_FILE;
+		}
+
+		// frame count was not known when node was added
+		pPlayerNodeInfo->nFrames = record.GetFrameNumber();
 	}
 
 	pPlayerNodeInfo->nCurFrame = record.GetFrameNumber();
@@ -1345,6 +1791,12 @@ XnStatus PlayerNode::HandleNewDataRecord(NewDataRecordHeader record, XnBool bRea
 
 	m_nTimeStamp = record.GetTimeStamp();
 
+	if (bReadPayload && IsFrameSuperseded(pPlayerNodeInfo, record.GetFrameNumber(), record.GetTimeStamp()))
+	{
+		// playback is late, and this frame would be replaced right away anyway. Save decoding it.
+		bReadPayload = FALSE;
+	}
+
 	if (bReadPayload)
 	{
 		//Now read the actual data
@@ -1353,6 +1805,11 @@ XnStatus PlayerNode::HandleNewDataRecord(NewDataRecordHeader record, XnBool bRea
 		XN_IS_STATUS_OK(nRetVal);
 		if (nBytesRead < record.GetPayloadSize())
 		{
+			if (m_bOpenEnded)
+			{
+				// last frame of a recording that was not closed
+				return XN_STATUS_EOF;
+			}
 			XN_ASSERT(FALSE);
 			XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Not enough bytes read");
 		}
@@ -1377,7 +1834,7 @@ XnStatus PlayerNode::HandleNewDataRecord(NewDataRecordHeader record, XnBool bRea
 		}
 
 		nRetVal = m_pNodeNotifications->OnNodeNewData(m_pNotificationsCookie, pPlayerNodeInfo->strName, 
-			record.GetTimeStamp(), record.GetFrameNumber(), pUncompressedData, nUncompressedDataSize);
+			record.GetTimeStamp(), pPlayerNodeInfo->nFrameBase + record.GetFrameNumber(), pUncompressedData, nUncompressedDataSize);
 		XN_IS_STATUS_OK_ASSERT(nRetVal);
 	}
 	else
@@ -1390,6 +1847,58 @@ XnStatus PlayerNode::HandleNewDataRecord(NewDataRecordHeader record, XnBool bRea
 	return XN_STATUS_OK;
 }
 
+XnBool PlayerNode::IsFrameSuperseded(PlayerNodeInfo* pPlayerNodeInfo, XnUInt32 nFrame, XnUInt64 nTimestamp)
+{
+	if (!m_bCanDropFrames || m_playbackClock.IsTimestampDue == NULL)
+	{
+		pPlayerNodeInfo->bSyncDropPending = FALSE;
+		return (FALSE);
+	}
+
+	// the frame synced node already decided for this frame (when it read its own frame of the pair)
+	if (pPlayerNodeInfo->bSyncDropPending && pPlayerNodeInfo->nSyncDropFrame == nFrame)
+	{
+		pPlayerNodeInfo->bSyncDropPending = FALSE;
+		return pPlayerNodeInfo->bSyncDrop;
+	}
+	pPlayerNodeInfo->bSyncDropPending = FALSE;
+
+	XnBool bSuperseded = IsNodeFrameSuperseded(pPlayerNodeInfo, nFrame, nTimestamp);
+
+	// frame synced nodes are dropped together, so the application never gets half a pair. The other node's 
+	// frame of this pair is the next one it reads, and is dropped only if both are late.
+	PlayerNodeInfo* pSyncedInfo = (pPlayerNodeInfo->strFrameSyncedWith[0] == '\0') ? NULL : GetPlayerNodeInfoByName(pPlayerNodeInfo->strFrameSyncedWith);
+	if (pSyncedInfo != NULL && pSyncedInfo != pPlayerNodeInfo && pSyncedInfo->bValid)
+	{
+		XnUInt32 nSyncedFrame = pSyncedInfo->nCurFrame + 1;
+		bSuperseded = bSuperseded && IsNodeFrameSuperseded(pSyncedInfo, nSyncedFrame, nTimestamp);
+
+		pSyncedInfo->bSyncDropPending = TRUE;
+		pSyncedInfo->nSyncDropFrame = nSyncedFrame;
+		pSyncedInfo->bSyncDrop = bSuperseded;
+	}
+
+	return (bSuperseded);
+}
+
+XnBool PlayerNode::IsNodeFrameSuperseded(PlayerNodeInfo* pPlayerNodeInfo, XnUInt32 nFrame, XnUInt64 nTimestamp)
+{
+	if (!m_bSeekable)
+	{
+		// a live stream has no seek table, and its next frame may not have arrived yet. The clock tells 
+		// whether this frame is already too late to be played.
+		return m_playbackClock.IsTimestampDue(m_playbackClock.pCookie, nTimestamp);
+	}
+
+	// the seek table tells when the next frame of this node is due (without it, we can't know)
+	if (pPlayerNodeInfo->pDataIndex == NULL || nFrame >= pPlayerNodeInfo->nIndexedFrames)
+	{
+		return (FALSE);
+	}
+
+	return m_playbackClock.IsTimestampDue(m_playbackClock.pCookie, pPlayerNodeInfo->pDataIndex[nFrame + 1].nTimestamp);
+}
+
 XnStatus PlayerNode::HandleDataIndexRecord(DataIndexRecordHeader record, XnBool bReadPayload)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
@@ -1457,6 +1966,8 @@ XnStatus PlayerNode::HandleDataIndexRecord(DataIndexRecordHeader record, XnBool
 		{
 			XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Not enough bytes read");
 		}
+
+		pPlayerNodeInfo->nIndexedFrames = pPlayerNodeInfo->nFrames;
 	}
 	else
 	{
@@ -1468,6 +1979,85 @@ XnStatus PlayerNode::HandleDataIndexRecord(DataIndexRecordHeader record, XnBool
 	return XN_STATUS_OK;
 }
 
+XnStatus PlayerNode::HandleDataIndexChunkRecord(DataIndexChunkRecordHeader record)
+{
+	XnStatus nRetVal = record.Decode();
+	XN_IS_STATUS_OK_ASSERT(nRetVal);
+	DEBUG_LOG_RECORD(record, "DataIndexChunk");
+
+	// never process this record (chunks are read during node added)
+	nRetVal = SkipRecordPayload(record);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return XN_STATUS_OK;
+}
+
+XnStatus PlayerNode::ReadDataIndexChunks(XnUInt32 nNodeID, XnUInt64 nLastChunkPos)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	PlayerNodeInfo* pPlayerNodeInfo = GetPlayerNodeInfo(nNodeID);
+	XN_VALIDATE_PTR(pPlayerNodeInfo, XN_STATUS_CORRUPT_FILE);
+	if (!pPlayerNodeInfo->bValid)
+	{
+		XN_ASSERT(FALSE);
+		return XN_STATUS_CORRUPT_FILE;
+	}
+
+	// allocate our data index (entry 0 stays empty, as frames start with 1)
+	xnOSFree(pPlayerNodeInfo->pDataIndex);
+	pPlayerNodeInfo->pDataIndex = (DataIndexEntry*)xnOSCalloc(pPlayerNodeInfo->nFrames+1, sizeof(DataIndexEntry));
+	XN_VALIDATE_ALLOC_PTR(pPlayerNodeInfo->pDataIndex);
+	pPlayerNodeInfo->nIndexedFrames = 0;
+
+	// chunks are chained from last to first
+	XnUInt32 nEntriesRead = 0;
+	XnUInt64 nChunkPos = nLastChunkPos;
+	DataIndexChunkRecordHeader chunk(m_pRecordBuffer, RECORD_MAX_SIZE, m_bIs32bitFileFormat);
+	while (nChunkPos != 0)
+	{
+		nRetVal = SeekStream(XN_OS_SEEK_SET, nChunkPos);
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = ReadRecord(chunk);
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = chunk.Decode();
+		XN_IS_STATUS_OK(nRetVal);
+
+		XnUInt32 nEntries = chunk.GetPayloadSize() / sizeof(DataIndexEntry);
+		if (chunk.GetType() != RECORD_SEEK_TABLE_CHUNK || chunk.GetNodeID() != nNodeID ||
+			chunk.GetFirstFrame() == 0 || chunk.GetFirstFrame() + nEntries - 1 > pPlayerNodeInfo->nFrames)
+		{
+			xnOSFree(pPlayerNodeInfo->pDataIndex);
+			pPlayerNodeInfo->pDataIndex = NULL;
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Invalid seek table chunk at position %llu", nChunkPos);
+		}
+
+		XnUInt32 nBytesRead = 0;
+		nRetVal = Read(&pPlayerNodeInfo->pDataIndex[chunk.GetFirstFrame()], nEntries * sizeof(DataIndexEntry), nBytesRead);
+		XN_IS_STATUS_OK(nRetVal);
+		if (nBytesRead < nEntries * sizeof(DataIndexEntry))
+		{
+			XN_LOG_ERROR_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Not enough bytes read");
+		}
+
+		nEntriesRead += nEntries;
+		nChunkPos = chunk.GetUndoRecordPos();
+	}
+
+	if (nEntriesRead != pPlayerNodeInfo->nFrames)
+	{
+		xnOSFree(pPlayerNodeInfo->pDataIndex);
+		pPlayerNodeInfo->pDataIndex = NULL;
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Seek table has %u entries, but node has %u frames!", nEntriesRead, pPlayerNodeInfo->nFrames);
+	}
+
+	pPlayerNodeInfo->nIndexedFrames = pPlayerNodeInfo->nFrames;
+
+	return XN_STATUS_OK;
+}
+
 XnStatus PlayerNode::HandleEndRecord(EndRecord record)
 {
 	XN_VALIDATE_INPUT_PTR(m_pNodeNotifications);
@@ -1475,17 +2065,35 @@ XnStatus PlayerNode::HandleEndRecord(EndRecord record)
 	XN_IS_STATUS_OK(nRetVal);
 	DEBUG_LOG_RECORD(record, "End");
 
+	return HandleEndOfStream();
+}
+
+XnStatus PlayerNode::HandleEndOfStream()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
 	if (!m_bDataBegun)
 	{
 		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "File does not contain any data!");
 	}
 
+	// a segmented recording goes on in its next segment
+	nRetVal = OpenSegment(m_nSegment + 1);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		return (XN_STATUS_OK);
+	}
+	else if (nRetVal != XN_STATUS_NO_MATCH)
+	{
+		xnLogWarning(XN_MASK_OPEN_NI, "Failed to open segment %u: %s. Ending playback there.", m_nSegment + 1, xnGetStatusString(nRetVal));
+	}
+
 	nRetVal = m_eofReachedEvent.Raise();
 	XN_IS_STATUS_OK(nRetVal);
 
-	if (m_bRepeat)
+	if (m_bRepeat && m_bSeekable)
 	{
-		nRetVal = Rewind();
+		nRetVal = (m_nSegment != 0) ? OpenSegment(0) : Rewind();
 		XN_IS_STATUS_OK(nRetVal);
 	}
 	else
@@ -1735,4 +2343,10 @@ void PlayerNode::PlayerNodeInfo::Reset()
 	bValid = FALSE;
 	xnOSFree(pDataIndex);
 	pDataIndex = NULL;
+	nIndexedFrames = 0;
+	nFrameBase = 0;
+	xnOSMemSet(strFrameSyncedWith, 0, sizeof(strFrameSyncedWith));
+	bSyncDropPending = FALSE;
+	nSyncDropFrame = 0;
+	bSyncDrop = FALSE;
 }
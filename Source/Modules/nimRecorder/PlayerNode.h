@@ -26,6 +26,7 @@
 #include <XnTypes.h>
 #include <XnEventT.h>
 #include <XnStringsHashT.h>
+#include <XnAtoms.h>
 #include "DataRecords.h"
 #include <XnCodecIDs.h>
 
@@ -56,6 +57,9 @@ public:
 	virtual XnStatus RegisterToEndOfFileReached(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
 	virtual void UnregisterFromEndOfFileReached(XnCallbackHandle hCallback);
 
+	//xn::ModuleProductionNode implementation
+	virtual XnStatus SetGeneralProperty(const XnChar* strName, XnUInt32 nBufferSize, const void* pBuffer);
+
 private:
 	struct RecordUndoInfo
 	{
@@ -67,6 +71,9 @@ private:
 
 	typedef XnStringsHashT<RecordUndoInfo> RecordUndoInfoMap;
 
+	// number of frames of each node (by name) in a segment
+	typedef XnHashT<XnAtom, XnUInt32> SegmentFramesMap;
+
 	struct PlayerNodeInfo
 	{
 		PlayerNodeInfo();
@@ -87,6 +94,12 @@ private:
 		RecordUndoInfoMap recordUndoInfoMap;
 		RecordUndoInfo newDataUndoInfo;
 		DataIndexEntry* pDataIndex;
+		XnUInt32 nIndexedFrames; // frames covered by pDataIndex (an unclosed recording may have more)
+		XnUInt32 nFrameBase; // frames this node had in previous segments
+		XnChar strFrameSyncedWith[XN_MAX_NAME_LENGTH];
+		XnBool bSyncDropPending; // the frame synced node already decided whether to drop nSyncDropFrame
+		XnUInt32 nSyncDropFrame;
+		XnBool bSyncDrop;
 	};
 
 	XnStatus ProcessRecord(XnBool bProcessPayload);
@@ -97,6 +110,12 @@ private:
 	XnStatus ProcessEachNodeLastData(XnUInt32 nIDToProcessLast);
 
 	XnStatus OpenStream();
+	XnStatus ReadHeader();
+	XnStatus OpenSegment(XnUInt32 nSegment);
+	XnStatus ScanSegments();
+	XnStatus ScanSegment(SegmentFramesMap& segmentFrames);
+	XnUInt32 GetSegmentFrameBase(const XnChar* strNodeName, XnUInt32 nSegment);
+	XnStatus FindFrameSegment(const XnChar* strNodeName, XnUInt32 nFrame, XnUInt32& nSegment, XnUInt32& nFrameBase);
 	XnStatus Read(void* pData, XnUInt32 nSize, XnUInt32& nBytesRead);
 	XnStatus ReadRecordHeader(Record& record);
 	XnStatus ReadRecordFields(Record& record);
@@ -117,11 +136,17 @@ private:
 	XnStatus HandleNodeStateReadyRecord(NodeStateReadyRecord record);
 	XnStatus HandleNodeDataBeginRecord(NodeDataBeginRecord record);
 	XnStatus HandleNewDataRecord(NewDataRecordHeader record, XnBool bHandleRecord);
+	XnBool IsFrameSuperseded(PlayerNodeInfo* pPlayerNodeInfo, XnUInt32 nFrame, XnUInt64 nTimestamp);
+	XnBool IsNodeFrameSuperseded(PlayerNodeInfo* pPlayerNodeInfo, XnUInt32 nFrame, XnUInt64 nTimestamp);
 	XnStatus HandleDataIndexRecord(DataIndexRecordHeader record, XnBool bReadPayload);
+	XnStatus HandleDataIndexChunkRecord(DataIndexChunkRecordHeader record);
+	XnStatus ReadDataIndexChunks(XnUInt32 nNodeID, XnUInt64 nLastChunkPos);
 	XnStatus HandleEndRecord(EndRecord record);
+	XnStatus HandleEndOfStream();
 	XnStatus Rewind();
 	XnStatus ProcessUntilFirstData();
 	PlayerNodeInfo* GetPlayerNodeInfo(XnUInt32 nNodeID);
+	XnStatus GrowNodeInfoMap(XnUInt32 nNodeID);
 	XnStatus RemovePlayerNodeInfo(XnUInt32 nNodeID);
 	XnUInt32 GetPlayerNodeIDByName(const XnChar* strNodeName);
 	PlayerNodeInfo* GetPlayerNodeInfoByName(const XnChar* strNodeName);
@@ -141,11 +166,15 @@ private:
 	static const XnUInt64 RECORD_MAX_SIZE;
 	static const XnVersion OLDEST_SUPPORTED_FILE_FORMAT_VERSION;
 	static const XnVersion FIRST_FILESIZE64BIT_FILE_FORMAT_VERSION;
+	static const XnUInt32 OPEN_ENDED_INITIAL_NODES;
+	static const XnUInt32 OPEN_ENDED_MAX_NODE_ID;
 
 	XnVersion m_fileVersion;
 	XnChar m_strName[XN_MAX_NAME_LENGTH];
 	XnBool m_bOpen;
 	XnBool m_bIs32bitFileFormat;
+	XnBool m_bSeekable; // FALSE for live (network) streams
+	XnBool m_bOpenEnded; // TRUE if header was never finalized (live stream, or recording was not closed)
 	XnUInt8* m_pRecordBuffer;
 	XnUInt8* m_pUncompressedData;
 	void* m_pStreamCookie;
@@ -155,6 +184,12 @@ private:
 	XnBool m_bRepeat;
 	XnBool m_bDataBegun;
 	XnBool m_bEOF;
+	XnUInt32 m_nSegment; // segment being played, if the stream is a segmented recording
+	XnPlayerSegmentedInputStreamInterface m_segmentedStream; // nVersion is 0 if the stream has no segments
+	SegmentFramesMap* m_pSegmentFrames; // per segment, NULL if the stream has no segments
+	XnUInt32 m_nSegments;
+	XnPlaybackClock m_playbackClock; // set in real-time mode, to drop frames that are already late
+	XnBool m_bCanDropFrames; // only frames played in order may be dropped (a seek must apply the frame it lands on)
 	
 	XnUInt64 m_nTimeStamp;
 	XnUInt64 m_nGlobalMaxTimeStamp;
@@ -32,17 +32,25 @@ const XnUInt32 RecorderNode::RECORD_MAX_SIZE = 20 * 1024;
 */
 const XnUInt32 RecorderNode::PAYLOAD_DATA_SIZE = (XnUInt32)(1600 * 1200 * 3 * 1.2);
 
+/*Data index entries are kept in memory until a chunk of this size is full. The chunk is then written to the
+  stream, and the seek info of all nodes is updated, so a recording that was never closed can still be
+  played (and seeked) up to that point.
+*/
+const XnUInt32 RecorderNode::DATA_INDEX_CHUNK_ENTRIES = 1024;
+
 RecorderNode::RecorderNode(xn::Context &context) : 
 	m_pStreamCookie(NULL),
 	m_pOutputStream(NULL),
 	m_bOpen(FALSE),
+	m_bSeekable(TRUE),
 	m_pRecordBuffer(NULL),
 	m_context(context),
 	m_pPayloadData(NULL),
 	m_nGlobalStartTimeStamp(XN_MAX_UINT64),
 	m_nGlobalMaxTimeStamp(0),
 	m_nNumNodes(0),
-	m_nConfigurationID(0)
+	m_nConfigurationID(0),
+	m_newDataProp(XN_INVALID_ATOM)
 {
 }
 
@@ -53,6 +61,9 @@ RecorderNode::~RecorderNode()
 
 XnStatus RecorderNode::Init()
 {
+	XnStatus nRetVal = xnAtomIntern(XN_PROP_NEWDATA, &m_newDataProp);
+	XN_IS_STATUS_OK(nRetVal);
+
 	m_pRecordBuffer = XN_NEW_ARR(XnUInt8, RECORD_MAX_SIZE);
 	XN_VALIDATE_ALLOC_PTR(m_pRecordBuffer);
 	m_pPayloadData = XN_NEW_ARR(XnUInt8, PAYLOAD_DATA_SIZE);
@@ -73,9 +84,16 @@ XnStatus RecorderNode::Destroy()
 
 XnStatus RecorderNode::SetOutputStream(void* pStreamCookie, XnRecorderOutputStreamInterface* pStream)
 {
+	// setting the stream again starts a new, self-contained, recording (e.g. the next segment). Timestamps
+	// continue from the previous one.
+	XnStatus nRetVal = CloseStream();
+	XN_IS_STATUS_OK(nRetVal);
+	m_nNumNodes = 0;
+
 	m_pStreamCookie = pStreamCookie;
 	m_pOutputStream = pStream;
-	XnStatus nRetVal = OpenStream();
+	m_bSeekable = (pStream != NULL && pStream->Seek64 != NULL);
+	nRetVal = OpenStream();
 	XN_IS_STATUS_OK(nRetVal);
 	return XN_STATUS_OK;
 }
@@ -83,6 +101,11 @@ XnStatus RecorderNode::SetOutputStream(void* pStreamCookie, XnRecorderOutputStre
 XnStatus RecorderNode::OnNodeAdded(const XnChar* strNodeName, XnProductionNodeType type, XnCodecID compression)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnAtom nodeName = XN_INVALID_ATOM;
+	nRetVal = xnAtomIntern(strNodeName, &nodeName);
+	XN_IS_STATUS_OK(nRetVal);
+
 	XnUInt32 nNodeID = ++m_nNumNodes;
 
 	m_nConfigurationID++;
@@ -122,11 +145,27 @@ XnStatus RecorderNode::OnNodeAdded(const XnChar* strNodeName, XnProductionNodeTy
 		XN_IS_STATUS_OK(nRetVal);
 		nRetVal = m_context.CreateCodec(compression, node, recordedNodeInfo.codec);
 		XN_IS_STATUS_OK(nRetVal);
+
+		// a stream we can't seek in will never have seek tables
+		if (m_bSeekable)
+		{
+			recordedNodeInfo.pDataIndexChunk = XN_NEW_ARR(DataIndexEntry, DATA_INDEX_CHUNK_ENTRIES);
+			if (recordedNodeInfo.pDataIndexChunk == NULL)
+			{
+				recordedNodeInfo.codec.Release();
+				return XN_STATUS_ALLOC_FAILED;
+			}
+		}
 	}
 
 	/* Index recorded node info by name in hash */
-	nRetVal = m_recordedNodesInfo.Set(strNodeName, recordedNodeInfo);
-	XN_IS_STATUS_OK(nRetVal);
+	nRetVal = m_recordedNodesInfo.Set(nodeName, recordedNodeInfo);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_DELETE_ARR(recordedNodeInfo.pDataIndexChunk);
+		recordedNodeInfo.codec.Release();
+		return (nRetVal);
+	}
 
 	return XN_STATUS_OK;
 }
@@ -135,7 +174,11 @@ XnStatus RecorderNode::OnNodeRemoved(const XnChar* strNodeName)
 {
 	m_nConfigurationID++;
 
-	XnStatus nRetVal = RemoveNode(strNodeName);
+	XnAtom nodeName = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomFind(strNodeName, &nodeName);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = RemoveNode(nodeName);
 	XN_IS_STATUS_OK(nRetVal);
 	return XN_STATUS_OK;
 }
@@ -339,7 +382,7 @@ XnStatus RecorderNode::OnNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeSt
 	pRecordedNodeInfo->nMaxTimeStamp = nTimeStamp;
 
 	XnUInt64 nUndoRecordPos = 0;
-	nRetVal = UpdateNodePropInfo(strNodeName, XN_PROP_NEWDATA, pRecordedNodeInfo, nUndoRecordPos);
+	nRetVal = UpdateNodePropInfo(*pRecordedNodeInfo, m_newDataProp, nUndoRecordPos);
 	XN_IS_STATUS_OK(nRetVal);
 
 	//Prepare data header
@@ -385,9 +428,16 @@ XnStatus RecorderNode::OnNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeSt
 		m_nGlobalMaxTimeStamp = nTimeStamp;
 	}
 
-	// write to seek table
-	nRetVal = pRecordedNodeInfo->dataIndex.AddLast(dataIndexEntry);
-	XN_IS_STATUS_OK(nRetVal);
+	// write to seek table (a stream we can't seek in will never have one)
+	if (pRecordedNodeInfo->pDataIndexChunk != NULL)
+	{
+		pRecordedNodeInfo->pDataIndexChunk[pRecordedNodeInfo->nDataIndexChunkEntries++] = dataIndexEntry;
+		if (pRecordedNodeInfo->nDataIndexChunkEntries == DATA_INDEX_CHUNK_ENTRIES)
+		{
+			nRetVal = WriteCheckpoint(strNodeName, *pRecordedNodeInfo);
+			XN_IS_STATUS_OK(nRetVal);
+		}
+	}
 
 	return XN_STATUS_OK;
 }
@@ -458,6 +508,12 @@ XnStatus RecorderNode::FinalizeStream()
 		XN_IS_STATUS_OK(nRetVal);
 	}
 
+	if (!m_bSeekable)
+	{
+		// header can't be re-written. Players handle a non-finalized header.
+		return XN_STATUS_OK;
+	}
+
 	/* Re-write header with correct max timestamp*/
 	nRetVal = SeekStream(XN_OS_SEEK_SET, 0);
 	XN_IS_STATUS_OK(nRetVal);
@@ -494,46 +550,53 @@ XnStatus RecorderNode::WriteNodeDataBegin(const XnChar* strNodeName)
 	return XN_STATUS_OK;
 }
 
-XnStatus RecorderNode::UpdateNodeSeekInfo(const XnChar* strNodeName, const RecordedNodeInfo& recordedNodeInfo)
+XnStatus RecorderNode::FlushDataIndexChunk(const XnChar* strNodeName, RecordedNodeInfo& recordedNodeInfo)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
-	if (recordedNodeInfo.bGotData)
+	if (recordedNodeInfo.nDataIndexChunkEntries == 0)
 	{
-		XnUInt64 nSeekTablePos = 0;
+		return (XN_STATUS_OK);
+	}
 
-		nSeekTablePos = TellStream();
+	XnUInt64 nChunkPos = TellStream();
 
-		// write seek table
-		DataIndexRecordHeader seekTableHeader(m_pRecordBuffer, RECORD_MAX_SIZE, FALSE);
-		seekTableHeader.SetNodeID(recordedNodeInfo.nNodeID);
-		seekTableHeader.SetPayloadSize((recordedNodeInfo.nMaxFrameNum+1) * sizeof(DataIndexEntry));
-		nRetVal = seekTableHeader.Encode();
-		XN_IS_STATUS_OK(nRetVal);
+	DataIndexChunkRecordHeader chunkHeader(m_pRecordBuffer, RECORD_MAX_SIZE, FALSE);
+	chunkHeader.SetNodeID(recordedNodeInfo.nNodeID);
+	chunkHeader.SetFirstFrame(recordedNodeInfo.nMaxFrameNum - recordedNodeInfo.nDataIndexChunkEntries + 1);
+	chunkHeader.SetPayloadSize(recordedNodeInfo.nDataIndexChunkEntries * sizeof(DataIndexEntry));
+	chunkHeader.SetUndoRecordPos(recordedNodeInfo.nLastDataIndexChunkPos);
+	nRetVal = chunkHeader.Encode();
+	XN_IS_STATUS_OK(nRetVal);
 
-		nRetVal = WriteRecordToStream(strNodeName, seekTableHeader);
-		XN_IS_STATUS_OK(nRetVal);
+	nRetVal = WriteRecordToStream(strNodeName, chunkHeader);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = WriteToStream(strNodeName, recordedNodeInfo.pDataIndexChunk, recordedNodeInfo.nDataIndexChunkEntries * sizeof(DataIndexEntry));
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogWarning(XN_MASK_OPEN_NI, "Failed to write Seek Table to file: %s", xnGetStatusString(nRetVal));
+		XN_ASSERT(FALSE);
+		return nRetVal;
+	}
 
-		// write an empty entry for frame 0 (frames start with 1)
-		DataIndexEntry* pPayload = (DataIndexEntry*)m_pPayloadData;
-		xnOSMemSet(pPayload, 0, sizeof(DataIndexEntry));
-		pPayload++;
+	recordedNodeInfo.nLastDataIndexChunkPos = nChunkPos;
+	recordedNodeInfo.nDataIndexChunkEntries = 0;
 
-		// now write the table itself
-		for (DataIndexEntryList::ConstIterator it = recordedNodeInfo.dataIndex.Begin(); it != recordedNodeInfo.dataIndex.End(); ++it, ++pPayload)
-		{
-			*pPayload = *it;
-		}
-		XN_ASSERT((recordedNodeInfo.nMaxFrameNum+1) == XnUInt32(pPayload - (DataIndexEntry*)m_pPayloadData));
+	return (XN_STATUS_OK);
+}
 
-		nRetVal = WriteToStream(strNodeName, m_pPayloadData, (XnUInt32)((XnUInt8*)pPayload - m_pPayloadData));
-		if (nRetVal != XN_STATUS_OK)
-		{
-			xnLogWarning(XN_MASK_OPEN_NI, "Failed to write Seek Table to file: %s", xnGetStatusString(nRetVal));
-			XN_ASSERT(FALSE);
-			return nRetVal;
-		}
+XnStatus RecorderNode::UpdateNodeSeekInfo(const XnChar* strNodeName, RecordedNodeInfo& recordedNodeInfo)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
 
+	if (recordedNodeInfo.bGotData && recordedNodeInfo.pDataIndexChunk != NULL)
+	{
+		// write what's left of the seek table. The node added record will point to its last chunk.
+		nRetVal = FlushDataIndexChunk(strNodeName, recordedNodeInfo);
+		XN_IS_STATUS_OK(nRetVal);
+
+		XnUInt64 nSeekTablePos = recordedNodeInfo.nLastDataIndexChunkPos;
 		XnUInt64 nStartPos = TellStream();
 
 		//Seek to position of node added record
@@ -566,15 +629,13 @@ XnStatus RecorderNode::UpdateNodeSeekInfo(const XnChar* strNodeName, const Recor
 }
 
 
-XnStatus RecorderNode::RemoveNode(const XnChar* strNodeName)
+XnStatus RecorderNode::RemoveNode(XnAtom nodeName)
 {
 	RecordedNodeInfo recordedNodeInfo;
-	XnChar strNodeNameCopy[XN_MAX_NAME_LENGTH];
-	//We copy the node name cuz when we'll remove it from the hash it will be freed, but we need it later.
-	XnStatus nRetVal = xnOSStrCopy(strNodeNameCopy, strNodeName, sizeof(strNodeNameCopy));
-	XN_IS_STATUS_OK(nRetVal);
+	// interned names are never freed, so the name outlives the node's entry
+	const XnChar* strNodeName = xnAtomGetString(nodeName);
 
-	RecordedNodesInfo::ConstIterator it = m_recordedNodesInfo.Find(strNodeName);
+	RecordedNodesInfo::ConstIterator it = m_recordedNodesInfo.Find(nodeName);
 	if (it == m_recordedNodesInfo.End())
 	{
 		return XN_STATUS_NO_MATCH;
@@ -582,7 +643,7 @@ XnStatus RecorderNode::RemoveNode(const XnChar* strNodeName)
 
 	recordedNodeInfo = it->Value();
 
-	nRetVal = m_recordedNodesInfo.Remove(it);
+	XnStatus nRetVal = m_recordedNodesInfo.Remove(it);
 	XN_IS_STATUS_OK(nRetVal);
 
 	NodeRemovedRecord record(m_pRecordBuffer, RECORD_MAX_SIZE, FALSE);
@@ -597,7 +658,7 @@ XnStatus RecorderNode::RemoveNode(const XnChar* strNodeName)
 		return nRetVal;
 	}
 
-	nRetVal = WriteRecordToStream(strNodeNameCopy, record);
+	nRetVal = WriteRecordToStream(strNodeName, record);
 	if (nRetVal != XN_STATUS_OK)
 	{
 		xnLogWarning(XN_MASK_OPEN_NI, "Failed to write Node Removed record to file: %s", xnGetStatusString(nRetVal));
@@ -605,33 +666,67 @@ XnStatus RecorderNode::RemoveNode(const XnChar* strNodeName)
 		return nRetVal;
 	}
 
-	nRetVal = UpdateNodeSeekInfo(strNodeNameCopy, recordedNodeInfo);
+	nRetVal = UpdateNodeSeekInfo(strNodeName, recordedNodeInfo);
 	XN_IS_STATUS_OK(nRetVal);
 
 	recordedNodeInfo.codec.Release();
+	XN_DELETE_ARR(recordedNodeInfo.pDataIndexChunk);
+	recordedNodeInfo.pDataIndexChunk = NULL;
 	return XN_STATUS_OK;
 }
 
+XnStatus RecorderNode::WriteCheckpoint(const XnChar* strNodeName, RecordedNodeInfo& recordedNodeInfo)
+{
+	// flush the node's seek table, and point its node added record at it. If recording stops without the 
+	// stream being finalized, this node's frames up to here can be played and seeked. Every node has its own
+	// chain of chunks, so other nodes are checkpointed when their own chunks fill up.
+	return UpdateNodeSeekInfo(strNodeName, recordedNodeInfo);
+}
+
 
 XnStatus RecorderNode::UpdateNodePropInfo(const XnChar* strNodeName, const XnChar* strPropName, 
 										  RecordedNodeInfo*& pRecordedNodeInfo, XnUInt64& nUndoPos)
 {
-	XnStatus nRetVal = m_recordedNodesInfo.Get(strNodeName, pRecordedNodeInfo);
+	pRecordedNodeInfo = GetRecordedNodeInfo(strNodeName);
+	XN_VALIDATE_PTR(pRecordedNodeInfo, XN_STATUS_NO_MATCH);
+
+	XnAtom propName = XN_INVALID_ATOM;
+	XnStatus nRetVal = xnAtomIntern(strPropName, &propName);
 	XN_IS_STATUS_OK(nRetVal);
-	RecordedNodePropInfoMap& propInfoMap = pRecordedNodeInfo->propInfoMap;
+
+	return UpdateNodePropInfo(*pRecordedNodeInfo, propName, nUndoPos);
+}
+
+XnStatus RecorderNode::UpdateNodePropInfo(RecordedNodeInfo& recordedNodeInfo, XnAtom propName, XnUInt64& nUndoPos)
+{
+	RecordedNodePropInfoMap& propInfoMap = recordedNodeInfo.propInfoMap;
+	RecordedNodePropInfoMap::Iterator it = propInfoMap.Find(propName);
+	if (it != propInfoMap.End())
+	{
+		nUndoPos = it->Value().nPos;
+		it->Value().nPos = TellStream();
+		return XN_STATUS_OK;
+	}
+
 	RecordedNodePropInfo propInfo;
-	propInfoMap.Get(strPropName, propInfo);
 	nUndoPos = propInfo.nPos;
 	propInfo.nPos = TellStream();
-	nRetVal = propInfoMap.Set(strPropName, propInfo);
+	XnStatus nRetVal = propInfoMap.Set(propName, propInfo);
 	XN_IS_STATUS_OK(nRetVal);
 	return XN_STATUS_OK;
 }
 
 RecorderNode::RecordedNodeInfo* RecorderNode::GetRecordedNodeInfo(const XnChar* strNodeName)
 {
+	// a name that was never interned can't belong to a recorded node
+	XnAtom nodeName = XN_INVALID_ATOM;
+	if (xnAtomFind(strNodeName, &nodeName) != XN_STATUS_OK)
+	{
+		return NULL;
+	}
+
 	RecordedNodeInfo* pRecordedNodeInfo = NULL;
-	return (m_recordedNodesInfo.Get(strNodeName, pRecordedNodeInfo) == XN_STATUS_OK) ? pRecordedNodeInfo : NULL;
+	return (m_recordedNodesInfo.Get(nodeName, pRecordedNodeInfo) == XN_STATUS_OK) ? pRecordedNodeInfo : NULL;
 }
 
 RecorderNode::RecordedNodeInfo::RecordedNodeInfo()
@@ -651,5 +746,7 @@ void RecorderNode::RecordedNodeInfo::Reset()
 	bGotData = FALSE;
 	compression = XN_CODEC_NULL;
 	propInfoMap.Clear();
-	dataIndex.Clear();
+	pDataIndexChunk = NULL;
+	nDataIndexChunkEntries = 0;
+	nLastDataIndexChunkPos = 0;
 }
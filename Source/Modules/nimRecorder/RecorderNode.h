@@ -22,7 +22,8 @@
 #define __RECORDER_NODE_H__
 
 #include <XnModuleCppInterface.h>
-#include <XnStringsHashT.h>
+#include <XnHashT.h>
+#include <XnAtoms.h>
 #include <DataRecords.h>
 
 class Record;
@@ -60,8 +61,7 @@ private:
 		XnUInt64 nPos;		//Position in stream of record that did this property change
 	};
 
-	typedef XnStringsHashT<RecordedNodePropInfo> RecordedNodePropInfoMap;
-	typedef XnListT<DataIndexEntry> DataIndexEntryList;
+	typedef XnHashT<XnAtom, RecordedNodePropInfo> RecordedNodePropInfoMap;
 
 	struct RecordedNodeInfo
 	{
@@ -79,10 +79,13 @@ private:
 		XnCodecID compression;
 		xn::Codec codec;
 		RecordedNodePropInfoMap propInfoMap;
-		DataIndexEntryList dataIndex;
+		DataIndexEntry* pDataIndexChunk; // entries not yet written to the stream
+		XnUInt32 nDataIndexChunkEntries;
+		XnUInt64 nLastDataIndexChunkPos; // 0 if no chunk was written yet
 	};
 
-	typedef XnStringsHashT<RecordedNodeInfo> RecordedNodesInfo;
+	// keyed by node name atom, so that the per-frame path never hashes a string
+	typedef XnHashT<XnAtom, RecordedNodeInfo> RecordedNodesInfo;
 
 	XnStatus OpenStream();
 	XnStatus WriteHeader(XnUInt64 nGlobalMaxTimeStamp, XnUInt32 nMaxNodeID);
@@ -93,16 +96,21 @@ private:
 	XnStatus FinalizeStream();
 	XnStatus CloseStream();
 	XnStatus WriteNodeDataBegin(const XnChar* strNodeName);
-	XnStatus UpdateNodeSeekInfo(const XnChar* strNodeName, const RecordedNodeInfo& recordedNodeInfo);
-	XnStatus RemoveNode(const XnChar* strNodeName);
+	XnStatus FlushDataIndexChunk(const XnChar* strNodeName, RecordedNodeInfo& recordedNodeInfo);
+	XnStatus UpdateNodeSeekInfo(const XnChar* strNodeName, RecordedNodeInfo& recordedNodeInfo);
+	XnStatus WriteCheckpoint(const XnChar* strNodeName, RecordedNodeInfo& recordedNodeInfo);
+	XnStatus RemoveNode(XnAtom nodeName);
 	
 	//UpdateNodePropInfo() returns, in nUndoPos, the position in the file you should read to undo the property update.
 	XnStatus UpdateNodePropInfo(const XnChar* strNodeName, const XnChar* strPropName, RecordedNodeInfo*& pRecordedNodeInfo, XnUInt64& nUndoPos);
+	XnStatus UpdateNodePropInfo(RecordedNodeInfo& recordedNodeInfo, XnAtom propName, XnUInt64& nUndoPos);
 	RecordedNodeInfo* GetRecordedNodeInfo(const XnChar* strNodeName);
 
 	static const XnUInt32 RECORD_MAX_SIZE;
 	static const XnUInt32 PAYLOAD_DATA_SIZE;
+	static const XnUInt32 DATA_INDEX_CHUNK_ENTRIES;
 	XnBool m_bOpen;
+	XnBool m_bSeekable; // FALSE when streaming (e.g. over network) - no seek tables and no header update
 	XnUInt8* m_pRecordBuffer;
 	XnUInt8* m_pPayloadData;
 	void* m_pStreamCookie;
@@ -114,6 +122,7 @@ private:
 	XnUInt64 m_nGlobalMaxTimeStamp;
 	XnUInt32 m_nNumNodes;
 	XnUInt32 m_nConfigurationID;
+	XnAtom m_newDataProp;
 };
 
 #endif //__RECORDER_NODE_H__
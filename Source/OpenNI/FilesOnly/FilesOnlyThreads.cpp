@@ -50,6 +50,18 @@ XN_C_API XnStatus xnOSWaitForThreadExit(XN_THREAD_HANDLE ThreadHandle, XnUInt32
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSSetThreadAffinity(XN_THREAD_HANDLE ThreadHandle, XnUInt64 nCPUMask)
+{
+	XN_IMPLEMENT_OS;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSSetThreadName(XN_THREAD_HANDLE ThreadHandle, const XnChar* strName)
+{
+	XN_IMPLEMENT_OS;
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSGetCurrentThreadID(XN_THREAD_HANDLE* pThreadID)
 {
 	*pThreadID = 0;
@@ -62,6 +74,18 @@ XN_C_API XnStatus xnOSGetCurrentCallStack(XnUInt32 nFramesToSkip, XnChar** astrF
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSGetCurrentCallStackAddresses(XnUInt32 nFramesToSkip, void** apFrames, XnUInt32* pnFrames)
+{
+	XN_IMPLEMENT_OS;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSResolveCallStackAddresses(void* const* apFrames, XnUInt32 nFrames, XnChar** astrFrames, XnUInt32 nMaxNameLength)
+{
+	XN_IMPLEMENT_OS;
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSGetCurrentProcessID(XN_PROCESS_ID* pProcID)
 {
 	*pProcID = 0;
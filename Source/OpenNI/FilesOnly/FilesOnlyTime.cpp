@@ -79,6 +79,22 @@ XN_C_API XnStatus xnOSSleep(XnUInt32 nMilliseconds)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSSleepUntilHighResTimeStamp(XnUInt64 nTimeStamp)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt64 nNow;
+
+	do
+	{
+		nRetVal = xnOSGetHighResTimeStamp(&nNow);
+		XN_IS_STATUS_OK(nRetVal);
+	} while (nNow < nTimeStamp);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSStartTimer(XnOSTimer* pTimer)
 {
 	XN_VALIDATE_INPUT_PTR(pTimer);
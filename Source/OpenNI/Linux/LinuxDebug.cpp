@@ -67,6 +67,56 @@ XN_C_API XnStatus xnOSGetCurrentCallStack(XnUInt32 nFramesToSkip, XnChar** astrF
 	return XN_STATUS_OK;
 }
 
+XN_C_API XnStatus xnOSGetCurrentCallStackAddresses(XnUInt32 nFramesToSkip, void** apFrames, XnUInt32* pnFrames)
+{
+	if (*pnFrames == 0)
+	{
+		return XN_STATUS_OK;
+	}
+
+	void* aFrames[256];
+	// skip this function's frame as well
+	++nFramesToSkip;
+	XnUInt32 nRequested = XN_MIN(*pnFrames + nFramesToSkip, sizeof(aFrames) / sizeof(aFrames[0]));
+	XnUInt32 nTotalFrames = backtrace(aFrames, nRequested);
+
+	if (nFramesToSkip >= nTotalFrames)
+	{
+		*pnFrames = 0;
+		return (XN_STATUS_OK);
+	}
+
+	XnUInt32 nFrames = nTotalFrames - nFramesToSkip;
+	xnOSMemCopy(apFrames, aFrames + nFramesToSkip, nFrames * sizeof(void*));
+	*pnFrames = nFrames;
+
+	return XN_STATUS_OK;
+}
+
+XN_C_API XnStatus xnOSResolveCallStackAddresses(void* const* apFrames, XnUInt32 nFrames, XnChar** astrFrames, XnUInt32 nMaxNameLength)
+{
+	if (nFrames == 0 || nMaxNameLength == 0)
+	{
+		return XN_STATUS_OK;
+	}
+
+	char** pstrFrames = backtrace_symbols((void* const*)apFrames, nFrames);
+	if (pstrFrames == NULL)
+	{
+		return (XN_STATUS_ALLOC_FAILED);
+	}
+
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		strncpy(astrFrames[i], pstrFrames[i], nMaxNameLength);
+		astrFrames[i][nMaxNameLength - 1] = '\0';
+	}
+
+	free(pstrFrames);
+
+	return XN_STATUS_OK;
+}
+
 #else
 
 XN_C_API XnStatus xnOSGetCurrentCallStack(XnUInt32 nFramesToSkip, XnChar** astrFrames, XnUInt32 nMaxNameLength, XnUInt32* pnFrames)
@@ -75,4 +125,15 @@ XN_C_API XnStatus xnOSGetCurrentCallStack(XnUInt32 nFramesToSkip, XnChar** astrF
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSGetCurrentCallStackAddresses(XnUInt32 nFramesToSkip, void** apFrames, XnUInt32* pnFrames)
+{
+	*pnFrames = 0;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSResolveCallStackAddresses(void* const* apFrames, XnUInt32 nFrames, XnChar** astrFrames, XnUInt32 nMaxNameLength)
+{
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+}
+
 #endif
\ No newline at end of file
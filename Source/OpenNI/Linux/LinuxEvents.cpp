@@ -25,6 +25,7 @@
 #include "LinuxPosixEvents.h"
 #include "LinuxPosixNamedEvents.h"
 #include "LinuxSysVNamedEvents.h"
+#include "LinuxFutexEvents.h"
 
 //---------------------------------------------------------------------------
 // Code
@@ -40,7 +41,11 @@ XN_C_API XnStatus xnOSCreateEvent(XN_EVENT_HANDLE* pEventHandle, XnBool bManualR
 	*pEventHandle = NULL;
 
 	XnLinuxEvent* pEvent = NULL;
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+	XN_VALIDATE_NEW(pEvent, XnLinuxFutexEvent, bManualReset);
+#else
 	XN_VALIDATE_NEW(pEvent, XnLinuxPosixEvent, bManualReset);
+#endif
 
 	nRetVal = pEvent->Init();
 	if (nRetVal != XN_STATUS_OK)
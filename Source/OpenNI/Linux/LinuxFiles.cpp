@@ -30,9 +30,11 @@
 	
 	#define OFF_T off_t
 	#define LSEEK lseek
+	#define PREAD pread
 #else
 	#define OFF_T off64_t
 	#define LSEEK lseek64
+	#define PREAD pread64
 #endif
 
 #include <XnOS.h>
@@ -145,6 +147,13 @@ XN_C_API XnStatus xnOSOpenFile(const XnChar* cpFileName, const XnUInt32 nFlags,
 		nOSOpenFlags |= O_APPEND;
 	}
 
+#if (XN_PLATFORM != XN_PLATFORM_MACOSX)
+	if (nFlags & XN_OS_FILE_DIRECT)
+	{
+		nOSOpenFlags |= O_DIRECT;
+	}
+#endif
+
 	// Open the file via the OS (give read permissions to ALL)
 	*pFile = open(cpFileName, nOSOpenFlags, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
@@ -162,6 +171,16 @@ XN_C_API XnStatus xnOSOpenFile(const XnChar* cpFileName, const XnUInt32 nFlags,
 		}
 	}
 
+#if (XN_PLATFORM == XN_PLATFORM_MACOSX)
+	// no O_DIRECT on Mac. Turning off caching is the closest thing.
+	if ((nFlags & XN_OS_FILE_DIRECT) && (-1 == fcntl(*pFile, F_NOCACHE, 1)))
+	{
+		close(*pFile);
+		*pFile = XN_INVALID_FILE_HANDLE;
+		return XN_STATUS_OS_FILE_OPEN_FAILED;
+	}
+#endif
+
 	// All is good...
 	return (XN_STATUS_OK);
 }
@@ -215,6 +234,32 @@ XN_C_API XnStatus xnOSReadFile(const XN_FILE_HANDLE File, void* pBuffer, XnUInt3
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSReadFileAt(const XN_FILE_HANDLE File, XnUInt64 nOffset, void* pBuffer, XnUInt32* pnBufferSize)
+{
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pBuffer);
+	XN_VALIDATE_INPUT_PTR(pnBufferSize);
+
+	// Make sure the actual file handle isn't invalid
+	if (File == XN_INVALID_FILE_HANDLE)
+	{
+		return XN_STATUS_OS_INVALID_FILE;
+	}
+
+	// pread() neither uses nor moves the file position, so several threads can read the same handle
+	ssize_t nBytesRead = PREAD(File, pBuffer, *pnBufferSize, (OFF_T)nOffset);
+	if (nBytesRead == -1)
+	{
+		return XN_STATUS_OS_FILE_READ_FAILED;
+	}
+
+	// update the number of bytes read
+	*pnBufferSize = nBytesRead;
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSWriteFile(const XN_FILE_HANDLE File, const void* pBuffer, const XnUInt32 nBufferSize)
 {
 	// Validate the input/output pointers (to make sure none of them is NULL)
@@ -402,6 +447,63 @@ XN_C_API XnStatus xnOSFlushFile(const XN_FILE_HANDLE File)
 	return XN_STATUS_OK;
 }
 
+XN_C_API XnStatus xnOSPreallocateFile(const XN_FILE_HANDLE File, XnUInt64 nSize)
+{
+	// Make sure the actual file handle isn't invalid
+	if (File == XN_INVALID_FILE_HANDLE)
+	{
+		return XN_STATUS_OS_INVALID_FILE;
+	}
+
+	// reserve the blocks, but keep the file size as is (so a reader never sees unwritten data)
+#if (XN_PLATFORM == XN_PLATFORM_MACOSX)
+	fstore_t store = { F_ALLOCATEALL, F_PEOFPOSMODE, 0, (OFF_T)nSize, 0 };
+	struct stat fileStat;
+	if (-1 == fstat(File, &fileStat))
+	{
+		return XN_STATUS_OS_FILE_WRITE_FAILED;
+	}
+	if ((OFF_T)nSize <= fileStat.st_size)
+	{
+		return XN_STATUS_OK;
+	}
+	store.fst_length = (OFF_T)nSize - fileStat.st_size;
+	if (-1 == fcntl(File, F_PREALLOCATE, &store))
+	{
+		return XN_STATUS_OS_FILE_WRITE_FAILED;
+	}
+#elif defined(ANDROID)
+	return XN_STATUS_NOT_IMPLEMENTED;
+#else
+	if (-1 == fallocate(File, FALLOC_FL_KEEP_SIZE, 0, (OFF_T)nSize))
+	{
+		if (errno == EOPNOTSUPP)
+		{
+			return XN_STATUS_NOT_IMPLEMENTED;
+		}
+		return XN_STATUS_OS_FILE_WRITE_FAILED;
+	}
+#endif
+
+	return XN_STATUS_OK;
+}
+
+XN_C_API XnStatus xnOSTruncateFile(const XN_FILE_HANDLE File, XnUInt64 nSize)
+{
+	// Make sure the actual file handle isn't invalid
+	if (File == XN_INVALID_FILE_HANDLE)
+	{
+		return XN_STATUS_OS_INVALID_FILE;
+	}
+
+	if (-1 == ftruncate(File, (OFF_T)nSize))
+	{
+		return XN_STATUS_OS_FILE_WRITE_FAILED;
+	}
+
+	return XN_STATUS_OK;
+}
+
 XN_C_API XnStatus xnOSFileExists(const XnChar* cpFileName, XnBool* bResult)
 {
 	// Validate the input/output pointers (to make sure none of them is NULL)
@@ -0,0 +1,189 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef __LINUX_FUTEX_H__
+#define __LINUX_FUTEX_H__
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Number of times a contended lock or an unsignaled event is polled before the thread parks in the kernel. */
+#define XN_FUTEX_SPIN_COUNT		100
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/** A non-recursive lock: 0 - free, 1 - locked, 2 - locked and (maybe) other threads are parked on it. */
+typedef struct XnFutexLock
+{
+	volatile XnInt32 nState;
+} XnFutexLock;
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static inline void xnFutexCpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__("pause");
+#elif defined(__aarch64__) || defined(__ARM_ARCH_7A__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+/** Spinning only pays off if the thread we wait for can run meanwhile, i.e. on a multi-processor machine. */
+static inline XnUInt32 xnFutexGetSpinCount()
+{
+	static volatile XnInt32 nSpinCount = -1;
+	if (nSpinCount < 0)
+	{
+		nSpinCount = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? XN_FUTEX_SPIN_COUNT : 0;
+	}
+
+	return (XnUInt32)nSpinCount;
+}
+
+static inline void xnFutexWait(volatile XnInt32* pWord, XnInt32 nExpected, const struct timespec* pTimeout)
+{
+	// returns early on a wake-up, a signal, a timeout or if *pWord != nExpected. Callers re-check their condition in all cases.
+	syscall(SYS_futex, pWord, FUTEX_WAIT_PRIVATE, nExpected, pTimeout, NULL, 0);
+}
+
+static inline void xnFutexWake(volatile XnInt32* pWord, XnInt32 nCount)
+{
+	syscall(SYS_futex, pWord, FUTEX_WAKE_PRIVATE, nCount, NULL, NULL, 0);
+}
+
+static inline void xnFutexGetDeadline(XnUInt32 nMilliseconds, struct timespec* pDeadline)
+{
+	clock_gettime(CLOCK_MONOTONIC, pDeadline);
+	pDeadline->tv_sec += nMilliseconds / 1000;
+	pDeadline->tv_nsec += (nMilliseconds % 1000) * 1000000;
+	if (pDeadline->tv_nsec >= 1000000000)
+	{
+		pDeadline->tv_nsec -= 1000000000;
+		++pDeadline->tv_sec;
+	}
+}
+
+/** Calculates the (relative) time left until the deadline. Returns FALSE if it already passed. */
+static inline XnBool xnFutexGetTimeLeft(const struct timespec* pDeadline, struct timespec* pTimeLeft)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	pTimeLeft->tv_sec = pDeadline->tv_sec - now.tv_sec;
+	pTimeLeft->tv_nsec = pDeadline->tv_nsec - now.tv_nsec;
+	if (pTimeLeft->tv_nsec < 0)
+	{
+		pTimeLeft->tv_nsec += 1000000000;
+		--pTimeLeft->tv_sec;
+	}
+
+	return (pTimeLeft->tv_sec >= 0 && (pTimeLeft->tv_sec > 0 || pTimeLeft->tv_nsec > 0));
+}
+
+static inline XnBool xnFutexLockTryAcquire(XnFutexLock* pLock)
+{
+	return __sync_bool_compare_and_swap(&pLock->nState, 0, 1);
+}
+
+static XnStatus xnFutexLockAcquireSlow(XnFutexLock* pLock, XnUInt32 nMilliseconds)
+{
+	if (nMilliseconds == 0)
+	{
+		return (XN_STATUS_OS_MUTEX_TIMEOUT);
+	}
+
+	// lock holders usually release quickly, and parking costs two system calls - spin a little first
+	XnUInt32 nSpinCount = xnFutexGetSpinCount();
+	for (XnUInt32 i = 0; i < nSpinCount; ++i)
+	{
+		xnFutexCpuRelax();
+		if (pLock->nState == 0 && xnFutexLockTryAcquire(pLock))
+		{
+			return (XN_STATUS_OK);
+		}
+	}
+
+	struct timespec deadline;
+	struct timespec timeLeft;
+	if (nMilliseconds != XN_WAIT_INFINITE)
+	{
+		xnFutexGetDeadline(nMilliseconds, &deadline);
+	}
+
+	// mark the lock as contended, so that its holder wakes us up when releasing it
+	XnInt32 nState = __sync_lock_test_and_set(&pLock->nState, 2);
+	while (nState != 0)
+	{
+		const struct timespec* pTimeout = NULL;
+		if (nMilliseconds != XN_WAIT_INFINITE)
+		{
+			if (!xnFutexGetTimeLeft(&deadline, &timeLeft))
+			{
+				return (XN_STATUS_OS_MUTEX_TIMEOUT);
+			}
+			pTimeout = &timeLeft;
+		}
+
+		xnFutexWait(&pLock->nState, 2, pTimeout);
+		nState = __sync_lock_test_and_set(&pLock->nState, 2);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static inline XnStatus xnFutexLockAcquire(XnFutexLock* pLock, XnUInt32 nMilliseconds)
+{
+	if (xnFutexLockTryAcquire(pLock))
+	{
+		return (XN_STATUS_OK);
+	}
+
+	return xnFutexLockAcquireSlow(pLock, nMilliseconds);
+}
+
+static inline void xnFutexLockRelease(XnFutexLock* pLock)
+{
+	// only enter the kernel if someone might be parked on the lock
+	if (__sync_fetch_and_sub(&pLock->nState, 1) != 1)
+	{
+		pLock->nState = 0;
+		xnFutexWake(&pLock->nState, 1);
+	}
+}
+
+#endif // XN_PLATFORM_HAS_NO_FUTEX
+
+#endif // __LINUX_FUTEX_H__
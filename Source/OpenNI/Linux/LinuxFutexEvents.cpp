@@ -0,0 +1,133 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include "LinuxFutexEvents.h"
+
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+
+XnLinuxFutexEvent::XnLinuxFutexEvent(XnBool bManualReset) : XnLinuxEvent(bManualReset), m_nSignaled(0), m_nWaiters(0)
+{
+
+}
+
+XnStatus XnLinuxFutexEvent::Init()
+{
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnLinuxFutexEvent::Destroy()
+{
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnLinuxFutexEvent::Set()
+{
+	// a full barrier, so that the waiters count is not read before the event is marked as signaled
+	__sync_val_compare_and_swap(&m_nSignaled, 0, 1);
+
+	if (m_nWaiters > 0)
+	{
+		// an auto-reset event releases only one waiter anyway
+		xnFutexWake(&m_nSignaled, m_bManualReset ? INT_MAX : 1);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnLinuxFutexEvent::Reset()
+{
+	__sync_val_compare_and_swap(&m_nSignaled, 1, 0);
+
+	return (XN_STATUS_OK);
+}
+
+XnBool XnLinuxFutexEvent::TryConsume()
+{
+	if (m_bManualReset)
+	{
+		if (m_nSignaled != 0)
+		{
+			__sync_synchronize();
+			return (TRUE);
+		}
+
+		return (FALSE);
+	}
+	else
+	{
+		return __sync_bool_compare_and_swap(&m_nSignaled, 1, 0);
+	}
+}
+
+XnStatus XnLinuxFutexEvent::Wait(XnUInt32 nMilliseconds)
+{
+	if (TryConsume())
+	{
+		return (XN_STATUS_OK);
+	}
+
+	if (nMilliseconds == 0)
+	{
+		return (XN_STATUS_OS_EVENT_TIMEOUT);
+	}
+
+	// new data usually follows shortly - poll for a while before parking
+	XnUInt32 nSpinCount = xnFutexGetSpinCount();
+	for (XnUInt32 i = 0; i < nSpinCount; ++i)
+	{
+		xnFutexCpuRelax();
+		if (m_nSignaled != 0 && TryConsume())
+		{
+			return (XN_STATUS_OK);
+		}
+	}
+
+	struct timespec deadline;
+	struct timespec timeLeft;
+	if (nMilliseconds != XN_WAIT_INFINITE)
+	{
+		xnFutexGetDeadline(nMilliseconds, &deadline);
+	}
+
+	for (;;)
+	{
+		const struct timespec* pTimeout = NULL;
+		if (nMilliseconds != XN_WAIT_INFINITE)
+		{
+			if (!xnFutexGetTimeLeft(&deadline, &timeLeft))
+			{
+				return (XN_STATUS_OS_EVENT_TIMEOUT);
+			}
+			pTimeout = &timeLeft;
+		}
+
+		// register as a waiter before checking the state again (inside the kernel), so a concurrent Set() can't miss us
+		__sync_fetch_and_add(&m_nWaiters, 1);
+		xnFutexWait(&m_nSignaled, 0, pTimeout);
+		__sync_fetch_and_sub(&m_nWaiters, 1);
+
+		if (TryConsume())
+		{
+			return (XN_STATUS_OK);
+		}
+	}
+}
+
+#endif // XN_PLATFORM_HAS_NO_FUTEX
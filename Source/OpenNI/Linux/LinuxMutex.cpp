@@ -26,6 +26,7 @@
 #include <sys/stat.h>
 #include <sys/ipc.h>
 #include <XnLog.h>
+#include "LinuxFutex.h"
 
 #ifndef XN_PLATFORM_LINUX_NO_SYSV
 #include <sys/sem.h>
@@ -37,7 +38,14 @@
 struct XnMutex
 {
 	XnBool bIsNamed;
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+	// unnamed mutexes are recursive futex locks. Uncontended lock/unlock never enter the kernel.
+	XnFutexLock FutexLock;
+	volatile pthread_t Owner;
+	XnUInt32 nRecursion;
+#else
 	pthread_mutex_t ThreadMutex;
+#endif
 	int NamedSem;
 	XnChar csSemFileName[XN_FILE_MAX_PATH];
 	int hSemFile;
@@ -52,6 +60,12 @@ typedef struct XnMutex XnMutex;
 XnStatus xnOSUnNamedMutexCreate(XnMutex* pMutex)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
+
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+	pMutex->FutexLock.nState = 0;
+	pMutex->nRecursion = 0;
+	return (XN_STATUS_OK);
+#else
 	
 	// make the mutex recursive (re-entrent)
 	pthread_mutexattr_t tAttributes;
@@ -74,9 +88,46 @@ XnStatus xnOSUnNamedMutexCreate(XnMutex* pMutex)
 		return (XN_STATUS_OS_MUTEX_CREATION_FAILED);
 	}
 
+	return (XN_STATUS_OK);
+#endif
+}
+
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+static XnStatus xnOSUnNamedMutexLock(XnMutex* pMutex, XnUInt32 nMilliseconds)
+{
+	// Owner can only be equal to the calling thread if this thread wrote it (and still holds the lock)
+	pthread_t self = pthread_self();
+	if (pMutex->nRecursion != 0 && pthread_equal(pMutex->Owner, self))
+	{
+		++pMutex->nRecursion;
+		return (XN_STATUS_OK);
+	}
+
+	XnStatus nRetVal = xnFutexLockAcquire(&pMutex->FutexLock, nMilliseconds);
+	XN_IS_STATUS_OK(nRetVal);
+
+	pMutex->Owner = self;
+	pMutex->nRecursion = 1;
+
 	return (XN_STATUS_OK);
 }
 
+static XnStatus xnOSUnNamedMutexUnlock(XnMutex* pMutex)
+{
+	if (pMutex->nRecursion == 0 || !pthread_equal(pMutex->Owner, pthread_self()))
+	{
+		return (XN_STATUS_OS_MUTEX_UNLOCK_FAILED);
+	}
+
+	if (--pMutex->nRecursion == 0)
+	{
+		xnFutexLockRelease(&pMutex->FutexLock);
+	}
+
+	return (XN_STATUS_OK);
+}
+#endif
+
 XnStatus xnOSNamedMutexCreate(XnMutex* pMutex, const XnChar* csMutexName)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
@@ -283,11 +334,13 @@ XN_C_API XnStatus xnOSCloseMutex(XN_MUTEX_HANDLE* pMutexHandle)
 	}
 	else
 	{
+#ifdef XN_PLATFORM_HAS_NO_FUTEX
 		// destroy the mutex via the OS
 		if (0 != pthread_mutex_destroy(&pMutex->ThreadMutex))
 		{
 			return (XN_STATUS_OS_MUTEX_CLOSE_FAILED);
 		}
+#endif
 	}
 	
 	// free the handle
@@ -306,6 +359,13 @@ XN_C_API XnStatus xnOSLockMutex(const XN_MUTEX_HANDLE MutexHandle, XnUInt32 nMil
 	// Make sure the actual mutex handle isn't NULL
 	XN_RET_IF_NULL(MutexHandle, XN_STATUS_OS_INVALID_MUTEX);
 
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+	if (!MutexHandle->bIsNamed)
+	{
+		return xnOSUnNamedMutexLock(MutexHandle, nMilliseconds);
+	}
+#endif
+
 #ifndef XN_PLATFORM_LINUX_NO_SYSV
 	struct sembuf op;
 	// try to decrease it by 1 (if it's 0, we'll wait)
@@ -326,10 +386,12 @@ XN_C_API XnStatus xnOSLockMutex(const XN_MUTEX_HANDLE MutexHandle, XnUInt32 nMil
 			}
 #endif
 		}
+#ifdef XN_PLATFORM_HAS_NO_FUTEX
 		else
 		{
 			rc = pthread_mutex_lock(&MutexHandle->ThreadMutex);
 		}
+#endif
 	}
 	else
 	{
@@ -355,6 +417,7 @@ XN_C_API XnStatus xnOSLockMutex(const XN_MUTEX_HANDLE MutexHandle, XnUInt32 nMil
 			}
 #endif
 		}
+#ifdef XN_PLATFORM_HAS_NO_FUTEX
 		else
 		{
 			// calculate timeout absolute time. First we take current time
@@ -370,6 +433,7 @@ XN_C_API XnStatus xnOSLockMutex(const XN_MUTEX_HANDLE MutexHandle, XnUInt32 nMil
 			rc = pthread_mutex_lock(&MutexHandle->ThreadMutex);
 #endif
 		}
+#endif
 	}
 	
 	// check for failures
@@ -394,6 +458,13 @@ XN_C_API XnStatus xnOSUnLockMutex(const XN_MUTEX_HANDLE MutexHandle)
 
 	// Make sure the actual mutex handle isn't NULL
 	XN_RET_IF_NULL(MutexHandle, XN_STATUS_OS_INVALID_MUTEX);
+
+#ifndef XN_PLATFORM_HAS_NO_FUTEX
+	if (!MutexHandle->bIsNamed)
+	{
+		return xnOSUnNamedMutexUnlock(MutexHandle);
+	}
+#endif
 	
 	// unlock via the OS
 	if (MutexHandle->bIsNamed)
@@ -410,10 +481,12 @@ XN_C_API XnStatus xnOSUnLockMutex(const XN_MUTEX_HANDLE MutexHandle)
 		}
 #endif
 	}
+#ifdef XN_PLATFORM_HAS_NO_FUTEX
 	else
 	{
 		rc = pthread_mutex_unlock(&MutexHandle->ThreadMutex);
 	}
+#endif
 	
 	if (0 != rc)
 	{
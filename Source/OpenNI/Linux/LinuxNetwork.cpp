@@ -24,6 +24,7 @@
 #include <XnOS.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netdb.h>
 #include <ctype.h>
 #include <netinet/in.h>
@@ -45,6 +46,9 @@ typedef struct xnOSSocket
 	sockaddr_in SocketAddress;
 	socklen_t nSocketAddressLen;
 
+	/** The file name of a local socket. */ 
+	sockaddr_un LocalAddress;
+
 	/** The socket type enum (UDP, TDP, etc...) */ 
 	XnUInt32 nSocketType;
 } xnOSSocket;
@@ -86,7 +90,27 @@ XN_C_API XnStatus xnOSCreateSocket(const XnOSSocketType SocketType, const XnChar
 
 	Socket = *SocketPtr;
 
-	if (SocketType == XN_OS_UDP_SOCKET)
+	if (SocketType == XN_OS_LOCAL_SOCKET)
+	{
+		if (strlen(cpIPAddress) >= sizeof(Socket->LocalAddress.sun_path))
+		{
+			XN_ALIGNED_FREE_AND_NULL(Socket);
+			return (XN_STATUS_OS_NETWORK_BAD_HOST_NAME);
+		}
+
+		Socket->Socket = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (Socket->Socket == -1)
+		{
+			XN_ALIGNED_FREE_AND_NULL(Socket);
+			return (XN_STATUS_OS_NETWORK_SOCKET_CREATION_FAILED);
+		}
+
+		Socket->LocalAddress.sun_family = AF_UNIX;
+		strcpy(Socket->LocalAddress.sun_path, cpIPAddress);
+		Socket->nSocketType = SocketType;
+		return (XN_STATUS_OK);
+	}
+	else if (SocketType == XN_OS_UDP_SOCKET)
 	{
 		// Create a UDP socket
 		Socket->Socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
@@ -183,6 +207,21 @@ XN_C_API XnStatus xnOSBindSocket(XN_SOCKET_HANDLE Socket)
 
 	// Make sure the actual socket handle isn't NULL
 	XN_RET_IF_INVALID(Socket->Socket, XN_STATUS_OS_INVALID_SOCKET);
+
+	if (Socket->nSocketType == XN_OS_LOCAL_SOCKET)
+	{
+		// a socket file left by a previous process would make bind fail
+		unlink(Socket->LocalAddress.sun_path);
+
+		nRetVal = bind(Socket->Socket, (const sockaddr*)&Socket->LocalAddress, sizeof(Socket->LocalAddress));
+		if (nRetVal == -1)
+		{
+			xnLogWarning(XN_MASK_OS, "Failed to bind socket to '%s': errno is %d", Socket->LocalAddress.sun_path, errno);
+			return(XN_STATUS_OS_NETWORK_SOCKET_BIND_FAILED);
+		}
+
+		return (XN_STATUS_OK);
+	}
 	
 	// Workaround Linux annoying behavior. Linux keeps a port open in a TIME_WAIT state after it is close,
 	// and does not allow to bind it again. If socket is closed, you have to wait a couple of minutes before
@@ -300,6 +339,19 @@ XN_C_API XnStatus xnOSConnectSocket(XN_SOCKET_HANDLE Socket, XnUInt32 nMillisecs
 	// Make sure the actual socket handle isn't NULL
 	XN_RET_IF_INVALID(Socket->Socket, XN_STATUS_OS_INVALID_SOCKET);
 
+	if (Socket->nSocketType == XN_OS_LOCAL_SOCKET)
+	{
+		// connecting to a local socket never waits for the other side
+		nRetVal = connect(Socket->Socket, (const sockaddr*)&Socket->LocalAddress, sizeof(Socket->LocalAddress));
+		if (nRetVal == -1)
+		{
+			xnLogError(XN_MASK_OS, "connect() failed with error %d", errno);
+			return(XN_STATUS_OS_NETWORK_SOCKET_CONNECT_FAILED);
+		}
+
+		return (XN_STATUS_OK);
+	}
+
 	// Connect to the socket and make sure it succeeded
 	if (sizeof(SocketAddress) != sizeof(Socket->SocketAddress))
 	{
@@ -349,11 +401,12 @@ XN_C_API XnStatus xnOSConnectSocket(XN_SOCKET_HANDLE Socket, XnUInt32 nMillisecs
 		else
 		{
 			// select returned due to socket state change. Check if an error occurred or everything is OK.
-			if (FD_ISSET(Socket->Socket, &fdExceptHandles))
+			// (on Linux, a refused connection is reported as writable, so the error must always be checked)
+			XnUInt32 nLastError = 0;
+			socklen_t nLastErrorSize = sizeof(nLastError);
+			getsockopt(Socket->Socket, SOL_SOCKET, SO_ERROR, &nLastError, &nLastErrorSize);
+			if (FD_ISSET(Socket->Socket, &fdExceptHandles) || nLastError != 0)
 			{
-				XnUInt32 nLastError = 0;
-				socklen_t nLastErrorSize = sizeof(nLastError);
-				getsockopt(Socket->Socket, SOL_SOCKET, SO_ERROR, &nLastError, &nLastErrorSize);
 				XN_LOG_ERROR_RETURN(XN_STATUS_OS_NETWORK_SOCKET_CONNECT_FAILED, XN_MASK_OS, "Connect failed with error: %u", nLastError);
 			}
 			// else, it means it's in the writable state, which means connect succeeded.
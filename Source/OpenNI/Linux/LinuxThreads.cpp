@@ -151,10 +151,10 @@ XN_C_API XnStatus xnOSSetThreadPriority(XN_THREAD_HANDLE ThreadHandle, XnThreadP
 	sched_param param;
 	int rc = 0;
 	
+	memset(&param, 0, sizeof(param));
+
 	if (nPriority == XN_PRIORITY_CRITICAL)
 	{
-		memset(&param, 0, sizeof(param));
-	
 #ifndef XN_PLATFORM_HAS_NO_SCHED_PARAM
 		param.__sched_priority = 5;
 #endif
@@ -163,6 +163,25 @@ XN_C_API XnStatus xnOSSetThreadPriority(XN_THREAD_HANDLE ThreadHandle, XnThreadP
 #if XN_PLATFORM == XN_PLATFORM_ANDROID_ARM
 		//Note: It's only going to work if it runs as root! (but if not it fails anyway...)		
 		param.sched_priority = sched_get_priority_max(nPolicy) - 1;
+#endif
+	}
+	else if (nPriority == XN_PRIORITY_HIGH)
+	{
+#ifndef XN_PLATFORM_HAS_NO_SCHED_PARAM
+		param.__sched_priority = 1;
+#endif
+		nPolicy = SCHED_RR;
+	}
+	else if (nPriority == XN_PRIORITY_NORMAL)
+	{
+		nPolicy = SCHED_OTHER;
+	}
+	else if (nPriority == XN_PRIORITY_LOW)
+	{
+#ifdef SCHED_BATCH
+		nPolicy = SCHED_BATCH;
+#else
+		nPolicy = SCHED_OTHER;
 #endif
 	}
 	else
@@ -193,6 +212,60 @@ XN_C_API XnStatus xnOSSetThreadPriority(XN_THREAD_HANDLE ThreadHandle, XnThreadP
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSSetThreadAffinity(XN_THREAD_HANDLE ThreadHandle, XnUInt64 nCPUMask)
+{
+	// Make sure the actual thread handle isn't NULL
+	XN_RET_IF_NULL(ThreadHandle, XN_STATUS_OS_INVALID_THREAD);
+
+#if (XN_PLATFORM == XN_PLATFORM_LINUX_X86 || XN_PLATFORM == XN_PLATFORM_LINUX_ARM)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for (XnUInt32 nCPU = 0; nCPU < 64; ++nCPU)
+	{
+		if ((nCPUMask & (1ULL << nCPU)) != 0)
+		{
+			CPU_SET(nCPU, &cpuSet);
+		}
+	}
+
+	int rc = pthread_setaffinity_np(*ThreadHandle, sizeof(cpuSet), &cpuSet);
+	if (rc != 0)
+	{
+		xnLogWarning(XN_MASK_OS, "Failed to set thread affinity to 0x%llx (%d)", nCPUMask, rc);
+		return (XN_STATUS_OS_THREAD_SET_AFFINITY_FAILED);
+	}
+
+	return (XN_STATUS_OK);
+#else
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+#endif
+}
+
+XN_C_API XnStatus xnOSSetThreadName(XN_THREAD_HANDLE ThreadHandle, const XnChar* strName)
+{
+	// Make sure the actual thread handle isn't NULL
+	XN_RET_IF_NULL(ThreadHandle, XN_STATUS_OS_INVALID_THREAD);
+	XN_VALIDATE_INPUT_PTR(strName);
+
+#if (XN_PLATFORM == XN_PLATFORM_LINUX_X86 || XN_PLATFORM == XN_PLATFORM_LINUX_ARM)
+	// the kernel limits thread names to 16 characters, including the terminating null
+	XnChar strShortName[16];
+	strncpy(strShortName, strName, sizeof(strShortName) - 1);
+	strShortName[sizeof(strShortName) - 1] = '\0';
+
+	int rc = pthread_setname_np(*ThreadHandle, strShortName);
+	if (rc != 0)
+	{
+		xnLogWarning(XN_MASK_OS, "Failed to set thread name to '%s' (%d)", strShortName, rc);
+		return (XN_STATUS_OS_THREAD_SET_NAME_FAILED);
+	}
+
+	return (XN_STATUS_OK);
+#else
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+#endif
+}
+
 XN_C_API XnStatus xnOSGetCurrentThreadID(XN_THREAD_ID* pThreadID)
 {
 	// Validate the input/output pointers (to make sure none of them is NULL)
@@ -205,3 +278,18 @@ XN_C_API XnStatus xnOSGetCurrentThreadID(XN_THREAD_ID* pThreadID)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API void xnOSMemoryBarrier()
+{
+	__sync_synchronize();
+}
+
+XN_C_API XnInt32 xnOSAtomicAdd32(volatile XnInt32* pValue, XnInt32 nValue)
+{
+	return __sync_add_and_fetch(pValue, nValue);
+}
+
+XN_C_API XnBool xnOSAtomicCompareAndSwap32(volatile XnInt32* pValue, XnInt32 nExpected, XnInt32 nNew)
+{
+	return __sync_bool_compare_and_swap(pValue, nExpected, nNew);
+}
+
@@ -22,6 +22,7 @@
 // Includes
 //---------------------------------------------------------------------------
 #include <XnOS.h>
+#include <errno.h>
 
 //---------------------------------------------------------------------------
 // Global Variables
@@ -91,6 +92,44 @@ XN_C_API XnStatus xnOSSleep(XnUInt32 nMilliseconds)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSSleepUntilHighResTimeStamp(XnUInt64 nTimeStamp)
+{
+#ifndef XN_PLATFORM_HAS_NO_CLOCK_GETTIME
+	// high res timestamps are relative to the global timer start, on the same clock xnOSGetMonoTime() uses
+	struct timespec deadline = g_xnOSHighResGlobalTimer.tStartTime;
+	deadline.tv_sec += (time_t)(nTimeStamp / 1000000);
+	deadline.tv_nsec += (long)(nTimeStamp % 1000000) * 1000;
+	if (deadline.tv_nsec >= 1000000000)
+	{
+		deadline.tv_nsec -= 1000000000;
+		deadline.tv_sec++;
+	}
+
+	int rc;
+	do
+	{
+		rc = clock_nanosleep(CLOCK_REALTIME, TIMER_ABSTIME, &deadline, NULL);
+	} while (rc == EINTR);
+
+	if (rc != 0)
+	{
+		return (XN_STATUS_ERROR);
+	}
+#else
+	XnUInt64 nNow;
+	XnStatus nRetVal = xnOSGetHighResTimeStamp(&nNow);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nNow < nTimeStamp)
+	{
+		usleep((useconds_t)(nTimeStamp - nNow));
+	}
+#endif
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSStartTimer(XnOSTimer* pTimer)
 {
 	// Validate the input/output pointers (to make sure none of them is NULL)
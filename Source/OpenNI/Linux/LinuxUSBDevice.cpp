@@ -740,6 +740,8 @@ XN_C_API XnStatus XN_C_DECL xnUSBDeviceInit(const XnUSBDeviceDescriptorHolder* p
 		return (nRetVal);
 	}
 
+	xnOSApplyThreadPolicy(pDevice->hThread, XN_THREAD_ROLE_USB_DEVICE, "XnUSBDevice");
+
 	pDevice->pDump = xnDumpFileOpen("Gadget", "gadget.csv");
 	xnDumpFileWriteString(pDevice->pDump, "Time,HostState,DeviceState,Event,NewHostState,NewDeviceState\n","");
 	
@@ -62,6 +62,7 @@ XnUSBEventCallbackList g_connectivityEvent;
 #define XN_MASK_USB "xnUSB"
 
 #define XN_USB_HANDLE_EVENTS_TIMEOUT 1000
+#define XN_USB_READ_THREAD_MODE_MAX_LENGTH 32
 
 #define XN_VALIDATE_DEVICE_HANDLE(x)					\
 	if (x == NULL)									\
@@ -81,6 +82,166 @@ struct xnUSBInitData
 } g_InitData = {NULL, NULL, FALSE, 0, NULL};
 
 XnStatus xnUSBPlatformSpecificShutdown();
+void xnUSBAsynchThreadRelease();
+
+//---------------------------------------------------------------------------
+// Backend
+//---------------------------------------------------------------------------
+static int xnUSBLibusbCloseDevice(XN_USB_DEV_HANDLE pDevHandle)
+{
+	int rc = libusb_release_interface(pDevHandle->hDevice, pDevHandle->nInterface);
+	if (0 != rc)
+	{
+		return (rc);
+	}
+
+	libusb_close(pDevHandle->hDevice);
+
+	xnUSBAsynchThreadRelease();
+
+	return (0);
+}
+
+static int xnUSBLibusbSetInterface(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nInterface, XnUInt8 nAltSetting)
+{
+	return libusb_set_interface_alt_setting(pDevHandle->hDevice, nInterface, nAltSetting);
+}
+
+static int xnUSBLibusbControlTransfer(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nRequestType, XnUInt8 nRequest, XnUInt16 nValue, XnUInt16 nIndex, XnUChar* pBuffer, XnUInt16 nLength, XnUInt32 nTimeOut)
+{
+	return libusb_control_transfer(pDevHandle->hDevice, nRequestType, nRequest, nValue, nIndex, pBuffer, nLength, nTimeOut);
+}
+
+static XnStatus xnUSBLibusbOpenEndPoint(XN_USB_DEV_HANDLE pDevHandle, XN_USB_EP_HANDLE pEPHandle)
+{
+	// get the device from the handle
+	libusb_device* pDevice = libusb_get_device(pDevHandle->hDevice);
+	
+	// get the configuration descriptor
+	libusb_config_descriptor* pConfig;
+	int rc = libusb_get_active_config_descriptor(pDevice, &pConfig);
+	if (rc != 0)
+	{
+		return (XN_STATUS_USB_CONFIG_QUERY_FAILED);
+	}
+	
+	// make sure configuration contains the interface we need
+	if (pConfig->bNumInterfaces <= pDevHandle->nInterface)
+	{
+		libusb_free_config_descriptor(pConfig);
+		return (XN_STATUS_USB_INTERFACE_QUERY_FAILED);
+	}
+	
+	// take that interface
+	const libusb_interface* pInterface = &pConfig->interface[pDevHandle->nInterface];
+	
+	// make sure interface contains the alternate setting we work with
+	if (pInterface->num_altsetting <= pDevHandle->nAltSetting)
+	{
+		libusb_free_config_descriptor(pConfig);
+		return (XN_STATUS_USB_INTERFACE_QUERY_FAILED);
+	}
+	
+	// take that setting
+	const libusb_interface_descriptor* pInterfaceDesc = &pInterface->altsetting[pDevHandle->nAltSetting];
+	
+	// search for the requested endpoint
+	const libusb_endpoint_descriptor* pEndpointDesc = NULL;
+	
+	for (uint8_t i = 0; i < pInterfaceDesc->bNumEndpoints; ++i)
+	{
+		if (pInterfaceDesc->endpoint[i].bEndpointAddress == pEPHandle->nAddress)
+		{
+			pEndpointDesc = &pInterfaceDesc->endpoint[i];
+			break;
+		}
+	}
+	
+	if (pEndpointDesc == NULL)
+	{
+		libusb_free_config_descriptor(pConfig);
+		return (XN_STATUS_USB_ENDPOINT_NOT_FOUND);
+	}
+	
+	libusb_transfer_type transfer_type = (libusb_transfer_type)(pEndpointDesc->bmAttributes & 0x3); // lower 2-bits
+
+    // calculate max packet size
+	// NOTE: we do not use libusb functions (libusb_get_max_packet_size/libusb_get_max_iso_packet_size) because
+	// they hace a bug and does not consider alternative interface
+    XnUInt32 nMaxPacketSize = 0;
+	
+	if (transfer_type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
+	{
+		XnUInt32 wMaxPacketSize = pEndpointDesc->wMaxPacketSize;
+		// bits 11 and 12 mark the number of additional transactions, bits 0-10 mark the size
+		XnUInt32 nAdditionalTransactions = wMaxPacketSize >> 11;
+		XnUInt32 nPacketSize = wMaxPacketSize & 0x7FF;
+		nMaxPacketSize = (nAdditionalTransactions + 1) * (nPacketSize);
+	}
+	else
+	{
+		nMaxPacketSize = pEndpointDesc->wMaxPacketSize;
+	}
+
+	// free the configuration descriptor. no need of it anymore
+	libusb_free_config_descriptor(pConfig);
+	pConfig = NULL;
+	
+	// Make sure the endpoint matches the required endpoint type
+	if ((pEPHandle->nType == XN_USB_EP_BULK && transfer_type != LIBUSB_TRANSFER_TYPE_BULK) ||
+		(pEPHandle->nType == XN_USB_EP_INTERRUPT && transfer_type != LIBUSB_TRANSFER_TYPE_INTERRUPT) ||
+		(pEPHandle->nType == XN_USB_EP_ISOCHRONOUS && transfer_type != LIBUSB_TRANSFER_TYPE_ISOCHRONOUS))
+	{
+		return (XN_STATUS_USB_WRONG_ENDPOINT_TYPE);
+	}
+
+	pEPHandle->hDevice = pDevHandle->hDevice;
+	pEPHandle->nMaxPacketSize = nMaxPacketSize;
+	pEPHandle->pBackendData = NULL;
+
+	return (XN_STATUS_OK);
+}
+
+static int xnUSBLibusbTransfer(XN_USB_EP_HANDLE pEPHandle, XnUChar* pBuffer, XnUInt32 nLength, XnUInt32* pnTransferred, XnUInt32 nTimeOut)
+{
+	int nTransferred = 0;
+	int rc = 0;
+
+	if (pEPHandle->nType == XN_USB_EP_BULK)
+	{
+		rc = libusb_bulk_transfer(pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nLength, &nTransferred, nTimeOut);
+	}
+	else
+	{
+		rc = libusb_interrupt_transfer(pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nLength, &nTransferred, nTimeOut);
+	}
+
+	*pnTransferred = nTransferred;
+	return (rc);
+}
+
+static int xnUSBLibusbSubmitTransfer(void* /*pEndPointData*/, libusb_transfer* pTransfer)
+{
+	return libusb_submit_transfer(pTransfer);
+}
+
+static int xnUSBLibusbCancelTransfer(void* /*pEndPointData*/, libusb_transfer* pTransfer)
+{
+	return libusb_cancel_transfer(pTransfer);
+}
+
+static const XnUSBBackend g_libusbBackend = 
+{
+	"libusb",
+	xnUSBLibusbCloseDevice,
+	xnUSBLibusbSetInterface,
+	xnUSBLibusbControlTransfer,
+	xnUSBLibusbOpenEndPoint,
+	xnUSBLibusbTransfer,
+	xnUSBLibusbSubmitTransfer,
+	xnUSBLibusbCancelTransfer,
+	NULL,
+};
 
 //---------------------------------------------------------------------------
 // Code
@@ -105,15 +266,20 @@ XnStatus xnUSBPlatformSpecificInit()
 {
 	xnLogVerbose(XN_MASK_USB, "Initializing USB...");
 
-	// initialize the library
+	XnStatus nRetVal = xnOSCreateCriticalSection(&g_InitData.hLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnUSBSimulatorInit();
+	XN_IS_STATUS_OK(nRetVal);
+
+	// initialize the library. Without it, no device will be found, but simulated devices still work.
 	int rc = libusb_init(&g_InitData.pContext);
 	if (rc != 0)
 	{
-		return (XN_STATUS_USB_INIT_FAILED);
+		g_InitData.pContext = NULL;
+		xnLogWarning(XN_MASK_USB, "Failed to initialize libusb (err=%d). USB devices will not be available.", rc);
+		return (XN_STATUS_OK);
 	}
-
-	XnStatus nRetVal = xnOSCreateCriticalSection(&g_InitData.hLock);
-	XN_IS_STATUS_OK(nRetVal);
 	
 	//libusb_set_debug(g_InitData.pContext, 3);
 	
@@ -152,6 +318,8 @@ XnStatus xnUSBAsynchThreadAddRef()
 			xnLogWarning(XN_MASK_USB, "USB events thread: Failed to set thread priority to critical. This might cause loss of data...");
 			printf("Warning: USB events thread - failed to set priority. This might cause loss of data...\n");
 		}
+
+		xnOSApplyThreadPolicy(g_InitData.hThread, XN_THREAD_ROLE_USB_EVENTS, "XnUSBEvents");
 	}
 	
 	return (XN_STATUS_OK);	
@@ -198,6 +366,8 @@ XnStatus xnUSBPlatformSpecificShutdown()
 	
 	xnUSBAsynchThreadStop();
 
+	xnUSBSimulatorShutdown();
+
 	if (g_InitData.hLock != NULL)
 	{
 		xnOSCloseCriticalSection(&g_InitData.hLock);
@@ -222,6 +392,11 @@ XnStatus FindDevice(XnUInt16 nVendorID, XnUInt16 nProductID, void* pExtraParam,
 {
 	*ppDevice = NULL;
 
+	if (g_InitData.pContext == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
 	// get device list
 	libusb_device** ppDevices;
 	ssize_t nDeviceCount = libusb_get_device_list(g_InitData.pContext, &ppDevices);
@@ -284,17 +459,24 @@ XN_C_API XnStatus xnUSBIsDevicePresent(XnUInt16 nVendorID, XnUInt16 nProductID,
 		// unref device
 		libusb_unref_device(pDevice);
 	}
+	else
+	{
+		*pbDevicePresent = (xnUSBSimulatorEnumerateDevices(nVendorID, nProductID, NULL, 0) != 0);
+	}
 	
 	return (XN_STATUS_OK);
 }
 
 XN_C_API XnStatus xnUSBEnumerateDevices(XnUInt16 nVendorID, XnUInt16 nProductID, const XnUSBConnectionString** pastrDevicePaths, XnUInt32* pnCount)
 {
-	XnStatus nRetVal = XN_STATUS_OK;
-	
 	// get device list
-	libusb_device** ppDevices;
-	ssize_t nDeviceCount = libusb_get_device_list(g_InitData.pContext, &ppDevices);
+	libusb_device** ppDevices = NULL;
+	ssize_t nDeviceCount = 0;
+	
+	if (g_InitData.pContext != NULL)
+	{
+		nDeviceCount = libusb_get_device_list(g_InitData.pContext, &ppDevices);
+	}
 	
 	// first enumeration - count
 	XnUInt32 nCount = 0;
@@ -318,12 +500,18 @@ XN_C_API XnStatus xnUSBEnumerateDevices(XnUInt16 nVendorID, XnUInt16 nProductID,
 			++nCount;
 		}
 	}
+
+	// simulated devices are listed after the real ones
+	XnUInt32 nSimulatedCount = xnUSBSimulatorEnumerateDevices(nVendorID, nProductID, NULL, 0);
 	
 	// allocate array
-	XnUSBConnectionString* aResult = (XnUSBConnectionString*)xnOSCalloc(nCount, sizeof(XnUSBConnectionString));
+	XnUSBConnectionString* aResult = (XnUSBConnectionString*)xnOSCalloc(nCount + nSimulatedCount, sizeof(XnUSBConnectionString));
 	if (aResult == NULL)
 	{
-		libusb_free_device_list(ppDevices, 1);
+		if (ppDevices != NULL)
+		{
+			libusb_free_device_list(ppDevices, 1);
+		}
 		return XN_STATUS_ALLOC_FAILED;
 	}
 	
@@ -339,6 +527,7 @@ XN_C_API XnStatus xnUSBEnumerateDevices(XnUInt16 nVendorID, XnUInt16 nProductID,
 		if (rc != 0)
 		{
 			libusb_free_device_list(ppDevices, 1);
+			xnOSFree(aResult);
 			return (XN_STATUS_USB_ENUMERATE_FAILED);
 		}
 		
@@ -349,12 +538,18 @@ XN_C_API XnStatus xnUSBEnumerateDevices(XnUInt16 nVendorID, XnUInt16 nProductID,
 			nCurrent++;
 		}
 	}
+
+	// devices may have been disconnected since they were counted
+	nSimulatedCount = XN_MIN(nSimulatedCount, xnUSBSimulatorEnumerateDevices(nVendorID, nProductID, aResult + nCount, nSimulatedCount));
 	
 	*pastrDevicePaths = aResult;
-	*pnCount = nCount;
+	*pnCount = nCount + nSimulatedCount;
 		
 	// free the list (also dereference each device)
-	libusb_free_device_list(ppDevices, 1);
+	if (ppDevices != NULL)
+	{
+		libusb_free_device_list(ppDevices, 1);
+	}
 	
 	return XN_STATUS_OK;
 }
@@ -420,6 +615,8 @@ XN_C_API XnStatus xnUSBOpenDeviceImpl(libusb_device* pDevice, XN_USB_DEV_HANDLE*
 	pDevHandle->hDevice = handle;
 	pDevHandle->nInterface = 0;
 	pDevHandle->nAltSetting = 0;
+	pDevHandle->pBackend = &g_libusbBackend;
+	pDevHandle->pBackendData = NULL;
 	
 	// mark the device is of high-speed
 	pDevHandle->nDevSpeed = XN_USB_DEVICE_HIGH_SPEED;
@@ -447,6 +644,13 @@ XN_C_API XnStatus xnUSBOpenDevice(XnUInt16 nVendorID, XnUInt16 nProductID, void*
 	libusb_device* pDevice;
 	nRetVal = FindDevice(nVendorID, nProductID, pExtraParam, &pDevice);
 	XN_IS_STATUS_OK(nRetVal);
+
+	// when there is no such real device, try a simulated one
+	XnUSBConnectionString strSimulatedPath;
+	if (pDevice == NULL && xnUSBSimulatorEnumerateDevices(nVendorID, nProductID, &strSimulatedPath, 1) != 0)
+	{
+		return xnUSBSimulatorOpenDevice(strSimulatedPath, pDevHandlePtr);
+	}
 		
 	nRetVal = xnUSBOpenDeviceImpl(pDevice, pDevHandlePtr);
 	XN_IS_STATUS_OK(nRetVal);
@@ -457,6 +661,18 @@ XN_C_API XnStatus xnUSBOpenDevice(XnUInt16 nVendorID, XnUInt16 nProductID, void*
 XN_C_API XnStatus xnUSBOpenDeviceByPath(const XnUSBConnectionString strDevicePath, XN_USB_DEV_HANDLE* pDevHandlePtr)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
+
+	// make sure library was initialized
+	XN_VALIDATE_USB_INIT();
+	
+	// Validate parameters
+	XN_VALIDATE_INPUT_PTR(strDevicePath);
+	XN_VALIDATE_OUTPUT_PTR(pDevHandlePtr);
+
+	if (xnUSBSimulatorIsDevicePath(strDevicePath))
+	{
+		return xnUSBSimulatorOpenDevice(strDevicePath, pDevHandlePtr);
+	}
 	
 	// parse connection string
 	XnUInt16 nVendorID = 0;
@@ -470,6 +686,11 @@ XN_C_API XnStatus xnUSBOpenDeviceByPath(const XnUSBConnectionString strDevicePat
 		XN_LOG_WARNING_RETURN(XN_STATUS_USB_DEVICE_OPEN_FAILED, "Invalid connection string: %s", strDevicePath);
 	}
 
+	if (g_InitData.pContext == NULL)
+	{
+		return (XN_STATUS_USB_DEVICE_NOT_FOUND);
+	}
+
 	// find device	
 	libusb_device** ppDevices;
 	ssize_t nDeviceCount = libusb_get_device_list(g_InitData.pContext, &ppDevices);
@@ -513,17 +734,13 @@ XN_C_API XnStatus xnUSBCloseDevice(XN_USB_DEV_HANDLE pDevHandle)
 	XN_VALIDATE_USB_INIT();
 	XN_VALIDATE_DEVICE_HANDLE(pDevHandle);
 
-	int rc = libusb_release_interface(pDevHandle->hDevice, pDevHandle->nInterface);
+	int rc = pDevHandle->pBackend->CloseDevice(pDevHandle);
 	if (0 != rc)
 	{
 		return (XN_STATUS_USB_DEVICE_CLOSE_FAILED);
 	}
 
-	libusb_close(pDevHandle->hDevice);
-
 	XN_FREE_AND_NULL(pDevHandle);
-	
-	xnUSBAsynchThreadRelease();
 
 	return (XN_STATUS_OK);
 }
@@ -556,7 +773,7 @@ XN_C_API XnStatus xnUSBSetInterface(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nInter
 	XN_VALIDATE_USB_INIT();
 	XN_VALIDATE_DEVICE_HANDLE(pDevHandle);
 	
-	int rc = libusb_set_interface_alt_setting(pDevHandle->hDevice, nInterface, nAltInterface);
+	int rc = pDevHandle->pBackend->SetInterface(pDevHandle, nInterface, nAltInterface);
 	if (rc != 0)
 	{
 		return (XN_STATUS_USB_SET_INTERFACE_FAILED);
@@ -575,141 +792,56 @@ XN_C_API XnStatus xnUSBGetInterface(XN_USB_DEV_HANDLE pDevHandle, XnUInt8* pnInt
 
 XN_C_API XnStatus xnUSBOpenEndPoint(XN_USB_DEV_HANDLE pDevHandle, XnUInt16 nEndPointID, XnUSBEndPointType nEPType, XnUSBDirectionType nDirType, XN_USB_EP_HANDLE* pEPHandlePtr)
 {
+	XnStatus nRetVal = XN_STATUS_OK;
+
 	// validate parameters
 	XN_VALIDATE_USB_INIT();
 	XN_VALIDATE_DEVICE_HANDLE(pDevHandle);
 	XN_VALIDATE_OUTPUT_PTR(pEPHandlePtr);
 
-	// get the device from the handle
-	libusb_device* pDevice = libusb_get_device(pDevHandle->hDevice);
-	
-	// get the configuration descriptor
-	libusb_config_descriptor* pConfig;
-	int rc = libusb_get_active_config_descriptor(pDevice, &pConfig);
-	if (rc != 0)
-	{
-		return (XN_STATUS_USB_CONFIG_QUERY_FAILED);
-	}
-	
-	// make sure configuration contains the interface we need
-	if (pConfig->bNumInterfaces <= pDevHandle->nInterface)
+	if (nEPType != XN_USB_EP_BULK && nEPType != XN_USB_EP_INTERRUPT && nEPType != XN_USB_EP_ISOCHRONOUS)
 	{
-		libusb_free_config_descriptor(pConfig);
-		return (XN_STATUS_USB_INTERFACE_QUERY_FAILED);
+		return (XN_STATUS_USB_UNKNOWN_ENDPOINT_TYPE);
 	}
-	
-	// take that interface
-	const libusb_interface* pInterface = &pConfig->interface[pDevHandle->nInterface];
-	
-	// make sure interface contains the alternate setting we work with
-	if (pInterface->num_altsetting <= pDevHandle->nAltSetting)
+
+	// Make sure the endpoint matches the required direction
+	libusb_endpoint_direction direction = (libusb_endpoint_direction)(nEndPointID & 0x80); // 8th bit
+	if (nDirType == XN_USB_DIRECTION_IN)
 	{
-		libusb_free_config_descriptor(pConfig);
-		return (XN_STATUS_USB_INTERFACE_QUERY_FAILED);
+		if (direction != LIBUSB_ENDPOINT_IN)
+		{
+			return (XN_STATUS_USB_WRONG_ENDPOINT_DIRECTION);
+		}
 	}
-	
-	// take that setting
-	const libusb_interface_descriptor* pInterfaceDesc = &pInterface->altsetting[pDevHandle->nAltSetting];
-	
-	// search for the requested endpoint
-	const libusb_endpoint_descriptor* pEndpointDesc = NULL;
-	
-	for (uint8_t i = 0; i < pInterfaceDesc->bNumEndpoints; ++i)
+	else if (nDirType == XN_USB_DIRECTION_OUT)
 	{
-		if (pInterfaceDesc->endpoint[i].bEndpointAddress == nEndPointID)
+		if (direction != LIBUSB_ENDPOINT_OUT)
 		{
-			pEndpointDesc = &pInterfaceDesc->endpoint[i];
-			break;
+			return (XN_STATUS_USB_WRONG_ENDPOINT_DIRECTION);
 		}
 	}
-	
-	if (pEndpointDesc == NULL)
+	else
 	{
-		libusb_free_config_descriptor(pConfig);
-		return (XN_STATUS_USB_ENDPOINT_NOT_FOUND);
+		return (XN_STATUS_USB_UNKNOWN_ENDPOINT_DIRECTION);
 	}
 	
-	libusb_transfer_type transfer_type = (libusb_transfer_type)(pEndpointDesc->bmAttributes & 0x3); // lower 2-bits
+	// allocate handle
+	XN_VALIDATE_ALIGNED_CALLOC(*pEPHandlePtr, XnUSBEPHandle, 1, XN_DEFAULT_MEM_ALIGN);
+	XN_USB_EP_HANDLE pHandle = *pEPHandlePtr;
+	pHandle->nAddress = nEndPointID;
+	pHandle->nType = nEPType;
+	pHandle->nDirection = nDirType;
+	pHandle->readThreadMode = xnUSBGetDefaultReadThreadMode();
+	pHandle->pBackend = pDevHandle->pBackend;
 
-    // calculate max packet size
-	// NOTE: we do not use libusb functions (libusb_get_max_packet_size/libusb_get_max_iso_packet_size) because
-	// they hace a bug and does not consider alternative interface
-    XnUInt32 nMaxPacketSize = 0;
-	
-	if (transfer_type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
-	{
-		XnUInt32 wMaxPacketSize = pEndpointDesc->wMaxPacketSize;
-		// bits 11 and 12 mark the number of additional transactions, bits 0-10 mark the size
-		XnUInt32 nAdditionalTransactions = wMaxPacketSize >> 11;
-		XnUInt32 nPacketSize = wMaxPacketSize & 0x7FF;
-		nMaxPacketSize = (nAdditionalTransactions + 1) * (nPacketSize);
-	}
-	else
+	// let the backend find the endpoint
+	nRetVal = pDevHandle->pBackend->OpenEndPoint(pDevHandle, pHandle);
+	if (nRetVal != XN_STATUS_OK)
 	{
-		nMaxPacketSize = pEndpointDesc->wMaxPacketSize;
+		XN_ALIGNED_FREE_AND_NULL(*pEPHandlePtr);
+		return (nRetVal);
 	}
 
-	// free the configuration descriptor. no need of it anymore
-	libusb_free_config_descriptor(pConfig);
-	pConfig = NULL;
-	
-	// Make sure the endpoint matches the required endpoint type
-	if (nEPType == XN_USB_EP_BULK)
-	{
-		if (transfer_type != LIBUSB_TRANSFER_TYPE_BULK)
-		{
-			return (XN_STATUS_USB_WRONG_ENDPOINT_TYPE);
-		}
-	}
-	else if (nEPType == XN_USB_EP_INTERRUPT)
-	{
-		if (transfer_type != LIBUSB_TRANSFER_TYPE_INTERRUPT)
-		{
-			return (XN_STATUS_USB_WRONG_ENDPOINT_TYPE);
-		}
-	}
-	else if (nEPType == XN_USB_EP_ISOCHRONOUS)
-	{
-		if (transfer_type != LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
-		{
-			return (XN_STATUS_USB_WRONG_ENDPOINT_TYPE);
-		}
-	}
-	else
-	{
-		return (XN_STATUS_USB_UNKNOWN_ENDPOINT_TYPE);
-	}
-
-	// Make sure the endpoint matches the required direction
-	libusb_endpoint_direction direction = (libusb_endpoint_direction)(nEndPointID & 0x80); // 8th bit
-	if (nDirType == XN_USB_DIRECTION_IN)
-	{
-		if (direction != LIBUSB_ENDPOINT_IN)
-		{
-			return (XN_STATUS_USB_WRONG_ENDPOINT_DIRECTION);
-		}
-	}
-	else if (nDirType == XN_USB_DIRECTION_OUT)
-	{
-		if (direction != LIBUSB_ENDPOINT_OUT)
-		{
-			return (XN_STATUS_USB_WRONG_ENDPOINT_DIRECTION);
-		}
-	}
-	else
-	{
-		return (XN_STATUS_USB_UNKNOWN_ENDPOINT_DIRECTION);
-	}
-	
-	// allocate handle
-	XN_VALIDATE_ALIGNED_CALLOC(*pEPHandlePtr, XnUSBEPHandle, 1, XN_DEFAULT_MEM_ALIGN);
-	XN_USB_EP_HANDLE pHandle = *pEPHandlePtr;
-	pHandle->hDevice = pDevHandle->hDevice;
-	pHandle->nAddress = nEndPointID;
-	pHandle->nType = nEPType;
-	pHandle->nDirection = nDirType;
-	pHandle->nMaxPacketSize = nMaxPacketSize;
-
 	return XN_STATUS_OK;
 }
 
@@ -719,6 +851,11 @@ XN_C_API XnStatus xnUSBCloseEndPoint(XN_USB_EP_HANDLE pEPHandle)
 	XN_VALIDATE_USB_INIT();
 	XN_VALIDATE_EP_HANDLE(pEPHandle);
 	
+	if (pEPHandle->pBackend->CloseEndPoint != NULL)
+	{
+		pEPHandle->pBackend->CloseEndPoint(pEPHandle->pBackendData);
+	}
+
 	XN_ALIGNED_FREE_AND_NULL(pEPHandle);
 	
 	return XN_STATUS_OK;
@@ -788,7 +925,7 @@ XN_C_API XnStatus xnUSBSendControl(XN_USB_DEV_HANDLE pDevHandle, XnUSBControlTyp
 	bmRequestType |= LIBUSB_ENDPOINT_OUT;
 	
 	// send	
-	int nBytesSent = libusb_control_transfer(pDevHandle->hDevice, bmRequestType, nRequest, nValue, nIndex, pBuffer, nBufferSize, nTimeOut);
+	int nBytesSent = pDevHandle->pBackend->ControlTransfer(pDevHandle, bmRequestType, nRequest, nValue, nIndex, pBuffer, (XnUInt16)nBufferSize, nTimeOut);
 	
 	// check everything went OK
 	if (nBytesSent == LIBUSB_ERROR_TIMEOUT)
@@ -845,7 +982,7 @@ XN_C_API XnStatus xnUSBReceiveControl(XN_USB_DEV_HANDLE pDevHandle, XnUSBControl
 	bmRequestType |= LIBUSB_ENDPOINT_IN;
 	
 	// send	
-	int nBytesReceived = libusb_control_transfer(pDevHandle->hDevice, bmRequestType, nRequest, nValue, nIndex, pBuffer, nBufferSize, nTimeOut);
+	int nBytesReceived = pDevHandle->pBackend->ControlTransfer(pDevHandle, bmRequestType, nRequest, nValue, nIndex, pBuffer, (XnUInt16)nBufferSize, nTimeOut);
 	
 	// check everything went OK
 	if (nBytesReceived == LIBUSB_ERROR_TIMEOUT)
@@ -885,28 +1022,21 @@ XN_C_API XnStatus xnUSBWriteEndPoint(XN_USB_EP_HANDLE pEPHandle, XnUChar* pBuffe
 	{
 		return (XN_STATUS_USB_WRONG_ENDPOINT_DIRECTION);
 	}
-	
+
 	if (nBufferSize == 0)
 	{
 		return (XN_STATUS_USB_BUFFER_TOO_SMALL);
 	}
 
-	// send (according to EP type)
-	int nBytesSent = 0;
-	int rc = 0;
-	
-	if (pEPHandle->nType == XN_USB_EP_BULK)
-	{
-		rc = libusb_bulk_transfer(pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, &nBytesSent, nTimeOut);
-	}
-	else if (pEPHandle->nType == XN_USB_EP_INTERRUPT)
-	{
-		rc = libusb_interrupt_transfer(pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, &nBytesSent, nTimeOut);
-	}
-	else
+	// only bulk and interrupt endpoints can be written synchronously
+	if (pEPHandle->nType != XN_USB_EP_BULK && pEPHandle->nType != XN_USB_EP_INTERRUPT)
 	{
 		return (XN_STATUS_USB_UNSUPPORTED_ENDPOINT_TYPE);
 	}
+
+	// send
+	XnUInt32 nBytesSent = 0;
+	int rc = pEPHandle->pBackend->Transfer(pEPHandle, pBuffer, nBufferSize, &nBytesSent, nTimeOut);
 	
 	// check result
 	if (rc == LIBUSB_ERROR_TIMEOUT)
@@ -944,24 +1074,17 @@ XN_C_API XnStatus xnUSBReadEndPoint(XN_USB_EP_HANDLE pEPHandle, XnUChar* pBuffer
 		return (XN_STATUS_USB_BUFFER_TOO_SMALL);
 	}
 	
-	// receive (according to EP type)
-	*pnBytesReceived = 0;
-
-	int nBytesReceived = 0;
-	int rc = 0;
-	
-	if (pEPHandle->nType == XN_USB_EP_BULK)
-	{
-		rc = libusb_bulk_transfer(pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, &nBytesReceived, nTimeOut);
-	}
-	else if (pEPHandle->nType == XN_USB_EP_INTERRUPT)
-	{
-		rc = libusb_interrupt_transfer(pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, &nBytesReceived, nTimeOut);
-	}
-	else
+	// only bulk and interrupt endpoints can be read synchronously
+	if (pEPHandle->nType != XN_USB_EP_BULK && pEPHandle->nType != XN_USB_EP_INTERRUPT)
 	{
 		return (XN_STATUS_USB_UNSUPPORTED_ENDPOINT_TYPE);
 	}
+
+	// receive
+	*pnBytesReceived = 0;
+
+	XnUInt32 nBytesReceived = 0;
+	int rc = pEPHandle->pBackend->Transfer(pEPHandle, pBuffer, nBufferSize, &nBytesReceived, nTimeOut);
 	
 	// check result
 	if (rc == LIBUSB_ERROR_TIMEOUT)
@@ -1004,9 +1127,23 @@ void xnCleanupThreadData(XnUSBReadThreadData* pThreadData)
 			pThreadData->pBuffersInfo[i].transfer = NULL;
 			xnOSCloseEvent(&pThreadData->pBuffersInfo[i].hEvent);
 		}
+
+		XN_FREE_AND_NULL(pThreadData->pBuffersInfo[i].aPackets);
 	}
 	
 	XN_ALIGNED_FREE_AND_NULL(pThreadData->pBuffersInfo);
+
+	if (pThreadData->hDrainedEvent != NULL)
+	{
+		xnOSCloseEvent(&pThreadData->hDrainedEvent);
+		pThreadData->hDrainedEvent = NULL;
+	}
+
+	if (pThreadData->hLock != NULL)
+	{
+		xnOSCloseCriticalSection(&pThreadData->hLock);
+		pThreadData->hLock = NULL;
+	}
 }
 
 /** Checks if any transfer of the thread is queued. */
@@ -1021,6 +1158,171 @@ XnBool xnIsAnyTransferQueued(XnUSBReadThreadData* pThreadData)
 	return (FALSE);
 }
 
+/** Submits the transfer of a buffer. Returns FALSE if it could not be submitted. */
+static XnBool xnUSBSubmitBuffer(XnUSBBuffersInfo* pBufferInfo)
+{
+	XnUSBReadThreadData* pThreadData = pBufferInfo->pThreadData;
+	libusb_transfer* pTransfer = pBufferInfo->transfer;
+
+	pBufferInfo->bIsQueued = TRUE;
+	xnOSGetHighResTimeStamp(&pBufferInfo->nSubmitTime);
+
+	int rc = pThreadData->bDeviceGone ? LIBUSB_ERROR_NO_DEVICE : pThreadData->pBackend->SubmitTransfer(pThreadData->pBackendData, pTransfer);
+	if (rc != 0)
+	{
+		pBufferInfo->bIsQueued = FALSE;
+		xnMetricsAdd(&pThreadData->statistics.nSubmitFailures, 1);
+
+		if (rc == LIBUSB_ERROR_NO_DEVICE)
+		{
+			// report the disconnection once, rather than for every buffer
+			if (!pThreadData->bDeviceGone)
+			{
+				pThreadData->bDeviceGone = TRUE;
+				xnLogError(XN_MASK_USB, "Endpoint 0x%x: device was disconnected!", pTransfer->endpoint);
+
+				for (XnUSBEventCallbackList::Iterator it = g_connectivityEvent.Begin(); it != g_connectivityEvent.End(); ++it)
+				{
+					XnUSBEventCallback* pCallback = *it;
+					XnUSBEventArgs args;
+					args.strDevicePath = NULL;
+					args.eventType = XN_USB_EVENT_DEVICE_DISCONNECT;
+					pCallback->pFunc(&args, pCallback->pCookie);
+				}
+			}
+		}
+		else
+		{
+			xnLogError(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: Failed to submit asynch I/O transfer (err=%d)!", pTransfer->endpoint, pBufferInfo->nBufferID, rc);
+		}
+
+		return (FALSE);
+	}
+
+	return (TRUE);
+}
+
+static XnStatus xnUSBTranslatePacketStatus(libusb_transfer_status status)
+{
+	switch (status)
+	{
+	case LIBUSB_TRANSFER_COMPLETED:
+		return (XN_STATUS_OK);
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		return (XN_STATUS_USB_TRANSFER_TIMEOUT);
+	case LIBUSB_TRANSFER_STALL:
+		return (XN_STATUS_USB_TRANSFER_STALL);
+	default:
+		return (XN_STATUS_USB_ENDPOINT_READ_FAILED);
+	}
+}
+
+/** Passes the data of a returned transfer to the read callback, and counts it. */
+static void xnUSBProcessTransfer(XnUSBBuffersInfo* pBufferInfo)
+{
+	XnUSBReadThreadData* pThreadData = pBufferInfo->pThreadData;
+	XnUSBEndPointStatisticsData* pStatistics = &pThreadData->statistics;
+	libusb_transfer* pTransfer = pBufferInfo->transfer;
+	XnUSBPacket* aPackets = pBufferInfo->aPackets;
+	XnUInt32 nPackets = 1;
+
+	xnMetricsAdd(&pStatistics->nTransfers, 1);
+
+	if (pBufferInfo->nLastStatus == LIBUSB_TRANSFER_TIMED_OUT)
+	{
+		// some data may have arrived before the timeout
+		xnMetricsAdd(&pStatistics->nTimeouts, 1);
+	}
+	else if (pBufferInfo->nLastStatus != LIBUSB_TRANSFER_COMPLETED && // read succeeded
+		pBufferInfo->nLastStatus != LIBUSB_TRANSFER_CANCELLED)        // cancelled, but maybe some data arrived
+	{
+		xnMetricsAdd(&pStatistics->nFailedTransfers, 1);
+		xnLogWarning(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: Asynch transfer failed (status: %d)", pTransfer->endpoint, pBufferInfo->nBufferID, pBufferInfo->nLastStatus);
+		return;
+	}
+
+	XnUInt32 nTotalBytes = 0;
+
+	if (pTransfer->type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
+	{
+		nPackets = pTransfer->num_iso_packets;
+
+		for (XnUInt32 i = 0; i < nPackets; ++i)
+		{
+			struct libusb_iso_packet_descriptor* pPacket = &pTransfer->iso_packet_desc[i];
+			XnUChar* pBuffer = libusb_get_iso_packet_buffer_simple(pTransfer, i);
+			XnUInt32 nPacketBytes = 0;
+
+			if (pPacket->status == LIBUSB_TRANSFER_COMPLETED)
+			{
+				nPacketBytes = pPacket->actual_length;
+			}
+			else
+			{
+				xnMetricsAdd(&pStatistics->nFailedPackets, 1);
+				xnLogWarning(XN_MASK_USB, "Endpoint 0x%x, Buffer %d, packet %d Asynch transfer failed (status: %d)", pTransfer->endpoint, pBufferInfo->nBufferID, i, pPacket->status);
+			}
+
+			if (aPackets != NULL)
+			{
+				// packets are passed where they are
+				aPackets[i].pData = pBuffer;
+				aPackets[i].nSize = nPacketBytes;
+				aPackets[i].nStatus = xnUSBTranslatePacketStatus(pPacket->status);
+			}
+			else if (nPacketBytes != 0 && pTransfer->buffer + nTotalBytes != pBuffer)
+			{
+				// some packets may return empty, so we need to remove spaces, and make the buffer sequential
+				memmove(pTransfer->buffer + nTotalBytes, pBuffer, nPacketBytes);
+			}
+
+			nTotalBytes += nPacketBytes;
+		}
+
+		if (nTotalBytes == 0)
+		{
+			return;
+		}
+	}
+	else
+	{
+		nTotalBytes = pTransfer->actual_length;
+
+		if (nTotalBytes == 0 && (pBufferInfo->nLastStatus == LIBUSB_TRANSFER_TIMED_OUT || aPackets != NULL))
+		{
+			return;
+		}
+
+		if (aPackets != NULL)
+		{
+			aPackets[0].pData = pTransfer->buffer;
+			aPackets[0].nSize = nTotalBytes;
+			aPackets[0].nStatus = XN_STATUS_OK;
+		}
+	}
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+	xnMetricsAddLatency(&pStatistics->dispatchLatency, nStart - pBufferInfo->nCompletionTime);
+
+	// call callback method
+	XN_TRACE_BEGIN(XN_TRACE_USB_TRANSFER, pThreadData->strTraceName, 0, 0, nTotalBytes);
+	if (aPackets != NULL)
+	{
+		pThreadData->pPacketsCallbackFunction(aPackets, nPackets, pThreadData->pCallbackData);
+	}
+	else
+	{
+		pThreadData->pCallbackFunction(pTransfer->buffer, nTotalBytes, pThreadData->pCallbackData);
+	}
+	XN_TRACE_END(XN_TRACE_USB_TRANSFER, pThreadData->strTraceName, 0, 0, nTotalBytes);
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+	xnMetricsAddLatency(&pStatistics->callbackDuration, nEnd - nStart);
+	xnMetricsAdd(&pStatistics->nBytes, nTotalBytes);
+}
+
 XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 {
 	XnUSBReadThreadData* pThreadData = (XnUSBReadThreadData*)pThreadParam;
@@ -1031,20 +1333,17 @@ XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 	{
 		xnLogWarning(XN_MASK_USB, "Failed to set thread priority to critical. This might cause loss of data...");
 	}
+
+	// configured policy is applied from within the thread, so it is not overridden by the priority set above
+	XnChar strThreadName[XN_THREAD_ROLE_MAX_LENGTH];
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(strThreadName, sizeof(strThreadName), &nCharsWritten, "XnUSB %s", pThreadData->strTraceName);
+	xnOSApplyThreadPolicy(pThreadData->hReadThread, XN_THREAD_ROLE_USB_READ, strThreadName);
 	
 	// first of all, submit all transfers
 	for (XnUInt32 i = 0; i < pThreadData->nNumBuffers; ++i)
 	{
-		XnUSBBuffersInfo* pBufferInfo = &pThreadData->pBuffersInfo[i];
-		libusb_transfer* pTransfer = pBufferInfo->transfer;
-		
-		// submit request
-		pBufferInfo->bIsQueued = TRUE;
-		int rc = libusb_submit_transfer(pTransfer);
-		if (rc != 0)
-		{
-			xnLogError(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: Failed to submit asynch I/O transfer (err=%d)!", pTransfer->endpoint, pBufferInfo->nBufferID, rc);
-		}
+		xnUSBSubmitBuffer(&pThreadData->pBuffersInfo[i]);
 	}
 	
 	// now let libusb process asynchornous I/O
@@ -1062,14 +1361,28 @@ XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 			XnUSBBuffersInfo* pBufferInfo = &pThreadData->pBuffersInfo[i];
 			libusb_transfer* pTransfer = pBufferInfo->transfer;
 
+			if (!pBufferInfo->bIsQueued)
+			{
+				// it could not be submitted. Unless the device is gone, try again once the timeout passes.
+				xnOSWaitEvent(pBufferInfo->hEvent, pThreadData->bKillReadThread ? 0 : pThreadData->nTimeOut);
+				if (!pThreadData->bKillReadThread)
+				{
+					xnUSBSubmitBuffer(pBufferInfo);
+				}
+				continue;
+			}
+
 			// wait for the next transfer to be completed, and process it
 			nRetVal = xnOSWaitEvent(pBufferInfo->hEvent, pThreadData->bKillReadThread ? 0 : pThreadData->nTimeOut);
 			if (nRetVal == XN_STATUS_OS_EVENT_TIMEOUT)
 			{
-//				xnLogWarning(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: timeout. cancelling transfer...", pTransfer->endpoint, pBufferInfo->nBufferID);
-				
+				if (!pThreadData->bKillReadThread)
+				{
+					xnMetricsAdd(&pThreadData->statistics.nTimeouts, 1);
+				}
+
 				// cancel it
-				int rc = libusb_cancel_transfer(pBufferInfo->transfer);
+				int rc = pThreadData->pBackend->CancelTransfer(pThreadData->pBackendData, pBufferInfo->transfer);
 				if (rc != 0)
 				{
 					xnLogError(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: Failed to cancel asynch I/O transfer (err=%d)!", pTransfer->endpoint, pBufferInfo->nBufferID, rc);
@@ -1093,76 +1406,12 @@ XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 			}
 			else // transfer done
 			{
-				if (pBufferInfo->nLastStatus == LIBUSB_TRANSFER_COMPLETED || // read succeeded
-					pBufferInfo->nLastStatus == LIBUSB_TRANSFER_CANCELLED)   // cancelled, but maybe some data arrived
-				{
-					if (pTransfer->type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
-					{
-						XnUInt32 nTotalBytes = 0;
-						
-						// some packets may return empty, so we need to remove spaces, and make the buffer sequential
-						for (XnUInt32 i = 0; i < pTransfer->num_iso_packets; ++i)
-						{
-							struct libusb_iso_packet_descriptor* pPacket = &pTransfer->iso_packet_desc[i];
-							if (pPacket->status == LIBUSB_TRANSFER_COMPLETED && pPacket->actual_length != 0)
-							{
-								XnUChar* pBuffer = libusb_get_iso_packet_buffer_simple(pTransfer, i);
-								// if buffer is not at same offset, move it
-								if (pTransfer->buffer + nTotalBytes != pBuffer)
-								{
-//									printf("buffer %d has %d bytes. Moving to offset %d...\n", i, pPacket->actual_length, nTotalBytes);
-									memmove(pTransfer->buffer + nTotalBytes, pBuffer, pPacket->actual_length);
-								}
-								nTotalBytes += pPacket->actual_length;
-							}
-							else if (pPacket->status != LIBUSB_TRANSFER_COMPLETED)
-							{
-								xnLogWarning(XN_MASK_USB, "Endpoint 0x%x, Buffer %d, packet %d Asynch transfer failed (status: %d)", pTransfer->endpoint, pBufferInfo->nBufferID, i, pPacket->status);
-							}
-						}
-						
-						if (nTotalBytes != 0)
-						{
-							// call callback method
-							pBufferInfo->pThreadData->pCallbackFunction(pTransfer->buffer, nTotalBytes, pBufferInfo->pThreadData->pCallbackData);
-						}
-					}
-					else
-					{
-						// call callback method
-						pBufferInfo->pThreadData->pCallbackFunction(pTransfer->buffer, pTransfer->actual_length, pBufferInfo->pThreadData->pCallbackData);
-					}
-				}
-				else if (pBufferInfo->nLastStatus == LIBUSB_TRANSFER_TIMED_OUT)
-				{
-					// no need to do anything.
-				}
-				else
-				{
-					xnLogWarning(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: Asynch transfer failed (status: %d)", pTransfer->endpoint, pBufferInfo->nBufferID, pTransfer->status);
-				}
+				xnUSBProcessTransfer(pBufferInfo);
 
 				// as long as running should continue, resubmit transfer
 				if (!pBufferInfo->pThreadData->bKillReadThread)
 				{
-					pBufferInfo->bIsQueued = TRUE;
-					int rc = libusb_submit_transfer(pTransfer);
-					if (rc != 0)
-					{
-						xnLogError(XN_MASK_USB, "Endpoint 0x%x, Buffer %d: Failed to re-submit asynch I/O transfer (err=%d)!", pTransfer->endpoint, pBufferInfo->nBufferID, rc);
-						if (rc == LIBUSB_ERROR_NO_DEVICE)
-						{
-							for (XnUSBEventCallbackList::Iterator it = g_connectivityEvent.Begin(); it != g_connectivityEvent.End(); ++it)
-							{
-								XnUSBEventCallback* pCallback = *it;
-								XnUSBEventArgs args;
-								args.strDevicePath = NULL;
-								args.eventType = XN_USB_EVENT_DEVICE_DISCONNECT;
-								pCallback->pFunc(&args, pCallback->pCookie);
-							}
-						}
-
-					}
+					xnUSBSubmitBuffer(pBufferInfo);
 				}
 			}
 		}
@@ -1171,16 +1420,47 @@ XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
 }
 
+/** Completion mode: resubmits a processed transfer, unless the read thread is being shut down. */
+static void xnUSBResubmitProcessedTransfer(XnUSBBuffersInfo* pBufferInfo)
+{
+	XnUSBReadThreadData* pThreadData = pBufferInfo->pThreadData;
+
+	// shutdown marks the kill and cancels queued transfers under the same lock, so a transfer resubmitted here 
+	// is either cancelled by it, or not resubmitted at all
+	XnAutoCSLocker locker(pThreadData->hLock);
+
+	if (!pThreadData->bKillReadThread && xnUSBSubmitBuffer(pBufferInfo))
+	{
+		return;
+	}
+
+	// once it is not queued, shutdown may free the buffer, so it must not be touched after the lock is released
+	pBufferInfo->bIsQueued = FALSE;
+	xnOSSetEvent(pThreadData->hDrainedEvent);
+}
+
 /* This function is called whenever transfer is done (successfully or with an error). */
 void xnTransferCallback(libusb_transfer *pTransfer)
 {
 	XnUSBBuffersInfo* pBufferInfo = (XnUSBBuffersInfo*)pTransfer->user_data;
-	
-	// mark that buffer is done
-	pBufferInfo->bIsQueued = FALSE;
+	XnUSBReadThreadData* pThreadData = pBufferInfo->pThreadData;
+
+	xnOSGetHighResTimeStamp(&pBufferInfo->nCompletionTime);
+	xnMetricsAddLatency(&pThreadData->statistics.transferLatency, pBufferInfo->nCompletionTime - pBufferInfo->nSubmitTime);
 	
 	// keep the status (according to libusb documentation, this field is invalid outside the callback method)
 	pBufferInfo->nLastStatus = pTransfer->status;
+
+	if (pThreadData->mode == XN_USB_READ_THREAD_MODE_COMPLETION)
+	{
+		// process the transfer right here, so it is resubmitted without waking up another thread
+		xnUSBProcessTransfer(pBufferInfo);
+		xnUSBResubmitProcessedTransfer(pBufferInfo);
+		return;
+	}
+
+	// mark that buffer is done
+	pBufferInfo->bIsQueued = FALSE;
 	
 	// notify endpoint thread this buffer is done
 	XnStatus nRetVal = xnOSSetEvent(pBufferInfo->hEvent);
@@ -1191,15 +1471,71 @@ void xnTransferCallback(libusb_transfer *pTransfer)
 	}
 }
 
-XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, void* pCallbackData)
+/** Completion mode: submits all transfers. From here on, they are processed by the thread completing them. */
+static XnStatus xnUSBStartCompletionProcessing(XnUSBReadThreadData* pThreadData)
+{
+	XnStatus nRetVal = xnOSCreateCriticalSection(&pThreadData->hLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&pThreadData->hDrainedEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAutoCSLocker locker(pThreadData->hLock);
+
+	for (XnUInt32 i = 0; i < pThreadData->nNumBuffers; ++i)
+	{
+		xnUSBSubmitBuffer(&pThreadData->pBuffersInfo[i]);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+/** Completion mode: cancels all transfers, and waits for them to return. Returns FALSE if some did not. */
+static XnBool xnUSBStopCompletionProcessing(XnUSBReadThreadData* pThreadData)
+{
+	{
+		XnAutoCSLocker locker(pThreadData->hLock);
+
+		pThreadData->bKillReadThread = TRUE;
+
+		for (XnUInt32 i = 0; i < pThreadData->nNumBuffers; ++i)
+		{
+			if (pThreadData->pBuffersInfo[i].bIsQueued)
+			{
+				pThreadData->pBackend->CancelTransfer(pThreadData->pBackendData, pThreadData->pBuffersInfo[i].transfer);
+			}
+		}
+	}
+
+	XnUInt64 nStart;
+	xnOSGetTimeStamp(&nStart);
+
+	while (TRUE)
+	{
+		{
+			XnAutoCSLocker locker(pThreadData->hLock);
+			if (!xnIsAnyTransferQueued(pThreadData))
+			{
+				return (TRUE);
+			}
+		}
+
+		XnUInt64 nNow;
+		xnOSGetTimeStamp(&nNow);
+		if (nNow - nStart >= XN_USB_READ_THREAD_KILL_TIMEOUT)
+		{
+			return (FALSE);
+		}
+
+		xnOSWaitEvent(pThreadData->hDrainedEvent, (XnUInt32)(XN_USB_READ_THREAD_KILL_TIMEOUT - (nNow - nStart)));
+	}
+}
+
+/** Starts a read thread. Exactly one of the callbacks is set. */
+static XnStatus xnUSBInitReadThreadImpl(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, XnUSBReadPacketsCallbackFunctionPtr pPacketsCallbackFunction, void* pCallbackData)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 	
-	// validate parameters
-	XN_VALIDATE_USB_INIT();
-	XN_VALIDATE_EP_HANDLE(pEPHandle);
-	XN_VALIDATE_INPUT_PTR(pCallbackFunction);
-	
 	xnLogVerbose(XN_MASK_USB, "Starting a USB read thread...");
 
 	XnUSBReadThreadData* pThreadData = &pEPHandle->ThreadData;
@@ -1212,9 +1548,18 @@ XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBuff
 	memset(pThreadData, 0, sizeof(XnUSBReadThreadData));
 	pThreadData->nNumBuffers = nNumBuffers;
 	pThreadData->pCallbackFunction = pCallbackFunction;
+	pThreadData->pPacketsCallbackFunction = pPacketsCallbackFunction;
 	pThreadData->pCallbackData = pCallbackData;
 	pThreadData->bKillReadThread = FALSE;
 	pThreadData->nTimeOut = nTimeOut;
+	pThreadData->mode = pEPHandle->readThreadMode;
+	pThreadData->pBackend = pEPHandle->pBackend;
+	pThreadData->pBackendData = pEPHandle->pBackendData;
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(pThreadData->strTraceName, sizeof(pThreadData->strTraceName), &nCharsWritten, "EP 0x%02x", pEPHandle->nAddress);
+
+	// in completion mode, nobody waits for transfers, so they time out on their own
+	XnUInt32 nTransferTimeOut = (pThreadData->mode == XN_USB_READ_THREAD_MODE_COMPLETION) ? nTimeOut : 0;
 
 	// allocate buffers
 	pThreadData->pBuffersInfo = (XnUSBBuffersInfo*)xnOSCallocAligned(nNumBuffers, sizeof(XnUSBBuffersInfo), XN_DEFAULT_MEM_ALIGN);
@@ -1262,15 +1607,15 @@ XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBuff
 		// fill transfer params
 		if (pEPHandle->nType == XN_USB_EP_BULK)
 		{
-			libusb_fill_bulk_transfer(pTransfer, pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, xnTransferCallback, pBufferInfo, 0);
+			libusb_fill_bulk_transfer(pTransfer, pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, xnTransferCallback, pBufferInfo, nTransferTimeOut);
 		}
 		else if (pEPHandle->nType == XN_USB_EP_INTERRUPT)
 		{
-			libusb_fill_interrupt_transfer(pTransfer, pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, xnTransferCallback, pBufferInfo, 0);
+			libusb_fill_interrupt_transfer(pTransfer, pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, xnTransferCallback, pBufferInfo, nTransferTimeOut);
 		}
 		else if (pEPHandle->nType == XN_USB_EP_ISOCHRONOUS)
 		{
-			libusb_fill_iso_transfer(pTransfer, pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, nNumIsoPackets, xnTransferCallback, pBufferInfo, 0);
+			libusb_fill_iso_transfer(pTransfer, pEPHandle->hDevice, pEPHandle->nAddress, pBuffer, nBufferSize, nNumIsoPackets, xnTransferCallback, pBufferInfo, nTransferTimeOut);
 			libusb_set_iso_packet_lengths(pTransfer, nMaxPacketSize);
 		}
 		else
@@ -1285,23 +1630,65 @@ XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBuff
 			xnCleanupThreadData(pThreadData);
 			return (nRetVal);
 		}
+
+		if (pPacketsCallbackFunction != NULL)
+		{
+			pBufferInfo->aPackets = (XnUSBPacket*)xnOSCalloc(XN_MAX(nNumIsoPackets, 1), sizeof(XnUSBPacket));
+			if (pBufferInfo->aPackets == NULL)
+			{
+				xnCleanupThreadData(pThreadData);
+				return (XN_STATUS_ALLOC_FAILED);
+			}
+		}
 	}
 
-	// create a thread to perform the asynchronous read operations
-	nRetVal = xnOSCreateThread(xnUSBReadThreadMain, &pEPHandle->ThreadData, &pThreadData->hReadThread);
-	if (nRetVal != XN_STATUS_OK)
+	if (pThreadData->mode == XN_USB_READ_THREAD_MODE_COMPLETION)
 	{
-		xnCleanupThreadData(pThreadData);
-		return (nRetVal);
+		nRetVal = xnUSBStartCompletionProcessing(pThreadData);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnCleanupThreadData(pThreadData);
+			return (nRetVal);
+		}
+	}
+	else
+	{
+		// create a thread to perform the asynchronous read operations
+		nRetVal = xnOSCreateThread(xnUSBReadThreadMain, &pEPHandle->ThreadData, &pThreadData->hReadThread);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnCleanupThreadData(pThreadData);
+			return (nRetVal);
+		}
 	}
 
 	pThreadData->bIsRunning = TRUE;
 	
-	xnLogInfo(XN_MASK_USB, "USB read thread was started.");
+	xnLogInfo(XN_MASK_USB, "USB read thread was started (%s mode).", pThreadData->mode == XN_USB_READ_THREAD_MODE_COMPLETION ? "completion" : "ordered");
 
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, void* pCallbackData)
+{
+	// validate parameters
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_EP_HANDLE(pEPHandle);
+	XN_VALIDATE_INPUT_PTR(pCallbackFunction);
+
+	return xnUSBInitReadThreadImpl(pEPHandle, nBufferSize, nNumBuffers, nTimeOut, pCallbackFunction, NULL, pCallbackData);
+}
+
+XN_C_API XnStatus xnUSBInitPacketReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadPacketsCallbackFunctionPtr pCallbackFunction, void* pCallbackData)
+{
+	// validate parameters
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_EP_HANDLE(pEPHandle);
+	XN_VALIDATE_INPUT_PTR(pCallbackFunction);
+
+	return xnUSBInitReadThreadImpl(pEPHandle, nBufferSize, nNumBuffers, nTimeOut, NULL, pCallbackFunction, pCallbackData);
+}
+
 XN_C_API XnStatus xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle)
 {
 	XN_VALIDATE_USB_INIT();
@@ -1314,7 +1701,17 @@ XN_C_API XnStatus xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle)
 		return (XN_STATUS_USB_READTHREAD_NOT_INIT);
 	}
 
-	if (pThreadData->hReadThread != NULL)
+	if (pThreadData->mode == XN_USB_READ_THREAD_MODE_COMPLETION)
+	{
+		if (!xnUSBStopCompletionProcessing(pThreadData))
+		{
+			// transfers that did not return may still complete into their buffers, so they are leaked rather than freed
+			xnLogError(XN_MASK_USB, "Endpoint 0x%x: transfers did not return after being cancelled!", pEPHandle->nAddress);
+			pThreadData->bIsRunning = FALSE;
+			return (XN_STATUS_USB_READTHREAD_SHUTDOWN_FAILED);
+		}
+	}
+	else if (pThreadData->hReadThread != NULL)
 	{
 		// mark thread should be killed
 		pThreadData->bKillReadThread = TRUE;
@@ -1327,7 +1724,7 @@ XN_C_API XnStatus xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle)
 		{
 			if (pThreadData->pBuffersInfo[i].bIsQueued)
 			{
-				libusb_cancel_transfer(pThreadData->pBuffersInfo[i].transfer);
+				pThreadData->pBackend->CancelTransfer(pThreadData->pBackendData, pThreadData->pBuffersInfo[i].transfer);
 			}
 		}
 #endif
@@ -1351,6 +1748,70 @@ XN_C_API XnStatus xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnUSBSetReadThreadMode(XN_USB_EP_HANDLE pEPHandle, XnUSBReadThreadMode mode)
+{
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_EP_HANDLE(pEPHandle);
+
+	if (mode != XN_USB_READ_THREAD_MODE_ORDERED && mode != XN_USB_READ_THREAD_MODE_COMPLETION)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	if (pEPHandle->ThreadData.bIsRunning)
+	{
+		return (XN_STATUS_USB_READTHREAD_ALREADY_INIT);
+	}
+
+	pEPHandle->readThreadMode = mode;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBGetReadThreadMode(XN_USB_EP_HANDLE pEPHandle, XnUSBReadThreadMode* pMode)
+{
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_EP_HANDLE(pEPHandle);
+	XN_VALIDATE_OUTPUT_PTR(pMode);
+
+	*pMode = pEPHandle->readThreadMode;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBGetEndPointStatistics(XN_USB_EP_HANDLE pEPHandle, XnUSBEndPointStatistics* pStatistics)
+{
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_EP_HANDLE(pEPHandle);
+	XN_VALIDATE_OUTPUT_PTR(pStatistics);
+
+	XnUSBEndPointStatisticsData* pData = &pEPHandle->ThreadData.statistics;
+
+	pStatistics->nTransfers = xnMetricsRead(&pData->nTransfers);
+	pStatistics->nBytes = xnMetricsRead(&pData->nBytes);
+	pStatistics->nTimeouts = xnMetricsRead(&pData->nTimeouts);
+	pStatistics->nFailedTransfers = xnMetricsRead(&pData->nFailedTransfers);
+	pStatistics->nFailedPackets = xnMetricsRead(&pData->nFailedPackets);
+	pStatistics->nSubmitFailures = xnMetricsRead(&pData->nSubmitFailures);
+	xnMetricsReadLatency(&pData->transferLatency, &pStatistics->transferLatency);
+	xnMetricsReadLatency(&pData->dispatchLatency, &pStatistics->dispatchLatency);
+	xnMetricsReadLatency(&pData->callbackDuration, &pStatistics->callbackDuration);
+
+	return (XN_STATUS_OK);
+}
+
+XnUSBReadThreadMode xnUSBGetDefaultReadThreadMode()
+{
+	XnChar strMode[XN_USB_READ_THREAD_MODE_MAX_LENGTH];
+	if (xnOSGetEnvironmentVariable(XN_USB_READ_THREAD_MODE_ENV, strMode, sizeof(strMode)) == XN_STATUS_OK &&
+		xnOSStrCaseCmp(strMode, "completion") == 0)
+	{
+		return (XN_USB_READ_THREAD_MODE_COMPLETION);
+	}
+
+	return (XN_USB_READ_THREAD_MODE_ORDERED);
+}
+
 XN_C_API XnStatus xnUSBSetCallbackHandler(XnUInt16 nVendorID, XnUInt16 /*nProductID*/, void* pExtraParam, XnUSBEventCallbackFunctionPtr pCallbackFunction, void* pCallbackData)
 {
 	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
@@ -25,6 +25,8 @@
 // Includes
 //---------------------------------------------------------------------------
 #include <XnOS.h>
+#include <XnTrace.h>
+#include "../XnMetricsInternal.h"
 
 //---------------------------------------------------------------------------
 // Defines
@@ -35,6 +37,33 @@
 //---------------------------------------------------------------------------
 // Structures & Enums
 //---------------------------------------------------------------------------
+/* 
+* Operations through which devices and their endpoints are driven. Real devices go through libusb itself, and 
+* simulated ones through the simulator. Unless noted otherwise, operations return libusb error codes.
+*/
+typedef struct XnUSBBackend
+{
+	const XnChar* strName;
+
+	/* Releases the device. The handle itself is freed by the caller. */
+	int (*CloseDevice)(XN_USB_DEV_HANDLE pDevHandle);
+	int (*SetInterface)(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nInterface, XnUInt8 nAltSetting);
+	/* Returns the number of bytes transferred, or an error, like libusb_control_transfer. */
+	int (*ControlTransfer)(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nRequestType, XnUInt8 nRequest, XnUInt16 nValue, XnUInt16 nIndex, XnUChar* pBuffer, XnUInt16 nLength, XnUInt32 nTimeOut);
+	/* 
+	* Looks up the endpoint the handle was created for (its address, type and direction are set), and sets its 
+	* device, max packet size and backend data. Returns an XnStatus, telling why the endpoint can not be used.
+	*/
+	XnStatus (*OpenEndPoint)(XN_USB_DEV_HANDLE pDevHandle, XN_USB_EP_HANDLE pEPHandle);
+
+	/* Synchronous bulk or interrupt transfer, like libusb_bulk_transfer. */
+	int (*Transfer)(XN_USB_EP_HANDLE pEPHandle, XnUChar* pBuffer, XnUInt32 nLength, XnUInt32* pnTransferred, XnUInt32 nTimeOut);
+	int (*SubmitTransfer)(void* pEndPointData, libusb_transfer* pTransfer);
+	int (*CancelTransfer)(void* pEndPointData, libusb_transfer* pTransfer);
+	/* Frees the backend data of an endpoint. May be NULL. */
+	void (*CloseEndPoint)(void* pEndPointData);
+} XnUSBBackend;
+
 typedef struct XnUSBDeviceHandle
 {
 //	XnBool bValid;
@@ -42,8 +71,24 @@ typedef struct XnUSBDeviceHandle
 	XnUSBDeviceSpeed nDevSpeed;
 	XnUInt8 nInterface;
 	XnUInt8 nAltSetting;
+	const XnUSBBackend* pBackend;
+	void* pBackendData;
 } XnUSBDevHandle;
 
+/* Counters behind XnUSBEndPointStatistics. */
+typedef struct XnUSBEndPointStatisticsData
+{
+	volatile XnUInt64 nTransfers;
+	volatile XnUInt64 nBytes;
+	volatile XnUInt64 nTimeouts;
+	volatile XnUInt64 nFailedTransfers;
+	volatile XnUInt64 nFailedPackets;
+	volatile XnUInt64 nSubmitFailures;
+	XnLatencyMetricsData transferLatency;
+	XnLatencyMetricsData dispatchLatency;
+	XnLatencyMetricsData callbackDuration;
+} XnUSBEndPointStatisticsData;
+
 struct XnUSBReadThreadData; // Forward declaration
 
 typedef struct XnUSBBuffersInfo
@@ -59,6 +104,12 @@ typedef struct XnUSBBuffersInfo
 	XnUInt32 nBufferID;
 	/* Holds the last status received. */
 	libusb_transfer_status nLastStatus;
+	/* When the transfer was last submitted. */
+	XnUInt64 nSubmitTime;
+	/* When the transfer last returned. */
+	XnUInt64 nCompletionTime;
+	/* Packet descriptors passed to a packets callback. */
+	XnUSBPacket* aPackets;
 } XnUSBBuffersInfo;
 
 /* Information about a thread reading from an endpoint. */
@@ -76,12 +127,28 @@ typedef struct XnUSBReadThreadData
 	XnUInt32 nTimeOut;
 	/* User callback function. */
 	XnUSBReadCallbackFunctionPtr pCallbackFunction;
+	/* User callback function, when packets are passed where they were received. */
+	XnUSBReadPacketsCallbackFunctionPtr pPacketsCallbackFunction;
 	/* User callback data. */
 	void* pCallbackData;
 	/* Handle to the read thread. */
 	XN_THREAD_HANDLE hReadThread;
 	/* When TRUE, signals the thread to exit. */
 	XnBool bKillReadThread;
+	/* Name of the endpoint in traced events. */
+	XnChar strTraceName[XN_TRACE_OBJECT_NAME_LENGTH];
+	/* How transfers are processed. */
+	XnUSBReadThreadMode mode;
+	/* Backend of the endpoint, and its data. */
+	const XnUSBBackend* pBackend;
+	void* pBackendData;
+	/* Completion mode: taken when deciding whether to resubmit a transfer, and when cancelling transfers. */
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	/* Completion mode: set whenever a transfer returns and is not resubmitted. */
+	XN_EVENT_HANDLE hDrainedEvent;
+	/* Set once a transfer could not be submitted because the device is gone. Transfers are not submitted again. */
+	volatile XnBool bDeviceGone;
+	XnUSBEndPointStatisticsData statistics;
 } XnUSBReadThreadData;
 
 typedef struct XnUSBEndPointHandle
@@ -92,6 +159,24 @@ typedef struct XnUSBEndPointHandle
 	XnUSBDirectionType nDirection;
 	XnUSBReadThreadData ThreadData;
 	XnUInt32 nMaxPacketSize;
+	XnUSBReadThreadMode readThreadMode;
+	const XnUSBBackend* pBackend;
+	void* pBackendData;
 } XnUSBEPHandle;
 
+//---------------------------------------------------------------------------
+// Functions
+//---------------------------------------------------------------------------
+/* Gets the read thread mode new endpoints are opened in. */
+XnUSBReadThreadMode xnUSBGetDefaultReadThreadMode();
+
+/* Simulated devices. See XnUSBSimulator.cpp. */
+XnStatus xnUSBSimulatorInit();
+void xnUSBSimulatorShutdown();
+/* Returns TRUE if the path names a simulated device (connected or not). */
+XnBool xnUSBSimulatorIsDevicePath(const XnChar* strDevicePath);
+/* Copies the paths of up to nMaxCount connected simulated devices with the given IDs, and returns how many there are. */
+XnUInt32 xnUSBSimulatorEnumerateDevices(XnUInt16 nVendorID, XnUInt16 nProductID, XnUSBConnectionString* astrDevicePaths, XnUInt32 nMaxCount);
+XnStatus xnUSBSimulatorOpenDevice(const XnChar* strDevicePath, XN_USB_DEV_HANDLE* pDevHandlePtr);
+
 #endif //_XN_USBLINUX_X86_H_
@@ -0,0 +1,1138 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnUSB.h>
+#include <XnUSBSimulator.h>
+
+#if (XN_PLATFORM == XN_PLATFORM_ANDROID_ARM)
+#include <libusb.h>
+#else
+#include <libusb-1.0/libusb.h>
+#endif
+
+#include "XnUSBLinux.h"
+#include "../XnUSBInternal.h"
+#include <XnLog.h>
+#include <XnOSCpp.h>
+#include <XnListT.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_USB_SIMULATOR "xnUSBSimulator"
+#define XN_USB_SIMULATOR_STOP_TIMEOUT 5000
+/* The pattern is copied from a table holding several of its periods, so most of it is copied in large chunks. */
+#define XN_USB_SIMULATOR_PATTERN_TABLE_SIZE (XN_USB_SIMULATOR_PATTERN_PERIOD * 16)
+/* Most data a device without a control handler keeps from an OUT control transfer. */
+#define XN_USB_SIMULATOR_CONTROL_DATA_SIZE 512
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+struct XnUSBSimulatedDevice; // forward declaration
+
+typedef struct XnUSBSimulatedTransfer
+{
+	libusb_transfer* pTransfer;
+	/* When it was submitted, for its timeout. */
+	XnUInt64 nSubmitTime;
+	/* Extra delay of its completion, in microseconds. */
+	XnUInt32 nJitter;
+	XnBool bCancelled;
+} XnUSBSimulatedTransfer;
+
+typedef XnListT<XnUSBSimulatedTransfer> XnUSBSimulatedTransferList;
+
+typedef struct XnUSBSimulatedEndPoint
+{
+	XnUSBSimulatedEndPointConfig config;
+	/* The device the endpoint belongs to, or NULL if it was opened alone. */
+	XnUSBSimulatedDevice* pDevice;
+	/* Protects the transfers, the stream position, the random generator and the statistics. */
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	/* Set whenever a transfer is submitted or cancelled, or the endpoint is disconnected. */
+	XN_EVENT_HANDLE hWakeEvent;
+	/* Completes the transfers. */
+	XN_THREAD_HANDLE hThread;
+	volatile XnBool bStop;
+	/* Once set, transfers return without data, and new ones are refused. */
+	XnBool bDisconnected;
+	/* Queued transfers, in the order they were submitted. */
+	XnUSBSimulatedTransferList transfers;
+	/* Position in the stream of the next byte to be sent. */
+	XnUInt64 nPosition;
+	/* When the device started producing data (paced endpoints only). */
+	XnUInt64 nStartTime;
+	/* State of the generator of delays and losses. */
+	XnUInt32 nRandom;
+	XnUSBSimulatedEndPointStatistics statistics;
+} XnUSBSimulatedEndPoint;
+
+typedef XnListT<XnUSBSimulatedEndPoint*> XnUSBSimulatedEndPointList;
+
+typedef struct XnUSBSimulatedDevice
+{
+	XnUSBSimulatedDeviceConfig config;
+	XnUSBConnectionString strPath;
+	/* Cleared when the device is disconnected. */
+	volatile XnBool bConnected;
+	/* The connection holds one reference, and so does every open handle of the device, or of its endpoints. */
+	XnUInt32 nRefCount;
+	/* Open endpoints, which are disconnected with the device. */
+	XnUSBSimulatedEndPointList endPoints;
+	/* Serializes control transfers, like the default control pipe does. */
+	XN_CRITICAL_SECTION_HANDLE hControlLock;
+	/* Data of the last OUT control transfer, when there is no control handler. */
+	XnUChar aControlData[XN_USB_SIMULATOR_CONTROL_DATA_SIZE];
+	XnUInt32 nControlDataSize;
+} XnUSBSimulatedDevice;
+
+typedef XnListT<XnUSBSimulatedDevice*> XnUSBSimulatedDeviceList;
+
+//---------------------------------------------------------------------------
+// Globals
+//---------------------------------------------------------------------------
+/* Protects the connected devices, the reference counts, and the endpoint lists of the devices. */
+static XN_CRITICAL_SECTION_HANDLE g_hSimulatorLock = NULL;
+static XnUSBSimulatedDeviceList g_simulatedDevices;
+static XnUInt32 g_nNextSimulatedDeviceID = 1;
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static const XnUInt8* xnUSBSimulatorGetPatternTable()
+{
+	// filling is idempotent, so racing threads would just write the same values
+	static XnUInt8 aTable[XN_USB_SIMULATOR_PATTERN_TABLE_SIZE];
+	static volatile XnBool bFilled = FALSE;
+	if (!bFilled)
+	{
+		for (XnUInt32 i = 0; i < XN_USB_SIMULATOR_PATTERN_TABLE_SIZE; ++i)
+		{
+			aTable[i] = (XnUInt8)(i % XN_USB_SIMULATOR_PATTERN_PERIOD);
+		}
+		bFilled = TRUE;
+	}
+
+	return aTable;
+}
+
+/* A xorshift generator. Called with the lock taken. */
+static XnUInt32 xnUSBSimulatorRandom(XnUSBSimulatedEndPoint* pEndPoint)
+{
+	XnUInt32 x = pEndPoint->nRandom;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pEndPoint->nRandom = x;
+	return x;
+}
+
+/* Decides whether the next packet is lost. Called with the lock taken. */
+static XnBool xnUSBSimulatorIsPacketLost(XnUSBSimulatedEndPoint* pEndPoint)
+{
+	return (pEndPoint->config.nLossPerMillion != 0 && xnUSBSimulatorRandom(pEndPoint) % 1000000 < pEndPoint->config.nLossPerMillion);
+}
+
+static XnBool xnUSBSimulatorIsIn(XnUSBSimulatedEndPoint* pEndPoint)
+{
+	return ((pEndPoint->config.nEndPointID & LIBUSB_ENDPOINT_IN) != 0);
+}
+
+/* Writes the next bytes of the stream. */
+static void xnUSBSimulatorWritePattern(XnUSBSimulatedEndPoint* pEndPoint, XnUChar* pBuffer, XnUInt32 nBytes)
+{
+	const XnUInt8* pTable = xnUSBSimulatorGetPatternTable();
+
+	while (nBytes > 0)
+	{
+		XnUInt32 nOffset = (XnUInt32)(pEndPoint->nPosition % XN_USB_SIMULATOR_PATTERN_PERIOD);
+		XnUInt32 nChunk = XN_MIN(nBytes, XN_USB_SIMULATOR_PATTERN_TABLE_SIZE - nOffset);
+		xnOSMemCopy(pBuffer, pTable + nOffset, nChunk);
+		pBuffer += nChunk;
+		nBytes -= nChunk;
+		pEndPoint->nPosition += nChunk;
+	}
+}
+
+/* Sends the next bytes of the stream, unless they are lost on the way. Returns FALSE if they were. */
+static XnBool xnUSBSimulatorSendPacket(XnUSBSimulatedEndPoint* pEndPoint, XnUChar* pBuffer, XnUInt32 nBytes)
+{
+	if (nBytes != 0 && xnUSBSimulatorIsPacketLost(pEndPoint))
+	{
+		pEndPoint->nPosition += nBytes;
+		++pEndPoint->statistics.nPacketsLost;
+		pEndPoint->statistics.nBytesLost += nBytes;
+		return (FALSE);
+	}
+
+	xnUSBSimulatorWritePattern(pEndPoint, pBuffer, nBytes);
+	pEndPoint->statistics.nBytesTransferred += nBytes;
+	return (TRUE);
+}
+
+/* Number of bytes the device puts in a transfer when it has enough data. */
+static XnUInt32 xnUSBSimulatorGetRequestedBytes(XnUSBSimulatedEndPoint* pEndPoint, libusb_transfer* pTransfer)
+{
+	XnUInt32 nPerPacket = pEndPoint->config.nBytesPerPacket;
+
+	if (pTransfer->type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
+	{
+		XnUInt32 nBytes = 0;
+		for (XnInt32 i = 0; i < pTransfer->num_iso_packets; ++i)
+		{
+			XnUInt32 nLength = pTransfer->iso_packet_desc[i].length;
+			nBytes += (nPerPacket == 0) ? nLength : XN_MIN(nLength, nPerPacket);
+		}
+		return nBytes;
+	}
+	else
+	{
+		XnUInt32 nLength = pTransfer->length;
+		return (nPerPacket == 0) ? nLength : XN_MIN(nLength, nPerPacket);
+	}
+}
+
+/* Puts the next nBytes of the stream in a transfer of an IN endpoint, and sets its status. */
+static void xnUSBSimulatorFillTransfer(XnUSBSimulatedEndPoint* pEndPoint, libusb_transfer* pTransfer, XnUInt32 nBytes, libusb_transfer_status status)
+{
+	XnUInt32 nPerPacket = pEndPoint->config.nBytesPerPacket;
+
+	if (pTransfer->type == LIBUSB_TRANSFER_TYPE_ISOCHRONOUS)
+	{
+		XnUChar* pPacketBuffer = pTransfer->buffer;
+		pTransfer->actual_length = 0;
+
+		for (XnInt32 i = 0; i < pTransfer->num_iso_packets; ++i)
+		{
+			libusb_iso_packet_descriptor* pPacket = &pTransfer->iso_packet_desc[i];
+			XnUInt32 nPacketBytes = (nPerPacket == 0) ? pPacket->length : XN_MIN(pPacket->length, nPerPacket);
+			nPacketBytes = XN_MIN(nPacketBytes, nBytes);
+			nBytes -= nPacketBytes;
+
+			if (xnUSBSimulatorSendPacket(pEndPoint, pPacketBuffer, nPacketBytes))
+			{
+				pPacket->actual_length = nPacketBytes;
+				pPacket->status = LIBUSB_TRANSFER_COMPLETED;
+			}
+			else
+			{
+				pPacket->actual_length = 0;
+				pPacket->status = LIBUSB_TRANSFER_ERROR;
+			}
+
+			pPacketBuffer += pPacket->length;
+			pTransfer->actual_length += pPacket->actual_length;
+		}
+	}
+	else if (!xnUSBSimulatorSendPacket(pEndPoint, pTransfer->buffer, nBytes))
+	{
+		pTransfer->actual_length = 0;
+		status = LIBUSB_TRANSFER_ERROR;
+	}
+	else
+	{
+		pTransfer->actual_length = nBytes;
+	}
+
+	pTransfer->status = status;
+}
+
+/* Takes all the data of a transfer of an OUT endpoint. */
+static void xnUSBSimulatorConsumeTransfer(XnUSBSimulatedEndPoint* pEndPoint, libusb_transfer* pTransfer)
+{
+	pTransfer->actual_length = pTransfer->length;
+
+	for (XnInt32 i = 0; i < pTransfer->num_iso_packets; ++i)
+	{
+		pTransfer->iso_packet_desc[i].actual_length = pTransfer->iso_packet_desc[i].length;
+		pTransfer->iso_packet_desc[i].status = LIBUSB_TRANSFER_COMPLETED;
+	}
+
+	pEndPoint->statistics.nBytesTransferred += pTransfer->length;
+	pTransfer->status = LIBUSB_TRANSFER_COMPLETED;
+}
+
+/* Number of bytes the device produced since it started (paced endpoints only). */
+static XnUInt64 xnUSBSimulatorGetProducedBytes(XnUSBSimulatedEndPoint* pEndPoint, XnUInt64 nNow)
+{
+	return (nNow - pEndPoint->nStartTime) * pEndPoint->config.nBytesPerSecond / 1000000;
+}
+
+/*
+* Takes the next transfer that can be completed out of the queue, and fills it. If none can, returns NULL, and
+* sets how long to wait before checking again. Sets pbDisconnect if the endpoint sent all it should before
+* disconnecting. Called with the lock taken.
+*/
+static libusb_transfer* xnUSBSimulatorTakeCompletedTransfer(XnUSBSimulatedEndPoint* pEndPoint, XnUInt32* pnWait, XnBool* pbDisconnect)
+{
+	*pnWait = XN_WAIT_INFINITE;
+	*pbDisconnect = FALSE;
+
+	if (pEndPoint->transfers.IsEmpty())
+	{
+		return (NULL);
+	}
+
+	if (pEndPoint->bDisconnected)
+	{
+		// everything returns, without data
+		libusb_transfer* pTransfer = pEndPoint->transfers.Begin()->pTransfer;
+		pEndPoint->transfers.Remove(pEndPoint->transfers.Begin());
+		xnUSBSimulatorFillTransfer(pEndPoint, pTransfer, 0, LIBUSB_TRANSFER_NO_DEVICE);
+		return (pTransfer);
+	}
+
+	// a cancelled transfer that is not first in the queue returns without data
+	XnUSBSimulatedTransferList::Iterator it = pEndPoint->transfers.Begin();
+	for (++it; it != pEndPoint->transfers.End(); ++it)
+	{
+		if (it->bCancelled)
+		{
+			libusb_transfer* pTransfer = it->pTransfer;
+			pEndPoint->transfers.Remove(it);
+			xnUSBSimulatorFillTransfer(pEndPoint, pTransfer, 0, LIBUSB_TRANSFER_CANCELLED);
+			return (pTransfer);
+		}
+	}
+
+	XnUSBSimulatedTransfer& head = *pEndPoint->transfers.Begin();
+	XnBool bIn = xnUSBSimulatorIsIn(pEndPoint);
+	XnUInt32 nRequested = bIn ? xnUSBSimulatorGetRequestedBytes(pEndPoint, head.pTransfer) : 0;
+	XnUInt64 nDisconnectAfter = pEndPoint->config.nDisconnectAfterBytes;
+
+	if (bIn && nDisconnectAfter != 0)
+	{
+		// the device sends no more than it should before disconnecting
+		nRequested = (XnUInt32)XN_MIN((XnUInt64)nRequested, nDisconnectAfter - pEndPoint->nPosition);
+	}
+
+	XnUInt64 nNow;
+	xnOSGetHighResTimeStamp(&nNow);
+
+	// when the transfer may complete
+	XnUInt64 nReady = head.nSubmitTime;
+	XnUInt32 nAvailable = nRequested;
+
+	if (bIn && pEndPoint->config.nBytesPerSecond != 0)
+	{
+		XnUInt64 nProduced = xnUSBSimulatorGetProducedBytes(pEndPoint, nNow);
+		nAvailable = (XnUInt32)XN_MIN((XnUInt64)nRequested, nProduced > pEndPoint->nPosition ? nProduced - pEndPoint->nPosition : 0);
+
+		// rounded up, so that all the data was produced by then
+		XnUInt64 nDataReady = pEndPoint->nStartTime + ((pEndPoint->nPosition + nRequested) * 1000000 + pEndPoint->config.nBytesPerSecond - 1) / pEndPoint->config.nBytesPerSecond;
+		nReady = XN_MAX(nReady, nDataReady);
+	}
+
+	nReady += head.nJitter;
+
+	libusb_transfer_status status = LIBUSB_TRANSFER_COMPLETED;
+
+	if (nNow < nReady)
+	{
+		XnUInt64 nDeadline = (head.pTransfer->timeout != 0) ? head.nSubmitTime + (XnUInt64)head.pTransfer->timeout * 1000 : 0;
+
+		if (head.bCancelled)
+		{
+			status = LIBUSB_TRANSFER_CANCELLED;
+		}
+		else if (nDeadline != 0 && nNow >= nDeadline)
+		{
+			status = LIBUSB_TRANSFER_TIMED_OUT;
+		}
+		else
+		{
+			// wait until the transfer is ready, or times out
+			if (nDeadline != 0 && nDeadline < nReady)
+			{
+				nReady = nDeadline;
+			}
+			*pnWait = (XnUInt32)((nReady - nNow + 999) / 1000);
+			return (NULL);
+		}
+	}
+	else
+	{
+		nAvailable = nRequested;
+	}
+
+	libusb_transfer* pTransfer = head.pTransfer;
+	pEndPoint->transfers.Remove(pEndPoint->transfers.Begin());
+
+	if (bIn)
+	{
+		xnUSBSimulatorFillTransfer(pEndPoint, pTransfer, nAvailable, status);
+		*pbDisconnect = (nDisconnectAfter != 0 && pEndPoint->nPosition >= nDisconnectAfter);
+	}
+	else if (status == LIBUSB_TRANSFER_COMPLETED)
+	{
+		xnUSBSimulatorConsumeTransfer(pEndPoint, pTransfer);
+	}
+	else
+	{
+		// nothing was taken yet
+		pTransfer->actual_length = 0;
+		pTransfer->status = status;
+	}
+
+	return (pTransfer);
+}
+
+/* Disconnects an endpoint. Called with the simulator lock taken, if the endpoint belongs to a device. */
+static void xnUSBSimulatorDisconnectEndPoint(XnUSBSimulatedEndPoint* pEndPoint)
+{
+	XnAutoCSLocker locker(pEndPoint->hLock);
+	pEndPoint->bDisconnected = TRUE;
+	xnOSSetEvent(pEndPoint->hWakeEvent);
+}
+
+static void xnUSBSimulatorReleaseDevice(XnUSBSimulatedDevice* pDevice)
+{
+	{
+		XnAutoCSLocker locker(g_hSimulatorLock);
+		if (--pDevice->nRefCount != 0)
+		{
+			return;
+		}
+	}
+
+	if (pDevice->hControlLock != NULL)
+	{
+		xnOSCloseCriticalSection(&pDevice->hControlLock);
+	}
+
+	XN_DELETE_ARR(pDevice->config.aEndPoints);
+	XN_DELETE(pDevice);
+}
+
+/* Disconnects a device, and all of its endpoints. Does nothing if it was already disconnected. */
+static void xnUSBSimulatorDisconnect(XnUSBSimulatedDevice* pDevice)
+{
+	{
+		XnAutoCSLocker locker(g_hSimulatorLock);
+
+		if (!pDevice->bConnected)
+		{
+			return;
+		}
+
+		pDevice->bConnected = FALSE;
+		g_simulatedDevices.Remove(pDevice);
+
+		for (XnUSBSimulatedEndPointList::Iterator it = pDevice->endPoints.Begin(); it != pDevice->endPoints.End(); ++it)
+		{
+			xnUSBSimulatorDisconnectEndPoint(*it);
+		}
+	}
+
+	xnLogInfo(XN_MASK_USB_SIMULATOR, "Simulated device %s was disconnected", pDevice->strPath);
+
+	// the reference of the connection
+	xnUSBSimulatorReleaseDevice(pDevice);
+}
+
+static XN_THREAD_PROC xnUSBSimulatorThread(XN_THREAD_PARAM pThreadParam)
+{
+	XnUSBSimulatedEndPoint* pEndPoint = (XnUSBSimulatedEndPoint*)pThreadParam;
+
+	while (!pEndPoint->bStop)
+	{
+		libusb_transfer* pTransfer = NULL;
+		XnUInt32 nWait = XN_WAIT_INFINITE;
+		XnBool bDisconnect = FALSE;
+
+		{
+			XnAutoCSLocker locker(pEndPoint->hLock);
+			pTransfer = xnUSBSimulatorTakeCompletedTransfer(pEndPoint, &nWait, &bDisconnect);
+		}
+
+		if (pTransfer != NULL)
+		{
+			// the lock is not held, so the callback may resubmit the transfer
+			pTransfer->callback(pTransfer);
+
+			if (bDisconnect)
+			{
+				if (pEndPoint->pDevice != NULL)
+				{
+					xnUSBSimulatorDisconnect(pEndPoint->pDevice);
+				}
+				else
+				{
+					xnUSBSimulatorDisconnectEndPoint(pEndPoint);
+				}
+			}
+		}
+		else
+		{
+			xnOSWaitEvent(pEndPoint->hWakeEvent, nWait);
+		}
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+static int xnUSBSimulatorSubmitTransfer(void* pEndPointData, libusb_transfer* pTransfer)
+{
+	XnUSBSimulatedEndPoint* pEndPoint = (XnUSBSimulatedEndPoint*)pEndPointData;
+
+	XnUSBSimulatedTransfer transfer;
+	transfer.pTransfer = pTransfer;
+	transfer.bCancelled = FALSE;
+	xnOSGetHighResTimeStamp(&transfer.nSubmitTime);
+
+	XnAutoCSLocker locker(pEndPoint->hLock);
+
+	if (pEndPoint->bStop || pEndPoint->bDisconnected)
+	{
+		return (LIBUSB_ERROR_NO_DEVICE);
+	}
+
+	transfer.nJitter = (pEndPoint->config.nJitter == 0) ? 0 : xnUSBSimulatorRandom(pEndPoint) % (pEndPoint->config.nJitter + 1);
+
+	if (xnUSBSimulatorIsIn(pEndPoint) && pEndPoint->config.nBytesPerSecond != 0 && pEndPoint->transfers.IsEmpty())
+	{
+		if (pEndPoint->nStartTime == 0)
+		{
+			pEndPoint->nStartTime = transfer.nSubmitTime;
+		}
+		else
+		{
+			// data produced while nothing was queued is lost (but no more than the device sends before disconnecting)
+			XnUInt64 nProduced = xnUSBSimulatorGetProducedBytes(pEndPoint, transfer.nSubmitTime);
+			if (pEndPoint->config.nDisconnectAfterBytes != 0)
+			{
+				nProduced = XN_MIN(nProduced, pEndPoint->config.nDisconnectAfterBytes);
+			}
+
+			if (nProduced > pEndPoint->nPosition)
+			{
+				pEndPoint->statistics.nBytesOverrun += nProduced - pEndPoint->nPosition;
+				pEndPoint->nPosition = nProduced;
+			}
+		}
+	}
+
+	if (pEndPoint->transfers.AddLast(transfer) != XN_STATUS_OK)
+	{
+		return (LIBUSB_ERROR_NO_MEM);
+	}
+
+	xnOSSetEvent(pEndPoint->hWakeEvent);
+
+	return (0);
+}
+
+static int xnUSBSimulatorCancelTransfer(void* pEndPointData, libusb_transfer* pTransfer)
+{
+	XnUSBSimulatedEndPoint* pEndPoint = (XnUSBSimulatedEndPoint*)pEndPointData;
+
+	XnAutoCSLocker locker(pEndPoint->hLock);
+
+	for (XnUSBSimulatedTransferList::Iterator it = pEndPoint->transfers.Begin(); it != pEndPoint->transfers.End(); ++it)
+	{
+		if (it->pTransfer == pTransfer && !it->bCancelled)
+		{
+			it->bCancelled = TRUE;
+			xnOSSetEvent(pEndPoint->hWakeEvent);
+			return (0);
+		}
+	}
+
+	// already completed (or being completed)
+	return (LIBUSB_ERROR_NOT_FOUND);
+}
+
+static void XN_CALLBACK_TYPE xnUSBSimulatorSyncTransferCallback(libusb_transfer* pTransfer)
+{
+	xnOSSetEvent((XN_EVENT_HANDLE)pTransfer->user_data);
+}
+
+static int xnUSBSimulatorTransfer(XN_USB_EP_HANDLE pEPHandle, XnUChar* pBuffer, XnUInt32 nLength, XnUInt32* pnTransferred, XnUInt32 nTimeOut)
+{
+	*pnTransferred = 0;
+
+	XN_EVENT_HANDLE hDoneEvent = NULL;
+	if (xnOSCreateEvent(&hDoneEvent, FALSE) != XN_STATUS_OK)
+	{
+		return (LIBUSB_ERROR_NO_MEM);
+	}
+
+	libusb_transfer* pTransfer = libusb_alloc_transfer(0);
+	if (pTransfer == NULL)
+	{
+		xnOSCloseEvent(&hDoneEvent);
+		return (LIBUSB_ERROR_NO_MEM);
+	}
+
+	// the transfer is completed by the simulator thread, which also times it out
+	if (pEPHandle->nType == XN_USB_EP_BULK)
+	{
+		libusb_fill_bulk_transfer(pTransfer, NULL, pEPHandle->nAddress, pBuffer, nLength, xnUSBSimulatorSyncTransferCallback, hDoneEvent, nTimeOut);
+	}
+	else
+	{
+		libusb_fill_interrupt_transfer(pTransfer, NULL, pEPHandle->nAddress, pBuffer, nLength, xnUSBSimulatorSyncTransferCallback, hDoneEvent, nTimeOut);
+	}
+
+	int rc = xnUSBSimulatorSubmitTransfer(pEPHandle->pBackendData, pTransfer);
+	if (rc == 0)
+	{
+		xnOSWaitEvent(hDoneEvent, XN_WAIT_INFINITE);
+		*pnTransferred = pTransfer->actual_length;
+
+		switch (pTransfer->status)
+		{
+		case LIBUSB_TRANSFER_COMPLETED:
+			rc = 0;
+			break;
+		case LIBUSB_TRANSFER_TIMED_OUT:
+			rc = LIBUSB_ERROR_TIMEOUT;
+			break;
+		case LIBUSB_TRANSFER_NO_DEVICE:
+			rc = LIBUSB_ERROR_NO_DEVICE;
+			break;
+		default:
+			rc = LIBUSB_ERROR_IO;
+			break;
+		}
+	}
+
+	libusb_free_transfer(pTransfer);
+	xnOSCloseEvent(&hDoneEvent);
+
+	return (rc);
+}
+
+static void xnUSBSimulatorCloseEndPoint(void* pEndPointData)
+{
+	XnUSBSimulatedEndPoint* pEndPoint = (XnUSBSimulatedEndPoint*)pEndPointData;
+
+	if (pEndPoint->hThread != NULL)
+	{
+		pEndPoint->bStop = TRUE;
+		xnOSSetEvent(pEndPoint->hWakeEvent);
+		xnOSWaitAndTerminateThread(&pEndPoint->hThread, XN_USB_SIMULATOR_STOP_TIMEOUT);
+	}
+
+	if (!pEndPoint->transfers.IsEmpty())
+	{
+		xnLogWarning(XN_MASK_USB_SIMULATOR, "Endpoint 0x%x was closed with %u transfers queued", pEndPoint->config.nEndPointID, pEndPoint->transfers.Size());
+	}
+
+	if (pEndPoint->pDevice != NULL)
+	{
+		{
+			XnAutoCSLocker locker(g_hSimulatorLock);
+			pEndPoint->pDevice->endPoints.Remove(pEndPoint);
+		}
+
+		xnUSBSimulatorReleaseDevice(pEndPoint->pDevice);
+	}
+
+	if (pEndPoint->hWakeEvent != NULL)
+	{
+		xnOSCloseEvent(&pEndPoint->hWakeEvent);
+	}
+
+	if (pEndPoint->hLock != NULL)
+	{
+		xnOSCloseCriticalSection(&pEndPoint->hLock);
+	}
+
+	XN_DELETE(pEndPoint);
+}
+
+static int xnUSBSimulatorCloseDevice(XN_USB_DEV_HANDLE pDevHandle)
+{
+	xnUSBSimulatorReleaseDevice((XnUSBSimulatedDevice*)pDevHandle->pBackendData);
+	return (0);
+}
+
+static int xnUSBSimulatorSetInterface(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nInterface, XnUInt8 /*nAltSetting*/)
+{
+	XnUSBSimulatedDevice* pDevice = (XnUSBSimulatedDevice*)pDevHandle->pBackendData;
+
+	if (!pDevice->bConnected)
+	{
+		return (LIBUSB_ERROR_NO_DEVICE);
+	}
+
+	// all alternate settings of the only interface are the same
+	return (nInterface == 0) ? 0 : LIBUSB_ERROR_NOT_FOUND;
+}
+
+static int xnUSBSimulatorControlTransfer(XN_USB_DEV_HANDLE pDevHandle, XnUInt8 nRequestType, XnUInt8 nRequest, XnUInt16 nValue, XnUInt16 nIndex, XnUChar* pBuffer, XnUInt16 nLength, XnUInt32 /*nTimeOut*/)
+{
+	XnUSBSimulatedDevice* pDevice = (XnUSBSimulatedDevice*)pDevHandle->pBackendData;
+
+	XnUSBControlType nType = XN_USB_CONTROL_TYPE_STANDARD;
+	if ((nRequestType & 0x60) == LIBUSB_REQUEST_TYPE_VENDOR)
+	{
+		nType = XN_USB_CONTROL_TYPE_VENDOR;
+	}
+	else if ((nRequestType & 0x60) == LIBUSB_REQUEST_TYPE_CLASS)
+	{
+		nType = XN_USB_CONTROL_TYPE_CLASS;
+	}
+
+	XnUSBDirectionType nDirection = ((nRequestType & LIBUSB_ENDPOINT_IN) != 0) ? XN_USB_DIRECTION_IN : XN_USB_DIRECTION_OUT;
+
+	XnAutoCSLocker locker(pDevice->hControlLock);
+
+	if (!pDevice->bConnected)
+	{
+		return (LIBUSB_ERROR_NO_DEVICE);
+	}
+
+	if (pDevice->config.pControlHandler != NULL)
+	{
+		XnUInt32 nBytes = 0;
+		XnStatus nRetVal = pDevice->config.pControlHandler(nType, nDirection, nRequest, nValue, nIndex, pBuffer, nLength, &nBytes, pDevice->config.pControlCookie);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			return (LIBUSB_ERROR_PIPE);
+		}
+
+		return (nDirection == XN_USB_DIRECTION_IN) ? (int)XN_MIN(nBytes, (XnUInt32)nLength) : nLength;
+	}
+
+	// without a handler, the device answers with what it was last sent
+	if (nDirection == XN_USB_DIRECTION_OUT)
+	{
+		pDevice->nControlDataSize = XN_MIN((XnUInt32)nLength, (XnUInt32)XN_USB_SIMULATOR_CONTROL_DATA_SIZE);
+		xnOSMemCopy(pDevice->aControlData, pBuffer, pDevice->nControlDataSize);
+		return (nLength);
+	}
+	else
+	{
+		XnUInt32 nBytes = XN_MIN((XnUInt32)nLength, pDevice->nControlDataSize);
+		xnOSMemCopy(pBuffer, pDevice->aControlData, nBytes);
+		return (nBytes);
+	}
+}
+
+static XnStatus xnUSBSimulatorOpenDeviceEndPoint(XN_USB_DEV_HANDLE pDevHandle, XN_USB_EP_HANDLE pEPHandle);
+
+static const XnUSBBackend g_simulatorBackend =
+{
+	"simulator",
+	xnUSBSimulatorCloseDevice,
+	xnUSBSimulatorSetInterface,
+	xnUSBSimulatorControlTransfer,
+	xnUSBSimulatorOpenDeviceEndPoint,
+	xnUSBSimulatorTransfer,
+	xnUSBSimulatorSubmitTransfer,
+	xnUSBSimulatorCancelTransfer,
+	xnUSBSimulatorCloseEndPoint,
+};
+
+static XnStatus xnUSBSimulatorStart(XnUSBSimulatedEndPoint* pEndPoint)
+{
+	XnStatus nRetVal = xnOSCreateCriticalSection(&pEndPoint->hLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&pEndPoint->hWakeEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateThread(xnUSBSimulatorThread, pEndPoint, &pEndPoint->hThread);
+	XN_IS_STATUS_OK(nRetVal);
+
+	// the simulator thread plays the part of the USB events thread
+	XnChar strThreadName[XN_THREAD_ROLE_MAX_LENGTH];
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(strThreadName, sizeof(strThreadName), &nCharsWritten, "XnUSBSim EP 0x%02x", pEndPoint->config.nEndPointID);
+	xnOSApplyThreadPolicy(pEndPoint->hThread, XN_THREAD_ROLE_USB_EVENTS, strThreadName);
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnUSBSimulatorValidateEndPointConfig(const XnUSBSimulatedEndPointConfig* pConfig)
+{
+	if (pConfig->nType != XN_USB_EP_BULK && pConfig->nType != XN_USB_EP_ISOCHRONOUS && pConfig->nType != XN_USB_EP_INTERRUPT)
+	{
+		return (XN_STATUS_USB_UNKNOWN_ENDPOINT_TYPE);
+	}
+
+	if (pConfig->nMaxPacketSize == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+/* Creates an endpoint, and starts its thread. */
+static XnStatus xnUSBSimulatorCreateEndPoint(const XnUSBSimulatedEndPointConfig* pConfig, XnUSBSimulatedDevice* pDevice, XnUSBSimulatedEndPoint** ppEndPoint)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUSBSimulatedEndPoint* pEndPoint;
+	XN_VALIDATE_NEW(pEndPoint, XnUSBSimulatedEndPoint);
+	pEndPoint->config = *pConfig;
+	pEndPoint->pDevice = NULL;
+	pEndPoint->hLock = NULL;
+	pEndPoint->hWakeEvent = NULL;
+	pEndPoint->hThread = NULL;
+	pEndPoint->bStop = FALSE;
+	pEndPoint->bDisconnected = FALSE;
+	pEndPoint->nPosition = 0;
+	pEndPoint->nStartTime = 0;
+	pEndPoint->nRandom = (pConfig->nSeed != 0) ? pConfig->nSeed : 0x9E3779B9 + pConfig->nEndPointID;
+	xnOSMemSet(&pEndPoint->statistics, 0, sizeof(pEndPoint->statistics));
+
+	nRetVal = xnUSBSimulatorStart(pEndPoint);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnUSBSimulatorCloseEndPoint(pEndPoint);
+		return (nRetVal);
+	}
+
+	if (pDevice != NULL)
+	{
+		XnAutoCSLocker locker(g_hSimulatorLock);
+
+		if (!pDevice->bConnected)
+		{
+			nRetVal = XN_STATUS_USB_DEVICE_NOT_FOUND;
+		}
+		else
+		{
+			nRetVal = pDevice->endPoints.AddLast(pEndPoint);
+		}
+
+		if (nRetVal == XN_STATUS_OK)
+		{
+			pEndPoint->pDevice = pDevice;
+			++pDevice->nRefCount;
+		}
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnUSBSimulatorCloseEndPoint(pEndPoint);
+		return (nRetVal);
+	}
+
+	*ppEndPoint = pEndPoint;
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnUSBSimulatorOpenDeviceEndPoint(XN_USB_DEV_HANDLE pDevHandle, XN_USB_EP_HANDLE pEPHandle)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUSBSimulatedDevice* pDevice = (XnUSBSimulatedDevice*)pDevHandle->pBackendData;
+
+	const XnUSBSimulatedEndPointConfig* pConfig = NULL;
+	for (XnUInt32 i = 0; i < pDevice->config.nEndPoints; ++i)
+	{
+		if (pDevice->config.aEndPoints[i].nEndPointID == pEPHandle->nAddress)
+		{
+			pConfig = &pDevice->config.aEndPoints[i];
+			break;
+		}
+	}
+
+	if (pConfig == NULL)
+	{
+		return (XN_STATUS_USB_ENDPOINT_NOT_FOUND);
+	}
+
+	if (pConfig->nType != pEPHandle->nType)
+	{
+		return (XN_STATUS_USB_WRONG_ENDPOINT_TYPE);
+	}
+
+	XnUSBSimulatedEndPoint* pEndPoint = NULL;
+	nRetVal = xnUSBSimulatorCreateEndPoint(pConfig, pDevice, &pEndPoint);
+	XN_IS_STATUS_OK(nRetVal);
+
+	pEPHandle->hDevice = NULL;
+	pEPHandle->nMaxPacketSize = pConfig->nMaxPacketSize;
+	pEPHandle->pBackendData = pEndPoint;
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus xnUSBSimulatorInit()
+{
+	if (g_hSimulatorLock == NULL)
+	{
+		XnStatus nRetVal = xnOSCreateCriticalSection(&g_hSimulatorLock);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+void xnUSBSimulatorShutdown()
+{
+	if (g_hSimulatorLock == NULL)
+	{
+		return;
+	}
+
+	// devices that are still connected are disconnected. Open handles must be closed before shutting down.
+	while (!g_simulatedDevices.IsEmpty())
+	{
+		xnUSBSimulatorDisconnect(*g_simulatedDevices.Begin());
+	}
+
+	xnOSCloseCriticalSection(&g_hSimulatorLock);
+	g_hSimulatorLock = NULL;
+}
+
+XnBool xnUSBSimulatorIsDevicePath(const XnChar* strDevicePath)
+{
+	return (strncmp(strDevicePath, XN_USB_SIMULATOR_PATH_PREFIX, sizeof(XN_USB_SIMULATOR_PATH_PREFIX) - 1) == 0);
+}
+
+XnUInt32 xnUSBSimulatorEnumerateDevices(XnUInt16 nVendorID, XnUInt16 nProductID, XnUSBConnectionString* astrDevicePaths, XnUInt32 nMaxCount)
+{
+	XnAutoCSLocker locker(g_hSimulatorLock);
+
+	XnUInt32 nCount = 0;
+
+	for (XnUSBSimulatedDeviceList::ConstIterator it = g_simulatedDevices.Begin(); it != g_simulatedDevices.End(); ++it)
+	{
+		const XnUSBSimulatedDevice* pDevice = *it;
+		if (pDevice->config.nVendorID == nVendorID && pDevice->config.nProductID == nProductID)
+		{
+			if (nCount < nMaxCount)
+			{
+				xnOSStrCopy(astrDevicePaths[nCount], pDevice->strPath, sizeof(XnUSBConnectionString));
+			}
+			++nCount;
+		}
+	}
+
+	return (nCount);
+}
+
+XnStatus xnUSBSimulatorOpenDevice(const XnChar* strDevicePath, XN_USB_DEV_HANDLE* pDevHandlePtr)
+{
+	XnUSBSimulatedDevice* pDevice = NULL;
+
+	{
+		XnAutoCSLocker locker(g_hSimulatorLock);
+
+		for (XnUSBSimulatedDeviceList::Iterator it = g_simulatedDevices.Begin(); it != g_simulatedDevices.End(); ++it)
+		{
+			if (xnOSStrCmp((*it)->strPath, strDevicePath) == 0)
+			{
+				pDevice = *it;
+				++pDevice->nRefCount;
+				break;
+			}
+		}
+	}
+
+	if (pDevice == NULL)
+	{
+		return (XN_STATUS_USB_DEVICE_NOT_FOUND);
+	}
+
+	XN_USB_DEV_HANDLE pDevHandle = (XN_USB_DEV_HANDLE)xnOSCalloc(1, sizeof(XnUSBDeviceHandle));
+	if (pDevHandle == NULL)
+	{
+		xnUSBSimulatorReleaseDevice(pDevice);
+		return (XN_STATUS_ALLOC_FAILED);
+	}
+
+	pDevHandle->hDevice = NULL;
+	pDevHandle->nDevSpeed = pDevice->config.nSpeed;
+	pDevHandle->nInterface = 0;
+	pDevHandle->nAltSetting = 0;
+	pDevHandle->pBackend = &g_simulatorBackend;
+	pDevHandle->pBackendData = pDevice;
+
+	*pDevHandlePtr = pDevHandle;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBSimulatorOpenEndPoint(const XnUSBSimulatedEndPointConfig* pConfig, XN_USB_EP_HANDLE* pEPHandlePtr)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_INPUT_PTR(pConfig);
+	XN_VALIDATE_OUTPUT_PTR(pEPHandlePtr);
+
+	if ((pConfig->nEndPointID & LIBUSB_ENDPOINT_IN) == 0)
+	{
+		return (XN_STATUS_USB_WRONG_ENDPOINT_DIRECTION);
+	}
+
+	nRetVal = xnUSBSimulatorValidateEndPointConfig(pConfig);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUSBSimulatedEndPoint* pEndPoint = NULL;
+	nRetVal = xnUSBSimulatorCreateEndPoint(pConfig, NULL, &pEndPoint);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XN_USB_EP_HANDLE pHandle = (XN_USB_EP_HANDLE)xnOSCallocAligned(1, sizeof(XnUSBEPHandle), XN_DEFAULT_MEM_ALIGN);
+	if (pHandle == NULL)
+	{
+		xnUSBSimulatorCloseEndPoint(pEndPoint);
+		return (XN_STATUS_ALLOC_FAILED);
+	}
+
+	pHandle->hDevice = NULL;
+	pHandle->nAddress = (unsigned char)pConfig->nEndPointID;
+	pHandle->nType = pConfig->nType;
+	pHandle->nDirection = XN_USB_DIRECTION_IN;
+	pHandle->nMaxPacketSize = pConfig->nMaxPacketSize;
+	pHandle->readThreadMode = xnUSBGetDefaultReadThreadMode();
+	pHandle->pBackend = &g_simulatorBackend;
+	pHandle->pBackendData = pEndPoint;
+
+	*pEPHandlePtr = pHandle;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBSimulatorConnectDevice(const XnUSBSimulatedDeviceConfig* pConfig, XnUSBConnectionString strDevicePath)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_INPUT_PTR(pConfig);
+	XN_VALIDATE_OUTPUT_PTR(strDevicePath);
+
+	if (pConfig->nEndPoints != 0)
+	{
+		XN_VALIDATE_INPUT_PTR(pConfig->aEndPoints);
+	}
+
+	for (XnUInt32 i = 0; i < pConfig->nEndPoints; ++i)
+	{
+		nRetVal = xnUSBSimulatorValidateEndPointConfig(&pConfig->aEndPoints[i]);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	XnUSBSimulatedDevice* pDevice;
+	XN_VALIDATE_NEW(pDevice, XnUSBSimulatedDevice);
+	pDevice->config = *pConfig;
+	pDevice->config.aEndPoints = NULL;
+	pDevice->bConnected = TRUE;
+	pDevice->nRefCount = 1;
+	pDevice->hControlLock = NULL;
+	pDevice->nControlDataSize = 0;
+
+	XnUSBSimulatedEndPointConfig* aEndPoints = XN_NEW_ARR(XnUSBSimulatedEndPointConfig, XN_MAX(pConfig->nEndPoints, 1));
+	if (aEndPoints == NULL)
+	{
+		xnUSBSimulatorReleaseDevice(pDevice);
+		return (XN_STATUS_ALLOC_FAILED);
+	}
+	pDevice->config.aEndPoints = aEndPoints;
+
+	for (XnUInt32 i = 0; i < pConfig->nEndPoints; ++i)
+	{
+		aEndPoints[i] = pConfig->aEndPoints[i];
+	}
+
+	nRetVal = xnOSCreateCriticalSection(&pDevice->hControlLock);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnUSBSimulatorReleaseDevice(pDevice);
+		return (nRetVal);
+	}
+
+	{
+		XnAutoCSLocker locker(g_hSimulatorLock);
+
+		XnUInt32 nCharsWritten = 0;
+		xnOSStrFormat(pDevice->strPath, sizeof(pDevice->strPath), &nCharsWritten, XN_USB_SIMULATOR_PATH_PREFIX "%04hx/%04hx@%u", pConfig->nVendorID, pConfig->nProductID, g_nNextSimulatedDeviceID++);
+
+		nRetVal = g_simulatedDevices.AddLast(pDevice);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnUSBSimulatorReleaseDevice(pDevice);
+		return (nRetVal);
+	}
+
+	xnLogInfo(XN_MASK_USB_SIMULATOR, "Simulated device %s was connected", pDevice->strPath);
+
+	xnOSStrCopy(strDevicePath, pDevice->strPath, sizeof(XnUSBConnectionString));
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBSimulatorDisconnectDevice(const XnUSBConnectionString strDevicePath)
+{
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_INPUT_PTR(strDevicePath);
+
+	XnUSBSimulatedDevice* pDevice = NULL;
+
+	{
+		XnAutoCSLocker locker(g_hSimulatorLock);
+
+		for (XnUSBSimulatedDeviceList::Iterator it = g_simulatedDevices.Begin(); it != g_simulatedDevices.End(); ++it)
+		{
+			if (xnOSStrCmp((*it)->strPath, strDevicePath) == 0)
+			{
+				// keeps it alive until it is disconnected
+				pDevice = *it;
+				++pDevice->nRefCount;
+				break;
+			}
+		}
+	}
+
+	if (pDevice == NULL)
+	{
+		return (XN_STATUS_USB_DEVICE_NOT_FOUND);
+	}
+
+	xnUSBSimulatorDisconnect(pDevice);
+	xnUSBSimulatorReleaseDevice(pDevice);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBSimulatorGetEndPointStatistics(XN_USB_EP_HANDLE pEPHandle, XnUSBSimulatedEndPointStatistics* pStatistics)
+{
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_INPUT_PTR(pEPHandle);
+	XN_VALIDATE_OUTPUT_PTR(pStatistics);
+
+	// only simulated endpoints keep these
+	if (pEPHandle->pBackend != &g_simulatorBackend)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	XnUSBSimulatedEndPoint* pEndPoint = (XnUSBSimulatedEndPoint*)pEPHandle->pBackendData;
+
+	XnAutoCSLocker locker(pEndPoint->hLock);
+	*pStatistics = pEndPoint->statistics;
+
+	return (XN_STATUS_OK);
+}
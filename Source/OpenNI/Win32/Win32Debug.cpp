@@ -190,3 +190,53 @@ XN_C_API XnStatus xnOSGetCurrentCallStack(XnUInt32 nFramesToSkip, XnChar** astrF
 
 	return XN_STATUS_OK;
 }
+
+XN_C_API XnStatus xnOSGetCurrentCallStackAddresses(XnUInt32 nFramesToSkip, void** apFrames, XnUInt32* pnFrames)
+{
+	if (*pnFrames == 0)
+	{
+		return XN_STATUS_OK;
+	}
+
+	// skip this function's frame as well. RtlCaptureStackBackTrace only walks the stack - no symbols are loaded here.
+	XnUInt32 nFramesToCapture = XN_MIN(*pnFrames, 62 - (nFramesToSkip + 1));
+	*pnFrames = RtlCaptureStackBackTrace(nFramesToSkip + 1, nFramesToCapture, apFrames, NULL);
+
+	return XN_STATUS_OK;
+}
+
+XN_C_API XnStatus xnOSResolveCallStackAddresses(void* const* apFrames, XnUInt32 nFrames, XnChar** astrFrames, XnUInt32 nMaxNameLength)
+{
+	if (nFrames == 0 || nMaxNameLength == 0)
+	{
+		return XN_STATUS_OK;
+	}
+
+	// Init
+	if (!g_bInitialized)
+	{
+		Init();
+		g_bInitialized = TRUE;
+	}
+
+	const XnUInt32 BUFFER_SIZE = 1024;
+	XnChar symbolBuffer[BUFFER_SIZE];
+	SYMBOL_INFO* pSymbolInfo = (SYMBOL_INFO*)symbolBuffer;
+	pSymbolInfo->SizeOfStruct = sizeof(SYMBOL_INFO);
+	pSymbolInfo->MaxNameLen = BUFFER_SIZE - sizeof(SYMBOL_INFO) - 1;
+
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		XnUInt32 nWritten;
+		if (g_bAvailable && g_pSymFromAddr(GetCurrentProcess(), (DWORD64)apFrames[i], NULL, pSymbolInfo))
+		{
+			xnOSStrFormat(astrFrames[i], nMaxNameLength, &nWritten, "%s()", pSymbolInfo->Name);
+		}
+		else
+		{
+			xnOSStrFormat(astrFrames[i], nMaxNameLength, &nWritten, "0x%p", apFrames[i]);
+		}
+	}
+
+	return XN_STATUS_OK;
+}
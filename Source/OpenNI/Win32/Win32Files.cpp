@@ -102,8 +102,11 @@ XN_C_API XnStatus xnOSOpenFile(const XnChar* cpFileName, const XnUInt32 nFlags,
 	// Update the OS Create and Open flags according the user request
 	if (nFlags & XN_OS_FILE_READ)
 	{
-		// Add the generic read flags and also specify request that the file must exist
-		nOSCreateFlags = OPEN_EXISTING;
+		// Add the generic read flags and also specify request that the file must exist (unless it is also written)
+		if ((nFlags & XN_OS_FILE_WRITE) == 0)
+		{
+			nOSCreateFlags = OPEN_EXISTING;
+		}
 		nOSOpenFlags |= GENERIC_READ;
 	}
 	if (nFlags & XN_OS_FILE_WRITE)
@@ -132,6 +135,10 @@ XN_C_API XnStatus xnOSOpenFile(const XnChar* cpFileName, const XnUInt32 nFlags,
 		nAttributes	|= FILE_FLAG_NO_BUFFERING;
 		nAttributes	|= FILE_FLAG_WRITE_THROUGH;
 	}
+	if (nFlags & XN_OS_FILE_DIRECT)
+	{
+		nAttributes	|= FILE_FLAG_NO_BUFFERING;
+	}
 
 	// Open the file via the OS
 	*pFile = CreateFile(cpFileName, nOSOpenFlags, nShareMode, NULL, nOSCreateFlags, nAttributes, NULL);
@@ -228,6 +235,37 @@ XN_C_API XnStatus xnOSReadFile(const XN_FILE_HANDLE File, void* pBuffer, XnUInt3
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSReadFileAt(const XN_FILE_HANDLE File, XnUInt64 nOffset, void* pBuffer, XnUInt32* pnBufferSize)
+{
+	// Validate the input/output pointers (to make sure none of them is NULL)
+	XN_VALIDATE_INPUT_PTR(pBuffer);
+	XN_VALIDATE_INPUT_PTR(pnBufferSize);
+
+	// Make sure the actual file handle isn't NULL
+	XN_RET_IF_NULL(File, XN_STATUS_OS_INVALID_FILE);
+
+	// the offset in the overlapped structure makes the read positional. The handle is synchronous, so it still
+	// blocks until done, and each thread passes its own structure.
+	OVERLAPPED overlapped;
+	xnOSMemSet(&overlapped, 0, sizeof(overlapped));
+	overlapped.Offset = (DWORD)nOffset;
+	overlapped.OffsetHigh = (DWORD)(nOffset >> 32);
+
+	DWORD nBytesRead = 0;
+	if (!ReadFile(File, pBuffer, *pnBufferSize, &nBytesRead, &overlapped))
+	{
+		if (GetLastError() != ERROR_HANDLE_EOF)
+		{
+			return (XN_STATUS_OS_FILE_READ_FAILED);
+		}
+	}
+
+	*pnBufferSize = nBytesRead;
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSWriteFile(const XN_FILE_HANDLE File, const void* pBuffer, const XnUInt32 nBufferSize)
 {
 	// Local function variables
@@ -415,6 +453,52 @@ XN_C_API XnStatus xnOSFlushFile(const XN_FILE_HANDLE File)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSPreallocateFile(const XN_FILE_HANDLE File, XnUInt64 nSize)
+{
+	// Make sure the actual file handle isn't NULL
+	XN_RET_IF_NULL(File, XN_STATUS_OS_INVALID_FILE);
+
+#if (_WIN32_WINNT >= 0x0600)
+	// reserve the clusters, but keep the file size as is
+	FILE_ALLOCATION_INFO allocationInfo;
+	allocationInfo.AllocationSize.QuadPart = nSize;
+	if (!SetFileInformationByHandle(File, FileAllocationInfo, &allocationInfo, sizeof(allocationInfo)))
+	{
+		return (XN_STATUS_OS_FILE_WRITE_FAILED);
+	}
+
+	return (XN_STATUS_OK);
+#else
+	XN_REFERENCE_VARIABLE(nSize);
+	return (XN_STATUS_NOT_IMPLEMENTED);
+#endif
+}
+
+XN_C_API XnStatus xnOSTruncateFile(const XN_FILE_HANDLE File, XnUInt64 nSize)
+{
+	LARGE_INTEGER liPos;
+	LARGE_INTEGER liZero;
+	LARGE_INTEGER liSize;
+
+	// Make sure the actual file handle isn't NULL
+	XN_RET_IF_NULL(File, XN_STATUS_OS_INVALID_FILE);
+
+	// SetEndOfFile() works on the current position, so keep it to restore later
+	liZero.QuadPart = 0;
+	liSize.QuadPart = nSize;
+	if (!SetFilePointerEx(File, liZero, &liPos, FILE_CURRENT) ||
+		!SetFilePointerEx(File, liSize, NULL, FILE_BEGIN) ||
+		!SetEndOfFile(File))
+	{
+		return (XN_STATUS_OS_FILE_WRITE_FAILED);
+	}
+
+	SetFilePointerEx(File, liPos, NULL, FILE_BEGIN);
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSDeleteFile(const XnChar* cpFileName)
 {
 	// Validate the input/output pointers (to make sure none of them is NULL)
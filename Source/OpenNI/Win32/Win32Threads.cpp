@@ -159,6 +159,48 @@ XN_C_API XnStatus xnOSSetThreadPriority(XN_THREAD_HANDLE ThreadHandle, XnThreadP
 	return XN_STATUS_OK;
 }
 
+XN_C_API XnStatus xnOSSetThreadAffinity(XN_THREAD_HANDLE ThreadHandle, XnUInt64 nCPUMask)
+{
+	// Make sure the actual thread handle isn't NULL
+	XN_RET_IF_NULL(ThreadHandle, XN_STATUS_OS_INVALID_THREAD);
+
+	if (SetThreadAffinityMask(ThreadHandle, (DWORD_PTR)nCPUMask) == 0)
+	{
+		return XN_STATUS_OS_THREAD_SET_AFFINITY_FAILED;
+	}
+
+	return XN_STATUS_OK;
+}
+
+typedef HRESULT (WINAPI *SetThreadDescriptionFuncPtr)(HANDLE hThread, PCWSTR lpThreadDescription);
+
+XN_C_API XnStatus xnOSSetThreadName(XN_THREAD_HANDLE ThreadHandle, const XnChar* strName)
+{
+	// Make sure the actual thread handle isn't NULL
+	XN_RET_IF_NULL(ThreadHandle, XN_STATUS_OS_INVALID_THREAD);
+	XN_VALIDATE_INPUT_PTR(strName);
+
+	// SetThreadDescription only exists on Windows 10 (1607) and later
+	static SetThreadDescriptionFuncPtr pSetThreadDescription = (SetThreadDescriptionFuncPtr)GetProcAddress(GetModuleHandleA("kernel32.dll"), "SetThreadDescription");
+	if (pSetThreadDescription == NULL)
+	{
+		return XN_STATUS_OS_UNSUPPORTED_FUNCTION;
+	}
+
+	WCHAR wstrName[XN_THREAD_ROLE_MAX_LENGTH * 2];
+	if (MultiByteToWideChar(CP_ACP, 0, strName, -1, wstrName, sizeof(wstrName) / sizeof(WCHAR)) == 0)
+	{
+		return XN_STATUS_OS_THREAD_SET_NAME_FAILED;
+	}
+
+	if (FAILED(pSetThreadDescription(ThreadHandle, wstrName)))
+	{
+		return XN_STATUS_OS_THREAD_SET_NAME_FAILED;
+	}
+
+	return XN_STATUS_OK;
+}
+
 XN_C_API XnStatus xnOSGetCurrentThreadID(XN_THREAD_ID* pThreadID)
 {
 	// Validate the input/output pointers (to make sure none of them is NULL)
@@ -171,3 +213,18 @@ XN_C_API XnStatus xnOSGetCurrentThreadID(XN_THREAD_ID* pThreadID)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API void xnOSMemoryBarrier()
+{
+	MemoryBarrier();
+}
+
+XN_C_API XnInt32 xnOSAtomicAdd32(volatile XnInt32* pValue, XnInt32 nValue)
+{
+	return (XnInt32)InterlockedExchangeAdd((volatile LONG*)pValue, (LONG)nValue) + nValue;
+}
+
+XN_C_API XnBool xnOSAtomicCompareAndSwap32(volatile XnInt32* pValue, XnInt32 nExpected, XnInt32 nNew)
+{
+	return ((XnInt32)InterlockedCompareExchange((volatile LONG*)pValue, (LONG)nNew, (LONG)nExpected) == nExpected);
+}
+
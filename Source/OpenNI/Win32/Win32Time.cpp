@@ -83,6 +83,37 @@ XN_C_API XnStatus xnOSSleep(XnUInt32 nMilliseconds)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnOSSleepUntilHighResTimeStamp(XnUInt64 nTimeStamp)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt64 nNow;
+	nRetVal = xnOSGetHighResTimeStamp(&nNow);
+	XN_IS_STATUS_OK(nRetVal);
+
+	// Sleep() is only as accurate as the system tick, so sleep for the bulk of the time and yield for the rest
+	if (nTimeStamp > nNow + 2000)
+	{
+		Sleep((DWORD)((nTimeStamp - nNow) / 1000) - 1);
+	}
+
+	for (;;)
+	{
+		nRetVal = xnOSGetHighResTimeStamp(&nNow);
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (nNow >= nTimeStamp)
+		{
+			break;
+		}
+
+		SwitchToThread();
+	}
+
+	// All is good...
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnStatus xnOSStartTimer(XnOSTimer* pTimer)
 {
 	// Local function variables
@@ -22,6 +22,7 @@
 // Includes
 //---------------------------------------------------------------------------
 #include <XnUSB.h>
+#include <XnUSBSimulator.h>
 #include "../xnUSBInternal.h"
 #include "XnUSBWin32.h"
 #include <XnLog.h>
@@ -1466,7 +1467,21 @@ XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 		// If the request was completed successfully, call the callback function
 		if (bResult == TRUE)
 		{
-			pCallbackFunction(pBuffersInfo[nOVIdx].pBuffer, nBytesRead, pCallbackData);
+			XN_TRACE_BEGIN(XN_TRACE_USB_TRANSFER, pThreadData->strTraceName, 0, 0, nBytesRead);
+			if (pThreadData->pPacketsCallbackFunction != NULL)
+			{
+				// the driver already put the packets together, so the whole buffer is passed as one
+				if (nBytesRead != 0)
+				{
+					XnUSBPacket packet = { pBuffersInfo[nOVIdx].pBuffer, nBytesRead, XN_STATUS_OK };
+					pThreadData->pPacketsCallbackFunction(&packet, 1, pCallbackData);
+				}
+			}
+			else
+			{
+				pCallbackFunction(pBuffersInfo[nOVIdx].pBuffer, nBytesRead, pCallbackData);
+			}
+			XN_TRACE_END(XN_TRACE_USB_TRANSFER, pThreadData->strTraceName, 0, 0, nBytesRead);
 		}
 
 		// Re-queue the request
@@ -1485,20 +1500,13 @@ XN_THREAD_PROC xnUSBReadThreadMain(XN_THREAD_PARAM pThreadParam)
 	}
 }
 
-XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, PVOID pCallbackData)
+static XnStatus xnUSBInitReadThreadImpl(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, XnUSBReadPacketsCallbackFunctionPtr pPacketsCallbackFunction, PVOID pCallbackData)
 {
 	// Local variables
 	XnStatus nRetVal = XN_STATUS_OK;
 	xnUSBReadThreadData* pThreadData = NULL;
 	XnUInt32 nBufIdx = 0;
 
-	// Validate xnUSB
-	XN_VALIDATE_USB_INIT();
-	XN_VALIDATE_USB_PEP_HANDLE(pEPHandle);
-
-	// Validate the input/output pointers
-	XN_VALIDATE_INPUT_PTR(pCallbackFunction);
-
 	// Dereference the ThreadData
 	pThreadData = &pEPHandle->ThreadData;
 
@@ -1517,9 +1525,13 @@ XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBuff
 	pThreadData->nNumBuffers = nNumBuffers;
 	pThreadData->nTimeOut = nTimeOut;
 	pThreadData->pCallbackFunction = pCallbackFunction;
+	pThreadData->pPacketsCallbackFunction = pPacketsCallbackFunction;
 	pThreadData->pCallbackData = pCallbackData;
 	pThreadData->bKillReadThread = FALSE;
 
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(pThreadData->strTraceName, sizeof(pThreadData->strTraceName), &nCharsWritten, "EP 0x%02x", pEPHandle->nEndPointID);
+
 	// Update the EP timeout
 	if (nTimeOut != pEPHandle->nTimeOut)
 	{
@@ -1545,6 +1557,10 @@ XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBuff
 	nRetVal = xnOSCreateThread(xnUSBReadThreadMain, &pEPHandle->ThreadData, &pThreadData->hReadThread);
 	XN_IS_STATUS_OK(nRetVal); // Add cleanup memory!
 
+	XnChar strThreadName[XN_THREAD_ROLE_MAX_LENGTH];
+	xnOSStrFormat(strThreadName, sizeof(strThreadName), &nCharsWritten, "XnUSB %s", pThreadData->strTraceName);
+	xnOSApplyThreadPolicy(pThreadData->hReadThread, XN_THREAD_ROLE_USB_READ, strThreadName);
+
 	// Mark that this EP has a valid read thread
 	pThreadData->bInUse = TRUE;
 
@@ -1552,6 +1568,30 @@ XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBuff
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnUSBInitReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadCallbackFunctionPtr pCallbackFunction, PVOID pCallbackData)
+{
+	// Validate xnUSB
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_USB_PEP_HANDLE(pEPHandle);
+
+	// Validate the input/output pointers
+	XN_VALIDATE_INPUT_PTR(pCallbackFunction);
+
+	return xnUSBInitReadThreadImpl(pEPHandle, nBufferSize, nNumBuffers, nTimeOut, pCallbackFunction, NULL, pCallbackData);
+}
+
+XN_C_API XnStatus xnUSBInitPacketReadThread(XN_USB_EP_HANDLE pEPHandle, XnUInt32 nBufferSize, XnUInt32 nNumBuffers, XnUInt32 nTimeOut, XnUSBReadPacketsCallbackFunctionPtr pCallbackFunction, PVOID pCallbackData)
+{
+	// Validate xnUSB
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_USB_PEP_HANDLE(pEPHandle);
+
+	// Validate the input/output pointers
+	XN_VALIDATE_INPUT_PTR(pCallbackFunction);
+
+	return xnUSBInitReadThreadImpl(pEPHandle, nBufferSize, nNumBuffers, nTimeOut, NULL, pCallbackFunction, pCallbackData);
+}
+
 XN_C_API XnStatus xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle)
 {
 	// Local variables
@@ -1617,6 +1657,59 @@ XN_C_API XnStatus xnUSBShutdownReadThread(XN_USB_EP_HANDLE pEPHandle)
 	return (XN_STATUS_OK);
 }
 
+XN_C_API XnStatus xnUSBSetReadThreadMode(XN_USB_EP_HANDLE pEPHandle, XnUSBReadThreadMode mode)
+{
+	// Validate xnUSB
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_USB_PEP_HANDLE(pEPHandle);
+
+	// The read thread already handles buffers in the order they complete (through an I/O completion port),
+	// but always calls the callback from its own thread
+	if (mode != XN_USB_READ_THREAD_MODE_ORDERED)
+	{
+		return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBGetReadThreadMode(XN_USB_EP_HANDLE pEPHandle, XnUSBReadThreadMode* pMode)
+{
+	// Validate xnUSB
+	XN_VALIDATE_USB_INIT();
+	XN_VALIDATE_USB_PEP_HANDLE(pEPHandle);
+	XN_VALIDATE_OUTPUT_PTR(pMode);
+
+	*pMode = XN_USB_READ_THREAD_MODE_ORDERED;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnUSBGetEndPointStatistics(XN_USB_EP_HANDLE /*pEPHandle*/, XnUSBEndPointStatistics* /*pStatistics*/)
+{
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+}
+
+XN_C_API XnStatus xnUSBSimulatorOpenEndPoint(const XnUSBSimulatedEndPointConfig* /*pConfig*/, XN_USB_EP_HANDLE* /*pEPHandlePtr*/)
+{
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+}
+
+XN_C_API XnStatus xnUSBSimulatorConnectDevice(const XnUSBSimulatedDeviceConfig* /*pConfig*/, XnUSBConnectionString /*strDevicePath*/)
+{
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+}
+
+XN_C_API XnStatus xnUSBSimulatorDisconnectDevice(const XnUSBConnectionString /*strDevicePath*/)
+{
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+}
+
+XN_C_API XnStatus xnUSBSimulatorGetEndPointStatistics(XN_USB_EP_HANDLE /*pEPHandle*/, XnUSBSimulatedEndPointStatistics* /*pStatistics*/)
+{
+	return (XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+}
+
 XN_C_API XnStatus XN_C_DECL xnUSBRegisterToConnectivityEvents(XnUInt16 nVendorID, XnUInt16 nProductID, XnUSBDeviceCallbackFunctionPtr pFunc, void* pCookie, XnRegistrationHandle* phRegistration)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
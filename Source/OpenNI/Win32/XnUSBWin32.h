@@ -25,6 +25,7 @@
 // Includes
 //---------------------------------------------------------------------------
 #include <XnOS.h>
+#include <XnTrace.h>
 #include <PSDrvPublic.h>
 
 //---------------------------------------------------------------------------
@@ -74,6 +75,7 @@ typedef struct xnUSBReadThreadData
 	XnUInt32 nTimeOut;
 
 	XnUSBReadCallbackFunctionPtr pCallbackFunction;
+	XnUSBReadPacketsCallbackFunctionPtr pPacketsCallbackFunction;
 	PVOID pCallbackData;
 
 	XN_THREAD_HANDLE  hReadThread;
@@ -81,6 +83,8 @@ typedef struct xnUSBReadThreadData
 
 	xnUSBBuffersInfo* pBuffersInfo;
 	OVERLAPPED* pOvlpIO;
+
+	XnChar strTraceName[XN_TRACE_OBJECT_NAME_LENGTH];
 } xnUSBReadThreadData;
 
 typedef struct XnUSBEndPointHandle
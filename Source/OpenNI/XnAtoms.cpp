@@ -0,0 +1,271 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnAtoms.h>
+#include <XnLog.h>
+#include <XnOSCpp.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_ATOMS				"Atoms"
+#define XN_ATOMS_INITIAL_CAPACITY	256
+#define XN_ATOMS_CHUNK_SIZE			1024
+#define XN_ATOMS_MAX_CHUNKS			1024
+#define XN_ATOMS_MAX_COUNT			(XN_ATOMS_CHUNK_SIZE * XN_ATOMS_MAX_CHUNKS)
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/* Never changes nor freed once published. */
+typedef struct XnAtomRecord
+{
+	XnUInt32 nHash;
+	XnAtom atom;
+	XnChar strName[1];
+} XnAtomRecord;
+
+/*
+* An open addressing table from strings to their records. Readers take no lock, so a slot is only
+* written once, after the record it points to is complete, and a table that was outgrown is replaced
+* by a new one rather than rehashed in place. Outgrown tables are never freed, as a reader may still
+* be probing them. They add up to less than the size of the current one.
+*/
+typedef struct XnAtomTable
+{
+	XnUInt32 nMask;
+	XnAtomRecord* volatile* apSlots;
+	struct XnAtomTable* pOutgrown;
+} XnAtomTable;
+
+class AtomsData
+{
+public:
+	static AtomsData& GetInstance()
+	{
+		static AtomsData data;
+		return data;
+	}
+
+	XnAtomTable* volatile pTable;
+	/* atom - 1 to record. Chunks never move, so existing atoms can be read while new ones are added. */
+	XnAtomRecord** volatile apChunks[XN_ATOMS_MAX_CHUNKS];
+	volatile XnUInt32 nCount;
+	XN_CRITICAL_SECTION_HANDLE hLock;
+
+private:
+	AtomsData() : pTable(NULL), nCount(0), hLock(NULL)
+	{
+		xnOSMemSet((void*)apChunks, 0, sizeof(apChunks));
+		xnOSCreateCriticalSection(&hLock);
+	}
+
+	// strings are interned for the lifetime of the process, so nothing is freed
+};
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+/* FNV-1a */
+static inline XnUInt32 xnAtomsHash(const XnChar* strName, XnUInt32* pnLength)
+{
+	XnUInt32 nHash = 2166136261U;
+	const XnChar* pChar = strName;
+	for (; *pChar != '\0'; ++pChar)
+	{
+		nHash ^= (XnUInt8)*pChar;
+		nHash *= 16777619U;
+	}
+
+	*pnLength = (XnUInt32)(pChar - strName);
+	return nHash;
+}
+
+static const XnAtomRecord* xnAtomsLookup(const XnAtomTable* pTable, const XnChar* strName, XnUInt32 nHash)
+{
+	if (pTable == NULL)
+	{
+		return NULL;
+	}
+
+	// records are reached through the pointers that published them, so no barrier is needed here
+	for (XnUInt32 nSlot = nHash & pTable->nMask; ; nSlot = (nSlot + 1) & pTable->nMask)
+	{
+		const XnAtomRecord* pRecord = pTable->apSlots[nSlot];
+		if (pRecord == NULL)
+		{
+			return NULL;
+		}
+
+		if (pRecord->nHash == nHash && strcmp(pRecord->strName, strName) == 0)
+		{
+			return pRecord;
+		}
+	}
+}
+
+static void xnAtomsInsert(XnAtomTable* pTable, XnAtomRecord* pRecord)
+{
+	XnUInt32 nSlot = pRecord->nHash & pTable->nMask;
+	while (pTable->apSlots[nSlot] != NULL)
+	{
+		nSlot = (nSlot + 1) & pTable->nMask;
+	}
+
+	pTable->apSlots[nSlot] = pRecord;
+}
+
+static XnStatus xnAtomsCreateTable(XnUInt32 nCapacity, XnAtomTable** ppTable)
+{
+	XnAtomTable* pTable = (XnAtomTable*)xnOSCalloc(1, sizeof(XnAtomTable) + nCapacity * sizeof(XnAtomRecord*));
+	XN_VALIDATE_ALLOC_PTR(pTable);
+
+	pTable->nMask = nCapacity - 1;
+	pTable->apSlots = (XnAtomRecord* volatile*)(pTable + 1);
+	*ppTable = pTable;
+	return (XN_STATUS_OK);
+}
+
+/* Makes room for one more atom, keeping the table at most half full. Called with the lock held. */
+static XnStatus xnAtomsReserve(AtomsData& data)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnAtomTable* pTable = data.pTable;
+	if (pTable != NULL && (data.nCount + 1) * 2 <= pTable->nMask + 1)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	XnAtomTable* pNewTable = NULL;
+	nRetVal = xnAtomsCreateTable(pTable == NULL ? XN_ATOMS_INITIAL_CAPACITY : (pTable->nMask + 1) * 2, &pNewTable);
+	XN_IS_STATUS_OK(nRetVal);
+
+	for (XnUInt32 i = 0; i < data.nCount; ++i)
+	{
+		xnAtomsInsert(pNewTable, data.apChunks[i / XN_ATOMS_CHUNK_SIZE][i % XN_ATOMS_CHUNK_SIZE]);
+	}
+
+	pNewTable->pOutgrown = pTable;
+	// the table is published only once it is filled
+	xnOSMemoryBarrier();
+	data.pTable = pNewTable;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus XN_C_DECL xnAtomIntern(const XnChar* strName, XnAtom* pAtom)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strName);
+	XN_VALIDATE_OUTPUT_PTR(pAtom);
+
+	XnUInt32 nLength = 0;
+	XnUInt32 nHash = xnAtomsHash(strName, &nLength);
+	AtomsData& data = AtomsData::GetInstance();
+
+	const XnAtomRecord* pRecord = xnAtomsLookup(data.pTable, strName, nHash);
+	if (pRecord != NULL)
+	{
+		*pAtom = pRecord->atom;
+		return (XN_STATUS_OK);
+	}
+
+	XnAutoCSLocker locker(data.hLock);
+
+	// another thread may have interned it while we waited for the lock
+	pRecord = xnAtomsLookup(data.pTable, strName, nHash);
+	if (pRecord != NULL)
+	{
+		*pAtom = pRecord->atom;
+		return (XN_STATUS_OK);
+	}
+
+	XnUInt32 nIndex = data.nCount;
+	if (nIndex == XN_ATOMS_MAX_COUNT)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INTERNAL_BUFFER_TOO_SMALL, XN_MASK_ATOMS, "Can't intern more than %u strings", XN_ATOMS_MAX_COUNT);
+	}
+
+	nRetVal = xnAtomsReserve(data);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAtomRecord** pChunk = data.apChunks[nIndex / XN_ATOMS_CHUNK_SIZE];
+	if (pChunk == NULL)
+	{
+		pChunk = (XnAtomRecord**)xnOSCalloc(XN_ATOMS_CHUNK_SIZE, sizeof(XnAtomRecord*));
+		XN_VALIDATE_ALLOC_PTR(pChunk);
+		data.apChunks[nIndex / XN_ATOMS_CHUNK_SIZE] = pChunk;
+	}
+
+	XnAtomRecord* pNewRecord = (XnAtomRecord*)xnOSMalloc(sizeof(XnAtomRecord) + nLength);
+	XN_VALIDATE_ALLOC_PTR(pNewRecord);
+	pNewRecord->nHash = nHash;
+	pNewRecord->atom = nIndex + 1;
+	xnOSMemCopy(pNewRecord->strName, strName, nLength + 1);
+
+	pChunk[nIndex % XN_ATOMS_CHUNK_SIZE] = pNewRecord;
+	// and the record only once it is filled
+	xnOSMemoryBarrier();
+	xnAtomsInsert(data.pTable, pNewRecord);
+	data.nCount = nIndex + 1;
+
+	*pAtom = pNewRecord->atom;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus XN_C_DECL xnAtomFind(const XnChar* strName, XnAtom* pAtom)
+{
+	XN_VALIDATE_INPUT_PTR(strName);
+	XN_VALIDATE_OUTPUT_PTR(pAtom);
+
+	XnUInt32 nLength = 0;
+	XnUInt32 nHash = xnAtomsHash(strName, &nLength);
+
+	const XnAtomRecord* pRecord = xnAtomsLookup(AtomsData::GetInstance().pTable, strName, nHash);
+	if (pRecord == NULL)
+	{
+		return (XN_STATUS_NO_MATCH);
+	}
+
+	*pAtom = pRecord->atom;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API const XnChar* XN_C_DECL xnAtomGetString(XnAtom atom)
+{
+	AtomsData& data = AtomsData::GetInstance();
+	if (atom == XN_INVALID_ATOM || atom > data.nCount)
+	{
+		return NULL;
+	}
+
+	XnUInt32 nIndex = atom - 1;
+	return data.apChunks[nIndex / XN_ATOMS_CHUNK_SIZE][nIndex % XN_ATOMS_CHUNK_SIZE]->strName;
+}
+
+XN_C_API XnUInt32 XN_C_DECL xnAtomGetCount()
+{
+	return AtomsData::GetInstance().nCount;
+}
@@ -0,0 +1,597 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnDepthRegistration.h>
+#include <XnLog.h>
+
+#if (XN_PLATFORM != XN_PLATFORM_WIN32)
+	#include <unistd.h>
+#endif
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE2__)
+	#define XN_DEPTH_REGISTRATION_SSE2
+	#include <emmintrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Z-buffer value of an output pixel no depth pixel fell on (larger than any real depth). */
+#define XN_DEPTH_REGISTRATION_EMPTY				0xFFFF
+#define XN_DEPTH_REGISTRATION_WORKER_EXIT_TIMEOUT	1000
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef enum XnDepthRegistrationPhase
+{
+	/** Each thread warps a band of depth rows into its own z-buffer. */
+	XN_DEPTH_REGISTRATION_PHASE_WARP,
+	/** Each thread merges a band of output rows from all z-buffers, and clears them for the next frame. */
+	XN_DEPTH_REGISTRATION_PHASE_MERGE
+} XnDepthRegistrationPhase;
+
+typedef struct XnDepthRegistrationWorker
+{
+	XnDepthRegistration* pRegistration;
+	XnUInt32 nIndex;
+	XN_THREAD_HANDLE hThread;
+	XN_EVENT_HANDLE hStartEvent;
+	XN_EVENT_HANDLE hDoneEvent;
+	/* One extra pixel at the end receives every depth pixel that falls outside the output. */
+	XnDepthPixel* pZBuffer;
+} XnDepthRegistrationWorker;
+
+struct XnDepthRegistration
+{
+	XnUInt32 nDepthXRes;
+	XnUInt32 nDepthYRes;
+	XnUInt32 nOutputXRes;
+	XnUInt32 nOutputYRes;
+
+	/* A depth pixel with depth z lands on output column (z * pSlopeX[i] + fOffsetX) / (z * pSlopeW[i] + fOffsetW),
+	   and row (z * pSlopeY[i] + fOffsetY) / (z * pSlopeW[i] + fOffsetW). */
+	XnFloat* pSlopeX;
+	XnFloat* pSlopeY;
+	XnFloat* pSlopeW;
+	XnFloat fOffsetX;
+	XnFloat fOffsetY;
+	XnFloat fOffsetW;
+
+	/* Calibration scaled to the engine's resolutions, for mapping single points. */
+	XnDouble fDepthFocalX;
+	XnDouble fDepthFocalY;
+	XnDouble fDepthCenterX;
+	XnDouble fDepthCenterY;
+	XnDouble fOutputFocalX;
+	XnDouble fOutputFocalY;
+	XnDouble fOutputCenterX;
+	XnDouble fOutputCenterY;
+	XnDouble aRotation[9];
+	XnDouble aTranslation[3];
+	XnBool bMirror;
+
+	XnUInt32 nThreads;
+	XnDepthRegistrationWorker aWorkers[XN_DEPTH_REGISTRATION_MAX_THREADS];
+	XnBool bStopWorkers;
+	XnDepthRegistrationPhase phase;
+	const XnDepthPixel* pSource;
+	XnDepthPixel* pTarget;
+};
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XnUInt32 xnDepthRegistrationGetCPUCount()
+{
+#if (XN_PLATFORM == XN_PLATFORM_WIN32)
+	xnOSInfo osInfo;
+	if (xnOSGetInfo(&osInfo) == XN_STATUS_OK && osInfo.nProcessorsCount > 0)
+	{
+		return osInfo.nProcessorsCount;
+	}
+#elif defined(_SC_NPROCESSORS_ONLN)
+	long nCPUs = sysconf(_SC_NPROCESSORS_ONLN);
+	if (nCPUs > 0)
+	{
+		return (XnUInt32)nCPUs;
+	}
+#endif
+	return 1;
+}
+
+static XnStatus xnDepthRegistrationScaleIntrinsics(const XnCameraIntrinsics& intrinsics, XnUInt32 nXRes, XnUInt32 nYRes, XnDouble& fFocalX, XnDouble& fFocalY, XnDouble& fCenterX, XnDouble& fCenterY)
+{
+	if (intrinsics.nXRes == 0 || intrinsics.nYRes == 0 || intrinsics.fFocalLengthX <= 0 || intrinsics.fFocalLengthY <= 0)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_DEPTH_REGISTRATION, "Invalid camera intrinsics");
+	}
+
+	XnDouble fScaleX = (XnDouble)nXRes / intrinsics.nXRes;
+	XnDouble fScaleY = (XnDouble)nYRes / intrinsics.nYRes;
+	fFocalX = intrinsics.fFocalLengthX * fScaleX;
+	fFocalY = intrinsics.fFocalLengthY * fScaleY;
+	fCenterX = intrinsics.fPrincipalPointX * fScaleX;
+	fCenterY = intrinsics.fPrincipalPointY * fScaleY;
+
+	return (XN_STATUS_OK);
+}
+
+/* Transforms the ray of depth column x and row y (at depth 1) into image sensor coordinates. */
+static void xnDepthRegistrationTransformRay(const XnDepthRegistration* pRegistration, XnDouble x, XnDouble y, XnDouble aRay[3])
+{
+	if (pRegistration->bMirror)
+	{
+		x = pRegistration->nDepthXRes - 1 - x;
+	}
+
+	XnDouble fRayX = (x - pRegistration->fDepthCenterX) / pRegistration->fDepthFocalX;
+	XnDouble fRayY = (y - pRegistration->fDepthCenterY) / pRegistration->fDepthFocalY;
+
+	const XnDouble* R = pRegistration->aRotation;
+	aRay[0] = R[0] * fRayX + R[1] * fRayY + R[2];
+	aRay[1] = R[3] * fRayX + R[4] * fRayY + R[5];
+	aRay[2] = R[6] * fRayX + R[7] * fRayY + R[8];
+}
+
+static XnStatus xnDepthRegistrationBuildTables(XnDepthRegistration* pRegistration)
+{
+	XnUInt32 nPixels = pRegistration->nDepthXRes * pRegistration->nDepthYRes;
+
+	XN_VALIDATE_ALIGNED_CALLOC(pRegistration->pSlopeX, XnFloat, nPixels, XN_DEFAULT_MEM_ALIGN);
+	XN_VALIDATE_ALIGNED_CALLOC(pRegistration->pSlopeY, XnFloat, nPixels, XN_DEFAULT_MEM_ALIGN);
+	XN_VALIDATE_ALIGNED_CALLOC(pRegistration->pSlopeW, XnFloat, nPixels, XN_DEFAULT_MEM_ALIGN);
+
+	// projecting (z * ray + T) gives column (fx * (z * rayX + Tx) + cx * (z * rayZ + Tz)) / (z * rayZ + Tz),
+	// so everything but z can be folded into a slope per pixel and a constant offset.
+	const XnDouble* T = pRegistration->aTranslation;
+	XnDouble fLastColumn = pRegistration->nOutputXRes - 1.0;
+	XnDouble fOffsetX = pRegistration->fOutputFocalX * T[0] + pRegistration->fOutputCenterX * T[2];
+	XnDouble fOffsetW = T[2];
+	if (pRegistration->bMirror)
+	{
+		// mirrored column is (lastColumn - column), which folds the same way
+		fOffsetX = fLastColumn * fOffsetW - fOffsetX;
+	}
+
+	pRegistration->fOffsetX = (XnFloat)fOffsetX;
+	pRegistration->fOffsetY = (XnFloat)(pRegistration->fOutputFocalY * T[1] + pRegistration->fOutputCenterY * T[2]);
+	pRegistration->fOffsetW = (XnFloat)fOffsetW;
+
+	XnUInt32 nIndex = 0;
+	for (XnUInt32 y = 0; y < pRegistration->nDepthYRes; ++y)
+	{
+		for (XnUInt32 x = 0; x < pRegistration->nDepthXRes; ++x, ++nIndex)
+		{
+			XnDouble aRay[3];
+			xnDepthRegistrationTransformRay(pRegistration, x, y, aRay);
+
+			XnDouble fSlopeX = pRegistration->fOutputFocalX * aRay[0] + pRegistration->fOutputCenterX * aRay[2];
+			if (pRegistration->bMirror)
+			{
+				fSlopeX = fLastColumn * aRay[2] - fSlopeX;
+			}
+
+			pRegistration->pSlopeX[nIndex] = (XnFloat)fSlopeX;
+			pRegistration->pSlopeY[nIndex] = (XnFloat)(pRegistration->fOutputFocalY * aRay[1] + pRegistration->fOutputCenterY * aRay[2]);
+			pRegistration->pSlopeW[nIndex] = (XnFloat)aRay[2];
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+/* Returns the z-buffer index depth pixel i lands on, or nTrashIndex if it has no depth or lands outside the output. */
+static inline XnUInt32 xnDepthRegistrationTargetIndex(const XnDepthRegistration* pRegistration, XnUInt32 i, XnDepthPixel nDepth, XnUInt32 nTrashIndex)
+{
+	XnFloat fDepth = (XnFloat)nDepth;
+	XnFloat fW = fDepth * pRegistration->pSlopeW[i] + pRegistration->fOffsetW;
+	XnFloat fX = (fDepth * pRegistration->pSlopeX[i] + pRegistration->fOffsetX) / fW + 0.5f;
+	XnFloat fY = (fDepth * pRegistration->pSlopeY[i] + pRegistration->fOffsetY) / fW + 0.5f;
+
+	if (nDepth == 0 || !(fW > 0) ||
+		!(fX >= 0) || !(fX < (XnFloat)pRegistration->nOutputXRes) ||
+		!(fY >= 0) || !(fY < (XnFloat)pRegistration->nOutputYRes))
+	{
+		return nTrashIndex;
+	}
+
+	return (XnUInt32)(XnInt32)fY * pRegistration->nOutputXRes + (XnUInt32)(XnInt32)fX;
+}
+
+static void xnDepthRegistrationWarpRows(const XnDepthRegistration* pRegistration, XnUInt32 nFirstRow, XnUInt32 nLastRow, XnDepthPixel* pZBuffer)
+{
+	const XnUInt32 nXRes = pRegistration->nDepthXRes;
+	const XnUInt32 nTrashIndex = pRegistration->nOutputXRes * pRegistration->nOutputYRes;
+	const XnDepthPixel* pSource = pRegistration->pSource;
+
+#ifdef XN_DEPTH_REGISTRATION_SSE2
+	const __m128 offsetX = _mm_set1_ps(pRegistration->fOffsetX);
+	const __m128 offsetY = _mm_set1_ps(pRegistration->fOffsetY);
+	const __m128 offsetW = _mm_set1_ps(pRegistration->fOffsetW);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 xRes = _mm_set1_ps((XnFloat)pRegistration->nOutputXRes);
+	const __m128 yRes = _mm_set1_ps((XnFloat)pRegistration->nOutputYRes);
+	const __m128i trash = _mm_set1_epi32((XnInt32)nTrashIndex);
+	const __m128i zeroInt = _mm_setzero_si128();
+	XnInt32 aIndices[4];
+#endif
+
+	for (XnUInt32 y = nFirstRow; y < nLastRow; ++y)
+	{
+		XnUInt32 i = y * nXRes;
+		XnUInt32 nRowEnd = i + nXRes;
+
+#ifdef XN_DEPTH_REGISTRATION_SSE2
+		for (; i + 4 <= nRowEnd; i += 4)
+		{
+			__m128i depth = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(pSource + i)), zeroInt);
+			__m128 z = _mm_cvtepi32_ps(depth);
+
+			__m128 w = _mm_add_ps(_mm_mul_ps(z, _mm_loadu_ps(pRegistration->pSlopeW + i)), offsetW);
+			__m128 fx = _mm_add_ps(_mm_div_ps(_mm_add_ps(_mm_mul_ps(z, _mm_loadu_ps(pRegistration->pSlopeX + i)), offsetX), w), half);
+			__m128 fy = _mm_add_ps(_mm_div_ps(_mm_add_ps(_mm_mul_ps(z, _mm_loadu_ps(pRegistration->pSlopeY + i)), offsetY), w), half);
+
+			// comparisons are false for NaNs, so a zero denominator ends up invalid as well
+			__m128 valid = _mm_cmpgt_ps(w, zero);
+			valid = _mm_and_ps(valid, _mm_cmpge_ps(fx, zero));
+			valid = _mm_and_ps(valid, _mm_cmplt_ps(fx, xRes));
+			valid = _mm_and_ps(valid, _mm_cmpge_ps(fy, zero));
+			valid = _mm_and_ps(valid, _mm_cmplt_ps(fy, yRes));
+			__m128i validInt = _mm_andnot_si128(_mm_cmpeq_epi32(depth, zeroInt), _mm_castps_si128(valid));
+
+			// both coordinates are non-negative here, so truncation is floor, and the index is exact in a float
+			__m128 column = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+			__m128 row = _mm_cvtepi32_ps(_mm_cvttps_epi32(fy));
+			__m128i index = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(row, xRes), column));
+			index = _mm_or_si128(_mm_and_si128(validInt, index), _mm_andnot_si128(validInt, trash));
+			_mm_storeu_si128((__m128i*)aIndices, index);
+
+			for (XnUInt32 j = 0; j < 4; ++j)
+			{
+				XnDepthPixel nDepth = pSource[i + j];
+				XnDepthPixel& nTarget = pZBuffer[aIndices[j]];
+				if (nDepth < nTarget)
+				{
+					nTarget = nDepth;
+				}
+			}
+		}
+#endif
+
+		for (; i < nRowEnd; ++i)
+		{
+			XnDepthPixel nDepth = pSource[i];
+			XnDepthPixel& nTarget = pZBuffer[xnDepthRegistrationTargetIndex(pRegistration, i, nDepth, nTrashIndex)];
+			if (nDepth < nTarget)
+			{
+				nTarget = nDepth;
+			}
+		}
+	}
+}
+
+static void xnDepthRegistrationMergePixels(XnDepthRegistration* pRegistration, XnUInt32 nFirst, XnUInt32 nLast)
+{
+	const XnUInt32 nThreads = pRegistration->nThreads;
+	XnDepthPixel* pTarget = pRegistration->pTarget;
+	XnUInt32 i = nFirst;
+
+#ifdef XN_DEPTH_REGISTRATION_SSE2
+	const __m128i empty = _mm_set1_epi16((XnInt16)XN_DEPTH_REGISTRATION_EMPTY);
+	for (; i + 8 <= nLast; i += 8)
+	{
+		__m128i closest = empty;
+		for (XnUInt32 t = 0; t < nThreads; ++t)
+		{
+			__m128i* pZ = (__m128i*)(pRegistration->aWorkers[t].pZBuffer + i);
+			__m128i z = _mm_loadu_si128(pZ);
+			// SSE2 has no unsigned 16-bit min, but a - saturate(a - b) is one
+			closest = _mm_sub_epi16(closest, _mm_subs_epu16(closest, z));
+			_mm_storeu_si128(pZ, empty);
+		}
+
+		closest = _mm_andnot_si128(_mm_cmpeq_epi16(closest, empty), closest);
+		_mm_storeu_si128((__m128i*)(pTarget + i), closest);
+	}
+#endif
+
+	for (; i < nLast; ++i)
+	{
+		XnDepthPixel nClosest = XN_DEPTH_REGISTRATION_EMPTY;
+		for (XnUInt32 t = 0; t < nThreads; ++t)
+		{
+			XnDepthPixel* pZ = pRegistration->aWorkers[t].pZBuffer + i;
+			nClosest = XN_MIN(nClosest, *pZ);
+			*pZ = XN_DEPTH_REGISTRATION_EMPTY;
+		}
+
+		pTarget[i] = (nClosest == XN_DEPTH_REGISTRATION_EMPTY) ? 0 : nClosest;
+	}
+}
+
+static void xnDepthRegistrationRunPhase(XnDepthRegistration* pRegistration, XnUInt32 nIndex)
+{
+	if (pRegistration->phase == XN_DEPTH_REGISTRATION_PHASE_WARP)
+	{
+		XnUInt32 nRows = pRegistration->nDepthYRes;
+		XnUInt32 nFirstRow = nRows * nIndex / pRegistration->nThreads;
+		XnUInt32 nLastRow = nRows * (nIndex + 1) / pRegistration->nThreads;
+		xnDepthRegistrationWarpRows(pRegistration, nFirstRow, nLastRow, pRegistration->aWorkers[nIndex].pZBuffer);
+	}
+	else
+	{
+		XnUInt32 nRows = pRegistration->nOutputYRes;
+		XnUInt32 nFirstRow = nRows * nIndex / pRegistration->nThreads;
+		XnUInt32 nLastRow = nRows * (nIndex + 1) / pRegistration->nThreads;
+		xnDepthRegistrationMergePixels(pRegistration, nFirstRow * pRegistration->nOutputXRes, nLastRow * pRegistration->nOutputXRes);
+	}
+}
+
+XN_THREAD_PROC xnDepthRegistrationWorkerThread(XN_THREAD_PARAM pThreadParam)
+{
+	XnDepthRegistrationWorker* pWorker = (XnDepthRegistrationWorker*)pThreadParam;
+	XnDepthRegistration* pRegistration = pWorker->pRegistration;
+
+	for (;;)
+	{
+		xnOSWaitEvent(pWorker->hStartEvent, XN_WAIT_INFINITE);
+		if (pRegistration->bStopWorkers)
+		{
+			break;
+		}
+
+		xnDepthRegistrationRunPhase(pRegistration, pWorker->nIndex);
+		xnOSSetEvent(pWorker->hDoneEvent);
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+/* Runs the current phase on all threads, the calling one included, and waits for them to finish. */
+static void xnDepthRegistrationRunPhaseOnAllThreads(XnDepthRegistration* pRegistration)
+{
+	for (XnUInt32 t = 1; t < pRegistration->nThreads; ++t)
+	{
+		xnOSSetEvent(pRegistration->aWorkers[t].hStartEvent);
+	}
+
+	xnDepthRegistrationRunPhase(pRegistration, 0);
+
+	for (XnUInt32 t = 1; t < pRegistration->nThreads; ++t)
+	{
+		xnOSWaitEvent(pRegistration->aWorkers[t].hDoneEvent, XN_WAIT_INFINITE);
+	}
+}
+
+static void xnDepthRegistrationFree(XnDepthRegistration* pRegistration)
+{
+	// stop threads
+	pRegistration->bStopWorkers = TRUE;
+	for (XnUInt32 t = 1; t < XN_DEPTH_REGISTRATION_MAX_THREADS; ++t)
+	{
+		XnDepthRegistrationWorker& worker = pRegistration->aWorkers[t];
+		if (worker.hThread != NULL)
+		{
+			xnOSSetEvent(worker.hStartEvent);
+			xnOSWaitAndTerminateThread(&worker.hThread, XN_DEPTH_REGISTRATION_WORKER_EXIT_TIMEOUT);
+		}
+	}
+
+	for (XnUInt32 t = 0; t < XN_DEPTH_REGISTRATION_MAX_THREADS; ++t)
+	{
+		XnDepthRegistrationWorker& worker = pRegistration->aWorkers[t];
+		if (worker.hStartEvent != NULL)
+		{
+			xnOSCloseEvent(&worker.hStartEvent);
+		}
+		if (worker.hDoneEvent != NULL)
+		{
+			xnOSCloseEvent(&worker.hDoneEvent);
+		}
+		XN_ALIGNED_FREE_AND_NULL(worker.pZBuffer);
+	}
+
+	XN_ALIGNED_FREE_AND_NULL(pRegistration->pSlopeX);
+	XN_ALIGNED_FREE_AND_NULL(pRegistration->pSlopeY);
+	XN_ALIGNED_FREE_AND_NULL(pRegistration->pSlopeW);
+
+	xnOSFree(pRegistration);
+}
+
+#define XN_CHECK_RC_AND_FREE(nRetVal, pRegistration)	\
+	if (nRetVal != XN_STATUS_OK)						\
+	{													\
+		xnDepthRegistrationFree(pRegistration);			\
+		return (nRetVal);								\
+	}
+
+static XnStatus xnDepthRegistrationInitWorker(XnDepthRegistration* pRegistration, XnUInt32 nIndex)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnDepthRegistrationWorker& worker = pRegistration->aWorkers[nIndex];
+	worker.pRegistration = pRegistration;
+	worker.nIndex = nIndex;
+
+	XnUInt32 nZBufferSize = pRegistration->nOutputXRes * pRegistration->nOutputYRes + 1;
+	XN_VALIDATE_ALIGNED_CALLOC(worker.pZBuffer, XnDepthPixel, nZBufferSize, XN_DEFAULT_MEM_ALIGN);
+	for (XnUInt32 i = 0; i < nZBufferSize; ++i)
+	{
+		worker.pZBuffer[i] = XN_DEPTH_REGISTRATION_EMPTY;
+	}
+
+	// the calling thread does the first share of the work itself
+	if (nIndex == 0)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	nRetVal = xnOSCreateEvent(&worker.hStartEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&worker.hDoneEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateThread(xnDepthRegistrationWorkerThread, (XN_THREAD_PARAM)&worker, &worker.hThread);
+	XN_IS_STATUS_OK(nRetVal);
+
+	xnOSApplyThreadPolicy(worker.hThread, XN_THREAD_ROLE_REGISTRATION, "XnRegistration");
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnDepthRegistrationCreate(const XnRegistrationCalibration* pCalibration, XnUInt32 nDepthXRes, XnUInt32 nDepthYRes, XnUInt32 nOutputXRes, XnUInt32 nOutputYRes, XnBool bMirror, XnUInt32 nThreads, XnDepthRegistration** ppRegistration)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pCalibration);
+	XN_VALIDATE_OUTPUT_PTR(ppRegistration);
+
+	*ppRegistration = NULL;
+
+	if (nDepthXRes == 0 || nDepthYRes == 0 || nOutputXRes == 0 || nOutputYRes == 0 ||
+		nOutputXRes * nOutputYRes >= (1 << 24)) // output indices are calculated in floats
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_DEPTH_REGISTRATION, "Unsupported registration resolution %ux%u -> %ux%u", nDepthXRes, nDepthYRes, nOutputXRes, nOutputYRes);
+	}
+
+	if (nThreads == 0)
+	{
+		nThreads = xnDepthRegistrationGetCPUCount();
+	}
+	nThreads = XN_MIN(nThreads, XN_DEPTH_REGISTRATION_MAX_THREADS);
+	nThreads = XN_MIN(nThreads, nDepthYRes);
+
+	XnDepthRegistration* pRegistration = NULL;
+	XN_VALIDATE_CALLOC(pRegistration, XnDepthRegistration, 1);
+
+	pRegistration->nDepthXRes = nDepthXRes;
+	pRegistration->nDepthYRes = nDepthYRes;
+	pRegistration->nOutputXRes = nOutputXRes;
+	pRegistration->nOutputYRes = nOutputYRes;
+	pRegistration->bMirror = bMirror;
+	pRegistration->nThreads = nThreads;
+	xnOSMemCopy(pRegistration->aRotation, pCalibration->aRotation, sizeof(pRegistration->aRotation));
+	xnOSMemCopy(pRegistration->aTranslation, pCalibration->aTranslation, sizeof(pRegistration->aTranslation));
+
+	nRetVal = xnDepthRegistrationScaleIntrinsics(pCalibration->depth, nDepthXRes, nDepthYRes,
+		pRegistration->fDepthFocalX, pRegistration->fDepthFocalY, pRegistration->fDepthCenterX, pRegistration->fDepthCenterY);
+	XN_CHECK_RC_AND_FREE(nRetVal, pRegistration);
+
+	nRetVal = xnDepthRegistrationScaleIntrinsics(pCalibration->image, nOutputXRes, nOutputYRes,
+		pRegistration->fOutputFocalX, pRegistration->fOutputFocalY, pRegistration->fOutputCenterX, pRegistration->fOutputCenterY);
+	XN_CHECK_RC_AND_FREE(nRetVal, pRegistration);
+
+	nRetVal = xnDepthRegistrationBuildTables(pRegistration);
+	XN_CHECK_RC_AND_FREE(nRetVal, pRegistration);
+
+	for (XnUInt32 t = 0; t < nThreads; ++t)
+	{
+		nRetVal = xnDepthRegistrationInitWorker(pRegistration, t);
+		XN_CHECK_RC_AND_FREE(nRetVal, pRegistration);
+	}
+
+	xnLogVerbose(XN_MASK_DEPTH_REGISTRATION, "Registration engine created for %ux%u -> %ux%u, using %u threads", nDepthXRes, nDepthYRes, nOutputXRes, nOutputYRes, nThreads);
+
+	*ppRegistration = pRegistration;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnDepthRegistrationDestroy(XnDepthRegistration** ppRegistration)
+{
+	XN_VALIDATE_INPUT_PTR(ppRegistration);
+
+	if (*ppRegistration != NULL)
+	{
+		xnDepthRegistrationFree(*ppRegistration);
+		*ppRegistration = NULL;
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnDepthRegistrationRegister(XnDepthRegistration* pRegistration, const XnDepthPixel* pDepth, XnDepthPixel* pRegistered)
+{
+	XN_VALIDATE_INPUT_PTR(pRegistration);
+	XN_VALIDATE_INPUT_PTR(pDepth);
+	XN_VALIDATE_OUTPUT_PTR(pRegistered);
+
+	pRegistration->pSource = pDepth;
+	pRegistration->pTarget = pRegistered;
+
+	// all warping is done before merging starts, so the output may overwrite the input
+	pRegistration->phase = XN_DEPTH_REGISTRATION_PHASE_WARP;
+	xnDepthRegistrationRunPhaseOnAllThreads(pRegistration);
+
+	pRegistration->phase = XN_DEPTH_REGISTRATION_PHASE_MERGE;
+	xnDepthRegistrationRunPhaseOnAllThreads(pRegistration);
+
+	pRegistration->pSource = NULL;
+	pRegistration->pTarget = NULL;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnDepthRegistrationMapPoints(XnDepthRegistration* pRegistration, XnUInt32 nCount, const XnPoint3D* aDepthPoints, XnPoint3D* aImagePoints)
+{
+	XN_VALIDATE_INPUT_PTR(pRegistration);
+	XN_VALIDATE_INPUT_PTR(aDepthPoints);
+	XN_VALIDATE_OUTPUT_PTR(aImagePoints);
+
+	const XnDouble* T = pRegistration->aTranslation;
+
+	for (XnUInt32 i = 0; i < nCount; ++i)
+	{
+		XnDouble fDepth = aDepthPoints[i].Z;
+
+		XnDouble aRay[3];
+		xnDepthRegistrationTransformRay(pRegistration, aDepthPoints[i].X, aDepthPoints[i].Y, aRay);
+
+		XnDouble fX = fDepth * aRay[0] + T[0];
+		XnDouble fY = fDepth * aRay[1] + T[1];
+		XnDouble fZ = fDepth * aRay[2] + T[2];
+
+		if (fDepth <= 0 || fZ <= 0)
+		{
+			aImagePoints[i].X = 0;
+			aImagePoints[i].Y = 0;
+			aImagePoints[i].Z = 0;
+			continue;
+		}
+
+		XnDouble fColumn = pRegistration->fOutputFocalX * fX / fZ + pRegistration->fOutputCenterX;
+		if (pRegistration->bMirror)
+		{
+			fColumn = pRegistration->nOutputXRes - 1 - fColumn;
+		}
+
+		aImagePoints[i].X = (XnFloat)fColumn;
+		aImagePoints[i].Y = (XnFloat)(pRegistration->fOutputFocalY * fY / fZ + pRegistration->fOutputCenterY);
+		aImagePoints[i].Z = (XnFloat)fDepth;
+	}
+
+	return (XN_STATUS_OK);
+}
@@ -22,6 +22,7 @@
 // Includes
 //---------------------------------------------------------------------------
 #include "XnXmlScriptNodeExporter.h"
+#include "XnFilterNodeExporter.h"
 #include <XnModuleCppRegistratration.h>
 #include "xnInternalFuncs.h"
 
@@ -30,6 +31,8 @@
 //---------------------------------------------------------------------------
 XN_EXPORT_MODULE(xn::Module);
 XN_EXPORT_NODE(XnXmlScriptNodeExporter, XN_NODE_TYPE_SCRIPT);
+XN_EXPORT_NODE(XnDepthFilterExporter, XN_NODE_TYPE_DEPTH);
+XN_EXPORT_NODE(XnImageFilterExporter, XN_NODE_TYPE_IMAGE);
 
 XnOpenNIModuleInterface* GetOpenNIModuleInterface()
 {
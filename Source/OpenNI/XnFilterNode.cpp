@@ -0,0 +1,1205 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnFilterNode.h"
+#include <XnPropNames.h>
+#include <XnLog.h>
+#include <XnOSCpp.h>
+#include <math.h>
+#include <ctype.h>
+
+#if (defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))) || (defined(__GNUC__) && defined(__SSE2__))
+	#define XN_FILTER_SSE2
+	#include <emmintrin.h>
+#endif
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_FILTER							"Filter"
+
+#define XN_FILTER_FRAME_POOL_DEFAULT_FRAMES		2
+#define XN_FILTER_FRAME_POOL_DEFAULT_MAX_FRAMES	16
+
+#define XN_FILTER_MAX_STAGE_NAME				32
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef struct XnFilterStageSyntax
+{
+	const XnChar* strName;
+	XnFilterStageType type;
+	XnUInt32 nMinParams;
+	XnUInt32 nMaxParams;
+	XnUInt32 nDefaultParam;
+} XnFilterStageSyntax;
+
+static const XnFilterStageSyntax g_aStageSyntax[] = 
+{
+	{ "crop",		XN_FILTER_STAGE_CROP,		4, 4, 0 },
+	{ "downscale",	XN_FILTER_STAGE_DOWNSCALE,	1, 1, 0 },
+	{ "mirror",		XN_FILTER_STAGE_MIRROR,		0, 0, 0 },
+	{ "median",		XN_FILTER_STAGE_MEDIAN,		0, 1, 3 },
+	{ "holefill",	XN_FILTER_STAGE_HOLE_FILL,	0, 0, 0 },
+	{ "threshold",	XN_FILTER_STAGE_THRESHOLD,	2, 2, 0 },
+};
+
+//---------------------------------------------------------------------------
+// Row Kernels
+//---------------------------------------------------------------------------
+static void xnFilterGatherRow(const XnUInt8* pSrc, XnInt32 nStep, XnUInt32 nPixels, XnUInt32 nBytesPerPixel, XnUInt8* pDst)
+{
+	if (nStep == 1)
+	{
+		xnOSMemCopy(pDst, pSrc, nPixels * nBytesPerPixel);
+		return;
+	}
+
+	switch (nBytesPerPixel)
+	{
+	case 1:
+		for (XnUInt32 i = 0; i < nPixels; ++i, pSrc += nStep)
+		{
+			pDst[i] = *pSrc;
+		}
+		break;
+	case 2:
+		{
+			const XnUInt16* pSrc16 = (const XnUInt16*)pSrc;
+			XnUInt16* pDst16 = (XnUInt16*)pDst;
+			for (XnUInt32 i = 0; i < nPixels; ++i, pSrc16 += nStep)
+			{
+				pDst16[i] = *pSrc16;
+			}
+		}
+		break;
+	case 3:
+		for (XnUInt32 i = 0; i < nPixels; ++i, pSrc += nStep * 3, pDst += 3)
+		{
+			pDst[0] = pSrc[0];
+			pDst[1] = pSrc[1];
+			pDst[2] = pSrc[2];
+		}
+		break;
+	default:
+		for (XnUInt32 i = 0; i < nPixels; ++i, pSrc += nStep * (XnInt32)nBytesPerPixel, pDst += nBytesPerPixel)
+		{
+			xnOSMemCopy(pDst, pSrc, nBytesPerPixel);
+		}
+		break;
+	}
+}
+
+static void xnFilterThresholdRow(XnDepthPixel* pPixels, XnUInt32 nPixels, XnDepthPixel nMin, XnDepthPixel nMax)
+{
+	XnUInt32 i = 0;
+
+#ifdef XN_FILTER_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i minValue = _mm_set1_epi16((short)nMin);
+	const __m128i maxValue = _mm_set1_epi16((short)nMax);
+	for (; i + 8 <= nPixels; i += 8)
+	{
+		__m128i value = _mm_loadu_si128((const __m128i*)(pPixels + i));
+		// saturating subtraction is zero exactly when the value is inside the range
+		__m128i aboveMin = _mm_cmpeq_epi16(_mm_subs_epu16(minValue, value), zero);
+		__m128i belowMax = _mm_cmpeq_epi16(_mm_subs_epu16(value, maxValue), zero);
+		value = _mm_and_si128(value, _mm_and_si128(aboveMin, belowMax));
+		_mm_storeu_si128((__m128i*)(pPixels + i), value);
+	}
+#endif
+
+	for (; i < nPixels; ++i)
+	{
+		if (pPixels[i] < nMin || pPixels[i] > nMax)
+		{
+			pPixels[i] = 0;
+		}
+	}
+}
+
+static void xnFilterHoleFillRow(XnDepthPixel* pPixels, XnDepthPixel* pLastValid, XnUInt32 nPixels)
+{
+	XnUInt32 i = 0;
+
+#ifdef XN_FILTER_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for (; i + 8 <= nPixels; i += 8)
+	{
+		__m128i value = _mm_loadu_si128((const __m128i*)(pPixels + i));
+		__m128i last = _mm_loadu_si128((const __m128i*)(pLastValid + i));
+		__m128i hole = _mm_cmpeq_epi16(value, zero);
+		value = _mm_or_si128(_mm_andnot_si128(hole, value), _mm_and_si128(hole, last));
+		_mm_storeu_si128((__m128i*)(pPixels + i), value);
+		_mm_storeu_si128((__m128i*)(pLastValid + i), value);
+	}
+#endif
+
+	for (; i < nPixels; ++i)
+	{
+		if (pPixels[i] == 0)
+		{
+			pPixels[i] = pLastValid[i];
+		}
+		else
+		{
+			pLastValid[i] = pPixels[i];
+		}
+	}
+}
+
+/** Writes the (lower) median of nFrames rows, nFrameStride pixels apart, into pOut. **/
+static void xnFilterMedianRow(const XnDepthPixel* pHistory, XnUInt32 nFrameStride, XnUInt32 nFrames, XnDepthPixel* pOut, XnUInt32 nPixels)
+{
+	// a partial selection sort: after pass k, position k holds the k-th smallest value
+	XnUInt32 nMedian = (nFrames - 1) / 2;
+	XnUInt32 i = 0;
+
+#ifdef XN_FILTER_SSE2
+	// SSE2 only has signed 16-bit min/max, so values are biased into the signed range and back
+	const __m128i bias = _mm_set1_epi16((short)0x8000);
+	__m128i aValues[XN_FILTER_MAX_MEDIAN_FRAMES];
+	for (; i + 8 <= nPixels; i += 8)
+	{
+		for (XnUInt32 f = 0; f < nFrames; ++f)
+		{
+			aValues[f] = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(pHistory + f * nFrameStride + i)), bias);
+		}
+
+		for (XnUInt32 k = 0; k <= nMedian; ++k)
+		{
+			for (XnUInt32 j = k + 1; j < nFrames; ++j)
+			{
+				__m128i low = _mm_min_epi16(aValues[k], aValues[j]);
+				aValues[j] = _mm_max_epi16(aValues[k], aValues[j]);
+				aValues[k] = low;
+			}
+		}
+
+		_mm_storeu_si128((__m128i*)(pOut + i), _mm_xor_si128(aValues[nMedian], bias));
+	}
+#endif
+
+	XnDepthPixel aPixelValues[XN_FILTER_MAX_MEDIAN_FRAMES];
+	for (; i < nPixels; ++i)
+	{
+		for (XnUInt32 f = 0; f < nFrames; ++f)
+		{
+			aPixelValues[f] = pHistory[f * nFrameStride + i];
+		}
+
+		for (XnUInt32 k = 0; k <= nMedian; ++k)
+		{
+			for (XnUInt32 j = k + 1; j < nFrames; ++j)
+			{
+				XnDepthPixel nLow = XN_MIN(aPixelValues[k], aPixelValues[j]);
+				aPixelValues[j] = XN_MAX(aPixelValues[k], aPixelValues[j]);
+				aPixelValues[k] = nLow;
+			}
+		}
+
+		pOut[i] = aPixelValues[nMedian];
+	}
+}
+
+//---------------------------------------------------------------------------
+// XnFilterGenerator
+//---------------------------------------------------------------------------
+XnFilterGenerator::XnFilterGenerator(const XnChar* strName, xn::MapGenerator& input) :
+	m_input(input),
+	m_nInputXRes(0),
+	m_nInputYRes(0),
+	m_hLock(NULL),
+	m_bGenerating(FALSE),
+	m_nLastInputFrameID(0),
+	m_pool(XN_FILTER_FRAME_POOL_DEFAULT_FRAMES, XN_FILTER_FRAME_POOL_DEFAULT_MAX_FRAMES),
+	m_nDroppedFrames(0),
+	m_hInputNewData(NULL),
+	m_hInputGenerating(NULL),
+	m_hInputOutputMode(NULL),
+	m_hInputCropping(NULL)
+{
+	strncpy(m_strName, strName, sizeof(m_strName) - 1);
+	m_strName[sizeof(m_strName) - 1] = '\0';
+	m_strStages[0] = '\0';
+	xnOSMemSet(&m_chain, 0, sizeof(m_chain));
+	xnOSMemSet(&m_view, 0, sizeof(m_view));
+}
+
+XnFilterGenerator::~XnFilterGenerator()
+{
+	if (m_hInputNewData != NULL)
+	{
+		m_input.UnregisterFromNewDataAvailable(m_hInputNewData);
+	}
+
+	if (m_hInputGenerating != NULL)
+	{
+		m_input.UnregisterFromGenerationRunningChange(m_hInputGenerating);
+	}
+
+	if (m_hInputOutputMode != NULL)
+	{
+		m_input.UnregisterFromMapOutputModeChange(m_hInputOutputMode);
+	}
+
+	if (m_hInputCropping != NULL)
+	{
+		m_input.GetCroppingCap().UnregisterFromCroppingChange(m_hInputCropping);
+	}
+
+	xnOSCloseCriticalSection(&m_hLock);
+}
+
+XnStatus XnFilterGenerator::Init(const XnChar* strStages)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = xnOSCreateCriticalSection(&m_hLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = m_input.RegisterToNewDataAvailable(OnInputNewDataAvailable, this, m_hInputNewData);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = m_input.RegisterToGenerationRunningChange(OnInputGenerationRunningChanged, this, m_hInputGenerating);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = m_input.RegisterToMapOutputModeChange(OnInputMapOutputModeChanged, this, m_hInputOutputMode);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (m_input.IsCapabilitySupported(XN_CAPABILITY_CROPPING))
+	{
+		nRetVal = m_input.GetCroppingCap().RegisterToCroppingChange(OnInputMapOutputModeChanged, this, m_hInputCropping);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	nRetVal = SetStages(strStages == NULL ? "" : strStages);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::ParseStages(const XnChar* strStages, XnFilterChain& chain)
+{
+	chain.nCount = 0;
+
+	const XnChar* pStage = strStages;
+	while (*pStage != '\0')
+	{
+		const XnChar* pStageEnd = strchr(pStage, ';');
+		if (pStageEnd == NULL)
+		{
+			pStageEnd = pStage + strlen(pStage);
+		}
+
+		// skip white space around the stage
+		const XnChar* pNext = (*pStageEnd == ';') ? pStageEnd + 1 : pStageEnd;
+		while (pStage < pStageEnd && isspace((unsigned char)*pStage))
+		{
+			++pStage;
+		}
+		while (pStageEnd > pStage && isspace((unsigned char)pStageEnd[-1]))
+		{
+			--pStageEnd;
+		}
+
+		if (pStage == pStageEnd)
+		{
+			// allow empty stages (e.g. a trailing ';')
+			pStage = pNext;
+			continue;
+		}
+
+		XnChar strStage[XN_FILTER_MAX_STAGES_LENGTH];
+		XnUInt32 nLength = (XnUInt32)(pStageEnd - pStage);
+		if (nLength >= sizeof(strStage))
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Filter stage is too long");
+		}
+		xnOSMemCopy(strStage, pStage, nLength);
+		strStage[nLength] = '\0';
+
+		XnChar* strParams = strchr(strStage, ':');
+		if (strParams != NULL)
+		{
+			*strParams = '\0';
+			++strParams;
+		}
+
+		const XnFilterStageSyntax* pSyntax = NULL;
+		for (XnUInt32 i = 0; i < sizeof(g_aStageSyntax) / sizeof(g_aStageSyntax[0]); ++i)
+		{
+			if (xnOSStrCaseCmp(strStage, g_aStageSyntax[i].strName) == 0)
+			{
+				pSyntax = &g_aStageSyntax[i];
+				break;
+			}
+		}
+
+		if (pSyntax == NULL)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Unknown filter stage '%s'", strStage);
+		}
+
+		if (chain.nCount == XN_FILTER_MAX_STAGES)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "A filter can have at most %u stages", XN_FILTER_MAX_STAGES);
+		}
+
+		XnFilterStage& stage = chain.aStages[chain.nCount];
+		xnOSMemSet(&stage, 0, sizeof(stage));
+		stage.type = pSyntax->type;
+		stage.aParams[0] = pSyntax->nDefaultParam;
+
+		XnUInt32 nParams = 0;
+		const XnChar* pParam = strParams;
+		while (pParam != NULL && *pParam != '\0')
+		{
+			XnChar* pParamEnd = NULL;
+			unsigned long nValue = strtoul(pParam, &pParamEnd, 10);
+			while (isspace((unsigned char)*pParamEnd))
+			{
+				++pParamEnd;
+			}
+
+			if (pParamEnd == pParam || (*pParamEnd != ',' && *pParamEnd != '\0') || nParams == pSyntax->nMaxParams)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Bad parameters for filter stage '%s'", strStage);
+			}
+
+			stage.aParams[nParams++] = (XnUInt32)nValue;
+			pParam = (*pParamEnd == ',') ? pParamEnd + 1 : pParamEnd;
+		}
+
+		if (nParams < pSyntax->nMinParams)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Filter stage '%s' requires %u parameters", strStage, pSyntax->nMinParams);
+		}
+
+		switch (stage.type)
+		{
+		case XN_FILTER_STAGE_CROP:
+			if (stage.aParams[2] == 0 || stage.aParams[3] == 0)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Crop size can not be zero");
+			}
+			break;
+		case XN_FILTER_STAGE_DOWNSCALE:
+			if (stage.aParams[0] == 0 || stage.aParams[0] > XN_FILTER_MAX_DOWNSCALE)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Downscale factor must be between 1 and %u", XN_FILTER_MAX_DOWNSCALE);
+			}
+			break;
+		case XN_FILTER_STAGE_MEDIAN:
+			if (stage.aParams[0] == 0 || stage.aParams[0] > XN_FILTER_MAX_MEDIAN_FRAMES)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Median window must be between 1 and %u frames", XN_FILTER_MAX_MEDIAN_FRAMES);
+			}
+			break;
+		case XN_FILTER_STAGE_THRESHOLD:
+			if (stage.aParams[0] > stage.aParams[1] || stage.aParams[1] > XN_MAX_UINT16)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "Bad threshold range %u-%u", stage.aParams[0], stage.aParams[1]);
+			}
+			break;
+		default:
+			break;
+		}
+
+		++chain.nCount;
+		pStage = pNext;
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::ComputeView(XnUInt32 nInputXRes, XnUInt32 nInputYRes, const XnFilterChain& chain, XnFilterView& view)
+{
+	view.nOffsetX = 0;
+	view.nOffsetY = 0;
+	view.nStepX = 1;
+	view.nStepY = 1;
+	view.nXRes = nInputXRes;
+	view.nYRes = nInputYRes;
+
+	for (XnUInt32 i = 0; i < chain.nCount; ++i)
+	{
+		const XnFilterStage& stage = chain.aStages[i];
+		switch (stage.type)
+		{
+		case XN_FILTER_STAGE_CROP:
+			if (stage.aParams[0] + stage.aParams[2] > view.nXRes || stage.aParams[1] + stage.aParams[3] > view.nYRes)
+			{
+				return (XN_STATUS_BAD_PARAM);
+			}
+			view.nOffsetX += (XnInt32)stage.aParams[0] * view.nStepX;
+			view.nOffsetY += (XnInt32)stage.aParams[1] * view.nStepY;
+			view.nXRes = stage.aParams[2];
+			view.nYRes = stage.aParams[3];
+			break;
+		case XN_FILTER_STAGE_DOWNSCALE:
+			view.nStepX *= (XnInt32)stage.aParams[0];
+			view.nStepY *= (XnInt32)stage.aParams[0];
+			view.nXRes /= stage.aParams[0];
+			view.nYRes /= stage.aParams[0];
+			if (view.nXRes == 0 || view.nYRes == 0)
+			{
+				return (XN_STATUS_BAD_PARAM);
+			}
+			break;
+		case XN_FILTER_STAGE_MIRROR:
+			view.nOffsetX += (XnInt32)(view.nXRes - 1) * view.nStepX;
+			view.nStepX = -view.nStepX;
+			break;
+		default:
+			// not a geometric stage
+			break;
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::ValidateStages(const XnFilterChain& /*chain*/)
+{
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::OnViewChanged()
+{
+	return (XN_STATUS_OK);
+}
+
+void XnFilterGenerator::OnOutputChanged()
+{
+	m_mapOutputModeChangeEvent.Raise();
+}
+
+void XnFilterGenerator::ProcessRow(XnUInt32 /*nRow*/, void* /*pRow*/)
+{
+}
+
+void XnFilterGenerator::OnFrameProcessed()
+{
+}
+
+XnBool XnFilterGenerator::IsInputSupported()
+{
+	return TRUE;
+}
+
+XnStatus XnFilterGenerator::SetStages(const XnChar* strStages)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (strlen(strStages) >= sizeof(m_strStages))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "%s: Filter stages string is too long", m_strName);
+	}
+
+	XnFilterChain chain;
+	nRetVal = ParseStages(strStages, chain);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = ValidateStages(chain);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUInt32 nInputXRes = 0;
+	XnUInt32 nInputYRes = 0;
+	GetInputResolution(nInputXRes, nInputYRes);
+
+	XnFilterView view;
+	nRetVal = ComputeView(nInputXRes, nInputYRes, chain, view);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_FILTER, "%s: Filter stages '%s' do not fit a %ux%u input", m_strName, strStages, nInputXRes, nInputYRes);
+	}
+
+	XnBool bResolutionChanged = FALSE;
+	{
+		XnAutoCSLocker locker(m_hLock);
+
+		bResolutionChanged = (view.nXRes != m_view.nXRes || view.nYRes != m_view.nYRes);
+		m_chain = chain;
+		m_view = view;
+		m_nInputXRes = nInputXRes;
+		m_nInputYRes = nInputYRes;
+		strcpy(m_strStages, strStages);
+
+		nRetVal = OnViewChanged();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	xnLogVerbose(XN_MASK_FILTER, "%s: Filter stages set to '%s' (output is %ux%u)", m_strName, m_strStages, m_view.nXRes, m_view.nYRes);
+
+	if (bResolutionChanged)
+	{
+		OnOutputChanged();
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnBool XnFilterGenerator::UpdateView()
+{
+	XnUInt32 nInputXRes = 0;
+	XnUInt32 nInputYRes = 0;
+	GetInputResolution(nInputXRes, nInputYRes);
+
+	if (nInputXRes == m_nInputXRes && nInputYRes == m_nInputYRes)
+	{
+		return FALSE;
+	}
+
+	XnUInt32 nOldXRes = m_view.nXRes;
+	XnUInt32 nOldYRes = m_view.nYRes;
+
+	if (ComputeView(nInputXRes, nInputYRes, m_chain, m_view) != XN_STATUS_OK)
+	{
+		// the geometric stages no longer fit. Pass the input through rather than fail every frame.
+		xnLogWarning(XN_MASK_FILTER, "%s: Filter stages '%s' do not fit the new %ux%u input. Ignoring crop and downscale.", m_strName, m_strStages, nInputXRes, nInputYRes);
+		XnFilterChain empty;
+		empty.nCount = 0;
+		ComputeView(nInputXRes, nInputYRes, empty, m_view);
+	}
+
+	m_nInputXRes = nInputXRes;
+	m_nInputYRes = nInputYRes;
+	OnViewChanged();
+
+	return (m_view.nXRes != nOldXRes || m_view.nYRes != nOldYRes);
+}
+
+void XnFilterGenerator::GetInputResolution(XnUInt32& nXRes, XnUInt32& nYRes)
+{
+	XnMapOutputMode mode;
+	xnOSMemSet(&mode, 0, sizeof(mode));
+	m_input.GetMapOutputMode(mode);
+	nXRes = mode.nXRes;
+	nYRes = mode.nYRes;
+
+	if (m_hInputCropping != NULL)
+	{
+		XnCropping cropping;
+		if (m_input.GetCroppingCap().GetCropping(cropping) == XN_STATUS_OK && cropping.bEnabled)
+		{
+			nXRes = cropping.nXSize;
+			nYRes = cropping.nYSize;
+		}
+	}
+}
+
+XnUInt32 XnFilterGenerator::GetInputBytesPerPixel()
+{
+	return m_input.GetBytesPerPixel();
+}
+
+XnBool XnFilterGenerator::IsCapabilitySupported(const XnChar* strCapabilityName)
+{
+	return (strcmp(strCapabilityName, XN_CAPABILITY_FRAME_LEASE) == 0);
+}
+
+XnStatus XnFilterGenerator::SetStringProperty(const XnChar* strName, const XnChar* strValue)
+{
+	if (strcmp(strName, XN_PROP_FILTER_STAGES) == 0)
+	{
+		return SetStages(strValue);
+	}
+
+	return (XN_STATUS_NOT_IMPLEMENTED);
+}
+
+XnStatus XnFilterGenerator::GetStringProperty(const XnChar* strName, XnChar* csValue, XnUInt32 nBufSize) const
+{
+	if (strcmp(strName, XN_PROP_FILTER_STAGES) == 0)
+	{
+		XnAutoCSLocker locker(m_hLock);
+		return xnOSStrCopy(csValue, m_strStages, nBufSize);
+	}
+
+	return (XN_STATUS_NOT_IMPLEMENTED);
+}
+
+XnStatus XnFilterGenerator::StartGenerating()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (!m_input.IsGenerating())
+	{
+		nRetVal = m_input.StartGenerating();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	if (!m_bGenerating)
+	{
+		m_bGenerating = TRUE;
+		m_generatingChangedEvent.Raise();
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnBool XnFilterGenerator::IsGenerating()
+{
+	return (m_bGenerating && m_input.IsGenerating());
+}
+
+void XnFilterGenerator::StopGenerating()
+{
+	// the input may have other consumers, so it keeps running
+	if (m_bGenerating)
+	{
+		m_bGenerating = FALSE;
+		m_generatingChangedEvent.Raise();
+	}
+}
+
+XnStatus XnFilterGenerator::RegisterToGenerationRunningChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback)
+{
+	return m_generatingChangedEvent.Register(handler, pCookie, hCallback);
+}
+
+void XnFilterGenerator::UnregisterFromGenerationRunningChange(XnCallbackHandle hCallback)
+{
+	m_generatingChangedEvent.Unregister(hCallback);
+}
+
+XnStatus XnFilterGenerator::RegisterToNewDataAvailable(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback)
+{
+	return m_newDataAvailableEvent.Register(handler, pCookie, hCallback);
+}
+
+void XnFilterGenerator::UnregisterFromNewDataAvailable(XnCallbackHandle hCallback)
+{
+	m_newDataAvailableEvent.Unregister(hCallback);
+}
+
+XnBool XnFilterGenerator::IsNewDataAvailable(XnUInt64& nTimestamp)
+{
+	if (!m_bGenerating)
+	{
+		return FALSE;
+	}
+
+	// either the input has data pending, or it was already updated (it is updated before us) with a frame 
+	// we did not process yet
+	if (m_input.IsNewDataAvailable(&nTimestamp))
+	{
+		return TRUE;
+	}
+
+	if (m_input.GetFrameID() != m_nLastInputFrameID)
+	{
+		nTimestamp = m_input.GetTimestamp();
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+XnStatus XnFilterGenerator::UpdateData()
+{
+	XnUInt32 nInputFrameID = m_input.GetFrameID();
+	const XnUInt8* pInput = (const XnUInt8*)m_input.GetData();
+	if (nInputFrameID == m_nLastInputFrameID || pInput == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	if (!IsInputSupported())
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "%s: Input format is not supported by filters", m_strName);
+	}
+
+	XnBool bResolutionChanged = FALSE;
+	{
+		XnAutoCSLocker locker(m_hLock);
+
+		m_nLastInputFrameID = nInputFrameID;
+		bResolutionChanged = UpdateView();
+
+		XnUInt32 nBytesPerPixel = GetInputBytesPerPixel();
+		if (m_input.GetDataSize() < m_nInputXRes * m_nInputYRes * nBytesPerPixel)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_BUFFER_SIZE, XN_MASK_FILTER, "%s: Input frame %u is smaller than its %ux%u resolution", m_strName, nInputFrameID, m_nInputXRes, m_nInputYRes);
+		}
+
+		// filter straight into the next buffer, which then becomes current
+		XnFramePool::Frame& next = m_pool.Next();
+		XnUInt32 nNeededSize = m_view.nXRes * m_view.nYRes * nBytesPerPixel;
+		XnStatus nRetVal = XnFramePool::Allocate(next, nNeededSize);
+		XN_IS_STATUS_OK(nRetVal);
+
+		Process(pInput, (XnUInt8*)next.pData);
+
+		next.nDataSize = nNeededSize;
+		next.nFrameID = nInputFrameID;
+		next.nTimestamp = m_input.GetTimestamp();
+
+		if (!m_pool.Advance())
+		{
+			// all buffers are leased. Drop the new frame, and keep the current one.
+			if (m_nDroppedFrames == 0)
+			{
+				xnLogWarning(XN_MASK_FILTER, "%s: All %u frame buffers are leased. Dropping frames until one is released.", m_strName, m_pool.GetSize());
+			}
+			++m_nDroppedFrames;
+			return (XN_STATUS_OK);
+		}
+
+		if (m_nDroppedFrames != 0)
+		{
+			xnLogInfo(XN_MASK_FILTER, "%s: Frame buffer available again, after dropping %u frames", m_strName, m_nDroppedFrames);
+			m_nDroppedFrames = 0;
+		}
+	}
+
+	if (bResolutionChanged)
+	{
+		OnOutputChanged();
+	}
+
+	return (XN_STATUS_OK);
+}
+
+void XnFilterGenerator::Process(const XnUInt8* pInput, XnUInt8* pOutput)
+{
+	XnUInt32 nBytesPerPixel = GetInputBytesPerPixel();
+	XnUInt32 nOutputRowSize = m_view.nXRes * nBytesPerPixel;
+
+	for (XnUInt32 y = 0; y < m_view.nYRes; ++y)
+	{
+		XnInt32 nSrcY = m_view.nOffsetY + (XnInt32)y * m_view.nStepY;
+		const XnUInt8* pSrc = pInput + ((XnSizeT)nSrcY * m_nInputXRes + m_view.nOffsetX) * nBytesPerPixel;
+		XnUInt8* pDst = pOutput + y * nOutputRowSize;
+
+		// gather the row, then run the per-pixel stages on it while it's still in cache
+		xnFilterGatherRow(pSrc, m_view.nStepX, m_view.nXRes, nBytesPerPixel, pDst);
+		ProcessRow(y, pDst);
+	}
+
+	OnFrameProcessed();
+}
+
+const void* XnFilterGenerator::GetCurrentData()
+{
+	return m_pool.Current().pData;
+}
+
+XnUInt32 XnFilterGenerator::GetDataSize()
+{
+	return m_pool.Current().nDataSize;
+}
+
+XnUInt64 XnFilterGenerator::GetTimestamp()
+{
+	return m_pool.Current().nTimestamp;
+}
+
+XnUInt32 XnFilterGenerator::GetFrameID()
+{
+	return m_pool.Current().nFrameID;
+}
+
+xn::ModuleFrameLeaseInterface* XnFilterGenerator::GetFrameLeaseInterface()
+{
+	return this;
+}
+
+XnUInt32 XnFilterGenerator::GetSupportedMapOutputModesCount()
+{
+	return 1;
+}
+
+XnStatus XnFilterGenerator::GetSupportedMapOutputModes(XnMapOutputMode aModes[], XnUInt32& nCount)
+{
+	if (nCount < 1)
+	{
+		return (XN_STATUS_OUTPUT_BUFFER_OVERFLOW);
+	}
+
+	nCount = 1;
+	return GetMapOutputMode(aModes[0]);
+}
+
+XnStatus XnFilterGenerator::SetMapOutputMode(const XnMapOutputMode& Mode)
+{
+	XnMapOutputMode current;
+	XnStatus nRetVal = GetMapOutputMode(current);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (Mode.nXRes != current.nXRes || Mode.nYRes != current.nYRes || Mode.nFPS != current.nFPS)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "%s: Filter output mode is set by its input and stages", m_strName);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::GetMapOutputMode(XnMapOutputMode& Mode)
+{
+	XnStatus nRetVal = m_input.GetMapOutputMode(Mode);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAutoCSLocker locker(m_hLock);
+	UpdateView();
+	Mode.nXRes = m_view.nXRes;
+	Mode.nYRes = m_view.nYRes;
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::RegisterToMapOutputModeChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback)
+{
+	return m_mapOutputModeChangeEvent.Register(handler, pCookie, hCallback);
+}
+
+void XnFilterGenerator::UnregisterFromMapOutputModeChange(XnCallbackHandle hCallback)
+{
+	m_mapOutputModeChangeEvent.Unregister(hCallback);
+}
+
+XnStatus XnFilterGenerator::AcquireFrame(XnFrameLease& lease)
+{
+	XnAutoCSLocker locker(m_hLock);
+
+	if (m_pool.Lease(lease) != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_FILTER, "%s: There is no frame to lease", m_strName);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::ReleaseFrame(const XnFrameLease& lease)
+{
+	XnAutoCSLocker locker(m_hLock);
+
+	if (m_pool.Release(lease) != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_NO_MATCH, XN_MASK_FILTER, "%s: Frame %u was not leased from this node", m_strName, lease.nFrameID);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterGenerator::SetFramePoolPolicy(const XnFramePoolPolicy& policy)
+{
+	XnAutoCSLocker locker(m_hLock);
+	return m_pool.SetPolicy(policy);
+}
+
+XnStatus XnFilterGenerator::GetFramePoolPolicy(XnFramePoolPolicy& policy)
+{
+	XnAutoCSLocker locker(m_hLock);
+	policy = m_pool.GetPolicy();
+	return (XN_STATUS_OK);
+}
+
+void XN_CALLBACK_TYPE XnFilterGenerator::OnInputNewDataAvailable(xn::ProductionNode& /*node*/, void* pCookie)
+{
+	XnFilterGenerator* pThis = (XnFilterGenerator*)pCookie;
+	if (pThis->m_bGenerating)
+	{
+		pThis->m_newDataAvailableEvent.Raise();
+	}
+}
+
+void XN_CALLBACK_TYPE XnFilterGenerator::OnInputGenerationRunningChanged(xn::ProductionNode& /*node*/, void* pCookie)
+{
+	XnFilterGenerator* pThis = (XnFilterGenerator*)pCookie;
+	pThis->m_generatingChangedEvent.Raise();
+}
+
+void XN_CALLBACK_TYPE XnFilterGenerator::OnInputMapOutputModeChanged(xn::ProductionNode& /*node*/, void* pCookie)
+{
+	XnFilterGenerator* pThis = (XnFilterGenerator*)pCookie;
+
+	{
+		XnAutoCSLocker locker(pThis->m_hLock);
+		pThis->UpdateView();
+	}
+
+	// FPS may have changed even if the resolution did not, so always notify
+	pThis->OnOutputChanged();
+}
+
+//---------------------------------------------------------------------------
+// XnDepthFilter
+//---------------------------------------------------------------------------
+XnDepthFilter::XnDepthFilter(const XnChar* strName, xn::DepthGenerator& input) :
+	XnFilterGenerator(strName, input),
+	m_depthInput(input),
+	m_hInputFieldOfView(NULL)
+{
+	xnOSMemSet(m_aStageState, 0, sizeof(m_aStageState));
+}
+
+XnDepthFilter::~XnDepthFilter()
+{
+	if (m_hInputFieldOfView != NULL)
+	{
+		m_depthInput.UnregisterFromFieldOfViewChange(m_hInputFieldOfView);
+	}
+
+	FreeStageState();
+}
+
+XnStatus XnDepthFilter::Init(const XnChar* strStages)
+{
+	XnStatus nRetVal = m_depthInput.RegisterToFieldOfViewChange(OnInputFieldOfViewChanged, this, m_hInputFieldOfView);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return XnFilterGenerator::Init(strStages);
+}
+
+XnDepthPixel* XnDepthFilter::GetDepthMap()
+{
+	return (XnDepthPixel*)GetCurrentData();
+}
+
+XnDepthPixel XnDepthFilter::GetDeviceMaxDepth()
+{
+	return m_depthInput.GetDeviceMaxDepth();
+}
+
+void XnDepthFilter::GetFieldOfView(XnFieldOfView& FOV)
+{
+	m_depthInput.GetFieldOfView(FOV);
+
+	XnAutoCSLocker locker(m_hLock);
+	UpdateView();
+
+	// crop and downscale keep the focal point, so the view angle shrinks with the part of the input that's covered
+	if (m_nInputXRes != 0 && m_nInputYRes != 0)
+	{
+		XnDouble dXCoverage = (XnDouble)(m_view.nXRes * (XnUInt32)abs(m_view.nStepX)) / m_nInputXRes;
+		XnDouble dYCoverage = (XnDouble)(m_view.nYRes * (XnUInt32)abs(m_view.nStepY)) / m_nInputYRes;
+		FOV.fHFOV = 2 * atan(tan(FOV.fHFOV / 2) * dXCoverage);
+		FOV.fVFOV = 2 * atan(tan(FOV.fVFOV / 2) * dYCoverage);
+	}
+}
+
+XnStatus XnDepthFilter::RegisterToFieldOfViewChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback)
+{
+	return m_fieldOfViewChangeEvent.Register(handler, pCookie, hCallback);
+}
+
+void XnDepthFilter::UnregisterFromFieldOfViewChange(XnCallbackHandle hCallback)
+{
+	m_fieldOfViewChangeEvent.Unregister(hCallback);
+}
+
+XnStatus XnDepthFilter::OnViewChanged()
+{
+	// temporal state is per output pixel, so it starts over whenever the stages or the resolution change
+	FreeStageState();
+
+	XnUInt32 nPixels = m_view.nXRes * m_view.nYRes;
+	for (XnUInt32 i = 0; i < m_chain.nCount; ++i)
+	{
+		XnUInt32 nHistoryFrames = 0;
+		switch (m_chain.aStages[i].type)
+		{
+		case XN_FILTER_STAGE_MEDIAN:
+			nHistoryFrames = m_chain.aStages[i].aParams[0];
+			break;
+		case XN_FILTER_STAGE_HOLE_FILL:
+			nHistoryFrames = 1;
+			break;
+		default:
+			break;
+		}
+
+		if (nHistoryFrames != 0)
+		{
+			XN_VALIDATE_CALLOC(m_aStageState[i].pHistory, XnDepthPixel, nPixels * nHistoryFrames);
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+void XnDepthFilter::OnOutputChanged()
+{
+	XnFilterGenerator::OnOutputChanged();
+	m_fieldOfViewChangeEvent.Raise();
+}
+
+void XnDepthFilter::ProcessRow(XnUInt32 nRow, void* pRow)
+{
+	XnDepthPixel* pPixels = (XnDepthPixel*)pRow;
+	XnUInt32 nPixels = m_view.nXRes;
+	XnUInt32 nFramePixels = m_view.nXRes * m_view.nYRes;
+
+	for (XnUInt32 i = 0; i < m_chain.nCount; ++i)
+	{
+		const XnFilterStage& stage = m_chain.aStages[i];
+		StageState& state = m_aStageState[i];
+
+		switch (stage.type)
+		{
+		case XN_FILTER_STAGE_THRESHOLD:
+			xnFilterThresholdRow(pPixels, nPixels, (XnDepthPixel)stage.aParams[0], (XnDepthPixel)stage.aParams[1]);
+			break;
+		case XN_FILTER_STAGE_MEDIAN:
+			{
+				// history is a ring of frames. Store this row in the current frame's slot, then take the median 
+				// over the frames seen so far.
+				XnUInt32 nWindow = stage.aParams[0];
+				XnDepthPixel* pHistory = state.pHistory + nRow * nPixels;
+				xnOSMemCopy(pHistory + (state.nFrames % nWindow) * nFramePixels, pPixels, nPixels * sizeof(XnDepthPixel));
+				xnFilterMedianRow(pHistory, nFramePixels, XN_MIN(state.nFrames + 1, nWindow), pPixels, nPixels);
+			}
+			break;
+		case XN_FILTER_STAGE_HOLE_FILL:
+			xnFilterHoleFillRow(pPixels, state.pHistory + nRow * nPixels, nPixels);
+			break;
+		default:
+			// geometric stages were already applied when gathering the row
+			break;
+		}
+	}
+}
+
+void XnDepthFilter::OnFrameProcessed()
+{
+	for (XnUInt32 i = 0; i < m_chain.nCount; ++i)
+	{
+		++m_aStageState[i].nFrames;
+	}
+}
+
+void XnDepthFilter::FreeStageState()
+{
+	for (XnUInt32 i = 0; i < XN_FILTER_MAX_STAGES; ++i)
+	{
+		xnOSFree(m_aStageState[i].pHistory);
+		m_aStageState[i].pHistory = NULL;
+		m_aStageState[i].nFrames = 0;
+	}
+}
+
+void XN_CALLBACK_TYPE XnDepthFilter::OnInputFieldOfViewChanged(xn::ProductionNode& /*node*/, void* pCookie)
+{
+	XnDepthFilter* pThis = (XnDepthFilter*)pCookie;
+	pThis->m_fieldOfViewChangeEvent.Raise();
+}
+
+//---------------------------------------------------------------------------
+// XnImageFilter
+//---------------------------------------------------------------------------
+XnImageFilter::XnImageFilter(const XnChar* strName, xn::ImageGenerator& input) :
+	XnFilterGenerator(strName, input),
+	m_imageInput(input),
+	m_hInputPixelFormat(NULL)
+{
+}
+
+XnImageFilter::~XnImageFilter()
+{
+	if (m_hInputPixelFormat != NULL)
+	{
+		m_imageInput.UnregisterFromPixelFormatChange(m_hInputPixelFormat);
+	}
+}
+
+XnStatus XnImageFilter::Init(const XnChar* strStages)
+{
+	if (!IsInputSupported())
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "%s: Filters do not support %s images", m_strName, xnPixelFormatToString(m_imageInput.GetPixelFormat()));
+	}
+
+	XnStatus nRetVal = m_imageInput.RegisterToPixelFormatChange(OnInputPixelFormatChanged, this, m_hInputPixelFormat);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return XnFilterGenerator::Init(strStages);
+}
+
+XnUInt8* XnImageFilter::GetImageMap()
+{
+	return (XnUInt8*)GetCurrentData();
+}
+
+XnBool XnImageFilter::IsPixelFormatSupported(XnPixelFormat Format)
+{
+	return (Format == m_imageInput.GetPixelFormat());
+}
+
+XnStatus XnImageFilter::SetPixelFormat(XnPixelFormat Format)
+{
+	if (Format != m_imageInput.GetPixelFormat())
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "%s: Filter pixel format is set by its input", m_strName);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnPixelFormat XnImageFilter::GetPixelFormat()
+{
+	return m_imageInput.GetPixelFormat();
+}
+
+XnStatus XnImageFilter::RegisterToPixelFormatChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback)
+{
+	return m_pixelFormatChangeEvent.Register(handler, pCookie, hCallback);
+}
+
+void XnImageFilter::UnregisterFromPixelFormatChange(XnCallbackHandle hCallback)
+{
+	m_pixelFormatChangeEvent.Unregister(hCallback);
+}
+
+XnStatus XnImageFilter::ValidateStages(const XnFilterChain& chain)
+{
+	for (XnUInt32 i = 0; i < chain.nCount; ++i)
+	{
+		switch (chain.aStages[i].type)
+		{
+		case XN_FILTER_STAGE_CROP:
+		case XN_FILTER_STAGE_DOWNSCALE:
+		case XN_FILTER_STAGE_MIRROR:
+			break;
+		default:
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_FILTER, "%s: Image filters only support crop, downscale and mirror stages", m_strName);
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnBool XnImageFilter::IsInputSupported()
+{
+	// compressed and packed formats can't be addressed per pixel
+	XnPixelFormat format = m_imageInput.GetPixelFormat();
+	return (format != XN_PIXEL_FORMAT_YUV422 && format != XN_PIXEL_FORMAT_MJPEG);
+}
+
+void XN_CALLBACK_TYPE XnImageFilter::OnInputPixelFormatChanged(xn::ProductionNode& /*node*/, void* pCookie)
+{
+	XnImageFilter* pThis = (XnImageFilter*)pCookie;
+	pThis->m_pixelFormatChangeEvent.Raise();
+}
@@ -0,0 +1,268 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef __XN_FILTER_NODE_H__
+#define __XN_FILTER_NODE_H__
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnModuleCppInterface.h>
+#include <XnCppWrapper.h>
+#include <XnEventT.h>
+#include <XnFramePool.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_FILTER_MAX_STAGES		16
+#define XN_FILTER_MAX_STAGE_PARAMS	4
+#define XN_FILTER_MAX_DOWNSCALE		16
+#define XN_FILTER_MAX_MEDIAN_FRAMES	9
+#define XN_FILTER_MAX_STAGES_LENGTH	XN_MAX_CREATION_INFO_LENGTH
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef enum XnFilterStageType
+{
+	/** crop:x,y,width,height - keeps a rectangle of the map. **/
+	XN_FILTER_STAGE_CROP,
+	/** downscale:factor - keeps every factor-th pixel in each direction. **/
+	XN_FILTER_STAGE_DOWNSCALE,
+	/** mirror - flips the map horizontally. **/
+	XN_FILTER_STAGE_MIRROR,
+	/** median:frames - per-pixel median of the last frames values (depth only). **/
+	XN_FILTER_STAGE_MEDIAN,
+	/** holefill - replaces zero pixels with the last valid value of that pixel (depth only). **/
+	XN_FILTER_STAGE_HOLE_FILL,
+	/** threshold:min,max - zeroes pixels outside [min, max] (depth only). **/
+	XN_FILTER_STAGE_THRESHOLD,
+} XnFilterStageType;
+
+typedef struct XnFilterStage
+{
+	XnFilterStageType type;
+	XnUInt32 aParams[XN_FILTER_MAX_STAGE_PARAMS];
+} XnFilterStage;
+
+typedef struct XnFilterChain
+{
+	XnFilterStage aStages[XN_FILTER_MAX_STAGES];
+	XnUInt32 nCount;
+} XnFilterChain;
+
+/** 
+ * Where each output pixel is taken from. All geometric stages (crop, downscale, mirror) compose into a 
+ * single view, so output pixel (x,y) is input pixel (nOffsetX + x*nStepX, nOffsetY + y*nStepY).
+ **/
+typedef struct XnFilterView
+{
+	XnInt32 nOffsetX;
+	XnInt32 nOffsetY;
+	XnInt32 nStepX;
+	XnInt32 nStepY;
+	XnUInt32 nXRes;
+	XnUInt32 nYRes;
+} XnFilterView;
+
+XN_PRAGMA_START_DISABLED_WARNING_SECTION(XN_INHERITS_VIA_DOMINANCE_WARNING_ID)
+
+/**
+ * A generator that transforms the output of another map generator. On each update it runs its stage chain 
+ * over the input's current frame in a single pass, writing directly into a pooled output buffer: each output 
+ * row is gathered from the input according to the composed geometric view, and the per-pixel stages are then 
+ * applied to that row while it is still in cache.
+ */
+class XnFilterGenerator :
+	virtual public xn::ModuleMapGenerator,
+	virtual public xn::ModuleFrameLeaseInterface
+{
+public:
+	XnFilterGenerator(const XnChar* strName, xn::MapGenerator& input);
+	virtual ~XnFilterGenerator();
+
+	virtual XnStatus Init(const XnChar* strStages);
+
+	/*ModuleProductionNode*/
+	virtual XnBool IsCapabilitySupported(const XnChar* strCapabilityName);
+	virtual XnStatus SetStringProperty(const XnChar* strName, const XnChar* strValue);
+	virtual XnStatus GetStringProperty(const XnChar* strName, XnChar* csValue, XnUInt32 nBufSize) const;
+
+	/*ModuleGenerator*/
+	virtual XnStatus StartGenerating();
+	virtual XnBool IsGenerating();
+	virtual void StopGenerating();
+	virtual XnStatus RegisterToGenerationRunningChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
+	virtual void UnregisterFromGenerationRunningChange(XnCallbackHandle hCallback);
+	virtual XnStatus RegisterToNewDataAvailable(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
+	virtual void UnregisterFromNewDataAvailable(XnCallbackHandle hCallback);
+	virtual XnBool IsNewDataAvailable(XnUInt64& nTimestamp);
+	virtual XnStatus UpdateData();
+	virtual XnUInt32 GetDataSize();
+	virtual XnUInt64 GetTimestamp();
+	virtual XnUInt32 GetFrameID();
+	virtual xn::ModuleFrameLeaseInterface* GetFrameLeaseInterface();
+
+	/*ModuleMapGenerator*/
+	virtual XnUInt32 GetSupportedMapOutputModesCount();
+	virtual XnStatus GetSupportedMapOutputModes(XnMapOutputMode aModes[], XnUInt32& nCount);
+	virtual XnStatus SetMapOutputMode(const XnMapOutputMode& Mode);
+	virtual XnStatus GetMapOutputMode(XnMapOutputMode& Mode);
+	virtual XnStatus RegisterToMapOutputModeChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
+	virtual void UnregisterFromMapOutputModeChange(XnCallbackHandle hCallback);
+
+	/*ModuleFrameLeaseInterface*/
+	virtual XnStatus AcquireFrame(XnFrameLease& lease);
+	virtual XnStatus ReleaseFrame(const XnFrameLease& lease);
+	virtual XnStatus SetFramePoolPolicy(const XnFramePoolPolicy& policy);
+	virtual XnStatus GetFramePoolPolicy(XnFramePoolPolicy& policy);
+
+	static XnStatus ParseStages(const XnChar* strStages, XnFilterChain& chain);
+	static XnStatus ComputeView(XnUInt32 nInputXRes, XnUInt32 nInputYRes, const XnFilterChain& chain, XnFilterView& view);
+
+protected:
+	typedef XnEventNoArgs PropChangeEvent;
+
+	/** Checks that every stage in the chain can be applied by this node. **/
+	virtual XnStatus ValidateStages(const XnFilterChain& chain);
+	/** Checks that the input's current format can be processed. **/
+	virtual XnBool IsInputSupported();
+	/** Called (under lock) whenever the chain or the output resolution changes, so stage state can be reset. **/
+	virtual XnStatus OnViewChanged();
+	/** Called (without lock) when the output mode changed, to raise the relevant events. **/
+	virtual void OnOutputChanged();
+	/** Applies the per-pixel stages to a single output row. **/
+	virtual void ProcessRow(XnUInt32 nRow, void* pRow);
+	/** Called after all rows of a frame were processed. **/
+	virtual void OnFrameProcessed();
+
+	XnBool UpdateView();
+	const void* GetCurrentData();
+	XnUInt32 GetInputBytesPerPixel();
+	void GetInputResolution(XnUInt32& nXRes, XnUInt32& nYRes);
+
+	XnChar m_strName[XN_MAX_NAME_LENGTH];
+	xn::MapGenerator m_input;
+	XnFilterChain m_chain;
+	XnFilterView m_view;
+	XnUInt32 m_nInputXRes;
+	XnUInt32 m_nInputYRes;
+	XN_CRITICAL_SECTION_HANDLE m_hLock;
+	PropChangeEvent m_mapOutputModeChangeEvent;
+
+private:
+	XnStatus SetStages(const XnChar* strStages);
+	void Process(const XnUInt8* pInput, XnUInt8* pOutput);
+
+	static void XN_CALLBACK_TYPE OnInputNewDataAvailable(xn::ProductionNode& node, void* pCookie);
+	static void XN_CALLBACK_TYPE OnInputGenerationRunningChanged(xn::ProductionNode& node, void* pCookie);
+	static void XN_CALLBACK_TYPE OnInputMapOutputModeChanged(xn::ProductionNode& node, void* pCookie);
+
+	XnChar m_strStages[XN_FILTER_MAX_STAGES_LENGTH];
+	XnBool m_bGenerating;
+	XnUInt32 m_nLastInputFrameID;
+
+	XnFramePool m_pool;
+	XnUInt32 m_nDroppedFrames;
+
+	PropChangeEvent m_generatingChangedEvent;
+	PropChangeEvent m_newDataAvailableEvent;
+
+	XnCallbackHandle m_hInputNewData;
+	XnCallbackHandle m_hInputGenerating;
+	XnCallbackHandle m_hInputOutputMode;
+	XnCallbackHandle m_hInputCropping;
+};
+
+class XnDepthFilter : 
+	public XnFilterGenerator,
+	virtual public xn::ModuleDepthGenerator
+{
+public:
+	XnDepthFilter(const XnChar* strName, xn::DepthGenerator& input);
+	virtual ~XnDepthFilter();
+
+	virtual XnStatus Init(const XnChar* strStages);
+
+	/*ModuleDepthGenerator*/
+	virtual XnDepthPixel* GetDepthMap();
+	virtual XnDepthPixel GetDeviceMaxDepth();
+	virtual void GetFieldOfView(XnFieldOfView& FOV);
+	virtual XnStatus RegisterToFieldOfViewChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
+	virtual void UnregisterFromFieldOfViewChange(XnCallbackHandle hCallback);
+
+protected:
+	virtual XnStatus OnViewChanged();
+	virtual void OnOutputChanged();
+	virtual void ProcessRow(XnUInt32 nRow, void* pRow);
+	virtual void OnFrameProcessed();
+
+private:
+	/** State kept between frames by the temporal stages, one entry per stage of the chain. **/
+	struct StageState
+	{
+		XnDepthPixel* pHistory;
+		XnUInt32 nFrames;
+	};
+
+	void FreeStageState();
+
+	static void XN_CALLBACK_TYPE OnInputFieldOfViewChanged(xn::ProductionNode& node, void* pCookie);
+
+	xn::DepthGenerator m_depthInput;
+	StageState m_aStageState[XN_FILTER_MAX_STAGES];
+	PropChangeEvent m_fieldOfViewChangeEvent;
+	XnCallbackHandle m_hInputFieldOfView;
+};
+
+class XnImageFilter : 
+	public XnFilterGenerator,
+	virtual public xn::ModuleImageGenerator
+{
+public:
+	XnImageFilter(const XnChar* strName, xn::ImageGenerator& input);
+	virtual ~XnImageFilter();
+
+	virtual XnStatus Init(const XnChar* strStages);
+
+	/*ModuleImageGenerator*/
+	virtual XnUInt8* GetImageMap();
+	virtual XnBool IsPixelFormatSupported(XnPixelFormat Format);
+	virtual XnStatus SetPixelFormat(XnPixelFormat Format);
+	virtual XnPixelFormat GetPixelFormat();
+	virtual XnStatus RegisterToPixelFormatChange(XnModuleStateChangedHandler handler, void* pCookie, XnCallbackHandle& hCallback);
+	virtual void UnregisterFromPixelFormatChange(XnCallbackHandle hCallback);
+
+protected:
+	virtual XnStatus ValidateStages(const XnFilterChain& chain);
+	virtual XnBool IsInputSupported();
+
+private:
+	static void XN_CALLBACK_TYPE OnInputPixelFormatChanged(xn::ProductionNode& node, void* pCookie);
+
+	xn::ImageGenerator m_imageInput;
+	PropChangeEvent m_pixelFormatChangeEvent;
+	XnCallbackHandle m_hInputPixelFormat;
+};
+
+XN_PRAGMA_STOP_DISABLED_WARNING_SECTION
+
+#endif // __XN_FILTER_NODE_H__
@@ -0,0 +1,101 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnFilterNodeExporter.h"
+#include "XnFilterNode.h"
+#include <XnInternalDefs.h>
+#include <XnLog.h>
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+XnFilterNodeExporter::XnFilterNodeExporter(XnProductionNodeType type) :
+	m_type(type)
+{
+}
+
+void XnFilterNodeExporter::GetDescription(XnProductionNodeDescription* pDescription)
+{
+	pDescription->Type = m_type;
+	xnGetVersion(&pDescription->Version);
+	strcpy(pDescription->strVendor, XN_VENDOR_OPEN_NI);
+	strcpy(pDescription->strName, XN_FILTER_NODE_NAME);
+}
+
+XnStatus XnFilterNodeExporter::EnumerateProductionTrees(xn::Context& /*context*/, xn::NodeInfoList& /*TreesList*/, xn::EnumerationErrors* /*pErrors*/)
+{
+	// never return any results. Filters are only created explicitly, using xnCreateFilter().
+	return (XN_STATUS_OK);
+}
+
+XnStatus XnFilterNodeExporter::Create(xn::Context& /*context*/, const XnChar* strInstanceName, const XnChar* strCreationInfo, xn::NodeInfoList* pNeededTrees, const XnChar* /*strConfigurationDir*/, xn::ModuleProductionNode** ppInstance)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_OUTPUT_PTR(ppInstance);
+
+	// the input is the (single) needed node
+	if (pNeededTrees == NULL || pNeededTrees->IsEmpty())
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "A filter node requires an input node");
+	}
+
+	xn::NodeInfo inputInfo = *pNeededTrees->Begin();
+	xn::ProductionNode input;
+	nRetVal = inputInfo.GetInstance(input);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (!input.IsValid() || !xnIsTypeDerivedFrom(inputInfo.GetDescription().Type, m_type))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Filter input must be an existing node of the filter's type");
+	}
+
+	XnFilterGenerator* pFilter = NULL;
+	if (m_type == XN_NODE_TYPE_DEPTH)
+	{
+		xn::DepthGenerator depth(input);
+		pFilter = XN_NEW(XnDepthFilter, strInstanceName, depth);
+	}
+	else
+	{
+		xn::ImageGenerator image(input);
+		pFilter = XN_NEW(XnImageFilter, strInstanceName, image);
+	}
+	XN_VALIDATE_ALLOC_PTR(pFilter);
+
+	nRetVal = pFilter->Init(strCreationInfo);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_DELETE(pFilter);
+		return (nRetVal);
+	}
+
+	*ppInstance = pFilter;
+
+	return (XN_STATUS_OK);
+}
+
+void XnFilterNodeExporter::Destroy(xn::ModuleProductionNode* pInstance)
+{
+	XN_DELETE(pInstance);
+}
@@ -31,6 +31,7 @@
 #include <XnBitSet.h>
 #include <XnDump.h>
 #include <XnListT.h>
+#include "XnMetricsInternal.h"
 
 #define XN_OPEN_NI_XML_ROOT_NAME	"OpenNI"
 
@@ -170,6 +171,7 @@ struct XnInternalNodeData
 	XnCallbackHandle hFrameSyncCallback;
 	XnFPSData genFPS;
 	XnFPSData readFPS;
+	XnNodeMetricsData metrics;
 	union
 	{
 		XnDepthMetaData* Depth;
@@ -222,6 +224,7 @@ typedef XnEvent1Arg<XnStatus> XnErrorStateChangedEvent;
 typedef XnEvent1Arg<XnContext*> XnContextShuttingDownEvent;
 typedef XnEvent2Args<XnContext*, XnNodeHandle> XnNodeCreationEvent;
 typedef XnEvent2Args<XnContext*, const XnChar*> XnNodeDestructionEvent;
+typedef XnListT<XnNodeHandle> XnPlayersList;
 
 class XnModuleLoader;
 
@@ -240,8 +243,10 @@ struct XnContext
 		pOwnedNodes(NULL),
 		pDumpRefCount(NULL),
 		pDumpDataFlow(NULL),
-		hPlayerNode(NULL)
-	{}
+		pMetricsExporter(NULL)
+	{
+		xnOSMemSet(&waitLatency, 0, sizeof(waitLatency));
+	}
 
 	XnLicenseList licenses;
 	XnModuleLoader moduleLoader;
@@ -261,7 +266,9 @@ struct XnContext
 	XnDumpFile* pDumpRefCount;
 	XnDumpFile* pDumpDataFlow;
 	XnContextShuttingDownEvent shutdownEvent;
-	XnNodeHandle hPlayerNode; // For now, we only support one player at a time
+	XnPlayersList playerNodes; // when more than one, playback is merged by timestamp
+	XnLatencyMetricsData waitLatency;
+	XnMetricsExporter* pMetricsExporter;
 };
 
 struct XnNodeInfo
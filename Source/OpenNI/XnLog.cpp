@@ -26,6 +26,7 @@
 #include <XnVersion.h>
 #include <stdarg.h>
 #include "XnXml.h"
+#include "xnInternalFuncs.h"
 #include <XnListT.h>
 #include <XnArray.h>
 #include <XnOSCpp.h>
@@ -475,7 +476,16 @@ XN_C_API XnStatus xnLogInitFromXmlFile(const XnChar* strFileName)
 	nRetVal = xnXmlLoadDocument(doc, strFileName);
 	XN_IS_STATUS_OK(nRetVal);
 
-	TiXmlElement* pRootElem = doc.RootElement();
+	return xnLogInitFromXml(doc.RootElement());
+}
+
+XnStatus xnLogInitFromXml(TiXmlElement* pRootElem)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = xnLogInitSystem();
+	XN_IS_STATUS_OK(nRetVal);
+
 	if (pRootElem != NULL)
 	{
 		TiXmlElement* pLog = pRootElem->FirstChildElement("Log");
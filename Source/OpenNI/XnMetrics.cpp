@@ -0,0 +1,629 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnInternalTypes.h"
+#include <XnOpenNI.h>
+#include <XnLog.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_METRICS						"Metrics"
+/** The exporter thread blocks for no longer than this, so that it notices when it should stop. **/
+#define XN_METRICS_POLL_TIMEOUT				100
+/** For the whole request, however slowly the client sends it. **/
+#define XN_METRICS_REQUEST_TIMEOUT			500
+#define XN_METRICS_INITIAL_BUFFER_SIZE		(16 * 1024)
+#define XN_METRICS_MAX_BUFFER_SIZE			(16 * 1024 * 1024)
+#define XN_METRICS_MAX_REQUEST_SIZE			4096
+#define XN_METRICS_MAX_LABEL_LENGTH			(XN_MAX_NAME_LENGTH * 2)
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef enum XnMetricKind
+{
+	XN_METRIC_COUNTER,
+	XN_METRIC_GAUGE,
+	/** An XnLatencyMetrics. Written as a summary (in seconds), followed by a gauge of its maximum. **/
+	XN_METRIC_LATENCY,
+} XnMetricKind;
+
+/** A Prometheus metric family, with one sample per node of a certain type. **/
+typedef struct XnMetricFamily
+{
+	const XnChar* strName;
+	const XnChar* strHelp;
+	XnMetricKind kind;
+	/** Only nodes of this type (or derived from it) have this metric. **/
+	XnProductionNodeType nodeType;
+	/** Offset of the value in XnNodeMetrics. **/
+	XnSizeT nOffset;
+} XnMetricFamily;
+
+/** Formats text into a fixed buffer, remembering if it ran out of space. **/
+typedef struct XnMetricsWriter
+{
+	XnChar* csBuffer;
+	XnUInt32 nBufferSize;
+	XnUInt32 nUsed;
+	XnStatus nStatus;
+} XnMetricsWriter;
+
+struct XnMetricsExporter
+{
+	XnContext* pContext;
+	XN_SOCKET_HANDLE hListenSocket;
+	XnBool bBound;
+	XN_THREAD_HANDLE hThread;
+	volatile XnBool bStop;
+	XnChar strSocketPath[XN_FILE_MAX_PATH];
+	XnChar* pBuffer;
+	XnUInt32 nBufferSize;
+};
+
+//---------------------------------------------------------------------------
+// Global Variables
+//---------------------------------------------------------------------------
+static const XnMetricFamily g_aNodeMetricFamilies[] =
+{
+	{ "openni_node_frames_generated_total", "Frames a generator reported as new data.", XN_METRIC_COUNTER, XN_NODE_TYPE_GENERATOR, offsetof(XnNodeMetrics, nFramesGenerated) },
+	{ "openni_node_frames_consumed_total", "Frames the application received by updating a generator.", XN_METRIC_COUNTER, XN_NODE_TYPE_GENERATOR, offsetof(XnNodeMetrics, nFramesConsumed) },
+	{ "openni_node_frames_skipped_total", "Frames replaced by newer ones before the generator was updated.", XN_METRIC_COUNTER, XN_NODE_TYPE_GENERATOR, offsetof(XnNodeMetrics, nFramesSkipped) },
+	{ "openni_node_bytes_consumed_total", "Bytes the application received by updating a generator.", XN_METRIC_COUNTER, XN_NODE_TYPE_GENERATOR, offsetof(XnNodeMetrics, nBytesConsumed) },
+	{ "openni_node_update_seconds", "Time spent updating a generator's data.", XN_METRIC_LATENCY, XN_NODE_TYPE_GENERATOR, offsetof(XnNodeMetrics, updateLatency) },
+	{ "openni_node_data_latency_seconds", "Time from a generator reporting new data until it was updated.", XN_METRIC_LATENCY, XN_NODE_TYPE_GENERATOR, offsetof(XnNodeMetrics, dataLatency) },
+	{ "openni_codec_encode_seconds", "Time spent compressing data.", XN_METRIC_LATENCY, XN_NODE_TYPE_CODEC, offsetof(XnNodeMetrics, encodeLatency) },
+	{ "openni_codec_decode_seconds", "Time spent decompressing data.", XN_METRIC_LATENCY, XN_NODE_TYPE_CODEC, offsetof(XnNodeMetrics, decodeLatency) },
+	{ "openni_recorder_record_seconds", "Time spent recording a frame.", XN_METRIC_LATENCY, XN_NODE_TYPE_RECORDER, offsetof(XnNodeMetrics, recordLatency) },
+	{ "openni_recorder_queued_bytes", "Bytes recorded but not yet written to the destination.", XN_METRIC_GAUGE, XN_NODE_TYPE_RECORDER, offsetof(XnNodeMetrics, nQueuedBytes) },
+	{ "openni_recorder_queued_bytes_peak", "Highest number of bytes that waited to be written to the destination.", XN_METRIC_GAUGE, XN_NODE_TYPE_RECORDER, offsetof(XnNodeMetrics, nMaxQueuedBytes) },
+};
+
+//---------------------------------------------------------------------------
+// Counters
+//---------------------------------------------------------------------------
+void xnMetricsMarkNewData(XnNodeMetricsData* pMetrics)
+{
+	XnUInt64 nNow;
+	xnOSGetHighResTimeStamp(&nNow);
+
+	xnMetricsAdd(&pMetrics->nFramesGenerated, 1);
+	xnMetricsExchange(&pMetrics->nNewDataTime, nNow);
+}
+
+void xnMetricsMarkUpdate(XnNodeMetricsData* pMetrics, XnUInt64 nStart, XnUInt64 nEnd, XnUInt32 nFrameID, XnUInt32 nDataSize)
+{
+	xnMetricsAddLatency(&pMetrics->updateLatency, nEnd - nStart);
+
+	if (nFrameID == pMetrics->nLastFrameID)
+	{
+		// no new frame
+		return;
+	}
+
+	xnMetricsAdd(&pMetrics->nFramesConsumed, 1);
+	xnMetricsAdd(&pMetrics->nBytesConsumed, nDataSize);
+
+	// frame IDs go back when a recording is rewound, and those frames aren't skipped
+	if (pMetrics->nLastFrameID != 0 && nFrameID > pMetrics->nLastFrameID + 1)
+	{
+		xnMetricsAdd(&pMetrics->nFramesSkipped, nFrameID - pMetrics->nLastFrameID - 1);
+	}
+	pMetrics->nLastFrameID = nFrameID;
+
+	XnUInt64 nNewDataTime = xnMetricsExchange(&pMetrics->nNewDataTime, 0);
+	if (nNewDataTime != 0 && nNewDataTime <= nEnd)
+	{
+		xnMetricsAddLatency(&pMetrics->dataLatency, nEnd - nNewDataTime);
+	}
+}
+
+static void xnMetricsReadNode(XnInternalNodeData* pNode, XnNodeMetrics* pMetrics)
+{
+	XnNodeMetricsData* pData = &pNode->metrics;
+
+	xnOSStrCopy(pMetrics->strName, pNode->pNodeInfo->strInstanceName, sizeof(pMetrics->strName));
+	pMetrics->type = pNode->pNodeInfo->Description.Type;
+	pMetrics->nFramesGenerated = xnMetricsRead(&pData->nFramesGenerated);
+	pMetrics->nFramesConsumed = xnMetricsRead(&pData->nFramesConsumed);
+	pMetrics->nFramesSkipped = xnMetricsRead(&pData->nFramesSkipped);
+	pMetrics->nBytesConsumed = xnMetricsRead(&pData->nBytesConsumed);
+	xnMetricsReadLatency(&pData->updateLatency, &pMetrics->updateLatency);
+	xnMetricsReadLatency(&pData->dataLatency, &pMetrics->dataLatency);
+	xnMetricsReadLatency(&pData->encodeLatency, &pMetrics->encodeLatency);
+	xnMetricsReadLatency(&pData->decodeLatency, &pMetrics->decodeLatency);
+	xnMetricsReadLatency(&pData->recordLatency, &pMetrics->recordLatency);
+	pMetrics->nQueuedBytes = xnMetricsRead(&pData->nQueuedBytes);
+	pMetrics->nMaxQueuedBytes = xnMetricsRead(&pData->nMaxQueuedBytes);
+}
+
+XN_C_API XnStatus xnGetContextMetrics(XnContext* pContext, XnContextMetrics* pMetrics, XnNodeMetrics* aNodes, XnUInt32* pnNodes)
+{
+	XN_VALIDATE_INPUT_PTR(pContext);
+	XN_VALIDATE_OUTPUT_PTR(pMetrics);
+
+	// nodes are only added to and removed from the map under the context lock
+	XnAutoCSLocker locker(pContext->hLock);
+
+	xnOSGetHighResTimeStamp(&pMetrics->nTimestamp);
+	pMetrics->nNodeCount = pContext->nodesMap.Size();
+	xnMetricsReadLatency(&pContext->waitLatency, &pMetrics->waitLatency);
+
+	if (aNodes == NULL || pnNodes == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	XnUInt32 nWritten = 0;
+	for (XnNodesMap::ConstIterator it = pContext->nodesMap.Begin(); it != pContext->nodesMap.End() && nWritten < *pnNodes; ++it)
+	{
+		xnMetricsReadNode(it->Value(), &aNodes[nWritten]);
+		++nWritten;
+	}
+
+	*pnNodes = nWritten;
+
+	if (nWritten < pMetrics->nNodeCount)
+	{
+		return (XN_STATUS_OUTPUT_BUFFER_OVERFLOW);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnGetNodeMetrics(XnNodeHandle hNode, XnNodeMetrics* pMetrics)
+{
+	XN_VALIDATE_INPUT_PTR(hNode);
+	XN_VALIDATE_OUTPUT_PTR(pMetrics);
+
+	xnMetricsReadNode(hNode, pMetrics);
+
+	return (XN_STATUS_OK);
+}
+
+//---------------------------------------------------------------------------
+// Prometheus Format
+//---------------------------------------------------------------------------
+static void xnMetricsWrite(XnMetricsWriter* pWriter, const XnChar* csFormat, ...)
+{
+	if (pWriter->nStatus != XN_STATUS_OK)
+	{
+		return;
+	}
+
+	XnUInt32 nRemaining = pWriter->nBufferSize - pWriter->nUsed;
+	XnUInt32 nWritten = 0;
+
+	va_list args;
+	va_start(args, csFormat);
+	XnStatus nRetVal = xnOSStrFormatV(pWriter->csBuffer + pWriter->nUsed, nRemaining, &nWritten, csFormat, args);
+	va_end(args);
+
+	// some platforms report the length a truncated string would have had
+	if (nRetVal != XN_STATUS_OK || nWritten >= nRemaining)
+	{
+		pWriter->nStatus = XN_STATUS_OUTPUT_BUFFER_OVERFLOW;
+		return;
+	}
+
+	pWriter->nUsed += nWritten;
+}
+
+static void xnMetricsEscapeLabel(const XnChar* strValue, XnChar* strEscaped, XnUInt32 nSize)
+{
+	XnUInt32 nUsed = 0;
+	for (const XnChar* p = strValue; *p != '\0' && nUsed + 2 < nSize; ++p)
+	{
+		if (*p == '\\' || *p == '"')
+		{
+			strEscaped[nUsed++] = '\\';
+			strEscaped[nUsed++] = *p;
+		}
+		else if (*p == '\n')
+		{
+			strEscaped[nUsed++] = '\\';
+			strEscaped[nUsed++] = 'n';
+		}
+		else
+		{
+			strEscaped[nUsed++] = *p;
+		}
+	}
+	strEscaped[nUsed] = '\0';
+}
+
+static void xnMetricsWriteHeader(XnMetricsWriter* pWriter, const XnChar* strName, const XnChar* strHelp, const XnChar* strType)
+{
+	xnMetricsWrite(pWriter, "# HELP %s %s\n# TYPE %s %s\n", strName, strHelp, strName, strType);
+}
+
+static void xnMetricsWriteLatency(XnMetricsWriter* pWriter, const XnChar* strName, const XnChar* strLabels, const XnLatencyMetrics* pLatency)
+{
+	xnMetricsWrite(pWriter, "%s_sum%s %.6f\n", strName, strLabels, pLatency->nTotal / 1e6);
+	xnMetricsWrite(pWriter, "%s_count%s %llu\n", strName, strLabels, pLatency->nCount);
+}
+
+static void xnMetricsWriteNodeFamily(XnMetricsWriter* pWriter, const XnMetricFamily* pFamily, const XnNodeMetrics* aNodes, XnUInt32 nNodes)
+{
+	XnBool bHasNodes = FALSE;
+	for (XnUInt32 i = 0; i < nNodes; ++i)
+	{
+		if (xnIsTypeDerivedFrom(aNodes[i].type, pFamily->nodeType))
+		{
+			bHasNodes = TRUE;
+			break;
+		}
+	}
+
+	if (!bHasNodes)
+	{
+		return;
+	}
+
+	XnChar strLabels[XN_METRICS_MAX_LABEL_LENGTH + 64];
+	XnChar strEscaped[XN_METRICS_MAX_LABEL_LENGTH];
+	XnUInt32 nWritten;
+
+	switch (pFamily->kind)
+	{
+	case XN_METRIC_COUNTER:
+		xnMetricsWriteHeader(pWriter, pFamily->strName, pFamily->strHelp, "counter");
+		break;
+	case XN_METRIC_GAUGE:
+		xnMetricsWriteHeader(pWriter, pFamily->strName, pFamily->strHelp, "gauge");
+		break;
+	case XN_METRIC_LATENCY:
+		xnMetricsWriteHeader(pWriter, pFamily->strName, pFamily->strHelp, "summary");
+		break;
+	}
+
+	for (XnUInt32 i = 0; i < nNodes; ++i)
+	{
+		if (!xnIsTypeDerivedFrom(aNodes[i].type, pFamily->nodeType))
+		{
+			continue;
+		}
+
+		xnMetricsEscapeLabel(aNodes[i].strName, strEscaped, sizeof(strEscaped));
+		xnOSStrFormat(strLabels, sizeof(strLabels), &nWritten, "{node=\"%s\",type=\"%s\"}", strEscaped, xnProductionNodeTypeToString(aNodes[i].type));
+
+		const XnUChar* pValue = (const XnUChar*)&aNodes[i] + pFamily->nOffset;
+		if (pFamily->kind == XN_METRIC_LATENCY)
+		{
+			xnMetricsWriteLatency(pWriter, pFamily->strName, strLabels, (const XnLatencyMetrics*)pValue);
+		}
+		else
+		{
+			xnMetricsWrite(pWriter, "%s%s %llu\n", pFamily->strName, strLabels, *(const XnUInt64*)pValue);
+		}
+	}
+
+	if (pFamily->kind == XN_METRIC_LATENCY)
+	{
+		xnMetricsWrite(pWriter, "# HELP %s_max Longest of: %s\n# TYPE %s_max gauge\n", pFamily->strName, pFamily->strHelp, pFamily->strName);
+		for (XnUInt32 i = 0; i < nNodes; ++i)
+		{
+			if (!xnIsTypeDerivedFrom(aNodes[i].type, pFamily->nodeType))
+			{
+				continue;
+			}
+
+			xnMetricsEscapeLabel(aNodes[i].strName, strEscaped, sizeof(strEscaped));
+			const XnLatencyMetrics* pLatency = (const XnLatencyMetrics*)((const XnUChar*)&aNodes[i] + pFamily->nOffset);
+			xnMetricsWrite(pWriter, "%s_max{node=\"%s\",type=\"%s\"} %.6f\n", pFamily->strName, strEscaped, xnProductionNodeTypeToString(aNodes[i].type), pLatency->nMax / 1e6);
+		}
+	}
+}
+
+XN_C_API XnStatus xnFormatContextMetrics(XnContext* pContext, XnChar* csBuffer, XnUInt32 nBufferSize, XnUInt32* pnWritten)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pContext);
+	XN_VALIDATE_OUTPUT_PTR(csBuffer);
+	XN_VALIDATE_OUTPUT_PTR(pnWritten);
+
+	*pnWritten = 0;
+
+	XnContextMetrics context;
+	nRetVal = xnGetContextMetrics(pContext, &context, NULL, NULL);
+	XN_IS_STATUS_OK(nRetVal);
+
+	// leave room for nodes created in the meantime. Any created after that are reported next time.
+	XnUInt32 nNodes = context.nNodeCount + 8;
+	XnNodeMetrics* aNodes = (XnNodeMetrics*)xnOSMalloc(nNodes * sizeof(XnNodeMetrics));
+	XN_VALIDATE_ALLOC_PTR(aNodes);
+
+	nRetVal = xnGetContextMetrics(pContext, &context, aNodes, &nNodes);
+	if (nRetVal != XN_STATUS_OK && nRetVal != XN_STATUS_OUTPUT_BUFFER_OVERFLOW)
+	{
+		xnOSFree(aNodes);
+		return (nRetVal);
+	}
+
+	XnMetricsWriter writer = { csBuffer, nBufferSize, 0, XN_STATUS_OK };
+
+	xnMetricsWriteHeader(&writer, "openni_nodes", "Number of nodes in the context.", "gauge");
+	xnMetricsWrite(&writer, "openni_nodes %u\n", context.nNodeCount);
+
+	xnMetricsWriteHeader(&writer, "openni_wait_seconds", "Time the application spent waiting for data.", "summary");
+	xnMetricsWriteLatency(&writer, "openni_wait_seconds", "", &context.waitLatency);
+	xnMetricsWriteHeader(&writer, "openni_wait_seconds_max", "Longest time the application waited for data.", "gauge");
+	xnMetricsWrite(&writer, "openni_wait_seconds_max %.6f\n", context.waitLatency.nMax / 1e6);
+
+	for (XnUInt32 i = 0; i < sizeof(g_aNodeMetricFamilies) / sizeof(g_aNodeMetricFamilies[0]); ++i)
+	{
+		xnMetricsWriteNodeFamily(&writer, &g_aNodeMetricFamilies[i], aNodes, nNodes);
+	}
+
+	xnOSFree(aNodes);
+
+	XN_IS_STATUS_OK(writer.nStatus);
+
+	*pnWritten = writer.nUsed;
+
+	return (XN_STATUS_OK);
+}
+
+//---------------------------------------------------------------------------
+// Exporter
+//---------------------------------------------------------------------------
+static XnStatus xnMetricsExporterFormat(XnMetricsExporter* pExporter, XnUInt32* pnWritten)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	for (;;)
+	{
+		nRetVal = xnFormatContextMetrics(pExporter->pContext, pExporter->pBuffer, pExporter->nBufferSize, pnWritten);
+		if (nRetVal != XN_STATUS_OUTPUT_BUFFER_OVERFLOW || pExporter->nBufferSize >= XN_METRICS_MAX_BUFFER_SIZE)
+		{
+			return (nRetVal);
+		}
+
+		// the buffer is kept for next time, so this only happens while the graph grows
+		XnChar* pBuffer = (XnChar*)xnOSMalloc(pExporter->nBufferSize * 2);
+		XN_VALIDATE_ALLOC_PTR(pBuffer);
+		xnOSFree(pExporter->pBuffer);
+		pExporter->pBuffer = pBuffer;
+		pExporter->nBufferSize *= 2;
+	}
+}
+
+/** Answers a client. Returns without answering if the exporter is stopped meanwhile. **/
+static void xnMetricsExporterServe(XnMetricsExporter* pExporter, XN_SOCKET_HANDLE hClient)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// read the request (its content doesn't matter, there's only one thing to get). Clients that don't
+	// send one still get an answer, once the timeout passes.
+	XnUInt64 nNow;
+	xnOSGetTimeStamp(&nNow);
+	XnUInt64 nDeadline = nNow + XN_METRICS_REQUEST_TIMEOUT;
+
+	XnChar request[XN_METRICS_MAX_REQUEST_SIZE + 1];
+	XnUInt32 nRequestSize = 0;
+	while (nRequestSize < XN_METRICS_MAX_REQUEST_SIZE && !pExporter->bStop)
+	{
+		xnOSGetTimeStamp(&nNow);
+		if (nNow >= nDeadline)
+		{
+			break;
+		}
+
+		XnUInt32 nRead = XN_METRICS_MAX_REQUEST_SIZE - nRequestSize;
+		nRetVal = xnOSReceiveNetworkBuffer(hClient, request + nRequestSize, &nRead, (XnUInt32)XN_MIN(nDeadline - nNow, XN_METRICS_POLL_TIMEOUT));
+		if (nRetVal == XN_STATUS_OS_NETWORK_TIMEOUT)
+		{
+			continue;
+		}
+		else if (nRetVal != XN_STATUS_OK)
+		{
+			break;
+		}
+
+		nRequestSize += nRead;
+		request[nRequestSize] = '\0';
+		if (strstr(request, "\r\n\r\n") != NULL || strstr(request, "\n\n") != NULL)
+		{
+			break;
+		}
+	}
+
+	if (pExporter->bStop)
+	{
+		return;
+	}
+
+	XnUInt32 nBodySize = 0;
+	nRetVal = xnMetricsExporterFormat(pExporter, &nBodySize);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogWarning(XN_MASK_METRICS, "Failed to format metrics: %s", xnGetStatusString(nRetVal));
+		const XnChar* strError = "HTTP/1.0 500 Internal Server Error\r\nConnection: close\r\n\r\n";
+		xnOSSendNetworkBuffer(hClient, strError, xnOSStrLen(strError));
+		return;
+	}
+
+	XnChar strHeader[256];
+	XnUInt32 nHeaderSize = 0;
+	xnOSStrFormat(strHeader, sizeof(strHeader), &nHeaderSize, 
+		"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %u\r\nConnection: close\r\n\r\n", nBodySize);
+
+	nRetVal = xnOSSendNetworkBuffer(hClient, strHeader, nHeaderSize);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSSendNetworkBuffer(hClient, pExporter->pBuffer, nBodySize);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogVerbose(XN_MASK_METRICS, "Failed to send metrics: %s", xnGetStatusString(nRetVal));
+	}
+}
+
+XN_THREAD_PROC xnMetricsExporterThread(XN_THREAD_PARAM pThreadParam)
+{
+	XnMetricsExporter* pExporter = (XnMetricsExporter*)pThreadParam;
+
+	while (!pExporter->bStop)
+	{
+		XN_SOCKET_HANDLE hClient = NULL;
+		XnStatus nRetVal = xnOSAcceptSocket(pExporter->hListenSocket, &hClient, XN_METRICS_POLL_TIMEOUT);
+		if (nRetVal == XN_STATUS_OS_NETWORK_TIMEOUT)
+		{
+			continue;
+		}
+		else if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_METRICS, "Failed to accept a connection: %s", xnGetStatusString(nRetVal));
+			xnOSSleep(XN_METRICS_POLL_TIMEOUT);
+			continue;
+		}
+
+		xnMetricsExporterServe(pExporter, hClient);
+		xnOSCloseSocket(hClient);
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+void xnMetricsExporterDestroy(XnMetricsExporter** ppExporter)
+{
+	XnMetricsExporter* pExporter = *ppExporter;
+	if (pExporter == NULL)
+	{
+		return;
+	}
+
+	if (pExporter->hThread != NULL)
+	{
+		// the thread may hold the context lock, so it can't be killed. It notices this within a poll timeout.
+		pExporter->bStop = TRUE;
+		xnOSWaitForThreadExit(pExporter->hThread, XN_WAIT_INFINITE);
+		xnOSCloseThread(&pExporter->hThread);
+	}
+
+	if (pExporter->hListenSocket != NULL)
+	{
+		xnOSCloseSocket(pExporter->hListenSocket);
+	}
+
+	if (pExporter->bBound)
+	{
+		xnOSDeleteFile(pExporter->strSocketPath);
+	}
+
+	xnOSFree(pExporter->pBuffer);
+	xnOSFree(pExporter);
+
+	*ppExporter = NULL;
+}
+
+XN_C_API XnStatus xnStartMetricsExporter(XnContext* pContext, const XnChar* strSocketPath)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pContext);
+	XN_VALIDATE_INPUT_PTR(strSocketPath);
+
+	XnAutoCSLocker locker(pContext->hLock);
+
+	if (pContext->pMetricsExporter != NULL)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_METRICS, "Metrics are already exported on '%s'", pContext->pMetricsExporter->strSocketPath);
+	}
+
+	XnMetricsExporter* pExporter = NULL;
+	XN_VALIDATE_CALLOC(pExporter, XnMetricsExporter, 1);
+	pExporter->pContext = pContext;
+
+	nRetVal = xnOSStrCopy(pExporter->strSocketPath, strSocketPath, sizeof(pExporter->strSocketPath));
+	if (nRetVal == XN_STATUS_OK)
+	{
+		pExporter->pBuffer = (XnChar*)xnOSMalloc(XN_METRICS_INITIAL_BUFFER_SIZE);
+		pExporter->nBufferSize = XN_METRICS_INITIAL_BUFFER_SIZE;
+		if (pExporter->pBuffer == NULL)
+		{
+			nRetVal = XN_STATUS_ALLOC_FAILED;
+		}
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSCreateSocket(XN_OS_LOCAL_SOCKET, strSocketPath, 0, &pExporter->hListenSocket);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			pExporter->hListenSocket = NULL;
+		}
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSBindSocket(pExporter->hListenSocket);
+		pExporter->bBound = (nRetVal == XN_STATUS_OK);
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSListenSocket(pExporter->hListenSocket);
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSCreateThread(xnMetricsExporterThread, (XN_THREAD_PARAM)pExporter, &pExporter->hThread);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnMetricsExporterDestroy(&pExporter);
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_METRICS, "Failed to export metrics on '%s': %s", strSocketPath, xnGetStatusString(nRetVal));
+	}
+
+	xnOSApplyThreadPolicy(pExporter->hThread, XN_THREAD_ROLE_METRICS, "XnMetrics");
+
+	pContext->pMetricsExporter = pExporter;
+
+	xnLogInfo(XN_MASK_METRICS, "Exporting metrics on '%s'", strSocketPath);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnStopMetricsExporter(XnContext* pContext)
+{
+	XN_VALIDATE_INPUT_PTR(pContext);
+
+	XnMetricsExporter* pExporter = NULL;
+	{
+		XnAutoCSLocker locker(pContext->hLock);
+		pExporter = pContext->pMetricsExporter;
+		pContext->pMetricsExporter = NULL;
+	}
+
+	// the exporter thread takes the context lock to read the metrics, so it must not be held while stopping it
+	xnMetricsExporterDestroy(&pExporter);
+
+	return (XN_STATUS_OK);
+}
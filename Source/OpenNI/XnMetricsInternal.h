@@ -0,0 +1,152 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef __XN_METRICS_INTERNAL_H__
+#define __XN_METRICS_INTERNAL_H__
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include <XnTypes.h>
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+// Counters are updated by the threads that do the work (application, USB, playback, recording), and read by
+// whoever takes a snapshot. All updates are atomic, so no lock is taken on the data path.
+
+typedef struct XnLatencyMetricsData
+{
+	volatile XnUInt64 nCount;
+	volatile XnUInt64 nTotal;
+	volatile XnUInt64 nMax;
+} XnLatencyMetricsData;
+
+typedef struct XnNodeMetricsData
+{
+	volatile XnUInt64 nFramesGenerated;
+	volatile XnUInt64 nFramesConsumed;
+	volatile XnUInt64 nFramesSkipped;
+	volatile XnUInt64 nBytesConsumed;
+	XnLatencyMetricsData updateLatency;
+	XnLatencyMetricsData dataLatency;
+	XnLatencyMetricsData encodeLatency;
+	XnLatencyMetricsData decodeLatency;
+	XnLatencyMetricsData recordLatency;
+	volatile XnUInt64 nQueuedBytes;
+	volatile XnUInt64 nMaxQueuedBytes;
+	/** Time the node last reported new data, or 0 once that data was consumed. **/
+	volatile XnUInt64 nNewDataTime;
+	/** ID of the last consumed frame. Only touched by the updating thread. **/
+	XnUInt32 nLastFrameID;
+} XnNodeMetricsData;
+
+struct XnMetricsExporter; // forward declaration
+
+//---------------------------------------------------------------------------
+// Atomic Operations
+//---------------------------------------------------------------------------
+inline XnUInt64 xnMetricsRead(volatile XnUInt64* pCounter)
+{
+#if (XN_PLATFORM == XN_PLATFORM_WIN32)
+	return (XnUInt64)InterlockedCompareExchange64((volatile LONGLONG*)pCounter, 0, 0);
+#else
+	return __sync_add_and_fetch(pCounter, 0);
+#endif
+}
+
+inline void xnMetricsAdd(volatile XnUInt64* pCounter, XnUInt64 nValue)
+{
+#if (XN_PLATFORM == XN_PLATFORM_WIN32)
+	InterlockedExchangeAdd64((volatile LONGLONG*)pCounter, (LONGLONG)nValue);
+#else
+	__sync_fetch_and_add(pCounter, nValue);
+#endif
+}
+
+inline XnUInt64 xnMetricsExchange(volatile XnUInt64* pCounter, XnUInt64 nValue)
+{
+#if (XN_PLATFORM == XN_PLATFORM_WIN32)
+	return (XnUInt64)InterlockedExchange64((volatile LONGLONG*)pCounter, (LONGLONG)nValue);
+#else
+	return __sync_lock_test_and_set(pCounter, nValue);
+#endif
+}
+
+inline void xnMetricsRaiseMax(volatile XnUInt64* pMax, XnUInt64 nValue)
+{
+	XnUInt64 nCurrent = xnMetricsRead(pMax);
+	while (nValue > nCurrent)
+	{
+#if (XN_PLATFORM == XN_PLATFORM_WIN32)
+		XnUInt64 nPrev = (XnUInt64)InterlockedCompareExchange64((volatile LONGLONG*)pMax, (LONGLONG)nValue, (LONGLONG)nCurrent);
+#else
+		XnUInt64 nPrev = __sync_val_compare_and_swap(pMax, nCurrent, nValue);
+#endif
+		if (nPrev == nCurrent)
+		{
+			break;
+		}
+		nCurrent = nPrev;
+	}
+}
+
+inline void xnMetricsAddLatency(XnLatencyMetricsData* pLatency, XnUInt64 nDuration)
+{
+	xnMetricsAdd(&pLatency->nCount, 1);
+	xnMetricsAdd(&pLatency->nTotal, nDuration);
+	xnMetricsRaiseMax(&pLatency->nMax, nDuration);
+}
+
+inline void xnMetricsReadLatency(XnLatencyMetricsData* pData, XnLatencyMetrics* pLatency)
+{
+	pLatency->nCount = xnMetricsRead(&pData->nCount);
+	pLatency->nTotal = xnMetricsRead(&pData->nTotal);
+	pLatency->nMax = xnMetricsRead(&pData->nMax);
+}
+
+inline void xnMetricsSetQueuedBytes(XnNodeMetricsData* pMetrics, XnUInt64 nBytes)
+{
+	xnMetricsExchange(&pMetrics->nQueuedBytes, nBytes);
+	xnMetricsRaiseMax(&pMetrics->nMaxQueuedBytes, nBytes);
+}
+
+//---------------------------------------------------------------------------
+// Functions
+//---------------------------------------------------------------------------
+/** Called when a generator reports new data. **/
+void xnMetricsMarkNewData(XnNodeMetricsData* pMetrics);
+
+/** 
+* Called after a generator was updated. 
+*
+* @param	pMetrics	[in]	The node's counters.
+* @param	nStart		[in]	When the update started.
+* @param	nEnd		[in]	When the update ended.
+* @param	nFrameID	[in]	ID of the frame the node now holds.
+* @param	nDataSize	[in]	Size of that frame.
+*/
+void xnMetricsMarkUpdate(XnNodeMetricsData* pMetrics, XnUInt64 nStart, XnUInt64 nEnd, XnUInt32 nFrameID, XnUInt32 nDataSize);
+
+/** Stops the exporter of a context, if there is one. Called when the context is destroyed. **/
+void xnMetricsExporterDestroy(XnMetricsExporter** ppExporter);
+
+#endif // __XN_METRICS_INTERNAL_H__
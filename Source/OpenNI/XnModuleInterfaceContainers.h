@@ -96,12 +96,15 @@ public:
 		Generator.pAlternativeViewPointInterface = &AlternativeViewPoint;
 		xnOSMemSet(&FrameSync, 0, sizeof(FrameSync));
 		Generator.pFrameSyncInterface = &FrameSync;
+		xnOSMemSet(&FrameLease, 0, sizeof(FrameLease));
+		Generator.pFrameLeaseInterface = &FrameLease;
 		HierarchyType.Set(XN_NODE_TYPE_GENERATOR, TRUE);
 	}
 	XnModuleGeneratorInterface Generator;
 	XnModuleMirrorInterface Mirror;
 	XnModuleAlternativeViewPointInterface AlternativeViewPoint;
 	XnModuleFrameSyncInterface FrameSync;
+	XnModuleFrameLeaseInterface FrameLease;
 };
 
 class XnRecorderInterfaceContainer : public XnProductionNodeInterfaceContainer
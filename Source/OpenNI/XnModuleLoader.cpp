@@ -1101,6 +1101,9 @@ XnStatus XnModuleLoader::ValidateGeneratorInterface(XnVersion& moduleOpenNIVersi
 	// validate frame sync capability
 	XN_VALIDATE_CAPABILITY(pInterface, FrameSync);
 
+	// validate frame lease capability
+	XN_VALIDATE_CAPABILITY(pInterface, FrameLease);
+
 	return (XN_STATUS_OK);
 }
 
@@ -24,6 +24,7 @@
 #include "xnInternalFuncs.h"
 #include "XnLog.h"
 #include "XnTypeManager.h"
+#include <XnTrace.h>
 
 namespace xn
 {
@@ -328,12 +329,14 @@ XnStatus GeneratorWatcher::Watch()
 		const void* pData = GetCurrentData();
 		if (pData != NULL)
 		{
+			XN_TRACE_BEGIN(XN_TRACE_RECORD, m_generator.GetName(), nCurrentTimeStamp, nCurrentFrameID, m_generator.GetDataSize());
 			nRetVal = m_notifications.OnNodeNewData(m_pCookie, 
 				m_generator.GetName(), 
 				nCurrentTimeStamp, 
 				m_generator.GetFrameID(),
 				pData,
 				m_generator.GetDataSize());
+			XN_TRACE_END(XN_TRACE_RECORD, m_generator.GetName(), nCurrentTimeStamp, nCurrentFrameID, m_generator.GetDataSize());
 			XN_IS_STATUS_OK(nRetVal);
 		}
 	}
@@ -728,6 +731,14 @@ XnStatus DepthWatcher::NotifyStateImpl()
 	nRetVal = NotifyFieldOfView();
 	XN_IS_STATUS_OK(nRetVal);
 
+	// Registration calibration (only some nodes have it, so it's not an error if this fails)
+	XnRegistrationCalibration calibration;
+	if (m_depthGenerator.GetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(calibration), &calibration) == XN_STATUS_OK)
+	{
+		nRetVal = NotifyGeneralPropChanged(XN_PROP_REGISTRATION_CALIBRATION, sizeof(calibration), &calibration);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
 	// User position
 	XnBool bUserPositionsCap = m_depthGenerator.IsCapabilitySupported(XN_CAPABILITY_USER_POSITION);
 	nRetVal = NotifyIntPropChanged(XN_CAPABILITY_USER_POSITION, bUserPositionsCap);
@@ -119,6 +119,42 @@ XN_C_API XnStatus xnOSWaitAndTerminateThread(XN_THREAD_HANDLE* pThreadHandle, Xn
 	return (XN_STATUS_OK);
 }
 
+#define XN_ONCE_RUNNING		1
+#define XN_ONCE_DONE		2
+
+XN_C_API XnStatus xnOSRunOnce(XN_ONCE* pOnce, XnOnceFunc pFunc, void* pCookie)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pOnce);
+	XN_VALIDATE_INPUT_PTR(pFunc);
+
+	for (;;)
+	{
+		if (*pOnce == XN_ONCE_DONE)
+		{
+			// make sure what pFunc did is seen
+			xnOSMemoryBarrier();
+			return (XN_STATUS_OK);
+		}
+
+		if (xnOSAtomicCompareAndSwap32(pOnce, XN_ONCE_INIT, XN_ONCE_RUNNING))
+		{
+			break;
+		}
+
+		// another thread is running it
+		xnOSSleep(0);
+	}
+
+	nRetVal = pFunc(pCookie);
+
+	xnOSMemoryBarrier();
+	*pOnce = (nRetVal == XN_STATUS_OK) ? XN_ONCE_DONE : XN_ONCE_INIT;
+
+	return (nRetVal);
+}
+
 XN_C_API XnStatus xnOSLoadFile(const XnChar* cpFileName, void* pBuffer, const XnUInt32 nBufferSize)
 {
 	// Local function variables
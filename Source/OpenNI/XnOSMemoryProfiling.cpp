@@ -25,49 +25,102 @@
 #include <XnOS.h>
 #include <XnOSCpp.h>
 #include <XnLog.h>
+#include <math.h>
+#include <stdlib.h>
 
 //---------------------------------------------------------------------------
 // Types
 //---------------------------------------------------------------------------
-
-#define XN_MEM_PROF_MAX_FRAME_LEN 80
-#define XN_MEM_PROF_MAX_FRAMES 20
-#define XN_MASK_MEM_PROFILING	"MemoryProfiling"
-//#define XN_MEMORY_PROFILING_DUMP
-
-typedef XnChar XnFrame[XN_MEM_PROF_MAX_FRAME_LEN];
-
-typedef struct
+#define XN_MASK_MEM_PROFILING				"MemoryProfiling"
+
+#define XN_MEM_PROF_MAX_FRAMES				16
+#define XN_MEM_PROF_MAX_FRAME_LEN			256
+// must be a power of 2 (open addressing)
+#define XN_MEM_PROF_MAX_CALL_SITES			2048
+// must be powers of 2
+#define XN_MEM_PROF_STRIPES					256
+#define XN_MEM_PROF_BUCKETS_PER_STRIPE		64
+#define XN_MEM_PROF_SAMPLES_PER_STRIPE		128
+
+typedef struct XnMemCallSite
 {
-	void* pMemBlock;
+	/** 0 marks an unused slot. */
+	XnUInt32 nHash;
 	XnAllocationType nAllocType;
-	XnUInt32 nBytes;
 	const XnChar* csFunction;
 	const XnChar* csFile;
 	XnUInt32 nLine;
 	const XnChar* csAdditional;
 	XnUInt32 nFrames;
-	XnFrame aFrames[XN_MEM_PROF_MAX_FRAMES];
-} XnMemBlockData;
-
-typedef struct XnMemBlockDataNode
+	void* apFrames[XN_MEM_PROF_MAX_FRAMES];
+
+	XnUInt64 nSampledAllocations;
+	XnUInt32 nLiveSamples;
+	XnUInt64 nLiveBytes;
+	XnDouble dLiveBlocks;
+	XnUInt64 nLiveBytesAtLastSnapshot;
+	/** Only valid in the copies made for a snapshot. */
+	XnInt64 nGrowth;
+} XnMemCallSite;
+
+typedef struct XnMemSample
 {
-	XnMemBlockData Data;
-	XnMemBlockDataNode* pNext;
-} XnMemBlockDataNode;
-
-typedef struct
+	const void* pMemBlock;
+	XnUInt64 nEstimatedBytes;
+	XnDouble dEstimatedBlocks;
+	XnMemCallSite* pSite;
+	XnMemSample* pNext;
+} XnMemSample;
+
+typedef struct XnMemSampleStripe
+{
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	/** Read without the lock by the free path, so that frees of unsampled blocks stay lock-free most of the time. */
+	volatile XnUInt32 nLive;
+	XnMemSample* apBuckets[XN_MEM_PROF_BUCKETS_PER_STRIPE];
+	XnMemSample* pFree;
+} XnMemSampleStripe;
+
+typedef struct XnMemProfilerData
 {
-	XnMemBlockDataNode* pFirst;
-	XnMemBlockDataNode* pLast;
-} XnMemBlockDataLinkedList;
+	volatile XnBool bActive;
+	/** Read without a lock by the free path. */
+	volatile XnBool bInitialized;
+	/** Set once the application started or stopped the profiler explicitly. */
+	XnBool bConfigured;
+	volatile XnUInt32 nSession;
+	XnUInt32 nSamplingInterval;
+
+	XN_CRITICAL_SECTION_HANDLE hSitesLock;
+	XnMemCallSite* aSites;
+	XnUInt32 nSites;
+	XnUInt64 nSampledAllocations;
+	/** Samples of new call sites, dropped because the call site table was full. */
+	XnUInt64 nDroppedForCallSites;
+	/** Samples dropped because the stripe of their block had no free sample. */
+	XnUInt64 nDroppedForSampleSlots;
+	XnUInt32 nSnapshots;
+
+	XnMemSample* aSamplePool;
+	XnMemSampleStripe aStripes[XN_MEM_PROF_STRIPES];
+
+	XN_THREAD_HANDLE hSnapshotThread;
+	XN_EVENT_HANDLE hSnapshotStopEvent;
+	XnChar strSnapshotPrefix[XN_FILE_MAX_PATH];
+	XnUInt32 nSnapshotIntervalMs;
+} XnMemProfilerData;
 
 //---------------------------------------------------------------------------
 // Global Variables
 //---------------------------------------------------------------------------
-static XnMemBlockDataLinkedList g_allocatedMemory = {NULL, NULL};
-static XN_CRITICAL_SECTION_HANDLE g_hCS;
-static XnDumpFile* g_dump = NULL;
+static XnMemProfilerData g_MemProf;
+static XN_ONCE g_MemProfInitOnce = XN_ONCE_INIT;
+
+/** Bytes this thread may still allocate before its next sample. */
+static XN_THREAD_STATIC XnInt64 g_nBytesUntilSample = 0;
+static XN_THREAD_STATIC XnUInt32 g_nThreadSession = 0;
+static XN_THREAD_STATIC XnUInt32 g_nRandomState = 0;
+static XN_THREAD_STATIC XnBool g_bInProfiler = FALSE;
 
 //---------------------------------------------------------------------------
 // Code
@@ -93,180 +146,633 @@ const XnChar* XnGetAllocTypeString(XnAllocationType nType)
 	}
 }
 
-XN_C_API void* xnOSLogMemAlloc(void* pMemBlock, XnAllocationType nAllocType, XnUInt32 nBytes, const XnChar* csFunction, const XnChar* csFile, XnUInt32 nLine, const XnChar* csAdditional)
+static inline XnUInt32 xnMemProfHashPointer(const void* pMemBlock)
 {
-	static XnBool bFirstTime = TRUE;
-	static XnBool bReentrent = FALSE;
+	XnUInt64 nValue = (XnUInt64)(XnSizeT)pMemBlock;
+	nValue ^= nValue >> 33;
+	nValue *= 0xff51afd7ed558ccdULL;
+	nValue ^= nValue >> 33;
+	return (XnUInt32)nValue;
+}
 
-	if (bFirstTime)
+/** Draws the distance (in bytes) to the next sample. Distances are exponentially distributed, so every allocated byte has the same chance of being sampled. */
+static XnInt64 xnMemProfNextSampleDistance()
+{
+	if (g_nRandomState == 0)
 	{
-		bFirstTime = FALSE;
-		printf("************************************************************\n");
-		printf("**  WARNING: Memory Profiling is on!                      **\n");
-		printf("************************************************************\n");
+		XnUInt64 nNow = 0;
+		xnOSGetHighResTimeStamp(&nNow);
+		g_nRandomState = ((XnUInt32)(XnSizeT)&g_nRandomState ^ (XnUInt32)nNow) | 1;
+	}
+
+	// xorshift32
+	g_nRandomState ^= g_nRandomState << 13;
+	g_nRandomState ^= g_nRandomState >> 17;
+	g_nRandomState ^= g_nRandomState << 5;
 
-		bReentrent = TRUE;
-		xnOSCreateCriticalSection(&g_hCS);
+	// uniform in (0, 1]
+	XnDouble dUniform = ((g_nRandomState >> 8) + 1) / 16777216.0;
+	return (XnInt64)(-log(dUniform) * g_MemProf.nSamplingInterval) + 1;
+}
+
+static void xnMemProfResetTables()
+{
+	for (XnUInt32 nStripe = 0; nStripe < XN_MEM_PROF_STRIPES; ++nStripe)
+	{
+		XnMemSampleStripe* pStripe = &g_MemProf.aStripes[nStripe];
+		XnAutoCSLocker locker(pStripe->hLock);
 
-#ifdef XN_MEMORY_PROFILING_DUMP
-		xnDumpSetMaskState("MemProf", TRUE);
-#endif
-		g_dump = xnDumpFileOpen("MemProf", "MemProfiling.log");
-		xnDumpFileWriteString(g_dump, "Entry,Address,AllocType,Bytes,Function,File,Line,AdditionalInfo\n");
-		bReentrent = FALSE;
+		xnOSMemSet(pStripe->apBuckets, 0, sizeof(pStripe->apBuckets));
+		pStripe->pFree = NULL;
+		XnMemSample* aSamples = g_MemProf.aSamplePool + nStripe * XN_MEM_PROF_SAMPLES_PER_STRIPE;
+		for (XnUInt32 i = 0; i < XN_MEM_PROF_SAMPLES_PER_STRIPE; ++i)
+		{
+			aSamples[i].pNext = pStripe->pFree;
+			pStripe->pFree = &aSamples[i];
+		}
+		pStripe->nLive = 0;
 	}
 
-	// ignore stuff that is being allocated during "first time"
-	if (bReentrent)
+	XnAutoCSLocker locker(g_MemProf.hSitesLock);
+	xnOSMemSet(g_MemProf.aSites, 0, sizeof(XnMemCallSite) * XN_MEM_PROF_MAX_CALL_SITES);
+	g_MemProf.nSites = 0;
+	g_MemProf.nSampledAllocations = 0;
+	g_MemProf.nDroppedForCallSites = 0;
+	g_MemProf.nDroppedForSampleSlots = 0;
+}
+
+static XnStatus XN_CALLBACK_TYPE xnMemProfInit(void* /*pCookie*/)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = xnOSCreateCriticalSection(&g_MemProf.hSitesLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	for (XnUInt32 nStripe = 0; nStripe < XN_MEM_PROF_STRIPES; ++nStripe)
 	{
-		return pMemBlock;
+		nRetVal = xnOSCreateCriticalSection(&g_MemProf.aStripes[nStripe].hLock);
+		XN_IS_STATUS_OK(nRetVal);
 	}
 
-	XnMemBlockDataNode* pNode;
-	pNode = (XnMemBlockDataNode*)xnOSMalloc(sizeof(XnMemBlockDataNode));
-	pNode->Data.pMemBlock = pMemBlock;
-	pNode->Data.nAllocType = nAllocType;
-	pNode->Data.nBytes = nBytes;
-	pNode->Data.csFunction = csFunction;
-	pNode->Data.csFile = csFile;
-	pNode->Data.nLine = nLine;
-	pNode->Data.csAdditional = csAdditional;
-	pNode->Data.nFrames = XN_MEM_PROF_MAX_FRAMES;
-	xnDumpFileWriteString(g_dump, "Alloc,0x%x,%s,%u,%s,%s,%u,%s\n", pMemBlock, XnGetAllocTypeString(nAllocType), nBytes, csFunction, csFile, nLine, csAdditional);
-
-	// try to get call stack (skip 2 frames - this one and the alloc func)
-	XnChar* pstrFrames[XN_MEM_PROF_MAX_FRAMES];
-	for (XnUInt32 i = 0; i < XN_MEM_PROF_MAX_FRAMES; ++i)
+	XN_VALIDATE_CALLOC(g_MemProf.aSites, XnMemCallSite, XN_MEM_PROF_MAX_CALL_SITES);
+	XN_VALIDATE_CALLOC(g_MemProf.aSamplePool, XnMemSample, XN_MEM_PROF_STRIPES * XN_MEM_PROF_SAMPLES_PER_STRIPE);
+
+	xnMemProfResetTables();
+
+	// the free path only checks this flag, so everything above must be visible before it is
+	xnOSMemoryBarrier();
+	g_MemProf.bInitialized = TRUE;
+
+	return (XN_STATUS_OK);
+}
+
+/** Finds (or adds) the call site of a sample. Must be called with the sites lock held. */
+static XnMemCallSite* xnMemProfFindCallSite(XnAllocationType nAllocType, const XnChar* csFunction, const XnChar* csFile, XnUInt32 nLine, const XnChar* csAdditional, void** apFrames, XnUInt32 nFrames)
+{
+	// FNV-1a over the return addresses and the source location
+	XnUInt32 nHash = 2166136261U;
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		nHash = (nHash ^ xnMemProfHashPointer(apFrames[i])) * 16777619U;
+	}
+	nHash = (nHash ^ xnMemProfHashPointer(csFunction)) * 16777619U;
+	nHash = (nHash ^ nLine) * 16777619U;
+	if (nHash == 0)
+	{
+		nHash = 1;
+	}
+
+	XnUInt32 nIndex = nHash & (XN_MEM_PROF_MAX_CALL_SITES - 1);
+	for (XnUInt32 nProbe = 0; nProbe < XN_MEM_PROF_MAX_CALL_SITES; ++nProbe)
 	{
-		pstrFrames[i] = pNode->Data.aFrames[i];
+		XnMemCallSite* pSite = &g_MemProf.aSites[nIndex];
+		if (pSite->nHash == 0)
+		{
+			// keep probe sequences short by never filling the table completely
+			if (g_MemProf.nSites >= XN_MEM_PROF_MAX_CALL_SITES * 3 / 4)
+			{
+				return NULL;
+			}
+
+			pSite->nHash = nHash;
+			pSite->nAllocType = nAllocType;
+			pSite->csFunction = csFunction;
+			pSite->csFile = csFile;
+			pSite->nLine = nLine;
+			pSite->csAdditional = csAdditional;
+			pSite->nFrames = nFrames;
+			xnOSMemCopy(pSite->apFrames, apFrames, nFrames * sizeof(void*));
+			++g_MemProf.nSites;
+			return pSite;
+		}
+
+		if (pSite->nHash == nHash && 
+			pSite->csFunction == csFunction && 
+			pSite->nLine == nLine && 
+			pSite->nFrames == nFrames && 
+			xnOSMemCmp(pSite->apFrames, apFrames, nFrames * sizeof(void*)) == 0)
+		{
+			return pSite;
+		}
+
+		nIndex = (nIndex + 1) & (XN_MEM_PROF_MAX_CALL_SITES - 1);
 	}
-	if (XN_STATUS_OK != xnOSGetCurrentCallStack(2, pstrFrames, XN_MEM_PROF_MAX_FRAME_LEN, &pNode->Data.nFrames))
+
+	return NULL;
+}
+
+static void xnMemProfRecordSample(const void* pMemBlock, XnAllocationType nAllocType, XnUInt32 nBytes, const XnChar* csFunction, const XnChar* csFile, XnUInt32 nLine, const XnChar* csAdditional, void** apFrames, XnUInt32 nFrames)
+{
+	// an allocation of nBytes is sampled with probability 1 - e^(-nBytes/interval). Weighting each sample by the
+	// inverse of that probability gives unbiased estimates of the real number of blocks and bytes.
+	XnDouble dProbability = 1.0 - exp(-(XnDouble)nBytes / g_MemProf.nSamplingInterval);
+	if (dProbability <= 0)
 	{
-		pNode->Data.nFrames = 0;
+		return;
 	}
 
-	pNode->pNext = NULL;
+	XnDouble dBlocks = 1.0 / dProbability;
+	XnUInt64 nEstimatedBytes = (XnUInt64)(nBytes * dBlocks + 0.5);
 
-	XnAutoCSLocker lock(g_hCS);
-	if (g_allocatedMemory.pLast == NULL)
+	XnMemCallSite* pSite = NULL;
 	{
-		g_allocatedMemory.pFirst = g_allocatedMemory.pLast = pNode;
+		XnAutoCSLocker locker(g_MemProf.hSitesLock);
+		pSite = xnMemProfFindCallSite(nAllocType, csFunction, csFile, nLine, csAdditional, apFrames, nFrames);
+		if (pSite == NULL && g_MemProf.nDroppedForCallSites++ != 0)
+		{
+			return;
+		}
 	}
-	else
+
+	if (pSite == NULL)
 	{
-		g_allocatedMemory.pLast->pNext = pNode;
-		g_allocatedMemory.pLast = pNode;
+		// only the first drop of a session is logged. The count is in the stats and in every snapshot.
+		xnLogWarning(XN_MASK_MEM_PROFILING, "Call site table is full, samples of new call sites are dropped");
+		return;
 	}
 
+	XnUInt32 nHash = xnMemProfHashPointer(pMemBlock);
+	XnMemSampleStripe* pStripe = &g_MemProf.aStripes[nHash & (XN_MEM_PROF_STRIPES - 1)];
+	XnMemSample* pSample = NULL;
+	{
+		XnAutoCSLocker locker(pStripe->hLock);
+
+		pSample = pStripe->pFree;
+		if (pSample != NULL)
+		{
+			pStripe->pFree = pSample->pNext;
+
+			pSample->pMemBlock = pMemBlock;
+			pSample->nEstimatedBytes = nEstimatedBytes;
+			pSample->dEstimatedBlocks = dBlocks;
+			pSample->pSite = pSite;
+
+			XnMemSample** ppBucket = &pStripe->apBuckets[(nHash >> 8) & (XN_MEM_PROF_BUCKETS_PER_STRIPE - 1)];
+			pSample->pNext = *ppBucket;
+			*ppBucket = pSample;
+			++pStripe->nLive;
+		}
+	}
+
+	XnBool bFirstDrop = FALSE;
+	{
+		XnAutoCSLocker locker(g_MemProf.hSitesLock);
+		if (pSample == NULL)
+		{
+			bFirstDrop = (g_MemProf.nDroppedForSampleSlots++ == 0);
+		}
+		else
+		{
+			++g_MemProf.nSampledAllocations;
+			++pSite->nSampledAllocations;
+			++pSite->nLiveSamples;
+			pSite->nLiveBytes += nEstimatedBytes;
+			pSite->dLiveBlocks += dBlocks;
+		}
+	}
+
+	if (bFirstDrop)
+	{
+		xnLogWarning(XN_MASK_MEM_PROFILING, "A sample stripe is full (%u live samples), samples of blocks hashed to it are dropped", XN_MEM_PROF_SAMPLES_PER_STRIPE);
+	}
+}
+
+XN_C_API void* xnOSLogMemAlloc(void* pMemBlock, XnAllocationType nAllocType, XnUInt32 nBytes, const XnChar* csFunction, const XnChar* csFile, XnUInt32 nLine, const XnChar* csAdditional)
+{
+	if (pMemBlock == NULL || g_bInProfiler)
+	{
+		return pMemBlock;
+	}
+
+	if (!g_MemProf.bActive)
+	{
+		if (g_MemProf.bConfigured)
+		{
+			return pMemBlock;
+		}
+
+		// compiling with XN_MEM_PROFILING turns profiling on, unless the application configures it itself
+		g_bInProfiler = TRUE;
+		xnOSMemProfilerStart(XN_MEM_PROF_DEFAULT_SAMPLING_INTERVAL);
+		g_bInProfiler = FALSE;
+	}
+
+	if (g_nThreadSession != g_MemProf.nSession)
+	{
+		g_nThreadSession = g_MemProf.nSession;
+		g_nBytesUntilSample = xnMemProfNextSampleDistance();
+	}
+
+	g_nBytesUntilSample -= nBytes;
+	if (g_nBytesUntilSample > 0)
+	{
+		return pMemBlock;
+	}
+
+	g_bInProfiler = TRUE;
+
+	// stack is captured here (and not in a helper) so that frame 1 is always the allocating function. 
+	// Addresses are only symbolized when a snapshot is written.
+	void* apFrames[XN_MEM_PROF_MAX_FRAMES];
+	XnUInt32 nFrames = XN_MEM_PROF_MAX_FRAMES;
+	if (XN_STATUS_OK != xnOSGetCurrentCallStackAddresses(1, apFrames, &nFrames))
+	{
+		nFrames = 0;
+	}
+
+	xnMemProfRecordSample(pMemBlock, nAllocType, nBytes, csFunction, csFile, nLine, csAdditional, apFrames, nFrames);
+
+	g_nBytesUntilSample = xnMemProfNextSampleDistance();
+	g_bInProfiler = FALSE;
+
 	return pMemBlock;
 }
 
 XN_C_API void xnOSLogMemFree(const void* pMemBlock)
 {
-	if (pMemBlock == NULL)
+	if (pMemBlock == NULL || !g_MemProf.bInitialized)
+	{
 		return;
+	}
 
-	XnMemBlockDataNode* pPrev = NULL;
+	XnUInt32 nHash = xnMemProfHashPointer(pMemBlock);
+	XnMemSampleStripe* pStripe = &g_MemProf.aStripes[nHash & (XN_MEM_PROF_STRIPES - 1)];
 
-	XnAutoCSLocker lock(g_hCS);
-	XnMemBlockDataNode* pNode = g_allocatedMemory.pFirst;
-	while (pNode != NULL)
+	// almost all blocks are never sampled. Don't take the lock if this stripe holds no samples at all.
+	if (pStripe->nLive == 0)
 	{
-		if (pNode->Data.pMemBlock == pMemBlock)
-		{
-			// found. Remove it from the list
-			if (pPrev == NULL) // no previous
-				g_allocatedMemory.pFirst = pNode->pNext;
-			else
-				pPrev->pNext = pNode->pNext;
-
-			// if it was last, update last
-			if (g_allocatedMemory.pLast == pNode)
-				g_allocatedMemory.pLast = pPrev;
+		return;
+	}
 
-			xnDumpFileWriteString(g_dump, "Free,0x%x\n", pMemBlock);
+	XnUInt64 nEstimatedBytes = 0;
+	XnDouble dEstimatedBlocks = 0;
+	XnMemCallSite* pSite = NULL;
+	{
+		XnAutoCSLocker locker(pStripe->hLock);
 
-			// deallocate memory
-			xnOSFree(pNode);
+		XnMemSample** ppSample = &pStripe->apBuckets[(nHash >> 8) & (XN_MEM_PROF_BUCKETS_PER_STRIPE - 1)];
+		while (*ppSample != NULL && (*ppSample)->pMemBlock != pMemBlock)
+		{
+			ppSample = &(*ppSample)->pNext;
+		}
 
+		XnMemSample* pSample = *ppSample;
+		if (pSample == NULL)
+		{
 			return;
 		}
 
-		// move to next
-		pPrev = pNode;
-		pNode = pNode->pNext;
+		*ppSample = pSample->pNext;
+		nEstimatedBytes = pSample->nEstimatedBytes;
+		dEstimatedBlocks = pSample->dEstimatedBlocks;
+		pSite = pSample->pSite;
+
+		pSample->pNext = pStripe->pFree;
+		pStripe->pFree = pSample;
+		--pStripe->nLive;
 	}
 
-	// if we got here then we're trying to free a non-allocated memory
-	XN_ASSERT(FALSE);
+	XnAutoCSLocker locker(g_MemProf.hSitesLock);
+	// the tables may have been reset (by stopping the profiler) since this sample was taken
+	if (pSite->nLiveSamples > 0)
+	{
+		--pSite->nLiveSamples;
+		pSite->nLiveBytes -= XN_MIN(pSite->nLiveBytes, nEstimatedBytes);
+		pSite->dLiveBlocks -= dEstimatedBlocks;
+	}
 }
 
-XN_C_API void xnOSWriteMemoryReport(const XnChar* csFileName)
+XN_C_API XnStatus xnOSMemProfilerStart(XnUInt32 nSamplingInterval)
 {
-	XN_FILE_HANDLE FileHandle;
-	XnStatus nRetVal = xnOSOpenFile(csFileName, XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE, &FileHandle);
-	if (nRetVal != XN_STATUS_OK) return;
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (nSamplingInterval == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	g_MemProf.bConfigured = TRUE;
+
+	// the first allocations of several threads may all start the profiler implicitly
+	nRetVal = xnOSRunOnce(&g_MemProfInitOnce, xnMemProfInit, NULL);
+	XN_IS_STATUS_OK(nRetVal);
 
-	const XnUInt32 nReportLineMaxSize = 2048;
-	XnChar csReportLine[nReportLineMaxSize];
-	XnUInt32 nReportLength = 0;
+	g_MemProf.nSamplingInterval = nSamplingInterval;
+	// every thread draws a new sampling distance on its next allocation
+	++g_MemProf.nSession;
+	xnOSMemoryBarrier();
+	g_MemProf.bActive = TRUE;
 
-	XnUInt32 nChars;
+	xnLogInfo(XN_MASK_MEM_PROFILING, "Memory profiling started (sampling every %u bytes)", nSamplingInterval);
 
-	XnUInt32 nSum = 0;
-	xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "Allocated memory blocks:\n");
-	nReportLength += nChars;
-	xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "============================================\n");
-	nReportLength += nChars;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSMemProfilerStop()
+{
+	g_MemProf.bConfigured = TRUE;
+
+	if (!g_MemProf.bActive)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	g_MemProf.bActive = FALSE;
+	xnOSMemoryBarrier();
+
+	xnMemProfResetTables();
+
+	xnLogInfo(XN_MASK_MEM_PROFILING, "Memory profiling stopped");
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnBool xnOSMemProfilerIsActive()
+{
+	return g_MemProf.bActive;
+}
+
+XN_C_API XnStatus xnOSMemProfilerGetStats(XnMemProfilerStats* pStats)
+{
+	XN_VALIDATE_OUTPUT_PTR(pStats);
+
+	xnOSMemSet(pStats, 0, sizeof(XnMemProfilerStats));
+
+	if (!g_MemProf.bInitialized)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	pStats->nSamplingInterval = g_MemProf.nSamplingInterval;
+
+	for (XnUInt32 nStripe = 0; nStripe < XN_MEM_PROF_STRIPES; ++nStripe)
+	{
+		pStats->nLiveSamples += g_MemProf.aStripes[nStripe].nLive;
+	}
+
+	XnAutoCSLocker locker(g_MemProf.hSitesLock);
+	pStats->nSampledAllocations = g_MemProf.nSampledAllocations;
+	pStats->nCallSites = g_MemProf.nSites;
+	pStats->nDroppedForCallSites = g_MemProf.nDroppedForCallSites;
+	pStats->nDroppedForSampleSlots = g_MemProf.nDroppedForSampleSlots;
+	pStats->nDroppedSamples = pStats->nDroppedForCallSites + pStats->nDroppedForSampleSlots;
+	for (XnUInt32 i = 0; i < XN_MEM_PROF_MAX_CALL_SITES; ++i)
+	{
+		pStats->nEstimatedLiveBytes += g_MemProf.aSites[i].nLiveBytes;
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static int xnMemProfCompareSites(const void* pLeft, const void* pRight)
+{
+	const XnMemCallSite* pLeftSite = (const XnMemCallSite*)pLeft;
+	const XnMemCallSite* pRightSite = (const XnMemCallSite*)pRight;
+
+	// biggest first
+	if (pLeftSite->nLiveBytes != pRightSite->nLiveBytes)
+	{
+		return (pLeftSite->nLiveBytes > pRightSite->nLiveBytes) ? -1 : 1;
+	}
+
+	if (pLeftSite->nGrowth != pRightSite->nGrowth)
+	{
+		return (pLeftSite->nGrowth > pRightSite->nGrowth) ? -1 : 1;
+	}
+
+	return 0;
+}
+
+static void xnMemProfWriteLine(XN_FILE_HANDLE FileHandle, const XnChar* csFormat, ...)
+{
+	XnChar csLine[1024];
+	XnUInt32 nChars = 0;
+
+	va_list args;
+	va_start(args, csFormat);
+	xnOSStrFormatV(csLine, sizeof(csLine), &nChars, csFormat, args);
+	va_end(args);
+
+	xnOSWriteFile(FileHandle, csLine, nChars);
+}
+
+XN_C_API XnStatus xnOSMemProfilerWriteSnapshot(const XnChar* strFileName)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strFileName);
 
-	xnOSWriteFile(FileHandle, csReportLine, nReportLength);
-	nReportLength = 0;
+	if (!g_MemProf.bInitialized)
+	{
+		return (XN_STATUS_NOT_INIT);
+	}
 
+	// copy the call sites, so that symbolizing and writing don't block sampling
+	XnMemCallSite* aSites = (XnMemCallSite*)xnOSMalloc(sizeof(XnMemCallSite) * XN_MEM_PROF_MAX_CALL_SITES);
+	XN_VALIDATE_ALLOC_PTR(aSites);
+
+	XnUInt32 nSites = 0;
+	XnUInt32 nSnapshot = 0;
+	XnUInt64 nSampledAllocations = 0;
+	XnUInt64 nDroppedForCallSites = 0;
+	XnUInt64 nDroppedForSampleSlots = 0;
+	XnUInt64 nLiveBytes = 0;
+	XnInt64 nGrowth = 0;
 	{
-		XnAutoCSLocker lock(g_hCS);
-		for (XnMemBlockDataNode* pNode = g_allocatedMemory.pFirst; pNode != NULL; pNode = pNode->pNext)
+		XnAutoCSLocker locker(g_MemProf.hSitesLock);
+
+		nSnapshot = ++g_MemProf.nSnapshots;
+		nSampledAllocations = g_MemProf.nSampledAllocations;
+		nDroppedForCallSites = g_MemProf.nDroppedForCallSites;
+		nDroppedForSampleSlots = g_MemProf.nDroppedForSampleSlots;
+
+		for (XnUInt32 i = 0; i < XN_MEM_PROF_MAX_CALL_SITES; ++i)
 		{
-			xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "%d bytes allocated at 0x%08x using %s", pNode->Data.nBytes, pNode->Data.pMemBlock, XnGetAllocTypeString(pNode->Data.nAllocType));
-			nReportLength += nChars;
+			XnMemCallSite* pSite = &g_MemProf.aSites[i];
+			if (pSite->nHash == 0)
+			{
+				continue;
+			}
 
-			if (pNode->Data.csAdditional != NULL)
+			XnInt64 nSiteGrowth = (XnInt64)pSite->nLiveBytes - (XnInt64)pSite->nLiveBytesAtLastSnapshot;
+			pSite->nLiveBytesAtLastSnapshot = pSite->nLiveBytes;
+
+			nLiveBytes += pSite->nLiveBytes;
+			nGrowth += nSiteGrowth;
+
+			if (pSite->nLiveBytes == 0 && nSiteGrowth == 0)
 			{
-				xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, " (%s)", pNode->Data.csAdditional);
-				nReportLength += nChars;
+				continue;
 			}
 
-			xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, " at %s [%s, %d]\n", pNode->Data.csFunction, pNode->Data.csFile, pNode->Data.nLine);
-			nReportLength += nChars;
+			aSites[nSites] = *pSite;
+			aSites[nSites].nGrowth = nSiteGrowth;
+			++nSites;
+		}
+	}
 
-			if (pNode->Data.nFrames > 0)
+	qsort(aSites, nSites, sizeof(XnMemCallSite), xnMemProfCompareSites);
+
+	XN_FILE_HANDLE FileHandle;
+	nRetVal = xnOSOpenFile(strFileName, XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE, &FileHandle);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSFree(aSites);
+		return (nRetVal);
+	}
+
+	XnUInt64 nNow = 0;
+	xnOSGetTimeStamp(&nNow);
+
+	xnMemProfWriteLine(FileHandle, "Memory profile snapshot #%u at %llu ms (sampling every %u bytes)\n", nSnapshot, nNow, g_MemProf.nSamplingInterval);
+	xnMemProfWriteLine(FileHandle, "============================================\n");
+	xnMemProfWriteLine(FileHandle, "Estimated live memory: %llu bytes (%+lld since last snapshot)\n", nLiveBytes, nGrowth);
+	xnMemProfWriteLine(FileHandle, "Sampled allocations: %llu, dropped samples: %llu (call site table full: %llu, sample stripe full: %llu)\n\n", 
+		nSampledAllocations, nDroppedForCallSites + nDroppedForSampleSlots, nDroppedForCallSites, nDroppedForSampleSlots);
+
+	XnChar aFrameNames[XN_MEM_PROF_MAX_FRAMES][XN_MEM_PROF_MAX_FRAME_LEN];
+	XnChar* astrFrames[XN_MEM_PROF_MAX_FRAMES];
+	for (XnUInt32 i = 0; i < XN_MEM_PROF_MAX_FRAMES; ++i)
+	{
+		astrFrames[i] = aFrameNames[i];
+	}
+
+	for (XnUInt32 i = 0; i < nSites; ++i)
+	{
+		XnMemCallSite* pSite = &aSites[i];
+
+		xnMemProfWriteLine(FileHandle, "~%llu bytes in ~%.0f blocks (%+lld since last snapshot), %llu sampled allocations using %s", 
+			pSite->nLiveBytes, pSite->dLiveBlocks, pSite->nGrowth, pSite->nSampledAllocations, XnGetAllocTypeString(pSite->nAllocType));
+
+		if (pSite->csAdditional != NULL && pSite->csAdditional[0] != '\0')
+		{
+			xnMemProfWriteLine(FileHandle, " (%s)", pSite->csAdditional);
+		}
+
+		if (pSite->csFunction != NULL && pSite->csFunction[0] != '\0')
+		{
+			xnMemProfWriteLine(FileHandle, " at %s [%s, %u]", pSite->csFunction, pSite->csFile, pSite->nLine);
+		}
+
+		xnMemProfWriteLine(FileHandle, "\n");
+
+		if (pSite->nFrames > 0 && 
+			xnOSResolveCallStackAddresses(pSite->apFrames, pSite->nFrames, astrFrames, XN_MEM_PROF_MAX_FRAME_LEN) == XN_STATUS_OK)
+		{
+			xnMemProfWriteLine(FileHandle, "Callstack:\n");
+			for (XnUInt32 iFrame = 0; iFrame < pSite->nFrames; ++iFrame)
 			{
-				xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "Callstack:\n");
-				nReportLength += nChars;
-
-				for (XnUInt i = 0; i < pNode->Data.nFrames; ++i)
-				{
-					xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "\t%s\n", pNode->Data.aFrames[i]);
-					nReportLength += nChars;
-				}
+				xnMemProfWriteLine(FileHandle, "\t%s\n", astrFrames[iFrame]);
 			}
+		}
+
+		xnMemProfWriteLine(FileHandle, "\n");
+	}
 
-			xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "\n");
-			nReportLength += nChars;
+	xnOSCloseFile(&FileHandle);
+	xnOSFree(aSites);
 
-			xnOSWriteFile(FileHandle, csReportLine, nReportLength);
-			nReportLength = 0;
+	return (XN_STATUS_OK);
+}
+
+XN_C_API void xnOSWriteMemoryReport(const XnChar* csFileName)
+{
+	xnOSMemProfilerWriteSnapshot(csFileName);
+}
+
+XN_THREAD_PROC xnMemProfSnapshotThread(XN_THREAD_PARAM /*pThreadParam*/)
+{
+	XnUInt32 nIndex = 0;
 
-			nSum += pNode->Data.nBytes;
+	while (xnOSWaitEvent(g_MemProf.hSnapshotStopEvent, g_MemProf.nSnapshotIntervalMs) == XN_STATUS_OS_EVENT_TIMEOUT)
+	{
+		XnChar strFileName[XN_FILE_MAX_PATH];
+		XnUInt32 nChars = 0;
+		xnOSStrFormat(strFileName, sizeof(strFileName), &nChars, "%s-%04u.txt", g_MemProf.strSnapshotPrefix, nIndex++);
+
+		XnStatus nRetVal = xnOSMemProfilerWriteSnapshot(strFileName);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_MEM_PROFILING, "Failed to write memory snapshot '%s': %s", strFileName, xnGetStatusString(nRetVal));
 		}
 	}
 
-	xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "*******************************************************************\n\n");
-	nReportLength += nChars;
-	xnOSStrFormat(csReportLine + nReportLength, nReportLineMaxSize - nReportLength, &nChars, "Total allocated memory: %d bytes\n", nSum);
-	nReportLength += nChars;
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSMemProfilerStartPeriodicSnapshots(const XnChar* strFilePrefix, XnUInt32 nIntervalMs)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
 
-	xnOSWriteFile(FileHandle, csReportLine, nReportLength);
-	nReportLength = 0;
+	XN_VALIDATE_INPUT_PTR(strFilePrefix);
 
-	xnOSCloseFile(&FileHandle);
+	if (nIntervalMs == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	if (!g_MemProf.bInitialized)
+	{
+		return (XN_STATUS_NOT_INIT);
+	}
+
+	nRetVal = xnOSMemProfilerStopPeriodicSnapshots();
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSStrCopy(g_MemProf.strSnapshotPrefix, strFilePrefix, sizeof(g_MemProf.strSnapshotPrefix));
+	XN_IS_STATUS_OK(nRetVal);
+
+	g_MemProf.nSnapshotIntervalMs = nIntervalMs;
+
+	nRetVal = xnOSCreateEvent(&g_MemProf.hSnapshotStopEvent, TRUE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateThread(xnMemProfSnapshotThread, NULL, &g_MemProf.hSnapshotThread);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSCloseEvent(&g_MemProf.hSnapshotStopEvent);
+		g_MemProf.hSnapshotStopEvent = NULL;
+		return (nRetVal);
+	}
+
+	xnOSApplyThreadPolicy(g_MemProf.hSnapshotThread, XN_THREAD_ROLE_MEM_PROFILER, "XnMemProfiler");
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSMemProfilerStopPeriodicSnapshots()
+{
+	if (g_MemProf.hSnapshotThread == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	xnOSSetEvent(g_MemProf.hSnapshotStopEvent);
+	xnOSWaitAndTerminateThread(&g_MemProf.hSnapshotThread, 5000);
+	g_MemProf.hSnapshotThread = NULL;
+
+	xnOSCloseEvent(&g_MemProf.hSnapshotStopEvent);
+	g_MemProf.hSnapshotStopEvent = NULL;
+
+	return (XN_STATUS_OK);
 }
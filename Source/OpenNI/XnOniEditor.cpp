@@ -0,0 +1,861 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOniEditor.h>
+#include <XnLog.h>
+#include <XnHashT.h>
+#include <XnStringsHashT.h>
+#include "XnOniRecords.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_ONI_EDITOR_WRITE_BUFFER_SIZE			(4 * 1024 * 1024)
+/** Same chunk size as the recorder, so edited files are indexed the same way as recorded ones. */
+#define XN_ONI_EDITOR_DATA_INDEX_CHUNK_ENTRIES	1024
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/* Position in the output of the last record of each property of a node (what the next one undoes). */
+typedef XnStringsHashT<XnUInt64> XnOniEditorPropPositions;
+
+/* A node of the edited file. */
+typedef struct XnOniEditorNode
+{
+	XnUInt32 nNodeID;
+	XnChar strName[XN_MAX_NAME_LENGTH];
+	XnProductionNodeType type;
+	XnCodecID compression;
+	XnUInt64 nNodeAddedPos;
+	XnBool bStateReady;
+	XnBool bGotData;
+	XnUInt32 nFrames;
+	XnUInt64 nMinTimestamp;
+	XnUInt64 nMaxTimestamp;
+	XnUInt64 nLastDataPos;
+	XnOniEditorPropPositions propPositions;
+	DataIndexEntry aDataIndexChunk[XN_ONI_EDITOR_DATA_INDEX_CHUNK_ENTRIES];
+	XnUInt32 nDataIndexChunkEntries;
+	XnUInt64 nLastDataIndexChunkPos;
+} XnOniEditorNode;
+
+typedef XnStringsHashT<XnOniEditorNode*> XnOniEditorNodes;
+
+/* A node of the recording being appended. */
+typedef struct XnOniEditorSourceNode
+{
+	XnChar strName[XN_MAX_NAME_LENGTH];
+	XnProductionNodeType type;
+	XnCodecID compression;
+	XnBool bSelected;
+	XnOniEditorNode* pOutput; // NULL until its node added record is copied
+	XnUInt32 nFramesToCopy;
+	XnUInt64 nFirstTimestamp;
+	XnUInt64 nLastTimestamp;
+} XnOniEditorSourceNode;
+
+typedef XnHashT<XnUInt32, XnOniEditorSourceNode> XnOniEditorSourceNodes;
+
+typedef struct XnOniEditorSource
+{
+	const XnChar* strFileName;
+	XN_FILE_HANDLE hFile;
+	XnOniFileFormat format;
+	XnUInt64 nPos;
+	XnOniEditorSourceNodes nodes;
+	XnUInt64 nStartTime;
+	XnUInt64 nEndTime;
+	XnBool bKeepTimestamps;
+	/* Smallest timestamp of the frames to copy. Unless timestamps are kept, it is moved to the editor's time offset. */
+	XnUInt64 nBaseTimestamp;
+	/* Position of the last frame to copy. Nothing after it is needed. */
+	XnUInt64 nLastCopyPos;
+} XnOniEditorSource;
+
+struct XnOniEditor
+{
+	XN_FILE_HANDLE hFile;
+	XnUInt8* pWriteBuffer;
+	XnUInt32 nWriteBufferUsed;
+	XnUInt64 nFlushedBytes;
+	XnUInt8* pRecordBuffer;
+	XnUInt8* pSourceRecordBuffer;
+	XnOniEditorNodes nodes;
+	XnUInt32 nNodes;
+	XnUInt32 nConfigurationID;
+	/* Added to the timestamps of the next appended recording. */
+	XnUInt64 nTimeOffset;
+	XnUInt64 nGlobalMaxTimestamp;
+};
+
+//---------------------------------------------------------------------------
+// Output
+//---------------------------------------------------------------------------
+static XnUInt64 xnOniEditorTell(const XnOniEditor* pEditor)
+{
+	return pEditor->nFlushedBytes + pEditor->nWriteBufferUsed;
+}
+
+static XnStatus xnOniEditorFlush(XnOniEditor* pEditor)
+{
+	if (pEditor->nWriteBufferUsed == 0)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	XnStatus nRetVal = xnOSWriteFile(pEditor->hFile, pEditor->pWriteBuffer, pEditor->nWriteBufferUsed);
+	XN_IS_STATUS_OK(nRetVal);
+
+	pEditor->nFlushedBytes += pEditor->nWriteBufferUsed;
+	pEditor->nWriteBufferUsed = 0;
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOniEditorWrite(XnOniEditor* pEditor, const void* pData, XnUInt32 nSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (pEditor->nWriteBufferUsed + nSize > XN_ONI_EDITOR_WRITE_BUFFER_SIZE)
+	{
+		nRetVal = xnOniEditorFlush(pEditor);
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (nSize > XN_ONI_EDITOR_WRITE_BUFFER_SIZE)
+		{
+			nRetVal = xnOSWriteFile(pEditor->hFile, pData, nSize);
+			XN_IS_STATUS_OK(nRetVal);
+			pEditor->nFlushedBytes += nSize;
+			return (XN_STATUS_OK);
+		}
+	}
+
+	xnOSMemCopy(pEditor->pWriteBuffer + pEditor->nWriteBufferUsed, pData, nSize);
+	pEditor->nWriteBufferUsed += nSize;
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOniEditorWriteRecord(XnOniEditor* pEditor, Record& record)
+{
+	return xnOniEditorWrite(pEditor, record.GetData(), record.GetSize());
+}
+
+/* Overwrites already written bytes (the header, or a node added record). */
+static XnStatus xnOniEditorWriteAt(XnOniEditor* pEditor, XnUInt64 nPos, const void* pData, XnUInt32 nSize)
+{
+	XnStatus nRetVal = xnOniEditorFlush(pEditor);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSSeekFile64(pEditor->hFile, XN_OS_SEEK_SET, nPos);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSWriteFile(pEditor->hFile, pData, nSize);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSSeekFile64(pEditor->hFile, XN_OS_SEEK_SET, pEditor->nFlushedBytes);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOniEditorWriteHeader(XnOniEditor* pEditor, XnUInt64 nGlobalMaxTimeStamp, XnUInt32 nMaxNodeID)
+{
+	RecordingHeader header = DEFAULT_RECORDING_HEADER;
+	header.nGlobalMaxTimeStamp = nGlobalMaxTimeStamp;
+	header.nMaxNodeID = nMaxNodeID;
+
+	if (xnOniEditorTell(pEditor) == 0)
+	{
+		return xnOniEditorWrite(pEditor, &header, sizeof(header));
+	}
+	else
+	{
+		return xnOniEditorWriteAt(pEditor, 0, &header, sizeof(header));
+	}
+}
+
+static XnStatus xnOniEditorFlushDataIndexChunk(XnOniEditor* pEditor, XnOniEditorNode* pNode)
+{
+	if (pNode->nDataIndexChunkEntries == 0)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	XnUInt64 nChunkPos = xnOniEditorTell(pEditor);
+	XnUInt32 nChunkSize = pNode->nDataIndexChunkEntries * sizeof(DataIndexEntry);
+
+	DataIndexChunkRecordHeader chunkHeader(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+	chunkHeader.SetNodeID(pNode->nNodeID);
+	chunkHeader.SetFirstFrame(pNode->nFrames - pNode->nDataIndexChunkEntries + 1);
+	chunkHeader.SetPayloadSize(nChunkSize);
+	chunkHeader.SetUndoRecordPos(pNode->nLastDataIndexChunkPos);
+	XnStatus nRetVal = chunkHeader.Encode();
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorWriteRecord(pEditor, chunkHeader);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorWrite(pEditor, pNode->aDataIndexChunk, nChunkSize);
+	XN_IS_STATUS_OK(nRetVal);
+
+	pNode->nLastDataIndexChunkPos = nChunkPos;
+	pNode->nDataIndexChunkEntries = 0;
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOniEditorEncodeNodeAdded(const XnOniEditorNode* pNode, NodeAddedRecord& record)
+{
+	record.SetNodeID(pNode->nNodeID);
+	record.SetNodeName(pNode->strName);
+	record.SetNodeType(pNode->type);
+	record.SetCompression(pNode->compression);
+	record.SetNumberOfFrames(pNode->nFrames);
+	record.SetMinTimestamp(pNode->nMinTimestamp);
+	record.SetMaxTimestamp(pNode->nMaxTimestamp);
+	record.SetSeekTablePosition(pNode->nLastDataIndexChunkPos);
+	return record.Encode();
+}
+
+static XnStatus xnOniEditorAddNode(XnOniEditor* pEditor, const XnOniEditorSourceNode& sourceNode, XnOniEditorNode** ppNode)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnOniEditorNode* pNode = XN_NEW(XnOniEditorNode);
+	XN_VALIDATE_ALLOC_PTR(pNode);
+
+	pNode->nNodeID = ++pEditor->nNodes;
+	xnOSStrCopy(pNode->strName, sourceNode.strName, sizeof(pNode->strName));
+	pNode->type = sourceNode.type;
+	pNode->compression = sourceNode.compression;
+	pNode->nNodeAddedPos = xnOniEditorTell(pEditor);
+	pNode->bStateReady = FALSE;
+	pNode->bGotData = FALSE;
+	pNode->nFrames = 0;
+	pNode->nMinTimestamp = 0;
+	pNode->nMaxTimestamp = 0;
+	pNode->nLastDataPos = 0;
+	pNode->nDataIndexChunkEntries = 0;
+	pNode->nLastDataIndexChunkPos = 0;
+
+	nRetVal = pEditor->nodes.Set(pNode->strName, pNode);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_DELETE(pNode);
+		return (nRetVal);
+	}
+
+	pEditor->nConfigurationID++;
+
+	NodeAddedRecord record(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+	nRetVal = xnOniEditorEncodeNodeAdded(pNode, record);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorWriteRecord(pEditor, record);
+	XN_IS_STATUS_OK(nRetVal);
+
+	*ppNode = pNode;
+
+	return (XN_STATUS_OK);
+}
+
+/* Writes the node removed record, the rest of the seek table, and the final node added record. */
+static XnStatus xnOniEditorFinalizeNode(XnOniEditor* pEditor, XnOniEditorNode* pNode)
+{
+	NodeRemovedRecord removedRecord(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+	removedRecord.SetNodeID(pNode->nNodeID);
+	removedRecord.SetUndoRecordPos(pNode->nNodeAddedPos);
+	XnStatus nRetVal = removedRecord.Encode();
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorWriteRecord(pEditor, removedRecord);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (!pNode->bGotData)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	nRetVal = xnOniEditorFlushDataIndexChunk(pEditor, pNode);
+	XN_IS_STATUS_OK(nRetVal);
+
+	NodeAddedRecord addedRecord(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+	nRetVal = xnOniEditorEncodeNodeAdded(pNode, addedRecord);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorWriteAt(pEditor, pNode->nNodeAddedPos, addedRecord.GetData(), addedRecord.GetSize());
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+//---------------------------------------------------------------------------
+// Input
+//---------------------------------------------------------------------------
+static XnStatus xnOniEditorOpenSource(XnOniEditorSource& source)
+{
+	XnStatus nRetVal = xnOSOpenFile(source.strFileName, XN_OS_FILE_READ, &source.hFile);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_ONI_EDITOR, "Failed to open '%s': %s", source.strFileName, xnGetStatusString(nRetVal));
+	}
+
+	nRetVal = xnOniReadHeader(source.hFile, source.strFileName, &source.format);
+	XN_IS_STATUS_OK(nRetVal);
+
+	source.nPos = source.format.nFirstRecordPos;
+
+	return (XN_STATUS_OK);
+}
+
+/* Reads the next record, without its payload. Returns XN_STATUS_EOF when the recording ends. */
+static XnStatus xnOniEditorReadRecord(XnOniEditorSource& source, Record& record)
+{
+	return xnOniReadRecord(source.hFile, source.nPos, &source.format, record);
+}
+
+static void xnOniEditorSkipPayload(XnOniEditorSource& source, const Record& record)
+{
+	source.nPos += record.GetSize() + record.GetPayloadSize();
+}
+
+/* Copies a payload from the source into the write buffer, without staging it anywhere else. */
+static XnStatus xnOniEditorCopyPayload(XnOniEditor* pEditor, XnOniEditorSource& source, const Record& record)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	XnUInt64 nPayloadPos = source.nPos + record.GetSize();
+	XnUInt32 nLeft = record.GetPayloadSize();
+
+	while (nLeft > 0)
+	{
+		if (pEditor->nWriteBufferUsed == XN_ONI_EDITOR_WRITE_BUFFER_SIZE)
+		{
+			nRetVal = xnOniEditorFlush(pEditor);
+			XN_IS_STATUS_OK(nRetVal);
+		}
+
+		XnUInt32 nBytesRead = XN_MIN(nLeft, XN_ONI_EDITOR_WRITE_BUFFER_SIZE - pEditor->nWriteBufferUsed);
+		nRetVal = xnOSReadFileAt(source.hFile, nPayloadPos, pEditor->pWriteBuffer + pEditor->nWriteBufferUsed, &nBytesRead);
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (nBytesRead == 0)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_ONI_EDITOR, "Frame in '%s' at position %llu is truncated", source.strFileName, source.nPos);
+		}
+
+		pEditor->nWriteBufferUsed += nBytesRead;
+		nPayloadPos += nBytesRead;
+		nLeft -= nBytesRead;
+	}
+
+	source.nPos += record.GetSize() + record.GetPayloadSize();
+
+	return (XN_STATUS_OK);
+}
+
+static XnOniEditorSourceNode* xnOniEditorGetSourceNode(XnOniEditorSource& source, XnUInt32 nNodeID)
+{
+	XnOniEditorSourceNodes::Iterator it = source.nodes.Find(nNodeID);
+	return (it == source.nodes.End()) ? NULL : &it->Value();
+}
+
+static XnBool xnOniEditorIsNodeSelected(const XnOniCopyOptions* pOptions, const XnChar* strName)
+{
+	if (pOptions == NULL || pOptions->astrNodeNames == NULL)
+	{
+		return TRUE;
+	}
+
+	for (XnUInt32 i = 0; i < pOptions->nNodeNames; ++i)
+	{
+		if (xnOSStrCmp(pOptions->astrNodeNames[i], strName) == 0)
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static XnBool xnOniEditorIsInRange(const XnOniEditorSource& source, XnUInt64 nTimestamp)
+{
+	return (nTimestamp >= source.nStartTime && nTimestamp <= source.nEndTime);
+}
+
+/* First pass: learns the nodes of the source and which frames will be copied, reading only record fields.
+   Nothing is written if the source can't be appended. */
+static XnStatus xnOniEditorScanSource(XnOniEditor* pEditor, XnOniEditorSource& source, const XnOniCopyOptions* pOptions)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	Record record(pEditor->pSourceRecordBuffer, XN_ONI_RECORD_MAX_SIZE, source.format.bOld32Header);
+
+	for (;;)
+	{
+		XnUInt64 nRecordPos = source.nPos;
+		nRetVal = xnOniEditorReadRecord(source, record);
+		if (nRetVal == XN_STATUS_EOF)
+		{
+			break;
+		}
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (record.GetType() == RECORD_END)
+		{
+			break;
+		}
+
+		switch (record.GetType())
+		{
+		case RECORD_NODE_ADDED_1_0_0_4:
+		case RECORD_NODE_ADDED_1_0_0_5:
+		case RECORD_NODE_ADDED:
+			{
+				// all versions start with the name, type and codec
+				NodeAdded_1_0_0_4_Record nodeAdded(record);
+				nRetVal = nodeAdded.Decode();
+				XN_IS_STATUS_OK(nRetVal);
+
+				XnOniEditorSourceNode sourceNode;
+				xnOSMemSet(&sourceNode, 0, sizeof(sourceNode));
+				nRetVal = xnOSStrCopy(sourceNode.strName, nodeAdded.GetNodeName(), sizeof(sourceNode.strName));
+				XN_IS_STATUS_OK(nRetVal);
+				sourceNode.type = nodeAdded.GetNodeType();
+				sourceNode.compression = nodeAdded.GetCompression();
+				sourceNode.bSelected = xnOniEditorIsNodeSelected(pOptions, sourceNode.strName);
+
+				XnOniEditorNode* pNode = NULL;
+				if (sourceNode.bSelected && pEditor->nodes.Get(sourceNode.strName, pNode) == XN_STATUS_OK &&
+					(pNode->type != sourceNode.type || pNode->compression != sourceNode.compression))
+				{
+					XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_ONI_EDITOR, "Node '%s' of '%s' does not match the one already in the file (type or codec differ). It can't be copied without re-encoding.", sourceNode.strName, source.strFileName);
+				}
+
+				nRetVal = source.nodes.Set(record.GetNodeID(), sourceNode);
+				XN_IS_STATUS_OK(nRetVal);
+			}
+			break;
+		case RECORD_NEW_DATA:
+			{
+				NewDataRecordHeader newData(record);
+				nRetVal = newData.Decode();
+				XN_IS_STATUS_OK(nRetVal);
+
+				XnOniEditorSourceNode* pSourceNode = xnOniEditorGetSourceNode(source, record.GetNodeID());
+				XN_VALIDATE_PTR(pSourceNode, XN_STATUS_CORRUPT_FILE);
+
+				XnUInt64 nTimestamp = newData.GetTimeStamp();
+				if (pSourceNode->bSelected && xnOniEditorIsInRange(source, nTimestamp))
+				{
+					if (pSourceNode->nFramesToCopy == 0)
+					{
+						pSourceNode->nFirstTimestamp = nTimestamp;
+					}
+					pSourceNode->nLastTimestamp = nTimestamp;
+					pSourceNode->nFramesToCopy++;
+					source.nBaseTimestamp = XN_MIN(source.nBaseTimestamp, nTimestamp);
+					source.nLastCopyPos = nRecordPos;
+				}
+			}
+			break;
+		default:
+			// properties and seek tables are only needed in the second pass
+			break;
+		}
+
+		xnOniEditorSkipPayload(source, record);
+	}
+
+	for (XnUInt32 i = 0; pOptions != NULL && pOptions->astrNodeNames != NULL && i < pOptions->nNodeNames; ++i)
+	{
+		XnBool bFound = FALSE;
+		for (XnOniEditorSourceNodes::ConstIterator it = source.nodes.Begin(); it != source.nodes.End(); ++it)
+		{
+			bFound |= (xnOSStrCmp(it->Value().strName, pOptions->astrNodeNames[i]) == 0);
+		}
+
+		if (!bFound)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_NO_MATCH, XN_MASK_ONI_EDITOR, "'%s' has no node named '%s'", source.strFileName, pOptions->astrNodeNames[i]);
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOniEditorCopyProperty(XnOniEditor* pEditor, XnOniEditorNode* pNode, const Record& record)
+{
+	// all property records have the same layout (name, size, value), only their type differs
+	GeneralPropRecord sourceProp(record);
+	XnStatus nRetVal = sourceProp.Decode();
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUInt64 nUndoPos = 0;
+	pNode->propPositions.Get(sourceProp.GetPropName(), nUndoPos);
+	nRetVal = pNode->propPositions.Set(sourceProp.GetPropName(), xnOniEditorTell(pEditor));
+	XN_IS_STATUS_OK(nRetVal);
+
+	GeneralPropRecord prop(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE, record.GetType());
+	prop.SetNodeID(pNode->nNodeID);
+	prop.SetPropName(sourceProp.GetPropName());
+	prop.SetPropDataSize(sourceProp.GetPropDataSize());
+	prop.SetPropData(sourceProp.GetPropData());
+	prop.SetUndoRecordPos(nUndoPos);
+	nRetVal = prop.Encode();
+	XN_IS_STATUS_OK(nRetVal);
+
+	pEditor->nConfigurationID++;
+
+	return xnOniEditorWriteRecord(pEditor, prop);
+}
+
+static XnStatus xnOniEditorCopyFrame(XnOniEditor* pEditor, XnOniEditorSource& source, XnOniEditorNode* pNode, const NewDataRecordHeader& sourceRecord)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt64 nTimestamp = sourceRecord.GetTimeStamp();
+	if (!source.bKeepTimestamps)
+	{
+		nTimestamp = nTimestamp - source.nBaseTimestamp + pEditor->nTimeOffset;
+	}
+
+	if (!pNode->bGotData)
+	{
+		NodeDataBeginRecord dataBegin(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+		dataBegin.SetNodeID(pNode->nNodeID);
+		nRetVal = dataBegin.Encode();
+		XN_IS_STATUS_OK(nRetVal);
+		nRetVal = xnOniEditorWriteRecord(pEditor, dataBegin);
+		XN_IS_STATUS_OK(nRetVal);
+
+		pNode->bGotData = TRUE;
+		pNode->nMinTimestamp = nTimestamp;
+	}
+
+	// data index chunks are written between frames, so they never end up inside one
+	if (pNode->nDataIndexChunkEntries == XN_ONI_EDITOR_DATA_INDEX_CHUNK_ENTRIES)
+	{
+		nRetVal = xnOniEditorFlushDataIndexChunk(pEditor, pNode);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	XnUInt64 nRecordPos = xnOniEditorTell(pEditor);
+
+	NewDataRecordHeader newData(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+	newData.SetNodeID(pNode->nNodeID);
+	newData.SetTimeStamp(nTimestamp);
+	newData.SetFrameNumber(++pNode->nFrames);
+	newData.SetPayloadSize(sourceRecord.GetPayloadSize());
+	newData.SetUndoRecordPos(pNode->nLastDataPos);
+	nRetVal = newData.Encode();
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorWriteRecord(pEditor, newData);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorCopyPayload(pEditor, source, sourceRecord);
+	XN_IS_STATUS_OK(nRetVal);
+
+	DataIndexEntry& entry = pNode->aDataIndexChunk[pNode->nDataIndexChunkEntries++];
+	entry.nTimestamp = nTimestamp;
+	entry.nConfigurationID = pEditor->nConfigurationID;
+	entry.nSeekPos = nRecordPos;
+
+	pNode->nLastDataPos = nRecordPos;
+	pNode->nMaxTimestamp = XN_MAX(pNode->nMaxTimestamp, nTimestamp);
+	pEditor->nGlobalMaxTimestamp = XN_MAX(pEditor->nGlobalMaxTimestamp, nTimestamp);
+
+	return (XN_STATUS_OK);
+}
+
+/* Second pass: copies the records of the selected nodes, up to the last frame to copy. */
+static XnStatus xnOniEditorCopySource(XnOniEditor* pEditor, XnOniEditorSource& source)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	Record record(pEditor->pSourceRecordBuffer, XN_ONI_RECORD_MAX_SIZE, source.format.bOld32Header);
+
+	while (source.nPos <= source.nLastCopyPos)
+	{
+		nRetVal = xnOniEditorReadRecord(source, record);
+		XN_IS_STATUS_OK(nRetVal);
+
+		XnOniEditorSourceNode* pSourceNode = xnOniEditorGetSourceNode(source, record.GetNodeID());
+		if (pSourceNode == NULL || !pSourceNode->bSelected)
+		{
+			xnOniEditorSkipPayload(source, record);
+			continue;
+		}
+
+		switch (record.GetType())
+		{
+		case RECORD_NODE_ADDED_1_0_0_4:
+		case RECORD_NODE_ADDED_1_0_0_5:
+		case RECORD_NODE_ADDED:
+			if (pSourceNode->pOutput == NULL && pEditor->nodes.Get(pSourceNode->strName, pSourceNode->pOutput) != XN_STATUS_OK)
+			{
+				nRetVal = xnOniEditorAddNode(pEditor, *pSourceNode, &pSourceNode->pOutput);
+				XN_IS_STATUS_OK(nRetVal);
+			}
+			break;
+		case RECORD_INT_PROPERTY:
+		case RECORD_REAL_PROPERTY:
+		case RECORD_STRING_PROPERTY:
+		case RECORD_GENERAL_PROPERTY:
+			XN_VALIDATE_PTR(pSourceNode->pOutput, XN_STATUS_CORRUPT_FILE);
+			nRetVal = xnOniEditorCopyProperty(pEditor, pSourceNode->pOutput, record);
+			XN_IS_STATUS_OK(nRetVal);
+			break;
+		case RECORD_NODE_STATE_READY:
+			XN_VALIDATE_PTR(pSourceNode->pOutput, XN_STATUS_CORRUPT_FILE);
+			if (!pSourceNode->pOutput->bStateReady)
+			{
+				NodeStateReadyRecord stateReady(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+				stateReady.SetNodeID(pSourceNode->pOutput->nNodeID);
+				nRetVal = stateReady.Encode();
+				XN_IS_STATUS_OK(nRetVal);
+				nRetVal = xnOniEditorWriteRecord(pEditor, stateReady);
+				XN_IS_STATUS_OK(nRetVal);
+
+				pSourceNode->pOutput->bStateReady = TRUE;
+				pEditor->nConfigurationID++;
+			}
+			break;
+		case RECORD_NEW_DATA:
+			{
+				NewDataRecordHeader newData(record);
+				nRetVal = newData.Decode();
+				XN_IS_STATUS_OK(nRetVal);
+
+				if (xnOniEditorIsInRange(source, newData.GetTimeStamp()))
+				{
+					XN_VALIDATE_PTR(pSourceNode->pOutput, XN_STATUS_CORRUPT_FILE);
+					nRetVal = xnOniEditorCopyFrame(pEditor, source, pSourceNode->pOutput, newData);
+					XN_IS_STATUS_OK(nRetVal);
+					continue;
+				}
+			}
+			break;
+		default:
+			// data begin records are written before the first copied frame, node removed records when the file
+			// is closed, and seek tables are rebuilt
+			break;
+		}
+
+		xnOniEditorSkipPayload(source, record);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static void xnOniEditorFree(XnOniEditor* pEditor)
+{
+	for (XnOniEditorNodes::Iterator it = pEditor->nodes.Begin(); it != pEditor->nodes.End(); ++it)
+	{
+		XN_DELETE(it->Value());
+	}
+
+	if (pEditor->hFile != XN_INVALID_FILE_HANDLE)
+	{
+		xnOSCloseFile(&pEditor->hFile);
+	}
+
+	XN_DELETE_ARR(pEditor->pWriteBuffer);
+	XN_DELETE_ARR(pEditor->pRecordBuffer);
+	XN_DELETE_ARR(pEditor->pSourceRecordBuffer);
+	XN_DELETE(pEditor);
+}
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+XN_C_API XnStatus xnOniEditorCreate(const XnChar* strFileName, XnOniEditor** ppEditor)
+{
+	XN_VALIDATE_INPUT_PTR(strFileName);
+	XN_VALIDATE_OUTPUT_PTR(ppEditor);
+
+	XnOniEditor* pEditor = XN_NEW(XnOniEditor);
+	XN_VALIDATE_ALLOC_PTR(pEditor);
+
+	pEditor->hFile = XN_INVALID_FILE_HANDLE;
+	pEditor->nWriteBufferUsed = 0;
+	pEditor->nFlushedBytes = 0;
+	pEditor->nNodes = 0;
+	pEditor->nConfigurationID = 0;
+	pEditor->nTimeOffset = 0;
+	pEditor->nGlobalMaxTimestamp = 0;
+	pEditor->pWriteBuffer = XN_NEW_ARR(XnUInt8, XN_ONI_EDITOR_WRITE_BUFFER_SIZE);
+	pEditor->pRecordBuffer = XN_NEW_ARR(XnUInt8, XN_ONI_RECORD_MAX_SIZE);
+	pEditor->pSourceRecordBuffer = XN_NEW_ARR(XnUInt8, XN_ONI_RECORD_MAX_SIZE);
+	if (pEditor->pWriteBuffer == NULL || pEditor->pRecordBuffer == NULL || pEditor->pSourceRecordBuffer == NULL)
+	{
+		xnOniEditorFree(pEditor);
+		return (XN_STATUS_ALLOC_FAILED);
+	}
+
+	XnStatus nRetVal = xnOSOpenFile(strFileName, XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE, &pEditor->hFile);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOniEditorFree(pEditor);
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_ONI_EDITOR, "Failed to create '%s': %s", strFileName, xnGetStatusString(nRetVal));
+	}
+
+	// like the recorder, invalid values mark the file as not finalized until it is closed
+	nRetVal = xnOniEditorWriteHeader(pEditor, INVALID_TIMESTAMP, INVALID_NODE_ID);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOniEditorFree(pEditor);
+		return (nRetVal);
+	}
+
+	*ppEditor = pEditor;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOniEditorAppend(XnOniEditor* pEditor, const XnChar* strSourceFile, const XnOniCopyOptions* pOptions)
+{
+	XN_VALIDATE_INPUT_PTR(pEditor);
+	XN_VALIDATE_INPUT_PTR(strSourceFile);
+
+	XnOniEditorSource source;
+	source.strFileName = strSourceFile;
+	source.hFile = XN_INVALID_FILE_HANDLE;
+	source.bKeepTimestamps = (pOptions != NULL && pOptions->bKeepTimestamps);
+	source.nStartTime = (pOptions == NULL) ? 0 : pOptions->nStartTime;
+	source.nEndTime = (pOptions == NULL || pOptions->nEndTime == 0) ? XN_MAX_UINT64 : pOptions->nEndTime;
+	source.nBaseTimestamp = XN_MAX_UINT64;
+	source.nLastCopyPos = 0;
+
+	if (source.nStartTime > source.nEndTime)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_ONI_EDITOR, "Range ends before it starts");
+	}
+
+	XnStatus nRetVal = xnOniEditorOpenSource(source);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOniEditorScanSource(pEditor, source, pOptions);
+	}
+
+	if (nRetVal == XN_STATUS_OK && source.nLastCopyPos == 0)
+	{
+		xnLogWarning(XN_MASK_ONI_EDITOR, "'%s' has no frames to copy in the requested range", strSourceFile);
+		nRetVal = XN_STATUS_NO_MATCH;
+	}
+
+	// kept timestamps must go on from what was already appended, or playback would go back in time
+	if (nRetVal == XN_STATUS_OK && source.bKeepTimestamps && pEditor->nTimeOffset != 0 && source.nBaseTimestamp <= pEditor->nGlobalMaxTimestamp)
+	{
+		xnLogWarning(XN_MASK_ONI_EDITOR, "The frames of '%s' start at %llu, before the end of the file (%llu). Their timestamps can't be kept.", strSourceFile, source.nBaseTimestamp, pEditor->nGlobalMaxTimestamp);
+		nRetVal = XN_STATUS_INVALID_OPERATION;
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		// second pass, from the first record
+		source.nPos = source.format.nFirstRecordPos;
+		nRetVal = xnOniEditorCopySource(pEditor, source);
+	}
+
+	if (source.hFile != XN_INVALID_FILE_HANDLE)
+	{
+		xnOSCloseFile(&source.hFile);
+	}
+
+	XN_IS_STATUS_OK(nRetVal);
+
+	// the next recording starts one frame after this one ends. The shortest frame interval of the copied
+	// nodes is used, so the highest frame rate keeps its pace across the cut.
+	XnUInt64 nFrameInterval = XN_MAX_UINT64;
+	for (XnOniEditorSourceNodes::ConstIterator it = source.nodes.Begin(); it != source.nodes.End(); ++it)
+	{
+		const XnOniEditorSourceNode& sourceNode = it->Value();
+		if (sourceNode.nFramesToCopy > 1)
+		{
+			nFrameInterval = XN_MIN(nFrameInterval, (sourceNode.nLastTimestamp - sourceNode.nFirstTimestamp) / (sourceNode.nFramesToCopy - 1));
+		}
+	}
+
+	if (nFrameInterval == XN_MAX_UINT64 || nFrameInterval == 0)
+	{
+		nFrameInterval = 1;
+	}
+
+	pEditor->nTimeOffset = pEditor->nGlobalMaxTimestamp + nFrameInterval;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOniEditorClose(XnOniEditor** ppEditor)
+{
+	XN_VALIDATE_INPUT_PTR(ppEditor);
+	XnOniEditor* pEditor = *ppEditor;
+	XN_VALIDATE_INPUT_PTR(pEditor);
+
+	// same layout as a closed recording: the end record, then every node's removal and the rest of its seek
+	// table. Its node added record and the header are then rewritten with the final counts.
+	EndRecord endRecord(pEditor->pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, FALSE);
+	XnStatus nRetVal = endRecord.Encode();
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOniEditorWriteRecord(pEditor, endRecord);
+	}
+
+	for (XnOniEditorNodes::Iterator it = pEditor->nodes.Begin(); nRetVal == XN_STATUS_OK && it != pEditor->nodes.End(); ++it)
+	{
+		nRetVal = xnOniEditorFinalizeNode(pEditor, it->Value());
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOniEditorWriteHeader(pEditor, pEditor->nGlobalMaxTimestamp, pEditor->nNodes);
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOniEditorFlush(pEditor);
+	}
+
+	xnOniEditorFree(pEditor);
+	*ppEditor = NULL;
+
+	return (nRetVal);
+}
+
+XN_C_API XnStatus xnOniEditorCopy(const XnChar* strSourceFile, const XnChar* strDestFile, const XnOniCopyOptions* pOptions)
+{
+	XnOniEditor* pEditor = NULL;
+	XnStatus nRetVal = xnOniEditorCreate(strDestFile, &pEditor);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOniEditorAppend(pEditor, strSourceFile, pOptions);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOniEditorClose(&pEditor);
+		xnOSDeleteFile(strDestFile);
+		return (nRetVal);
+	}
+
+	return xnOniEditorClose(&pEditor);
+}
@@ -0,0 +1,578 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOniFrameReader.h>
+#include <XnLog.h>
+#include <XnOSCpp.h>
+#include <XnArray.h>
+#include <XnHashT.h>
+#include <XnCodecIDs.h>
+#include <XnPropNames.h>
+#include "XnOniRecords.h"
+#include "../Modules/Common/XnLosslessCompression.h"
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef struct XnOniFrameReaderFrame
+{
+	XnUInt64 nPayloadPos;
+	XnUInt64 nTimestamp;
+	XnUInt32 nPayloadSize;
+	XnUInt32 nFrameID;
+	XnUInt16 nXRes;
+	XnUInt16 nYRes;
+} XnOniFrameReaderFrame;
+
+typedef struct XnOniFrameReaderNode
+{
+	XnOniNodeInfo info;
+	/* The node's configuration at the current indexing position. Each frame keeps the resolution it was recorded in. */
+	XnMapOutputMode mode;
+	XnCropping cropping;
+	XnUInt32 nBytesPerPixel;
+	XnArray<XnOniFrameReaderFrame> frames;
+} XnOniFrameReaderNode;
+
+typedef XnHashT<XnUInt32, XnOniFrameReaderNode*> XnOniFrameReaderNodeIDs;
+
+struct XnOniFrameReader
+{
+	XN_FILE_HANDLE hFile;
+	XnArray<XnOniFrameReaderNode*> nodes;
+	/* Size of the largest stored frame. All decode buffers are that big. */
+	XnUInt32 nMaxPayloadSize;
+	/* Decode buffers not in use. A reading thread takes one for the duration of a read, so there are never
+	   more of them than threads that read at the same time, and the lock is only held to pop or push one. */
+	XnArray<XnUInt8*> freeDecodeBuffers;
+	XN_CRITICAL_SECTION_HANDLE hDecodeBuffersLock;
+};
+
+//---------------------------------------------------------------------------
+// Indexing
+//---------------------------------------------------------------------------
+static XnUInt32 xnOniFrameReaderDefaultBytesPerPixel(XnCodecID codec)
+{
+	switch (codec)
+	{
+	case XN_CODEC_16Z:
+	case XN_CODEC_16Z_EMB_TABLES:
+	case XN_CODEC_16Z_ANS:
+		return sizeof(XnUInt16);
+	case XN_CODEC_JPEG:
+	case XN_CODEC_IMAGE_LOSSLESS:
+		return sizeof(XnRGB24Pixel);
+	default:
+		return sizeof(XnUInt8);
+	}
+}
+
+static XnStatus xnOniFrameReaderAddNode(XnOniFrameReader* pReader, const NodeAdded_1_0_0_4_Record& record, XnOniFrameReaderNode** ppNode)
+{
+	// a node that was removed and added again keeps its frames
+	for (XnUInt32 i = 0; i < pReader->nodes.GetSize(); ++i)
+	{
+		if (xnOSStrCmp(pReader->nodes[i]->info.strName, record.GetNodeName()) == 0)
+		{
+			*ppNode = pReader->nodes[i];
+			return (XN_STATUS_OK);
+		}
+	}
+
+	XnOniFrameReaderNode* pNode = XN_NEW(XnOniFrameReaderNode);
+	XN_VALIDATE_ALLOC_PTR(pNode);
+
+	xnOSMemSet(&pNode->info, 0, sizeof(pNode->info));
+	xnOSStrCopy(pNode->info.strName, record.GetNodeName(), sizeof(pNode->info.strName));
+	pNode->info.type = record.GetNodeType();
+	pNode->info.codec = record.GetCompression();
+	xnOSMemSet(&pNode->mode, 0, sizeof(pNode->mode));
+	xnOSMemSet(&pNode->cropping, 0, sizeof(pNode->cropping));
+	pNode->nBytesPerPixel = xnOniFrameReaderDefaultBytesPerPixel(pNode->info.codec);
+
+	XnStatus nRetVal = pReader->nodes.AddLast(pNode);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_DELETE(pNode);
+		return (nRetVal);
+	}
+
+	*ppNode = pNode;
+
+	return (XN_STATUS_OK);
+}
+
+static void xnOniFrameReaderUpdateConfiguration(XnOniFrameReaderNode* pNode, const Record& record)
+{
+	// all property records have the same layout (name, size, value), only their type differs
+	GeneralPropRecord prop(record);
+	if (prop.Decode() != XN_STATUS_OK)
+	{
+		return;
+	}
+
+	if (record.GetType() == RECORD_GENERAL_PROPERTY)
+	{
+		if (xnOSStrCmp(prop.GetPropName(), XN_PROP_MAP_OUTPUT_MODE) == 0 && prop.GetPropDataSize() == sizeof(pNode->mode))
+		{
+			xnOSMemCopy(&pNode->mode, prop.GetPropData(), sizeof(pNode->mode));
+		}
+		else if (xnOSStrCmp(prop.GetPropName(), XN_PROP_CROPPING) == 0 && prop.GetPropDataSize() == sizeof(pNode->cropping))
+		{
+			xnOSMemCopy(&pNode->cropping, prop.GetPropData(), sizeof(pNode->cropping));
+		}
+	}
+	else if (record.GetType() == RECORD_INT_PROPERTY && xnOSStrCmp(prop.GetPropName(), XN_PROP_BYTES_PER_PIXEL) == 0)
+	{
+		IntPropRecord intProp(record);
+		if (intProp.Decode() == XN_STATUS_OK && intProp.GetValue() != 0)
+		{
+			pNode->nBytesPerPixel = (XnUInt32)intProp.GetValue();
+		}
+	}
+}
+
+static XnStatus xnOniFrameReaderAddFrame(XnOniFrameReader* pReader, XnOniFrameReaderNode* pNode, const NewDataRecordHeader& record, XnUInt64 nPayloadPos)
+{
+	XnOniFrameReaderFrame frame;
+	frame.nPayloadPos = nPayloadPos;
+	frame.nTimestamp = record.GetTimeStamp();
+	frame.nPayloadSize = record.GetPayloadSize();
+	frame.nFrameID = record.GetFrameNumber();
+	frame.nXRes = (XnUInt16)(pNode->cropping.bEnabled ? pNode->cropping.nXSize : pNode->mode.nXRes);
+	frame.nYRes = (XnUInt16)(pNode->cropping.bEnabled ? pNode->cropping.nYSize : pNode->mode.nYRes);
+
+	XnStatus nRetVal = pNode->frames.AddLast(frame);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnOniNodeInfo& info = pNode->info;
+	if (info.nFrames == 0)
+	{
+		info.nMinTimestamp = frame.nTimestamp;
+	}
+	info.nFrames++;
+	info.nMinTimestamp = XN_MIN(info.nMinTimestamp, frame.nTimestamp);
+	info.nMaxTimestamp = XN_MAX(info.nMaxTimestamp, frame.nTimestamp);
+
+	XnUInt32 nDecodedSize = frame.nPayloadSize;
+	if (info.codec != XN_CODEC_UNCOMPRESSED && info.codec != XN_CODEC_NULL)
+	{
+		nDecodedSize = XN_MAX(nDecodedSize, (XnUInt32)frame.nXRes * frame.nYRes * pNode->nBytesPerPixel);
+	}
+	if (info.codec == XN_CODEC_AUDIO_LOSSLESS)
+	{
+		// audio has no resolution, so take the most a frame of this size can decode to
+		nDecodedSize = frame.nPayloadSize * XN_STREAM_COMPRESSION_AUDIO_LOSSLESS_MAX_EXPANSION;
+	}
+	info.nMaxFrameSize = XN_MAX(info.nMaxFrameSize, nDecodedSize);
+
+	pReader->nMaxPayloadSize = XN_MAX(pReader->nMaxPayloadSize, frame.nPayloadSize);
+
+	return (XN_STATUS_OK);
+}
+
+/* Walks all the records of the file once, reading only their fields, to find where every frame is. */
+static XnStatus xnOniFrameReaderIndex(XnOniFrameReader* pReader, const XnChar* strFileName)
+{
+	XnOniFileFormat format;
+	XnStatus nRetVal = xnOniReadHeader(pReader->hFile, strFileName, &format);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUInt64 nFileSize = 0;
+	nRetVal = xnOSGetFileSize64(strFileName, &nFileSize);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUInt8* pRecordBuffer = (XnUInt8*)xnOSMalloc(XN_ONI_RECORD_MAX_SIZE);
+	XN_VALIDATE_ALLOC_PTR(pRecordBuffer);
+
+	Record record(pRecordBuffer, XN_ONI_RECORD_MAX_SIZE, format.bOld32Header);
+	XnOniFrameReaderNodeIDs nodeIDs;
+	XnUInt64 nPos = format.nFirstRecordPos;
+
+	for (;;)
+	{
+		nRetVal = xnOniReadRecord(pReader->hFile, nPos, &format, record);
+		if (nRetVal != XN_STATUS_OK || record.GetType() == RECORD_END)
+		{
+			break;
+		}
+
+		XnUInt64 nPayloadPos = nPos + record.GetSize();
+		XnOniFrameReaderNode* pNode = NULL;
+		nodeIDs.Get(record.GetNodeID(), pNode);
+
+		switch (record.GetType())
+		{
+		case RECORD_NODE_ADDED_1_0_0_4:
+		case RECORD_NODE_ADDED_1_0_0_5:
+		case RECORD_NODE_ADDED:
+			{
+				// all versions start with the name, type and codec
+				NodeAdded_1_0_0_4_Record nodeAdded(record);
+				nRetVal = nodeAdded.Decode();
+				if (nRetVal == XN_STATUS_OK)
+				{
+					nRetVal = xnOniFrameReaderAddNode(pReader, nodeAdded, &pNode);
+				}
+				if (nRetVal == XN_STATUS_OK)
+				{
+					nRetVal = nodeIDs.Set(record.GetNodeID(), pNode);
+				}
+			}
+			break;
+		case RECORD_INT_PROPERTY:
+		case RECORD_GENERAL_PROPERTY:
+			if (pNode != NULL)
+			{
+				xnOniFrameReaderUpdateConfiguration(pNode, record);
+			}
+			break;
+		case RECORD_NEW_DATA:
+			{
+				if (pNode == NULL)
+				{
+					xnLogWarning(XN_MASK_ONI_FRAME_READER, "Frame at position %llu belongs to an unknown node", nPos);
+					nRetVal = XN_STATUS_CORRUPT_FILE;
+					break;
+				}
+
+				if (nPayloadPos + record.GetPayloadSize() > nFileSize)
+				{
+					// the last frame of a recording that was not closed may be partial
+					nRetVal = format.bOpenEnded ? XN_STATUS_EOF : XN_STATUS_CORRUPT_FILE;
+					break;
+				}
+
+				NewDataRecordHeader newData(record);
+				nRetVal = newData.Decode();
+				if (nRetVal == XN_STATUS_OK)
+				{
+					nRetVal = xnOniFrameReaderAddFrame(pReader, pNode, newData, nPayloadPos);
+				}
+			}
+			break;
+		default:
+			// nothing else affects where frames are, or how they are decoded
+			break;
+		}
+
+		if (nRetVal != XN_STATUS_OK)
+		{
+			break;
+		}
+
+		nPos = nPayloadPos + record.GetPayloadSize();
+	}
+
+	xnOSFree(pRecordBuffer);
+
+	if (nRetVal == XN_STATUS_EOF)
+	{
+		nRetVal = XN_STATUS_OK;
+	}
+
+	return (nRetVal);
+}
+
+//---------------------------------------------------------------------------
+// Reading
+//---------------------------------------------------------------------------
+static XnStatus xnOniFrameReaderGetFrame(const XnOniFrameReader* pReader, XnUInt32 nNode, XnUInt32 nFrame, const XnOniFrameReaderNode** ppNode, const XnOniFrameReaderFrame** ppFrame)
+{
+	if (nNode >= pReader->nodes.GetSize())
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_ONI_FRAME_READER, "Invalid node number: %u (the recording has %u nodes)", nNode, pReader->nodes.GetSize());
+	}
+
+	const XnOniFrameReaderNode* pNode = pReader->nodes[nNode];
+	if (nFrame >= pNode->frames.GetSize())
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_ONI_FRAME_READER, "Invalid frame index: %u (node '%s' has %u frames)", nFrame, pNode->info.strName, pNode->frames.GetSize());
+	}
+
+	*ppNode = pNode;
+	*ppFrame = &pNode->frames[nFrame];
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOniFrameReaderReadPayload(XnOniFrameReader* pReader, const XnOniFrameReaderFrame* pFrame, void* pBuffer)
+{
+	XnUInt32 nBytesRead = pFrame->nPayloadSize;
+	XnStatus nRetVal = xnOSReadFileAt(pReader->hFile, pFrame->nPayloadPos, pBuffer, &nBytesRead);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nBytesRead != pFrame->nPayloadSize)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_ONI_FRAME_READER, "Frame at position %llu is truncated", pFrame->nPayloadPos);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static void xnOniFrameReaderFillFrameInfo(const XnOniFrameReaderFrame* pFrame, XnUInt32 nDataSize, XnOniFrameInfo* pFrameInfo)
+{
+	if (pFrameInfo != NULL)
+	{
+		pFrameInfo->nFrameID = pFrame->nFrameID;
+		pFrameInfo->nTimestamp = pFrame->nTimestamp;
+		pFrameInfo->nDataSize = nDataSize;
+		pFrameInfo->nXRes = pFrame->nXRes;
+		pFrameInfo->nYRes = pFrame->nYRes;
+	}
+}
+
+static XnStatus xnOniFrameReaderTakeDecodeBuffer(XnOniFrameReader* pReader, XnUInt8** ppBuffer)
+{
+	{
+		XnAutoCSLocker locker(pReader->hDecodeBuffersLock);
+		XnUInt32 nFree = pReader->freeDecodeBuffers.GetSize();
+		if (nFree > 0)
+		{
+			*ppBuffer = pReader->freeDecodeBuffers[nFree - 1];
+			return pReader->freeDecodeBuffers.SetSize(nFree - 1);
+		}
+	}
+
+	// more threads are reading than ever before
+	*ppBuffer = (XnUInt8*)xnOSMalloc(pReader->nMaxPayloadSize);
+	XN_VALIDATE_ALLOC_PTR(*ppBuffer);
+
+	return (XN_STATUS_OK);
+}
+
+static void xnOniFrameReaderReturnDecodeBuffer(XnOniFrameReader* pReader, XnUInt8* pBuffer)
+{
+	XnAutoCSLocker locker(pReader->hDecodeBuffersLock);
+	if (pReader->freeDecodeBuffers.AddLast(pBuffer) != XN_STATUS_OK)
+	{
+		xnOSFree(pBuffer);
+	}
+}
+
+static XnStatus xnOniFrameReaderDecode(XnCodecID codec, const XnUInt8* pCompressed, XnUInt32 nCompressedSize, void* pBuffer, XnUInt32* pnDataSize)
+{
+	switch (codec)
+	{
+	case XN_CODEC_16Z:
+		return XnStreamUncompressDepth16Z(pCompressed, nCompressedSize, (XnUInt16*)pBuffer, pnDataSize);
+	case XN_CODEC_16Z_EMB_TABLES:
+		return XnStreamUncompressDepth16ZWithEmbTable(pCompressed, nCompressedSize, (XnUInt16*)pBuffer, pnDataSize);
+	case XN_CODEC_16Z_ANS:
+		return XnStreamUncompressDepth16ZAns(pCompressed, nCompressedSize, (XnUInt16*)pBuffer, pnDataSize);
+	case XN_CODEC_8Z:
+		return XnStreamUncompressImage8Z(pCompressed, nCompressedSize, (XnUInt8*)pBuffer, pnDataSize);
+	case XN_CODEC_IMAGE_LOSSLESS:
+		return XnStreamUncompressImageLossless(pCompressed, nCompressedSize, (XnUInt8*)pBuffer, pnDataSize);
+	case XN_CODEC_AUDIO_LOSSLESS:
+		return XnStreamUncompressAudioLossless(pCompressed, nCompressedSize, (XnUInt8*)pBuffer, pnDataSize);
+	default:
+		return (XN_STATUS_NOT_IMPLEMENTED);
+	}
+}
+
+//---------------------------------------------------------------------------
+// Exported Functions
+//---------------------------------------------------------------------------
+XN_C_API XnStatus xnOniFrameReaderOpen(const XnChar* strFileName, XnOniFrameReader** ppReader)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strFileName);
+	XN_VALIDATE_OUTPUT_PTR(ppReader);
+
+	XnOniFrameReader* pReader = XN_NEW(XnOniFrameReader);
+	XN_VALIDATE_ALLOC_PTR(pReader);
+
+	pReader->hFile = XN_INVALID_FILE_HANDLE;
+	pReader->nMaxPayloadSize = 0;
+	pReader->hDecodeBuffersLock = NULL;
+
+	nRetVal = xnOSCreateCriticalSection(&pReader->hDecodeBuffersLock);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSOpenFile(strFileName, XN_OS_FILE_READ, &pReader->hFile);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_ONI_FRAME_READER, "Failed to open '%s': %s", strFileName, xnGetStatusString(nRetVal));
+		}
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOniFrameReaderIndex(pReader, strFileName);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOniFrameReaderClose(&pReader);
+		return (nRetVal);
+	}
+
+	*ppReader = pReader;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOniFrameReaderClose(XnOniFrameReader** ppReader)
+{
+	XN_VALIDATE_INPUT_PTR(ppReader);
+
+	XnOniFrameReader* pReader = *ppReader;
+	if (pReader == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	if (pReader->hFile != XN_INVALID_FILE_HANDLE)
+	{
+		xnOSCloseFile(&pReader->hFile);
+	}
+
+	for (XnUInt32 i = 0; i < pReader->nodes.GetSize(); ++i)
+	{
+		XN_DELETE(pReader->nodes[i]);
+	}
+
+	for (XnUInt32 i = 0; i < pReader->freeDecodeBuffers.GetSize(); ++i)
+	{
+		xnOSFree(pReader->freeDecodeBuffers[i]);
+	}
+
+	if (pReader->hDecodeBuffersLock != NULL)
+	{
+		xnOSCloseCriticalSection(&pReader->hDecodeBuffersLock);
+	}
+
+	XN_DELETE(pReader);
+	*ppReader = NULL;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnUInt32 xnOniFrameReaderGetNodeCount(const XnOniFrameReader* pReader)
+{
+	XN_RET_IF_NULL(pReader, 0);
+	return pReader->nodes.GetSize();
+}
+
+XN_C_API XnStatus xnOniFrameReaderFindNode(const XnOniFrameReader* pReader, const XnChar* strNodeName, XnUInt32* pnNode)
+{
+	XN_VALIDATE_INPUT_PTR(pReader);
+	XN_VALIDATE_INPUT_PTR(strNodeName);
+	XN_VALIDATE_OUTPUT_PTR(pnNode);
+
+	for (XnUInt32 i = 0; i < pReader->nodes.GetSize(); ++i)
+	{
+		if (xnOSStrCmp(pReader->nodes[i]->info.strName, strNodeName) == 0)
+		{
+			*pnNode = i;
+			return (XN_STATUS_OK);
+		}
+	}
+
+	return (XN_STATUS_NO_MATCH);
+}
+
+XN_C_API XnStatus xnOniFrameReaderGetNodeInfo(const XnOniFrameReader* pReader, XnUInt32 nNode, XnOniNodeInfo* pInfo)
+{
+	XN_VALIDATE_INPUT_PTR(pReader);
+	XN_VALIDATE_OUTPUT_PTR(pInfo);
+
+	if (nNode >= pReader->nodes.GetSize())
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	*pInfo = pReader->nodes[nNode]->info;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOniFrameReaderReadRawFrame(XnOniFrameReader* pReader, XnUInt32 nNode, XnUInt32 nFrame, void* pBuffer, XnUInt32 nBufferSize, XnOniFrameInfo* pFrameInfo)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pReader);
+	XN_VALIDATE_OUTPUT_PTR(pBuffer);
+
+	const XnOniFrameReaderNode* pNode = NULL;
+	const XnOniFrameReaderFrame* pFrame = NULL;
+	nRetVal = xnOniFrameReaderGetFrame(pReader, nNode, nFrame, &pNode, &pFrame);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nBufferSize < pFrame->nPayloadSize)
+	{
+		return (XN_STATUS_OUTPUT_BUFFER_OVERFLOW);
+	}
+
+	nRetVal = xnOniFrameReaderReadPayload(pReader, pFrame, pBuffer);
+	XN_IS_STATUS_OK(nRetVal);
+
+	xnOniFrameReaderFillFrameInfo(pFrame, pFrame->nPayloadSize, pFrameInfo);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOniFrameReaderReadFrame(XnOniFrameReader* pReader, XnUInt32 nNode, XnUInt32 nFrame, void* pBuffer, XnUInt32 nBufferSize, XnOniFrameInfo* pFrameInfo)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(pReader);
+	XN_VALIDATE_OUTPUT_PTR(pBuffer);
+
+	const XnOniFrameReaderNode* pNode = NULL;
+	const XnOniFrameReaderFrame* pFrame = NULL;
+	nRetVal = xnOniFrameReaderGetFrame(pReader, nNode, nFrame, &pNode, &pFrame);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnCodecID codec = pNode->info.codec;
+	if (codec == XN_CODEC_UNCOMPRESSED || codec == XN_CODEC_NULL)
+	{
+		// nothing to decode, so read straight into the caller's buffer
+		return xnOniFrameReaderReadRawFrame(pReader, nNode, nFrame, pBuffer, nBufferSize, pFrameInfo);
+	}
+
+	if (codec != XN_CODEC_16Z && codec != XN_CODEC_16Z_EMB_TABLES && codec != XN_CODEC_16Z_ANS && codec != XN_CODEC_8Z && codec != XN_CODEC_IMAGE_LOSSLESS && codec != XN_CODEC_AUDIO_LOSSLESS)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_NOT_IMPLEMENTED, XN_MASK_ONI_FRAME_READER, "Can't decode frames of node '%s' (codec %.4s). Read them raw instead.", pNode->info.strName, (const XnChar*)&codec);
+	}
+
+	XnUInt8* pDecodeBuffer = NULL;
+	nRetVal = xnOniFrameReaderTakeDecodeBuffer(pReader, &pDecodeBuffer);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUInt32 nDataSize = nBufferSize;
+	nRetVal = xnOniFrameReaderReadPayload(pReader, pFrame, pDecodeBuffer);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOniFrameReaderDecode(codec, pDecodeBuffer, pFrame->nPayloadSize, pBuffer, &nDataSize);
+	}
+
+	xnOniFrameReaderReturnDecodeBuffer(pReader, pDecodeBuffer);
+	XN_IS_STATUS_OK(nRetVal);
+
+	xnOniFrameReaderFillFrameInfo(pFrame, nDataSize, pFrameInfo);
+
+	return (XN_STATUS_OK);
+}
@@ -0,0 +1,91 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "XnOniRecords.h"
+#include <XnLog.h>
+#include <XnUtils.h>
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+XnStatus xnOniReadHeader(XN_FILE_HANDLE hFile, const XnChar* strFileName, XnOniFileFormat* pFormat)
+{
+	static const XnVersion OLDEST_SUPPORTED_VERSION = {1, 0, 0, 4};
+	static const XnVersion FIRST_FILESIZE64BIT_VERSION = {1, 0, 1, 0};
+
+	RecordingHeader header;
+	XnUInt32 nBytesRead = sizeof(header);
+	XnStatus nRetVal = xnOSReadFileAt(hFile, 0, &header, &nBytesRead);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nBytesRead != sizeof(header) || xnOSMemCmp(header.headerMagic, DEFAULT_RECORDING_HEADER.headerMagic, sizeof(header.headerMagic)) != 0)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_ONI_RECORDS, "'%s' is not a recording", strFileName);
+	}
+
+	if ((xnVersionCompare(&header.version, &OLDEST_SUPPORTED_VERSION) < 0) ||
+		(xnVersionCompare(&header.version, &DEFAULT_RECORDING_HEADER.version) > 0))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_UNSUPPORTED_VERSION, XN_MASK_ONI_RECORDS, "'%s' has an unsupported file format version: %u.%u.%u.%u", strFileName, header.version.nMajor, header.version.nMinor, header.version.nMaintenance, header.version.nBuild);
+	}
+
+	pFormat->bOld32Header = (xnVersionCompare(&header.version, &FIRST_FILESIZE64BIT_VERSION) < 0);
+	pFormat->bOpenEnded = (header.nMaxNodeID == INVALID_NODE_ID);
+	pFormat->nFirstRecordPos = sizeof(header);
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus xnOniReadRecord(XN_FILE_HANDLE hFile, XnUInt64 nPos, const XnOniFileFormat* pFormat, Record& record)
+{
+	XnUInt32 nBytesRead = record.HEADER_SIZE;
+	XnStatus nRetVal = xnOSReadFileAt(hFile, nPos, record.GetData(), &nBytesRead);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nBytesRead != record.HEADER_SIZE || !record.IsHeaderValid() ||
+		record.GetSize() < record.HEADER_SIZE || record.GetSize() > XN_ONI_RECORD_MAX_SIZE)
+	{
+		if (pFormat->bOpenEnded)
+		{
+			// a recording that was not closed ends wherever writing stopped
+			return (XN_STATUS_EOF);
+		}
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_ONI_RECORDS, "Invalid record at position %llu", nPos);
+	}
+
+	XnUInt32 nFieldsSize = record.GetSize() - record.HEADER_SIZE;
+	nBytesRead = nFieldsSize;
+	nRetVal = xnOSReadFileAt(hFile, nPos + record.HEADER_SIZE, record.GetData() + record.HEADER_SIZE, &nBytesRead);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nBytesRead != nFieldsSize)
+	{
+		if (pFormat->bOpenEnded)
+		{
+			return (XN_STATUS_EOF);
+		}
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_ONI_RECORDS, "Record at position %llu is truncated", nPos);
+	}
+
+	return (XN_STATUS_OK);
+}
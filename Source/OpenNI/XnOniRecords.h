@@ -0,0 +1,72 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef __XN_ONI_RECORDS_H__
+#define __XN_ONI_RECORDS_H__
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include "../Modules/Common/DataRecords.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_MASK_ONI_RECORDS "OniRecords"
+
+/** Largest record (without its payload) in a recording. Records are read into buffers of this size. */
+#define XN_ONI_RECORD_MAX_SIZE	(20 * 1024)
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/** How the records of a recording are read, as told by its header. */
+typedef struct XnOniFileFormat
+{
+	/** TRUE for files older than 1.0.1.0, whose records have 32-bit positions. */
+	XnBool bOld32Header;
+	/** TRUE if the recording was not closed, so it ends wherever writing stopped. */
+	XnBool bOpenEnded;
+	/** Position of the first record. */
+	XnUInt64 nFirstRecordPos;
+} XnOniFileFormat;
+
+//---------------------------------------------------------------------------
+// Functions
+//---------------------------------------------------------------------------
+/**
+* Reads the header of a recording, and checks that it is one whose version can be read.
+*
+* @param	hFile			[in]	The open recording.
+* @param	strFileName		[in]	Its name, for error messages.
+* @param	pFormat			[out]	How to read its records.
+*/
+XnStatus xnOniReadHeader(XN_FILE_HANDLE hFile, const XnChar* strFileName, XnOniFileFormat* pFormat);
+
+/**
+* Reads a record, without its payload, from a position of a recording. The record's buffer should be
+* @ref XN_ONI_RECORD_MAX_SIZE bytes long. Does not move the file pointer.
+*
+* @returns XN_STATUS_EOF if the recording was not closed, and ends at that position.
+*/
+XnStatus xnOniReadRecord(XN_FILE_HANDLE hFile, XnUInt64 nPos, const XnOniFileFormat* pFormat, Record& record);
+
+#endif // __XN_ONI_RECORDS_H__
@@ -41,6 +41,7 @@
 #include <math.h>
 #include <XnPropNames.h>
 #include "XnTypeManager.h"
+#include <XnTrace.h>
 
 //---------------------------------------------------------------------------
 // Defines
@@ -155,7 +156,6 @@ XN_C_API XnStatus xnInit(XnContext** ppContext)
 	pContext->hLock = 0;
 	pContext->pDumpRefCount = xnDumpFileOpen(XN_DUMP_MASK_REF_COUNT, "RefCount.csv");
 	pContext->pDumpDataFlow = xnDumpFileOpen(XN_DUMP_MASK_DATA_FLOW, "DataFlow.csv");
-	pContext->hPlayerNode = NULL;
 
 	xnDumpFileWriteString(pContext->pDumpRefCount, "Timestamp,Object,RefCount,Comment\n");
 	xnDumpFileWriteString(pContext->pDumpDataFlow, "Timestamp,Action,Object,DataTimestamp\n");
@@ -362,9 +362,21 @@ XN_C_API XnStatus xnInitFromXmlFileEx(const XnChar* strFileName, XnContext** ppC
 	*ppContext = NULL;
 	*phScriptNode = NULL;
 
-	nRetVal = xnLogInitFromXmlFile(strFileName);
+	// the log and thread settings share one parse of the file
+	TiXmlDocument doc;
+	nRetVal = xnXmlLoadDocument(doc, strFileName);
 	XN_IS_STATUS_OK(nRetVal);
 
+	nRetVal = xnLogInitFromXml(doc.RootElement());
+	XN_IS_STATUS_OK(nRetVal);
+
+	// threads without a policy just keep the OS defaults, so a bad <Threads> entry shouldn't fail the whole init
+	nRetVal = xnOSLoadThreadPoliciesFromXml(doc.RootElement());
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogWarning(XN_MASK_OPEN_NI, "Some thread policies in '%s' were ignored: %s", strFileName, xnGetStatusString(nRetVal));
+	}
+
 	XnContext* pContext;
 	nRetVal = xnInit(&pContext);
 	XN_IS_STATUS_OK(nRetVal);
@@ -449,6 +461,9 @@ static void xnContextDestroy(XnContext* pContext, XnBool bForce /* = FALSE */)
 		xnDumpRefCount(pContext, NULL, 0, "Destroy");
 		xnDumpFileClose(pContext->pDumpRefCount);
 
+		// the exporter reads the nodes, so it must be stopped before they are destroyed
+		xnMetricsExporterDestroy(&pContext->pMetricsExporter);
+
 		// we have to destroy nodes from top to bottom. So we'll go over the list, each time removing
 		// nodes that nobody needs, until the list is empty
 		while (!pContext->nodesMap.IsEmpty())
@@ -482,7 +497,7 @@ static void xnContextDestroy(XnContext* pContext, XnBool bForce /* = FALSE */)
 	#ifdef _WIN32
 		xnOSWriteMemoryReport("C:\\xnMemProf.txt");
 	#else
-		//TODO: Something for Linux
+		xnOSWriteMemoryReport("xnMemProf.txt");
 	#endif
 #endif
 	}
@@ -1496,11 +1511,15 @@ XnStatus xnCreatePrivateData(XnInternalNodeData* pNodeData)
 
 void XN_CALLBACK_TYPE xnGeneratorHasNewData(XnNodeHandle hNode, void* /*pCookie*/)
 {
+	xnMetricsMarkNewData(&hNode->metrics);
 	xnMarkFPSFrame(hNode->pContext, &hNode->genFPS);
 	xnOSSetEvent(hNode->pContext->hNewDataEvent);
 	XnUInt64 nNow;
 	xnOSGetHighResTimeStamp(&nNow);
 	xnDumpFileWriteString(hNode->pContext->pDumpDataFlow, "%llu,NewDataAvailable,%s,\n", nNow, hNode->pNodeInfo->strInstanceName);
+
+	// the frame itself is not known yet, only the report's number, which the update consuming it traces too
+	XN_TRACE_INSTANT(XN_TRACE_NEW_DATA_AVAILABLE, hNode->pNodeInfo->strInstanceName, 0, xnTraceReportNewData(hNode->pNodeInfo->strInstanceName), 0);
 }
 
 void XN_CALLBACK_TYPE xnNodeLockChanged(XnNodeHandle hNode, void* /*pCookie*/)
@@ -1732,7 +1751,8 @@ static XnStatus xnCreateProductionNodeImpl(XnContext* pContext, XnNodeInfo* pTre
 		xnNodeFrameSyncChanged(pNodeData, NULL);
 	}
 
-	// add it to the context
+	// add it to the context (the map is read by metrics snapshots, which may come from other threads)
+	XnAutoCSLocker contextLocker(pContext->hLock);
 	nRetVal = pContext->nodesMap.Set(pTree->strInstanceName, pNodeData);
 	if (nRetVal != XN_STATUS_OK)
 	{
@@ -1742,8 +1762,14 @@ static XnStatus xnCreateProductionNodeImpl(XnContext* pContext, XnNodeInfo* pTre
 	// if this is a player node, store it in the context (so we'll know to play it...)
 	if (pNodeData->pModuleInstance->pLoaded->pInterface->HierarchyType.IsSet(XN_NODE_TYPE_PLAYER))
 	{
-		pContext->hPlayerNode = pNodeData;
+		nRetVal = pContext->playerNodes.AddLast(pNodeData);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			pContext->nodesMap.Remove(pTree->strInstanceName);
+			return xnFreeProductionNodeImpl(pNodeData, nRetVal);
+		}
 	}
+	contextLocker.Unlock();
 
 	// increase info ref count (context now holds it)
 	++pTree->nRefCount;
@@ -1857,10 +1883,8 @@ static XnStatus xnFreeProductionNodeImpl(XnNodeHandle hNode, XnStatus nRetVal /*
 		}
 		else if (hNode->pTypeHierarchy->IsSet(XN_NODE_TYPE_PLAYER))
 		{
-			// remove it from the context
-			hNode->pContext->hPlayerNode = NULL;
-
-			// TODO: We might want to check if another player exists instead (so playback can continue with that player...)
+			// remove it from the context (playback continues with the other players, if any)
+			hNode->pContext->playerNodes.Remove(hNode);
 		}
 
 		// free all registration cookies that were not unregistered
@@ -1931,7 +1955,10 @@ void xnDestroyProductionNodeImpl(XnNodeHandle hNode)
 	}
 
 	// remove it from map
-	hNode->pContext->nodesMap.Remove(hNode->pNodeInfo->strInstanceName);
+	{
+		XnAutoCSLocker contextLocker(hNode->pContext->hLock);
+		hNode->pContext->nodesMap.Remove(hNode->pNodeInfo->strInstanceName);
+	}
 	// destroy module node
 	hNode->pContext->moduleLoader.DestroyModuleInstance(hNode->pModuleInstance);
 
@@ -2175,6 +2202,81 @@ XN_C_API XnStatus xnCreateMockNodeBasedOn(XnContext* pContext,
 	return XN_STATUS_OK;
 }
 
+XN_C_API XnStatus xnCreateFilter(XnContext* pContext, XnNodeHandle hInput, const XnChar* strStages, const XnChar* strName, XnNodeHandle* phFilter)
+{
+	XN_VALIDATE_INPUT_PTR(pContext);
+	XN_VALIDATE_INPUT_PTR(hInput);
+	//strStages and strName may be NULL
+	XN_VALIDATE_OUTPUT_PTR(phFilter);
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnProductionNodeType type;
+	if (hInput->pTypeHierarchy->IsSet(XN_NODE_TYPE_DEPTH))
+	{
+		type = XN_NODE_TYPE_DEPTH;
+	}
+	else if (hInput->pTypeHierarchy->IsSet(XN_NODE_TYPE_IMAGE))
+	{
+		type = XN_NODE_TYPE_IMAGE;
+	}
+	else
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_TYPE, XN_MASK_OPEN_NI, "Only depth and image generators can be filtered ('%s' is neither)", xnGetNodeName(hInput));
+	}
+
+	if (strStages != NULL && strlen(strStages) >= XN_MAX_CREATION_INFO_LENGTH)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Filter stages string is too long");
+	}
+
+	XnChar strFilterName[XN_MAX_NAME_LENGTH];
+	if (strName == NULL)
+	{
+		XnUInt32 nCharsWritten = 0;
+		nRetVal = xnOSStrFormat(strFilterName, sizeof(strFilterName), &nCharsWritten, "%s_%s", xnGetNodeName(hInput), XN_FILTER_NODE_NAME);
+		XN_IS_STATUS_OK_ASSERT(nRetVal);
+		strName = strFilterName;
+	}
+
+	// create a description for this node
+	XnProductionNodeDescription description;
+	strcpy(description.strVendor, XN_VENDOR_OPEN_NI);
+	strcpy(description.strName, XN_FILTER_NODE_NAME);
+	description.Type = type;
+	xnGetVersion(&description.Version);
+
+	// the input is the filter's only needed node, so it will always be updated before the filter
+	XnNodeInfoList* pNeededNodes = NULL;
+	nRetVal = xnNodeInfoListAllocate(&pNeededNodes);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnNodeInfoListAddNode(pNeededNodes, hInput->pNodeInfo);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnNodeInfoListFree(pNeededNodes);
+		return (nRetVal);
+	}
+
+	// stages are kept as the creation info
+	XnNodeInfo* pNodeInfo = NULL;
+	nRetVal = xnNodeInfoAllocate(&description, strStages, pNeededNodes, &pNodeInfo);
+	xnNodeInfoListFree(pNeededNodes);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnNodeInfoSetInstanceName(pNodeInfo, strName);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnNodeInfoFree(pNodeInfo);
+		return (nRetVal);
+	}
+
+	nRetVal = xnCreateProductionTree(pContext, pNodeInfo, phFilter);
+	xnNodeInfoFree(pNodeInfo);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnNodeInfo* xnGetNodeInfo(XnNodeHandle hNode)
 {
 	XN_ASSERT(hNode != NULL);
@@ -2481,23 +2583,104 @@ XnBool XN_CALLBACK_TYPE xnDidAllNodesAdvanced(void* pConditionData)
 	return (TRUE);
 }
 
+/**
+* Plays the next frame out of several players, keeping the global timestamp order. Each player reads
+* ahead on its own thread, so the files are read and decoded in parallel. Frames of different players
+* that are at most XN_FRAME_SYNC_THRESHOLD apart are played together (so frame-synced nodes from different 
+* files line up, even if their devices did not stamp them exactly alike).
+* Unless bWait is set, nothing is played if any player is still reading its next frame (the merge order 
+* can't be known before that).
+*/
+static XnStatus xnPlayMergedNext(XnContext* pContext, XnBool bWait)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt64 nMinTimestamp = 0;
+	XnBool bFound = FALSE;
+
+	for (XnPlayersList::ConstIterator it = pContext->playerNodes.Begin(); it != pContext->playerNodes.End(); ++it)
+	{
+		xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>((*it)->pPrivateData);
+		XN_VALIDATE_PTR(pPlayerImpl, XN_STATUS_ERROR);
+
+		nRetVal = pPlayerImpl->StartReadAhead();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	for (XnPlayersList::ConstIterator it = pContext->playerNodes.Begin(); it != pContext->playerNodes.End(); ++it)
+	{
+		xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>((*it)->pPrivateData);
+
+		XnUInt64 nTimestamp = 0;
+		XnBool bEOF = FALSE;
+		nRetVal = pPlayerImpl->PeekNextTimestamp(nTimestamp, bEOF, bWait);
+		if (nRetVal == XN_STATUS_NO_MATCH)
+		{
+			// this player's read-ahead is behind. Try again on the next call.
+			return (XN_STATUS_OK);
+		}
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (!bEOF && (!bFound || nTimestamp < nMinTimestamp))
+		{
+			nMinTimestamp = nTimestamp;
+			bFound = TRUE;
+		}
+	}
+
+	if (!bFound)
+	{
+		// all players are done. Flush whatever they read after their last frame.
+		for (XnPlayersList::ConstIterator it = pContext->playerNodes.Begin(); it != pContext->playerNodes.End(); ++it)
+		{
+			xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>((*it)->pPrivateData);
+			while ((nRetVal = pPlayerImpl->PlayNextQueued()) == XN_STATUS_OK);
+			if (nRetVal != XN_STATUS_EOF)
+			{
+				return (nRetVal);
+			}
+		}
+
+		return (XN_STATUS_EOF);
+	}
+
+	for (XnPlayersList::ConstIterator it = pContext->playerNodes.Begin(); it != pContext->playerNodes.End(); ++it)
+	{
+		xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>((*it)->pPrivateData);
+
+		XnUInt64 nTimestamp = 0;
+		XnBool bEOF = FALSE;
+		nRetVal = pPlayerImpl->PeekNextTimestamp(nTimestamp, bEOF);
+		XN_IS_STATUS_OK(nRetVal);
+
+		if (!bEOF && nTimestamp <= nMinTimestamp + XN_FRAME_SYNC_THRESHOLD)
+		{
+			nRetVal = pPlayerImpl->PlayNextQueued();
+			XN_IS_STATUS_OK(nRetVal);
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
 static XnStatus xnPlayRecording(XnContext* pContext, XnBool bAsynch = FALSE)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
 	// check if we have players in this context
-	// TODO: handle the case in which we have more than one player
-	XnNodeHandle hPlayer = NULL;
-	nRetVal = xnFindExistingRefNodeByType(pContext, XN_NODE_TYPE_PLAYER, &hPlayer);
-	if (nRetVal == XN_STATUS_NO_MATCH)
+	if (pContext->playerNodes.IsEmpty())
 	{
 		return (XN_STATUS_OK);
 	}
-	else
+	else if (pContext->playerNodes.Size() > 1)
 	{
-		XN_IS_STATUS_OK(nRetVal)
+		// merged playback is driven by the application thread (the reading itself is done ahead of time).
+		// An asynchronous call only plays frames that were already read.
+		return xnPlayMergedNext(pContext, !bAsynch);
 	}
 
+	XnNodeHandle hPlayer = *pContext->playerNodes.Begin();
+
 	if (xnIsPlayerAtEOF(hPlayer))
 	{
 		return XN_STATUS_EOF;
@@ -2520,26 +2703,36 @@ static XnStatus xnPlayRecording(XnContext* pContext, XnBool bAsynch = FALSE)
 	return (XN_STATUS_OK);
 }
 
-XnStatus xnWaitForCondition(XnContext* pContext, XnConditionFunc pConditionFunc, void* pConditionData)
+static XnStatus xnWaitForConditionImpl(XnContext* pContext, XnConditionFunc pConditionFunc, void* pConditionData)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 	
 	xnMarkFPSFrame(pContext, &pContext->readFPS);
 
 	// check if we have players in this context
-	// TODO: handle the case in which we have more than one player
-	if (pContext->hPlayerNode != NULL)
+	if (pContext->playerNodes.Size() > 1)
+	{
+		// play (in timestamp order) until condition is met
+		while (!pConditionFunc(pConditionData))
+		{
+			nRetVal = xnPlayMergedNext(pContext, TRUE);
+			XN_IS_STATUS_OK(nRetVal);
+		}
+	}
+	else if (!pContext->playerNodes.IsEmpty())
 	{
+		XnNodeHandle hPlayer = *pContext->playerNodes.Begin();
+
 		// play until condition is met
 		while (!pConditionFunc(pConditionData))
 		{
-			if (xnIsPlayerAtEOF(pContext->hPlayerNode))
+			if (xnIsPlayerAtEOF(hPlayer))
 			{
 				return XN_STATUS_EOF;
 			}
 			else
 			{
-				nRetVal = xnPlayerReadNext(pContext->hPlayerNode);
+				nRetVal = xnPlayerReadNext(hPlayer);
 				XN_IS_STATUS_OK(nRetVal);
 			}
 		}
@@ -2547,7 +2740,9 @@ XnStatus xnWaitForCondition(XnContext* pContext, XnConditionFunc pConditionFunc,
 	else
 	{
 		// no players, just wait for the event
+		XN_TRACE_BEGIN(XN_TRACE_WAIT, NULL, 0, 0, 0);
 		nRetVal = xnOSWaitForCondition(pContext->hNewDataEvent, XN_NODE_WAIT_FOR_DATA_TIMEOUT, pConditionFunc, pConditionData);
+		XN_TRACE_END(XN_TRACE_WAIT, NULL, 0, 0, 0);
 		if (nRetVal == XN_STATUS_OS_EVENT_TIMEOUT)
 		{
 			return (XN_STATUS_WAIT_DATA_TIMEOUT);
@@ -2558,6 +2753,17 @@ XnStatus xnWaitForCondition(XnContext* pContext, XnConditionFunc pConditionFunc,
 	return (XN_STATUS_OK);
 }
 
+XnStatus xnWaitForCondition(XnContext* pContext, XnConditionFunc pConditionFunc, void* pConditionData)
+{
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nStart);
+	XnStatus nRetVal = xnWaitForConditionImpl(pContext, pConditionFunc, pConditionData);
+	xnOSGetHighResTimeStamp(&nEnd);
+	xnMetricsAddLatency(&pContext->waitLatency, nEnd - nStart);
+	return (nRetVal);
+}
+
 XN_C_API XnStatus xnWaitAndUpdateAll(XnContext* pContext)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
@@ -3576,8 +3782,15 @@ static XnStatus xnUpdateDataImpl(XnNodeHandle hInstance)
 	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
 	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
 	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
+	XN_TRACE_BEGIN(XN_TRACE_UPDATE_DATA, hInstance->pNodeInfo->strInstanceName, 0, xnTraceConsumeNewData(hInstance->pNodeInfo->strInstanceName), 0);
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
 	nRetVal = pInterface->Generator.UpdateData(hModuleNode);
-	XN_IS_STATUS_OK(nRetVal);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_TRACE_END(XN_TRACE_UPDATE_DATA, hInstance->pNodeInfo->strInstanceName, 0, 0, 0);
+		return (nRetVal);
+	}
 
 	hInstance->bWasDataRead = TRUE;
 	hInstance->bIsNewData = TRUE;
@@ -3586,7 +3799,9 @@ static XnStatus xnUpdateDataImpl(XnNodeHandle hInstance)
 
 	XnUInt64 nNow;
 	xnOSGetHighResTimeStamp(&nNow);
+	xnMetricsMarkUpdate(&hInstance->metrics, nStart, nNow, xnGetFrameID(hInstance), xnGetDataSize(hInstance));
 	xnDumpFileWriteString(hInstance->pContext->pDumpDataFlow, "%llu,Update,%s,%llu\n", nNow, hInstance->pNodeInfo->strInstanceName, xnGetTimestamp(hInstance));
+	XN_TRACE_END(XN_TRACE_UPDATE_DATA, hInstance->pNodeInfo->strInstanceName, xnGetTimestamp(hInstance), xnGetFrameID(hInstance), xnGetDataSize(hInstance));
 
 	return XN_STATUS_OK;
 }
@@ -3709,6 +3924,20 @@ XN_C_API XnStatus xnSetRecorderDestination(XnNodeHandle hRecorder, XnRecordMediu
 	return XN_STATUS_OK;	
 }
 
+XN_C_API XnStatus xnSetRecorderFileOptions(XnNodeHandle hRecorder, const XnRecorderFileOptions* pOptions)
+{
+	XN_VALIDATE_INPUT_PTR(hRecorder);
+	XN_VALIDATE_INPUT_PTR(pOptions);
+	XN_VALIDATE_INTERFACE_TYPE(hRecorder, XN_NODE_TYPE_RECORDER);
+	XN_VALIDATE_CHANGES_ALLOWED(hRecorder);
+	//Get recorder object
+	xn::RecorderImpl *pRecorderImpl = dynamic_cast<xn::RecorderImpl*>(hRecorder->pPrivateData);
+	XN_VALIDATE_PTR(pRecorderImpl, XN_STATUS_ERROR);
+	XnStatus nRetVal = pRecorderImpl->SetFileOptions(*pOptions);
+	XN_IS_STATUS_OK(nRetVal);
+	return XN_STATUS_OK;	
+}
+
 XN_C_API XnStatus XN_C_DECL xnGetRecorderDestination(XnNodeHandle hRecorder, XnRecordMedium* pDestType, XnChar* strDest, XnUInt32 nBufSize)
 {
 	XN_VALIDATE_INPUT_PTR(hRecorder);
@@ -3792,7 +4021,13 @@ XN_C_API XnStatus xnRecord(XnNodeHandle hInstance)
 	//Get recorder object
 	xn::RecorderImpl *pRecorderImpl = dynamic_cast<xn::RecorderImpl*>(hInstance->pPrivateData);
 	XN_VALIDATE_PTR(pRecorderImpl, XN_STATUS_ERROR);
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nStart);
 	XnStatus nRetVal = pRecorderImpl->Record();
+	xnOSGetHighResTimeStamp(&nEnd);
+	xnMetricsAddLatency(&hInstance->metrics.recordLatency, nEnd - nStart);
+	xnMetricsSetQueuedBytes(&hInstance->metrics, pRecorderImpl->GetQueuedBytes());
 	XN_IS_STATUS_OK(nRetVal);
 	return XN_STATUS_OK;
 }
@@ -3884,6 +4119,31 @@ XN_C_API XnStatus xnSetPlayerSource(XnNodeHandle hPlayer, XnRecordMedium sourceT
 	return XN_STATUS_OK;	
 }
 
+XN_C_API XnStatus xnSetPlayerNetworkOptions(XnNodeHandle hPlayer, const XnPlayerNetworkOptions* pOptions)
+{
+	XN_VALIDATE_INPUT_PTR(hPlayer);
+	XN_VALIDATE_INPUT_PTR(pOptions);
+	XN_VALIDATE_INTERFACE_TYPE(hPlayer, XN_NODE_TYPE_PLAYER);
+	XN_VALIDATE_CHANGES_ALLOWED(hPlayer);
+	//Get player impl object
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hPlayer->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, XN_STATUS_ERROR);
+	XnStatus nRetVal = pPlayerImpl->SetNetworkOptions(*pOptions);
+	XN_IS_STATUS_OK(nRetVal);
+	return XN_STATUS_OK;	
+}
+
+XN_C_API XnStatus xnAbortPlayerSource(XnNodeHandle hPlayer)
+{
+	XN_VALIDATE_INPUT_PTR(hPlayer);
+	XN_VALIDATE_INTERFACE_TYPE(hPlayer, XN_NODE_TYPE_PLAYER);
+	// (no changes check - this is called while another thread is inside xnSetPlayerSource)
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hPlayer->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, XN_STATUS_ERROR);
+	pPlayerImpl->AbortSource();
+	return XN_STATUS_OK;	
+}
+
 XN_C_API XnStatus xnPlayerReadNext(XnNodeHandle hPlayer)
 {
 	XN_VALIDATE_INPUT_PTR(hPlayer);
@@ -3941,10 +4201,11 @@ XN_C_API XnStatus xnSeekPlayerToFrame(XnNodeHandle hPlayer,
 XN_C_API XnStatus xnTellPlayerTimestamp(XnNodeHandle hPlayer, XnUInt64* pnTimestamp)
 {
 	XN_VALIDATE_INPUT_PTR(hPlayer);
+	XN_VALIDATE_OUTPUT_PTR(pnTimestamp);
 	XN_VALIDATE_INTERFACE_TYPE(hPlayer, XN_NODE_TYPE_PLAYER);
-	XnPlayerInterfaceContainer* pInterface = (XnPlayerInterfaceContainer*)hPlayer->pModuleInstance->pLoaded->pInterface;
-	XnModuleNodeHandle hModuleNode = hPlayer->pModuleInstance->hNode;
-	return pInterface->Player.TellTimestamp(hModuleNode, pnTimestamp);
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hPlayer->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, XN_STATUS_ERROR);
+	return pPlayerImpl->TellTimestamp(*pnTimestamp);
 }
 
 XN_C_API XnStatus xnTellPlayerFrame(XnNodeHandle hPlayer, const XnChar* strNodeName, XnUInt32* pnFrame)
@@ -3952,9 +4213,9 @@ XN_C_API XnStatus xnTellPlayerFrame(XnNodeHandle hPlayer, const XnChar* strNodeN
 	XN_VALIDATE_INPUT_PTR(hPlayer);
 	XN_VALIDATE_OUTPUT_PTR(pnFrame);
 	XN_VALIDATE_INTERFACE_TYPE(hPlayer, XN_NODE_TYPE_PLAYER);
-	XnPlayerInterfaceContainer* pInterface = (XnPlayerInterfaceContainer*)hPlayer->pModuleInstance->pLoaded->pInterface;
-	XnModuleNodeHandle hModuleNode = hPlayer->pModuleInstance->hNode;
-	return pInterface->Player.TellFrame(hModuleNode, strNodeName, pnFrame);
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hPlayer->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, XN_STATUS_ERROR);
+	return pPlayerImpl->TellFrame(strNodeName, *pnFrame);
 }
 
 XN_C_API XnStatus xnGetPlayerNumFrames(XnNodeHandle hPlayer, const XnChar* strNodeName, XnUInt32* pnFrames)
@@ -3990,9 +4251,9 @@ XN_C_API XnStatus xnEnumeratePlayerNodes(XnNodeHandle hPlayer, XnNodeInfoList**
 XN_C_API XnBool xnIsPlayerAtEOF(XnNodeHandle hPlayer)
 {
 	XN_VALIDATE_INTERFACE_TYPE_RET(hPlayer, XN_NODE_TYPE_PLAYER, TRUE);
-	XnPlayerInterfaceContainer* pInterface = (XnPlayerInterfaceContainer*)hPlayer->pModuleInstance->pLoaded->pInterface;
-	XnModuleNodeHandle hModuleNode = hPlayer->pModuleInstance->hNode;
-	return pInterface->Player.IsEOF(hModuleNode);
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hPlayer->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, TRUE);
+	return pPlayerImpl->IsEOF();
 }
 
 XN_C_API XnStatus xnRegisterToEndOfFileReached(XnNodeHandle hPlayer, XnStateChangedHandler handler, void* pCookie, XnCallbackHandle* phCallback)
@@ -4037,6 +4298,25 @@ XN_C_API XnDouble xnGetPlaybackSpeed(XnNodeHandle hInstance)
 	return pPlayerImpl->GetPlaybackSpeed();
 }
 
+XN_C_API XnStatus xnSetPlayerRealTime(XnNodeHandle hInstance, XnBool bRealTime)
+{
+	XN_VALIDATE_INPUT_PTR(hInstance);
+	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_PLAYER);
+	//Get player impl object
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hInstance->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, XN_STATUS_ERROR);
+	return pPlayerImpl->SetRealTime(bRealTime);
+}
+
+XN_C_API XnBool xnIsPlayerRealTime(XnNodeHandle hInstance)
+{
+	XN_VALIDATE_INTERFACE_TYPE_RET(hInstance, XN_NODE_TYPE_PLAYER, FALSE);
+	//Get player impl object
+	xn::PlayerImpl *pPlayerImpl = dynamic_cast<xn::PlayerImpl*>(hInstance->pPrivateData);
+	XN_VALIDATE_PTR(pPlayerImpl, FALSE);
+	return pPlayerImpl->IsRealTime();
+}
+
 //---------------------------------------------------------------------------
 // Mirror Capability
 //---------------------------------------------------------------------------
@@ -4082,6 +4362,15 @@ XN_C_API void xnUnregisterFromMirrorChange(XnNodeHandle hInstance, XnCallbackHan
 //---------------------------------------------------------------------------
 // Alternative View Point Capability
 //---------------------------------------------------------------------------
+static XnBool xnAreViewPointChangesAllowed(XnNodeHandle hInstance)
+{
+	// mock nodes apply the view point to their own output, so changing it does not change what was
+	// recorded, and is allowed even when a player locks them.
+	const XnProductionNodeDescription& description = hInstance->pNodeInfo->Description;
+	return (xnAreChangesAllowed(hInstance) || 
+		(strcmp(description.strVendor, XN_VENDOR_OPEN_NI) == 0 && strcmp(description.strName, XN_MOCK_NODE_NAME) == 0));
+}
+
 XN_C_API XnBool xnIsViewPointSupported(XnNodeHandle hInstance, XnNodeHandle hOther)
 {
 	XN_VALIDATE_INTERFACE_TYPE_RET(hInstance, XN_NODE_TYPE_GENERATOR, FALSE);
@@ -4094,7 +4383,10 @@ XN_C_API XnBool xnIsViewPointSupported(XnNodeHandle hInstance, XnNodeHandle hOth
 XN_C_API XnStatus xnSetViewPoint(XnNodeHandle hInstance, XnNodeHandle hOther)
 {
 	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
-	XN_VALIDATE_CHANGES_ALLOWED(hInstance);
+	if (!xnAreViewPointChangesAllowed(hInstance))
+	{
+		return (XN_STATUS_NODE_IS_LOCKED);
+	}
 	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
 	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
 	XN_VALIDATE_FUNC_PTR(pInterface->AlternativeViewPoint.SetViewPoint);
@@ -4104,7 +4396,10 @@ XN_C_API XnStatus xnSetViewPoint(XnNodeHandle hInstance, XnNodeHandle hOther)
 XN_C_API XnStatus xnResetViewPoint(XnNodeHandle hInstance)
 {
 	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
-	XN_VALIDATE_CHANGES_ALLOWED(hInstance);
+	if (!xnAreViewPointChangesAllowed(hInstance))
+	{
+		return (XN_STATUS_NODE_IS_LOCKED);
+	}
 	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
 	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
 	XN_VALIDATE_FUNC_PTR(pInterface->AlternativeViewPoint.ResetViewPoint);
@@ -4142,7 +4437,10 @@ XN_C_API void xnUnregisterFromViewPointChange(XnNodeHandle hInstance, XnCallback
 XN_C_API XnStatus XN_C_DECL xnGetPixelCoordinatesInViewPoint(XnNodeHandle hInstance, XnNodeHandle hOther, XnUInt32 x, XnUInt32 y, XnUInt32* pAltX, XnUInt32* pAltY)
 {
 	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
-	XN_VALIDATE_CHANGES_ALLOWED(hInstance);
+	if (!xnAreViewPointChangesAllowed(hInstance))
+	{
+		return (XN_STATUS_NODE_IS_LOCKED);
+	}
 	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
 	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
 	XN_VALIDATE_FUNC_PTR(pInterface->AlternativeViewPoint.GetPixelCoordinatesInViewPoint);
@@ -4251,6 +4549,56 @@ XN_C_API void xnUnregisterFromFrameSyncChange(XnNodeHandle hInstance, XnCallback
 	xnUnregisterFromModuleStateChange(pInterface->FrameSync.UnregisterFromFrameSyncChange, hModuleNode, hCallback);
 }
 
+//---------------------------------------------------------------------------
+// Frame Lease
+//---------------------------------------------------------------------------
+
+XN_C_API XnStatus xnAcquireFrame(XnNodeHandle hInstance, XnFrameLease* pLease)
+{
+	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
+	XN_VALIDATE_OUTPUT_PTR(pLease);
+	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
+	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
+	XN_VALIDATE_FUNC_PTR(pInterface->FrameLease.AcquireFrame);
+	return pInterface->FrameLease.AcquireFrame(hModuleNode, pLease);
+}
+
+XN_C_API XnStatus xnReleaseFrame(XnNodeHandle hInstance, const XnFrameLease* pLease)
+{
+	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
+	XN_VALIDATE_INPUT_PTR(pLease);
+	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
+	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
+	XN_VALIDATE_FUNC_PTR(pInterface->FrameLease.ReleaseFrame);
+	return pInterface->FrameLease.ReleaseFrame(hModuleNode, pLease);
+}
+
+XN_C_API XnStatus xnSetFramePoolPolicy(XnNodeHandle hInstance, const XnFramePoolPolicy* pPolicy)
+{
+	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
+	XN_VALIDATE_INPUT_PTR(pPolicy);
+
+	if (pPolicy->nFrames < 2 || (pPolicy->nMaxFrames != 0 && pPolicy->nMaxFrames < pPolicy->nFrames))
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Frame pool needs at least 2 frames, and no more than its maximum (got %u, max %u)", pPolicy->nFrames, pPolicy->nMaxFrames);
+	}
+
+	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
+	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
+	XN_VALIDATE_FUNC_PTR(pInterface->FrameLease.SetFramePoolPolicy);
+	return pInterface->FrameLease.SetFramePoolPolicy(hModuleNode, pPolicy);
+}
+
+XN_C_API XnStatus xnGetFramePoolPolicy(XnNodeHandle hInstance, XnFramePoolPolicy* pPolicy)
+{
+	XN_VALIDATE_INTERFACE_TYPE(hInstance, XN_NODE_TYPE_GENERATOR);
+	XN_VALIDATE_OUTPUT_PTR(pPolicy);
+	XnGeneratorInterfaceContainer* pInterface = (XnGeneratorInterfaceContainer*)hInstance->pModuleInstance->pLoaded->pInterface;
+	XnModuleNodeHandle hModuleNode = hInstance->pModuleInstance->hNode;
+	XN_VALIDATE_FUNC_PTR(pInterface->FrameLease.GetFramePoolPolicy);
+	return pInterface->FrameLease.GetFramePoolPolicy(hModuleNode, pPolicy);
+}
+
 //---------------------------------------------------------------------------
 // Map Generators
 //---------------------------------------------------------------------------
@@ -6843,7 +7191,15 @@ XN_C_API XnStatus xnEncodeData(XnNodeHandle hCodec, const void* pSrc, XnUInt32 n
 	XN_VALIDATE_INTERFACE_TYPE(hCodec, XN_NODE_TYPE_CODEC);
 	XnCodecInterfaceContainer* pInterface = (XnCodecInterfaceContainer*)hCodec->pModuleInstance->pLoaded->pInterface;
 	XnModuleNodeHandle hModuleNode = hCodec->pModuleInstance->hNode;
-	return pInterface->Codec.CompressData(hModuleNode, pSrc, nSrcSize, pDst, nDstSize, pnBytesWritten);
+	XN_TRACE_BEGIN(XN_TRACE_ENCODE, hCodec->pNodeInfo->strInstanceName, 0, 0, nSrcSize);
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nStart);
+	XnStatus nRetVal = pInterface->Codec.CompressData(hModuleNode, pSrc, nSrcSize, pDst, nDstSize, pnBytesWritten);
+	xnOSGetHighResTimeStamp(&nEnd);
+	xnMetricsAddLatency(&hCodec->metrics.encodeLatency, nEnd - nStart);
+	XN_TRACE_END(XN_TRACE_ENCODE, hCodec->pNodeInfo->strInstanceName, 0, 0, nSrcSize);
+	return (nRetVal);
 }
 
 XN_C_API XnStatus xnDecodeData(XnNodeHandle hCodec, const void* pSrc, XnUInt32 nSrcSize, void* pDst, XnUInt32 nDstSize, XnUInt* pnBytesWritten)
@@ -6851,7 +7207,15 @@ XN_C_API XnStatus xnDecodeData(XnNodeHandle hCodec, const void* pSrc, XnUInt32 n
 	XN_VALIDATE_INTERFACE_TYPE(hCodec, XN_NODE_TYPE_CODEC);
 	XnCodecInterfaceContainer* pInterface = (XnCodecInterfaceContainer*)hCodec->pModuleInstance->pLoaded->pInterface;
 	XnModuleNodeHandle hModuleNode = hCodec->pModuleInstance->hNode;
-	return pInterface->Codec.DecompressData(hModuleNode, pSrc, nSrcSize, pDst, nDstSize, pnBytesWritten);
+	XN_TRACE_BEGIN(XN_TRACE_DECODE, hCodec->pNodeInfo->strInstanceName, 0, 0, nSrcSize);
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nStart);
+	XnStatus nRetVal = pInterface->Codec.DecompressData(hModuleNode, pSrc, nSrcSize, pDst, nDstSize, pnBytesWritten);
+	xnOSGetHighResTimeStamp(&nEnd);
+	xnMetricsAddLatency(&hCodec->metrics.decodeLatency, nEnd - nStart);
+	XN_TRACE_END(XN_TRACE_DECODE, hCodec->pNodeInfo->strInstanceName, 0, 0, nSrcSize);
+	return (nRetVal);
 }
 
 //---------------------------------------------------------------------------
@@ -7110,3 +7474,56 @@ XnStatus xnGetOpenNIConfFilesPath(XnChar* strDest, XnUInt32 nBufSize)
 	
 	return (XN_STATUS_OK);
 }
+
+XnStatus xnParseNetworkAddress(const XnChar* strAddress, XnChar* strHost, XnUInt32 nHostBufSize, XnUInt16* pnPort)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strAddress);
+	XN_VALIDATE_OUTPUT_PTR(strHost);
+	XN_VALIDATE_OUTPUT_PTR(pnPort);
+
+	// port is whatever follows the last colon
+	const XnChar* pColon = NULL;
+	for (const XnChar* p = strAddress; *p != '\0'; ++p)
+	{
+		if (*p == ':')
+		{
+			pColon = p;
+		}
+	}
+
+	if (pColon == NULL || pColon == strAddress || pColon[1] == '\0')
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Network address '%s' is not of the form host:port", strAddress);
+	}
+
+	XnUInt32 nPort = 0;
+	for (const XnChar* p = pColon + 1; *p != '\0'; ++p)
+	{
+		if (*p < '0' || *p > '9' || nPort > XN_MAX_UINT16)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Network address '%s' has an invalid port", strAddress);
+		}
+		nPort = nPort * 10 + (*p - '0');
+	}
+
+	if (nPort == 0 || nPort > XN_MAX_UINT16)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_BAD_PARAM, XN_MASK_OPEN_NI, "Network address '%s' has an invalid port", strAddress);
+	}
+
+	XnUInt32 nHostLength = (XnUInt32)(pColon - strAddress);
+	if (nHostLength + 1 > nHostBufSize)
+	{
+		return (XN_STATUS_INTERNAL_BUFFER_TOO_SMALL);
+	}
+
+	nRetVal = xnOSStrNCopy(strHost, strAddress, nHostLength, nHostBufSize);
+	XN_IS_STATUS_OK(nRetVal);
+	strHost[nHostLength] = '\0';
+
+	*pnPort = (XnUInt16)nPort;
+	
+	return (XN_STATUS_OK);
+}
@@ -26,8 +26,16 @@
 #include "XnInternalTypes.h"
 #include "XnPropNames.h"
 #include <XnCppWrapper.h>
+#include "xnInternalFuncs.h"
+#include <XnTrace.h>
 
 #define XN_PLAYBACK_SPEED_SANITY_SLEEP 2000
+#define XN_PLAYER_NETWORK_ACCEPT_TIMEOUT 30000
+#define XN_PLAYER_NETWORK_RECEIVE_TIMEOUT 100
+#define XN_PLAYER_NETWORK_RECEIVE_QUEUE_SIZE (4 * 1024 * 1024)
+#define XN_PLAYER_NETWORK_SOCKET_BUFFER_SIZE (1024 * 1024)
+#define XN_PLAYER_READ_AHEAD_FRAMES 4
+#define XN_PLAYER_READ_AHEAD_WAIT_TIMEOUT 100
 
 namespace xn
 {
@@ -43,6 +51,17 @@ XnPlayerInputStreamInterface PlayerImpl::s_fileInputStream =
 	&TellFile64
 };
 
+XnPlayerInputStreamInterface PlayerImpl::s_networkInputStream = 
+{
+	&OpenNetwork,
+	&ReadNetwork,
+	NULL,
+	&TellNetwork,
+	&CloseNetwork,
+	NULL,
+	&TellNetwork64
+};
+
 XnNodeNotifications PlayerImpl::s_nodeNotifications =
 {
 	&OnNodeAdded,
@@ -55,21 +74,64 @@ XnNodeNotifications PlayerImpl::s_nodeNotifications =
 	&OnNodeNewData
 };
 
+XnNodeNotifications PlayerImpl::s_queuedNodeNotifications =
+{
+	&QueueNodeAdded,
+	&QueueNodeRemoved,
+	&QueueNodeIntPropChanged,
+	&QueueNodeRealPropChanged,
+	&QueueNodeStringPropChanged,
+	&QueueNodeGeneralPropChanged,
+	&QueueNodeStateReady,
+	&QueueNodeNewData
+};
+
 PlayerImpl::PlayerImpl() : 
 	m_hPlayer(NULL), 
 	m_bIsFileOpen(FALSE),
 	m_hInFile(XN_INVALID_FILE_HANDLE),
+	m_bIsSocketOpen(FALSE),
+	m_hInSocket(NULL),
+	m_bNetworkAbort(FALSE),
+	m_hReceiveThread(NULL),
+	m_hReceiveLock(NULL),
+	m_hReceiveDataEvent(NULL),
+	m_hReceiveSpaceEvent(NULL),
+	m_pReceiveQueue(NULL),
+	m_nReceiveQueueSize(0),
+	m_nBytesReceived(0),
+	m_nBytesConsumed(0),
+	m_bReceiveEnded(FALSE),
+	m_nReceiveStatus(XN_STATUS_OK),
+	m_bReceiveShutdown(FALSE),
+	m_nFirstArrivalMark(0),
+	m_nArrivalMarks(0),
+	m_nCurrentSegment(0),
 	m_sourceType(XnRecordMedium(-1)),
 	m_dPlaybackSpeed(1.0),
 	m_nStartTimestamp(0),
 	m_nStartTime(0),
 	m_bHasTimeReference(FALSE),
+	m_bRealTime(FALSE),
 	m_hPlaybackThread(NULL),
 	m_hPlaybackEvent(NULL),
 	m_hPlaybackLock(NULL),
-	m_bPlaybackThreadShutdown(FALSE)
+	m_bPlaybackThreadShutdown(FALSE),
+	m_hReadAheadThread(NULL),
+	m_hQueueDataEvent(NULL),
+	m_hQueueSpaceEvent(NULL),
+	m_hQueueLock(NULL),
+	m_nQueuedFrames(0),
+	m_bReadAheadEOF(FALSE),
+	m_nReadAheadStatus(XN_STATUS_OK),
+	m_bReadAheadShutdown(FALSE),
+	m_nLoopOffset(0),
+	m_nLastMergeTimestamp(0),
+	m_bLoopPending(FALSE),
+	m_nPlayedTimestamp(0)
 {
 	xnOSMemSet(m_strSource, 0, sizeof(m_strSource));
+	xnOSMemSet(&m_networkOptions, 0, sizeof(m_networkOptions));
 }
 
 PlayerImpl::~PlayerImpl()
@@ -101,22 +163,46 @@ XnStatus PlayerImpl::Init(XnNodeHandle hPlayer)
 	nRetVal = xnOSCreateEvent(&m_hPlaybackEvent, FALSE);
 	XN_IS_STATUS_OK(nRetVal);
 
+	nRetVal = xnOSCreateCriticalSection(&m_hQueueLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&m_hQueueDataEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&m_hQueueSpaceEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateCriticalSection(&m_hReceiveLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&m_hReceiveDataEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateEvent(&m_hReceiveSpaceEvent, FALSE);
+	XN_IS_STATUS_OK(nRetVal);
+
 	nRetVal = xnOSCreateThread(PlaybackThread, this, &m_hPlaybackThread);
 	XN_IS_STATUS_OK(nRetVal);
 
+	xnOSApplyThreadPolicy(m_hPlaybackThread, XN_THREAD_ROLE_PLAYBACK, "XnPlayback");
+
 	return XN_STATUS_OK;
 }
 
 void PlayerImpl::BeforeNodeDestroy()
 {
-	// we need to close the thread *before* the node is destroyed (as the thread uses it)
+	// we need to close the threads *before* the node is destroyed (as they use it). Network reads give up
+	// once shutdown is set, so both threads exit on their own.
 	m_bPlaybackThreadShutdown = TRUE;
 
+	StopReadAhead();
+
 	if (m_hPlaybackThread != NULL)
 	{
 		// signal the event, so the thread will wake up
 		xnOSSetEvent(m_hPlaybackEvent);
-		xnOSWaitAndTerminateThread(&m_hPlaybackThread, 1000);
+		xnOSWaitForThreadExit(m_hPlaybackThread, XN_WAIT_INFINITE);
+		xnOSCloseThread(&m_hPlaybackThread);
 		m_hPlaybackThread = NULL;
 	}
 
@@ -125,6 +211,18 @@ void PlayerImpl::BeforeNodeDestroy()
 		xnOSCloseEvent(&m_hPlaybackEvent);
 		m_hPlaybackEvent = NULL;
 	}
+
+	if (m_hQueueDataEvent != NULL)
+	{
+		xnOSCloseEvent(&m_hQueueDataEvent);
+		m_hQueueDataEvent = NULL;
+	}
+
+	if (m_hQueueSpaceEvent != NULL)
+	{
+		xnOSCloseEvent(&m_hQueueSpaceEvent);
+		m_hQueueSpaceEvent = NULL;
+	}
 }
 
 XnStatus PlayerImpl::SetSource(XnRecordMedium sourceType, const XnChar* strSource)
@@ -136,9 +234,8 @@ XnStatus PlayerImpl::SetSource(XnRecordMedium sourceType, const XnChar* strSourc
 	XnDouble dPlaybackSpeed = GetPlaybackSpeed();
 	SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST);
 
-	//Right now the only record medium we support is a file
-	
 	m_sourceType = sourceType;
+	m_bNetworkAbort = FALSE;
 
 	switch (m_sourceType)
 	{
@@ -146,10 +243,28 @@ XnStatus PlayerImpl::SetSource(XnRecordMedium sourceType, const XnChar* strSourc
 		{
 			nRetVal = xnOSStrCopy(m_strSource, strSource, sizeof(m_strSource));
 			XN_IS_STATUS_OK(nRetVal);
+			nRetVal = LoadSegments();
+			XN_IS_STATUS_OK(nRetVal);
+			nRetVal = SetSegmentedInputStream();
+			XN_IS_STATUS_OK(nRetVal);
 			nRetVal = ModulePlayer().SetInputStream(ModuleHandle(), this, &s_fileInputStream);
 			XN_IS_STATUS_OK(nRetVal);
 			break;
 		}
+		case XN_RECORD_MEDIUM_NETWORK:
+		{
+			nRetVal = xnOSStrCopy(m_strSource, strSource, sizeof(m_strSource));
+			XN_IS_STATUS_OK(nRetVal);
+			// the latency limit is enforced through the playback clock, even when not playing in real-time
+			if (m_networkOptions.nMaxLatency != 0)
+			{
+				nRetVal = UpdatePlaybackClock(m_bRealTime);
+				XN_IS_STATUS_OK(nRetVal);
+			}
+			nRetVal = ModulePlayer().SetInputStream(ModuleHandle(), this, &s_networkInputStream);
+			XN_IS_STATUS_OK(nRetVal);
+			break;
+		}
 		default:
 			XN_ASSERT(FALSE);
 			return XN_STATUS_BAD_PARAM;
@@ -162,6 +277,23 @@ XnStatus PlayerImpl::SetSource(XnRecordMedium sourceType, const XnChar* strSourc
 	return XN_STATUS_OK;
 }
 
+XnStatus PlayerImpl::SetNetworkOptions(const XnPlayerNetworkOptions& options)
+{
+	if (m_bIsSocketOpen)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Network options must be set before the source");
+	}
+
+	m_networkOptions = options;
+	return (XN_STATUS_OK);
+}
+
+void PlayerImpl::AbortSource()
+{
+	// checked by the accept loop and by network reads
+	m_bNetworkAbort = TRUE;
+}
+
 XnStatus PlayerImpl::GetSource(XnRecordMedium &sourceType, XnChar* strSource, XnUInt32 nBufSize)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
@@ -174,6 +306,25 @@ XnStatus PlayerImpl::GetSource(XnRecordMedium &sourceType, XnChar* strSource, Xn
 void PlayerImpl::Destroy()
 {
 	CloseFileImpl();
+	CloseNetworkImpl();
+
+	if (m_hReceiveLock != NULL)
+	{
+		xnOSCloseCriticalSection(&m_hReceiveLock);
+		m_hReceiveLock = NULL;
+	}
+
+	if (m_hReceiveDataEvent != NULL)
+	{
+		xnOSCloseEvent(&m_hReceiveDataEvent);
+		m_hReceiveDataEvent = NULL;
+	}
+
+	if (m_hReceiveSpaceEvent != NULL)
+	{
+		xnOSCloseEvent(&m_hReceiveSpaceEvent);
+		m_hReceiveSpaceEvent = NULL;
+	}
 
 	if (m_hPlaybackLock != NULL)
 	{
@@ -181,6 +332,19 @@ void PlayerImpl::Destroy()
 		m_hPlaybackLock = NULL;
 	}
 
+	ClearQueue();
+	for (QueueBuffersList::Iterator it = m_freeQueueBuffers.Begin(); it != m_freeQueueBuffers.End(); ++it)
+	{
+		XN_DELETE_ARR(it->pData);
+	}
+	m_freeQueueBuffers.Clear();
+
+	if (m_hQueueLock != NULL)
+	{
+		xnOSCloseCriticalSection(&m_hQueueLock);
+		m_hQueueLock = NULL;
+	}
+
 	for (PlayedNodesHash::Iterator it = m_playedNodes.Begin(); it != m_playedNodes.End(); ++it)
 	{
 		PlayedNodeInfo& nodeInfo = it->Value();
@@ -225,6 +389,9 @@ XnStatus PlayerImpl::SetPlaybackSpeed(XnDouble dSpeed)
 
 	m_dPlaybackSpeed = dSpeed;
 
+	// deadlines are calculated from the time reference using the speed, so start over from the next frame
+	ResetTimeReference();
+
 	return XN_STATUS_OK;
 }
 
@@ -233,6 +400,83 @@ XnDouble PlayerImpl::GetPlaybackSpeed()
 	return m_dPlaybackSpeed;
 }
 
+XnStatus PlayerImpl::SetRealTime(XnBool bRealTime)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// do that in a lock (other thread might be in the middle of playback/seek)
+	XnAutoCSLocker locker(m_hPlaybackLock);
+
+	nRetVal = UpdatePlaybackClock(bRealTime);
+	XN_IS_STATUS_OK(nRetVal);
+
+	m_bRealTime = bRealTime;
+
+	return XN_STATUS_OK;
+}
+
+XnStatus PlayerImpl::UpdatePlaybackClock(XnBool bRealTime)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// a live source with a latency limit always needs the clock
+	XnBool bLatencyLimit = (m_sourceType == XN_RECORD_MEDIUM_NETWORK && m_networkOptions.nMaxLatency != 0);
+
+	XnPlaybackClock clock;
+	clock.IsTimestampDue = (bRealTime || bLatencyLimit) ? IsTimestampDue : NULL;
+	clock.pCookie = this;
+
+	// it's the player module that drops frames (before decoding them)
+	XnProductionNodeInterfaceContainer* pInterface = m_hPlayer->pModuleInstance->pLoaded->pInterface;
+	if (pInterface->ProductionNode.SetGeneralProperty == NULL)
+	{
+		return (XN_STATUS_NOT_IMPLEMENTED);
+	}
+
+	nRetVal = pInterface->ProductionNode.SetGeneralProperty(ModuleHandle(), XN_PROP_PLAYBACK_CLOCK, sizeof(clock), &clock);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogWarning(XN_MASK_OPEN_NI, "Player module does not support real-time playback: %s", xnGetStatusString(nRetVal));
+		return (nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnUInt64 PlayerImpl::GetTimestampDeadline(XnUInt64 nTimeStamp)
+{
+	// in some recordings, frames are not ordered by timestamp. Such frames are due right away.
+	if (nTimeStamp <= m_nStartTimestamp)
+	{
+		return m_nStartTime;
+	}
+
+	return m_nStartTime + (XnUInt64)((nTimeStamp - m_nStartTimestamp) / m_dPlaybackSpeed);
+}
+
+XnBool XN_CALLBACK_TYPE PlayerImpl::IsTimestampDue(void* pCookie, XnUInt64 nTimeStamp)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+
+	// a network source is live - it is already paced by the remote recorder. Its data is only late if it
+	// waited in the receive queue for too long.
+	if (pThis->m_sourceType == XN_RECORD_MEDIUM_NETWORK)
+	{
+		return (pThis->m_networkOptions.nMaxLatency != 0 && 
+			pThis->GetNetworkLatency() > (XnUInt64)pThis->m_networkOptions.nMaxLatency * 1000);
+	}
+
+	if (!pThis->m_bRealTime || !pThis->m_bHasTimeReference || pThis->m_dPlaybackSpeed == XN_PLAYBACK_SPEED_FASTEST)
+	{
+		return (FALSE);
+	}
+
+	XnUInt64 nNow;
+	xnOSGetHighResTimeStamp(&nNow);
+
+	return (nNow >= pThis->GetTimestampDeadline(nTimeStamp));
+}
+
 void PlayerImpl::ResetTimeReference()
 {
 	m_bHasTimeReference = FALSE;
@@ -250,6 +494,88 @@ XnModuleNodeHandle PlayerImpl::ModuleHandle()
 }
 
 XnStatus PlayerImpl::SeekToTimestamp(XnInt64 nTimeOffset, XnPlayerSeekOrigin origin)
+{
+	// (checked here, as stopping read-ahead could wait for live data)
+	if (m_sourceType == XN_RECORD_MEDIUM_NETWORK)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Cannot seek in a live stream");
+	}
+
+	// queued frames belong to the old position. The read-ahead thread must be stopped before taking
+	// the playback lock, as it holds that lock while reading.
+	XnBool bReadAhead = (m_hReadAheadThread != NULL);
+	StopReadAhead();
+
+	XnStatus nRetVal = SeekToTimestampImpl(nTimeOffset, origin);
+
+	if (bReadAhead)
+	{
+		XnStatus nStartRetVal = StartReadAhead();
+		if (nRetVal == XN_STATUS_OK)
+		{
+			nRetVal = nStartRetVal;
+		}
+	}
+
+	return (nRetVal);
+}
+
+XnStatus PlayerImpl::TellTimestamp(XnUInt64& nTimestamp)
+{
+	if (m_hReadAheadThread != NULL)
+	{
+		// the module is ahead of the application
+		nTimestamp = m_nPlayedTimestamp;
+		return (XN_STATUS_OK);
+	}
+
+	return ModulePlayer().TellTimestamp(ModuleHandle(), &nTimestamp);
+}
+
+XnStatus PlayerImpl::TellFrame(const XnChar* strNodeName, XnUInt32& nFrame)
+{
+	if (m_hReadAheadThread != NULL)
+	{
+		// the module is ahead of the application
+		PlayedNodeInfo playedNode;
+		XnStatus nRetVal = m_playedNodes.Get(strNodeName, playedNode);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			XN_LOG_WARNING_RETURN(XN_STATUS_BAD_NODE_NAME, XN_MASK_OPEN_NI, "Bad node name '%s'", strNodeName);
+		}
+
+		nFrame = playedNode.nPlayedFrame;
+		return (XN_STATUS_OK);
+	}
+
+	return ModulePlayer().TellFrame(ModuleHandle(), strNodeName, &nFrame);
+}
+
+XnStatus PlayerImpl::SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset, XnPlayerSeekOrigin origin)
+{
+	if (m_sourceType == XN_RECORD_MEDIUM_NETWORK)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Cannot seek in a live stream");
+	}
+
+	XnBool bReadAhead = (m_hReadAheadThread != NULL);
+	StopReadAhead();
+
+	XnStatus nRetVal = SeekToFrameImpl(strNodeName, nFrameOffset, origin);
+
+	if (bReadAhead)
+	{
+		XnStatus nStartRetVal = StartReadAhead();
+		if (nRetVal == XN_STATUS_OK)
+		{
+			nRetVal = nStartRetVal;
+		}
+	}
+
+	return (nRetVal);
+}
+
+XnStatus PlayerImpl::SeekToTimestampImpl(XnInt64 nTimeOffset, XnPlayerSeekOrigin origin)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
@@ -272,8 +598,7 @@ XnStatus PlayerImpl::SeekToTimestamp(XnInt64 nTimeOffset, XnPlayerSeekOrigin ori
 	return XN_STATUS_OK;
 }
 
-
-XnStatus PlayerImpl::SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset, XnPlayerSeekOrigin origin)
+XnStatus PlayerImpl::SeekToFrameImpl(const XnChar* strNodeName, XnInt32 nFrameOffset, XnPlayerSeekOrigin origin)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
@@ -350,6 +675,21 @@ void XN_CALLBACK_TYPE PlayerImpl::CloseFile(void* pCookie)
 	pThis->CloseFileImpl();
 }
 
+XnUInt32 XN_CALLBACK_TYPE PlayerImpl::GetSegmentCount(void* pCookie)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	XN_VALIDATE_PTR(pThis, 0);
+	// a plain recording is a single segment
+	return XN_MAX(pThis->m_segments.GetSize(), 1);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OpenSegment(void* pCookie, XnUInt32 nSegment)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	return pThis->OpenSegmentImpl(nSegment);
+}
+
 XnStatus PlayerImpl::OpenFileImpl()
 {
 	if (m_bIsFileOpen)
@@ -358,11 +698,12 @@ XnStatus PlayerImpl::OpenFileImpl()
 		return XN_STATUS_OK;
 	}
 	
-	XnStatus nRetVal = xnOSOpenFile(m_strSource, XN_OS_FILE_READ, &m_hInFile);
+	const XnChar* strFileName = (m_segments.GetSize() > 0) ? m_segments[m_nCurrentSegment].strPath : m_strSource;
+	XnStatus nRetVal = xnOSOpenFile(strFileName, XN_OS_FILE_READ, &m_hInFile);
 
 	if (nRetVal != XN_STATUS_OK)
 	{
-		xnLogWarning(XN_MASK_OPEN_NI, "Failed to open file '%s' for reading", m_strSource);
+		xnLogWarning(XN_MASK_OPEN_NI, "Failed to open file '%s' for reading", strFileName);
 		return XN_STATUS_OS_FILE_OPEN_FAILED;
 	}
 	m_bIsFileOpen = TRUE;
@@ -424,109 +765,552 @@ void PlayerImpl::CloseFileImpl()
 	}
 }
 
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeAdded(void* pCookie, const XnChar* strNodeName, XnProductionNodeType type, XnCodecID compression)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->AddNode(strNodeName, type, compression);
-}
-
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeRemoved(void* pCookie, const XnChar* strNodeName)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->RemoveNode(strNodeName);
-}
-
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeIntPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnUInt64 nValue)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->SetNodeIntProp(strNodeName, strPropName, nValue);
-}
-
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeRealPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnDouble dValue)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->SetNodeRealProp(strNodeName, strPropName, dValue);
-}
-
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeStringPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, const XnChar* strValue)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->SetNodeStringProp(strNodeName, strPropName, strValue);
-}
-
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeGeneralPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnUInt32 nBufferSize, const void* pBuffer)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->SetNodeGeneralProp(strNodeName, strPropName, nBufferSize, pBuffer);
-}
-
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeStateReady(void* pCookie, const XnChar* strNodeName)
+XnStatus PlayerImpl::OpenSegmentImpl(XnUInt32 nSegment)
 {
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->SetNodeStateReady(strNodeName);
-}
+	if (nSegment >= GetSegmentCount(this))
+	{
+		return (XN_STATUS_NO_MATCH);
+	}
 
-XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeNewData(void* pCookie, const XnChar* strNodeName, XnUInt64 nTimeStamp, XnUInt32 nFrame, const void* pData, XnUInt32 nSize)
-{
-	XN_VALIDATE_INPUT_PTR(pCookie);
-	PlayerImpl* pThis = (PlayerImpl*)pCookie;
-	return pThis->SetNodeNewData(strNodeName, nTimeStamp, nFrame, pData, nSize);
+	CloseFileImpl();
+	m_nCurrentSegment = nSegment;
+	return OpenFileImpl();
 }
 
-XnStatus PlayerImpl::AddNode(const XnChar* strNodeName, XnProductionNodeType type, XnCodecID /*compression*/)
+XnStatus PlayerImpl::LoadSegments()
 {
 	XnStatus nRetVal = XN_STATUS_OK;
-	
-	PlayedNodeInfo playedNodeInfo = {0};
 
-	if (m_playedNodes.Get(strNodeName, playedNodeInfo) == XN_STATUS_OK)
+	m_segments.Clear();
+	m_nCurrentSegment = 0;
+
+	// anything that does not start like a manifest is a recording. Failing to open it is reported later on.
+	XN_FILE_HANDLE hFile = XN_INVALID_FILE_HANDLE;
+	if (xnOSOpenFile(m_strSource, XN_OS_FILE_READ, &hFile) != XN_STATUS_OK)
 	{
-		// already in the list, just return OK.
 		return (XN_STATUS_OK);
 	}
 
-	// check if we need to create it (maybe it's a rewind...)
-	if (xnGetRefNodeHandleByName(m_hPlayer->pContext, strNodeName, &playedNodeInfo.hNode) != XN_STATUS_OK)
+	const XnUInt32 nHeaderSize = sizeof(XN_SEGMENTS_MANIFEST_HEADER) - 1;
+	XnChar strHeader[sizeof(XN_SEGMENTS_MANIFEST_HEADER)];
+	XnUInt32 nBytesRead = nHeaderSize;
+	nRetVal = xnOSReadFile(hFile, strHeader, &nBytesRead);
+	xnOSCloseFile(&hFile);
+	if (nRetVal != XN_STATUS_OK || nBytesRead != nHeaderSize || xnOSMemCmp(strHeader, XN_SEGMENTS_MANIFEST_HEADER, nHeaderSize) != 0)
 	{
-		XnStatus nRetVal = xnCreateMockNode(m_hPlayer->pContext, type, strNodeName, &playedNodeInfo.hNode);
-		XN_IS_STATUS_OK(nRetVal);
-
-		// mark this node as needed node. We need this in order to make sure if xnForceShutdown() is called,
-		// the player will be destroyed *before* mock node is (so we can release it).
-		nRetVal = xnAddNeededNode(m_hPlayer, playedNodeInfo.hNode);
-		if (nRetVal != XN_STATUS_OK)
-		{
-			xnProductionNodeRelease(playedNodeInfo.hNode);
-			return (nRetVal);
-		}
+		return (XN_STATUS_OK);
 	}
 
-	// lock it, so no one can change configuration (this is a file recording)
-	nRetVal = xnLockNodeForChanges(playedNodeInfo.hNode, &playedNodeInfo.hLock);
+	XnUInt64 nFileSize = 0;
+	nRetVal = xnOSGetFileSize64(m_strSource, &nFileSize);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnChar* pManifest = XN_NEW_ARR(XnChar, (XnUInt32)nFileSize + 1);
+	XN_VALIDATE_ALLOC_PTR(pManifest);
+	nRetVal = xnOSLoadFile(m_strSource, pManifest, (XnUInt32)nFileSize);
 	if (nRetVal != XN_STATUS_OK)
 	{
-		xnProductionNodeRelease(playedNodeInfo.hNode);
+		XN_DELETE_ARR(pManifest);
 		return (nRetVal);
 	}
+	pManifest[nFileSize] = '\0';
 
-	nRetVal = m_playedNodes.Set(strNodeName, playedNodeInfo);
+	// segments are listed relative to the manifest
+	XnChar strDir[XN_FILE_MAX_PATH];
+	nRetVal = xnOSGetDirName(m_strSource, strDir, sizeof(strDir));
 	if (nRetVal != XN_STATUS_OK)
 	{
-		xnProductionNodeRelease(playedNodeInfo.hNode);
+		XN_DELETE_ARR(pManifest);
 		return (nRetVal);
 	}
 
-	return XN_STATUS_OK;
-}
+	XnChar* pLine = pManifest + nHeaderSize;
+	while (*pLine != '\0')
+	{
+		XnChar* pEnd = pLine;
+		while (*pEnd != '\0' && *pEnd != '\n' && *pEnd != '\r')
+		{
+			++pEnd;
+		}
 
-XnStatus PlayerImpl::RemoveNode(const XnChar* strNodeName)
+		XnBool bLast = (*pEnd == '\0');
+		*pEnd = '\0';
+
+		if (*pLine != '\0')
+		{
+			SegmentFile segment;
+			XnUInt32 nCharsWritten = 0;
+			nRetVal = xnOSStrFormat(segment.strPath, sizeof(segment.strPath), &nCharsWritten, "%s%s%s", strDir, XN_FILE_DIR_SEP, pLine);
+			if (nRetVal == XN_STATUS_OK)
+			{
+				nRetVal = m_segments.AddLast(segment);
+			}
+
+			if (nRetVal != XN_STATUS_OK)
+			{
+				XN_DELETE_ARR(pManifest);
+				m_segments.Clear();
+				return (nRetVal);
+			}
+		}
+
+		pLine = bLast ? pEnd : pEnd + 1;
+	}
+
+	XN_DELETE_ARR(pManifest);
+
+	if (m_segments.GetSize() == 0)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_CORRUPT_FILE, XN_MASK_OPEN_NI, "Segments manifest '%s' lists no segments", m_strSource);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus PlayerImpl::SetSegmentedInputStream()
+{
+	if (m_segments.GetSize() == 0)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	XnPlayerSegmentedInputStreamInterface segmentedStream;
+	segmentedStream.nVersion = XN_PLAYER_SEGMENTED_INPUT_STREAM_VERSION;
+	segmentedStream.pCookie = this;
+	segmentedStream.GetSegmentCount = GetSegmentCount;
+	segmentedStream.OpenSegment = OpenSegment;
+
+	// the player module copies the interface
+	XnProductionNodeInterfaceContainer* pInterface = m_hPlayer->pModuleInstance->pLoaded->pInterface;
+	XnStatus nRetVal = XN_STATUS_NOT_IMPLEMENTED;
+	if (pInterface->ProductionNode.SetGeneralProperty != NULL)
+	{
+		nRetVal = pInterface->ProductionNode.SetGeneralProperty(ModuleHandle(), XN_PROP_SEGMENTED_INPUT_STREAM, sizeof(segmentedStream), &segmentedStream);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogWarning(XN_MASK_OPEN_NI, "Player module does not support segmented recordings (%s). Only the first segment of '%s' will be played.", xnGetStatusString(nRetVal), m_strSource);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OpenNetwork(void* pCookie)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	return pThis->OpenNetworkImpl();
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::ReadNetwork(void* pCookie, void* pBuffer, XnUInt32 nSize, XnUInt32* pnBytesRead)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	XnUInt32 nBytesRead = 0;
+	return pThis->ReadNetworkImpl(pBuffer, nSize, (pnBytesRead != NULL) ? *pnBytesRead : nBytesRead);
+}
+
+XnUInt32 XN_CALLBACK_TYPE PlayerImpl::TellNetwork(void* pCookie)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	XN_VALIDATE_PTR(pThis, (XnUInt32)-1);
+	// Enforce uint32 limitation
+	if (pThis->m_nBytesConsumed >> 32)
+		return (XnUInt32) -1;
+
+	return (XnUInt32)pThis->m_nBytesConsumed;
+}
+
+XnUInt64 XN_CALLBACK_TYPE PlayerImpl::TellNetwork64(void* pCookie)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	XN_VALIDATE_PTR(pThis, (XnUInt64)-1);
+	return pThis->m_nBytesConsumed;
+}
+
+void XN_CALLBACK_TYPE PlayerImpl::CloseNetwork(void* pCookie)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	if (pThis == NULL)
+	{
+		xnLogWarning(XN_MASK_OPEN_NI, "Got NULL cookie");
+		return;
+	}
+	pThis->CloseNetworkImpl();
+}
+
+XnStatus PlayerImpl::OpenNetworkImpl()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (m_bIsSocketOpen)
+	{
+		//Already open
+		return XN_STATUS_OK;
+	}
+
+	XnChar strHost[XN_FILE_MAX_PATH];
+	XnUInt16 nPort = 0;
+	nRetVal = xnParseNetworkAddress(m_strSource, strHost, sizeof(strHost), &nPort);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSInitNetwork();
+	XN_IS_STATUS_OK(nRetVal);
+
+	// we only serve a single recorder, so the listening socket is only needed until it connects
+	XN_SOCKET_HANDLE hListenSocket = NULL;
+	nRetVal = xnOSCreateSocket(XN_OS_TCP_SOCKET, strHost, nPort, &hListenSocket);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnOSBindSocket(hListenSocket);
+		if (nRetVal == XN_STATUS_OK)
+		{
+			nRetVal = xnOSListenSocket(hListenSocket);
+		}
+		if (nRetVal == XN_STATUS_OK)
+		{
+			nRetVal = AcceptNetworkConnection(hListenSocket);
+		}
+		xnOSCloseSocket(hListenSocket);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSShutdownNetwork();
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to accept a recorder connection on '%s': %s", m_strSource, xnGetStatusString(nRetVal));
+	}
+
+	xnOSSetSocketBufferSize(m_hInSocket, XN_PLAYER_NETWORK_SOCKET_BUFFER_SIZE);
+
+	m_nReceiveQueueSize = (m_networkOptions.nReceiveQueueSize != 0) ? m_networkOptions.nReceiveQueueSize : XN_PLAYER_NETWORK_RECEIVE_QUEUE_SIZE;
+	m_pReceiveQueue = XN_NEW_ARR(XnUChar, m_nReceiveQueueSize);
+	if (m_pReceiveQueue == NULL)
+	{
+		xnOSCloseSocket(m_hInSocket);
+		m_hInSocket = NULL;
+		xnOSShutdownNetwork();
+		return XN_STATUS_ALLOC_FAILED;
+	}
+
+	m_nBytesReceived = 0;
+	m_nBytesConsumed = 0;
+	m_bReceiveEnded = FALSE;
+	m_nReceiveStatus = XN_STATUS_OK;
+	m_bReceiveShutdown = FALSE;
+	m_nFirstArrivalMark = 0;
+	m_nArrivalMarks = 0;
+	m_bIsSocketOpen = TRUE;
+
+	nRetVal = xnOSCreateThread(ReceiveThread, this, &m_hReceiveThread);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		CloseNetworkImpl();
+		return (nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus PlayerImpl::AcceptNetworkConnection(XN_SOCKET_HANDLE hListenSocket)
+{
+	XnUInt32 nTimeout = (m_networkOptions.nAcceptTimeout != 0) ? m_networkOptions.nAcceptTimeout : XN_PLAYER_NETWORK_ACCEPT_TIMEOUT;
+
+	XnUInt64 nStartTime;
+	xnOSGetTimeStamp(&nStartTime);
+
+	// wait in short steps, so the wait can be aborted
+	for (;;)
+	{
+		if (m_bNetworkAbort)
+		{
+			return (XN_STATUS_OS_EVENT_CANCELED);
+		}
+
+		XnStatus nRetVal = xnOSAcceptSocket(hListenSocket, &m_hInSocket, XN_PLAYER_NETWORK_RECEIVE_TIMEOUT);
+		if (nRetVal != XN_STATUS_OS_NETWORK_TIMEOUT)
+		{
+			return (nRetVal);
+		}
+
+		XnUInt64 nNow;
+		xnOSGetTimeStamp(&nNow);
+		if (nNow - nStartTime >= nTimeout)
+		{
+			return (XN_STATUS_OS_NETWORK_TIMEOUT);
+		}
+	}
+}
+
+XN_THREAD_PROC PlayerImpl::ReceiveThread(XN_THREAD_PARAM pThreadParam)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pThreadParam;
+	pThis->ReceiveThread();
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+void PlayerImpl::ReceiveThread()
+{
+	while (!m_bReceiveShutdown && !m_bNetworkAbort)
+	{
+		XnUInt32 nFree = 0;
+		XnUInt32 nWritePos = 0;
+		{
+			XnAutoCSLocker locker(m_hReceiveLock);
+			nFree = m_nReceiveQueueSize - (XnUInt32)(m_nBytesReceived - m_nBytesConsumed);
+			nWritePos = (XnUInt32)(m_nBytesReceived % m_nReceiveQueueSize);
+		}
+
+		if (nFree == 0)
+		{
+			// queue is full. Not reading the socket lets TCP flow control slow the recorder down.
+			xnOSWaitEvent(m_hReceiveSpaceEvent, XN_PLAYER_NETWORK_RECEIVE_TIMEOUT);
+			continue;
+		}
+
+		// the free part of the queue is never read, so it can be filled outside the lock
+		XnUInt32 nReceived = XN_MIN(nFree, m_nReceiveQueueSize - nWritePos);
+		XnStatus nRetVal = xnOSReceiveNetworkBuffer(m_hInSocket, (XnChar*)m_pReceiveQueue + nWritePos, &nReceived, XN_PLAYER_NETWORK_RECEIVE_TIMEOUT);
+		if (nRetVal == XN_STATUS_OS_NETWORK_TIMEOUT)
+		{
+			continue;
+		}
+
+		XnUInt64 nNow;
+		xnOSGetHighResTimeStamp(&nNow);
+
+		{
+			XnAutoCSLocker locker(m_hReceiveLock);
+			if (nRetVal != XN_STATUS_OK)
+			{
+				// a closed connection behaves like end of file
+				m_bReceiveEnded = TRUE;
+				m_nReceiveStatus = (nRetVal == XN_STATUS_OS_NETWORK_CONNECTION_CLOSED) ? XN_STATUS_OK : nRetVal;
+			}
+			else
+			{
+				m_nBytesReceived += nReceived;
+
+				if (m_nArrivalMarks < MAX_ARRIVAL_MARKS)
+				{
+					ArrivalMark& mark = m_arrivalMarks[(m_nFirstArrivalMark + m_nArrivalMarks) % MAX_ARRIVAL_MARKS];
+					mark.nTime = nNow;
+					++m_nArrivalMarks;
+				}
+				// (when out of marks, the last one is extended. The new data then seems older than it is, so
+				// latency may be overestimated, but never underestimated)
+				m_arrivalMarks[(m_nFirstArrivalMark + m_nArrivalMarks - 1) % MAX_ARRIVAL_MARKS].nEndOffset = m_nBytesReceived;
+			}
+		}
+
+		xnOSSetEvent(m_hReceiveDataEvent);
+
+		if (nRetVal != XN_STATUS_OK)
+		{
+			break;
+		}
+	}
+}
+
+XnStatus PlayerImpl::ReadNetworkImpl(void* pData, XnUInt32 nSize, XnUInt32 &nBytesRead)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_IS_BOOL_OK_RET(m_bIsSocketOpen, XN_STATUS_ERROR);
+
+	XnUChar* pDest = (XnUChar*)pData;
+	nBytesRead = 0;
+
+	// unlike a file, a network read blocks until all requested bytes arrived (or the recorder disconnected),
+	// as the player module treats short reads as a truncated stream.
+	while (nBytesRead < nSize)
+	{
+		XnUInt32 nAvailable = 0;
+		XnBool bEnded = FALSE;
+		{
+			XnAutoCSLocker locker(m_hReceiveLock);
+			nAvailable = (XnUInt32)(m_nBytesReceived - m_nBytesConsumed);
+			bEnded = m_bReceiveEnded;
+			nRetVal = m_nReceiveStatus;
+		}
+
+		if (nAvailable == 0)
+		{
+			if (bEnded || m_bPlaybackThreadShutdown || m_bNetworkAbort)
+			{
+				break;
+			}
+
+			xnOSWaitEvent(m_hReceiveDataEvent, XN_PLAYER_NETWORK_RECEIVE_TIMEOUT);
+			continue;
+		}
+
+		XnUInt32 nReadPos = (XnUInt32)(m_nBytesConsumed % m_nReceiveQueueSize);
+		XnUInt32 nCopy = XN_MIN(nAvailable, nSize - nBytesRead);
+		nCopy = XN_MIN(nCopy, m_nReceiveQueueSize - nReadPos);
+		xnOSMemCopy(pDest + nBytesRead, m_pReceiveQueue + nReadPos, nCopy);
+		nBytesRead += nCopy;
+
+		{
+			XnAutoCSLocker locker(m_hReceiveLock);
+			m_nBytesConsumed += nCopy;
+
+			// forget the arrival of data that was already played
+			while (m_nArrivalMarks > 0 && m_arrivalMarks[m_nFirstArrivalMark].nEndOffset <= m_nBytesConsumed)
+			{
+				m_nFirstArrivalMark = (m_nFirstArrivalMark + 1) % MAX_ARRIVAL_MARKS;
+				--m_nArrivalMarks;
+			}
+		}
+
+		xnOSSetEvent(m_hReceiveSpaceEvent);
+	}
+
+	return (nRetVal);
+}
+
+XnUInt64 PlayerImpl::GetNetworkLatency()
+{
+	XnAutoCSLocker locker(m_hReceiveLock);
+
+	if (m_nArrivalMarks == 0)
+	{
+		// nothing is waiting
+		return 0;
+	}
+
+	// the oldest mark covers the next byte to be read
+	XnUInt64 nNow;
+	xnOSGetHighResTimeStamp(&nNow);
+	XnUInt64 nArrival = m_arrivalMarks[m_nFirstArrivalMark].nTime;
+	return (nNow > nArrival) ? (nNow - nArrival) : 0;
+}
+
+void PlayerImpl::CloseNetworkImpl()
+{
+	if (m_bIsSocketOpen)
+	{
+		m_bReceiveShutdown = TRUE;
+		if (m_hReceiveThread != NULL)
+		{
+			// the thread never blocks for longer than the receive timeout
+			xnOSWaitForThreadExit(m_hReceiveThread, XN_WAIT_INFINITE);
+			xnOSCloseThread(&m_hReceiveThread);
+			m_hReceiveThread = NULL;
+		}
+
+		xnOSCloseSocket(m_hInSocket);
+		m_hInSocket = NULL;
+		xnOSShutdownNetwork();
+		XN_DELETE_ARR(m_pReceiveQueue);
+		m_pReceiveQueue = NULL;
+		m_bIsSocketOpen = FALSE;
+	}
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeAdded(void* pCookie, const XnChar* strNodeName, XnProductionNodeType type, XnCodecID compression)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->AddNode(strNodeName, type, compression);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeRemoved(void* pCookie, const XnChar* strNodeName)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->RemoveNode(strNodeName);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeIntPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnUInt64 nValue)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->SetNodeIntProp(strNodeName, strPropName, nValue);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeRealPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnDouble dValue)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->SetNodeRealProp(strNodeName, strPropName, dValue);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeStringPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, const XnChar* strValue)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->SetNodeStringProp(strNodeName, strPropName, strValue);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeGeneralPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnUInt32 nBufferSize, const void* pBuffer)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->SetNodeGeneralProp(strNodeName, strPropName, nBufferSize, pBuffer);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeStateReady(void* pCookie, const XnChar* strNodeName)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->SetNodeStateReady(strNodeName);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::OnNodeNewData(void* pCookie, const XnChar* strNodeName, XnUInt64 nTimeStamp, XnUInt32 nFrame, const void* pData, XnUInt32 nSize)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	return pThis->SetNodeNewData(strNodeName, nTimeStamp, nFrame, pData, nSize);
+}
+
+XnStatus PlayerImpl::AddNode(const XnChar* strNodeName, XnProductionNodeType type, XnCodecID /*compression*/)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	
+	PlayedNodeInfo playedNodeInfo = {0};
+
+	if (m_playedNodes.Get(strNodeName, playedNodeInfo) == XN_STATUS_OK)
+	{
+		// already in the list, just return OK.
+		return (XN_STATUS_OK);
+	}
+
+	// check if we need to create it (maybe it's a rewind...)
+	if (xnGetRefNodeHandleByName(m_hPlayer->pContext, strNodeName, &playedNodeInfo.hNode) != XN_STATUS_OK)
+	{
+		XnStatus nRetVal = xnCreateMockNode(m_hPlayer->pContext, type, strNodeName, &playedNodeInfo.hNode);
+		XN_IS_STATUS_OK(nRetVal);
+
+		// mark this node as needed node. We need this in order to make sure if xnForceShutdown() is called,
+		// the player will be destroyed *before* mock node is (so we can release it).
+		nRetVal = xnAddNeededNode(m_hPlayer, playedNodeInfo.hNode);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnProductionNodeRelease(playedNodeInfo.hNode);
+			return (nRetVal);
+		}
+	}
+
+	// lock it, so no one can change configuration (this is a file recording)
+	nRetVal = xnLockNodeForChanges(playedNodeInfo.hNode, &playedNodeInfo.hLock);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnProductionNodeRelease(playedNodeInfo.hNode);
+		return (nRetVal);
+	}
+
+	nRetVal = m_playedNodes.Set(strNodeName, playedNodeInfo);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnProductionNodeRelease(playedNodeInfo.hNode);
+		return (nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus PlayerImpl::RemoveNode(const XnChar* strNodeName)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
@@ -649,6 +1433,8 @@ XnStatus PlayerImpl::SetNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeSta
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 
+	m_nPlayedTimestamp = nTimeStamp;
+
 	XnUInt64 nNow;
 	xnOSGetHighResTimeStamp(&nNow);
 
@@ -659,27 +1445,23 @@ XnStatus PlayerImpl::SetNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeSta
 
 		m_bHasTimeReference = TRUE;
 	}
-	else if (m_dPlaybackSpeed != XN_PLAYBACK_SPEED_FASTEST)
+	// (a network source is live - it is already paced by the remote recorder)
+	else if (m_dPlaybackSpeed != XN_PLAYBACK_SPEED_FASTEST && m_sourceType != XN_RECORD_MEDIUM_NETWORK)
 	{
-		// check this data timestamp compared to when we started
-		XnInt64 nTimestampDiff = nTimeStamp - m_nStartTimestamp;
-		
-		// in some recordings, frames are not ordered by timestamp. Make sure this does not break the mechanism
-		if (nTimestampDiff > 0)
-		{
-			XnInt64 nTimeDiff = nNow - m_nStartTime;
+		// the reference is kept for as long as playback keeps up, so every frame is due at an absolute time,
+		// and oversleeping (or a slow frame) is made up for by the following frames instead of piling up.
+		XnUInt64 nDeadline = GetTimestampDeadline(nTimeStamp);
+		XnUInt64 nSanityDeadline = nNow + XN_PLAYBACK_SPEED_SANITY_SLEEP * 1000;
 
-			// check if we need to wait some time
-			XnInt64 nRequestedTimeDiff = (XnInt64)(nTimestampDiff / m_dPlaybackSpeed);
-			if (nTimeDiff < nRequestedTimeDiff)
-			{
-				XnUInt32 nSleep = XnUInt32((nRequestedTimeDiff - nTimeDiff)/1000);
-				nSleep = XN_MIN(nSleep, XN_PLAYBACK_SPEED_SANITY_SLEEP);
-				xnOSSleep(nSleep);
-			}
+		if (nDeadline > nNow)
+		{
+			xnOSSleepUntilHighResTimeStamp(XN_MIN(nDeadline, nSanityDeadline));
+		}
 
-			// update reference to current frame (this will handle cases in which application
-			// stopped reading frames and continued after a while)
+		if (nDeadline > nSanityDeadline || nNow > nDeadline + XN_PLAYBACK_SPEED_SANITY_SLEEP * 1000)
+		{
+			// timestamps jumped, or playback is way behind (probably the application stopped reading frames
+			// and continued after a while). Don't try to catch up - continue from this frame.
 			m_nStartTimestamp = nTimeStamp;
 			xnOSGetHighResTimeStamp(&m_nStartTime);
 		}
@@ -714,6 +1496,8 @@ XnStatus PlayerImpl::SetNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeSta
 	nRetVal = xnLockedNodeEndChanges(playedNode.hNode, playedNode.hLock);
 	XN_IS_STATUS_OK(nRetVal);
 
+	m_playedNodes.Find(strNodeName)->Value().nPlayedFrame = nFrame;
+
 	return XN_STATUS_OK;
 }
 
@@ -746,6 +1530,9 @@ XnStatus PlayerImpl::SetNodeStateReady(const XnChar* strNodeName)
 void PlayerImpl::OnEndOfFileReached()
 {
 	ResetTimeReference();
+
+	// (called on the read-ahead thread, which is the only one touching the merged timeline)
+	m_bLoopPending = TRUE;
 }
 
 void PlayerImpl::EndOfFileReachedCallback(void* pCookie)
@@ -801,9 +1588,464 @@ void PlayerImpl::TriggerPlayback()
 
 XnStatus PlayerImpl::ReadNext()
 {
+	if (m_hReadAheadThread != NULL)
+	{
+		// the module is being read by the read-ahead thread. Just apply what it prepared.
+		return PlayNextQueued();
+	}
+
 	// Always read inside a lock (to make it thread safe)
 	XnAutoCSLocker lock(m_hPlaybackLock);
-	return ModulePlayer().ReadNext(ModuleHandle());
+	XN_TRACE_BEGIN(XN_TRACE_PLAYBACK, m_hPlayer->pNodeInfo->strInstanceName, 0, 0, 0);
+	XnStatus nRetVal = ModulePlayer().ReadNext(ModuleHandle());
+	XN_TRACE_END(XN_TRACE_PLAYBACK, m_hPlayer->pNodeInfo->strInstanceName, 0, 0, 0);
+	return (nRetVal);
+}
+
+XnBool PlayerImpl::IsEOF()
+{
+	if (m_hReadAheadThread != NULL)
+	{
+		// the module is ahead of the application. We're only at EOF once everything it read was played.
+		XnAutoCSLocker locker(m_hQueueLock);
+		return (m_bReadAheadEOF && m_queue.IsEmpty());
+	}
+
+	return ModulePlayer().IsEOF(ModuleHandle());
+}
+
+XnStatus PlayerImpl::StartReadAhead()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (m_hReadAheadThread != NULL)
+	{
+		// already running
+		return (XN_STATUS_OK);
+	}
+
+	{
+		// make sure no one is in the middle of reading while we replace the notifications
+		XnAutoCSLocker locker(m_hPlaybackLock);
+
+		nRetVal = ModulePlayer().SetNodeNotifications(ModuleHandle(), this, &s_queuedNodeNotifications);
+		XN_IS_STATUS_OK(nRetVal);
+
+		m_bReadAheadEOF = ModulePlayer().IsEOF(ModuleHandle());
+	}
+
+	m_nReadAheadStatus = XN_STATUS_OK;
+	m_bReadAheadShutdown = FALSE;
+	m_nLoopOffset = 0;
+	m_nLastMergeTimestamp = 0;
+	m_bLoopPending = FALSE;
+
+	nRetVal = xnOSCreateThread(ReadAheadThread, this, &m_hReadAheadThread);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		m_hReadAheadThread = NULL;
+		XnAutoCSLocker locker(m_hPlaybackLock);
+		ModulePlayer().SetNodeNotifications(ModuleHandle(), this, &s_nodeNotifications);
+		return (nRetVal);
+	}
+
+	xnOSApplyThreadPolicy(m_hReadAheadThread, XN_THREAD_ROLE_PLAYER_READ_AHEAD, "XnReadAhead");
+
+	return (XN_STATUS_OK);
+}
+
+void PlayerImpl::StopReadAhead()
+{
+	if (m_hReadAheadThread == NULL)
+	{
+		return;
+	}
+
+	// the thread checks for shutdown at least once per read, and is never killed (it might be holding the
+	// playback lock)
+	m_bReadAheadShutdown = TRUE;
+	xnOSSetEvent(m_hQueueSpaceEvent);
+	xnOSWaitForThreadExit(m_hReadAheadThread, XN_WAIT_INFINITE);
+	xnOSCloseThread(&m_hReadAheadThread);
+	m_hReadAheadThread = NULL;
+
+	XnAutoCSLocker locker(m_hPlaybackLock);
+	ModulePlayer().SetNodeNotifications(ModuleHandle(), this, &s_nodeNotifications);
+
+	// anything still queued was read ahead of the application, and is lost. Callers that continue playing
+	// (i.e. seeks) reposition the stream anyway.
+	ClearQueue();
+	m_bReadAheadEOF = FALSE;
+}
+
+XnStatus PlayerImpl::PeekNextTimestamp(XnUInt64& nTimestamp, XnBool& bEOF, XnBool bWait /* = TRUE */)
+{
+	XN_IS_BOOL_OK_RET(m_hReadAheadThread != NULL, XN_STATUS_INVALID_OPERATION);
+
+	for (;;)
+	{
+		{
+			XnAutoCSLocker locker(m_hQueueLock);
+
+			for (NotificationsQueue::ConstIterator it = m_queue.Begin(); it != m_queue.End(); ++it)
+			{
+				if (it->type == QUEUED_NEW_DATA)
+				{
+					nTimestamp = it->nMergeTimeStamp;
+					bEOF = FALSE;
+					return (XN_STATUS_OK);
+				}
+			}
+
+			if (m_nReadAheadStatus != XN_STATUS_OK)
+			{
+				return (m_nReadAheadStatus);
+			}
+
+			if (m_bReadAheadEOF)
+			{
+				bEOF = TRUE;
+				return (XN_STATUS_OK);
+			}
+		}
+
+		if (!bWait)
+		{
+			return (XN_STATUS_NO_MATCH);
+		}
+
+		XnStatus nRetVal = xnOSWaitEvent(m_hQueueDataEvent, XN_PLAYER_READ_AHEAD_WAIT_TIMEOUT);
+		if (nRetVal != XN_STATUS_OK && nRetVal != XN_STATUS_OS_EVENT_TIMEOUT)
+		{
+			return (nRetVal);
+		}
+	}
+}
+
+XnStatus PlayerImpl::PlayNextQueued()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// make sure a full frame (or the end of the stream) was queued
+	XnUInt64 nTimestamp = 0;
+	XnBool bEOF = FALSE;
+	nRetVal = PeekNextTimestamp(nTimestamp, bEOF);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnBool bEmpty = TRUE;
+	XnBool bDone = FALSE;
+	while (!bDone)
+	{
+		QueuedNotification notification;
+
+		{
+			XnAutoCSLocker locker(m_hQueueLock);
+			if (m_queue.IsEmpty())
+			{
+				break;
+			}
+
+			notification = *m_queue.Begin();
+			m_queue.Remove(m_queue.Begin());
+			if (notification.type == QUEUED_NEW_DATA)
+			{
+				--m_nQueuedFrames;
+				bDone = TRUE;
+			}
+		}
+
+		if (bDone)
+		{
+			xnOSSetEvent(m_hQueueSpaceEvent);
+		}
+
+		bEmpty = FALSE;
+		nRetVal = ApplyNotification(notification);
+
+		{
+			XnAutoCSLocker locker(m_hQueueLock);
+			ReleaseQueueBuffer(notification.buffer);
+		}
+
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	if (bEmpty && bEOF)
+	{
+		return (XN_STATUS_EOF);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus PlayerImpl::ApplyNotification(const QueuedNotification& notification)
+{
+	switch (notification.type)
+	{
+	case QUEUED_NODE_ADDED:
+		return AddNode(notification.strNodeName, notification.nodeType, notification.compression);
+	case QUEUED_NODE_REMOVED:
+		return RemoveNode(notification.strNodeName);
+	case QUEUED_INT_PROP:
+		return SetNodeIntProp(notification.strNodeName, notification.strPropName, notification.nValue);
+	case QUEUED_REAL_PROP:
+		return SetNodeRealProp(notification.strNodeName, notification.strPropName, notification.dValue);
+	case QUEUED_STRING_PROP:
+		return SetNodeStringProp(notification.strNodeName, notification.strPropName, (const XnChar*)notification.buffer.pData);
+	case QUEUED_GENERAL_PROP:
+		return SetNodeGeneralProp(notification.strNodeName, notification.strPropName, notification.nSize, notification.buffer.pData);
+	case QUEUED_STATE_READY:
+		return SetNodeStateReady(notification.strNodeName);
+	case QUEUED_NEW_DATA:
+		return SetNodeNewData(notification.strNodeName, notification.nTimeStamp, notification.nFrame, notification.buffer.pData, notification.nSize);
+	default:
+		XN_ASSERT(FALSE);
+		return XN_STATUS_ERROR;
+	}
+}
+
+void PlayerImpl::InitNotification(QueuedNotification& notification, QueuedNotificationType type, const XnChar* strNodeName, const XnChar* strPropName)
+{
+	xnOSMemSet(&notification, 0, sizeof(notification));
+	notification.type = type;
+	xnOSStrCopy(notification.strNodeName, strNodeName, sizeof(notification.strNodeName));
+	if (strPropName != NULL)
+	{
+		xnOSStrCopy(notification.strPropName, strPropName, sizeof(notification.strPropName));
+	}
+}
+
+XnStatus PlayerImpl::QueueNotification(QueuedNotification& notification, const void* pData, XnUInt32 nSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnAutoCSLocker locker(m_hQueueLock);
+
+	if (pData != NULL)
+	{
+		// the module reuses its buffers on the next read, so keep a copy. Buffers are recycled, as frames
+		// tend to have the same size.
+		QueueBuffersList::Iterator it = m_freeQueueBuffers.Begin();
+		for (; it != m_freeQueueBuffers.End(); ++it)
+		{
+			if (it->nCapacity >= nSize)
+			{
+				break;
+			}
+		}
+
+		if (it != m_freeQueueBuffers.End())
+		{
+			notification.buffer = *it;
+			m_freeQueueBuffers.Remove(it);
+		}
+		else
+		{
+			notification.buffer.pData = XN_NEW_ARR(XnUInt8, nSize);
+			if (notification.buffer.pData == NULL)
+			{
+				return (XN_STATUS_ALLOC_FAILED);
+			}
+			notification.buffer.nCapacity = nSize;
+		}
+
+		xnOSMemCopy(notification.buffer.pData, pData, nSize);
+		notification.nSize = nSize;
+	}
+
+	nRetVal = m_queue.AddLast(notification);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		ReleaseQueueBuffer(notification.buffer);
+		return (nRetVal);
+	}
+
+	if (notification.type == QUEUED_NEW_DATA)
+	{
+		++m_nQueuedFrames;
+		xnOSSetEvent(m_hQueueDataEvent);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+void PlayerImpl::ReleaseQueueBuffer(QueueBuffer& buffer)
+{
+	if (buffer.pData == NULL)
+	{
+		return;
+	}
+
+	if (m_freeQueueBuffers.AddLast(buffer) != XN_STATUS_OK)
+	{
+		XN_DELETE_ARR(buffer.pData);
+	}
+
+	buffer.pData = NULL;
+	buffer.nCapacity = 0;
+}
+
+void PlayerImpl::ClearQueue()
+{
+	for (NotificationsQueue::Iterator it = m_queue.Begin(); it != m_queue.End(); ++it)
+	{
+		XN_DELETE_ARR(it->buffer.pData);
+	}
+	m_queue.Clear();
+	m_nQueuedFrames = 0;
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeAdded(void* pCookie, const XnChar* strNodeName, XnProductionNodeType type, XnCodecID compression)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_NODE_ADDED, strNodeName, NULL);
+	notification.nodeType = type;
+	notification.compression = compression;
+	return pThis->QueueNotification(notification, NULL, 0);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeRemoved(void* pCookie, const XnChar* strNodeName)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_NODE_REMOVED, strNodeName, NULL);
+	return pThis->QueueNotification(notification, NULL, 0);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeIntPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnUInt64 nValue)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_INT_PROP, strNodeName, strPropName);
+	notification.nValue = nValue;
+	return pThis->QueueNotification(notification, NULL, 0);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeRealPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnDouble dValue)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_REAL_PROP, strNodeName, strPropName);
+	notification.dValue = dValue;
+	return pThis->QueueNotification(notification, NULL, 0);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeStringPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, const XnChar* strValue)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_STRING_PROP, strNodeName, strPropName);
+	return pThis->QueueNotification(notification, strValue, xnOSStrLen(strValue) + 1);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeGeneralPropChanged(void* pCookie, const XnChar* strNodeName, const XnChar* strPropName, XnUInt32 nBufferSize, const void* pBuffer)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_GENERAL_PROP, strNodeName, strPropName);
+	return pThis->QueueNotification(notification, pBuffer, nBufferSize);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeStateReady(void* pCookie, const XnChar* strNodeName)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_STATE_READY, strNodeName, NULL);
+	return pThis->QueueNotification(notification, NULL, 0);
+}
+
+XnStatus XN_CALLBACK_TYPE PlayerImpl::QueueNodeNewData(void* pCookie, const XnChar* strNodeName, XnUInt64 nTimeStamp, XnUInt32 nFrame, const void* pData, XnUInt32 nSize)
+{
+	XN_VALIDATE_INPUT_PTR(pCookie);
+	PlayerImpl* pThis = (PlayerImpl*)pCookie;
+	QueuedNotification notification;
+	InitNotification(notification, QUEUED_NEW_DATA, strNodeName, NULL);
+	notification.nTimeStamp = nTimeStamp;
+	notification.nMergeTimeStamp = pThis->GetMergeTimestamp(nTimeStamp);
+	notification.nFrame = nFrame;
+	return pThis->QueueNotification(notification, pData, nSize);
+}
+
+XnUInt64 PlayerImpl::GetMergeTimestamp(XnUInt64 nTimeStamp)
+{
+	if (m_bLoopPending)
+	{
+		// the player looped, and its timestamps start over. Keep the merged timeline going from where the 
+		// previous loop ended, so the other players are not held back until this one catches up again.
+		if (nTimeStamp + m_nLoopOffset <= m_nLastMergeTimestamp)
+		{
+			m_nLoopOffset = m_nLastMergeTimestamp + 1 - nTimeStamp;
+		}
+		m_bLoopPending = FALSE;
+	}
+
+	m_nLastMergeTimestamp = XN_MAX(m_nLastMergeTimestamp, nTimeStamp + m_nLoopOffset);
+	return (nTimeStamp + m_nLoopOffset);
+}
+
+void PlayerImpl::ReadAheadThread()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	while (!m_bReadAheadShutdown)
+	{
+		XnBool bHasSpace;
+		{
+			XnAutoCSLocker locker(m_hQueueLock);
+			bHasSpace = (m_nQueuedFrames < XN_PLAYER_READ_AHEAD_FRAMES && !m_bReadAheadEOF && m_nReadAheadStatus == XN_STATUS_OK);
+		}
+
+		if (!bHasSpace)
+		{
+			nRetVal = xnOSWaitEvent(m_hQueueSpaceEvent, XN_PLAYER_READ_AHEAD_WAIT_TIMEOUT);
+			if (nRetVal != XN_STATUS_OK && nRetVal != XN_STATUS_OS_EVENT_TIMEOUT)
+			{
+				xnLogWarning(XN_MASK_OPEN_NI, "Failed to wait for event: %s", xnGetStatusString(nRetVal));
+				xnOSSleep(1);
+			}
+			continue;
+		}
+
+		XnBool bEOF;
+		{
+			XnAutoCSLocker lock(m_hPlaybackLock);
+			XN_TRACE_BEGIN(XN_TRACE_PLAYBACK, m_hPlayer->pNodeInfo->strInstanceName, 0, 0, 0);
+			nRetVal = ModulePlayer().ReadNext(ModuleHandle());
+			XN_TRACE_END(XN_TRACE_PLAYBACK, m_hPlayer->pNodeInfo->strInstanceName, 0, 0, 0);
+			bEOF = ModulePlayer().IsEOF(ModuleHandle());
+		}
+
+		{
+			XnAutoCSLocker locker(m_hQueueLock);
+			if (nRetVal != XN_STATUS_OK)
+			{
+				xnLogWarning(XN_MASK_OPEN_NI, "Failed to read ahead: %s", xnGetStatusString(nRetVal));
+				m_nReadAheadStatus = nRetVal;
+			}
+			m_bReadAheadEOF = bEOF;
+		}
+
+		if (nRetVal != XN_STATUS_OK || bEOF)
+		{
+			// wake up anyone waiting for a frame that will never come
+			xnOSSetEvent(m_hQueueDataEvent);
+		}
+	}
+}
+
+XN_THREAD_PROC PlayerImpl::ReadAheadThread(XN_THREAD_PARAM pThreadParam)
+{
+	PlayerImpl* pThis = (PlayerImpl*)pThreadParam;
+	pThis->ReadAheadThread();
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
 }
 
 }
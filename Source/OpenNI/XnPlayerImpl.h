@@ -25,6 +25,8 @@
 #include "XnInternalTypes.h"
 #include <XnModuleInterface.h>
 #include <XnStringsHashT.h>
+#include <XnListT.h>
+#include <XnArray.h>
 #include <XnTypes.h>
 #include <XnOS.h>
 
@@ -40,20 +42,40 @@ public:
 	XnStatus Init(XnNodeHandle hPlayer);
 	virtual void BeforeNodeDestroy();
 	XnStatus SetSource(XnRecordMedium sourceType, const XnChar* strSource);
+	XnStatus SetNetworkOptions(const XnPlayerNetworkOptions& options);
+	void AbortSource();
 	XnStatus GetSource(XnRecordMedium &sourceType, XnChar* strSource, XnUInt32 nBufSize);
 	void Destroy();
 	XnStatus EnumerateNodes(XnNodeInfoList** ppList);
 	XnStatus SetPlaybackSpeed(XnDouble dSpeed);
 	XnDouble GetPlaybackSpeed();
+	XnStatus SetRealTime(XnBool bRealTime);
+	XnBool IsRealTime() { return m_bRealTime; }
 	void TriggerPlayback();
 	XnStatus ReadNext();
+	XnBool IsEOF();
 	XnStatus SeekToTimestamp(XnInt64 nTimeOffset, XnPlayerSeekOrigin origin);
 	XnStatus SeekToFrame(const XnChar* strNodeName, XnInt32 nFrameOffset, XnPlayerSeekOrigin origin);
+	XnStatus TellTimestamp(XnUInt64& nTimestamp);
+	XnStatus TellFrame(const XnChar* strNodeName, XnUInt32& nFrame);
+
+	// Read-ahead mode (used when a context merges several players): records are read and decoded on a
+	// dedicated thread, and the resulting notifications are queued until PlayNextQueued() applies them.
+	// Frames are ordered by their timestamp on a merged timeline, which is the recorded timestamp, except 
+	// that it goes on increasing when the player loops (in repeat mode). Unless bWait is set, 
+	// PeekNextTimestamp() returns XN_STATUS_NO_MATCH instead of waiting for a frame that was not read yet.
+	XnStatus StartReadAhead();
+	void StopReadAhead();
+	XnStatus PeekNextTimestamp(XnUInt64& nTimestamp, XnBool& bEOF, XnBool bWait = TRUE);
+	XnStatus PlayNextQueued();
 
 private:
 	XnModulePlayerInterface& ModulePlayer();
 	XnModuleNodeHandle ModuleHandle();
 	void ResetTimeReference();
+	XnStatus UpdatePlaybackClock(XnBool bRealTime);
+	XnUInt64 GetTimestampDeadline(XnUInt64 nTimeStamp);
+	static XnBool XN_CALLBACK_TYPE IsTimestampDue(void* pCookie, XnUInt64 nTimeStamp);
 
 	static XnStatus XN_CALLBACK_TYPE OpenFile(void* pCookie);
 	static XnStatus XN_CALLBACK_TYPE ReadFile(void* pCookie, void *pBuffer, XnUInt32 nSize, XnUInt32 *pnBytesRead);
@@ -62,6 +84,8 @@ private:
 	static XnUInt32 XN_CALLBACK_TYPE TellFile  (void* pCookie);
 	static XnUInt64 XN_CALLBACK_TYPE TellFile64(void* pCookie);
 	static void XN_CALLBACK_TYPE CloseFile(void *pCookie);
+	static XnUInt32 XN_CALLBACK_TYPE GetSegmentCount(void* pCookie);
+	static XnStatus XN_CALLBACK_TYPE OpenSegment(void* pCookie, XnUInt32 nSegment);
 
 	XnStatus OpenFileImpl();
 	XnStatus ReadFileImpl(void *pData, XnUInt32 nSize, XnUInt32& nBytesRead);
@@ -70,6 +94,27 @@ private:
 	XnUInt32 TellFileImpl  ();
 	XnUInt64 TellFile64Impl();
 	void CloseFileImpl();
+	XnStatus OpenSegmentImpl(XnUInt32 nSegment);
+	XnStatus LoadSegments();
+	XnStatus SetSegmentedInputStream();
+
+	static XnStatus XN_CALLBACK_TYPE OpenNetwork(void* pCookie);
+	static XnStatus XN_CALLBACK_TYPE ReadNetwork(void* pCookie, void *pBuffer, XnUInt32 nSize, XnUInt32 *pnBytesRead);
+	static XnUInt32 XN_CALLBACK_TYPE TellNetwork  (void* pCookie);
+	static XnUInt64 XN_CALLBACK_TYPE TellNetwork64(void* pCookie);
+	static void XN_CALLBACK_TYPE CloseNetwork(void *pCookie);
+
+	XnStatus OpenNetworkImpl();
+	XnStatus AcceptNetworkConnection(XN_SOCKET_HANDLE hListenSocket);
+	XnStatus ReadNetworkImpl(void *pData, XnUInt32 nSize, XnUInt32& nBytesRead);
+	void CloseNetworkImpl();
+	XnUInt64 GetNetworkLatency();
+
+	void ReceiveThread();
+	static XN_THREAD_PROC ReceiveThread(XN_THREAD_PARAM pThreadParam);
+
+	XnStatus SeekToTimestampImpl(XnInt64 nTimeOffset, XnPlayerSeekOrigin origin);
+	XnStatus SeekToFrameImpl(const XnChar* strNodeName, XnInt32 nFrameOffset, XnPlayerSeekOrigin origin);
 
 	//Node notifications
 	static XnStatus XN_CALLBACK_TYPE OnNodeAdded(void* pCookie, const XnChar* strNodeName,
@@ -102,31 +147,151 @@ private:
 	void PlaybackThread();
 	static XN_THREAD_PROC PlaybackThread(XN_THREAD_PARAM pThreadParam);
 
+	typedef enum
+	{
+		QUEUED_NODE_ADDED,
+		QUEUED_NODE_REMOVED,
+		QUEUED_INT_PROP,
+		QUEUED_REAL_PROP,
+		QUEUED_STRING_PROP,
+		QUEUED_GENERAL_PROP,
+		QUEUED_STATE_READY,
+		QUEUED_NEW_DATA,
+	} QueuedNotificationType;
+
+	typedef struct QueueBuffer
+	{
+		XnUInt8* pData;
+		XnUInt32 nCapacity;
+	} QueueBuffer;
+
+	typedef struct QueuedNotification
+	{
+		QueuedNotificationType type;
+		XnChar strNodeName[XN_MAX_NAME_LENGTH];
+		XnChar strPropName[XN_MAX_NAME_LENGTH];
+		XnProductionNodeType nodeType;
+		XnCodecID compression;
+		XnUInt64 nValue;
+		XnDouble dValue;
+		XnUInt64 nTimeStamp;
+		XnUInt64 nMergeTimeStamp; // on the merged timeline
+		XnUInt32 nFrame;
+		QueueBuffer buffer;
+		XnUInt32 nSize;
+	} QueuedNotification;
+
+	typedef XnListT<QueuedNotification> NotificationsQueue;
+	typedef XnListT<QueueBuffer> QueueBuffersList;
+
+	//Node notifications in read-ahead mode
+	static XnStatus XN_CALLBACK_TYPE QueueNodeAdded(void* pCookie, const XnChar* strNodeName,
+		XnProductionNodeType type, XnCodecID compression);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeRemoved(void* pCookie, const XnChar* strNodeName);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeIntPropChanged(void* pCookie, const XnChar* strNodeName, 
+		const XnChar* strPropName, XnUInt64 nValue);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeRealPropChanged(void* pCookie, const XnChar* strNodeName, 
+		const XnChar* strPropName, XnDouble dValue);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeStringPropChanged(void* pCookie, const XnChar* strNodeName, 
+		const XnChar* strPropName, const XnChar* strValue);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeGeneralPropChanged(void* pCookie, const XnChar* strNodeName, 
+		const XnChar* strPropName, XnUInt32 nBufferSize, const void* pBuffer);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeStateReady(void* pCookie, const XnChar* strNodeName);
+	static XnStatus XN_CALLBACK_TYPE QueueNodeNewData(void* pCookie, const XnChar* strNodeName, 
+		XnUInt64 nTimeStamp, XnUInt32 nFrame, const void* pData, XnUInt32 nSize);
+
+	static void InitNotification(QueuedNotification& notification, QueuedNotificationType type, const XnChar* strNodeName, const XnChar* strPropName);
+	XnStatus QueueNotification(QueuedNotification& notification, const void* pData, XnUInt32 nSize);
+	XnUInt64 GetMergeTimestamp(XnUInt64 nTimeStamp);
+	XnStatus ApplyNotification(const QueuedNotification& notification);
+	void ReleaseQueueBuffer(QueueBuffer& buffer);
+	void ClearQueue();
+
+	void ReadAheadThread();
+	static XN_THREAD_PROC ReadAheadThread(XN_THREAD_PARAM pThreadParam);
+
 	typedef struct PlayedNodeInfo
 	{
 		XnNodeHandle hNode;
 		XnLockHandle hLock;
+		XnUInt32 nPlayedFrame; // of the last frame the application got
 	} PlayedNodeInfo;
 
 	typedef XnStringsHashT<PlayedNodeInfo> PlayedNodesHash;
 
+	typedef struct SegmentFile
+	{
+		XnChar strPath[XN_FILE_MAX_PATH];
+	} SegmentFile;
+
+	typedef XnArray<SegmentFile> SegmentFilesArray;
+
+	// the time a part of the network stream was received (it covers the bytes up to nEndOffset)
+	typedef struct ArrivalMark
+	{
+		XnUInt64 nEndOffset;
+		XnUInt64 nTime;
+	} ArrivalMark;
+
+	enum { MAX_ARRIVAL_MARKS = 256 };
+
 	static XnPlayerInputStreamInterface s_fileInputStream;
+	static XnPlayerInputStreamInterface s_networkInputStream;
 	static XnNodeNotifications s_nodeNotifications;
+	static XnNodeNotifications s_queuedNodeNotifications;
 
 	XnNodeHandle m_hPlayer;
 	XnBool m_bIsFileOpen;
 	XN_FILE_HANDLE m_hInFile;
+	XnBool m_bIsSocketOpen;
+	XN_SOCKET_HANDLE m_hInSocket;
+	XnPlayerNetworkOptions m_networkOptions;
+	volatile XnBool m_bNetworkAbort;
+
+	// a network source is received on a dedicated thread, into a bounded queue (a ring buffer)
+	XN_THREAD_HANDLE m_hReceiveThread;
+	XN_CRITICAL_SECTION_HANDLE m_hReceiveLock;
+	XN_EVENT_HANDLE m_hReceiveDataEvent; // set when data was received (or the connection ended)
+	XN_EVENT_HANDLE m_hReceiveSpaceEvent; // set when data was taken from the queue
+	XnUChar* m_pReceiveQueue;
+	XnUInt32 m_nReceiveQueueSize;
+	XnUInt64 m_nBytesReceived;
+	XnUInt64 m_nBytesConsumed;
+	XnBool m_bReceiveEnded;
+	XnStatus m_nReceiveStatus;
+	volatile XnBool m_bReceiveShutdown;
+	ArrivalMark m_arrivalMarks[MAX_ARRIVAL_MARKS]; // for the data in the queue, oldest first
+	XnUInt32 m_nFirstArrivalMark;
+	XnUInt32 m_nArrivalMarks;
 	XnChar m_strSource[XN_FILE_MAX_PATH];
+	SegmentFilesArray m_segments; // empty, unless the source is a segments manifest
+	XnUInt32 m_nCurrentSegment;
 	XnRecordMedium m_sourceType;
 	PlayedNodesHash m_playedNodes;
 	XnDouble m_dPlaybackSpeed;
 	XnUInt64 m_nStartTimestamp;
 	XnUInt64 m_nStartTime;
 	XnBool m_bHasTimeReference;
+	XnBool m_bRealTime;
 	XN_THREAD_HANDLE m_hPlaybackThread;
 	XN_EVENT_HANDLE m_hPlaybackEvent;
 	XN_CRITICAL_SECTION_HANDLE m_hPlaybackLock;
 	XnBool m_bPlaybackThreadShutdown;
+
+	XN_THREAD_HANDLE m_hReadAheadThread;
+	XN_EVENT_HANDLE m_hQueueDataEvent; // set when a frame (or EOF) is queued
+	XN_EVENT_HANDLE m_hQueueSpaceEvent; // set when a frame is taken from the queue
+	XN_CRITICAL_SECTION_HANDLE m_hQueueLock;
+	NotificationsQueue m_queue;
+	QueueBuffersList m_freeQueueBuffers;
+	XnUInt32 m_nQueuedFrames;
+	XnBool m_bReadAheadEOF;
+	XnStatus m_nReadAheadStatus;
+	volatile XnBool m_bReadAheadShutdown;
+	XnUInt64 m_nLoopOffset; // added to recorded timestamps to get the merged timeline
+	XnUInt64 m_nLastMergeTimestamp;
+	XnBool m_bLoopPending; // stream ended, and (in repeat mode) starts over with the next frame
+	XnUInt64 m_nPlayedTimestamp; // of the last frame the application got (the module may be ahead of it)
 };
 
 }
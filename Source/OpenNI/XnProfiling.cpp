@@ -148,6 +148,8 @@ XN_C_API XnStatus xnProfilingInit(XnUInt32 nProfilingInterval)
 		nRetVal = xnOSCreateThread(xnProfilingThread, (XN_THREAD_PARAM)NULL, &g_ProfilingData.hThread);
 		XN_IS_STATUS_OK(nRetVal);
 
+		xnOSApplyThreadPolicy(g_ProfilingData.hThread, XN_THREAD_ROLE_PROFILING, "XnProfiling");
+
 		nRetVal = xnOSCreateCriticalSection(&g_ProfilingData.hCriticalSection);
 		XN_IS_STATUS_OK(nRetVal);
 
@@ -28,6 +28,17 @@
 #include "XnPropNames.h"
 #include <XnCodecIDs.h>
 #include "XnTypeManager.h"
+#include "xnInternalFuncs.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_RECORDER_NETWORK_CONNECT_TIMEOUT		5000
+#define XN_RECORDER_NETWORK_SEND_BUFFER_SIZE	(64 * 1024)
+#define XN_RECORDER_NETWORK_SOCKET_BUFFER_SIZE	(1024 * 1024)
+#define XN_RECORDER_FILE_WRITE_BUFFER_SIZE		(4 * 1024 * 1024)
+#define XN_RECORDER_FILE_PREALLOCATION_STEP		(64 * 1024 * 1024)
+#define XN_RECORDER_SEGMENT_NAME_FORMAT			"%s-%05u.oni"
 
 namespace xn 
 {
@@ -43,13 +54,42 @@ XnRecorderOutputStreamInterface RecorderImpl::s_fileOutputStream =
 	&RecorderImpl::TellFile64
 };
 
+XnRecorderOutputStreamInterface RecorderImpl::s_networkOutputStream = 
+{
+	&RecorderImpl::OpenNetwork,
+	&RecorderImpl::WriteNetwork,
+	NULL,
+	&RecorderImpl::TellNetwork,
+	&RecorderImpl::CloseNetwork,
+	NULL,
+	&RecorderImpl::TellNetwork64
+};
+
 RecorderImpl::RecorderImpl() : 
 	m_destType(XN_RECORD_MEDIUM_FILE),
 	m_bIsFileOpen(FALSE),
 	m_hOutFile(XN_INVALID_FILE_HANDLE),
+	m_pPatchBlock(NULL),
+	m_bDirectIO(FALSE),
+	m_bPreallocate(FALSE),
+	m_pWriteBuffer(NULL),
+	m_nWriteBufferSize(0),
+	m_nWriteBufferUsed(0),
+	m_nWriteBufferPos(0),
+	m_nWritePos(0),
+	m_nPreallocatedSize(0),
+	m_nSegment(0),
+	m_nSegmentStartTimestamp(XN_MAX_UINT64),
+	m_bIsSocketOpen(FALSE),
+	m_hOutSocket(NULL),
+	m_pSendBuffer(NULL),
+	m_nSendBufferUsed(0),
+	m_nBytesSent(0),
 	m_hRecorder(NULL)
 {
 	xnOSMemSet(m_strFileName, 0, sizeof(m_strFileName));
+	xnOSMemSet(m_strSegmentFileName, 0, sizeof(m_strSegmentFileName));
+	xnOSMemSet(&m_fileOptions, 0, sizeof(m_fileOptions));
 }
 
 RecorderImpl::~RecorderImpl()
@@ -81,10 +121,16 @@ void RecorderImpl::Destroy()
 {
 	for (NodeWatchersMap::Iterator it = m_nodeWatchersMap.Begin(); it != m_nodeWatchersMap.End(); ++it)
 	{
-		XN_DELETE(it->Value());
+		XN_DELETE(it->Value().pWatcher);
 	}
 	m_nodeWatchersMap.Clear();
+	for (RawNodesMap::Iterator it = m_rawNodesMap.Begin(); it != m_rawNodesMap.End(); ++it)
+	{
+		FreeRawNodeProps(it->Value());
+	}
+	m_rawNodesMap.Clear();
 	CloseFileImpl();	
+	CloseNetworkImpl();
 }
 
 XnStatus RecorderImpl::AddNode(ProductionNode &node, XnCodecID compression)
@@ -132,7 +178,11 @@ XnStatus RecorderImpl::AddNode(ProductionNode &node, XnCodecID compression)
 		return nRetVal;
 	}
 
-	nRetVal = m_nodeWatchersMap.Set(node.GetHandle(), pNodeWatcher);
+	WatchedNode watchedNode;
+	watchedNode.pWatcher = pNodeWatcher;
+	watchedNode.type = type;
+	watchedNode.compression = compression;
+	nRetVal = m_nodeWatchersMap.Set(node.GetHandle(), watchedNode);
 	if (nRetVal != XN_STATUS_OK)
 	{
 		XN_DELETE(pNodeWatcher);
@@ -167,9 +217,8 @@ XnStatus RecorderImpl::AddRawNode(const XnChar* strNodeName)
 	}
 
 	XnNodeHandle hNode = NULL;
-	NodeWatcher* pNodeWatcher = NULL;
 	if ((xnGetRefNodeHandleByName(m_hRecorder->pContext, strNodeName, &hNode) == XN_STATUS_OK) &&
-		(m_nodeWatchersMap.Get(hNode, pNodeWatcher) == XN_STATUS_OK))
+		(m_nodeWatchersMap.Find(hNode) != m_nodeWatchersMap.End()))
 	{
 		//There's a node by that name and we're already watching it
 		xnLogWarning(XN_MASK_OPEN_NI, "Attempted to add a raw node by name of '%s' but there is already another node by that name that is being recorded", strNodeName);
@@ -178,11 +227,15 @@ XnStatus RecorderImpl::AddRawNode(const XnChar* strNodeName)
 		return XN_STATUS_INVALID_OPERATION;
 	}
 
+	RawNodeInfo rawNodeInfo;
+	rawNodeInfo.type = (XnProductionNodeType)0;
+	rawNodeInfo.compression = XN_CODEC_UNCOMPRESSED;
+	rawNodeInfo.bStateReady = FALSE;
+
 	XnStatus nRetVal = Notifications().OnNodeAdded(ModuleHandle(), 
-		strNodeName, (XnProductionNodeType)0, XN_CODEC_UNCOMPRESSED);
+		strNodeName, rawNodeInfo.type, rawNodeInfo.compression);
 	XN_IS_STATUS_OK(nRetVal);
 
-	RawNodeInfo rawNodeInfo;
 	nRetVal = m_rawNodesMap.Set(strNodeName, rawNodeInfo);
 	XN_IS_STATUS_OK(nRetVal);
 
@@ -199,7 +252,15 @@ XnStatus RecorderImpl::RemoveRawNode(const XnChar* strNodeName)
 		return XN_STATUS_NO_MATCH;
 	}
 
-	return Notifications().OnNodeRemoved(ModuleHandle(), strNodeName);
+	XnStatus nRetVal = Notifications().OnNodeRemoved(ModuleHandle(), strNodeName);
+	XN_IS_STATUS_OK(nRetVal);
+
+	// forget it, so it isn't added again to the next segment
+	RawNodesMap::Iterator it = m_rawNodesMap.Find(strNodeName);
+	FreeRawNodeProps(it->Value());
+	m_rawNodesMap.Remove(it);
+
+	return XN_STATUS_OK;
 }
 
 
@@ -212,7 +273,10 @@ XnStatus RecorderImpl::SetRawNodeIntProp(const XnChar* strNodeName, const XnChar
 		return XN_STATUS_NO_MATCH;
 	}
 
-	return Notifications().OnNodeIntPropChanged(ModuleHandle(), strNodeName, strPropName, nVal);
+	XnStatus nRetVal = Notifications().OnNodeIntPropChanged(ModuleHandle(), strNodeName, strPropName, nVal);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return SaveRawNodeProp(strNodeName, strPropName, RAW_NODE_PROP_INT, sizeof(nVal), &nVal);
 }
 
 XnStatus RecorderImpl::SetRawNodeRealProp(const XnChar* strNodeName, const XnChar* strPropName, XnDouble dVal)
@@ -224,7 +288,10 @@ XnStatus RecorderImpl::SetRawNodeRealProp(const XnChar* strNodeName, const XnCha
 		return XN_STATUS_NO_MATCH;
 	}
 
-	return Notifications().OnNodeRealPropChanged(ModuleHandle(), strNodeName, strPropName, dVal);
+	XnStatus nRetVal = Notifications().OnNodeRealPropChanged(ModuleHandle(), strNodeName, strPropName, dVal);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return SaveRawNodeProp(strNodeName, strPropName, RAW_NODE_PROP_REAL, sizeof(dVal), &dVal);
 }
 
 XnStatus RecorderImpl::SetRawNodeStringProp(const XnChar* strNodeName, const XnChar* strPropName, const XnChar* strVal)
@@ -236,7 +303,10 @@ XnStatus RecorderImpl::SetRawNodeStringProp(const XnChar* strNodeName, const XnC
 		return XN_STATUS_NO_MATCH;
 	}
 
-	return Notifications().OnNodeStringPropChanged(ModuleHandle(), strNodeName, strPropName, strVal);
+	XnStatus nRetVal = Notifications().OnNodeStringPropChanged(ModuleHandle(), strNodeName, strPropName, strVal);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return SaveRawNodeProp(strNodeName, strPropName, RAW_NODE_PROP_STRING, xnOSStrLen(strVal) + 1, strVal);
 }
 
 XnStatus RecorderImpl::SetRawNodeGeneralProp(const XnChar* strNodeName, const XnChar* strPropName, XnUInt32 nBufferSize, const void* pBuffer)
@@ -248,7 +318,10 @@ XnStatus RecorderImpl::SetRawNodeGeneralProp(const XnChar* strNodeName, const Xn
 		return XN_STATUS_NO_MATCH;
 	}
 
-	return Notifications().OnNodeGeneralPropChanged(ModuleHandle(), strNodeName, strPropName, nBufferSize, pBuffer);
+	XnStatus nRetVal = Notifications().OnNodeGeneralPropChanged(ModuleHandle(), strNodeName, strPropName, nBufferSize, pBuffer);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return SaveRawNodeProp(strNodeName, strPropName, RAW_NODE_PROP_GENERAL, nBufferSize, pBuffer);
 }
 
 XnStatus RecorderImpl::NotifyRawNodeStateReady(const XnChar* strNodeName)
@@ -260,7 +333,11 @@ XnStatus RecorderImpl::NotifyRawNodeStateReady(const XnChar* strNodeName)
 		return XN_STATUS_NO_MATCH;
 	}
 	
-	return Notifications().OnNodeStateReady(ModuleHandle(), strNodeName);
+	XnStatus nRetVal = Notifications().OnNodeStateReady(ModuleHandle(), strNodeName);
+	XN_IS_STATUS_OK(nRetVal);
+
+	m_rawNodesMap.Find(strNodeName)->Value().bStateReady = TRUE;
+	return XN_STATUS_OK;
 }
 
 XnStatus RecorderImpl::SetRawNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeStamp, XnUInt32 nFrame, const void* pData, XnUInt32 nSize)
@@ -285,7 +362,7 @@ XnStatus RecorderImpl::RemoveNodeImpl(ProductionNode &node)
 		return XN_STATUS_NO_MATCH;
 	}
 
-	XN_DELETE(it->Value());
+	XN_DELETE(it->Value().pWatcher);
 
 	XnStatus nRetVal = m_nodeWatchersMap.Remove(it);
 	XN_IS_STATUS_OK(nRetVal);
@@ -341,6 +418,20 @@ XnStatus RecorderImpl::SetDestination(XnRecordMedium destType, const XnChar* str
 			XN_IS_STATUS_OK(nRetVal);
 			break;
 		}
+		case XN_RECORD_MEDIUM_NETWORK:
+		{
+			if (m_bIsSocketOpen)
+			{
+				XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "Recorder destination is already set!");
+			}
+
+			m_destType = destType;
+			nRetVal = xnOSStrCopy(m_strFileName, strDest, sizeof(m_strFileName));
+			XN_IS_STATUS_OK(nRetVal);
+			nRetVal = ModuleRecorder().SetOutputStream(ModuleHandle(), this, &s_networkOutputStream);
+			XN_IS_STATUS_OK(nRetVal);
+			break;
+		}
 		default:
 			XN_ASSERT(FALSE);
 			return XN_STATUS_BAD_PARAM;
@@ -349,12 +440,24 @@ XnStatus RecorderImpl::SetDestination(XnRecordMedium destType, const XnChar* str
 	return XN_STATUS_OK;
 }
 
+XnStatus RecorderImpl::SetFileOptions(const XnRecorderFileOptions& options)
+{
+	if (m_bIsFileOpen)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_INVALID_OPERATION, XN_MASK_OPEN_NI, "File options must be set before the recorder destination!");
+	}
+
+	m_fileOptions = options;
+	return XN_STATUS_OK;
+}
+
 XnStatus RecorderImpl::GetDestination(XnRecordMedium& destType, XnChar* strDest, XnUInt32 nBufSize)
 {
 	XnStatus nRetVal = XN_STATUS_OK;
 	switch (m_destType)
 	{
 		case XN_RECORD_MEDIUM_FILE:
+		case XN_RECORD_MEDIUM_NETWORK:
 			destType = m_destType;
 			nRetVal = xnOSStrCopy(strDest, m_strFileName, nBufSize);
 			XN_IS_STATUS_OK(nRetVal);
@@ -417,8 +520,8 @@ XnStatus RecorderImpl::Record()
 
 	for (NodeWatchersMap::Iterator it = m_nodeWatchersMap.Begin(); it != m_nodeWatchersMap.End(); ++it)
 	{
-		watchers[nCount].pWatcher = it->Value();
-		watchers[nCount].nTimestamp = it->Value()->GetTimestamp();
+		watchers[nCount].pWatcher = it->Value().pWatcher;
+		watchers[nCount].nTimestamp = it->Value().pWatcher->GetTimestamp();
 		++nCount;
 
 		if (nCount > MAX_SUPPORTED_NODES)
@@ -435,6 +538,20 @@ XnStatus RecorderImpl::Record()
 		XN_IS_STATUS_OK(nRetVal);
 	}
 
+	// network writes are batched per update cycle, so a remote player receives each cycle as a whole
+	if (m_bIsSocketOpen)
+	{
+		nRetVal = FlushNetworkImpl();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	// segments are only switched between cycles, so that no frame is split or lost
+	if (nCount > 0)
+	{
+		nRetVal = UpdateSegment(watchers[nCount-1].nTimestamp);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
 	return XN_STATUS_OK;
 }
 
@@ -494,21 +611,86 @@ void RecorderImpl::CloseFile(void* pCookie)
 
 XnStatus RecorderImpl::OpenFileImpl()
 {
+	XnStatus nRetVal = XN_STATUS_OK;
+
 	if (m_bIsFileOpen)
 	{
 		//Already open
 		return XN_STATUS_OK;
 	}
 
-	XnStatus nRetVal = xnOSOpenFile(m_strFileName, XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE, &m_hOutFile);
+	if (IsSegmented())
+	{
+		nRetVal = GetSegmentFileName(m_nSegment, m_strSegmentFileName, sizeof(m_strSegmentFileName));
+		XN_IS_STATUS_OK(nRetVal);
+	}
+	else
+	{
+		nRetVal = xnOSStrCopy(m_strSegmentFileName, m_strFileName, sizeof(m_strSegmentFileName));
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	m_bDirectIO = m_fileOptions.bDirectIO;
+	if (m_bDirectIO)
+	{
+		// read as well, as updates of flushed data rewrite whole blocks
+		nRetVal = xnOSOpenFile(m_strSegmentFileName, XN_OS_FILE_READ | XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE | XN_OS_FILE_DIRECT, &m_hOutFile);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			// some file systems (tmpfs, for one) do not support it
+			xnLogWarning(XN_MASK_OPEN_NI, "Direct I/O is not available for '%s'. Using cached writes.", m_strSegmentFileName);
+			m_bDirectIO = FALSE;
+		}
+	}
+
+	if (!m_bDirectIO)
+	{
+		nRetVal = xnOSOpenFile(m_strSegmentFileName, XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE, &m_hOutFile);
+	}
 
 	if (nRetVal != XN_STATUS_OK)
 	{
-		xnLogWarning(XN_MASK_OPEN_NI, "Failed to open file '%s' for writing", m_strFileName);
+		xnLogWarning(XN_MASK_OPEN_NI, "Failed to open file '%s' for writing", m_strSegmentFileName);
 		return XN_STATUS_OS_FILE_OPEN_FAILED;
 	}
+
+	// direct I/O requires both the buffer and the write size to be aligned
+	m_nWriteBufferSize = (m_fileOptions.nWriteBufferSize != 0) ? m_fileOptions.nWriteBufferSize : XN_RECORDER_FILE_WRITE_BUFFER_SIZE;
+	m_nWriteBufferSize = (m_nWriteBufferSize + XN_OS_FILE_DIRECT_ALIGNMENT - 1) / XN_OS_FILE_DIRECT_ALIGNMENT * XN_OS_FILE_DIRECT_ALIGNMENT;
+	m_pWriteBuffer = (XnUChar*)xnOSMallocAligned(m_nWriteBufferSize, XN_OS_FILE_DIRECT_ALIGNMENT);
+	if (m_bDirectIO && m_pWriteBuffer != NULL)
+	{
+		m_pPatchBlock = (XnUChar*)xnOSMallocAligned(XN_OS_FILE_DIRECT_ALIGNMENT, XN_OS_FILE_DIRECT_ALIGNMENT);
+		if (m_pPatchBlock == NULL)
+		{
+			xnOSFreeAligned(m_pWriteBuffer);
+			m_pWriteBuffer = NULL;
+		}
+	}
+
+	if (m_pWriteBuffer == NULL)
+	{
+		xnOSCloseFile(&m_hOutFile);
+		return XN_STATUS_ALLOC_FAILED;
+	}
+
+	m_nWriteBufferUsed = 0;
+	m_nWriteBufferPos = 0;
+	m_nWritePos = 0;
+	m_bPreallocate = TRUE;
+	m_nPreallocatedSize = 0;
 	m_bIsFileOpen = TRUE;
 
+	if (IsSegmented())
+	{
+		nRetVal = AddSegmentToManifest();
+		if (nRetVal != XN_STATUS_OK)
+		{
+			CloseFileImpl();
+			return (nRetVal);
+		}
+	}
+
 	return XN_STATUS_OK;	
 }
 
@@ -516,57 +698,615 @@ XnStatus RecorderImpl::WriteFileImpl(const XnChar* /*strNodeName*/,
 									 const void* pData, 
 									 XnUInt32 nSize)
 {
+	XnStatus nRetVal = XN_STATUS_OK;
+
 	//strNodeName may be NULL
 	XN_IS_BOOL_OK_RET(m_bIsFileOpen, XN_STATUS_ERROR);
 
-	return xnOSWriteFile(m_hOutFile, pData, nSize);
+	const XnUChar* pBytes = (const XnUChar*)pData;
+
+	// the recorder goes back to update records it already wrote. Whatever is no longer in the buffer goes
+	// straight to the file, after the buffer (which the update may point to), so an unclosed recording stays
+	// consistent.
+	if (m_nWritePos < m_nWriteBufferPos)
+	{
+		nRetVal = FlushWriteBuffer();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	if (m_nWritePos < m_nWriteBufferPos)
+	{
+		XnUInt32 nPatchSize = (XnUInt32)XN_MIN((XnUInt64)nSize, m_nWriteBufferPos - m_nWritePos);
+		nRetVal = PatchFile(pBytes, nPatchSize);
+		XN_IS_STATUS_OK(nRetVal);
+
+		m_nWritePos += nPatchSize;
+		pBytes += nPatchSize;
+		nSize -= nPatchSize;
+	}
+
+	if (!m_bDirectIO && m_nWriteBufferUsed == 0 && m_nWritePos == m_nWriteBufferPos && nSize >= m_nWriteBufferSize)
+	{
+		// large payloads are written as is, no point in copying them
+		nRetVal = WriteFileAt(m_hOutFile, m_nWritePos, pBytes, nSize);
+		XN_IS_STATUS_OK(nRetVal);
+
+		m_nWritePos += nSize;
+		m_nWriteBufferPos = m_nWritePos;
+		return XN_STATUS_OK;
+	}
+
+	while (nSize > 0)
+	{
+		XnUInt32 nOffset = (XnUInt32)(m_nWritePos - m_nWriteBufferPos);
+		if (nOffset == m_nWriteBufferSize)
+		{
+			nRetVal = FlushWriteBuffer();
+			XN_IS_STATUS_OK(nRetVal);
+			continue;
+		}
+
+		XnUInt32 nChunk = XN_MIN(nSize, m_nWriteBufferSize - nOffset);
+		xnOSMemCopy(m_pWriteBuffer + nOffset, pBytes, nChunk);
+		m_nWriteBufferUsed = XN_MAX(m_nWriteBufferUsed, nOffset + nChunk);
+		m_nWritePos += nChunk;
+		pBytes += nChunk;
+		nSize -= nChunk;
+	}
+
+	return XN_STATUS_OK;
 }
 
+XnStatus RecorderImpl::FlushWriteBuffer()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (m_nWriteBufferUsed == 0)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	XnUInt32 nWriteSize = m_nWriteBufferUsed;
+	if (m_bDirectIO)
+	{
+		// pad the last block. The file is truncated to its real size when closed.
+		nWriteSize = (m_nWriteBufferUsed + XN_OS_FILE_DIRECT_ALIGNMENT - 1) / XN_OS_FILE_DIRECT_ALIGNMENT * XN_OS_FILE_DIRECT_ALIGNMENT;
+		xnOSMemSet(m_pWriteBuffer + m_nWriteBufferUsed, 0, nWriteSize - m_nWriteBufferUsed);
+	}
+
+	PreallocateFile(m_nWriteBufferPos + nWriteSize);
+
+	nRetVal = WriteFileAt(m_hOutFile, m_nWriteBufferPos, m_pWriteBuffer, nWriteSize);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to write to '%s': %s", m_strSegmentFileName, xnGetStatusString(nRetVal));
+	}
+
+	if (m_bDirectIO)
+	{
+		// keep the partial last block, as the next flush must start on a block boundary
+		XnUInt32 nFullBlocksSize = m_nWriteBufferUsed / XN_OS_FILE_DIRECT_ALIGNMENT * XN_OS_FILE_DIRECT_ALIGNMENT;
+		xnOSMemMove(m_pWriteBuffer, m_pWriteBuffer + nFullBlocksSize, m_nWriteBufferUsed - nFullBlocksSize);
+		m_nWriteBufferPos += nFullBlocksSize;
+		m_nWriteBufferUsed -= nFullBlocksSize;
+	}
+	else
+	{
+		m_nWriteBufferPos += m_nWriteBufferUsed;
+		m_nWriteBufferUsed = 0;
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus RecorderImpl::PatchFile(const void* pData, XnUInt32 nSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (!m_bDirectIO)
+	{
+		return WriteFileAt(m_hOutFile, m_nWritePos, pData, nSize);
+	}
+
+	// direct writes must be aligned, so each block the update touches is read, updated and written back whole
+	const XnUChar* pBytes = (const XnUChar*)pData;
+	XnUInt64 nPos = m_nWritePos;
+	while (nSize > 0)
+	{
+		XnUInt64 nBlockPos = nPos / XN_OS_FILE_DIRECT_ALIGNMENT * XN_OS_FILE_DIRECT_ALIGNMENT;
+		XnUInt32 nOffset = (XnUInt32)(nPos - nBlockPos);
+		XnUInt32 nChunk = XN_MIN(nSize, XN_OS_FILE_DIRECT_ALIGNMENT - nOffset);
+
+		XnUInt32 nBlockSize = XN_OS_FILE_DIRECT_ALIGNMENT;
+		nRetVal = xnOSReadFileAt(m_hOutFile, nBlockPos, m_pPatchBlock, &nBlockSize);
+		XN_IS_STATUS_OK(nRetVal);
+		XN_IS_BOOL_OK_RET(nBlockSize == XN_OS_FILE_DIRECT_ALIGNMENT, XN_STATUS_OS_FILE_READ_FAILED);
+
+		xnOSMemCopy(m_pPatchBlock + nOffset, pBytes, nChunk);
+
+		nRetVal = WriteFileAt(m_hOutFile, nBlockPos, m_pPatchBlock, XN_OS_FILE_DIRECT_ALIGNMENT);
+		XN_IS_STATUS_OK(nRetVal);
+
+		nPos += nChunk;
+		pBytes += nChunk;
+		nSize -= nChunk;
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus RecorderImpl::WriteFileAt(XN_FILE_HANDLE hFile, XnUInt64 nPos, const void* pData, XnUInt32 nSize)
+{
+	XnStatus nRetVal = xnOSSeekFile64(hFile, XN_OS_SEEK_SET, nPos);
+	XN_IS_STATUS_OK(nRetVal);
+	return xnOSWriteFile(hFile, pData, nSize);
+}
+
+void RecorderImpl::PreallocateFile(XnUInt64 nEnd)
+{
+	if (!m_bPreallocate || nEnd <= m_nPreallocatedSize)
+	{
+		return;
+	}
+
+	// reserve a whole segment at once if we know its size, or a big step of it otherwise
+	XnUInt64 nSize = (nEnd + XN_RECORDER_FILE_PREALLOCATION_STEP - 1) / XN_RECORDER_FILE_PREALLOCATION_STEP * XN_RECORDER_FILE_PREALLOCATION_STEP;
+	if (nEnd <= m_fileOptions.nSegmentBytes)
+	{
+		nSize = m_fileOptions.nSegmentBytes;
+	}
+
+	XnStatus nRetVal = xnOSPreallocateFile(m_hOutFile, nSize);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogVerbose(XN_MASK_OPEN_NI, "Can't preallocate '%s' (%s). File will grow as needed.", m_strSegmentFileName, xnGetStatusString(nRetVal));
+		m_bPreallocate = FALSE;
+		return;
+	}
+
+	m_nPreallocatedSize = nSize;
+}
 
 XnStatus RecorderImpl::SeekFileImpl(XnOSSeekType seekType, const XnInt32 nOffset)
 {
-	XN_IS_BOOL_OK_RET(m_bIsFileOpen, XN_STATUS_ERROR);
-	return xnOSSeekFile64(m_hOutFile, seekType, nOffset);
+	return SeekFile64Impl(seekType, nOffset);
 }
 
 XnStatus RecorderImpl::SeekFile64Impl(XnOSSeekType seekType, const XnInt64 nOffset)
 {
 	XN_IS_BOOL_OK_RET(m_bIsFileOpen, XN_STATUS_ERROR);
-	return xnOSSeekFile64(m_hOutFile, seekType, nOffset);
+
+	// only the write position moves. Data is written to the file when the buffer is flushed.
+	XnUInt64 nEnd = m_nWriteBufferPos + m_nWriteBufferUsed;
+	XnInt64 nPos = nOffset;
+	switch (seekType)
+	{
+	case XN_OS_SEEK_SET:
+		break;
+	case XN_OS_SEEK_CUR:
+		nPos += m_nWritePos;
+		break;
+	case XN_OS_SEEK_END:
+		nPos += nEnd;
+		break;
+	default:
+		return XN_STATUS_BAD_PARAM;
+	}
+
+	if (nPos < 0 || (XnUInt64)nPos > nEnd)
+	{
+		XN_LOG_WARNING_RETURN(XN_STATUS_OS_FILE_SEEK_FAILED, XN_MASK_OPEN_NI, "Can't seek outside of recorded data in '%s'", m_strSegmentFileName);
+	}
+
+	m_nWritePos = nPos;
+	return XN_STATUS_OK;
 }
 
 XnUInt32 RecorderImpl::TellFileImpl()
 {
 	XN_IS_BOOL_OK_RET(m_bIsFileOpen, XN_STATUS_ERROR);
-	XnUInt64 pos;
-	XnStatus nRetVal = xnOSTellFile64(m_hOutFile, &pos);
-	XN_IS_STATUS_OK_RET(nRetVal, (XnUInt32) -1);
 	// Enforce uint32 limitation
-	if (pos >> 32)
+	if (m_nWritePos >> 32)
 		return (XnUInt32) -1;
 
-	return (XnUInt32)pos;
+	return (XnUInt32)m_nWritePos;
 }
 
 XnUInt64 RecorderImpl::TellFile64Impl()
 {
 	XN_IS_BOOL_OK_RET(m_bIsFileOpen, XN_STATUS_ERROR);
-	XnUInt64 pos;
-	XnStatus nRetVal = xnOSTellFile64(m_hOutFile, &pos);
-	XN_IS_STATUS_OK_RET(nRetVal, (XnUInt64) -1);
-
-	return pos;
+	return m_nWritePos;
 }
 
 void RecorderImpl::CloseFileImpl()
 {
 	if (m_bIsFileOpen)
 	{
+		XnStatus nRetVal = FlushWriteBuffer();
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogError(XN_MASK_OPEN_NI, "Recording '%s' is incomplete: %s", m_strSegmentFileName, xnGetStatusString(nRetVal));
+		}
+
+		// drop direct I/O padding and unused preallocated space
+		XnUInt64 nEnd = m_nWriteBufferPos + m_nWriteBufferUsed;
+		if (m_bDirectIO || m_nPreallocatedSize > nEnd)
+		{
+			xnOSTruncateFile(m_hOutFile, nEnd);
+		}
+
 		xnOSCloseFile(&m_hOutFile);
+		xnOSFreeAligned(m_pWriteBuffer);
+		m_pWriteBuffer = NULL;
+		if (m_pPatchBlock != NULL)
+		{
+			xnOSFreeAligned(m_pPatchBlock);
+			m_pPatchBlock = NULL;
+		}
 		m_bIsFileOpen = FALSE;
 	}
 }
 
+XnBool RecorderImpl::IsSegmented()
+{
+	return (m_fileOptions.nSegmentSeconds != 0 || m_fileOptions.nSegmentBytes != 0);
+}
+
+XnStatus RecorderImpl::GetSegmentFileName(XnUInt32 nSegment, XnChar* strFileName, XnUInt32 nBufSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// segments are named after the destination, without its extension
+	XnChar strStem[XN_FILE_MAX_PATH];
+	nRetVal = xnOSStrCopy(strStem, m_strFileName, sizeof(strStem));
+	XN_IS_STATUS_OK(nRetVal);
+
+	for (XnInt32 i = (XnInt32)xnOSStrLen(strStem) - 1; i >= 0 && strStem[i] != '/' && strStem[i] != '\\'; --i)
+	{
+		if (strStem[i] == '.')
+		{
+			strStem[i] = '\0';
+			break;
+		}
+	}
+
+	XnUInt32 nCharsWritten = 0;
+	nRetVal = xnOSStrFormat(strFileName, nBufSize, &nCharsWritten, XN_RECORDER_SEGMENT_NAME_FORMAT, strStem, nSegment);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus RecorderImpl::AddSegmentToManifest()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// the manifest lists segments relative to itself, so a recording can be moved around as a whole
+	XnChar strSegment[XN_FILE_MAX_PATH];
+	nRetVal = xnOSGetFileName(m_strSegmentFileName, strSegment, sizeof(strSegment));
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnChar strLine[XN_FILE_MAX_PATH + sizeof(XN_SEGMENTS_MANIFEST_HEADER) + 2];
+	XnUInt32 nCharsWritten = 0;
+	if (m_nSegment == 0)
+	{
+		nRetVal = xnOSStrFormat(strLine, sizeof(strLine), &nCharsWritten, "%s\n%s\n", XN_SEGMENTS_MANIFEST_HEADER, strSegment);
+		XN_IS_STATUS_OK(nRetVal);
+		nRetVal = xnOSSaveFile(m_strFileName, strLine, nCharsWritten);
+	}
+	else
+	{
+		nRetVal = xnOSStrFormat(strLine, sizeof(strLine), &nCharsWritten, "%s\n", strSegment);
+		XN_IS_STATUS_OK(nRetVal);
+		nRetVal = xnOSAppendFile(m_strFileName, strLine, nCharsWritten);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to update segments manifest '%s': %s", m_strFileName, xnGetStatusString(nRetVal));
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus RecorderImpl::UpdateSegment(XnUInt64 nTimestamp)
+{
+	if (!m_bIsFileOpen || !IsSegmented())
+	{
+		return (XN_STATUS_OK);
+	}
+
+	if (m_nSegmentStartTimestamp == XN_MAX_UINT64)
+	{
+		m_nSegmentStartTimestamp = nTimestamp;
+		return (XN_STATUS_OK);
+	}
+
+	XnBool bFull = FALSE;
+	if (m_fileOptions.nSegmentBytes != 0 && m_nWriteBufferPos + m_nWriteBufferUsed >= m_fileOptions.nSegmentBytes)
+	{
+		bFull = TRUE;
+	}
+	if (m_fileOptions.nSegmentSeconds != 0 && nTimestamp - m_nSegmentStartTimestamp >= (XnUInt64)m_fileOptions.nSegmentSeconds * 1000000)
+	{
+		bFull = TRUE;
+	}
+
+	if (bFull)
+	{
+		return StartNextSegment(nTimestamp);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus RecorderImpl::StartNextSegment(XnUInt64 nTimestamp)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	++m_nSegment;
+	m_nSegmentStartTimestamp = nTimestamp;
+
+	// the recorder finalizes the current segment, and then opens the next one
+	nRetVal = ModuleRecorder().SetOutputStream(ModuleHandle(), this, &s_fileOutputStream);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_LOG_ERROR_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to start recording segment %u of '%s': %s", m_nSegment, m_strFileName, xnGetStatusString(nRetVal));
+	}
+
+	// each segment describes its nodes from scratch, so it can also be played on its own
+	for (NodeWatchersMap::Iterator it = m_nodeWatchersMap.Begin(); it != m_nodeWatchersMap.End(); ++it)
+	{
+		nRetVal = NotifyNodeAdded(it->Key(), it->Value().type, it->Value().compression);
+		XN_IS_STATUS_OK(nRetVal);
+		nRetVal = it->Value().pWatcher->NotifyState();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	// raw nodes are described by what was recorded of them
+	for (RawNodesMap::Iterator it = m_rawNodesMap.Begin(); it != m_rawNodesMap.End(); ++it)
+	{
+		RawNodeInfo& rawNodeInfo = it->Value();
+		nRetVal = Notifications().OnNodeAdded(ModuleHandle(), it->Key(), rawNodeInfo.type, rawNodeInfo.compression);
+		XN_IS_STATUS_OK(nRetVal);
+
+		for (RawNodePropsMap::Iterator propIt = rawNodeInfo.props.Begin(); propIt != rawNodeInfo.props.End(); ++propIt)
+		{
+			nRetVal = NotifyRawNodeProp(it->Key(), propIt->Key(), propIt->Value());
+			XN_IS_STATUS_OK(nRetVal);
+		}
+
+		if (rawNodeInfo.bStateReady)
+		{
+			nRetVal = Notifications().OnNodeStateReady(ModuleHandle(), it->Key());
+			XN_IS_STATUS_OK(nRetVal);
+		}
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus RecorderImpl::NotifyRawNodeProp(const XnChar* strNodeName, const XnChar* strPropName, const RawNodeProp& prop)
+{
+	switch (prop.type)
+	{
+	case RAW_NODE_PROP_INT:
+		return Notifications().OnNodeIntPropChanged(ModuleHandle(), strNodeName, strPropName, *(const XnUInt64*)prop.pValue);
+	case RAW_NODE_PROP_REAL:
+		return Notifications().OnNodeRealPropChanged(ModuleHandle(), strNodeName, strPropName, *(const XnDouble*)prop.pValue);
+	case RAW_NODE_PROP_STRING:
+		return Notifications().OnNodeStringPropChanged(ModuleHandle(), strNodeName, strPropName, (const XnChar*)prop.pValue);
+	case RAW_NODE_PROP_GENERAL:
+		return Notifications().OnNodeGeneralPropChanged(ModuleHandle(), strNodeName, strPropName, prop.nSize, prop.pValue);
+	default:
+		XN_ASSERT(FALSE);
+		return XN_STATUS_ERROR;
+	}
+}
+
+XnStatus RecorderImpl::SaveRawNodeProp(const XnChar* strNodeName, const XnChar* strPropName, RawNodePropType type, XnUInt32 nSize, const void* pValue)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	RawNodesMap::Iterator it = m_rawNodesMap.Find(strNodeName);
+	XN_IS_BOOL_OK_RET(it != m_rawNodesMap.End(), XN_STATUS_NO_MATCH);
+
+	RawNodeProp prop;
+	prop.type = type;
+	prop.nSize = nSize;
+	prop.pValue = (XnUChar*)xnOSMalloc(XN_MAX(nSize, 1));
+	XN_VALIDATE_ALLOC_PTR(prop.pValue);
+	xnOSMemCopy(prop.pValue, pValue, nSize);
+
+	RawNodePropsMap& props = it->Value().props;
+	RawNodePropsMap::Iterator propIt = props.Find(strPropName);
+	if (propIt != props.End())
+	{
+		xnOSFree(propIt->Value().pValue);
+		propIt->Value() = prop;
+		return (XN_STATUS_OK);
+	}
+
+	nRetVal = props.Set(strPropName, prop);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSFree(prop.pValue);
+		return (nRetVal);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+void RecorderImpl::FreeRawNodeProps(RawNodeInfo& rawNodeInfo)
+{
+	for (RawNodePropsMap::Iterator it = rawNodeInfo.props.Begin(); it != rawNodeInfo.props.End(); ++it)
+	{
+		xnOSFree(it->Value().pValue);
+	}
+	rawNodeInfo.props.Clear();
+}
+
+XnStatus RecorderImpl::OpenNetwork(void* pCookie)
+{
+	RecorderImpl* pThis = (RecorderImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	return pThis->OpenNetworkImpl();
+}
+
+XnStatus RecorderImpl::WriteNetwork(void* pCookie, const XnChar* /*strNodeName*/, const void* pData, XnUInt32 nSize)
+{
+	RecorderImpl* pThis = (RecorderImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	return pThis->WriteNetworkImpl(pData, nSize);
+}
+
+XnUInt32 XN_CALLBACK_TYPE RecorderImpl::TellNetwork(void* pCookie)
+{
+	RecorderImpl* pThis = (RecorderImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	XnUInt64 nPos = pThis->m_nBytesSent + pThis->m_nSendBufferUsed;
+	// Enforce uint32 limitation
+	if (nPos >> 32)
+		return (XnUInt32) -1;
+
+	return (XnUInt32)nPos;
+}
+
+XnUInt64 XN_CALLBACK_TYPE RecorderImpl::TellNetwork64(void* pCookie)
+{
+	RecorderImpl* pThis = (RecorderImpl*)pCookie;
+	XN_VALIDATE_INPUT_PTR(pThis);
+	return pThis->m_nBytesSent + pThis->m_nSendBufferUsed;
+}
+
+void RecorderImpl::CloseNetwork(void* pCookie)
+{
+	RecorderImpl* pThis = (RecorderImpl*)pCookie;
+	if (pThis == NULL)
+	{
+		XN_ASSERT(FALSE);
+		return;
+	}
+	pThis->CloseNetworkImpl();
+}
+
+XnStatus RecorderImpl::OpenNetworkImpl()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	
+	if (m_bIsSocketOpen)
+	{
+		//Already open
+		return XN_STATUS_OK;
+	}
+
+	XnChar strHost[XN_FILE_MAX_PATH];
+	XnUInt16 nPort = 0;
+	nRetVal = xnParseNetworkAddress(m_strFileName, strHost, sizeof(strHost), &nPort);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSInitNetwork();
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateSocket(XN_OS_TCP_SOCKET, strHost, nPort, &m_hOutSocket);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSShutdownNetwork();
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to create socket for '%s': %s", m_strFileName, xnGetStatusString(nRetVal));
+	}
+
+	// a bigger kernel buffer lets a full frame be queued without blocking the recording thread
+	xnOSSetSocketBufferSize(m_hOutSocket, XN_RECORDER_NETWORK_SOCKET_BUFFER_SIZE);
+
+	nRetVal = xnOSConnectSocket(m_hOutSocket, XN_RECORDER_NETWORK_CONNECT_TIMEOUT);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSCloseSocket(m_hOutSocket);
+		m_hOutSocket = NULL;
+		xnOSShutdownNetwork();
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to connect to '%s': %s", m_strFileName, xnGetStatusString(nRetVal));
+	}
+
+	m_pSendBuffer = XN_NEW_ARR(XnUChar, XN_RECORDER_NETWORK_SEND_BUFFER_SIZE);
+	if (m_pSendBuffer == NULL)
+	{
+		xnOSCloseSocket(m_hOutSocket);
+		m_hOutSocket = NULL;
+		xnOSShutdownNetwork();
+		return XN_STATUS_ALLOC_FAILED;
+	}
+
+	m_nSendBufferUsed = 0;
+	m_nBytesSent = 0;
+	m_bIsSocketOpen = TRUE;
+
+	return XN_STATUS_OK;
+}
+
+XnStatus RecorderImpl::WriteNetworkImpl(const void* pData, XnUInt32 nSize)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	
+	XN_IS_BOOL_OK_RET(m_bIsSocketOpen, XN_STATUS_ERROR);
+
+	if (m_nSendBufferUsed + nSize > XN_RECORDER_NETWORK_SEND_BUFFER_SIZE)
+	{
+		nRetVal = FlushNetworkImpl();
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	if (nSize >= XN_RECORDER_NETWORK_SEND_BUFFER_SIZE)
+	{
+		// large payloads are sent as is, no point in copying them
+		nRetVal = xnOSSendNetworkBuffer(m_hOutSocket, (const XnChar*)pData, nSize);
+		XN_IS_STATUS_OK(nRetVal);
+		m_nBytesSent += nSize;
+	}
+	else
+	{
+		xnOSMemCopy(m_pSendBuffer + m_nSendBufferUsed, pData, nSize);
+		m_nSendBufferUsed += nSize;
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus RecorderImpl::FlushNetworkImpl()
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	
+	if (m_nSendBufferUsed == 0)
+	{
+		return XN_STATUS_OK;
+	}
+
+	nRetVal = xnOSSendNetworkBuffer(m_hOutSocket, (const XnChar*)m_pSendBuffer, m_nSendBufferUsed);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(nRetVal, XN_MASK_OPEN_NI, "Failed to send recording data to '%s': %s", m_strFileName, xnGetStatusString(nRetVal));
+	}
+
+	m_nBytesSent += m_nSendBufferUsed;
+	m_nSendBufferUsed = 0;
+	
+	return XN_STATUS_OK;
+}
+
+void RecorderImpl::CloseNetworkImpl()
+{
+	if (m_bIsSocketOpen)
+	{
+		FlushNetworkImpl();
+		xnOSCloseSocket(m_hOutSocket);
+		m_hOutSocket = NULL;
+		xnOSShutdownNetwork();
+		XN_DELETE_ARR(m_pSendBuffer);
+		m_pSendBuffer = NULL;
+		m_nSendBufferUsed = 0;
+		m_bIsSocketOpen = FALSE;
+	}
+}
+
 XnCodecID RecorderImpl::GetDefaultCodecID(ProductionNode& node)
 {
 	XN_ASSERT(node.IsValid());
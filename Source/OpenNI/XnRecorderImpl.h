@@ -54,8 +54,11 @@ namespace xn
 		XnStatus SetRawNodeNewData(const XnChar* strNodeName, XnUInt64 nTimeStamp, XnUInt32 nFrame, const void* pData, XnUInt32 nSize);
 
 		XnStatus SetDestination(XnRecordMedium destType, const XnChar* strDest);
+		XnStatus SetFileOptions(const XnRecorderFileOptions& options);
 		XnStatus GetDestination(XnRecordMedium& destType, XnChar* strDest, XnUInt32 nBufSize);
 		XnStatus Record();
+		/** Number of recorded bytes that are buffered, and not yet written to the file or sent. */
+		XnUInt32 GetQueuedBytes() const { return m_nWriteBufferUsed + m_nSendBufferUsed; }
 
 	protected:
 		XnStatus NotifyNodeAdded(XnNodeHandle hNode, XnProductionNodeType type, XnCodecID compression);
@@ -67,10 +70,39 @@ namespace xn
 		XnStatus RemoveNodeImpl(ProductionNode &node);
 
 	private:
-		typedef XnHashT<XnNodeHandle, NodeWatcher*> NodeWatchersMap;
+		struct WatchedNode
+		{
+			NodeWatcher* pWatcher;
+			XnProductionNodeType type;
+			XnCodecID compression;
+		};
+
+		typedef XnHashT<XnNodeHandle, WatchedNode> NodeWatchersMap;
+
+		enum RawNodePropType
+		{
+			RAW_NODE_PROP_INT,
+			RAW_NODE_PROP_REAL,
+			RAW_NODE_PROP_STRING,
+			RAW_NODE_PROP_GENERAL,
+		};
+
+		// last value of a raw node property, kept so it can be written again to the next segment
+		struct RawNodeProp
+		{
+			RawNodePropType type;
+			XnUInt32 nSize;
+			XnUChar* pValue;
+		};
+
+		typedef XnStringsHashT<RawNodeProp> RawNodePropsMap;
 
 		struct RawNodeInfo
 		{
+			XnProductionNodeType type;
+			XnCodecID compression;
+			XnBool bStateReady;
+			RawNodePropsMap props;
 		};
 
 		typedef XnStringsHashT<RawNodeInfo> RawNodesMap;
@@ -92,17 +124,62 @@ namespace xn
 		XnUInt64 TellFile64Impl();
 		void CloseFileImpl();
 
+		XnStatus FlushWriteBuffer();
+		XnStatus PatchFile(const void* pData, XnUInt32 nSize);
+		XnStatus WriteFileAt(XN_FILE_HANDLE hFile, XnUInt64 nPos, const void* pData, XnUInt32 nSize);
+		void PreallocateFile(XnUInt64 nEnd);
+		XnBool IsSegmented();
+		XnStatus GetSegmentFileName(XnUInt32 nSegment, XnChar* strFileName, XnUInt32 nBufSize);
+		XnStatus AddSegmentToManifest();
+		XnStatus UpdateSegment(XnUInt64 nTimestamp);
+		XnStatus StartNextSegment(XnUInt64 nTimestamp);
+		XnStatus NotifyRawNodeProp(const XnChar* strNodeName, const XnChar* strPropName, const RawNodeProp& prop);
+		XnStatus SaveRawNodeProp(const XnChar* strNodeName, const XnChar* strPropName, RawNodePropType type, XnUInt32 nSize, const void* pValue);
+		static void FreeRawNodeProps(RawNodeInfo& rawNodeInfo);
+
+		static XnStatus XN_CALLBACK_TYPE OpenNetwork(void* pCookie);
+		static XnStatus XN_CALLBACK_TYPE WriteNetwork(void* pCookie, const XnChar* strNodeName, 
+			const void* pData, XnUInt32 nSize);
+		static XnUInt32 XN_CALLBACK_TYPE TellNetwork(void* pCookie);
+		static XnUInt64 XN_CALLBACK_TYPE TellNetwork64(void* pCookie);
+		static void XN_CALLBACK_TYPE CloseNetwork(void* pCookie);
+
+		XnStatus OpenNetworkImpl();
+		XnStatus WriteNetworkImpl(const void* pData, XnUInt32 nSize);
+		XnStatus FlushNetworkImpl();
+		void CloseNetworkImpl();
+
 		XnCodecID GetDefaultCodecID(ProductionNode& node);
 		
 		XnBool IsRawNode(const XnChar* strNodeName);
 
 		//XnRecorderOutputStreamInterface implementation that writes to an stdio file
 		static XnRecorderOutputStreamInterface s_fileOutputStream;
+		//XnRecorderOutputStreamInterface implementation that streams to a TCP connection. It can't seek.
+		static XnRecorderOutputStreamInterface s_networkOutputStream;
 
 		XnRecordMedium m_destType;
-		XnChar m_strFileName[XN_FILE_MAX_PATH];
+		XnChar m_strFileName[XN_FILE_MAX_PATH]; // file name, or "host:port" for network destinations
 		XnBool m_bIsFileOpen;
 		XN_FILE_HANDLE m_hOutFile;
+		XnRecorderFileOptions m_fileOptions;
+		XnChar m_strSegmentFileName[XN_FILE_MAX_PATH]; // the file actually being written
+		XnUChar* m_pPatchBlock; // direct I/O only: scratch block for updates of flushed data
+		XnBool m_bDirectIO;
+		XnBool m_bPreallocate;
+		XnUChar* m_pWriteBuffer;
+		XnUInt32 m_nWriteBufferSize;
+		XnUInt32 m_nWriteBufferUsed;
+		XnUInt64 m_nWriteBufferPos; // file position of the first byte in the write buffer
+		XnUInt64 m_nWritePos;
+		XnUInt64 m_nPreallocatedSize;
+		XnUInt32 m_nSegment;
+		XnUInt64 m_nSegmentStartTimestamp;
+		XnBool m_bIsSocketOpen;
+		XN_SOCKET_HANDLE m_hOutSocket;
+		XnUChar* m_pSendBuffer;
+		XnUInt32 m_nSendBufferUsed;
+		XnUInt64 m_nBytesSent;
 		XnNodeHandle m_hRecorder;
 		NodeWatchersMap m_nodeWatchersMap;
 		RawNodesMap m_rawNodesMap;
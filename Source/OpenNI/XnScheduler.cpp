@@ -221,6 +221,8 @@ XN_C_API XnStatus xnSchedulerStart(XnScheduler** ppScheduler)
 	nRetVal = xnOSCreateThread(xnSchedulerThreadFunc, (XN_THREAD_PARAM)pScheduler, &pScheduler->hThread);
 	XN_CHECK_RC_AND_FREE(nRetVal, pScheduler);
 
+	xnOSApplyThreadPolicy(pScheduler->hThread, XN_THREAD_ROLE_SCHEDULER, "XnScheduler");
+
 	*ppScheduler = pScheduler;
 
 	return (XN_STATUS_OK);
@@ -0,0 +1,527 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOS.h>
+#include <XnOSCpp.h>
+#include <XnLog.h>
+#include "XnXml.h"
+#include "xnInternalFuncs.h"
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef struct XnThreadPolicyEntry
+{
+	XnChar strRole[XN_THREAD_ROLE_MAX_LENGTH];
+	XnThreadPolicy policy;
+} XnThreadPolicyEntry;
+
+typedef struct XnThreadPolicyTable
+{
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	XnThreadPolicyEntry aEntries[XN_THREAD_POLICY_MAX_ROLES];
+	XnUInt32 nCount;
+} XnThreadPolicyTable;
+
+//---------------------------------------------------------------------------
+// Global Variables
+//---------------------------------------------------------------------------
+static XnThreadPolicyTable g_ThreadPolicies = {0};
+static XN_ONCE g_ThreadPoliciesInitOnce = XN_ONCE_INIT;
+
+/** Roles looked up when reading policies from an INI file (XML files name their roles explicitly). */
+static const XnChar* g_astrThreadRoles[] = 
+{
+	XN_THREAD_ROLE_USB_READ,
+	XN_THREAD_ROLE_USB_EVENTS,
+	XN_THREAD_ROLE_USB_DEVICE,
+	XN_THREAD_ROLE_PLAYBACK,
+	XN_THREAD_ROLE_PLAYER_READ_AHEAD,
+	XN_THREAD_ROLE_SCHEDULER,
+	XN_THREAD_ROLE_PROFILING,
+	XN_THREAD_ROLE_MEM_PROFILER,
+	XN_THREAD_ROLE_REGISTRATION,
+	XN_THREAD_ROLE_METRICS,
+};
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XnStatus XN_CALLBACK_TYPE xnOSThreadPoliciesInit(void* /*pCookie*/)
+{
+	return xnOSCreateCriticalSection(&g_ThreadPolicies.hLock);
+}
+
+static XnStatus xnOSThreadPoliciesInitLock()
+{
+	// threads of different modules may be the first to look up their policy
+	return xnOSRunOnce(&g_ThreadPoliciesInitOnce, xnOSThreadPoliciesInit, NULL);
+}
+
+static XnThreadPolicyEntry* xnOSFindThreadPolicy(const XnChar* strRole)
+{
+	for (XnUInt32 i = 0; i < g_ThreadPolicies.nCount; ++i)
+	{
+		if (xnOSStrCaseCmp(g_ThreadPolicies.aEntries[i].strRole, strRole) == 0)
+		{
+			return &g_ThreadPolicies.aEntries[i];
+		}
+	}
+
+	return NULL;
+}
+
+XN_C_API XnStatus xnOSSetThreadPolicy(const XnChar* strRole, const XnThreadPolicy* pPolicy)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strRole);
+	XN_VALIDATE_INPUT_PTR(pPolicy);
+
+	if (xnOSStrLen(strRole) >= XN_THREAD_ROLE_MAX_LENGTH)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	nRetVal = xnOSThreadPoliciesInitLock();
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAutoCSLocker locker(g_ThreadPolicies.hLock);
+
+	XnThreadPolicyEntry* pEntry = xnOSFindThreadPolicy(strRole);
+	if (pEntry == NULL)
+	{
+		if (g_ThreadPolicies.nCount == XN_THREAD_POLICY_MAX_ROLES)
+		{
+			return (XN_STATUS_OS_THREAD_POLICY_TABLE_FULL);
+		}
+
+		pEntry = &g_ThreadPolicies.aEntries[g_ThreadPolicies.nCount++];
+		nRetVal = xnOSStrCopy(pEntry->strRole, strRole, sizeof(pEntry->strRole));
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	pEntry->policy = *pPolicy;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSGetThreadPolicy(const XnChar* strRole, XnThreadPolicy* pPolicy)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strRole);
+	XN_VALIDATE_OUTPUT_PTR(pPolicy);
+
+	nRetVal = xnOSThreadPoliciesInitLock();
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAutoCSLocker locker(g_ThreadPolicies.hLock);
+
+	XnThreadPolicyEntry* pEntry = xnOSFindThreadPolicy(strRole);
+	if (pEntry == NULL)
+	{
+		return (XN_STATUS_NO_MATCH);
+	}
+
+	*pPolicy = pEntry->policy;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSClearThreadPolicies()
+{
+	XnStatus nRetVal = xnOSThreadPoliciesInitLock();
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAutoCSLocker locker(g_ThreadPolicies.hLock);
+	g_ThreadPolicies.nCount = 0;
+
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOSParseCPUNumber(const XnChar*& strPos, XnUInt32* pnCPU)
+{
+	if (*strPos < '0' || *strPos > '9')
+	{
+		return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+	}
+
+	XnUInt32 nCPU = 0;
+	while (*strPos >= '0' && *strPos <= '9')
+	{
+		nCPU = nCPU * 10 + (*strPos - '0');
+		if (nCPU >= 64)
+		{
+			return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+		}
+		++strPos;
+	}
+
+	*pnCPU = nCPU;
+	return (XN_STATUS_OK);
+}
+
+/** Parses either a hex mask ("0x0c") or a CPU list ("2,3" or "2-3"). */
+static XnStatus xnOSParseAffinity(const XnChar* strAffinity, XnUInt64* pnMask)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+	XnUInt64 nMask = 0;
+	const XnChar* strPos = strAffinity;
+
+	if (strPos[0] == '0' && (strPos[1] == 'x' || strPos[1] == 'X'))
+	{
+		strPos += 2;
+		if (*strPos == '\0')
+		{
+			return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+		}
+
+		XnUInt32 nDigits = 0;
+		for (; *strPos != '\0'; ++strPos, ++nDigits)
+		{
+			XnUInt32 nDigit;
+			if (*strPos >= '0' && *strPos <= '9')
+			{
+				nDigit = *strPos - '0';
+			}
+			else if (*strPos >= 'a' && *strPos <= 'f')
+			{
+				nDigit = *strPos - 'a' + 10;
+			}
+			else if (*strPos >= 'A' && *strPos <= 'F')
+			{
+				nDigit = *strPos - 'A' + 10;
+			}
+			else
+			{
+				return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+			}
+
+			if (nDigits == 16)
+			{
+				return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+			}
+
+			nMask = (nMask << 4) | nDigit;
+		}
+
+		*pnMask = nMask;
+		return (XN_STATUS_OK);
+	}
+
+	for (;;)
+	{
+		while (*strPos == ' ')
+		{
+			++strPos;
+		}
+
+		XnUInt32 nFirst;
+		nRetVal = xnOSParseCPUNumber(strPos, &nFirst);
+		XN_IS_STATUS_OK(nRetVal);
+
+		XnUInt32 nLast = nFirst;
+		if (*strPos == '-')
+		{
+			++strPos;
+			nRetVal = xnOSParseCPUNumber(strPos, &nLast);
+			XN_IS_STATUS_OK(nRetVal);
+
+			if (nLast < nFirst)
+			{
+				return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+			}
+		}
+
+		for (XnUInt32 nCPU = nFirst; nCPU <= nLast; ++nCPU)
+		{
+			nMask |= (1ULL << nCPU);
+		}
+
+		while (*strPos == ' ')
+		{
+			++strPos;
+		}
+
+		if (*strPos == '\0')
+		{
+			break;
+		}
+		else if (*strPos != ',')
+		{
+			return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+		}
+
+		++strPos;
+	}
+
+	*pnMask = nMask;
+	return (XN_STATUS_OK);
+}
+
+static XnStatus xnOSParsePriority(const XnChar* strPriority, XnThreadPriority* pnPriority)
+{
+	if (xnOSStrCaseCmp(strPriority, "Low") == 0)
+	{
+		*pnPriority = XN_PRIORITY_LOW;
+	}
+	else if (xnOSStrCaseCmp(strPriority, "Normal") == 0)
+	{
+		*pnPriority = XN_PRIORITY_NORMAL;
+	}
+	else if (xnOSStrCaseCmp(strPriority, "High") == 0)
+	{
+		*pnPriority = XN_PRIORITY_HIGH;
+	}
+	else if (xnOSStrCaseCmp(strPriority, "Critical") == 0)
+	{
+		*pnPriority = XN_PRIORITY_CRITICAL;
+	}
+	else
+	{
+		return (XN_STATUS_OS_THREAD_POLICY_INVALID);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSParseThreadPolicy(const XnChar* strAffinity, const XnChar* strPriority, XnThreadPolicy* pPolicy)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_OUTPUT_PTR(pPolicy);
+
+	XnThreadPolicy policy = {0};
+
+	if (strAffinity != NULL && strAffinity[0] != '\0')
+	{
+		nRetVal = xnOSParseAffinity(strAffinity, &policy.nAffinityMask);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_OS, "Invalid thread affinity '%s'", strAffinity);
+			return (nRetVal);
+		}
+	}
+
+	if (strPriority != NULL && strPriority[0] != '\0')
+	{
+		nRetVal = xnOSParsePriority(strPriority, &policy.nPriority);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_OS, "Invalid thread priority '%s'", strPriority);
+			return (nRetVal);
+		}
+
+		policy.bOverridePriority = TRUE;
+	}
+
+	*pPolicy = policy;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnOSApplyThreadPolicy(XN_THREAD_HANDLE ThreadHandle, const XnChar* strRole, const XnChar* strName)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strRole);
+
+	if (strName == NULL)
+	{
+		strName = strRole;
+	}
+
+	// naming is cosmetic (it only helps debuggers and profilers), so a failure is not reported back
+	nRetVal = xnOSSetThreadName(ThreadHandle, strName);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnLogVerbose(XN_MASK_OS, "Could not name thread '%s': %s", strName, xnGetStatusString(nRetVal));
+	}
+
+	XnThreadPolicy policy;
+	nRetVal = xnOSGetThreadPolicy(strRole, &policy);
+	if (nRetVal == XN_STATUS_NO_MATCH)
+	{
+		return (XN_STATUS_OK);
+	}
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnStatus nResult = XN_STATUS_OK;
+
+	if (policy.nAffinityMask != 0)
+	{
+		nRetVal = xnOSSetThreadAffinity(ThreadHandle, policy.nAffinityMask);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_OS, "Failed to set affinity of %s thread '%s': %s", strRole, strName, xnGetStatusString(nRetVal));
+			nResult = nRetVal;
+		}
+	}
+
+	if (policy.bOverridePriority)
+	{
+		nRetVal = xnOSSetThreadPriority(ThreadHandle, policy.nPriority);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_OS, "Failed to set priority of %s thread '%s': %s", strRole, strName, xnGetStatusString(nRetVal));
+			nResult = nRetVal;
+		}
+	}
+
+	xnLogVerbose(XN_MASK_OS, "Applied %s policy to thread '%s'", strRole, strName);
+
+	return (nResult);
+}
+
+XN_C_API XnStatus xnOSLoadThreadPoliciesFromINI(const XnChar* strINIFile, const XnChar* strSection)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strINIFile);
+	XN_VALIDATE_INPUT_PTR(strSection);
+
+	XnBool bExists = FALSE;
+	nRetVal = xnOSDoesFileExist(strINIFile, &bExists);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (!bExists)
+	{
+		return (XN_STATUS_OS_INI_FILE_NOT_FOUND);
+	}
+
+	for (XnUInt32 i = 0; i < sizeof(g_astrThreadRoles) / sizeof(g_astrThreadRoles[0]); ++i)
+	{
+		// keys are named <Role>.Affinity and <Role>.Priority. A missing key leaves that setting untouched.
+		XnChar strKey[XN_THREAD_ROLE_MAX_LENGTH + 16];
+		XnChar strAffinity[XN_INI_MAX_LEN] = "";
+		XnChar strPriority[XN_INI_MAX_LEN] = "";
+		XnUInt32 nCharsWritten = 0;
+
+		nRetVal = xnOSStrFormat(strKey, sizeof(strKey), &nCharsWritten, "%s.Affinity", g_astrThreadRoles[i]);
+		XN_IS_STATUS_OK(nRetVal);
+		if (xnOSReadStringFromINI(strINIFile, strSection, strKey, strAffinity, sizeof(strAffinity)) != XN_STATUS_OK)
+		{
+			strAffinity[0] = '\0';
+		}
+
+		nRetVal = xnOSStrFormat(strKey, sizeof(strKey), &nCharsWritten, "%s.Priority", g_astrThreadRoles[i]);
+		XN_IS_STATUS_OK(nRetVal);
+		if (xnOSReadStringFromINI(strINIFile, strSection, strKey, strPriority, sizeof(strPriority)) != XN_STATUS_OK)
+		{
+			strPriority[0] = '\0';
+		}
+
+		if (strAffinity[0] == '\0' && strPriority[0] == '\0')
+		{
+			continue;
+		}
+
+		XnThreadPolicy parsed;
+		nRetVal = xnOSParseThreadPolicy(strAffinity, strPriority, &parsed);
+		XN_IS_STATUS_OK(nRetVal);
+
+		// start from the role's current policy, so a missing key keeps its setting
+		XnThreadPolicy policy = {0};
+		nRetVal = xnOSGetThreadPolicy(g_astrThreadRoles[i], &policy);
+		if (nRetVal != XN_STATUS_OK && nRetVal != XN_STATUS_NO_MATCH)
+		{
+			return (nRetVal);
+		}
+
+		if (strAffinity[0] != '\0')
+		{
+			policy.nAffinityMask = parsed.nAffinityMask;
+		}
+
+		if (strPriority[0] != '\0')
+		{
+			policy.nPriority = parsed.nPriority;
+			policy.bOverridePriority = parsed.bOverridePriority;
+		}
+
+		nRetVal = xnOSSetThreadPolicy(g_astrThreadRoles[i], &policy);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XnStatus xnOSLoadThreadPoliciesFromXml(const TiXmlElement* pRootElem)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	if (pRootElem == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	const TiXmlElement* pThreads = pRootElem->FirstChildElement("Threads");
+	if (pThreads == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	// a bad entry only loses its own policy - the others (and the rest of the configuration) still apply
+	XnStatus nResult = XN_STATUS_OK;
+
+	for (const TiXmlElement* pThread = pThreads->FirstChildElement("Thread"); pThread != NULL; pThread = pThread->NextSiblingElement("Thread"))
+	{
+		const XnChar* strRole;
+		nRetVal = xnXmlReadStringAttribute(pThread, "role", &strRole);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_OS, "Ignoring thread policy without a role (row %d)", pThread->Row());
+			nResult = nRetVal;
+			continue;
+		}
+
+		XnThreadPolicy policy;
+		nRetVal = xnOSParseThreadPolicy(pThread->Attribute("affinity"), pThread->Attribute("priority"), &policy);
+		if (nRetVal == XN_STATUS_OK)
+		{
+			nRetVal = xnOSSetThreadPolicy(strRole, &policy);
+		}
+
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnLogWarning(XN_MASK_OS, "Ignoring thread policy of role '%s': %s", strRole, xnGetStatusString(nRetVal));
+			nResult = nRetVal;
+		}
+	}
+
+	return (nResult);
+}
+
+XN_C_API XnStatus xnOSLoadThreadPoliciesFromXmlFile(const XnChar* strFileName)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strFileName);
+
+	TiXmlDocument doc;
+	nRetVal = xnXmlLoadDocument(doc, strFileName);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return xnOSLoadThreadPoliciesFromXml(doc.RootElement());
+}
@@ -0,0 +1,624 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnTrace.h>
+#include <XnOSCpp.h>
+#include <XnLog.h>
+
+//---------------------------------------------------------------------------
+// Definitions
+//---------------------------------------------------------------------------
+#define XN_MASK_TRACE				"Trace"
+#define XN_TRACE_EXPORT_CHUNK_SIZE	(64 * 1024)
+#define XN_TRACE_MAX_EVENT_JSON		512
+/** Objects whose new data reports are numbered for flows. Objects beyond it get no flows. **/
+#define XN_TRACE_MAX_FLOW_OBJECTS	64
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef struct XnTraceBuffer
+{
+	XnTraceEvent* aEvents;
+	/** A power of two while the session is active. Once it is stopped, the events are kept in order, and this is their count. **/
+	XnUInt32 nCapacity;
+	/** Total number of events ever written. Only the owner thread writes it. **/
+	volatile XnUInt64 nWritten;
+	/** Like nWritten, but incremented before the event is written (lets an exporter detect overwritten events). **/
+	volatile XnUInt64 nWriting;
+	XN_THREAD_ID nThreadID;
+	XnTraceBuffer* pNext;
+} XnTraceBuffer;
+
+/** Numbers the new data reports of an object, and remembers the last one an update consumed. **/
+typedef struct XnTraceFlowObject
+{
+	XnChar strObject[XN_TRACE_OBJECT_NAME_LENGTH];
+	XnUInt32 nReported;
+	XnUInt32 nConsumed;
+} XnTraceFlowObject;
+
+typedef struct
+{
+	volatile XnBool bActive;
+	volatile XnUInt32 nSession;
+	XnUInt32 nEventsPerThread;
+	/** Number of threads in the middle of writing an event. Buffers are freed only when there are none. **/
+	volatile XnInt32 nWriters;
+	/** Serializes starting, stopping and exporting. **/
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	/** Protects the buffers list (threads add their buffer on their first event of a session). **/
+	XN_CRITICAL_SECTION_HANDLE hBuffersLock;
+	/** Buffers of the current session, or of the last one once it is stopped. **/
+	XnTraceBuffer* pBuffers;
+	/** Protects the flow objects (new data is usually reported and consumed by different threads). **/
+	XN_CRITICAL_SECTION_HANDLE hFlowsLock;
+	XnTraceFlowObject aFlowObjects[XN_TRACE_MAX_FLOW_OBJECTS];
+	XnUInt32 nFlowObjects;
+} XnTraceData;
+
+/** Buffers JSON output, so that the file is written in large chunks. **/
+typedef struct
+{
+	XN_FILE_HANDLE hFile;
+	XnChar* pChunk;
+	XnUInt32 nUsed;
+	XnStatus nStatus;
+} XnTraceExportFile;
+
+//---------------------------------------------------------------------------
+// Global Variables
+//---------------------------------------------------------------------------
+static XnTraceData g_TraceData = {0};
+static XN_ONCE g_TraceInitOnce = XN_ONCE_INIT;
+static XN_THREAD_STATIC XnTraceBuffer* gt_pTraceBuffer = NULL;
+/** The session gt_pTraceBuffer belongs to. The buffer is freed once that session is over. **/
+static XN_THREAD_STATIC XnUInt32 gt_nTraceSession = 0;
+
+static const XnChar* g_astrTraceEventNames[XN_TRACE_EVENT_TYPE_COUNT] =
+{
+	"USBTransfer",
+	"NewDataAvailable",
+	"Wait",
+	"UpdateData",
+	"Encode",
+	"Decode",
+	"Record",
+	"Playback",
+};
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XnUInt32 xnTraceRoundUpToPowerOfTwo(XnUInt32 nValue)
+{
+	XnUInt32 nResult = 1;
+	while (nResult < nValue && nResult < 0x80000000)
+	{
+		nResult <<= 1;
+	}
+	return nResult;
+}
+
+static XnStatus XN_CALLBACK_TYPE xnTraceInit(void* /*pCookie*/)
+{
+	XnStatus nRetVal = xnOSCreateCriticalSection(&g_TraceData.hLock);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = xnOSCreateCriticalSection(&g_TraceData.hBuffersLock);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSCloseCriticalSection(&g_TraceData.hLock);
+		return (nRetVal);
+	}
+
+	nRetVal = xnOSCreateCriticalSection(&g_TraceData.hFlowsLock);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		xnOSCloseCriticalSection(&g_TraceData.hBuffersLock);
+		xnOSCloseCriticalSection(&g_TraceData.hLock);
+		return (nRetVal);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static XnTraceBuffer* xnTraceGetThreadBuffer()
+{
+	XnTraceBuffer* pBuffer = gt_pTraceBuffer;
+	if (pBuffer != NULL && gt_nTraceSession == g_TraceData.nSession)
+	{
+		return pBuffer;
+	}
+
+	// first event of this thread in this session (rare)
+	XnAutoCSLocker locker(g_TraceData.hBuffersLock);
+
+	// a session ends by clearing bActive and only then moving on to the next session number. Reading them in the 
+	// opposite order makes sure the buffer is tagged with the session that will free it.
+	XnUInt32 nSession = g_TraceData.nSession;
+	xnOSMemoryBarrier();
+	if (!g_TraceData.bActive)
+	{
+		return NULL;
+	}
+
+	pBuffer = XN_NEW(XnTraceBuffer);
+	if (pBuffer == NULL)
+	{
+		return NULL;
+	}
+
+	pBuffer->aEvents = XN_NEW_ARR(XnTraceEvent, g_TraceData.nEventsPerThread);
+	if (pBuffer->aEvents == NULL)
+	{
+		XN_DELETE(pBuffer);
+		return NULL;
+	}
+
+	pBuffer->nCapacity = g_TraceData.nEventsPerThread;
+	pBuffer->nWritten = 0;
+	pBuffer->nWriting = 0;
+	xnOSGetCurrentThreadID(&pBuffer->nThreadID);
+	pBuffer->pNext = g_TraceData.pBuffers;
+	g_TraceData.pBuffers = pBuffer;
+
+	gt_pTraceBuffer = pBuffer;
+	gt_nTraceSession = nSession;
+
+	return pBuffer;
+}
+
+/** Ends the current session, and waits until no thread writes to its buffers. Called with hLock held. **/
+static void xnTraceEndSession()
+{
+	g_TraceData.bActive = FALSE;
+	xnOSMemoryBarrier();
+	// threads holding a buffer of this session get a new one next time
+	++g_TraceData.nSession;
+	xnOSMemoryBarrier();
+
+	// writing an event is short, and takes no lock
+	while (g_TraceData.nWriters != 0)
+	{
+		xnOSSleep(0);
+	}
+	xnOSMemoryBarrier();
+}
+
+static void xnTraceFreeBuffers()
+{
+	XnAutoCSLocker locker(g_TraceData.hBuffersLock);
+
+	XnTraceBuffer* pBuffer = g_TraceData.pBuffers;
+	while (pBuffer != NULL)
+	{
+		XnTraceBuffer* pNext = pBuffer->pNext;
+		XN_DELETE_ARR(pBuffer->aEvents);
+		XN_DELETE(pBuffer);
+		pBuffer = pNext;
+	}
+
+	g_TraceData.pBuffers = NULL;
+}
+
+/** Replaces a thread's ring buffer by just the events it kept, oldest first. **/
+static void xnTraceCompactBuffer(XnTraceBuffer* pBuffer)
+{
+	XnUInt64 nFirst = (pBuffer->nWritten > pBuffer->nCapacity) ? pBuffer->nWritten - pBuffer->nCapacity : 0;
+	XnUInt32 nCount = (XnUInt32)(pBuffer->nWritten - nFirst);
+
+	XnTraceEvent* aEvents = NULL;
+	if (nCount != 0)
+	{
+		aEvents = XN_NEW_ARR(XnTraceEvent, nCount);
+		if (aEvents == NULL)
+		{
+			// keep the ring buffer, then
+			return;
+		}
+
+		for (XnUInt64 i = nFirst; i < pBuffer->nWritten; ++i)
+		{
+			aEvents[i - nFirst] = pBuffer->aEvents[i & (pBuffer->nCapacity - 1)];
+		}
+	}
+
+	XN_DELETE_ARR(pBuffer->aEvents);
+	pBuffer->aEvents = aEvents;
+	pBuffer->nCapacity = nCount;
+	pBuffer->nWritten = nCount;
+	pBuffer->nWriting = nCount;
+}
+
+XN_C_API XnStatus xnTraceStart(XnUInt32 nEventsPerThread)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = xnOSRunOnce(&g_TraceInitOnce, xnTraceInit, NULL);
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (nEventsPerThread == 0)
+	{
+		nEventsPerThread = XN_TRACE_DEFAULT_EVENTS_PER_THREAD;
+	}
+
+	XnAutoCSLocker locker(g_TraceData.hLock);
+
+	// discard the previous session
+	xnTraceEndSession();
+	xnTraceFreeBuffers();
+
+	{
+		XnAutoCSLocker flowsLocker(g_TraceData.hFlowsLock);
+		g_TraceData.nFlowObjects = 0;
+	}
+
+	g_TraceData.nEventsPerThread = xnTraceRoundUpToPowerOfTwo(nEventsPerThread);
+	xnOSMemoryBarrier();
+	g_TraceData.bActive = TRUE;
+
+	xnLogInfo(XN_MASK_TRACE, "Tracing started (%u events per thread)", g_TraceData.nEventsPerThread);
+	
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnTraceStop()
+{
+	XnStatus nRetVal = xnOSRunOnce(&g_TraceInitOnce, xnTraceInit, NULL);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnAutoCSLocker locker(g_TraceData.hLock);
+
+	if (!g_TraceData.bActive)
+	{
+		return (XN_STATUS_OK);
+	}
+
+	xnTraceEndSession();
+
+	// the ring buffers are no longer needed, only the events in them
+	XnAutoCSLocker buffersLocker(g_TraceData.hBuffersLock);
+	for (XnTraceBuffer* pBuffer = g_TraceData.pBuffers; pBuffer != NULL; pBuffer = pBuffer->pNext)
+	{
+		xnTraceCompactBuffer(pBuffer);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnBool xnTraceIsActive()
+{
+	return g_TraceData.bActive;
+}
+
+/** Copies an object name into an event (or a flow object), cutting it if it is too long. **/
+static void xnTraceCopyObjectName(XnChar* strDest, const XnChar* strObject)
+{
+	XnUInt32 nChar = 0;
+	if (strObject != NULL)
+	{
+		for (; nChar < XN_TRACE_OBJECT_NAME_LENGTH - 1 && strObject[nChar] != '\0'; ++nChar)
+		{
+			strDest[nChar] = strObject[nChar];
+		}
+	}
+	strDest[nChar] = '\0';
+}
+
+/** Finds the flow object of an object, or adds one. Returns NULL if there is no room. Called with hFlowsLock held. **/
+static XnTraceFlowObject* xnTraceFindFlowObject(const XnChar* strObject)
+{
+	// objects are told apart by the name their events carry
+	XnChar strName[XN_TRACE_OBJECT_NAME_LENGTH];
+	xnTraceCopyObjectName(strName, strObject);
+
+	for (XnUInt32 i = 0; i < g_TraceData.nFlowObjects; ++i)
+	{
+		if (strcmp(g_TraceData.aFlowObjects[i].strObject, strName) == 0)
+		{
+			return &g_TraceData.aFlowObjects[i];
+		}
+	}
+
+	if (g_TraceData.nFlowObjects == XN_TRACE_MAX_FLOW_OBJECTS)
+	{
+		return NULL;
+	}
+
+	XnTraceFlowObject* pObject = &g_TraceData.aFlowObjects[g_TraceData.nFlowObjects++];
+	xnOSMemCopy(pObject->strObject, strName, sizeof(strName));
+	pObject->nReported = 0;
+	pObject->nConsumed = 0;
+	return pObject;
+}
+
+XN_C_API XnUInt32 xnTraceReportNewData(const XnChar* strObject)
+{
+	if (!g_TraceData.bActive || strObject == NULL)
+	{
+		return 0;
+	}
+
+	XnAutoCSLocker locker(g_TraceData.hFlowsLock);
+	XnTraceFlowObject* pObject = xnTraceFindFlowObject(strObject);
+	if (pObject == NULL)
+	{
+		return 0;
+	}
+
+	return ++pObject->nReported;
+}
+
+XN_C_API XnUInt32 xnTraceConsumeNewData(const XnChar* strObject)
+{
+	if (!g_TraceData.bActive || strObject == NULL)
+	{
+		return 0;
+	}
+
+	XnAutoCSLocker locker(g_TraceData.hFlowsLock);
+	XnTraceFlowObject* pObject = xnTraceFindFlowObject(strObject);
+	if (pObject == NULL || pObject->nConsumed == pObject->nReported)
+	{
+		return 0;
+	}
+
+	pObject->nConsumed = pObject->nReported;
+	return pObject->nConsumed;
+}
+
+static void xnTraceWriteEvent(XnTraceBuffer* pBuffer, XnTraceEventType type, XnTracePhase phase, const XnChar* strObject, XnUInt64 nDataTimestamp, XnUInt32 nFrameID, XnUInt32 nSize)
+{
+	XnUInt64 nIndex = pBuffer->nWritten;
+	pBuffer->nWriting = nIndex + 1;
+	xnOSMemoryBarrier();
+
+	XnTraceEvent* pEvent = &pBuffer->aEvents[nIndex & (pBuffer->nCapacity - 1)];
+
+	xnOSGetHighResTimeStamp(&pEvent->nTime);
+	pEvent->nDataTimestamp = nDataTimestamp;
+	pEvent->nFrameID = nFrameID;
+	pEvent->nSize = nSize;
+	pEvent->nType = (XnUInt16)type;
+	pEvent->nPhase = (XnUInt16)phase;
+	xnTraceCopyObjectName(pEvent->strObject, strObject);
+
+	// publish the event only once it is complete (an exporter may be reading concurrently)
+	xnOSMemoryBarrier();
+	pBuffer->nWritten = nIndex + 1;
+}
+
+XN_C_API void xnTraceWrite(XnTraceEventType type, XnTracePhase phase, const XnChar* strObject, XnUInt64 nDataTimestamp, XnUInt32 nFrameID, XnUInt32 nSize)
+{
+	if (!g_TraceData.bActive)
+	{
+		return;
+	}
+
+	xnOSAtomicAdd32(&g_TraceData.nWriters, 1);
+
+	// the session may have ended meanwhile, and its buffers be about to be freed
+	if (g_TraceData.bActive)
+	{
+		XnTraceBuffer* pBuffer = xnTraceGetThreadBuffer();
+		if (pBuffer != NULL)
+		{
+			xnTraceWriteEvent(pBuffer, type, phase, strObject, nDataTimestamp, nFrameID, nSize);
+		}
+	}
+
+	xnOSAtomicAdd32(&g_TraceData.nWriters, -1);
+}
+
+XN_C_API const XnChar* xnTraceEventTypeToString(XnTraceEventType type)
+{
+	if (type < 0 || type >= XN_TRACE_EVENT_TYPE_COUNT)
+	{
+		return "Unknown";
+	}
+
+	return g_astrTraceEventNames[type];
+}
+
+static void xnTraceExportFlush(XnTraceExportFile* pFile)
+{
+	if (pFile->nStatus == XN_STATUS_OK && pFile->nUsed != 0)
+	{
+		pFile->nStatus = xnOSWriteFile(pFile->hFile, pFile->pChunk, pFile->nUsed);
+	}
+	pFile->nUsed = 0;
+}
+
+static void xnTraceExportWrite(XnTraceExportFile* pFile, const XnChar* strFormat, ...)
+{
+	if (pFile->nUsed + XN_TRACE_MAX_EVENT_JSON > XN_TRACE_EXPORT_CHUNK_SIZE)
+	{
+		xnTraceExportFlush(pFile);
+	}
+
+	XnUInt32 nCharsWritten = 0;
+	va_list args;
+	va_start(args, strFormat);
+	xnOSStrFormatV(pFile->pChunk + pFile->nUsed, XN_TRACE_EXPORT_CHUNK_SIZE - pFile->nUsed, &nCharsWritten, strFormat, args);
+	va_end(args);
+
+	pFile->nUsed += nCharsWritten;
+}
+
+/** Copies a name into a JSON string, escaping what needs escaping. **/
+static void xnTraceEscapeName(const XnChar* strName, XnChar* strEscaped)
+{
+	XnChar* pOut = strEscaped;
+	for (const XnChar* pIn = strName; *pIn != '\0'; ++pIn)
+	{
+		if (*pIn == '"' || *pIn == '\\')
+		{
+			*pOut++ = '\\';
+			*pOut++ = *pIn;
+		}
+		else if ((XnUChar)*pIn >= 0x20)
+		{
+			*pOut++ = *pIn;
+		}
+	}
+	*pOut = '\0';
+}
+
+/** Builds the ID connecting a new-data-available event to the update that consumed it (both refer to the new data by its number). **/
+static XnUInt64 xnTraceFlowID(const XnChar* strObject, XnUInt32 nNewData)
+{
+	// FNV-1a
+	XnUInt64 nHash = 14695981039346656037ULL;
+	for (const XnChar* p = strObject; *p != '\0'; ++p)
+	{
+		nHash ^= (XnUChar)*p;
+		nHash *= 1099511628211ULL;
+	}
+	return nHash ^ nNewData;
+}
+
+static void xnTraceExportEvent(XnTraceExportFile* pFile, XnUInt32 nPID, XnUInt32 nTID, const XnTraceEvent* pEvent)
+{
+	static const XnChar* astrPhases[] = { "B", "E", "i" };
+
+	XnChar strObject[XN_TRACE_OBJECT_NAME_LENGTH * 2];
+	xnTraceEscapeName(pEvent->strObject, strObject);
+
+	const XnChar* strName = xnTraceEventTypeToString((XnTraceEventType)pEvent->nType);
+	const XnChar* strPhase = (pEvent->nPhase <= XN_TRACE_PHASE_INSTANT) ? astrPhases[pEvent->nPhase] : "i";
+
+	xnTraceExportWrite(pFile, ",\n{\"name\":\"%s\",\"cat\":\"OpenNI\",\"ph\":\"%s\",%s\"ts\":%llu,\"pid\":%u,\"tid\":%u,"
+		"\"args\":{\"object\":\"%s\",\"dataTimestamp\":%llu,\"frameID\":%u,\"size\":%u}}",
+		strName, strPhase, (pEvent->nPhase == XN_TRACE_PHASE_INSTANT) ? "\"s\":\"t\"," : "", 
+		pEvent->nTime, nPID, nTID, strObject, pEvent->nDataTimestamp, pEvent->nFrameID, pEvent->nSize);
+
+	if (pEvent->nType == XN_TRACE_NEW_DATA_AVAILABLE && pEvent->nFrameID != 0)
+	{
+		xnTraceExportWrite(pFile, ",\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"s\",\"id\":\"0x%llx\",\"ts\":%llu,\"pid\":%u,\"tid\":%u}",
+			xnTraceFlowID(pEvent->strObject, pEvent->nFrameID), pEvent->nTime, nPID, nTID);
+	}
+
+	// the consumer end of the flow binds to the update slice it is in, so it follows the slice's beginning
+	if (pEvent->nType == XN_TRACE_UPDATE_DATA && pEvent->nPhase == XN_TRACE_PHASE_BEGIN && pEvent->nFrameID != 0)
+	{
+		xnTraceExportWrite(pFile, ",\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"f\",\"bp\":\"e\",\"id\":\"0x%llx\",\"ts\":%llu,\"pid\":%u,\"tid\":%u}",
+			xnTraceFlowID(pEvent->strObject, pEvent->nFrameID), pEvent->nTime, nPID, nTID);
+	}
+}
+
+static XnStatus xnTraceExportBuffer(XnTraceExportFile* pFile, XnUInt32 nPID, XnTraceBuffer* pBuffer, XnTraceEvent* aCopy)
+{
+	XnUInt64 nWritten = pBuffer->nWritten;
+	xnOSMemoryBarrier();
+	XnUInt64 nFirst = (nWritten > pBuffer->nCapacity) ? nWritten - pBuffer->nCapacity : 0;
+
+	// not a mask, as the buffers of a stopped session are no longer a power of two
+	for (XnUInt64 i = nFirst; i < nWritten; ++i)
+	{
+		aCopy[i - nFirst] = pBuffer->aEvents[i % pBuffer->nCapacity];
+	}
+
+	// the owner thread might have overwritten the oldest events while they were copied. Drop those.
+	xnOSMemoryBarrier();
+	XnUInt64 nWritingAfter = pBuffer->nWriting;
+	XnUInt64 nFirstValid = (nWritingAfter > pBuffer->nCapacity) ? nWritingAfter - pBuffer->nCapacity : 0;
+	if (nFirstValid < nFirst)
+	{
+		nFirstValid = nFirst;
+	}
+
+	XnUInt32 nTID = (XnUInt32)pBuffer->nThreadID;
+	xnTraceExportWrite(pFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"Thread %u\"}}", nPID, nTID, nTID);
+
+	for (XnUInt64 i = nFirstValid; i < nWritten; ++i)
+	{
+		xnTraceExportEvent(pFile, nPID, nTID, &aCopy[i - nFirst]);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnTraceExportChromeJSON(const XnChar* strFileName)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XN_VALIDATE_INPUT_PTR(strFileName);
+
+	XN_PROCESS_ID processID = 0;
+	xnOSGetCurrentProcessID(&processID);
+	XnUInt32 nPID = (XnUInt32)processID;
+
+	XnTraceExportFile file;
+	file.nUsed = 0;
+	file.nStatus = XN_STATUS_OK;
+	file.pChunk = XN_NEW_ARR(XnChar, XN_TRACE_EXPORT_CHUNK_SIZE);
+	XN_VALIDATE_ALLOC_PTR(file.pChunk);
+
+	nRetVal = xnOSOpenFile(strFileName, XN_OS_FILE_WRITE | XN_OS_FILE_TRUNCATE, &file.hFile);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		XN_DELETE_ARR(file.pChunk);
+		return (nRetVal);
+	}
+
+	xnTraceExportWrite(&file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	xnTraceExportWrite(&file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"OpenNI\"}}", nPID);
+
+	nRetVal = xnOSRunOnce(&g_TraceInitOnce, xnTraceInit, NULL);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		XnAutoCSLocker locker(g_TraceData.hLock);
+		XnAutoCSLocker buffersLocker(g_TraceData.hBuffersLock);
+
+		XnTraceEvent* aCopy = XN_NEW_ARR(XnTraceEvent, XN_MAX(g_TraceData.nEventsPerThread, 1));
+		if (aCopy == NULL)
+		{
+			nRetVal = XN_STATUS_ALLOC_FAILED;
+		}
+		else
+		{
+			for (XnTraceBuffer* pBuffer = g_TraceData.pBuffers; pBuffer != NULL; pBuffer = pBuffer->pNext)
+			{
+				xnTraceExportBuffer(&file, nPID, pBuffer, aCopy);
+			}
+
+			XN_DELETE_ARR(aCopy);
+		}
+	}
+
+	xnTraceExportWrite(&file, "\n]}\n");
+	xnTraceExportFlush(&file);
+
+	xnOSCloseFile(&file.hFile);
+	XN_DELETE_ARR(file.pChunk);
+
+	XN_IS_STATUS_OK(nRetVal);
+
+	if (file.nStatus != XN_STATUS_OK)
+	{
+		XN_LOG_WARNING_RETURN(file.nStatus, XN_MASK_TRACE, "Failed to write trace to '%s': %s", strFileName, xnGetStatusString(file.nStatus));
+	}
+
+	return (XN_STATUS_OK);
+}
@@ -27,6 +27,44 @@
 #include "XnInternalTypes.h"
 #include "XnModuleLoader.h"
 
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#define XN_PIXEL_CONVERSION_X86
+	#define XN_PIXEL_CONVERSION_SSSE3
+	#define XN_PIXEL_SSSE3_FUNC
+	#include <intrin.h>
+#elif defined(__GNUC__) && defined(__SSE2__)
+	#define XN_PIXEL_CONVERSION_X86
+	// the SSSE3 code is compiled in regardless of the build flags, and only called if the CPU has it
+	#if defined(__SSSE3__) || defined(__clang__) || (__GNUC__ >= 5)
+		#define XN_PIXEL_CONVERSION_SSSE3
+		#define XN_PIXEL_SSSE3_FUNC __attribute__((target("ssse3")))
+	#endif
+#endif
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	#include <emmintrin.h>
+	#ifdef XN_PIXEL_CONVERSION_SSSE3
+		#include <tmmintrin.h>
+	#endif
+#endif
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define XN_YUV422_U		0
+#define XN_YUV422_Y1	1
+#define XN_YUV422_V		2
+#define XN_YUV422_Y2	3
+#define XN_YUV422_BYTES_PER_DOUBLE_PIXEL	4
+
+#define XN_PIXEL_SIMD_SSE2		0x1
+#define XN_PIXEL_SIMD_SSSE3		0x2
+#define XN_PIXEL_SIMD_NAME_MAX	16
+/** Limits the instruction set pixel conversion may use: "none" or "sse2". */
+#define XN_PIXEL_CONVERSION_SIMD_ENV	"XN_PIXEL_CONVERSION_SIMD"
+
+#define XN_DEPTH_HISTOGRAM_TABLES	4
+
 //---------------------------------------------------------------------------
 // Static Data
 //---------------------------------------------------------------------------
@@ -38,6 +76,9 @@ XN_ENUM_MAP_START(XnPixelFormat)
 	XN_ENUM_MAP_ENTRY(XN_PIXEL_FORMAT_MJPEG, "MJPEG")
 XN_ENUM_MAP_END()
 
+/** XN_PIXEL_SIMD_* flags of the kernels to use, -1 until detected. */
+static volatile XnInt32 g_nPixelConversionSIMD = -1;
+
 //---------------------------------------------------------------------------
 // Code
 //---------------------------------------------------------------------------
@@ -103,6 +144,775 @@ XN_C_API XnUInt32 xnGetBytesPerPixelForPixelFormat(XnPixelFormat format)
 	}
 }
 
+//---------------------------------------------------------------------------
+// Pixel Conversion
+//---------------------------------------------------------------------------
+
+static XnUInt32 xnDetectPixelConversionSIMD()
+{
+	XnUInt32 nFlags = 0;
+
+#if defined(XN_PIXEL_CONVERSION_X86) && defined(_MSC_VER)
+	int CPUInfo[4];
+	__cpuid(CPUInfo, 1);
+	if ((CPUInfo[3] & (1 << 26)) != 0)
+	{
+		nFlags |= XN_PIXEL_SIMD_SSE2;
+	}
+	if ((CPUInfo[2] & (1 << 9)) != 0)
+	{
+		nFlags |= XN_PIXEL_SIMD_SSSE3;
+	}
+#elif defined(XN_PIXEL_CONVERSION_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+	{
+		nFlags |= XN_PIXEL_SIMD_SSE2;
+	}
+	if (__builtin_cpu_supports("ssse3"))
+	{
+		nFlags |= XN_PIXEL_SIMD_SSSE3;
+	}
+#endif
+
+#ifndef XN_PIXEL_CONVERSION_SSSE3
+	nFlags &= ~XN_PIXEL_SIMD_SSSE3;
+#endif
+
+	return nFlags;
+}
+
+static XnStatus xnLimitPixelConversionSIMD(const XnChar* strLimit, XnUInt32* pnFlags)
+{
+	if (strLimit == NULL)
+	{
+		return (XN_STATUS_OK);
+	}
+	else if (strcmp(strLimit, "none") == 0)
+	{
+		*pnFlags = 0;
+	}
+	else if (strcmp(strLimit, "sse2") == 0)
+	{
+		*pnFlags &= XN_PIXEL_SIMD_SSE2;
+	}
+	else
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	return (XN_STATUS_OK);
+}
+
+static XnUInt32 xnGetPixelConversionSIMD()
+{
+	// detection is idempotent, so racing threads would just store the same value
+	if (g_nPixelConversionSIMD == -1)
+	{
+		XnUInt32 nFlags = xnDetectPixelConversionSIMD();
+
+		// allow limiting the instruction set, for comparing implementations
+		XnChar strLimit[XN_PIXEL_SIMD_NAME_MAX];
+		if (xnOSGetEnvironmentVariable(XN_PIXEL_CONVERSION_SIMD_ENV, strLimit, sizeof(strLimit)) == XN_STATUS_OK)
+		{
+			xnLimitPixelConversionSIMD(strLimit, &nFlags);
+		}
+
+		g_nPixelConversionSIMD = (XnInt32)nFlags;
+	}
+
+	return (XnUInt32)g_nPixelConversionSIMD;
+}
+
+XN_C_API XnStatus xnSetPixelConversionSIMDLimit(const XnChar* strLimit)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt32 nFlags = xnDetectPixelConversionSIMD();
+	nRetVal = xnLimitPixelConversionSIMD(strLimit, &nFlags);
+	XN_IS_STATUS_OK(nRetVal);
+
+	g_nPixelConversionSIMD = (XnInt32)nFlags;
+
+	return (XN_STATUS_OK);
+}
+
+static inline XnUInt8 xnClampToByte(XnInt32 nValue)
+{
+	return (XnUInt8)(nValue < 0 ? 0 : (nValue > 255 ? 255 : nValue));
+}
+
+/** Returns nValue * nScale / 255, rounded, for values in [0, 255]. */
+static inline XnUInt8 xnScaleByte(XnUInt32 nValue, XnUInt32 nScale)
+{
+	XnUInt32 nProduct = nValue * nScale + 128;
+	return (XnUInt8)((nProduct + (nProduct >> 8)) >> 8);
+}
+
+static inline void xnYUVToRGB(XnInt32 nY, XnInt32 nU, XnInt32 nV, XnUInt8* pRGB)
+{
+	XnInt32 nC = (nY - 16) * 298 + 128;
+	XnInt32 nD = nU - 128;
+	XnInt32 nE = nV - 128;
+
+	pRGB[0] = xnClampToByte((nC + 409 * nE) >> 8);
+	pRGB[1] = xnClampToByte((nC - 100 * nD - 208 * nE) >> 8);
+	pRGB[2] = xnClampToByte((nC + 516 * nD) >> 8);
+}
+
+static inline XnUInt8 xnYToGray(XnInt32 nY)
+{
+	return xnClampToByte(((nY - 16) * 298 + 128) >> 8);
+}
+
+static void xnYUV422ToRGBScalar(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels, XnUInt32 nDstBytesPerPixel)
+{
+	for (XnUInt32 i = 0; i < nPixels; i += 2, pSrc += XN_YUV422_BYTES_PER_DOUBLE_PIXEL)
+	{
+		xnYUVToRGB(pSrc[XN_YUV422_Y1], pSrc[XN_YUV422_U], pSrc[XN_YUV422_V], pDst);
+		if (nDstBytesPerPixel == 4)
+		{
+			pDst[3] = 255;
+		}
+		pDst += nDstBytesPerPixel;
+
+		// an odd pixel count leaves the last macro pixel half used
+		if (i + 1 < nPixels)
+		{
+			xnYUVToRGB(pSrc[XN_YUV422_Y2], pSrc[XN_YUV422_U], pSrc[XN_YUV422_V], pDst);
+			if (nDstBytesPerPixel == 4)
+			{
+				pDst[3] = 255;
+			}
+			pDst += nDstBytesPerPixel;
+		}
+	}
+}
+
+static void xnYUV422ToGray8Scalar(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels)
+{
+	for (XnUInt32 i = 0; i < nPixels; i += 2, pSrc += XN_YUV422_BYTES_PER_DOUBLE_PIXEL)
+	{
+		*pDst++ = xnYToGray(pSrc[XN_YUV422_Y1]);
+		if (i + 1 < nPixels)
+		{
+			*pDst++ = xnYToGray(pSrc[XN_YUV422_Y2]);
+		}
+	}
+}
+
+static inline XnUInt16 xnGray16WindowRange(XnUInt16 nMin, XnUInt16 nMax)
+{
+	return (nMax > nMin) ? (XnUInt16)(nMax - nMin) : 1;
+}
+
+static void xnGray16ToGray8Scalar(const XnUInt16* pSrc, XnUInt8* pDst, XnUInt32 nPixels, XnUInt16 nMin, XnUInt16 nRange, XnFloat fFactor)
+{
+	for (XnUInt32 i = 0; i < nPixels; ++i)
+	{
+		XnUInt16 nValue = (pSrc[i] > nMin) ? (XnUInt16)(pSrc[i] - nMin) : 0;
+		if (nValue > nRange)
+		{
+			nValue = nRange;
+		}
+		pDst[i] = (XnUInt8)((XnFloat)nValue * fFactor + 0.5f);
+	}
+}
+
+static inline XnUInt8 xnDepthHistogramIntensity(XnDepthPixel nDepth, const XnFloat* pHistogram, XnUInt32 nHistogramSize)
+{
+	return (nDepth < nHistogramSize) ? (XnUInt8)(pHistogram[nDepth] * 255.0f) : 0;
+}
+
+static void xnColorizeDepthScalar(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8 nAlpha, XnUInt8* pDst, XnUInt32 nDstBytesPerPixel)
+{
+	for (XnUInt32 i = 0; i < nPixels; ++i, pDst += nDstBytesPerPixel)
+	{
+		XnUInt8 nIntensity = xnDepthHistogramIntensity(pDepth[i], pHistogram, nHistogramSize);
+		pDst[0] = xnScaleByte(nIntensity, color.nRed);
+		pDst[1] = xnScaleByte(nIntensity, color.nGreen);
+		pDst[2] = xnScaleByte(nIntensity, color.nBlue);
+		if (nDstBytesPerPixel == 4)
+		{
+			pDst[3] = (pDepth[i] == 0) ? 0 : nAlpha;
+		}
+	}
+}
+
+#ifdef XN_PIXEL_CONVERSION_X86
+
+/** Builds a coefficient vector for _mm_madd_epi16() over interleaved (a, b) pairs. */
+static inline __m128i xnPairCoefficients(XnInt16 nA, XnInt16 nB)
+{
+	return _mm_set1_epi32((XnInt32)(((XnUInt32)(XnUInt16)nB << 16) | (XnUInt16)nA));
+}
+
+/** Returns (a * coeffA + b * coeffB + c * coeffC + d * coeffD) >> 8 for 8 signed 16-bit lanes. */
+static inline __m128i xnMultiplyAdd4(__m128i a, __m128i b, __m128i ab, __m128i c, __m128i d, __m128i cd)
+{
+	__m128i nLow = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), ab), _mm_madd_epi16(_mm_unpacklo_epi16(c, d), cd));
+	__m128i nHigh = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), ab), _mm_madd_epi16(_mm_unpackhi_epi16(c, d), cd));
+	return _mm_packs_epi32(_mm_srai_epi32(nLow, 8), _mm_srai_epi32(nHigh, 8));
+}
+
+/** Converts 16 YUV422 pixels (32 bytes) to a vector per color channel. */
+static inline void xnYUV422ToRGBVectors(const XnUInt8* pSrc, __m128i& r, __m128i& g, __m128i& b)
+{
+	const __m128i nLowByte = _mm_set1_epi16(0x00FF);
+	const __m128i nOne = _mm_set1_epi16(1);
+	const __m128i n16 = _mm_set1_epi16(16);
+	const __m128i n128 = _mm_set1_epi16(128);
+	// a constant lane of 1 adds the rounding term inside the multiply-add
+	const __m128i nCoeffR = xnPairCoefficients(298, 409);
+	const __m128i nCoeffG1 = xnPairCoefficients(298, -100);
+	const __m128i nCoeffG2 = xnPairCoefficients(-208, 128);
+	const __m128i nCoeffB = xnPairCoefficients(298, 516);
+	const __m128i nCoeffRound = xnPairCoefficients(0, 128);
+
+	__m128i rgb[3][2];
+	for (XnUInt32 nHalf = 0; nHalf < 2; ++nHalf)
+	{
+		// each 16-bit lane holds one pixel: its Y in the high byte, and U or V in the low one
+		__m128i yuv = _mm_loadu_si128((const __m128i*)pSrc + nHalf);
+		__m128i y = _mm_srli_epi16(yuv, 8);
+		__m128i uv = _mm_and_si128(yuv, nLowByte);
+		__m128i u = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+		__m128i v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+
+		__m128i c = _mm_sub_epi16(y, n16);
+		__m128i d = _mm_sub_epi16(u, n128);
+		__m128i e = _mm_sub_epi16(v, n128);
+
+		rgb[0][nHalf] = xnMultiplyAdd4(c, e, nCoeffR, d, nOne, nCoeffRound);
+		rgb[1][nHalf] = xnMultiplyAdd4(c, d, nCoeffG1, e, nOne, nCoeffG2);
+		rgb[2][nHalf] = xnMultiplyAdd4(c, d, nCoeffB, e, nOne, nCoeffRound);
+	}
+
+	r = _mm_packus_epi16(rgb[0][0], rgb[0][1]);
+	g = _mm_packus_epi16(rgb[1][0], rgb[1][1]);
+	b = _mm_packus_epi16(rgb[2][0], rgb[2][1]);
+}
+
+/** Interleaves 16 pixels of separate channels into RGBA. */
+static inline void xnInterleaveRGBA(__m128i r, __m128i g, __m128i b, __m128i a, __m128i* pRGBA)
+{
+	__m128i rgLow = _mm_unpacklo_epi8(r, g);
+	__m128i rgHigh = _mm_unpackhi_epi8(r, g);
+	__m128i baLow = _mm_unpacklo_epi8(b, a);
+	__m128i baHigh = _mm_unpackhi_epi8(b, a);
+
+	pRGBA[0] = _mm_unpacklo_epi16(rgLow, baLow);
+	pRGBA[1] = _mm_unpackhi_epi16(rgLow, baLow);
+	pRGBA[2] = _mm_unpacklo_epi16(rgHigh, baHigh);
+	pRGBA[3] = _mm_unpackhi_epi16(rgHigh, baHigh);
+}
+
+static inline void xnStoreRGBA(__m128i r, __m128i g, __m128i b, __m128i a, XnUInt8* pDst)
+{
+	__m128i rgba[4];
+	xnInterleaveRGBA(r, g, b, a, rgba);
+	for (XnUInt32 i = 0; i < 4; ++i)
+	{
+		_mm_storeu_si128((__m128i*)pDst + i, rgba[i]);
+	}
+}
+
+static inline void xnStoreRGB24SSE2(__m128i r, __m128i g, __m128i b, XnUInt8* pDst)
+{
+	// SSE2 has no byte shuffle, so drop the alpha bytes one pixel at a time
+	__m128i rgba[4];
+	xnInterleaveRGBA(r, g, b, _mm_setzero_si128(), rgba);
+	const XnUInt8* aRGBA = (const XnUInt8*)rgba;
+	for (XnUInt32 i = 0; i < 16; ++i, pDst += 3)
+	{
+		pDst[0] = aRGBA[i * 4];
+		pDst[1] = aRGBA[i * 4 + 1];
+		pDst[2] = aRGBA[i * 4 + 2];
+	}
+}
+
+static XnUInt32 xnYUV422ToRGBSSE2(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels, XnUInt32 nDstBytesPerPixel)
+{
+	const __m128i nAlpha = _mm_set1_epi8((char)0xFF);
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 16 <= nPixels; nDone += 16, pSrc += 32, pDst += 16 * nDstBytesPerPixel)
+	{
+		__m128i r, g, b;
+		xnYUV422ToRGBVectors(pSrc, r, g, b);
+		if (nDstBytesPerPixel == 4)
+		{
+			xnStoreRGBA(r, g, b, nAlpha, pDst);
+		}
+		else
+		{
+			xnStoreRGB24SSE2(r, g, b, pDst);
+		}
+	}
+
+	return nDone;
+}
+
+static XnUInt32 xnYUV422ToGray8SSE2(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels)
+{
+	const __m128i nOne = _mm_set1_epi16(1);
+	const __m128i n16 = _mm_set1_epi16(16);
+	const __m128i nCoeff = xnPairCoefficients(298, 128);
+	const __m128i nZero = _mm_setzero_si128();
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 16 <= nPixels; nDone += 16, pSrc += 32, pDst += 16)
+	{
+		__m128i c0 = _mm_sub_epi16(_mm_srli_epi16(_mm_loadu_si128((const __m128i*)pSrc), 8), n16);
+		__m128i c1 = _mm_sub_epi16(_mm_srli_epi16(_mm_loadu_si128((const __m128i*)pSrc + 1), 8), n16);
+		__m128i gray0 = xnMultiplyAdd4(c0, nOne, nCoeff, nZero, nZero, nZero);
+		__m128i gray1 = xnMultiplyAdd4(c1, nOne, nCoeff, nZero, nZero, nZero);
+		_mm_storeu_si128((__m128i*)pDst, _mm_packus_epi16(gray0, gray1));
+	}
+
+	return nDone;
+}
+
+static XnUInt32 xnGetGray16RangeSSE2(const XnUInt16* pSrc, XnUInt32 nPixels, XnUInt16* pnMin, XnUInt16* pnMax)
+{
+	// SSE2 only compares signed words, so flip the sign bit to keep the unsigned order
+	const __m128i nBias = _mm_set1_epi16((XnInt16)0x8000);
+	__m128i nMin = _mm_set1_epi16(0x7FFF);
+	__m128i nMax = _mm_set1_epi16((XnInt16)0x8000);
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 8 <= nPixels; nDone += 8)
+	{
+		__m128i nValue = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(pSrc + nDone)), nBias);
+		nMin = _mm_min_epi16(nMin, nValue);
+		nMax = _mm_max_epi16(nMax, nValue);
+	}
+
+	XnUInt16 aMin[8];
+	XnUInt16 aMax[8];
+	_mm_storeu_si128((__m128i*)aMin, _mm_xor_si128(nMin, nBias));
+	_mm_storeu_si128((__m128i*)aMax, _mm_xor_si128(nMax, nBias));
+	for (XnUInt32 i = 0; i < 8; ++i)
+	{
+		*pnMin = XN_MIN(*pnMin, aMin[i]);
+		*pnMax = XN_MAX(*pnMax, aMax[i]);
+	}
+
+	return nDone;
+}
+
+static XnUInt32 xnGray16ToGray8SSE2(const XnUInt16* pSrc, XnUInt8* pDst, XnUInt32 nPixels, XnUInt16 nMin, XnUInt16 nRange, XnFloat fFactor)
+{
+	const __m128i vMin = _mm_set1_epi16((XnInt16)nMin);
+	const __m128i vRange = _mm_set1_epi16((XnInt16)nRange);
+	const __m128i vZero = _mm_setzero_si128();
+	const __m128 vFactor = _mm_set1_ps(fFactor);
+	const __m128 vHalf = _mm_set1_ps(0.5f);
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 16 <= nPixels; nDone += 16)
+	{
+		__m128i aWords[2];
+		for (XnUInt32 nHalf = 0; nHalf < 2; ++nHalf)
+		{
+			__m128i nValue = _mm_loadu_si128((const __m128i*)(pSrc + nDone) + nHalf);
+			// min(max(value - min, 0), range), with saturating unsigned arithmetic
+			nValue = _mm_subs_epu16(nValue, vMin);
+			nValue = _mm_sub_epi16(nValue, _mm_subs_epu16(nValue, vRange));
+
+			__m128 fLow = _mm_cvtepi32_ps(_mm_unpacklo_epi16(nValue, vZero));
+			__m128 fHigh = _mm_cvtepi32_ps(_mm_unpackhi_epi16(nValue, vZero));
+			__m128i nLow = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(fLow, vFactor), vHalf));
+			__m128i nHigh = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(fHigh, vFactor), vHalf));
+			aWords[nHalf] = _mm_packs_epi32(nLow, nHigh);
+		}
+		_mm_storeu_si128((__m128i*)(pDst + nDone), _mm_packus_epi16(aWords[0], aWords[1]));
+	}
+
+	return nDone;
+}
+
+/** Scales 16 intensities (in two vectors of words) by nScale / 255, into one vector of bytes. */
+static inline __m128i xnScaleIntensity(const __m128i* aIntensity, XnUInt8 nScale)
+{
+	// full and no color are the common cases
+	if (nScale == 255)
+	{
+		return _mm_packus_epi16(aIntensity[0], aIntensity[1]);
+	}
+	else if (nScale == 0)
+	{
+		return _mm_setzero_si128();
+	}
+
+	// same rounding division by 255 as xnScaleByte()
+	const __m128i vScale = _mm_set1_epi16(nScale);
+	const __m128i vRound = _mm_set1_epi16(128);
+	__m128i aScaled[2];
+	for (XnUInt32 nHalf = 0; nHalf < 2; ++nHalf)
+	{
+		__m128i nProduct = _mm_add_epi16(_mm_mullo_epi16(aIntensity[nHalf], vScale), vRound);
+		aScaled[nHalf] = _mm_srli_epi16(_mm_add_epi16(nProduct, _mm_srli_epi16(nProduct, 8)), 8);
+	}
+
+	return _mm_packus_epi16(aScaled[0], aScaled[1]);
+}
+
+/** Looks up the histogram intensities of 16 depth pixels, and splits them into color channels. */
+static inline void xnColorizeDepthVectors(const XnDepthPixel* pDepth, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8 nAlpha, __m128i& r, __m128i& g, __m128i& b, __m128i& a)
+{
+	const __m128 v255 = _mm_set1_ps(255.0f);
+	const __m128i vZero = _mm_setzero_si128();
+
+	const XnUInt32 nLastIndex = XN_MIN(nHistogramSize - 1, XN_MAX_UINT16);
+	const __m128i vLastIndex = _mm_set1_epi16((XnInt16)nLastIndex);
+
+	// There is no gather in SSE, so the lookup itself stays scalar. Indices are clamped instead of
+	// checked, and out of range pixels are masked out afterwards, to keep the loop branch free.
+	__m128i aIntensity[2];
+	for (XnUInt32 nHalf = 0; nHalf < 2; ++nHalf)
+	{
+		const XnDepthPixel* p = pDepth + nHalf * 8;
+		__m128 fLow = _mm_setr_ps(pHistogram[XN_MIN(p[0], nLastIndex)], pHistogram[XN_MIN(p[1], nLastIndex)], pHistogram[XN_MIN(p[2], nLastIndex)], pHistogram[XN_MIN(p[3], nLastIndex)]);
+		__m128 fHigh = _mm_setr_ps(pHistogram[XN_MIN(p[4], nLastIndex)], pHistogram[XN_MIN(p[5], nLastIndex)], pHistogram[XN_MIN(p[6], nLastIndex)], pHistogram[XN_MIN(p[7], nLastIndex)]);
+		__m128i nIntensity = _mm_packs_epi32(_mm_cvttps_epi32(_mm_mul_ps(fLow, v255)), _mm_cvttps_epi32(_mm_mul_ps(fHigh, v255)));
+
+		__m128i nInRange = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_loadu_si128((const __m128i*)p), vLastIndex), vZero);
+		aIntensity[nHalf] = _mm_and_si128(nIntensity, nInRange);
+	}
+
+	r = xnScaleIntensity(aIntensity, color.nRed);
+	g = xnScaleIntensity(aIntensity, color.nGreen);
+	b = xnScaleIntensity(aIntensity, color.nBlue);
+
+	__m128i nNoDepth = _mm_packs_epi16(
+		_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)pDepth), vZero),
+		_mm_cmpeq_epi16(_mm_loadu_si128((const __m128i*)pDepth + 1), vZero));
+	a = _mm_andnot_si128(nNoDepth, _mm_set1_epi8((char)nAlpha));
+}
+
+static XnUInt32 xnColorizeDepthSSE2(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8 nAlpha, XnUInt8* pDst, XnUInt32 nDstBytesPerPixel)
+{
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 16 <= nPixels; nDone += 16, pDst += 16 * nDstBytesPerPixel)
+	{
+		__m128i r, g, b, a;
+		xnColorizeDepthVectors(pDepth + nDone, pHistogram, nHistogramSize, color, nAlpha, r, g, b, a);
+		if (nDstBytesPerPixel == 4)
+		{
+			xnStoreRGBA(r, g, b, a, pDst);
+		}
+		else
+		{
+			xnStoreRGB24SSE2(r, g, b, pDst);
+		}
+	}
+
+	return nDone;
+}
+
+#ifdef XN_PIXEL_CONVERSION_SSSE3
+
+XN_PIXEL_SSSE3_FUNC static inline void xnStoreRGB24SSSE3(__m128i r, __m128i g, __m128i b, XnUInt8* pDst)
+{
+	const __m128i nDropAlpha = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+
+	__m128i rgba[4];
+	xnInterleaveRGBA(r, g, b, _mm_setzero_si128(), rgba);
+	for (XnUInt32 i = 0; i < 4; ++i)
+	{
+		rgba[i] = _mm_shuffle_epi8(rgba[i], nDropAlpha);
+	}
+
+	// each vector now holds 12 bytes of output. Stitch them into 3 full vectors.
+	_mm_storeu_si128((__m128i*)pDst, _mm_or_si128(rgba[0], _mm_slli_si128(rgba[1], 12)));
+	_mm_storeu_si128((__m128i*)pDst + 1, _mm_or_si128(_mm_srli_si128(rgba[1], 4), _mm_slli_si128(rgba[2], 8)));
+	_mm_storeu_si128((__m128i*)pDst + 2, _mm_or_si128(_mm_srli_si128(rgba[2], 8), _mm_slli_si128(rgba[3], 4)));
+}
+
+XN_PIXEL_SSSE3_FUNC static XnUInt32 xnYUV422ToRGB24SSSE3(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels)
+{
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 16 <= nPixels; nDone += 16, pSrc += 32, pDst += 48)
+	{
+		__m128i r, g, b;
+		xnYUV422ToRGBVectors(pSrc, r, g, b);
+		xnStoreRGB24SSSE3(r, g, b, pDst);
+	}
+
+	return nDone;
+}
+
+XN_PIXEL_SSSE3_FUNC static XnUInt32 xnColorizeDepthToRGB24SSSE3(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8* pDst)
+{
+	XnUInt32 nDone = 0;
+
+	for (; nDone + 16 <= nPixels; nDone += 16, pDst += 48)
+	{
+		__m128i r, g, b, a;
+		xnColorizeDepthVectors(pDepth + nDone, pHistogram, nHistogramSize, color, 0, r, g, b, a);
+		xnStoreRGB24SSSE3(r, g, b, pDst);
+	}
+
+	return nDone;
+}
+
+#endif // XN_PIXEL_CONVERSION_SSSE3
+
+#endif // XN_PIXEL_CONVERSION_X86
+
+XN_C_API XnStatus xnConvertYUV422ToRGB24(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels)
+{
+	XN_VALIDATE_INPUT_PTR(pSrc);
+	XN_VALIDATE_OUTPUT_PTR(pDst);
+
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	XnUInt32 nSIMD = xnGetPixelConversionSIMD();
+#ifdef XN_PIXEL_CONVERSION_SSSE3
+	if ((nSIMD & XN_PIXEL_SIMD_SSSE3) != 0)
+	{
+		nDone = xnYUV422ToRGB24SSSE3(pSrc, pDst, nPixels);
+	}
+	else
+#endif
+	if ((nSIMD & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnYUV422ToRGBSSE2(pSrc, pDst, nPixels, sizeof(XnRGB24Pixel));
+	}
+#endif
+
+	xnYUV422ToRGBScalar(pSrc + nDone * 2, pDst + nDone * sizeof(XnRGB24Pixel), nPixels - nDone, sizeof(XnRGB24Pixel));
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnConvertYUV422ToRGBA32(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels)
+{
+	XN_VALIDATE_INPUT_PTR(pSrc);
+	XN_VALIDATE_OUTPUT_PTR(pDst);
+
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	if ((xnGetPixelConversionSIMD() & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnYUV422ToRGBSSE2(pSrc, pDst, nPixels, 4);
+	}
+#endif
+
+	xnYUV422ToRGBScalar(pSrc + nDone * 2, pDst + nDone * 4, nPixels - nDone, 4);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnConvertYUV422ToGray8(const XnUInt8* pSrc, XnUInt8* pDst, XnUInt32 nPixels)
+{
+	XN_VALIDATE_INPUT_PTR(pSrc);
+	XN_VALIDATE_OUTPUT_PTR(pDst);
+
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	if ((xnGetPixelConversionSIMD() & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnYUV422ToGray8SSE2(pSrc, pDst, nPixels);
+	}
+#endif
+
+	xnYUV422ToGray8Scalar(pSrc + nDone * 2, pDst + nDone, nPixels - nDone);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnGetGray16Range(const XnUInt16* pSrc, XnUInt32 nPixels, XnUInt16* pnMin, XnUInt16* pnMax)
+{
+	XN_VALIDATE_INPUT_PTR(pSrc);
+	XN_VALIDATE_OUTPUT_PTR(pnMin);
+	XN_VALIDATE_OUTPUT_PTR(pnMax);
+
+	if (nPixels == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	XnUInt16 nMin = pSrc[0];
+	XnUInt16 nMax = pSrc[0];
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	if ((xnGetPixelConversionSIMD() & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnGetGray16RangeSSE2(pSrc, nPixels, &nMin, &nMax);
+	}
+#endif
+
+	for (XnUInt32 i = nDone; i < nPixels; ++i)
+	{
+		nMin = XN_MIN(nMin, pSrc[i]);
+		nMax = XN_MAX(nMax, pSrc[i]);
+	}
+
+	*pnMin = nMin;
+	*pnMax = nMax;
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnConvertGray16ToGray8(const XnUInt16* pSrc, XnUInt8* pDst, XnUInt32 nPixels, XnUInt16 nMin, XnUInt16 nMax)
+{
+	XN_VALIDATE_INPUT_PTR(pSrc);
+	XN_VALIDATE_OUTPUT_PTR(pDst);
+
+	XnUInt16 nRange = xnGray16WindowRange(nMin, nMax);
+	XnFloat fFactor = 255.0f / nRange;
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	if ((xnGetPixelConversionSIMD() & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnGray16ToGray8SSE2(pSrc, pDst, nPixels, nMin, nRange, fFactor);
+	}
+#endif
+
+	xnGray16ToGray8Scalar(pSrc + nDone, pDst + nDone, nPixels - nDone, nMin, nRange, fFactor);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnCalculateDepthHistogram(const XnDepthPixel* pDepth, XnUInt32 nPixels, XnFloat* pHistogram, XnUInt32 nHistogramSize)
+{
+	XN_VALIDATE_INPUT_PTR(pDepth);
+	XN_VALIDATE_OUTPUT_PTR(pHistogram);
+
+	if (nHistogramSize == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	// Neighboring depth pixels tend to be equal, and counting them into the same entry makes every
+	// increment wait for the previous one. Spreading consecutive pixels over separate count tables
+	// breaks that chain, and integer counts are cheaper to increment than floats.
+	XnUInt32* pCounts;
+	XN_VALIDATE_CALLOC(pCounts, XnUInt32, nHistogramSize * XN_DEPTH_HISTOGRAM_TABLES);
+	XnUInt32* pCounts0 = pCounts;
+	XnUInt32* pCounts1 = pCounts0 + nHistogramSize;
+	XnUInt32* pCounts2 = pCounts1 + nHistogramSize;
+	XnUInt32* pCounts3 = pCounts2 + nHistogramSize;
+
+	XnUInt32 i = 0;
+	for (; i + XN_DEPTH_HISTOGRAM_TABLES <= nPixels; i += XN_DEPTH_HISTOGRAM_TABLES)
+	{
+		XnDepthPixel nDepth0 = pDepth[i];
+		XnDepthPixel nDepth1 = pDepth[i + 1];
+		XnDepthPixel nDepth2 = pDepth[i + 2];
+		XnDepthPixel nDepth3 = pDepth[i + 3];
+		if (nDepth0 < nHistogramSize)
+		{
+			pCounts0[nDepth0]++;
+		}
+		if (nDepth1 < nHistogramSize)
+		{
+			pCounts1[nDepth1]++;
+		}
+		if (nDepth2 < nHistogramSize)
+		{
+			pCounts2[nDepth2]++;
+		}
+		if (nDepth3 < nHistogramSize)
+		{
+			pCounts3[nDepth3]++;
+		}
+	}
+	for (; i < nPixels; ++i)
+	{
+		if (pDepth[i] < nHistogramSize)
+		{
+			pCounts0[pDepth[i]]++;
+		}
+	}
+
+	// no-sample pixels are counted above just to keep the loop branch free, but they are not points
+	XnUInt32 nPoints = 0;
+	for (XnUInt32 nDepth = 1; nDepth < nHistogramSize; ++nDepth)
+	{
+		nPoints += pCounts0[nDepth] + pCounts1[nDepth] + pCounts2[nDepth] + pCounts3[nDepth];
+	}
+
+	pHistogram[0] = 0;
+	XnUInt32 nCumulative = 0;
+	for (XnUInt32 nDepth = 1; nDepth < nHistogramSize; ++nDepth)
+	{
+		nCumulative += pCounts0[nDepth] + pCounts1[nDepth] + pCounts2[nDepth] + pCounts3[nDepth];
+		pHistogram[nDepth] = (nCumulative == 0) ? 0 : (XnFloat)(nPoints - nCumulative) / nPoints;
+	}
+
+	xnOSFree(pCounts);
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnColorizeDepthToRGB24(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8* pDst)
+{
+	XN_VALIDATE_INPUT_PTR(pDepth);
+	XN_VALIDATE_INPUT_PTR(pHistogram);
+	XN_VALIDATE_OUTPUT_PTR(pDst);
+
+	if (nHistogramSize == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	XnUInt32 nSIMD = xnGetPixelConversionSIMD();
+#ifdef XN_PIXEL_CONVERSION_SSSE3
+	if ((nSIMD & XN_PIXEL_SIMD_SSSE3) != 0)
+	{
+		nDone = xnColorizeDepthToRGB24SSSE3(pDepth, nPixels, pHistogram, nHistogramSize, color, pDst);
+	}
+	else
+#endif
+	if ((nSIMD & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnColorizeDepthSSE2(pDepth, nPixels, pHistogram, nHistogramSize, color, 0, pDst, sizeof(XnRGB24Pixel));
+	}
+#endif
+
+	xnColorizeDepthScalar(pDepth + nDone, nPixels - nDone, pHistogram, nHistogramSize, color, 0, pDst + nDone * sizeof(XnRGB24Pixel), sizeof(XnRGB24Pixel));
+
+	return (XN_STATUS_OK);
+}
+
+XN_C_API XnStatus xnColorizeDepthToRGBA32(const XnDepthPixel* pDepth, XnUInt32 nPixels, const XnFloat* pHistogram, XnUInt32 nHistogramSize, XnRGB24Pixel color, XnUInt8 nAlpha, XnUInt8* pDst)
+{
+	XN_VALIDATE_INPUT_PTR(pDepth);
+	XN_VALIDATE_INPUT_PTR(pHistogram);
+	XN_VALIDATE_OUTPUT_PTR(pDst);
+
+	if (nHistogramSize == 0)
+	{
+		return (XN_STATUS_BAD_PARAM);
+	}
+
+	XnUInt32 nDone = 0;
+
+#ifdef XN_PIXEL_CONVERSION_X86
+	if ((xnGetPixelConversionSIMD() & XN_PIXEL_SIMD_SSE2) != 0)
+	{
+		nDone = xnColorizeDepthSSE2(pDepth, nPixels, pHistogram, nHistogramSize, color, nAlpha, pDst, 4);
+	}
+#endif
+
+	xnColorizeDepthScalar(pDepth + nDone, nPixels - nDone, pHistogram, nHistogramSize, color, nAlpha, pDst + nDone * 4, 4);
+
+	return (XN_STATUS_OK);
+}
+
 XN_C_API XnInt32 xnVersionCompare(const XnVersion* pVersion1, const XnVersion* pVersion2)
 {
 	XnInt32 nResult = pVersion1->nMajor - pVersion2->nMajor;
@@ -36,4 +36,29 @@ XnOpenNIModuleInterface* GetOpenNIModuleInterface();
 void GetOpenNIScriptNodeDescription(XnProductionNodeDescription* pDescription);
 XnStatus xnGetOpenNIConfFilesPath(XnChar* strDest, XnUInt32 nBufSize);
 
+/**
+* Splits a network medium name of the form "host:port" into its host and port parts.
+*/
+XnStatus xnParseNetworkAddress(const XnChar* strAddress, XnChar* strHost, XnUInt32 nHostBufSize, XnUInt16* pnPort);
+
+/**
+* First line of the manifest of a segmented recording. Each following line is the file name of one segment,
+* relative to the manifest's directory.
+*/
+#define XN_SEGMENTS_MANIFEST_HEADER "#OpenNI recording segments 1.0"
+
+//---------------------------------------------------------------------------
+// Configuration
+//---------------------------------------------------------------------------
+class TiXmlElement;
+
+/** Applies the <Log> element of an already parsed OpenNI XML configuration. pRootElem may be NULL. */
+XnStatus xnLogInitFromXml(TiXmlElement* pRootElem);
+
+/**
+* Applies the <Threads> element of an already parsed OpenNI XML configuration. pRootElem may be NULL.
+* An invalid <Thread> entry is logged and skipped, and its error is returned once the others were applied.
+*/
+XnStatus xnOSLoadThreadPoliciesFromXml(const TiXmlElement* pRootElem);
+
 #endif // __XNINTERNALFUNCS_H__
\ No newline at end of file
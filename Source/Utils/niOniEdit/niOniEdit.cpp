@@ -0,0 +1,215 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnOpenNI.h>
+#include <XnLog.h>
+#include <XnOniEditor.h>
+#include <stdlib.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define MAX_INPUTS 64
+#define MAX_NODE_NAMES 32
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+
+void printUsage(const char* procName)
+{
+	printf("Usage: %s [options] OUTPUT INPUT [INPUT ...]\n", procName);
+	printf("\n");
+	printf("Copies the frames of one or more recordings into OUTPUT, without decoding them. Several INPUTs are\n");
+	printf("concatenated: each one starts a frame after the previous one ends. Nodes are matched by name,\n");
+	printf("and must have the same codec in all INPUTs.\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("-s SEC	Copy from this time (in seconds) of each INPUT\n");
+	printf("-e SEC	Copy up to this time (in seconds) of each INPUT\n");
+	printf("-n NAME	Copy only node NAME. Can be given several times.\n");
+	printf("-k	Keep the recorded timestamps, instead of starting each INPUT right after the previous one.\n");
+	printf("	INPUTs must then be given in the order they were recorded.\n");
+	printf("-v	Verbose mode\n");
+}
+
+static XnBool parseSeconds(const char* str, XnUInt64& nMicroseconds)
+{
+	char* pEnd = NULL;
+	double dSeconds = strtod(str, &pEnd);
+	if (pEnd == str || *pEnd != '\0' || dSeconds < 0)
+	{
+		return FALSE;
+	}
+
+	nMicroseconds = (XnUInt64)(dSeconds * 1e6 + 0.5);
+	return TRUE;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* strOutput = NULL;
+	const char* astrInputs[MAX_INPUTS];
+	XnUInt32 nInputs = 0;
+	const XnChar* astrNodeNames[MAX_NODE_NAMES];
+	XnBool bVerbose = FALSE;
+
+	XnOniCopyOptions options;
+	xnOSMemSet(&options, 0, sizeof(options));
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const XnChar* arg = argv[i];
+		if (arg[0] == '-')
+		{
+			if (arg[1] == '\0' || arg[2] != '\0')
+			{
+				printUsage(argv[0]);
+				return -1;
+			}
+
+			if (arg[1] == 'v')
+			{
+				bVerbose = TRUE;
+				continue;
+			}
+
+			if (arg[1] == 'k')
+			{
+				options.bKeepTimestamps = TRUE;
+				continue;
+			}
+
+			if (i + 1 == argc)
+			{
+				printf("Option -%c needs a value\n", arg[1]);
+				printUsage(argv[0]);
+				return -1;
+			}
+
+			const XnChar* strValue = argv[++i];
+
+			switch (arg[1])
+			{
+			case 's':
+				if (!parseSeconds(strValue, options.nStartTime))
+				{
+					printf("Invalid start time: %s\n", strValue);
+					return -1;
+				}
+				break;
+			case 'e':
+				if (!parseSeconds(strValue, options.nEndTime))
+				{
+					printf("Invalid end time: %s\n", strValue);
+					return -1;
+				}
+				break;
+			case 'n':
+				if (options.nNodeNames == MAX_NODE_NAMES)
+				{
+					printf("Too many nodes (up to %u can be selected)\n", MAX_NODE_NAMES);
+					return -1;
+				}
+				astrNodeNames[options.nNodeNames++] = strValue;
+				options.astrNodeNames = astrNodeNames;
+				break;
+			default:
+				printf("Unknown option: -%c\n", arg[1]);
+				printUsage(argv[0]);
+				return -1;
+			}
+		}
+		else if (strOutput == NULL)
+		{
+			strOutput = arg;
+		}
+		else if (nInputs < MAX_INPUTS)
+		{
+			astrInputs[nInputs++] = arg;
+		}
+		else
+		{
+			printf("Too many inputs (up to %u can be concatenated)\n", MAX_INPUTS);
+			return -1;
+		}
+	} // args for
+
+	if (strOutput == NULL || nInputs == 0)
+	{
+		printUsage(argv[0]);
+		return -1;
+	}
+
+	xnLogInitSystem();
+	xnLogSetMaskMinSeverity(XN_LOG_MASK_ALL, bVerbose ? XN_LOG_VERBOSE : XN_LOG_WARNING);
+	xnLogSetConsoleOutput(TRUE);
+
+	XnUInt64 nStartTime = 0;
+	xnOSGetHighResTimeStamp(&nStartTime);
+
+	XnOniEditor* pEditor = NULL;
+	XnStatus nRetVal = xnOniEditorCreate(strOutput, &pEditor);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		printf("Failed to create %s: %s\n", strOutput, xnGetStatusString(nRetVal));
+		return -1;
+	}
+
+	for (XnUInt32 i = 0; i < nInputs; ++i)
+	{
+		if (bVerbose)
+		{
+			printf("Copying %s...\n", astrInputs[i]);
+		}
+
+		nRetVal = xnOniEditorAppend(pEditor, astrInputs[i], &options);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			printf("Failed to copy %s: %s\n", astrInputs[i], xnGetStatusString(nRetVal));
+			xnOniEditorClose(&pEditor);
+			xnOSDeleteFile(strOutput);
+			return -1;
+		}
+	}
+
+	nRetVal = xnOniEditorClose(&pEditor);
+	if (nRetVal != XN_STATUS_OK)
+	{
+		printf("Failed to write %s: %s\n", strOutput, xnGetStatusString(nRetVal));
+		return -1;
+	}
+
+	XnUInt64 nEndTime = 0;
+	xnOSGetHighResTimeStamp(&nEndTime);
+
+	if (bVerbose)
+	{
+		XnUInt64 nFileSize = 0;
+		xnOSGetFileSize64(strOutput, &nFileSize);
+		XnDouble dSeconds = (nEndTime - nStartTime) / 1e6;
+		printf("Wrote %llu bytes in %.2f seconds (%.1f MB/s).\n", nFileSize, dSeconds, (dSeconds > 0) ? nFileSize / dSeconds / (1024 * 1024) : 0.0);
+	}
+
+	return 0;
+}
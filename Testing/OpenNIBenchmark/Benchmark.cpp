@@ -0,0 +1,458 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+#include <XnPropNames.h>
+#include <new>
+#include <math.h>
+
+//---------------------------------------------------------------------------
+// Allocation Counting
+//---------------------------------------------------------------------------
+// Replacing the global operators counts every C++ allocation made by the
+// benchmark and, where the dynamic linker lets the executable interpose them
+// (Linux, Mac), by OpenNI and its modules as well. Allocations made with
+// xnOSMalloc() are not counted.
+#if __cplusplus >= 201103L
+	#define BENCHMARK_THROWS_BAD_ALLOC
+	#define BENCHMARK_NO_THROW			noexcept
+#else
+	#define BENCHMARK_THROWS_BAD_ALLOC	throw(std::bad_alloc)
+	#define BENCHMARK_NO_THROW			throw()
+#endif
+
+static volatile XnUInt64 g_nAllocations = 0;
+
+static inline void countAllocation()
+{
+#if XN_PLATFORM == XN_PLATFORM_WIN32
+	InterlockedIncrement64((volatile LONGLONG*)&g_nAllocations);
+#else
+	__sync_fetch_and_add(&g_nAllocations, 1);
+#endif
+}
+
+void* operator new(size_t nSize) BENCHMARK_THROWS_BAD_ALLOC
+{
+	countAllocation();
+	void* pResult = malloc(nSize == 0 ? 1 : nSize);
+	if (pResult == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return pResult;
+}
+
+void* operator new[](size_t nSize) BENCHMARK_THROWS_BAD_ALLOC
+{
+	return operator new(nSize);
+}
+
+void* operator new(size_t nSize, const std::nothrow_t&) BENCHMARK_NO_THROW
+{
+	countAllocation();
+	return malloc(nSize == 0 ? 1 : nSize);
+}
+
+void* operator new[](size_t nSize, const std::nothrow_t&) BENCHMARK_NO_THROW
+{
+	return operator new(nSize, std::nothrow);
+}
+
+void operator delete(void* p) BENCHMARK_NO_THROW
+{
+	free(p);
+}
+
+void operator delete[](void* p) BENCHMARK_NO_THROW
+{
+	free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) BENCHMARK_NO_THROW
+{
+	free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) BENCHMARK_NO_THROW
+{
+	free(p);
+}
+
+XnUInt64 benchmarkGetAllocationCount()
+{
+	return g_nAllocations;
+}
+
+//---------------------------------------------------------------------------
+// Utilities
+//---------------------------------------------------------------------------
+static int XN_CALLBACK_TYPE compareSamples(const void* pLeft, const void* pRight)
+{
+	XnUInt64 nLeft = *(const XnUInt64*)pLeft;
+	XnUInt64 nRight = *(const XnUInt64*)pRight;
+	return (nLeft < nRight) ? -1 : (nLeft > nRight) ? 1 : 0;
+}
+
+XnUInt64 benchmarkPercentile(XnUInt64* pSamples, XnUInt32 nCount, XnDouble dPercentile)
+{
+	if (nCount == 0)
+	{
+		return 0;
+	}
+
+	qsort(pSamples, nCount, sizeof(XnUInt64), compareSamples);
+
+	// nearest-rank
+	XnUInt32 nRank = (XnUInt32)(dPercentile / 100.0 * nCount + 0.5);
+	if (nRank > 0)
+	{
+		--nRank;
+	}
+	if (nRank >= nCount)
+	{
+		nRank = nCount - 1;
+	}
+
+	return pSamples[nRank];
+}
+
+void fillDepthFrame(XnDepthPixel* pDepth, XnUInt32 nXRes, XnUInt32 nYRes, XnUInt32 nFrame)
+{
+	// a sloped floor with a box sliding across it
+	XnUInt32 nBoxLeft = (nFrame * 8) % nXRes;
+	XnUInt32 nBoxRight = nBoxLeft + nXRes / 4;
+	XnUInt32 nBoxTop = nYRes / 4;
+	XnUInt32 nBoxBottom = nYRes * 3 / 4;
+
+	for (XnUInt32 y = 0; y < nYRes; ++y)
+	{
+		for (XnUInt32 x = 0; x < nXRes; ++x, ++pDepth)
+		{
+			if (y >= nBoxTop && y < nBoxBottom && x >= nBoxLeft && x < nBoxRight)
+			{
+				*pDepth = (XnDepthPixel)(1200 + (x - nBoxLeft) / 4);
+			}
+			else
+			{
+				*pDepth = (XnDepthPixel)(4000 - y * 4);
+			}
+		}
+	}
+}
+
+void fillImageFrame(XnUInt8* pImage, XnUInt32 nXRes, XnUInt32 nYRes, XnUInt32 nBytesPerPixel, XnUInt32 nFrame)
+{
+	for (XnUInt32 y = 0; y < nYRes; ++y)
+	{
+		for (XnUInt32 x = 0; x < nXRes; ++x)
+		{
+			for (XnUInt32 c = 0; c < nBytesPerPixel; ++c, ++pImage)
+			{
+				*pImage = (XnUInt8)((x + nFrame) * (c + 1) + y * (nBytesPerPixel - c));
+			}
+		}
+	}
+}
+
+void fillAudioFrame(XnInt16* pSamples, const XnWaveOutputMode& mode, XnUInt32 nSamplesPerChannel, XnUInt32 nFrame)
+{
+	const XnDouble dTwoPi = 6.283185307179586;
+	XnUInt32 nSeed = nFrame + 1;
+	for (XnUInt32 n = 0; n < nSamplesPerChannel; ++n)
+	{
+		XnDouble t = ((XnDouble)nFrame * nSamplesPerChannel + n) / mode.nSampleRate;
+		XnDouble dVoice = 6000 * sin(dTwoPi * 220 * t) + 2000 * sin(dTwoPi * 660 * t);
+		for (XnUInt32 c = 0; c < mode.nChannels; ++c, ++pSamples)
+		{
+			nSeed = nSeed * 1103515245 + 12345;
+			XnInt32 nHiss = (XnInt32)((nSeed >> 16) % 33) - 16;
+			*pSamples = (XnInt16)(dVoice * (1.0 - c * 0.1) + 3000 * sin(dTwoPi * 100 * (c + 1) * t) + nHiss);
+		}
+	}
+}
+
+//---------------------------------------------------------------------------
+// Mock Nodes
+//---------------------------------------------------------------------------
+static void setRecordableCapabilities(xn::ProductionNode& node)
+{
+	// the recorder queries these on every map generator
+	node.SetIntProperty(XN_CAPABILITY_MIRROR, FALSE);
+	node.SetIntProperty(XN_CAPABILITY_FRAME_SYNC, FALSE);
+	node.SetIntProperty(XN_CAPABILITY_EXTENDED_SERIALIZATION, FALSE);
+}
+
+XnStatus createMockDepth(xn::Context& context, const XnChar* strName, const BenchmarkConfig& config, xn::MockDepthGenerator& mockDepth)
+{
+	XnStatus nRetVal = mockDepth.Create(context, strName);
+	CHECK_RC(nRetVal, "Create mock depth node");
+
+	XnMapOutputMode mode = { config.nXRes, config.nYRes, config.nFPS };
+	nRetVal = mockDepth.SetMapOutputMode(mode);
+	CHECK_RC(nRetVal, "Set depth output mode");
+	setRecordableCapabilities(mockDepth);
+	mockDepth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1);
+	mockDepth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode);
+	mockDepth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000);
+	nRetVal = mockDepth.SetIntProperty(XN_PROP_STATE_READY, TRUE);
+	CHECK_RC(nRetVal, "Set mock depth state");
+
+	return XN_STATUS_OK;
+}
+
+XnStatus createMockImage(xn::Context& context, const XnChar* strName, const BenchmarkConfig& config, XnPixelFormat format, xn::MockImageGenerator& mockImage)
+{
+	XnStatus nRetVal = mockImage.Create(context, strName);
+	CHECK_RC(nRetVal, "Create mock image node");
+
+	XnMapOutputMode mode = { config.nXRes, config.nYRes, config.nFPS };
+	nRetVal = mockImage.SetMapOutputMode(mode);
+	CHECK_RC(nRetVal, "Set image output mode");
+	setRecordableCapabilities(mockImage);
+	mockImage.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1);
+	mockImage.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode);
+
+	XnSupportedPixelFormats formats;
+	xnOSMemSet(&formats, 0, sizeof(formats));
+	formats.m_bRGB24 = TRUE;
+	formats.m_bYUV422 = TRUE;
+	formats.m_bGrayscale8Bit = TRUE;
+	mockImage.SetGeneralProperty(XN_PROP_SUPPORTED_PIXEL_FORMATS, sizeof(formats), &formats);
+	nRetVal = mockImage.SetIntProperty(XN_PROP_PIXEL_FORMAT, format);
+	CHECK_RC(nRetVal, "Set image pixel format");
+
+	nRetVal = mockImage.SetIntProperty(XN_PROP_STATE_READY, TRUE);
+	CHECK_RC(nRetVal, "Set mock image state");
+
+	return XN_STATUS_OK;
+}
+
+XnStatus createMockAudio(xn::Context& context, const XnChar* strName, const XnWaveOutputMode& mode, xn::MockAudioGenerator& mockAudio)
+{
+	XnStatus nRetVal = mockAudio.Create(context, strName);
+	CHECK_RC(nRetVal, "Create mock audio node");
+
+	nRetVal = mockAudio.SetWaveOutputMode(mode);
+	CHECK_RC(nRetVal, "Set wave output mode");
+	mockAudio.SetIntProperty(XN_PROP_WAVE_SUPPORTED_OUTPUT_MODES_COUNT, 1);
+	mockAudio.SetGeneralProperty(XN_PROP_WAVE_SUPPORTED_OUTPUT_MODES, sizeof(mode), &mode);
+	nRetVal = mockAudio.SetIntProperty(XN_PROP_STATE_READY, TRUE);
+	CHECK_RC(nRetVal, "Set mock audio state");
+
+	return XN_STATUS_OK;
+}
+
+MockWorkload::MockWorkload() :
+	m_nXRes(0),
+	m_nYRes(0),
+	m_nFPS(0),
+	m_nDepthCount(0),
+	m_nImageCount(0),
+	m_pDepths(NULL),
+	m_pImages(NULL),
+	m_pDepthFrame(NULL),
+	m_pImageFrame(NULL),
+	m_nFrameID(0)
+{
+}
+
+MockWorkload::~MockWorkload()
+{
+	Release();
+}
+
+XnStatus MockWorkload::Init(xn::Context& context, const BenchmarkConfig& config)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	m_nXRes = config.nXRes;
+	m_nYRes = config.nYRes;
+	m_nFPS = config.nFPS;
+	m_nFrameID = 0;
+
+	m_pDepthFrame = XN_NEW_ARR(XnDepthPixel, m_nXRes * m_nYRes);
+	XN_VALIDATE_ALLOC_PTR(m_pDepthFrame);
+	m_pImageFrame = XN_NEW_ARR(XnUInt8, m_nXRes * m_nYRes * sizeof(XnRGB24Pixel));
+	XN_VALIDATE_ALLOC_PTR(m_pImageFrame);
+	fillDepthFrame(m_pDepthFrame, m_nXRes, m_nYRes, 0);
+	fillImageFrame(m_pImageFrame, m_nXRes, m_nYRes, sizeof(XnRGB24Pixel), 0);
+
+	m_pDepths = XN_NEW_ARR(xn::MockDepthGenerator, config.nDepthStreams);
+	m_pImages = XN_NEW_ARR(xn::MockImageGenerator, config.nImageStreams);
+
+	XnChar strName[XN_MAX_NAME_LENGTH];
+	XnUInt32 nCharsWritten = 0;
+
+	for (m_nDepthCount = 0; m_nDepthCount < config.nDepthStreams; ++m_nDepthCount)
+	{
+		xnOSStrFormat(strName, sizeof(strName), &nCharsWritten, "BenchmarkDepth%u", m_nDepthCount);
+		nRetVal = createMockDepth(context, strName, config, m_pDepths[m_nDepthCount]);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	for (m_nImageCount = 0; m_nImageCount < config.nImageStreams; ++m_nImageCount)
+	{
+		xnOSStrFormat(strName, sizeof(strName), &nCharsWritten, "BenchmarkImage%u", m_nImageCount);
+		nRetVal = createMockImage(context, strName, config, XN_PIXEL_FORMAT_RGB24, m_pImages[m_nImageCount]);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
+
+void MockWorkload::Release()
+{
+	for (XnUInt32 i = 0; i < m_nDepthCount; ++i)
+	{
+		m_pDepths[i].Release();
+	}
+	for (XnUInt32 i = 0; i < m_nImageCount; ++i)
+	{
+		m_pImages[i].Release();
+	}
+	m_nDepthCount = 0;
+	m_nImageCount = 0;
+
+	XN_DELETE_ARR(m_pDepths);
+	m_pDepths = NULL;
+	XN_DELETE_ARR(m_pImages);
+	m_pImages = NULL;
+	XN_DELETE_ARR(m_pDepthFrame);
+	m_pDepthFrame = NULL;
+	XN_DELETE_ARR(m_pImageFrame);
+	m_pImageFrame = NULL;
+}
+
+XnStatus MockWorkload::PushNextFrame(XnBool bMakeCurrent)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	++m_nFrameID;
+	XnUInt64 nTimestamp = (XnUInt64)m_nFrameID * 1000000 / m_nFPS;
+
+	// touch the data so that every frame differs, without paying for a full refill
+	m_pDepthFrame[0] = (XnDepthPixel)m_nFrameID;
+	m_pImageFrame[0] = (XnUInt8)m_nFrameID;
+
+	for (XnUInt32 i = 0; i < m_nDepthCount; ++i)
+	{
+		if (bMakeCurrent)
+		{
+			nRetVal = m_pDepths[i].SetData(m_nFrameID, nTimestamp, GetDepthFrameSize(), m_pDepthFrame);
+		}
+		else
+		{
+			nRetVal = PushData(m_pDepths[i], nTimestamp, GetDepthFrameSize(), m_pDepthFrame);
+		}
+		CHECK_RC(nRetVal, "Set mock depth data");
+	}
+
+	for (XnUInt32 i = 0; i < m_nImageCount; ++i)
+	{
+		if (bMakeCurrent)
+		{
+			nRetVal = m_pImages[i].SetData(m_nFrameID, nTimestamp, GetImageFrameSize(), m_pImageFrame);
+		}
+		else
+		{
+			nRetVal = PushData(m_pImages[i], nTimestamp, GetImageFrameSize(), m_pImageFrame);
+		}
+		CHECK_RC(nRetVal, "Set mock image data");
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus MockWorkload::PushData(xn::ProductionNode& node, XnUInt64 nTimestamp, XnUInt32 nSize, const void* pData)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// same as xnMockSetData(), without the update that makes the data current
+	nRetVal = node.SetGeneralProperty(XN_PROP_NEWDATA, nSize, pData);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = node.SetIntProperty(XN_PROP_FRAME_ID, m_nFrameID);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = node.SetIntProperty(XN_PROP_TIMESTAMP, nTimestamp);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return XN_STATUS_OK;
+}
+
+XnUInt32 MockWorkload::GetBytesPerFrame() const
+{
+	return m_nDepthCount * GetDepthFrameSize() + m_nImageCount * GetImageFrameSize();
+}
+
+//---------------------------------------------------------------------------
+// Results
+//---------------------------------------------------------------------------
+XnStatus BenchmarkResults::Add(const XnChar* strGroup, const XnChar* strName, const XnChar* strVariant, XnDouble dValue, const XnChar* strUnit)
+{
+	BenchmarkResult result;
+	xnOSMemSet(&result, 0, sizeof(result));
+	xnOSStrCopy(result.strGroup, strGroup, sizeof(result.strGroup));
+	xnOSStrCopy(result.strName, strName, sizeof(result.strName));
+	xnOSStrCopy(result.strVariant, (strVariant == NULL) ? "" : strVariant, sizeof(result.strVariant));
+	xnOSStrCopy(result.strUnit, strUnit, sizeof(result.strUnit));
+	result.dValue = dValue;
+
+	// progress goes to stderr, so that stdout stays valid JSON
+	fprintf(stderr, "%-10s %-28s %-14s %14.3f %s\n", strGroup, strName, result.strVariant, dValue, strUnit);
+
+	return m_results.AddLast(result);
+}
+
+XnStatus BenchmarkResults::WriteJSON(FILE* pFile, const BenchmarkConfig& config) const
+{
+	XnVersion version;
+	xnGetVersion(&version);
+
+	fprintf(pFile, "{\n");
+	fprintf(pFile, "\t\"openni_version\": \"%u.%u.%u.%u\",\n", version.nMajor, version.nMinor, version.nMaintenance, version.nBuild);
+	fprintf(pFile, "\t\"config\": {\n");
+	fprintf(pFile, "\t\t\"x_res\": %u,\n", config.nXRes);
+	fprintf(pFile, "\t\t\"y_res\": %u,\n", config.nYRes);
+	fprintf(pFile, "\t\t\"fps\": %u,\n", config.nFPS);
+	fprintf(pFile, "\t\t\"frames\": %u,\n", config.nFrames);
+	fprintf(pFile, "\t\t\"depth_streams\": %u,\n", config.nDepthStreams);
+	fprintf(pFile, "\t\t\"image_streams\": %u,\n", config.nImageStreams);
+	fprintf(pFile, "\t\t\"iterations\": %u\n", config.nIterations);
+	fprintf(pFile, "\t},\n");
+	fprintf(pFile, "\t\"results\": [");
+
+	// names are plain identifiers chosen by the benchmarks, so no escaping is needed
+	for (XnUInt32 i = 0; i < m_results.GetSize(); ++i)
+	{
+		const BenchmarkResult& result = m_results[i];
+		fprintf(pFile, "%s\n\t\t{ \"group\": \"%s\", \"name\": \"%s\", \"variant\": \"%s\", \"value\": %.6g, \"unit\": \"%s\" }",
+			(i == 0) ? "" : ",", result.strGroup, result.strName, result.strVariant, result.dValue, result.strUnit);
+	}
+
+	fprintf(pFile, "\n\t]\n");
+	fprintf(pFile, "}\n");
+
+	return (ferror(pFile) == 0) ? XN_STATUS_OK : XN_STATUS_OS_FILE_WRITE_FAILED;
+}
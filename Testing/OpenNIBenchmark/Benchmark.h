@@ -0,0 +1,160 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include <XnCppWrapper.h>
+#include <XnArray.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define BENCHMARK_MAX_NAME			64
+
+//---------------------------------------------------------------------------
+// Macros
+//---------------------------------------------------------------------------
+#define CHECK_RC(rc, what)													\
+	if (rc != XN_STATUS_OK)													\
+	{																		\
+		fprintf(stderr, "%s failed: %s\n", what, xnGetStatusString(rc));	\
+		return rc;															\
+	}
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef struct BenchmarkConfig
+{
+	XnUInt32 nXRes;
+	XnUInt32 nYRes;
+	XnUInt32 nFPS;
+	/** Number of frames each throughput / latency run pushes through. */
+	XnUInt32 nFrames;
+	XnUInt32 nDepthStreams;
+	XnUInt32 nImageStreams;
+	/** Number of times each codec is run over the same frame. */
+	XnUInt32 nIterations;
+	/** Directory for temporary recordings. */
+	const XnChar* strTempDir;
+} BenchmarkConfig;
+
+typedef struct BenchmarkResult
+{
+	XnChar strGroup[BENCHMARK_MAX_NAME];
+	XnChar strName[BENCHMARK_MAX_NAME];
+	XnChar strVariant[BENCHMARK_MAX_NAME];
+	XnDouble dValue;
+	XnChar strUnit[BENCHMARK_MAX_NAME];
+} BenchmarkResult;
+
+/** Collects the measurements of all benchmarks and writes them as one JSON document. */
+class BenchmarkResults
+{
+public:
+	XnStatus Add(const XnChar* strGroup, const XnChar* strName, const XnChar* strVariant, XnDouble dValue, const XnChar* strUnit);
+	XnStatus WriteJSON(FILE* pFile, const BenchmarkConfig& config) const;
+
+private:
+	XnArray<BenchmarkResult> m_results;
+};
+
+/** A set of mock generators fed with synthetic frames. */
+class MockWorkload
+{
+public:
+	MockWorkload();
+	~MockWorkload();
+
+	XnStatus Init(xn::Context& context, const BenchmarkConfig& config);
+	void Release();
+
+	/** Pushes the next synthetic frame into every mock node, making it the current data. */
+	XnStatus SetNextFrame() { return PushNextFrame(TRUE); }
+
+	/**
+	* Pushes the next synthetic frame into every mock node as pending data, the way the player
+	* feeds its nodes, so that the next context update picks it up.
+	*/
+	XnStatus QueueNextFrame() { return PushNextFrame(FALSE); }
+
+	XnUInt32 GetDepthCount() const { return m_nDepthCount; }
+	XnUInt32 GetImageCount() const { return m_nImageCount; }
+	xn::MockDepthGenerator& GetDepth(XnUInt32 i) { return m_pDepths[i]; }
+	xn::MockImageGenerator& GetImage(XnUInt32 i) { return m_pImages[i]; }
+
+	/** Size, in bytes, of one frame of all streams together. */
+	XnUInt32 GetBytesPerFrame() const;
+
+	const XnDepthPixel* GetDepthFrame() const { return m_pDepthFrame; }
+	XnUInt32 GetDepthFrameSize() const { return m_nXRes * m_nYRes * sizeof(XnDepthPixel); }
+	const XnUInt8* GetImageFrame() const { return m_pImageFrame; }
+	XnUInt32 GetImageFrameSize() const { return m_nXRes * m_nYRes * sizeof(XnRGB24Pixel); }
+
+private:
+	XnStatus PushNextFrame(XnBool bMakeCurrent);
+	XnStatus PushData(xn::ProductionNode& node, XnUInt64 nTimestamp, XnUInt32 nSize, const void* pData);
+
+	XnUInt32 m_nXRes;
+	XnUInt32 m_nYRes;
+	XnUInt32 m_nFPS;
+	XnUInt32 m_nDepthCount;
+	XnUInt32 m_nImageCount;
+	xn::MockDepthGenerator* m_pDepths;
+	xn::MockImageGenerator* m_pImages;
+	XnDepthPixel* m_pDepthFrame;
+	XnUInt8* m_pImageFrame;
+	XnUInt32 m_nFrameID;
+};
+
+//---------------------------------------------------------------------------
+// Functions
+//---------------------------------------------------------------------------
+XnStatus createMockDepth(xn::Context& context, const XnChar* strName, const BenchmarkConfig& config, xn::MockDepthGenerator& mockDepth);
+XnStatus createMockImage(xn::Context& context, const XnChar* strName, const BenchmarkConfig& config, XnPixelFormat format, xn::MockImageGenerator& mockImage);
+XnStatus createMockAudio(xn::Context& context, const XnChar* strName, const XnWaveOutputMode& mode, xn::MockAudioGenerator& mockAudio);
+
+/** Fills a depth map with a smooth synthetic scene, which compresses like real depth data does. */
+void fillDepthFrame(XnDepthPixel* pDepth, XnUInt32 nXRes, XnUInt32 nYRes, XnUInt32 nFrame);
+/** Fills an image with a synthetic gradient. */
+void fillImageFrame(XnUInt8* pImage, XnUInt32 nXRes, XnUInt32 nYRes, XnUInt32 nBytesPerPixel, XnUInt32 nFrame);
+/** Fills interleaved 16 bit samples with a few tones, mixed differently into every channel, and a little hiss. */
+void fillAudioFrame(XnInt16* pSamples, const XnWaveOutputMode& mode, XnUInt32 nSamplesPerChannel, XnUInt32 nFrame);
+
+/** Number of C++ heap allocations made so far, by any thread. */
+XnUInt64 benchmarkGetAllocationCount();
+
+/** Returns the value at the given percentile (0-100) of the samples. Sorts the samples. */
+XnUInt64 benchmarkPercentile(XnUInt64* pSamples, XnUInt32 nCount, XnDouble dPercentile);
+
+XnStatus runCodecBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runRecordingBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runUpdateBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runEventBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runSyncBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runPixelBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runRegistrationBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+XnStatus runUSBBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results);
+
+#endif // __BENCHMARK_H__
@@ -0,0 +1,203 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/* A microphone array: 4 channels at 48kHz, coded 100ms at a time. */
+#define CODEC_AUDIO_SAMPLE_RATE		48000
+#define CODEC_AUDIO_CHANNELS		4
+#define CODEC_AUDIO_FRAME_SAMPLES	4800
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef enum
+{
+	CODEC_INPUT_DEPTH,
+	CODEC_INPUT_RGB24,
+	CODEC_INPUT_GRAYSCALE8,
+	CODEC_INPUT_YUV422,
+	CODEC_INPUT_AUDIO,
+} CodecInput;
+
+typedef struct CodecInfo
+{
+	XnCodecID codecID;
+	const XnChar* strName;
+	CodecInput input;
+} CodecInfo;
+
+//---------------------------------------------------------------------------
+// Globals
+//---------------------------------------------------------------------------
+static CodecInfo g_codecs[] =
+{
+	{ XN_CODEC_UNCOMPRESSED, "NONE", CODEC_INPUT_DEPTH },
+	{ XN_CODEC_16Z, "16zP", CODEC_INPUT_DEPTH },
+	{ XN_CODEC_16Z_EMB_TABLES, "16zT", CODEC_INPUT_DEPTH },
+	{ XN_CODEC_16Z_ANS, "16zA", CODEC_INPUT_DEPTH },
+	{ XN_CODEC_8Z, "Im8z", CODEC_INPUT_GRAYSCALE8 },
+	{ XN_CODEC_JPEG, "JPEG", CODEC_INPUT_RGB24 },
+	{ XN_CODEC_8Z, "Im8z-rgb", CODEC_INPUT_RGB24 },
+	{ XN_CODEC_IMAGE_LOSSLESS, "ImLL", CODEC_INPUT_GRAYSCALE8 },
+	{ XN_CODEC_IMAGE_LOSSLESS, "ImLL-rgb", CODEC_INPUT_RGB24 },
+	{ XN_CODEC_IMAGE_LOSSLESS, "ImLL-yuv", CODEC_INPUT_YUV422 },
+	{ XN_CODEC_AUDIO_LOSSLESS, "AuLL", CODEC_INPUT_AUDIO },
+};
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XnStatus runCodecBenchmark(const BenchmarkConfig& config, const CodecInfo& codecInfo, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	xn::Context context;
+	nRetVal = context.Init();
+	CHECK_RC(nRetVal, "Init");
+
+	// the codec takes its parameters (resolution, pixel format) from the node it is created for
+	xn::MockDepthGenerator mockDepth;
+	xn::MockImageGenerator mockImage;
+	xn::MockAudioGenerator mockAudio;
+	xn::ProductionNode* pInitializer = NULL;
+	XnUInt32 nFrameSize = 0;
+	XnUInt8* pFrame = NULL;
+
+	if (codecInfo.input == CODEC_INPUT_DEPTH)
+	{
+		nRetVal = createMockDepth(context, "CodecDepth", config, mockDepth);
+		XN_IS_STATUS_OK(nRetVal);
+		pInitializer = &mockDepth;
+		nFrameSize = config.nXRes * config.nYRes * sizeof(XnDepthPixel);
+		pFrame = XN_NEW_ARR(XnUInt8, nFrameSize);
+		XN_VALIDATE_ALLOC_PTR(pFrame);
+		fillDepthFrame((XnDepthPixel*)pFrame, config.nXRes, config.nYRes, 0);
+	}
+	else if (codecInfo.input == CODEC_INPUT_AUDIO)
+	{
+		XnWaveOutputMode mode = { CODEC_AUDIO_SAMPLE_RATE, 16, CODEC_AUDIO_CHANNELS };
+		nRetVal = createMockAudio(context, "CodecAudio", mode, mockAudio);
+		XN_IS_STATUS_OK(nRetVal);
+		pInitializer = &mockAudio;
+		nFrameSize = CODEC_AUDIO_FRAME_SAMPLES * CODEC_AUDIO_CHANNELS * sizeof(XnInt16);
+		pFrame = XN_NEW_ARR(XnUInt8, nFrameSize);
+		XN_VALIDATE_ALLOC_PTR(pFrame);
+		fillAudioFrame((XnInt16*)pFrame, mode, CODEC_AUDIO_FRAME_SAMPLES, 0);
+	}
+	else
+	{
+		XnPixelFormat format = XN_PIXEL_FORMAT_GRAYSCALE_8_BIT;
+		if (codecInfo.input == CODEC_INPUT_RGB24)
+		{
+			format = XN_PIXEL_FORMAT_RGB24;
+		}
+		else if (codecInfo.input == CODEC_INPUT_YUV422)
+		{
+			format = XN_PIXEL_FORMAT_YUV422;
+		}
+		XnUInt32 nBytesPerPixel = xnGetBytesPerPixelForPixelFormat(format);
+		nRetVal = createMockImage(context, "CodecImage", config, format, mockImage);
+		XN_IS_STATUS_OK(nRetVal);
+		pInitializer = &mockImage;
+		nFrameSize = config.nXRes * config.nYRes * nBytesPerPixel;
+		pFrame = XN_NEW_ARR(XnUInt8, nFrameSize);
+		XN_VALIDATE_ALLOC_PTR(pFrame);
+		fillImageFrame(pFrame, config.nXRes, config.nYRes, nBytesPerPixel, 0);
+	}
+
+	xn::Codec codec;
+	nRetVal = context.CreateCodec(codecInfo.codecID, *pInitializer, codec);
+	CHECK_RC(nRetVal, "Create codec");
+
+	// leave room for codecs that expand incompressible data
+	XnUInt32 nEncodedBufferSize = nFrameSize * 2 + 1024;
+	XnUInt8* pEncoded = XN_NEW_ARR(XnUInt8, nEncodedBufferSize);
+	XN_VALIDATE_ALLOC_PTR(pEncoded);
+	XnUInt8* pDecoded = XN_NEW_ARR(XnUInt8, nFrameSize);
+	XN_VALIDATE_ALLOC_PTR(pDecoded);
+
+	XnUInt nEncodedSize = 0;
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+
+	xnOSGetHighResTimeStamp(&nStart);
+	for (XnUInt32 i = 0; i < config.nIterations; ++i)
+	{
+		nRetVal = codec.EncodeData(pFrame, nFrameSize, pEncoded, nEncodedBufferSize, &nEncodedSize);
+		CHECK_RC(nRetVal, "Encode");
+	}
+	xnOSGetHighResTimeStamp(&nEnd);
+	XnDouble dEncodeSeconds = (nEnd - nStart) / 1e6;
+
+	XnUInt nDecodedSize = 0;
+	xnOSGetHighResTimeStamp(&nStart);
+	for (XnUInt32 i = 0; i < config.nIterations; ++i)
+	{
+		nRetVal = codec.DecodeData(pEncoded, nEncodedSize, pDecoded, nFrameSize, &nDecodedSize);
+		CHECK_RC(nRetVal, "Decode");
+	}
+	xnOSGetHighResTimeStamp(&nEnd);
+	XnDouble dDecodeSeconds = (nEnd - nStart) / 1e6;
+
+	// throughput is always in terms of raw (uncompressed) data, so that codecs are comparable
+	XnDouble dMegabytes = (XnDouble)nFrameSize * config.nIterations / (1024 * 1024);
+	results.Add("codec", "encode_throughput", codecInfo.strName, dMegabytes / dEncodeSeconds, "MB/s");
+	results.Add("codec", "decode_throughput", codecInfo.strName, dMegabytes / dDecodeSeconds, "MB/s");
+	results.Add("codec", "compression_ratio", codecInfo.strName, (XnDouble)nFrameSize / nEncodedSize, "ratio");
+
+	if (codecInfo.input == CODEC_INPUT_AUDIO)
+	{
+		// how many times faster than the audio plays, on one core
+		XnDouble dAudioSeconds = (XnDouble)CODEC_AUDIO_FRAME_SAMPLES * config.nIterations / CODEC_AUDIO_SAMPLE_RATE;
+		results.Add("codec", "encode_realtime_factor", codecInfo.strName, dAudioSeconds / dEncodeSeconds, "x");
+		results.Add("codec", "decode_realtime_factor", codecInfo.strName, dAudioSeconds / dDecodeSeconds, "x");
+	}
+
+	XN_DELETE_ARR(pDecoded);
+	XN_DELETE_ARR(pEncoded);
+	XN_DELETE_ARR(pFrame);
+	codec.Release();
+	mockDepth.Release();
+	mockImage.Release();
+	mockAudio.Release();
+	context.Release();
+
+	return XN_STATUS_OK;
+}
+
+XnStatus runCodecBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	for (XnUInt32 i = 0; i < sizeof(g_codecs) / sizeof(g_codecs[0]); ++i)
+	{
+		nRetVal = runCodecBenchmark(config, g_codecs[i], results);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+#include <XnEventT.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define EVENT_BENCHMARK_RAISES			1000000
+#define EVENT_BENCHMARK_MAX_HANDLERS	8
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static void XN_CALLBACK_TYPE CountingHandler(void* pCookie)
+{
+	++*(volatile XnUInt32*)pCookie;
+}
+
+static XnStatus runEventBenchmark(XnUInt32 nHandlers, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnEventNoArgs event;
+	XnCallbackHandle ahCallbacks[EVENT_BENCHMARK_MAX_HANDLERS];
+	volatile XnUInt32 nCalls = 0;
+
+	for (XnUInt32 i = 0; i < nHandlers; ++i)
+	{
+		nRetVal = event.Register(CountingHandler, (void*)&nCalls, ahCallbacks[i]);
+		CHECK_RC(nRetVal, "Register to event");
+	}
+
+	XnUInt64 nAllocationsBefore = benchmarkGetAllocationCount();
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	for (XnUInt32 i = 0; i < EVENT_BENCHMARK_RAISES; ++i)
+	{
+		event.Raise();
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+	XnUInt64 nAllocations = benchmarkGetAllocationCount() - nAllocationsBefore;
+
+	if (nCalls != nHandlers * EVENT_BENCHMARK_RAISES)
+	{
+		fprintf(stderr, "Event handlers were called %u times instead of %u\n", (XnUInt32)nCalls, nHandlers * EVENT_BENCHMARK_RAISES);
+		return XN_STATUS_ERROR;
+	}
+
+	XnChar strVariant[BENCHMARK_MAX_NAME];
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(strVariant, sizeof(strVariant), &nCharsWritten, "%u_handlers", nHandlers);
+
+	results.Add("event", "raise_cost", strVariant, (nEnd - nStart) * 1000.0 / EVENT_BENCHMARK_RAISES, "ns");
+	results.Add("event", "allocations_per_raise", strVariant, (XnDouble)nAllocations / EVENT_BENCHMARK_RAISES, "allocations");
+
+	for (XnUInt32 i = 0; i < nHandlers; ++i)
+	{
+		event.Unregister(ahCallbacks[i]);
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus runEventBenchmarks(const BenchmarkConfig& /*config*/, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt32 anHandlers[] = { 0, 1, EVENT_BENCHMARK_MAX_HANDLERS };
+	for (XnUInt32 i = 0; i < sizeof(anHandlers) / sizeof(anHandlers[0]); ++i)
+	{
+		nRetVal = runEventBenchmark(anHandlers[i], results);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
@@ -0,0 +1,242 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+typedef XnStatus (*BenchmarkFunc)(const BenchmarkConfig& config, BenchmarkResults& results);
+
+typedef struct BenchmarkGroup
+{
+	const XnChar* strName;
+	BenchmarkFunc pFunc;
+	XnBool bSelected;
+} BenchmarkGroup;
+
+//---------------------------------------------------------------------------
+// Globals
+//---------------------------------------------------------------------------
+static BenchmarkGroup g_groups[] =
+{
+	{ "codec", runCodecBenchmarks, FALSE },
+	{ "recording", runRecordingBenchmarks, FALSE },
+	{ "update", runUpdateBenchmarks, FALSE },
+	{ "event", runEventBenchmarks, FALSE },
+	{ "sync", runSyncBenchmarks, FALSE },
+	{ "pixel", runPixelBenchmarks, FALSE },
+	{ "registration", runRegistrationBenchmarks, FALSE },
+	{ "usb", runUSBBenchmarks, FALSE },
+};
+
+static const XnUInt32 g_nGroups = sizeof(g_groups) / sizeof(g_groups[0]);
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static void printUsage(const XnChar* strProgram)
+{
+	fprintf(stderr, "usage: %s [options] [group...]\n", strProgram);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Runs OpenNI performance benchmarks on mock nodes (no device needed) and writes the\n");
+	fprintf(stderr, "results as JSON. Groups: codec, recording, update, event, sync, pixel,\n");
+	fprintf(stderr, "registration, usb (default: all).\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  --width <n>        frame width (default 640)\n");
+	fprintf(stderr, "  --height <n>       frame height (default 480)\n");
+	fprintf(stderr, "  --fps <n>          frame rate of the mock streams (default 30)\n");
+	fprintf(stderr, "  --frames <n>       frames per recording / update run (default 300)\n");
+	fprintf(stderr, "  --depth <n>        number of mock depth streams (default 1)\n");
+	fprintf(stderr, "  --image <n>        number of mock RGB streams (default 1)\n");
+	fprintf(stderr, "  --iterations <n>   codec runs per codec (default 100)\n");
+	fprintf(stderr, "  --temp-dir <dir>   where temporary recordings go (default .)\n");
+	fprintf(stderr, "  --output <file>    write JSON there instead of to stdout\n");
+	fprintf(stderr, "  --quick            small, fast run for smoke testing\n");
+}
+
+static XnBool parseNumber(const XnChar* strValue, XnUInt32& nValue)
+{
+	if (strValue == NULL)
+	{
+		return FALSE;
+	}
+
+	XnChar* pEnd = NULL;
+	unsigned long nParsed = strtoul(strValue, &pEnd, 10);
+	if (pEnd == strValue || *pEnd != '\0')
+	{
+		return FALSE;
+	}
+
+	nValue = (XnUInt32)nParsed;
+	return TRUE;
+}
+
+int main(int argc, char* argv[])
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	BenchmarkConfig config;
+	config.nXRes = 640;
+	config.nYRes = 480;
+	config.nFPS = 30;
+	config.nFrames = 300;
+	config.nDepthStreams = 1;
+	config.nImageStreams = 1;
+	config.nIterations = 100;
+	config.strTempDir = ".";
+
+	const XnChar* strOutput = NULL;
+	XnBool bAnySelected = FALSE;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const XnChar* strArg = argv[i];
+		const XnChar* strValue = (i + 1 < argc) ? argv[i + 1] : NULL;
+		XnBool bValid = TRUE;
+
+		if (strcmp(strArg, "--width") == 0)
+		{
+			bValid = parseNumber(strValue, config.nXRes) && config.nXRes > 0;
+			++i;
+		}
+		else if (strcmp(strArg, "--height") == 0)
+		{
+			bValid = parseNumber(strValue, config.nYRes) && config.nYRes > 0;
+			++i;
+		}
+		else if (strcmp(strArg, "--fps") == 0)
+		{
+			bValid = parseNumber(strValue, config.nFPS) && config.nFPS > 0;
+			++i;
+		}
+		else if (strcmp(strArg, "--frames") == 0)
+		{
+			bValid = parseNumber(strValue, config.nFrames) && config.nFrames > 0;
+			++i;
+		}
+		else if (strcmp(strArg, "--depth") == 0)
+		{
+			bValid = parseNumber(strValue, config.nDepthStreams);
+			++i;
+		}
+		else if (strcmp(strArg, "--image") == 0)
+		{
+			bValid = parseNumber(strValue, config.nImageStreams);
+			++i;
+		}
+		else if (strcmp(strArg, "--iterations") == 0)
+		{
+			bValid = parseNumber(strValue, config.nIterations) && config.nIterations > 0;
+			++i;
+		}
+		else if (strcmp(strArg, "--temp-dir") == 0)
+		{
+			bValid = (strValue != NULL);
+			config.strTempDir = strValue;
+			++i;
+		}
+		else if (strcmp(strArg, "--output") == 0)
+		{
+			bValid = (strValue != NULL);
+			strOutput = strValue;
+			++i;
+		}
+		else if (strcmp(strArg, "--quick") == 0)
+		{
+			config.nXRes = 320;
+			config.nYRes = 240;
+			config.nFrames = 30;
+			config.nIterations = 10;
+		}
+		else
+		{
+			bValid = FALSE;
+			for (XnUInt32 j = 0; j < g_nGroups; ++j)
+			{
+				if (strcmp(strArg, g_groups[j].strName) == 0)
+				{
+					g_groups[j].bSelected = TRUE;
+					bAnySelected = TRUE;
+					bValid = TRUE;
+				}
+			}
+		}
+
+		if (!bValid)
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (config.nDepthStreams + config.nImageStreams == 0)
+	{
+		fprintf(stderr, "At least one mock stream is needed\n");
+		return 1;
+	}
+
+	BenchmarkResults results;
+
+	for (XnUInt32 i = 0; i < g_nGroups; ++i)
+	{
+		if (bAnySelected && !g_groups[i].bSelected)
+		{
+			continue;
+		}
+
+		nRetVal = g_groups[i].pFunc(config, results);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			fprintf(stderr, "Benchmark group '%s' failed: %s\n", g_groups[i].strName, xnGetStatusString(nRetVal));
+			return 2;
+		}
+	}
+
+	FILE* pFile = stdout;
+	if (strOutput != NULL)
+	{
+		pFile = fopen(strOutput, "w");
+		if (pFile == NULL)
+		{
+			fprintf(stderr, "Failed to open %s for writing\n", strOutput);
+			return 3;
+		}
+	}
+
+	nRetVal = results.WriteJSON(pFile, config);
+
+	if (pFile != stdout)
+	{
+		fclose(pFile);
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		fprintf(stderr, "Failed to write results: %s\n", xnGetStatusString(nRetVal));
+		return 3;
+	}
+
+	return 0;
+}
@@ -0,0 +1,277 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define PIXEL_BENCHMARK_MAX_DEPTH	10000
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/** Frame buffers shared by all conversions. */
+typedef struct PixelBuffers
+{
+	XnUInt32 nPixels;
+	XnUInt8* pYUV;
+	XnUInt16* pGray16;
+	XnDepthPixel* pDepth;
+	XnFloat* pHistogram;
+	XnUInt8* pOutput;
+} PixelBuffers;
+
+typedef void (*PixelConversionFunc)(PixelBuffers& buffers);
+
+typedef struct PixelConversion
+{
+	const XnChar* strName;
+	PixelConversionFunc pReference;
+	PixelConversionFunc pUtils;
+} PixelConversion;
+
+//---------------------------------------------------------------------------
+// Reference Implementations
+//---------------------------------------------------------------------------
+// Straightforward per-pixel loops, the way NiViewer used to convert frames.
+
+static void referenceYUVToRGB(XnUInt8 nY, XnUInt8 nU, XnUInt8 nV, XnUInt8* pRGB)
+{
+	XnInt32 nC = (nY - 16) * 298 + 128;
+	XnInt16 nD = nU - 128;
+	XnInt16 nE = nV - 128;
+
+	pRGB[0] = XN_MIN(XN_MAX((nC            + 409 * nE) >> 8, 0), 255);
+	pRGB[1] = XN_MIN(XN_MAX((nC - 100 * nD - 208 * nE) >> 8, 0), 255);
+	pRGB[2] = XN_MIN(XN_MAX((nC + 516 * nD           ) >> 8, 0), 255);
+}
+
+static void referenceYUV422ToRGB(PixelBuffers& buffers, XnUInt32 nBytesPerPixel)
+{
+	const XnUInt8* pYUV = buffers.pYUV;
+	XnUInt8* pOutput = buffers.pOutput;
+	for (XnUInt32 i = 0; i < buffers.nPixels; i += 2, pYUV += 4)
+	{
+		referenceYUVToRGB(pYUV[1], pYUV[0], pYUV[2], pOutput);
+		if (nBytesPerPixel == 4)
+		{
+			pOutput[3] = 255;
+		}
+		pOutput += nBytesPerPixel;
+		referenceYUVToRGB(pYUV[3], pYUV[0], pYUV[2], pOutput);
+		if (nBytesPerPixel == 4)
+		{
+			pOutput[3] = 255;
+		}
+		pOutput += nBytesPerPixel;
+	}
+}
+
+static void referenceYUV422ToRGBA32(PixelBuffers& buffers)
+{
+	referenceYUV422ToRGB(buffers, 4);
+}
+
+static void referenceYUV422ToRGB24(PixelBuffers& buffers)
+{
+	referenceYUV422ToRGB(buffers, 3);
+}
+
+static void referenceGray16ToGray8(PixelBuffers& buffers)
+{
+	XnUInt16 nMax = 0;
+	for (XnUInt32 i = 0; i < buffers.nPixels; ++i)
+	{
+		if (buffers.pGray16[i] > nMax)
+		{
+			nMax = buffers.pGray16[i];
+		}
+	}
+
+	XnDouble dFactor = (nMax > 0) ? 255.0 / nMax : 1.0;
+	for (XnUInt32 i = 0; i < buffers.nPixels; ++i)
+	{
+		buffers.pOutput[i] = (XnUInt8)(buffers.pGray16[i] * dFactor);
+	}
+}
+
+static void referenceDepthHistogram(PixelBuffers& buffers)
+{
+	XnFloat* pHistogram = buffers.pHistogram;
+	xnOSMemSet(pHistogram, 0, (PIXEL_BENCHMARK_MAX_DEPTH + 1) * sizeof(XnFloat));
+
+	XnUInt32 nPoints = 0;
+	for (XnUInt32 i = 0; i < buffers.nPixels; ++i)
+	{
+		if (buffers.pDepth[i] != 0)
+		{
+			pHistogram[buffers.pDepth[i]]++;
+			nPoints++;
+		}
+	}
+
+	for (XnUInt32 i = 1; i <= PIXEL_BENCHMARK_MAX_DEPTH; ++i)
+	{
+		pHistogram[i] += pHistogram[i - 1];
+	}
+	for (XnUInt32 i = 1; i <= PIXEL_BENCHMARK_MAX_DEPTH; ++i)
+	{
+		if (pHistogram[i] != 0)
+		{
+			pHistogram[i] = (nPoints - pHistogram[i]) / nPoints;
+		}
+	}
+}
+
+static void referenceDepthColorize(PixelBuffers& buffers)
+{
+	XnUInt8* pOutput = buffers.pOutput;
+	for (XnUInt32 i = 0; i < buffers.nPixels; ++i, pOutput += 4)
+	{
+		XnDepthPixel nDepth = buffers.pDepth[i];
+		pOutput[0] = pOutput[1] = (XnUInt8)(buffers.pHistogram[nDepth] * 255);
+		pOutput[2] = 0;
+		pOutput[3] = (nDepth == 0) ? 0 : 255;
+	}
+}
+
+//---------------------------------------------------------------------------
+// XnUtils Implementations
+//---------------------------------------------------------------------------
+static void utilsYUV422ToRGBA32(PixelBuffers& buffers)
+{
+	xnConvertYUV422ToRGBA32(buffers.pYUV, buffers.pOutput, buffers.nPixels);
+}
+
+static void utilsYUV422ToRGB24(PixelBuffers& buffers)
+{
+	xnConvertYUV422ToRGB24(buffers.pYUV, buffers.pOutput, buffers.nPixels);
+}
+
+static void utilsGray16ToGray8(PixelBuffers& buffers)
+{
+	XnUInt16 nMin;
+	XnUInt16 nMax;
+	xnGetGray16Range(buffers.pGray16, buffers.nPixels, &nMin, &nMax);
+	xnConvertGray16ToGray8(buffers.pGray16, buffers.pOutput, buffers.nPixels, 0, nMax);
+}
+
+static void utilsDepthHistogram(PixelBuffers& buffers)
+{
+	xnCalculateDepthHistogram(buffers.pDepth, buffers.nPixels, buffers.pHistogram, PIXEL_BENCHMARK_MAX_DEPTH + 1);
+}
+
+static void utilsDepthColorize(PixelBuffers& buffers)
+{
+	XnRGB24Pixel yellow = { 255, 255, 0 };
+	xnColorizeDepthToRGBA32(buffers.pDepth, buffers.nPixels, buffers.pHistogram, PIXEL_BENCHMARK_MAX_DEPTH + 1, yellow, 255, buffers.pOutput);
+}
+
+//---------------------------------------------------------------------------
+// Globals
+//---------------------------------------------------------------------------
+static PixelConversion g_conversions[] =
+{
+	{ "yuv422_to_rgba32", referenceYUV422ToRGBA32, utilsYUV422ToRGBA32 },
+	{ "yuv422_to_rgb24", referenceYUV422ToRGB24, utilsYUV422ToRGB24 },
+	{ "gray16_to_gray8", referenceGray16ToGray8, utilsGray16ToGray8 },
+	{ "depth_histogram", referenceDepthHistogram, utilsDepthHistogram },
+	{ "depth_colorize", referenceDepthColorize, utilsDepthColorize },
+};
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XnDouble timeConversion(const BenchmarkConfig& config, PixelConversionFunc pFunc, PixelBuffers& buffers)
+{
+	// warm up caches and let the conversion pick its implementation
+	pFunc(buffers);
+
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nStart);
+	for (XnUInt32 i = 0; i < config.nIterations; ++i)
+	{
+		pFunc(buffers);
+	}
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	return (nEnd - nStart) / 1e6;
+}
+
+XnStatus runPixelBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	PixelBuffers buffers;
+	buffers.nPixels = config.nXRes * config.nYRes;
+
+	buffers.pYUV = XN_NEW_ARR(XnUInt8, buffers.nPixels * 2);
+	XN_VALIDATE_ALLOC_PTR(buffers.pYUV);
+	buffers.pGray16 = XN_NEW_ARR(XnUInt16, buffers.nPixels);
+	XN_VALIDATE_ALLOC_PTR(buffers.pGray16);
+	buffers.pDepth = XN_NEW_ARR(XnDepthPixel, buffers.nPixels);
+	XN_VALIDATE_ALLOC_PTR(buffers.pDepth);
+	buffers.pHistogram = XN_NEW_ARR(XnFloat, PIXEL_BENCHMARK_MAX_DEPTH + 1);
+	XN_VALIDATE_ALLOC_PTR(buffers.pHistogram);
+	buffers.pOutput = XN_NEW_ARR(XnUInt8, buffers.nPixels * 4);
+	XN_VALIDATE_ALLOC_PTR(buffers.pOutput);
+
+	fillImageFrame(buffers.pYUV, config.nXRes, config.nYRes, 2, 0);
+	fillDepthFrame(buffers.pDepth, config.nXRes, config.nYRes, 0);
+	// an IR-like image: depth values, scaled up to use most of the 16 bits
+	for (XnUInt32 i = 0; i < buffers.nPixels; ++i)
+	{
+		buffers.pGray16[i] = (XnUInt16)(buffers.pDepth[i] * 4);
+		buffers.pDepth[i] = XN_MIN(buffers.pDepth[i], PIXEL_BENCHMARK_MAX_DEPTH);
+	}
+
+	// colorizing reads the histogram, which both histogram implementations leave the same
+	xnCalculateDepthHistogram(buffers.pDepth, buffers.nPixels, buffers.pHistogram, PIXEL_BENCHMARK_MAX_DEPTH + 1);
+
+	XnDouble dMegapixels = (XnDouble)buffers.nPixels * config.nIterations / 1e6;
+
+	for (XnUInt32 i = 0; i < sizeof(g_conversions) / sizeof(g_conversions[0]); ++i)
+	{
+		const PixelConversion& conversion = g_conversions[i];
+
+		XnDouble dReferenceSeconds = timeConversion(config, conversion.pReference, buffers);
+		XnDouble dUtilsSeconds = timeConversion(config, conversion.pUtils, buffers);
+
+		XnChar strName[BENCHMARK_MAX_NAME];
+		XnUInt32 nWritten;
+		xnOSStrFormat(strName, sizeof(strName), &nWritten, "%s_throughput", conversion.strName);
+		results.Add("pixel", strName, "reference", dMegapixels / dReferenceSeconds, "Mpixel/s");
+		results.Add("pixel", strName, "xnUtils", dMegapixels / dUtilsSeconds, "Mpixel/s");
+
+		xnOSStrFormat(strName, sizeof(strName), &nWritten, "%s_speedup", conversion.strName);
+		results.Add("pixel", strName, "xnUtils", dReferenceSeconds / dUtilsSeconds, "ratio");
+	}
+
+	XN_DELETE_ARR(buffers.pOutput);
+	XN_DELETE_ARR(buffers.pHistogram);
+	XN_DELETE_ARR(buffers.pDepth);
+	XN_DELETE_ARR(buffers.pGray16);
+	XN_DELETE_ARR(buffers.pYUV);
+
+	return XN_STATUS_OK;
+}
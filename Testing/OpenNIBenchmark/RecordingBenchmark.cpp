@@ -0,0 +1,266 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+#include <XnPropNames.h>
+#include <XnStringsHashT.h>
+#include <XnHashT.h>
+#include <XnAtoms.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Resolution of the frames that measure the recorder's per-frame overhead, rather than its copying. */
+#define RECORDING_TINY_FRAME_RES		4
+#define RECORDING_NAME_LOOKUPS			1000000
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XnStatus recordWorkload(const BenchmarkConfig& config, const XnChar* strFileName, XnCodecID codecID, const XnChar* strVariant, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	xn::Context context;
+	nRetVal = context.Init();
+	CHECK_RC(nRetVal, "Init");
+
+	MockWorkload workload;
+	nRetVal = workload.Init(context, config);
+	XN_IS_STATUS_OK(nRetVal);
+
+	xn::Recorder recorder;
+	nRetVal = recorder.Create(context);
+	CHECK_RC(nRetVal, "Create recorder");
+
+	nRetVal = recorder.SetDestination(XN_RECORD_MEDIUM_FILE, strFileName);
+	CHECK_RC(nRetVal, "Set recorder destination file");
+
+	for (XnUInt32 i = 0; i < workload.GetDepthCount(); ++i)
+	{
+		nRetVal = recorder.AddNodeToRecording(workload.GetDepth(i), codecID);
+		CHECK_RC(nRetVal, "Add depth node to recording");
+	}
+
+	for (XnUInt32 i = 0; i < workload.GetImageCount(); ++i)
+	{
+		nRetVal = recorder.AddNodeToRecording(workload.GetImage(i), codecID);
+		CHECK_RC(nRetVal, "Add image node to recording");
+	}
+
+	XnUInt64 nAllocationsBefore = benchmarkGetAllocationCount();
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	for (XnUInt32 i = 0; i < config.nFrames; ++i)
+	{
+		nRetVal = workload.SetNextFrame();
+		XN_IS_STATUS_OK(nRetVal);
+
+		nRetVal = recorder.Record();
+		CHECK_RC(nRetVal, "Record");
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+	XnUInt64 nAllocations = benchmarkGetAllocationCount() - nAllocationsBefore;
+
+	XnDouble dSeconds = (nEnd - nStart) / 1e6;
+	XnDouble dMegabytes = (XnDouble)workload.GetBytesPerFrame() * config.nFrames / (1024 * 1024);
+	results.Add("recorder", "frame_rate", strVariant, config.nFrames / dSeconds, "frames/s");
+	results.Add("recorder", "throughput", strVariant, dMegabytes / dSeconds, "MB/s");
+	results.Add("recorder", "allocations_per_frame", strVariant, (XnDouble)nAllocations / config.nFrames, "allocations");
+	results.Add("recorder", "time_per_frame", strVariant, (nEnd - nStart) * 1e3 / config.nFrames, "ns");
+
+	recorder.Release();
+	workload.Release();
+	context.Release();
+
+	return XN_STATUS_OK;
+}
+
+static XnStatus playRecording(const BenchmarkConfig& config, const XnChar* strFileName, const XnChar* strVariant, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	xn::Context context;
+	nRetVal = context.Init();
+	CHECK_RC(nRetVal, "Init");
+
+	xn::Player player;
+	nRetVal = context.OpenFileRecording(strFileName, player);
+	CHECK_RC(nRetVal, "Open recording");
+
+	nRetVal = player.SetRepeat(FALSE);
+	CHECK_RC(nRetVal, "Turn repeat off");
+
+	nRetVal = player.SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST);
+	CHECK_RC(nRetVal, "Set playback speed");
+
+	XnUInt32 nFrames = 0;
+	XnUInt64 nAllocationsBefore = benchmarkGetAllocationCount();
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	while (!player.IsEOF())
+	{
+		nRetVal = context.WaitAndUpdateAll();
+		if (nRetVal == XN_STATUS_EOF)
+		{
+			break;
+		}
+		CHECK_RC(nRetVal, "Wait and update");
+		++nFrames;
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+	XnUInt64 nAllocations = benchmarkGetAllocationCount() - nAllocationsBefore;
+
+	if (nFrames == 0)
+	{
+		fprintf(stderr, "Recording %s has no frames\n", strFileName);
+		return XN_STATUS_ERROR;
+	}
+
+	XnUInt32 nBytesPerFrame = config.nXRes * config.nYRes * (config.nDepthStreams * sizeof(XnDepthPixel) + config.nImageStreams * sizeof(XnRGB24Pixel));
+	XnDouble dSeconds = (nEnd - nStart) / 1e6;
+	XnDouble dMegabytes = (XnDouble)nBytesPerFrame * nFrames / (1024 * 1024);
+	results.Add("player", "frame_rate", strVariant, nFrames / dSeconds, "frames/s");
+	results.Add("player", "throughput", strVariant, dMegabytes / dSeconds, "MB/s");
+	results.Add("player", "allocations_per_frame", strVariant, (XnDouble)nAllocations / nFrames, "allocations");
+
+	player.Release();
+	context.Release();
+
+	return XN_STATUS_OK;
+}
+
+static XnStatus runRecordingBenchmark(const BenchmarkConfig& config, XnCodecID codecID, const XnChar* strVariant, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnChar strFileName[XN_FILE_MAX_PATH];
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(strFileName, sizeof(strFileName), &nCharsWritten, "%s%sOpenNIBenchmark-%s.oni", config.strTempDir, XN_FILE_DIR_SEP, strVariant);
+
+	nRetVal = recordWorkload(config, strFileName, codecID, strVariant, results);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = playRecording(config, strFileName, strVariant, results);
+	}
+
+	xnOSDeleteFile(strFileName);
+
+	return nRetVal;
+}
+
+/*
+* Measures the name lookups the recorder and the mock nodes make for every frame and property: a table keyed
+* by the names themselves against one keyed by their atoms, including the lookup of the atom.
+*/
+static XnStatus measureNameLookups(BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	const XnChar* astrNames[] = 
+	{
+		XN_PROP_NEWDATA, XN_PROP_MAP_OUTPUT_MODE, XN_PROP_CROPPING, XN_PROP_BYTES_PER_PIXEL, XN_PROP_PIXEL_FORMAT,
+		XN_PROP_DEVICE_MAX_DEPTH, XN_PROP_FIELD_OF_VIEW, XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 
+		XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, XN_PROP_MIRROR, XN_PROP_SUPPORTED_USER_POSITIONS_COUNT, XN_PROP_STATE_READY,
+	};
+	const XnUInt32 nNames = sizeof(astrNames) / sizeof(astrNames[0]);
+
+	XnStringsHashT<XnUInt64> byString;
+	XnHashT<XnAtom, XnUInt64> byAtom;
+	for (XnUInt32 i = 0; i < nNames; ++i)
+	{
+		XnAtom atom = XN_INVALID_ATOM;
+		nRetVal = xnAtomIntern(astrNames[i], &atom);
+		CHECK_RC(nRetVal, "Intern name");
+
+		nRetVal = byString.Set(astrNames[i], i);
+		XN_IS_STATUS_OK(nRetVal);
+		nRetVal = byAtom.Set(atom, i);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	// the sums keep the lookups from being optimized away
+	XnUInt64 nStringSum = 0;
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+	for (XnUInt32 i = 0; i < RECORDING_NAME_LOOKUPS; ++i)
+	{
+		XnUInt64 nValue = 0;
+		byString.Get(astrNames[i % nNames], nValue);
+		nStringSum += nValue;
+	}
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+	results.Add("recorder", "name_lookup", "strings", (nEnd - nStart) * 1e3 / RECORDING_NAME_LOOKUPS, "ns");
+
+	XnUInt64 nAtomSum = 0;
+	xnOSGetHighResTimeStamp(&nStart);
+	for (XnUInt32 i = 0; i < RECORDING_NAME_LOOKUPS; ++i)
+	{
+		XnAtom atom = XN_INVALID_ATOM;
+		XnUInt64 nValue = 0;
+		xnAtomFind(astrNames[i % nNames], &atom);
+		byAtom.Get(atom, nValue);
+		nAtomSum += nValue;
+	}
+	xnOSGetHighResTimeStamp(&nEnd);
+	results.Add("recorder", "name_lookup", "atoms", (nEnd - nStart) * 1e3 / RECORDING_NAME_LOOKUPS, "ns");
+
+	if (nStringSum != nAtomSum)
+	{
+		fprintf(stderr, "Name lookups disagree\n");
+		return XN_STATUS_ERROR;
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus runRecordingBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// raw data measures the recording pipeline itself, the default codecs measure what applications get
+	nRetVal = runRecordingBenchmark(config, XN_CODEC_UNCOMPRESSED, "uncompressed", results);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = runRecordingBenchmark(config, XN_CODEC_NULL, "default_codecs", results);
+	XN_IS_STATUS_OK(nRetVal);
+
+	// with almost no data to copy, what's left is the bookkeeping every frame costs
+	BenchmarkConfig tinyConfig = config;
+	tinyConfig.nXRes = RECORDING_TINY_FRAME_RES;
+	tinyConfig.nYRes = RECORDING_TINY_FRAME_RES;
+	nRetVal = runRecordingBenchmark(tinyConfig, XN_CODEC_UNCOMPRESSED, "tiny_frames", results);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = measureNameLookups(results);
+	XN_IS_STATUS_OK(nRetVal);
+
+	return XN_STATUS_OK;
+}
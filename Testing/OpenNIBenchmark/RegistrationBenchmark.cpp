@@ -0,0 +1,110 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+#include <XnDepthRegistration.h>
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+/** A calibration like the ones of PrimeSense-style sensors: both sensors 2.5cm apart, looking the same way. */
+static void fillCalibration(const BenchmarkConfig& config, XnRegistrationCalibration& calibration)
+{
+	xnOSMemSet(&calibration, 0, sizeof(calibration));
+
+	calibration.depth.nXRes = config.nXRes;
+	calibration.depth.nYRes = config.nYRes;
+	calibration.depth.fFocalLengthX = config.nXRes * 0.9;
+	calibration.depth.fFocalLengthY = config.nXRes * 0.9;
+	calibration.depth.fPrincipalPointX = config.nXRes / 2.0;
+	calibration.depth.fPrincipalPointY = config.nYRes / 2.0;
+	calibration.image = calibration.depth;
+	calibration.image.fFocalLengthX = config.nXRes * 0.82;
+	calibration.image.fFocalLengthY = config.nXRes * 0.82;
+
+	calibration.aRotation[0] = calibration.aRotation[4] = calibration.aRotation[8] = 1.0;
+	calibration.aTranslation[0] = -25.0;
+}
+
+static XnStatus timeRegistration(const BenchmarkConfig& config, const XnRegistrationCalibration& calibration, XnUInt32 nThreads, const XnDepthPixel* pDepth, XnDepthPixel* pRegistered, XnDouble* pdSeconds)
+{
+	XnDepthRegistration* pRegistration = NULL;
+	XnStatus nRetVal = xnDepthRegistrationCreate(&calibration, config.nXRes, config.nYRes, config.nXRes, config.nYRes, FALSE, nThreads, &pRegistration);
+	CHECK_RC(nRetVal, "Create registration");
+
+	// warm up caches and wake the threads
+	nRetVal = xnDepthRegistrationRegister(pRegistration, pDepth, pRegistered);
+	CHECK_RC(nRetVal, "Register");
+
+	XnUInt64 nStart;
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nStart);
+	for (XnUInt32 i = 0; i < config.nIterations; ++i)
+	{
+		xnDepthRegistrationRegister(pRegistration, pDepth, pRegistered);
+	}
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	xnDepthRegistrationDestroy(&pRegistration);
+
+	*pdSeconds = (nEnd - nStart) / 1e6;
+	return XN_STATUS_OK;
+}
+
+XnStatus runRegistrationBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnUInt32 nPixels = config.nXRes * config.nYRes;
+	XnDepthPixel* pDepth = XN_NEW_ARR(XnDepthPixel, nPixels);
+	XN_VALIDATE_ALLOC_PTR(pDepth);
+	XnDepthPixel* pRegistered = XN_NEW_ARR(XnDepthPixel, nPixels);
+	if (pRegistered == NULL)
+	{
+		XN_DELETE_ARR(pDepth);
+		return XN_STATUS_ALLOC_FAILED;
+	}
+
+	fillDepthFrame(pDepth, config.nXRes, config.nYRes, 0);
+
+	XnRegistrationCalibration calibration;
+	fillCalibration(config, calibration);
+
+	XnDouble dSingleSeconds = 0;
+	XnDouble dAutoSeconds = 0;
+	nRetVal = timeRegistration(config, calibration, 1, pDepth, pRegistered, &dSingleSeconds);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = timeRegistration(config, calibration, 0, pDepth, pRegistered, &dAutoSeconds);
+	}
+
+	XN_DELETE_ARR(pRegistered);
+	XN_DELETE_ARR(pDepth);
+	XN_IS_STATUS_OK(nRetVal);
+
+	results.Add("registration", "register_throughput", "1_thread", config.nIterations / dSingleSeconds, "frames/s");
+	results.Add("registration", "register_throughput", "auto_threads", config.nIterations / dAutoSeconds, "frames/s");
+	results.Add("registration", "register_speedup", "auto_threads", dSingleSeconds / dAutoSeconds, "ratio");
+
+	return XN_STATUS_OK;
+}
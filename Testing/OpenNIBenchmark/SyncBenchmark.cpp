@@ -0,0 +1,368 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+
+#if (XN_PLATFORM != XN_PLATFORM_WIN32)
+#include <pthread.h>
+#include <errno.h>
+#endif
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+/** Round trips per iteration in the ping-pong test. */
+#define SYNC_BENCHMARK_ROUND_TRIPS_FACTOR	200
+/** Lock acquisitions per iteration (per thread) in the throughput tests. */
+#define SYNC_BENCHMARK_LOCKS_FACTOR			10000
+#define SYNC_BENCHMARK_MAX_THREADS			4
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/** The primitives under test: an auto-reset event and a recursive lock. */
+class SyncPrimitives
+{
+public:
+	virtual ~SyncPrimitives() {}
+	virtual XnStatus CreateEvent(void** ppEvent) = 0;
+	virtual void CloseEvent(void* pEvent) = 0;
+	virtual void SetEvent(void* pEvent) = 0;
+	virtual void WaitEvent(void* pEvent) = 0;
+	virtual XnStatus CreateLock(void** ppLock) = 0;
+	virtual void CloseLock(void* pLock) = 0;
+	virtual void Lock(void* pLock) = 0;
+	virtual void Unlock(void* pLock) = 0;
+};
+
+/** The current OS abstraction (events and critical sections). */
+class XnOSSyncPrimitives : public SyncPrimitives
+{
+public:
+	virtual XnStatus CreateEvent(void** ppEvent)
+	{
+		XN_EVENT_HANDLE hEvent = NULL;
+		XnStatus nRetVal = xnOSCreateEvent(&hEvent, FALSE);
+		*ppEvent = hEvent;
+		return nRetVal;
+	}
+
+	virtual void CloseEvent(void* pEvent) { XN_EVENT_HANDLE hEvent = (XN_EVENT_HANDLE)pEvent; xnOSCloseEvent(&hEvent); }
+	virtual void SetEvent(void* pEvent) { xnOSSetEvent((XN_EVENT_HANDLE)pEvent); }
+	virtual void WaitEvent(void* pEvent) { xnOSWaitEvent((XN_EVENT_HANDLE)pEvent, XN_WAIT_INFINITE); }
+
+	virtual XnStatus CreateLock(void** ppLock)
+	{
+		XN_CRITICAL_SECTION_HANDLE* phLock;
+		XN_VALIDATE_NEW(phLock, XN_CRITICAL_SECTION_HANDLE);
+		XnStatus nRetVal = xnOSCreateCriticalSection(phLock);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			XN_DELETE(phLock);
+			return nRetVal;
+		}
+		*ppLock = phLock;
+		return XN_STATUS_OK;
+	}
+
+	virtual void CloseLock(void* pLock)
+	{
+		XN_CRITICAL_SECTION_HANDLE* phLock = (XN_CRITICAL_SECTION_HANDLE*)pLock;
+		xnOSCloseCriticalSection(phLock);
+		XN_DELETE(phLock);
+	}
+
+	virtual void Lock(void* pLock) { xnOSEnterCriticalSection((XN_CRITICAL_SECTION_HANDLE*)pLock); }
+	virtual void Unlock(void* pLock) { xnOSLeaveCriticalSection((XN_CRITICAL_SECTION_HANDLE*)pLock); }
+};
+
+#if (XN_PLATFORM != XN_PLATFORM_WIN32)
+/**
+* The way Linux events and critical sections were implemented before they moved to futexes: a
+* recursive pthread mutex, and a mutex + condition variable pair per event. Kept here as a baseline.
+*/
+class PThreadSyncPrimitives : public SyncPrimitives
+{
+public:
+	typedef struct Event
+	{
+		pthread_mutex_t mutex;
+		pthread_cond_t cond;
+		XnBool bSignaled;
+	} Event;
+
+	virtual XnStatus CreateEvent(void** ppEvent)
+	{
+		Event* pEvent;
+		XN_VALIDATE_NEW(pEvent, Event);
+		pthread_mutex_init(&pEvent->mutex, NULL);
+		pthread_cond_init(&pEvent->cond, NULL);
+		pEvent->bSignaled = FALSE;
+		*ppEvent = pEvent;
+		return XN_STATUS_OK;
+	}
+
+	virtual void CloseEvent(void* pEvent)
+	{
+		Event* pThis = (Event*)pEvent;
+		pthread_cond_destroy(&pThis->cond);
+		pthread_mutex_destroy(&pThis->mutex);
+		XN_DELETE(pThis);
+	}
+
+	virtual void SetEvent(void* pEvent)
+	{
+		Event* pThis = (Event*)pEvent;
+		pthread_mutex_lock(&pThis->mutex);
+		pThis->bSignaled = TRUE;
+		pthread_cond_broadcast(&pThis->cond);
+		pthread_mutex_unlock(&pThis->mutex);
+	}
+
+	virtual void WaitEvent(void* pEvent)
+	{
+		Event* pThis = (Event*)pEvent;
+		pthread_mutex_lock(&pThis->mutex);
+		while (!pThis->bSignaled)
+		{
+			pthread_cond_wait(&pThis->cond, &pThis->mutex);
+		}
+		pThis->bSignaled = FALSE;
+		pthread_mutex_unlock(&pThis->mutex);
+	}
+
+	virtual XnStatus CreateLock(void** ppLock)
+	{
+		pthread_mutex_t* pMutex;
+		XN_VALIDATE_NEW(pMutex, pthread_mutex_t);
+		pthread_mutexattr_t attr;
+		pthread_mutexattr_init(&attr);
+		pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(pMutex, &attr);
+		pthread_mutexattr_destroy(&attr);
+		*ppLock = pMutex;
+		return XN_STATUS_OK;
+	}
+
+	virtual void CloseLock(void* pLock)
+	{
+		pthread_mutex_t* pMutex = (pthread_mutex_t*)pLock;
+		pthread_mutex_destroy(pMutex);
+		XN_DELETE(pMutex);
+	}
+
+	virtual void Lock(void* pLock) { pthread_mutex_lock((pthread_mutex_t*)pLock); }
+	virtual void Unlock(void* pLock) { pthread_mutex_unlock((pthread_mutex_t*)pLock); }
+};
+#endif
+
+typedef struct PingPongContext
+{
+	SyncPrimitives* pPrimitives;
+	void* pPing;
+	void* pPong;
+	XnUInt32 nRoundTrips;
+} PingPongContext;
+
+typedef struct LockContext
+{
+	SyncPrimitives* pPrimitives;
+	void* pLock;
+	XnUInt32 nLocks;
+	volatile XnUInt64* pnCounter;
+} LockContext;
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static XN_THREAD_PROC PongThread(XN_THREAD_PARAM pParam)
+{
+	PingPongContext* pContext = (PingPongContext*)pParam;
+	for (XnUInt32 i = 0; i < pContext->nRoundTrips; ++i)
+	{
+		pContext->pPrimitives->WaitEvent(pContext->pPing);
+		pContext->pPrimitives->SetEvent(pContext->pPong);
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+static XN_THREAD_PROC LockThread(XN_THREAD_PARAM pParam)
+{
+	LockContext* pContext = (LockContext*)pParam;
+	for (XnUInt32 i = 0; i < pContext->nLocks; ++i)
+	{
+		pContext->pPrimitives->Lock(pContext->pLock);
+		++*pContext->pnCounter;
+		pContext->pPrimitives->Unlock(pContext->pLock);
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+static XnStatus runPingPongBenchmark(SyncPrimitives& primitives, const XnChar* strVariant, XnUInt32 nRoundTrips, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	PingPongContext context;
+	context.pPrimitives = &primitives;
+	context.nRoundTrips = nRoundTrips;
+
+	nRetVal = primitives.CreateEvent(&context.pPing);
+	CHECK_RC(nRetVal, "Create event");
+	nRetVal = primitives.CreateEvent(&context.pPong);
+	CHECK_RC(nRetVal, "Create event");
+
+	XnUInt64* pRoundTrips = XN_NEW_ARR(XnUInt64, nRoundTrips);
+	XN_VALIDATE_ALLOC_PTR(pRoundTrips);
+
+	XN_THREAD_HANDLE hThread;
+	nRetVal = xnOSCreateThread(PongThread, &context, &hThread);
+	CHECK_RC(nRetVal, "Create thread");
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+	XnUInt64 nPrev = nStart;
+
+	for (XnUInt32 i = 0; i < nRoundTrips; ++i)
+	{
+		primitives.SetEvent(context.pPing);
+		primitives.WaitEvent(context.pPong);
+
+		XnUInt64 nNow;
+		xnOSGetHighResTimeStamp(&nNow);
+		pRoundTrips[i] = nNow - nPrev;
+		nPrev = nNow;
+	}
+
+	xnOSWaitForThreadExit(hThread, XN_WAIT_INFINITE);
+	xnOSCloseThread(&hThread);
+
+	// every round trip is two signal-to-wake hops
+	results.Add("sync", "signal_to_wake_mean", strVariant, (nPrev - nStart) * 1000.0 / (2.0 * nRoundTrips), "ns");
+	results.Add("sync", "round_trip_p50", strVariant, (XnDouble)benchmarkPercentile(pRoundTrips, nRoundTrips, 50), "us");
+	results.Add("sync", "round_trip_p99", strVariant, (XnDouble)benchmarkPercentile(pRoundTrips, nRoundTrips, 99), "us");
+
+	XN_DELETE_ARR(pRoundTrips);
+	primitives.CloseEvent(context.pPong);
+	primitives.CloseEvent(context.pPing);
+
+	return XN_STATUS_OK;
+}
+
+static XnStatus runLockBenchmark(SyncPrimitives& primitives, const XnChar* strVariant, XnUInt32 nThreads, XnUInt32 nLocksPerThread, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	volatile XnUInt64 nCounter = 0;
+	LockContext context;
+	context.pPrimitives = &primitives;
+	context.nLocks = nLocksPerThread;
+	context.pnCounter = &nCounter;
+
+	nRetVal = primitives.CreateLock(&context.pLock);
+	CHECK_RC(nRetVal, "Create lock");
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	if (nThreads == 1)
+	{
+		LockThread(&context);
+	}
+	else
+	{
+		XN_THREAD_HANDLE ahThreads[SYNC_BENCHMARK_MAX_THREADS];
+		for (XnUInt32 i = 0; i < nThreads; ++i)
+		{
+			nRetVal = xnOSCreateThread(LockThread, &context, &ahThreads[i]);
+			CHECK_RC(nRetVal, "Create thread");
+		}
+
+		for (XnUInt32 i = 0; i < nThreads; ++i)
+		{
+			xnOSWaitForThreadExit(ahThreads[i], XN_WAIT_INFINITE);
+			xnOSCloseThread(&ahThreads[i]);
+		}
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	primitives.CloseLock(context.pLock);
+
+	XnUInt64 nTotalLocks = (XnUInt64)nThreads * nLocksPerThread;
+	if (nCounter != nTotalLocks)
+	{
+		fprintf(stderr, "Lock protected counter is %llu instead of %llu\n", (unsigned long long)nCounter, (unsigned long long)nTotalLocks);
+		return XN_STATUS_ERROR;
+	}
+
+	XnChar strName[BENCHMARK_MAX_NAME];
+	XnUInt32 nCharsWritten = 0;
+	if (nThreads == 1)
+	{
+		results.Add("sync", "uncontended_lock_cost", strVariant, (nEnd - nStart) * 1000.0 / nTotalLocks, "ns");
+	}
+	else
+	{
+		xnOSStrFormat(strName, sizeof(strName), &nCharsWritten, "lock_throughput_%u_threads", nThreads);
+		results.Add("sync", strName, strVariant, nTotalLocks / ((nEnd - nStart) / 1000000.0) / 1000000.0, "Mlocks/s");
+	}
+
+	return XN_STATUS_OK;
+}
+
+static XnStatus runSyncBenchmark(SyncPrimitives& primitives, const XnChar* strVariant, const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	nRetVal = runPingPongBenchmark(primitives, strVariant, config.nIterations * SYNC_BENCHMARK_ROUND_TRIPS_FACTOR, results);
+	XN_IS_STATUS_OK(nRetVal);
+
+	XnUInt32 anThreads[] = { 1, 2, SYNC_BENCHMARK_MAX_THREADS };
+	for (XnUInt32 i = 0; i < sizeof(anThreads) / sizeof(anThreads[0]); ++i)
+	{
+		nRetVal = runLockBenchmark(primitives, strVariant, anThreads[i], config.nIterations * SYNC_BENCHMARK_LOCKS_FACTOR, results);
+		XN_IS_STATUS_OK(nRetVal);
+	}
+
+	return XN_STATUS_OK;
+}
+
+XnStatus runSyncBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	XnOSSyncPrimitives osPrimitives;
+	nRetVal = runSyncBenchmark(osPrimitives, "xnOS", config, results);
+	XN_IS_STATUS_OK(nRetVal);
+
+#if (XN_PLATFORM != XN_PLATFORM_WIN32)
+	PThreadSyncPrimitives pthreadPrimitives;
+	nRetVal = runSyncBenchmark(pthreadPrimitives, "pthread", config, results);
+	XN_IS_STATUS_OK(nRetVal);
+#endif
+
+	return XN_STATUS_OK;
+}
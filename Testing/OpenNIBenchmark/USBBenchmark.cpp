@@ -0,0 +1,262 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+#include <XnUSB.h>
+#include <XnUSBSimulator.h>
+
+//---------------------------------------------------------------------------
+// Defines
+//---------------------------------------------------------------------------
+#define USB_BENCHMARK_VENDOR_ID			0x1d27
+#define USB_BENCHMARK_PRODUCT_ID		0x0601
+#define USB_BENCHMARK_END_POINT			0x81
+#define USB_BENCHMARK_MAX_PACKET_SIZE	3072
+#define USB_BENCHMARK_PACKET_PAYLOAD	2600
+#define USB_BENCHMARK_PACKETS			32
+#define USB_BENCHMARK_BUFFERS			8
+#define USB_BENCHMARK_FRAME_SIZE		(640 * 480 * 2)
+/** Milliseconds every iteration adds to the length of a run. */
+#define USB_BENCHMARK_MS_PER_ITERATION	10
+
+//---------------------------------------------------------------------------
+// Types
+//---------------------------------------------------------------------------
+/** How the simulated device sends its data. */
+typedef struct USBBenchmarkSource
+{
+	/** Appended to the variant names. */
+	const XnChar* strSuffix;
+	XnUInt32 nBytesPerSecond;
+	XnUInt32 nJitter;
+	XnUInt32 nLossPerMillion;
+} USBBenchmarkSource;
+
+/** Puts the stream together into frames, the way a depth parser would. */
+typedef struct USBFrameConsumer
+{
+	XnUInt8* pFrame;
+	XnUInt32 nWritten;
+	XnUInt64 nBytes;
+} USBFrameConsumer;
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+static void consumeData(USBFrameConsumer* pConsumer, const XnUInt8* pData, XnUInt32 nSize)
+{
+	while (nSize > 0)
+	{
+		XnUInt32 nChunk = XN_MIN(nSize, USB_BENCHMARK_FRAME_SIZE - pConsumer->nWritten);
+		xnOSMemCopy(pConsumer->pFrame + pConsumer->nWritten, pData, nChunk);
+		pConsumer->nWritten = (pConsumer->nWritten + nChunk) % USB_BENCHMARK_FRAME_SIZE;
+		pConsumer->nBytes += nChunk;
+		pData += nChunk;
+		nSize -= nChunk;
+	}
+}
+
+static XnBool XN_CALLBACK_TYPE OnContiguousRead(XnUChar* pBuffer, XnUInt32 nBufferSize, void* pCallbackData)
+{
+	consumeData((USBFrameConsumer*)pCallbackData, pBuffer, nBufferSize);
+	return TRUE;
+}
+
+static XnBool XN_CALLBACK_TYPE OnPacketsRead(const XnUSBPacket* aPackets, XnUInt32 nCount, void* pCallbackData)
+{
+	for (XnUInt32 i = 0; i < nCount; ++i)
+	{
+		consumeData((USBFrameConsumer*)pCallbackData, aPackets[i].pData, aPackets[i].nSize);
+	}
+	return TRUE;
+}
+
+static XnDouble getAverage(const XnLatencyMetrics& metrics)
+{
+	return (metrics.nCount == 0) ? 0.0 : (XnDouble)metrics.nTotal / metrics.nCount;
+}
+
+static XnStatus runUSBBenchmark(const BenchmarkConfig& config, const USBBenchmarkSource& source, XnUSBReadThreadMode mode, XnBool bPackets, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// an isochronous source, with short packets, so the contiguous path has to compact them
+	XnUSBSimulatedEndPointConfig endPointConfig;
+	xnOSMemSet(&endPointConfig, 0, sizeof(endPointConfig));
+	endPointConfig.nEndPointID = USB_BENCHMARK_END_POINT;
+	endPointConfig.nType = XN_USB_EP_ISOCHRONOUS;
+	endPointConfig.nMaxPacketSize = USB_BENCHMARK_MAX_PACKET_SIZE;
+	endPointConfig.nBytesPerSecond = source.nBytesPerSecond;
+	endPointConfig.nBytesPerPacket = USB_BENCHMARK_PACKET_PAYLOAD;
+	endPointConfig.nJitter = source.nJitter;
+	endPointConfig.nLossPerMillion = source.nLossPerMillion;
+	// every variant sees the same delays and losses
+	endPointConfig.nSeed = 1;
+
+	XnUSBSimulatedDeviceConfig deviceConfig = { USB_BENCHMARK_VENDOR_ID, USB_BENCHMARK_PRODUCT_ID, XN_USB_DEVICE_HIGH_SPEED, &endPointConfig, 1, NULL, NULL };
+	XnUSBConnectionString strDevicePath;
+	nRetVal = xnUSBSimulatorConnectDevice(&deviceConfig, strDevicePath);
+	CHECK_RC(nRetVal, "Connect simulated device");
+
+	// the device is opened like a real one
+	XN_USB_DEV_HANDLE hDevice = NULL;
+	XN_USB_EP_HANDLE hEndPoint = NULL;
+	nRetVal = xnUSBOpenDeviceByPath(strDevicePath, &hDevice);
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnUSBOpenEndPoint(hDevice, USB_BENCHMARK_END_POINT, XN_USB_EP_ISOCHRONOUS, XN_USB_DIRECTION_IN, &hEndPoint);
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnUSBSetReadThreadMode(hEndPoint, mode);
+	}
+
+	USBFrameConsumer consumer = { NULL, 0, 0 };
+	if (nRetVal == XN_STATUS_OK)
+	{
+		consumer.pFrame = (XnUInt8*)xnOSMalloc(USB_BENCHMARK_FRAME_SIZE);
+		if (consumer.pFrame == NULL)
+		{
+			nRetVal = XN_STATUS_ALLOC_FAILED;
+		}
+	}
+
+	if (nRetVal != XN_STATUS_OK)
+	{
+		if (hEndPoint != NULL)
+		{
+			xnUSBCloseEndPoint(hEndPoint);
+		}
+		if (hDevice != NULL)
+		{
+			xnUSBCloseDevice(hDevice);
+		}
+		xnUSBSimulatorDisconnectDevice(strDevicePath);
+		CHECK_RC(nRetVal, "Open simulated endpoint");
+	}
+
+	XnUInt32 nBufferSize = USB_BENCHMARK_MAX_PACKET_SIZE * USB_BENCHMARK_PACKETS;
+
+	XnUInt64 nStart;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	if (bPackets)
+	{
+		nRetVal = xnUSBInitPacketReadThread(hEndPoint, nBufferSize, USB_BENCHMARK_BUFFERS, 1000, OnPacketsRead, &consumer);
+	}
+	else
+	{
+		nRetVal = xnUSBInitReadThread(hEndPoint, nBufferSize, USB_BENCHMARK_BUFFERS, 1000, OnContiguousRead, &consumer);
+	}
+
+	if (nRetVal == XN_STATUS_OK)
+	{
+		xnOSSleep(config.nIterations * USB_BENCHMARK_MS_PER_ITERATION);
+		nRetVal = xnUSBShutdownReadThread(hEndPoint);
+	}
+
+	XnUInt64 nEnd;
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	XnUSBEndPointStatistics stats;
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnUSBGetEndPointStatistics(hEndPoint, &stats);
+	}
+
+	XnUSBSimulatedEndPointStatistics deviceStats;
+	if (nRetVal == XN_STATUS_OK)
+	{
+		nRetVal = xnUSBSimulatorGetEndPointStatistics(hEndPoint, &deviceStats);
+	}
+
+	xnUSBCloseEndPoint(hEndPoint);
+	xnUSBCloseDevice(hDevice);
+	xnUSBSimulatorDisconnectDevice(strDevicePath);
+	xnOSFree(consumer.pFrame);
+	CHECK_RC(nRetVal, "Read simulated endpoint");
+
+	XnChar strVariant[BENCHMARK_MAX_NAME];
+	XnUInt32 nCharsWritten = 0;
+	xnOSStrFormat(strVariant, sizeof(strVariant), &nCharsWritten, "%s_%s%s", 
+		(mode == XN_USB_READ_THREAD_MODE_ORDERED) ? "ordered" : "completion", 
+		bPackets ? "packets" : "contiguous", 
+		source.strSuffix);
+
+	results.Add("usb", "iso_throughput", strVariant, consumer.nBytes / (XnDouble)(nEnd - nStart), "MB/s");
+	results.Add("usb", "dispatch_latency", strVariant, getAverage(stats.dispatchLatency), "us");
+	results.Add("usb", "callback_duration", strVariant, getAverage(stats.callbackDuration), "us");
+	// what was dropped: produced while no buffer was queued, lost on the way, or not delivered in time
+	results.Add("usb", "overrun_bytes", strVariant, (XnDouble)deviceStats.nBytesOverrun, "bytes");
+	results.Add("usb", "failed_packets", strVariant, (XnDouble)stats.nFailedPackets, "packets");
+	results.Add("usb", "timeouts", strVariant, (XnDouble)stats.nTimeouts, "transfers");
+
+	return XN_STATUS_OK;
+}
+
+XnStatus runUSBBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	// USB may already have been initialized by someone else in this process
+	nRetVal = xnUSBInit();
+	if (nRetVal != XN_STATUS_OK && nRetVal != XN_STATUS_USB_ALREADY_INIT)
+	{
+		CHECK_RC(nRetVal, "Init USB");
+	}
+	XnBool bShutdown = (nRetVal == XN_STATUS_OK);
+
+	// as fast as the read thread takes it, and a lossy device paced at about the rate of a depth and an image stream
+	USBBenchmarkSource aSources[] = 
+	{
+		{ "", 0, 0, 0 },
+		{ "_lossy", 40 * 1000 * 1000, 2000, 1000 },
+	};
+
+	XnUSBReadThreadMode aModes[] = { XN_USB_READ_THREAD_MODE_ORDERED, XN_USB_READ_THREAD_MODE_COMPLETION };
+	for (XnUInt32 s = 0; s < sizeof(aSources) / sizeof(aSources[0]) && nRetVal == XN_STATUS_OK; ++s)
+	{
+		for (XnUInt32 i = 0; i < sizeof(aModes) / sizeof(aModes[0]) && nRetVal == XN_STATUS_OK; ++i)
+		{
+			for (XnUInt32 j = 0; j < 2 && nRetVal == XN_STATUS_OK; ++j)
+			{
+				nRetVal = runUSBBenchmark(config, aSources[s], aModes[i], (j == 1), results);
+			}
+		}
+	}
+
+	if (bShutdown)
+	{
+		xnUSBShutdown();
+	}
+
+	// not every platform can simulate a device
+	if (nRetVal == XN_STATUS_OS_UNSUPPORTED_FUNCTION)
+	{
+		fprintf(stderr, "USB benchmarks are not supported on this platform, skipping\n");
+		return XN_STATUS_OK;
+	}
+
+	return nRetVal;
+}
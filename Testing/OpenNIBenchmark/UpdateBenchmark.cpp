@@ -0,0 +1,84 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+//---------------------------------------------------------------------------
+// Includes
+//---------------------------------------------------------------------------
+#include "Benchmark.h"
+
+//---------------------------------------------------------------------------
+// Code
+//---------------------------------------------------------------------------
+XnStatus runUpdateBenchmarks(const BenchmarkConfig& config, BenchmarkResults& results)
+{
+	XnStatus nRetVal = XN_STATUS_OK;
+
+	xn::Context context;
+	nRetVal = context.Init();
+	CHECK_RC(nRetVal, "Init");
+
+	MockWorkload workload;
+	nRetVal = workload.Init(context, config);
+	XN_IS_STATUS_OK(nRetVal);
+
+	nRetVal = context.StartGeneratingAll();
+	CHECK_RC(nRetVal, "Start generating");
+
+	XnUInt64* pLatencies = XN_NEW_ARR(XnUInt64, config.nFrames);
+	XN_VALIDATE_ALLOC_PTR(pLatencies);
+
+	XnUInt64 nTotal = 0;
+	XnUInt64 nAllocationsBefore = benchmarkGetAllocationCount();
+
+	for (XnUInt32 i = 0; i < config.nFrames; ++i)
+	{
+		// new data is already pending on every node, so this is the cost of the update itself
+		nRetVal = workload.QueueNextFrame();
+		XN_IS_STATUS_OK(nRetVal);
+
+		XnUInt64 nStart;
+		xnOSGetHighResTimeStamp(&nStart);
+
+		nRetVal = context.WaitAndUpdateAll();
+		CHECK_RC(nRetVal, "Wait and update");
+
+		XnUInt64 nEnd;
+		xnOSGetHighResTimeStamp(&nEnd);
+
+		pLatencies[i] = nEnd - nStart;
+		nTotal += pLatencies[i];
+	}
+
+	XnUInt64 nAllocations = benchmarkGetAllocationCount() - nAllocationsBefore;
+
+	results.Add("update", "wait_and_update_all_mean", NULL, (XnDouble)nTotal / config.nFrames, "us");
+	results.Add("update", "wait_and_update_all_p50", NULL, (XnDouble)benchmarkPercentile(pLatencies, config.nFrames, 50), "us");
+	results.Add("update", "wait_and_update_all_p90", NULL, (XnDouble)benchmarkPercentile(pLatencies, config.nFrames, 90), "us");
+	results.Add("update", "wait_and_update_all_p99", NULL, (XnDouble)benchmarkPercentile(pLatencies, config.nFrames, 99), "us");
+	results.Add("update", "wait_and_update_all_max", NULL, (XnDouble)benchmarkPercentile(pLatencies, config.nFrames, 100), "us");
+	// includes whatever the mock nodes allocate when data is queued on them
+	results.Add("update", "allocations_per_frame", NULL, (XnDouble)nAllocations / config.nFrames, "allocations");
+
+	XN_DELETE_ARR(pLatencies);
+	workload.Release();
+	context.Release();
+
+	return XN_STATUS_OK;
+}
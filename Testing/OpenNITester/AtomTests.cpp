@@ -0,0 +1,121 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnOS.h>
+#include <XnAtoms.h>
+
+#define TEST_THREADS	8
+#define TEST_NAMES		2000
+
+typedef struct InternThreadContext
+{
+	XnUInt32 nSeed;
+	XnAtom aAtoms[TEST_NAMES];
+	XnStatus nRetVal;
+} InternThreadContext;
+
+static XN_THREAD_PROC InternAllNamesThreadProc(XN_THREAD_PARAM pParam)
+{
+	InternThreadContext* pContext = (InternThreadContext*)pParam;
+
+	// every thread interns the same names, each in a different order, so that lookups race with growth
+	for (XnUInt32 i = 0; i < TEST_NAMES; ++i)
+	{
+		XnUInt32 nName = (i * 7 + pContext->nSeed * 131) % TEST_NAMES;
+		XnChar strName[64];
+		sprintf(strName, "AtomTest.Shared.%u", nName);
+
+		XnStatus nRetVal = xnAtomIntern(strName, &pContext->aAtoms[nName]);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			pContext->nRetVal = nRetVal;
+			break;
+		}
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+TEST(AtomTest, InternsEachStringOnce)
+{
+	XnAtom a1 = XN_INVALID_ATOM;
+	XnAtom a2 = XN_INVALID_ATOM;
+	XnAtom b = XN_INVALID_ATOM;
+	ASSERT_EQ(XN_STATUS_OK, xnAtomIntern("AtomTest.A", &a1));
+	ASSERT_EQ(XN_STATUS_OK, xnAtomIntern("AtomTest.A", &a2));
+	ASSERT_EQ(XN_STATUS_OK, xnAtomIntern("AtomTest.B", &b));
+
+	EXPECT_NE(XN_INVALID_ATOM, a1);
+	EXPECT_EQ(a1, a2);
+	EXPECT_NE(a1, b);
+	EXPECT_STREQ("AtomTest.A", xnAtomGetString(a1));
+	EXPECT_STREQ("AtomTest.B", xnAtomGetString(b));
+
+	XnAtom found = XN_INVALID_ATOM;
+	ASSERT_EQ(XN_STATUS_OK, xnAtomFind("AtomTest.B", &found));
+	EXPECT_EQ(b, found);
+}
+
+TEST(AtomTest, FindDoesNotIntern)
+{
+	XnUInt32 nCount = xnAtomGetCount();
+
+	XnAtom atom = XN_INVALID_ATOM;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnAtomFind("AtomTest.NeverInterned", &atom));
+	EXPECT_EQ(nCount, xnAtomGetCount());
+
+	EXPECT_EQ(NULL, xnAtomGetString(XN_INVALID_ATOM));
+	EXPECT_EQ(NULL, xnAtomGetString(nCount + 1));
+}
+
+TEST(AtomTest, GrowsWhileInternedFromManyThreads)
+{
+	InternThreadContext* aContexts = new InternThreadContext[TEST_THREADS];
+	XN_THREAD_HANDLE ahThreads[TEST_THREADS];
+	for (XnUInt32 i = 0; i < TEST_THREADS; ++i)
+	{
+		aContexts[i].nSeed = i;
+		aContexts[i].nRetVal = XN_STATUS_OK;
+		ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(InternAllNamesThreadProc, &aContexts[i], &ahThreads[i]));
+	}
+
+	for (XnUInt32 i = 0; i < TEST_THREADS; ++i)
+	{
+		xnOSWaitForThreadExit(ahThreads[i], XN_WAIT_INFINITE);
+		xnOSCloseThread(&ahThreads[i]);
+		EXPECT_EQ(XN_STATUS_OK, aContexts[i].nRetVal);
+	}
+
+	// all threads got the same atom for each name, and no two names share one
+	for (XnUInt32 nName = 0; nName < TEST_NAMES; ++nName)
+	{
+		XnChar strName[64];
+		sprintf(strName, "AtomTest.Shared.%u", nName);
+		XnAtom atom = aContexts[0].aAtoms[nName];
+		EXPECT_STREQ(strName, xnAtomGetString(atom));
+		for (XnUInt32 i = 1; i < TEST_THREADS; ++i)
+		{
+			EXPECT_EQ(atom, aContexts[i].aAtoms[nName]);
+		}
+	}
+
+	delete[] aContexts;
+}
@@ -0,0 +1,189 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <XnOniFrameReader.h>
+#include <math.h>
+
+using namespace xn;
+
+#define TEST_SAMPLE_RATE		48000
+#define TEST_CHANNELS			4
+/* 10ms of samples, like a USB audio packet */
+#define TEST_FRAME_SAMPLES		480
+#define TEST_FRAME_SIZE			(TEST_FRAME_SAMPLES * TEST_CHANNELS * sizeof(XnInt16))
+#define TEST_PI					3.14159265358979
+
+class AudioCodecTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		m_audio.Release();
+		m_context.Release();
+		xnOSDeleteFile("AudioCodecTest.oni");
+	}
+
+	void CreateAudio(XnUInt8 nChannels)
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+		ASSERT_EQ(XN_STATUS_OK, m_audio.Create(m_context, "Audio"));
+
+		XnWaveOutputMode mode = { TEST_SAMPLE_RATE, 16, nChannels };
+		ASSERT_EQ(XN_STATUS_OK, m_audio.SetWaveOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, m_audio.SetIntProperty(XN_PROP_WAVE_SUPPORTED_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, m_audio.SetGeneralProperty(XN_PROP_WAVE_SUPPORTED_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, m_audio.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+	}
+
+	// a tone per channel, the same voice heard a little differently by every microphone, and some hiss
+	static XnUInt32 FillSignal(XnInt16* pSamples, XnUInt32 nChannels, XnUInt32 nFrame)
+	{
+		XnUInt32 nSeed = nFrame + 1;
+		for (XnUInt32 n = 0; n < TEST_FRAME_SAMPLES; ++n)
+		{
+			XnDouble t = (nFrame * TEST_FRAME_SAMPLES + n) / (XnDouble)TEST_SAMPLE_RATE;
+			XnDouble dVoice = 6000 * sin(2 * TEST_PI * 220 * t) + 2000 * sin(2 * TEST_PI * 660 * t);
+			for (XnUInt32 c = 0; c < nChannels; ++c)
+			{
+				nSeed = nSeed * 1103515245 + 12345;
+				XnInt32 nHiss = (XnInt32)((nSeed >> 16) % 33) - 16;
+				XnDouble dTone = 3000 * sin(2 * TEST_PI * 100 * (c + 1) * t);
+				pSamples[n * nChannels + c] = (XnInt16)(dVoice * (1.0 - c * 0.1) + dTone + nHiss);
+			}
+		}
+
+		return TEST_FRAME_SAMPLES * nChannels * sizeof(XnInt16);
+	}
+
+	XnUInt32 RoundTrip(Codec& codec, const void* pSamples, XnUInt32 nSize)
+	{
+		XnUInt8 aEncoded[TEST_FRAME_SIZE * 2];
+		XnUInt8 aDecoded[TEST_FRAME_SIZE];
+		XnUInt nEncodedSize = 0;
+		XnUInt nDecodedSize = 0;
+		EXPECT_EQ(XN_STATUS_OK, codec.EncodeData(pSamples, nSize, aEncoded, sizeof(aEncoded), &nEncodedSize));
+		EXPECT_EQ(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize));
+		EXPECT_EQ(nSize, nDecodedSize);
+		EXPECT_EQ(0, memcmp(pSamples, aDecoded, nSize));
+		return nEncodedSize;
+	}
+
+	Context m_context;
+	MockAudioGenerator m_audio;
+};
+
+TEST_F(AudioCodecTest, LosslessRoundTripsAndCompresses)
+{
+	CreateAudio(TEST_CHANNELS);
+
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_AUDIO_LOSSLESS, m_audio, codec));
+
+	XnInt16 aSamples[TEST_FRAME_SAMPLES * TEST_CHANNELS];
+	XnUInt32 nSize = FillSignal(aSamples, TEST_CHANNELS, 0);
+	EXPECT_GT(nSize / 2, RoundTrip(codec, aSamples, nSize));
+
+	// the codec follows the node's channel count
+	XnWaveOutputMode mode = { TEST_SAMPLE_RATE, 16, 1 };
+	ASSERT_EQ(XN_STATUS_OK, m_audio.SetWaveOutputMode(mode));
+	nSize = FillSignal(aSamples, 1, 0);
+	EXPECT_GT(nSize / 2, RoundTrip(codec, aSamples, nSize));
+
+	// full scale square waves, and silence
+	for (XnUInt32 i = 0; i < TEST_FRAME_SAMPLES; ++i)
+	{
+		aSamples[i] = (i & 8) ? 32767 : -32768;
+	}
+	RoundTrip(codec, aSamples, TEST_FRAME_SAMPLES * sizeof(XnInt16));
+	xnOSMemSet(aSamples, 0, sizeof(aSamples));
+	EXPECT_GT(100U, RoundTrip(codec, aSamples, TEST_FRAME_SAMPLES * sizeof(XnInt16)));
+
+	codec.Release();
+}
+
+TEST_F(AudioCodecTest, LosslessStoresNoiseAndRejectsCorruptFrames)
+{
+	CreateAudio(TEST_CHANNELS);
+
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_AUDIO_LOSSLESS, m_audio, codec));
+
+	// noise doesn't compress, but costs no more than a small header
+	XnInt16 aSamples[TEST_FRAME_SAMPLES * TEST_CHANNELS];
+	XnUInt32 nSeed = 1;
+	for (XnUInt32 i = 0; i < TEST_FRAME_SAMPLES * TEST_CHANNELS; ++i)
+	{
+		nSeed = nSeed * 1103515245 + 12345;
+		aSamples[i] = (XnInt16)(nSeed >> 16);
+	}
+	EXPECT_GE(sizeof(aSamples) + 16, RoundTrip(codec, aSamples, sizeof(aSamples)));
+
+	XnUInt32 nSize = FillSignal(aSamples, TEST_CHANNELS, 0);
+	XnUInt8 aEncoded[TEST_FRAME_SIZE * 2];
+	XnUInt8 aDecoded[TEST_FRAME_SIZE];
+	XnUInt nEncodedSize = 0;
+	XnUInt nDecodedSize = 0;
+	ASSERT_EQ(XN_STATUS_OK, codec.EncodeData(aSamples, nSize, aEncoded, sizeof(aEncoded), &nEncodedSize));
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize / 2, aDecoded, sizeof(aDecoded), &nDecodedSize));
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded) / 2, &nDecodedSize));
+	aEncoded[nEncodedSize - 10] ^= 0x5A;
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize));
+
+	codec.Release();
+}
+
+TEST_F(AudioCodecTest, LosslessRecordingIsReadable)
+{
+	CreateAudio(TEST_CHANNELS);
+
+	Recorder recorder;
+	ASSERT_EQ(XN_STATUS_OK, recorder.Create(m_context));
+	ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, "AudioCodecTest.oni"));
+	ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(m_audio, XN_CODEC_AUDIO_LOSSLESS));
+
+	XnInt16 aSamples[TEST_FRAME_SAMPLES * TEST_CHANNELS];
+	XnUInt32 nSize = 0;
+	for (XnUInt32 i = 0; i < 5; ++i)
+	{
+		nSize = FillSignal(aSamples, TEST_CHANNELS, i);
+		ASSERT_EQ(XN_STATUS_OK, m_audio.SetData(i + 1, i * 10000, nSize, (const XnUInt8*)aSamples));
+		ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+	}
+	recorder.Release();
+
+	XnOniFrameReader* pReader = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderOpen("AudioCodecTest.oni", &pReader));
+	XnUInt32 nNode = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Audio", &nNode));
+	XnOniNodeInfo nodeInfo;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderGetNodeInfo(pReader, nNode, &nodeInfo));
+	EXPECT_LE(nSize, nodeInfo.nMaxFrameSize);
+
+	XnUInt8 aDecoded[TEST_FRAME_SIZE];
+	XnOniFrameInfo info;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderReadFrame(pReader, nNode, 3, aDecoded, sizeof(aDecoded), &info));
+	FillSignal(aSamples, TEST_CHANNELS, 3);
+	EXPECT_EQ(0, memcmp(aSamples, aDecoded, nSize));
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderClose(&pReader));
+}
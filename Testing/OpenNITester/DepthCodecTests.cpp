@@ -0,0 +1,241 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <XnOniFrameReader.h>
+
+using namespace xn;
+
+#define TEST_X_RES			160
+#define TEST_Y_RES			120
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAMES			10
+
+class DepthCodecTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, m_depth.Create(m_context, "Depth"));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+	}
+
+	virtual void TearDown()
+	{
+		m_depth.Release();
+		m_context.Release();
+		xnOSDeleteFile("DepthCodecTest.oni");
+	}
+
+	// a tilted floor, a sphere in front of it, and a hole with no depth
+	static void FillScene(XnDepthPixel* pDepth, XnUInt32 nFrame)
+	{
+		for (XnInt32 y = 0; y < TEST_Y_RES; ++y)
+		{
+			for (XnInt32 x = 0; x < TEST_X_RES; ++x)
+			{
+				XnInt32 nDepth = 3000 - y * 8 + x;
+				XnInt32 dx = x - 60 - (XnInt32)nFrame;
+				XnInt32 dy = y - 50;
+				if (dx * dx + dy * dy < 900)
+				{
+					nDepth = 1200 + (dx * dx + dy * dy) / 4;
+				}
+				if (x > 120 && y > 80)
+				{
+					nDepth = 0;
+				}
+				pDepth[y * TEST_X_RES + x] = (XnDepthPixel)nDepth;
+			}
+		}
+	}
+
+	XnUInt32 RoundTrip(Codec& codec, const XnDepthPixel* pDepth)
+	{
+		XnUInt8 aEncoded[TEST_PIXELS * sizeof(XnDepthPixel) * 2];
+		XnDepthPixel aDecoded[TEST_PIXELS];
+		XnUInt nEncodedSize = 0;
+		XnUInt nDecodedSize = 0;
+		EXPECT_EQ(XN_STATUS_OK, codec.EncodeData(pDepth, TEST_PIXELS * sizeof(XnDepthPixel), aEncoded, sizeof(aEncoded), &nEncodedSize));
+		EXPECT_EQ(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize));
+		EXPECT_EQ(TEST_PIXELS * sizeof(XnDepthPixel), nDecodedSize);
+		EXPECT_EQ(0, memcmp(pDepth, aDecoded, sizeof(aDecoded)));
+		return nEncodedSize;
+	}
+
+	Context m_context;
+	MockDepthGenerator m_depth;
+};
+
+TEST_F(DepthCodecTest, EntropyCodedIsLosslessAndSmallerThan16z)
+{
+	Codec codec;
+	Codec codec16z;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_16Z_ANS, m_depth, codec));
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_16Z_EMB_TABLES, m_depth, codec16z));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	FillScene(aDepth, 0);
+	XnUInt32 nSize = RoundTrip(codec, aDepth);
+	XnUInt32 nSize16z = RoundTrip(codec16z, aDepth);
+	EXPECT_LT(nSize, nSize16z);
+
+	codec16z.Release();
+	codec.Release();
+}
+
+TEST_F(DepthCodecTest, EntropyCodedHandlesExtremeData)
+{
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_16Z_ANS, m_depth, codec));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+
+	// constant
+	xnOSMemSet(aDepth, 0, sizeof(aDepth));
+	EXPECT_GT(100U, RoundTrip(codec, aDepth));
+
+	// largest possible jumps between neighbors
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		aDepth[i] = ((i + i / TEST_X_RES) % 2 == 0) ? 0 : 0xFFFF;
+	}
+	RoundTrip(codec, aDepth);
+
+	// noise doesn't compress, but costs no more than a small header
+	XnUInt32 nSeed = 1;
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		nSeed = nSeed * 1103515245 + 12345;
+		aDepth[i] = (XnDepthPixel)(nSeed >> 16);
+	}
+	EXPECT_GE(sizeof(aDepth) + 16, RoundTrip(codec, aDepth));
+
+	codec.Release();
+}
+
+TEST_F(DepthCodecTest, EntropyCodedRejectsCorruptFrames)
+{
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_16Z_ANS, m_depth, codec));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	FillScene(aDepth, 0);
+	XnUInt8 aEncoded[TEST_PIXELS * sizeof(XnDepthPixel) * 2];
+	XnDepthPixel aDecoded[TEST_PIXELS];
+	XnUInt nEncodedSize = 0;
+	XnUInt nDecodedSize = 0;
+	ASSERT_EQ(XN_STATUS_OK, codec.EncodeData(aDepth, sizeof(aDepth), aEncoded, sizeof(aEncoded), &nEncodedSize));
+
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize / 2, aDecoded, sizeof(aDecoded), &nDecodedSize));
+	aEncoded[nEncodedSize - 10] ^= 0x5A;
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize));
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded) / 2, &nDecodedSize));
+
+	codec.Release();
+}
+
+TEST_F(DepthCodecTest, EntropyCodedRejectsCorruptFramesReachingUnusedContexts)
+{
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_16Z_ANS, m_depth, codec));
+
+	// blocks of two far apart depths only have flat or very busy neighborhoods, so the contexts in between are
+	// never coded, and only a corrupt frame reaches them
+	XnDepthPixel aDepth[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		aDepth[i] = (((i % TEST_X_RES) / 8 + (i / TEST_X_RES) / 8) % 2 == 0) ? 1000 : 3000;
+	}
+	XnUInt8 aEncoded[TEST_PIXELS * sizeof(XnDepthPixel) * 2];
+	XnUInt8 aCorrupt[TEST_PIXELS * sizeof(XnDepthPixel) * 2];
+	XnDepthPixel aDecoded[TEST_PIXELS];
+	XnUInt nEncodedSize = 0;
+	XnUInt nDecodedSize = 0;
+	ASSERT_EQ(XN_STATUS_OK, codec.EncodeData(aDepth, sizeof(aDepth), aEncoded, sizeof(aEncoded), &nEncodedSize));
+
+	// the coded tokens are at the end of the frame
+	for (XnUInt32 i = 1; i <= 16; ++i)
+	{
+		xnOSMemCopy(aCorrupt, aEncoded, nEncodedSize);
+		aCorrupt[nEncodedSize - i * 8] ^= 0x5A;
+		EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aCorrupt, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize)) << "corrupt byte " << nEncodedSize - i * 8;
+	}
+
+	codec.Release();
+}
+
+TEST_F(DepthCodecTest, EntropyCodedRecordingPlaysBack)
+{
+	Recorder recorder;
+	ASSERT_EQ(XN_STATUS_OK, recorder.Create(m_context));
+	ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, "DepthCodecTest.oni"));
+	ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(m_depth, XN_CODEC_16Z_ANS));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_FRAMES; ++i)
+	{
+		FillScene(aDepth, i);
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetData(i + 1, i * 33333, sizeof(aDepth), aDepth));
+		ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+	}
+	recorder.Release();
+
+	// the frame reader decodes it without a player
+	XnOniFrameReader* pReader = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderOpen("DepthCodecTest.oni", &pReader));
+	XnUInt32 nNode = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Depth", &nNode));
+
+	XnDepthPixel aDecoded[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_FRAMES; ++i)
+	{
+		XnOniFrameInfo info;
+		ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderReadFrame(pReader, nNode, i, aDecoded, sizeof(aDecoded), &info));
+		FillScene(aDepth, i);
+		EXPECT_EQ(0, memcmp(aDepth, aDecoded, sizeof(aDepth)));
+	}
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderClose(&pReader));
+
+	// and so does the player
+	Context context;
+	Player player;
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording("DepthCodecTest.oni", player));
+	DepthGenerator depth;
+	ASSERT_EQ(XN_STATUS_OK, context.FindExistingNode(XN_NODE_TYPE_DEPTH, depth));
+	ASSERT_EQ(XN_STATUS_OK, player.SeekToFrame("Depth", 5, XN_PLAYER_SEEK_SET));
+	ASSERT_EQ(XN_STATUS_OK, depth.WaitAndUpdateData());
+	FillScene(aDepth, 4);
+	EXPECT_EQ(0, memcmp(aDepth, depth.GetDepthMap(), sizeof(aDepth)));
+	depth.Release();
+	player.Release();
+	context.Release();
+}
@@ -0,0 +1,323 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <XnDepthRegistration.h>
+
+using namespace xn;
+
+#define TEST_X_RES	64
+#define TEST_Y_RES	48
+#define TEST_PIXELS	(TEST_X_RES * TEST_Y_RES)
+
+static void InitCalibration(XnRegistrationCalibration& calibration, XnDouble fTranslationX)
+{
+	xnOSMemSet(&calibration, 0, sizeof(calibration));
+
+	// intrinsics are given at twice the test resolution, to check scaling
+	XnCameraIntrinsics intrinsics = { TEST_X_RES * 2, TEST_Y_RES * 2, 200.0, 200.0, TEST_X_RES, TEST_Y_RES };
+	calibration.depth = intrinsics;
+	calibration.image = intrinsics;
+	calibration.aRotation[0] = calibration.aRotation[4] = calibration.aRotation[8] = 1.0;
+	calibration.aTranslation[0] = fTranslationX;
+}
+
+class DepthRegistrationTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		m_pRegistration = NULL;
+		// with a focal length of 100 pixels, a 10mm baseline shifts pixels at 1000mm by 1 pixel, and at 500mm by 2
+		InitCalibration(m_calibration, 10.0);
+	}
+
+	virtual void TearDown()
+	{
+		xnDepthRegistrationDestroy(&m_pRegistration);
+	}
+
+	void FillFrame(XnDepthPixel* pFrame, XnDepthPixel nValue)
+	{
+		for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+		{
+			pFrame[i] = nValue;
+		}
+	}
+
+	XnRegistrationCalibration m_calibration;
+	XnDepthRegistration* m_pRegistration;
+};
+
+TEST_F(DepthRegistrationTest, IdentityKeepsDepth)
+{
+	InitCalibration(m_calibration, 0);
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationCreate(&m_calibration, TEST_X_RES, TEST_Y_RES, TEST_X_RES, TEST_Y_RES, FALSE, 1, &m_pRegistration));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	XnDepthPixel aRegistered[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		aDepth[i] = (XnDepthPixel)(i % 7 == 0 ? 0 : 500 + i);
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationRegister(m_pRegistration, aDepth, aRegistered));
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		ASSERT_EQ(aDepth[i], aRegistered[i]) << "at " << i;
+	}
+}
+
+TEST_F(DepthRegistrationTest, ClosestDepthWins)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationCreate(&m_calibration, TEST_X_RES, TEST_Y_RES, TEST_X_RES, TEST_Y_RES, FALSE, 1, &m_pRegistration));
+
+	// background at 1000mm, and a column at 500mm in front of it
+	XnDepthPixel aDepth[TEST_PIXELS];
+	FillFrame(aDepth, 1000);
+	for (XnUInt32 y = 0; y < TEST_Y_RES; ++y)
+	{
+		aDepth[y * TEST_X_RES + 10] = 500;
+	}
+
+	XnDepthPixel aRegistered[TEST_PIXELS];
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationRegister(m_pRegistration, aDepth, aRegistered));
+
+	for (XnUInt32 y = 0; y < TEST_Y_RES; ++y)
+	{
+		const XnDepthPixel* pRow = aRegistered + y * TEST_X_RES;
+		// background moves by 1 pixel, so the first column gets nothing
+		EXPECT_EQ(0, pRow[0]);
+		EXPECT_EQ(1000, pRow[5]);
+		// the foreground column moves by 2 pixels, onto the background of column 11
+		EXPECT_EQ(500, pRow[12]);
+		// and leaves a shadow where the background behind it would have been
+		EXPECT_EQ(0, pRow[11]);
+		EXPECT_EQ(1000, pRow[13]);
+	}
+}
+
+TEST_F(DepthRegistrationTest, ThreadsAndInPlaceGiveSameResult)
+{
+	// a slightly rotated calibration, so that rows and columns mix
+	m_calibration.aRotation[1] = 0.02;
+	m_calibration.aRotation[3] = -0.02;
+	m_calibration.aTranslation[1] = 3.0;
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		aDepth[i] = (XnDepthPixel)((i * 7919) % 3000);
+	}
+
+	XnDepthPixel aSingle[TEST_PIXELS];
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationCreate(&m_calibration, TEST_X_RES, TEST_Y_RES, TEST_X_RES, TEST_Y_RES, FALSE, 1, &m_pRegistration));
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationRegister(m_pRegistration, aDepth, aSingle));
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationDestroy(&m_pRegistration));
+
+	XnDepthPixel aThreaded[TEST_PIXELS];
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationCreate(&m_calibration, TEST_X_RES, TEST_Y_RES, TEST_X_RES, TEST_Y_RES, FALSE, 4, &m_pRegistration));
+	// twice, to check the z-buffers are cleared between frames
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationRegister(m_pRegistration, aDepth, aThreaded));
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationRegister(m_pRegistration, aDepth, aThreaded));
+	ASSERT_EQ(0, xnOSMemCmp(aSingle, aThreaded, sizeof(aSingle)));
+
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationRegister(m_pRegistration, aDepth, aDepth));
+	ASSERT_EQ(0, xnOSMemCmp(aSingle, aDepth, sizeof(aSingle)));
+}
+
+TEST_F(DepthRegistrationTest, MapPoints)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationCreate(&m_calibration, TEST_X_RES, TEST_Y_RES, TEST_X_RES * 2, TEST_Y_RES * 2, FALSE, 1, &m_pRegistration));
+
+	XnPoint3D aPoints[3] = { { 10, 20, 1000 }, { 10, 20, 500 }, { 10, 20, 0 } };
+	ASSERT_EQ(XN_STATUS_OK, xnDepthRegistrationMapPoints(m_pRegistration, 3, aPoints, aPoints));
+
+	// the output has twice the resolution, so shifts double as well
+	EXPECT_NEAR(22, aPoints[0].X, 1e-3);
+	EXPECT_NEAR(40, aPoints[0].Y, 1e-3);
+	EXPECT_EQ(1000, aPoints[0].Z);
+	EXPECT_NEAR(24, aPoints[1].X, 1e-3);
+	EXPECT_EQ(0, aPoints[2].Z);
+}
+
+TEST_F(DepthRegistrationTest, MockDepthRegistersToImage)
+{
+	Context context;
+	MockDepthGenerator depth;
+	MockImageGenerator image;
+	XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	ASSERT_EQ(XN_STATUS_OK, depth.Create(context));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+	ASSERT_EQ(XN_STATUS_OK, image.Create(context));
+	ASSERT_EQ(XN_STATUS_OK, image.SetMapOutputMode(mode));
+
+	EXPECT_FALSE(depth.IsCapabilitySupported(XN_CAPABILITY_ALTERNATIVE_VIEW_POINT) == TRUE);
+	EXPECT_EQ(XN_STATUS_NOT_IMPLEMENTED, depth.GetAlternativeViewPointCap().SetViewPoint(image));
+
+	ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(m_calibration), &m_calibration));
+	ASSERT_TRUE(depth.IsCapabilitySupported(XN_CAPABILITY_ALTERNATIVE_VIEW_POINT) == TRUE);
+	EXPECT_TRUE(depth.GetAlternativeViewPointCap().IsViewPointSupported(image) == TRUE);
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	FillFrame(aDepth, 1000);
+	aDepth[5 * TEST_X_RES + 10] = 500;
+
+	// not registered yet
+	XnUInt32 nAltX = 0;
+	XnUInt32 nAltY = 0;
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(1, 1000, sizeof(aDepth), aDepth));
+	EXPECT_EQ(500, depth.GetDepthMap()[5 * TEST_X_RES + 10]);
+	ASSERT_EQ(XN_STATUS_OK, depth.GetAlternativeViewPointCap().GetPixelCoordinatesInViewPoint(image, 10, 5, nAltX, nAltY));
+	EXPECT_EQ(12U, nAltX);
+	EXPECT_EQ(5U, nAltY);
+
+	ASSERT_EQ(XN_STATUS_OK, depth.GetAlternativeViewPointCap().SetViewPoint(image));
+	EXPECT_TRUE(depth.GetAlternativeViewPointCap().IsViewPointAs(image) == TRUE);
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(2, 2000, sizeof(aDepth), aDepth));
+	EXPECT_EQ(0, depth.GetDepthMap()[5 * TEST_X_RES + 11]);
+	EXPECT_EQ(500, depth.GetDepthMap()[5 * TEST_X_RES + 12]);
+	EXPECT_EQ(0, depth.GetDepthMap()[5 * TEST_X_RES + 0]);
+
+	// registered pixels are already in the image's view point
+	ASSERT_EQ(XN_STATUS_OK, depth.GetAlternativeViewPointCap().GetPixelCoordinatesInViewPoint(image, 12, 5, nAltX, nAltY));
+	EXPECT_EQ(12U, nAltX);
+	EXPECT_EQ(5U, nAltY);
+
+	ASSERT_EQ(XN_STATUS_OK, depth.GetAlternativeViewPointCap().ResetViewPoint());
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(3, 3000, sizeof(aDepth), aDepth));
+	EXPECT_EQ(500, depth.GetDepthMap()[5 * TEST_X_RES + 10]);
+
+	image.Release();
+	depth.Release();
+	context.Release();
+}
+
+TEST_F(DepthRegistrationTest, MockDepthKeepsUpdatingAfterFailedRegistration)
+{
+	Context context;
+	MockDepthGenerator depth;
+	MockImageGenerator image;
+	XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	ASSERT_EQ(XN_STATUS_OK, depth.Create(context));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+	ASSERT_EQ(XN_STATUS_OK, image.Create(context));
+	ASSERT_EQ(XN_STATUS_OK, image.SetMapOutputMode(mode));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(m_calibration), &m_calibration));
+	ASSERT_EQ(XN_STATUS_OK, depth.GetAlternativeViewPointCap().SetViewPoint(image));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	FillFrame(aDepth, 1000);
+	aDepth[5 * TEST_X_RES + 10] = 500;
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(1, 1000, sizeof(aDepth), aDepth));
+
+	// the engine can't be built from intrinsics without a focal length
+	XnRegistrationCalibration invalid = m_calibration;
+	invalid.depth.fFocalLengthX = 0;
+	ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(invalid), &invalid));
+	EXPECT_NE(XN_STATUS_OK, depth.SetData(2, 2000, sizeof(aDepth), aDepth));
+
+	// the frame is still consumed, unregistered
+	EXPECT_FALSE(depth.IsNewDataAvailable() == TRUE);
+	ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+	EXPECT_EQ(2U, depth.GetFrameID());
+	EXPECT_EQ(sizeof(aDepth), depth.GetDataSize());
+	EXPECT_EQ(500, depth.GetDepthMap()[5 * TEST_X_RES + 10]);
+
+	// and the next one is registered again
+	ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(m_calibration), &m_calibration));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(3, 3000, sizeof(aDepth), aDepth));
+	EXPECT_EQ(3U, depth.GetFrameID());
+	EXPECT_EQ(sizeof(aDepth), depth.GetDataSize());
+	EXPECT_EQ(500, depth.GetDepthMap()[5 * TEST_X_RES + 12]);
+
+	image.Release();
+	depth.Release();
+	context.Release();
+}
+
+TEST_F(DepthRegistrationTest, RecordedCalibrationRegistersPlayback)
+{
+	const XnChar* strFileName = "DepthRegistrationTest.oni";
+
+	{
+		Context context;
+		MockDepthGenerator depth;
+		Recorder recorder;
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(m_calibration), &m_calibration));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, strFileName));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, XN_CODEC_UNCOMPRESSED));
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		FillFrame(aDepth, 1000);
+		ASSERT_EQ(XN_STATUS_OK, depth.SetData(1, 1000, sizeof(aDepth), aDepth));
+		ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+
+		recorder.Release();
+		depth.Release();
+		context.Release();
+	}
+
+	Context playback;
+	Player player;
+	ASSERT_EQ(XN_STATUS_OK, playback.Init());
+	ASSERT_EQ(XN_STATUS_OK, playback.OpenFileRecording(strFileName, player));
+
+	DepthGenerator played;
+	ASSERT_EQ(XN_STATUS_OK, playback.FindExistingNode(XN_NODE_TYPE_DEPTH, played));
+	XnRegistrationCalibration calibration;
+	ASSERT_EQ(XN_STATUS_OK, played.GetGeneralProperty(XN_PROP_REGISTRATION_CALIBRATION, sizeof(calibration), &calibration));
+	EXPECT_EQ(0, xnOSMemCmp(&m_calibration, &calibration, sizeof(calibration)));
+	ASSERT_TRUE(played.IsCapabilitySupported(XN_CAPABILITY_ALTERNATIVE_VIEW_POINT) == TRUE);
+
+	// played nodes are locked, but their view point may still change
+	MockImageGenerator image;
+	ASSERT_EQ(XN_STATUS_OK, image.Create(playback));
+	ASSERT_EQ(XN_STATUS_OK, played.GetAlternativeViewPointCap().SetViewPoint(image));
+
+	ASSERT_EQ(XN_STATUS_OK, played.WaitAndUpdateData());
+	DepthMetaData md;
+	played.GetMetaData(md);
+	EXPECT_EQ(0, md(0, 0));
+	EXPECT_EQ(1000, md(1, 0));
+	EXPECT_EQ(1000, md(TEST_X_RES - 1, 0));
+
+	image.Release();
+	played.Release();
+	player.Release();
+	playback.Release();
+	xnOSDeleteFile(strFileName);
+}
@@ -0,0 +1,291 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <algorithm>
+#include <math.h>
+
+using namespace xn;
+
+#define TEST_X_RES	64
+#define TEST_Y_RES	48
+#define TEST_PIXELS	(TEST_X_RES * TEST_Y_RES)
+
+class FilterNodeTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+		ASSERT_EQ(XN_STATUS_OK, m_depth.Create(m_context, "FilterInput"));
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetMapOutputMode(mode));
+		XnFieldOfView fov = { 1.0, 0.8 };
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetGeneralProperty(XN_PROP_FIELD_OF_VIEW, sizeof(fov), &fov));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+		m_nFrameID = 0;
+	}
+
+	virtual void TearDown()
+	{
+		m_filter.Release();
+		m_depth.Release();
+		m_context.Release();
+	}
+
+	void PushFrame()
+	{
+		++m_nFrameID;
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetData(m_nFrameID, m_nFrameID * 1000, sizeof(m_frame), m_frame));
+		ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+	}
+
+	void FillFrame(XnDepthPixel nValue)
+	{
+		for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+		{
+			m_frame[i] = nValue;
+		}
+	}
+
+	Context m_context;
+	MockDepthGenerator m_depth;
+	DepthGenerator m_filter;
+	XnDepthPixel m_frame[TEST_PIXELS];
+	XnUInt32 m_nFrameID;
+};
+
+TEST_F(FilterNodeTest, GeometricStagesAreComposed)
+{
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		m_frame[i] = (XnDepthPixel)(i + 1);
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, m_depth.CreateFilter("crop:4,2,56,40; downscale:2; mirror", m_filter));
+	ASSERT_EQ(XN_STATUS_OK, m_filter.StartGenerating());
+
+	XnMapOutputMode mode;
+	ASSERT_EQ(XN_STATUS_OK, m_filter.GetMapOutputMode(mode));
+	EXPECT_EQ(28U, mode.nXRes);
+	EXPECT_EQ(20U, mode.nYRes);
+	EXPECT_EQ(30U, mode.nFPS);
+
+	PushFrame();
+
+	DepthMetaData md;
+	m_filter.GetMetaData(md);
+	ASSERT_EQ(28U, md.XRes());
+	ASSERT_EQ(20U, md.YRes());
+	EXPECT_EQ(m_nFrameID, md.FrameID());
+	EXPECT_EQ(m_nFrameID * 1000, md.Timestamp());
+
+	for (XnUInt32 y = 0; y < md.YRes(); ++y)
+	{
+		for (XnUInt32 x = 0; x < md.XRes(); ++x)
+		{
+			XnUInt32 nSrcX = 4 + (27 - x) * 2;
+			XnUInt32 nSrcY = 2 + y * 2;
+			ASSERT_EQ(m_frame[nSrcY * TEST_X_RES + nSrcX], md(x, y)) << "at " << x << "," << y;
+		}
+	}
+
+	// a quarter of the width is covered, so the view angle shrinks accordingly
+	XnFieldOfView fov;
+	ASSERT_EQ(XN_STATUS_OK, m_filter.GetFieldOfView(fov));
+	EXPECT_NEAR(2 * atan(tan(0.5) * 56 / 64), fov.fHFOV, 1e-6);
+}
+
+TEST_F(FilterNodeTest, ThresholdAndTemporalStages)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_depth.CreateFilter("threshold:100,2000;holefill;median:3", m_filter));
+	ASSERT_EQ(XN_STATUS_OK, m_filter.StartGenerating());
+
+	const XnDepthPixel aInputs[] = { 1000, 40000, 1200, 50, 900 };
+	// 40000 and 50 are thresholded to 0, and then filled with the last valid value
+	const XnDepthPixel aFilled[] = { 1000, 1000, 1200, 1200, 900 };
+
+	for (XnUInt32 i = 0; i < sizeof(aInputs) / sizeof(aInputs[0]); ++i)
+	{
+		FillFrame(aInputs[i]);
+		PushFrame();
+
+		// lower median of the last (up to) 3 filled values
+		XnDepthPixel aWindow[3];
+		XnUInt32 nWindow = 0;
+		for (XnUInt32 j = (i >= 2 ? i - 2 : 0); j <= i; ++j)
+		{
+			aWindow[nWindow++] = aFilled[j];
+		}
+		std::sort(aWindow, aWindow + nWindow);
+		XnDepthPixel nExpected = aWindow[(nWindow - 1) / 2];
+
+		const XnDepthPixel* pDepth = m_filter.GetDepthMap();
+		ASSERT_TRUE(pDepth != NULL);
+		for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+		{
+			ASSERT_EQ(nExpected, pDepth[p]) << "frame " << i << " pixel " << p;
+		}
+	}
+}
+
+TEST_F(FilterNodeTest, StagesCanBeChanged)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_depth.CreateFilter(NULL, m_filter, "MyFilter"));
+	EXPECT_STREQ("MyFilter", m_filter.GetName());
+
+	XnMapOutputMode mode;
+	ASSERT_EQ(XN_STATUS_OK, m_filter.GetMapOutputMode(mode));
+	EXPECT_EQ((XnUInt32)TEST_X_RES, mode.nXRes);
+
+	ASSERT_EQ(XN_STATUS_OK, m_filter.SetStringProperty(XN_PROP_FILTER_STAGES, "downscale:4"));
+	ASSERT_EQ(XN_STATUS_OK, m_filter.GetMapOutputMode(mode));
+	EXPECT_EQ(TEST_X_RES / 4U, mode.nXRes);
+	EXPECT_EQ(TEST_Y_RES / 4U, mode.nYRes);
+
+	XnChar strStages[100];
+	ASSERT_EQ(XN_STATUS_OK, m_filter.GetStringProperty(XN_PROP_FILTER_STAGES, strStages, sizeof(strStages)));
+	EXPECT_STREQ("downscale:4", strStages);
+
+	// bad stages are rejected, and the old ones are kept
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, m_filter.SetStringProperty(XN_PROP_FILTER_STAGES, "blur:3"));
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, m_filter.SetStringProperty(XN_PROP_FILTER_STAGES, "crop:0,0,100,10"));
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, m_filter.SetStringProperty(XN_PROP_FILTER_STAGES, "median:20"));
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, m_filter.SetStringProperty(XN_PROP_FILTER_STAGES, "threshold:10"));
+	ASSERT_EQ(XN_STATUS_OK, m_filter.GetMapOutputMode(mode));
+	EXPECT_EQ(TEST_X_RES / 4U, mode.nXRes);
+}
+
+TEST_F(FilterNodeTest, ImageFiltersOnlySupportGeometricStages)
+{
+	MockImageGenerator image;
+	ASSERT_EQ(XN_STATUS_OK, image.Create(m_context, "FilterImage"));
+	XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+	ASSERT_EQ(XN_STATUS_OK, image.SetMapOutputMode(mode));
+	ASSERT_EQ(XN_STATUS_OK, image.SetPixelFormat(XN_PIXEL_FORMAT_RGB24));
+	ASSERT_EQ(XN_STATUS_OK, image.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+	ImageGenerator filter;
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, image.CreateFilter("median:3", filter));
+	ASSERT_EQ(XN_STATUS_OK, image.CreateFilter("mirror", filter));
+	ASSERT_EQ(XN_STATUS_OK, filter.StartGenerating());
+	EXPECT_EQ(XN_PIXEL_FORMAT_RGB24, filter.GetPixelFormat());
+
+	XnRGB24Pixel aImage[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		aImage[i].nRed = (XnUInt8)i;
+		aImage[i].nGreen = (XnUInt8)(i >> 8);
+		aImage[i].nBlue = 7;
+	}
+	ASSERT_EQ(XN_STATUS_OK, image.SetData(1, 1000, sizeof(aImage), (const XnUInt8*)aImage));
+	ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+
+	ImageMetaData md;
+	filter.GetMetaData(md);
+	ASSERT_EQ((XnUInt32)TEST_X_RES, md.XRes());
+	for (XnUInt32 y = 0; y < md.YRes(); ++y)
+	{
+		for (XnUInt32 x = 0; x < md.XRes(); ++x)
+		{
+			const XnRGB24Pixel& expected = aImage[y * TEST_X_RES + (TEST_X_RES - 1 - x)];
+			const XnRGB24Pixel& actual = md.RGB24Map()(x, y);
+			ASSERT_EQ(expected.nRed, actual.nRed);
+			ASSERT_EQ(expected.nGreen, actual.nGreen);
+			ASSERT_EQ(expected.nBlue, actual.nBlue);
+		}
+	}
+
+	filter.Release();
+	image.Release();
+}
+
+TEST_F(FilterNodeTest, FilteredOutputCanBeLeased)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_depth.CreateFilter("downscale:2", m_filter));
+	ASSERT_EQ(XN_STATUS_OK, m_filter.StartGenerating());
+	EXPECT_TRUE(m_filter.IsCapabilitySupported(XN_CAPABILITY_FRAME_LEASE) == TRUE);
+
+	FillFrame(11);
+	PushFrame();
+	FrameRef frame;
+	ASSERT_EQ(XN_STATUS_OK, frame.Acquire(m_filter));
+
+	FillFrame(22);
+	PushFrame();
+	PushFrame();
+	EXPECT_EQ(m_nFrameID, m_filter.GetFrameID());
+	EXPECT_EQ(22, m_filter.GetDepthMap()[0]);
+
+	ASSERT_EQ(1U, frame.GetFrameID());
+	ASSERT_EQ(TEST_PIXELS / 4 * sizeof(XnDepthPixel), frame.GetDataSize());
+	EXPECT_EQ(11, ((const XnDepthPixel*)frame.GetData())[0]);
+}
+
+TEST_F(FilterNodeTest, FilterCanBeRecorded)
+{
+	const XnChar* strFileName = "FilterNodeTest.oni";
+
+	ASSERT_EQ(XN_STATUS_OK, m_depth.CreateFilter("crop:0,0,32,24", m_filter, "Cropped"));
+	ASSERT_EQ(XN_STATUS_OK, m_filter.StartGenerating());
+
+	{
+		Recorder recorder;
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(m_context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, strFileName));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(m_filter, XN_CODEC_UNCOMPRESSED));
+
+		for (XnDepthPixel i = 1; i <= 3; ++i)
+		{
+			FillFrame(i * 100);
+			PushFrame();
+		}
+
+		recorder.Release();
+	}
+
+	Context playback;
+	Player player;
+	ASSERT_EQ(XN_STATUS_OK, playback.Init());
+	ASSERT_EQ(XN_STATUS_OK, playback.OpenFileRecording(strFileName, player));
+
+	DepthGenerator played;
+	ASSERT_EQ(XN_STATUS_OK, playback.FindExistingNode(XN_NODE_TYPE_DEPTH, played));
+	EXPECT_STREQ("Cropped", played.GetName());
+
+	XnUInt32 nFrames = 0;
+	ASSERT_EQ(XN_STATUS_OK, player.GetNumFrames(played.GetName(), nFrames));
+	EXPECT_EQ(3U, nFrames);
+
+	ASSERT_EQ(XN_STATUS_OK, played.WaitAndUpdateData());
+	DepthMetaData md;
+	played.GetMetaData(md);
+	EXPECT_EQ(32U, md.XRes());
+	EXPECT_EQ(24U, md.YRes());
+	EXPECT_EQ(100, md(31, 23));
+
+	played.Release();
+	player.Release();
+	playback.Release();
+	xnOSDeleteFile(strFileName);
+}
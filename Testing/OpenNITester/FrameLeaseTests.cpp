@@ -0,0 +1,172 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+
+using namespace xn;
+
+#define TEST_X_RES	64
+#define TEST_Y_RES	48
+#define TEST_PIXELS	(TEST_X_RES * TEST_Y_RES)
+
+class FrameLeaseTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+		ASSERT_EQ(XN_STATUS_OK, m_depth.Create(m_context, "LeaseDepth"));
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+	}
+
+	virtual void TearDown()
+	{
+		m_depth.Release();
+		m_context.Release();
+	}
+
+	// every pixel of frame n holds n, so a frame that was overwritten is easy to spot
+	void PushFrame(XnUInt32 nFrame)
+	{
+		for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+		{
+			m_frame[i] = (XnDepthPixel)nFrame;
+		}
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetData(nFrame, nFrame * 1000, sizeof(m_frame), m_frame));
+	}
+
+	static XnBool HoldsFrame(const FrameRef& frame, XnUInt32 nFrame)
+	{
+		if (!frame.IsValid() || frame.GetFrameID() != nFrame || frame.GetDataSize() != sizeof(m_frame))
+		{
+			return FALSE;
+		}
+
+		const XnDepthPixel* pData = (const XnDepthPixel*)frame.GetData();
+		for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+		{
+			if (pData[i] != nFrame)
+			{
+				return FALSE;
+			}
+		}
+
+		return TRUE;
+	}
+
+	Context m_context;
+	MockDepthGenerator m_depth;
+	XnDepthPixel m_frame[TEST_PIXELS];
+};
+
+TEST_F(FrameLeaseTest, MockNodesSupportLeasing)
+{
+	EXPECT_TRUE(m_depth.IsCapabilitySupported(XN_CAPABILITY_FRAME_LEASE) == TRUE);
+}
+
+TEST_F(FrameLeaseTest, LeasedFrameSurvivesUpdates)
+{
+	FrameRef frame;
+	PushFrame(1);
+	ASSERT_EQ(XN_STATUS_OK, frame.Acquire(m_depth));
+
+	PushFrame(2);
+	PushFrame(3);
+
+	EXPECT_EQ(3U, m_depth.GetFrameID());
+	EXPECT_TRUE(HoldsFrame(frame, 1));
+
+	frame.Release();
+	EXPECT_FALSE(frame.IsValid() == TRUE);
+}
+
+TEST_F(FrameLeaseTest, PoolGrowsForManyLeases)
+{
+	const XnUInt32 nFrames = 8;
+	FrameRef frames[nFrames];
+
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		PushFrame(i + 1);
+		ASSERT_EQ(XN_STATUS_OK, frames[i].Acquire(m_depth));
+	}
+
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		EXPECT_TRUE(HoldsFrame(frames[i], i + 1));
+	}
+}
+
+TEST_F(FrameLeaseTest, FixedPoolDropsNewFrames)
+{
+	XnFramePoolPolicy policy = { 3, 0, XN_FRAME_POOL_DROP };
+	ASSERT_EQ(XN_STATUS_OK, m_depth.GetFrameLeaseCap().SetFramePoolPolicy(policy));
+
+	FrameRef first;
+	FrameRef second;
+	PushFrame(1);
+	ASSERT_EQ(XN_STATUS_OK, first.Acquire(m_depth));
+	PushFrame(2);
+	ASSERT_EQ(XN_STATUS_OK, second.Acquire(m_depth));
+
+	// all buffers are in use, so these are dropped
+	PushFrame(3);
+	PushFrame(4);
+	EXPECT_EQ(2U, m_depth.GetFrameID());
+
+	first.Release();
+	PushFrame(5);
+	EXPECT_EQ(5U, m_depth.GetFrameID());
+	EXPECT_TRUE(HoldsFrame(second, 2));
+}
+
+TEST_F(FrameLeaseTest, BadPolicyIsRejected)
+{
+	XnFramePoolPolicy policy = { 1, 0, XN_FRAME_POOL_DROP };
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, m_depth.GetFrameLeaseCap().SetFramePoolPolicy(policy));
+
+	XnFramePoolPolicy current;
+	ASSERT_EQ(XN_STATUS_OK, m_depth.GetFrameLeaseCap().GetFramePoolPolicy(current));
+	EXPECT_EQ(XN_FRAME_POOL_GROW, current.overflow);
+}
+
+TEST_F(FrameLeaseTest, ReleasingUnknownFrameFails)
+{
+	PushFrame(1);
+	XnFrameLease lease;
+	xnOSMemSet(&lease, 0, sizeof(lease));
+	lease.pData = m_frame;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, m_depth.GetFrameLeaseCap().ReleaseFrame(lease));
+}
+
+TEST_F(FrameLeaseTest, FrameOutlivesNodeHandle)
+{
+	FrameRef frame;
+	PushFrame(7);
+	ASSERT_EQ(XN_STATUS_OK, frame.Acquire(m_depth));
+
+	// the frame holds its own reference to the node
+	m_depth.Release();
+	EXPECT_TRUE(HoldsFrame(frame, 7));
+}
@@ -0,0 +1,208 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <XnOniFrameReader.h>
+
+using namespace xn;
+
+#define TEST_X_RES			160
+#define TEST_Y_RES			120
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_MAX_FRAME_SIZE	(TEST_PIXELS * sizeof(XnRGB24Pixel))
+
+class ImageCodecTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		m_image.Release();
+		m_context.Release();
+		xnOSDeleteFile("ImageCodecTest.oni");
+	}
+
+	void CreateImage(XnPixelFormat format)
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, m_image.Create(m_context, "Image"));
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+
+		XnSupportedPixelFormats formats;
+		xnOSMemSet(&formats, 0, sizeof(formats));
+		formats.m_bRGB24 = TRUE;
+		formats.m_bYUV422 = TRUE;
+		formats.m_bGrayscale8Bit = TRUE;
+		formats.m_bGrayscale16Bit = TRUE;
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetGeneralProperty(XN_PROP_SUPPORTED_PIXEL_FORMATS, sizeof(formats), &formats));
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetIntProperty(XN_PROP_PIXEL_FORMAT, format));
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+	}
+
+	// smooth shading with a bright square, a little sensor noise, and frame dependent motion
+	static XnUInt32 FillScene(XnPixelFormat format, XnUInt8* pImage, XnUInt32 nFrame)
+	{
+		XnUInt32 nBytesPerPixel = xnGetBytesPerPixelForPixelFormat(format);
+		XnUInt32 nSeed = nFrame + 1;
+		for (XnUInt32 y = 0; y < TEST_Y_RES; ++y)
+		{
+			for (XnUInt32 x = 0; x < TEST_X_RES; ++x)
+			{
+				nSeed = nSeed * 1103515245 + 12345;
+				XnUInt32 nNoise = (nSeed >> 16) % 3;
+				XnBool bSquare = (x - nFrame > 40 && x - nFrame < 80 && y > 30 && y < 70);
+				XnUInt8* pPixel = pImage + (y * TEST_X_RES + x) * nBytesPerPixel;
+				for (XnUInt32 c = 0; c < nBytesPerPixel; ++c)
+				{
+					XnUInt32 nValue = bSquare ? 220 - c * 30 : x / 2 + y / 3 + c * 20;
+					pPixel[c] = (XnUInt8)(nValue + nNoise);
+				}
+				if (format == XN_PIXEL_FORMAT_GRAYSCALE_16_BIT)
+				{
+					*(XnUInt16*)pPixel = (XnUInt16)((bSquare ? 3000 : x * 10 + y * 7) + nNoise);
+				}
+			}
+		}
+
+		return TEST_PIXELS * nBytesPerPixel;
+	}
+
+	XnUInt32 RoundTrip(Codec& codec, const XnUInt8* pImage, XnUInt32 nSize)
+	{
+		XnUInt8 aEncoded[TEST_MAX_FRAME_SIZE * 2];
+		XnUInt8 aDecoded[TEST_MAX_FRAME_SIZE];
+		XnUInt nEncodedSize = 0;
+		XnUInt nDecodedSize = 0;
+		EXPECT_EQ(XN_STATUS_OK, codec.EncodeData(pImage, nSize, aEncoded, sizeof(aEncoded), &nEncodedSize));
+		EXPECT_EQ(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize));
+		EXPECT_EQ(nSize, nDecodedSize);
+		EXPECT_EQ(0, memcmp(pImage, aDecoded, nSize));
+		return nEncodedSize;
+	}
+
+	Context m_context;
+	MockImageGenerator m_image;
+};
+
+TEST_F(ImageCodecTest, LosslessRoundTripsAllPixelFormats)
+{
+	XnPixelFormat aFormats[] = { XN_PIXEL_FORMAT_RGB24, XN_PIXEL_FORMAT_YUV422, XN_PIXEL_FORMAT_GRAYSCALE_8_BIT, XN_PIXEL_FORMAT_GRAYSCALE_16_BIT };
+	CreateImage(aFormats[0]);
+
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_IMAGE_LOSSLESS, m_image, codec));
+
+	XnUInt8 aImage[TEST_MAX_FRAME_SIZE];
+	for (XnUInt32 i = 0; i < sizeof(aFormats) / sizeof(aFormats[0]); ++i)
+	{
+		// the codec follows the node's pixel format
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetIntProperty(XN_PROP_PIXEL_FORMAT, aFormats[i]));
+		XnUInt32 nSize = FillScene(aFormats[i], aImage, 0);
+		EXPECT_GT(nSize / 2, RoundTrip(codec, aImage, nSize)) << xnPixelFormatToString(aFormats[i]);
+	}
+
+	codec.Release();
+}
+
+TEST_F(ImageCodecTest, LosslessIsSmallerThan8z)
+{
+	CreateImage(XN_PIXEL_FORMAT_GRAYSCALE_8_BIT);
+
+	Codec codec;
+	Codec codec8z;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_IMAGE_LOSSLESS, m_image, codec));
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_8Z, m_image, codec8z));
+
+	XnUInt8 aImage[TEST_MAX_FRAME_SIZE];
+	XnUInt32 nSize = FillScene(XN_PIXEL_FORMAT_GRAYSCALE_8_BIT, aImage, 0);
+	EXPECT_LT(RoundTrip(codec, aImage, nSize), RoundTrip(codec8z, aImage, nSize));
+
+	codec8z.Release();
+	codec.Release();
+}
+
+TEST_F(ImageCodecTest, LosslessStoresNoiseAndRejectsCorruptFrames)
+{
+	CreateImage(XN_PIXEL_FORMAT_RGB24);
+
+	Codec codec;
+	ASSERT_EQ(XN_STATUS_OK, m_context.CreateCodec(XN_CODEC_IMAGE_LOSSLESS, m_image, codec));
+
+	// noise doesn't compress, but costs no more than a small header
+	XnUInt8 aImage[TEST_MAX_FRAME_SIZE];
+	XnUInt32 nSeed = 1;
+	for (XnUInt32 i = 0; i < sizeof(aImage); ++i)
+	{
+		nSeed = nSeed * 1103515245 + 12345;
+		aImage[i] = (XnUInt8)(nSeed >> 16);
+	}
+	EXPECT_GE(sizeof(aImage) + 32, RoundTrip(codec, aImage, sizeof(aImage)));
+
+	XnUInt32 nSize = FillScene(XN_PIXEL_FORMAT_RGB24, aImage, 0);
+	XnUInt8 aEncoded[TEST_MAX_FRAME_SIZE * 2];
+	XnUInt8 aDecoded[TEST_MAX_FRAME_SIZE];
+	XnUInt nEncodedSize = 0;
+	XnUInt nDecodedSize = 0;
+	ASSERT_EQ(XN_STATUS_OK, codec.EncodeData(aImage, nSize, aEncoded, sizeof(aEncoded), &nEncodedSize));
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize / 2, aDecoded, sizeof(aDecoded), &nDecodedSize));
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded) / 2, &nDecodedSize));
+	aEncoded[nEncodedSize - 10] ^= 0x5A;
+	EXPECT_NE(XN_STATUS_OK, codec.DecodeData(aEncoded, nEncodedSize, aDecoded, sizeof(aDecoded), &nDecodedSize));
+
+	codec.Release();
+}
+
+TEST_F(ImageCodecTest, LosslessRecordingIsReadable)
+{
+	CreateImage(XN_PIXEL_FORMAT_YUV422);
+
+	Recorder recorder;
+	ASSERT_EQ(XN_STATUS_OK, recorder.Create(m_context));
+	ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, "ImageCodecTest.oni"));
+	ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(m_image, XN_CODEC_IMAGE_LOSSLESS));
+
+	XnUInt8 aImage[TEST_MAX_FRAME_SIZE];
+	XnUInt32 nSize = 0;
+	for (XnUInt32 i = 0; i < 5; ++i)
+	{
+		nSize = FillScene(XN_PIXEL_FORMAT_YUV422, aImage, i);
+		ASSERT_EQ(XN_STATUS_OK, m_image.SetData(i + 1, i * 33333, nSize, aImage));
+		ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+	}
+	recorder.Release();
+
+	XnOniFrameReader* pReader = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderOpen("ImageCodecTest.oni", &pReader));
+	XnUInt32 nNode = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Image", &nNode));
+
+	XnUInt8 aDecoded[TEST_MAX_FRAME_SIZE];
+	XnOniFrameInfo info;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderReadFrame(pReader, nNode, 3, aDecoded, sizeof(aDecoded), &info));
+	FillScene(XN_PIXEL_FORMAT_YUV422, aImage, 3);
+	EXPECT_EQ(0, memcmp(aImage, aDecoded, nSize));
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderClose(&pReader));
+}
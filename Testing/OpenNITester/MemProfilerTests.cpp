@@ -0,0 +1,219 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnOS.h>
+#include <string>
+#include <vector>
+
+#define TEST_SNAPSHOT_FILE		"MemProfilerTest.txt"
+#define TEST_SNAPSHOT_PREFIX	"MemProfilerPeriodic"
+
+static std::string ReadFile(const char* strFileName)
+{
+	std::string result;
+	FILE* pFile = fopen(strFileName, "rb");
+	if (pFile == NULL)
+	{
+		return result;
+	}
+
+	char buffer[4096];
+	size_t nRead;
+	while ((nRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+	{
+		result.append(buffer, nRead);
+	}
+	fclose(pFile);
+	return result;
+}
+
+class MemProfilerTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnOSMemProfilerStopPeriodicSnapshots();
+		xnOSMemProfilerStop();
+		for (size_t i = 0; i < m_blocks.size(); ++i)
+		{
+			xnOSLogMemFree(m_blocks[i]);
+			free(m_blocks[i]);
+		}
+		m_blocks.clear();
+		xnOSDeleteFile(TEST_SNAPSHOT_FILE);
+	}
+
+	void Allocate(XnUInt32 nCount, XnUInt32 nBytes)
+	{
+		for (XnUInt32 i = 0; i < nCount; ++i)
+		{
+			m_blocks.push_back(xnOSLogMemAlloc(malloc(nBytes), XN_ALLOCATION_MALLOC, nBytes, __FUNCTION__, __FILE__, __LINE__, NULL));
+		}
+	}
+
+	void FreeAll()
+	{
+		for (size_t i = 0; i < m_blocks.size(); ++i)
+		{
+			xnOSLogMemFree(m_blocks[i]);
+			free(m_blocks[i]);
+		}
+		m_blocks.clear();
+	}
+
+	std::vector<void*> m_blocks;
+};
+
+TEST_F(MemProfilerTest, EstimatesLiveBytes)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(4096));
+	EXPECT_TRUE(xnOSMemProfilerIsActive());
+
+	// 6.4MB in small blocks, so only ~1 in 64 allocations is sampled
+	Allocate(100000, 64);
+
+	XnMemProfilerStats stats;
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_EQ(4096U, stats.nSamplingInterval);
+	EXPECT_GT(stats.nSampledAllocations, 1000ULL);
+	EXPECT_LT(stats.nSampledAllocations, 2200ULL);
+	EXPECT_EQ(stats.nSampledAllocations, (XnUInt64)stats.nLiveSamples);
+	EXPECT_EQ(0ULL, stats.nDroppedSamples);
+	EXPECT_NEAR(6400000.0, (double)stats.nEstimatedLiveBytes, 6400000.0 * 0.15);
+
+	FreeAll();
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_EQ(0U, stats.nLiveSamples);
+	EXPECT_EQ(0ULL, stats.nEstimatedLiveBytes);
+}
+
+TEST_F(MemProfilerTest, LargeAllocationsAreAlwaysSampled)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(1024));
+
+	Allocate(10, 1024 * 1024);
+
+	XnMemProfilerStats stats;
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_EQ(10U, stats.nLiveSamples);
+	EXPECT_EQ(10ULL * 1024 * 1024, stats.nEstimatedLiveBytes);
+	EXPECT_EQ(1U, stats.nCallSites);
+}
+
+TEST_F(MemProfilerTest, SnapshotReportsGrowthByCallSite)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(1024));
+
+	Allocate(4, 1024 * 1024);
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerWriteSnapshot(TEST_SNAPSHOT_FILE));
+	std::string report = ReadFile(TEST_SNAPSHOT_FILE);
+	EXPECT_NE(std::string::npos, report.find("Estimated live memory: 4194304 bytes (+4194304 since last snapshot)"));
+	EXPECT_NE(std::string::npos, report.find("Allocate"));
+
+	// nothing changed - no growth
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerWriteSnapshot(TEST_SNAPSHOT_FILE));
+	report = ReadFile(TEST_SNAPSHOT_FILE);
+	EXPECT_NE(std::string::npos, report.find("Estimated live memory: 4194304 bytes (+0 since last snapshot)"));
+
+	FreeAll();
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerWriteSnapshot(TEST_SNAPSHOT_FILE));
+	report = ReadFile(TEST_SNAPSHOT_FILE);
+	EXPECT_NE(std::string::npos, report.find("Estimated live memory: 0 bytes (-4194304 since last snapshot)"));
+}
+
+TEST_F(MemProfilerTest, StopDiscardsSamples)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(1024));
+	Allocate(4, 1024 * 1024);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStop());
+	EXPECT_FALSE(xnOSMemProfilerIsActive());
+
+	XnMemProfilerStats stats;
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_EQ(0U, stats.nLiveSamples);
+	EXPECT_EQ(0ULL, stats.nSampledAllocations);
+
+	// allocations are not sampled while stopped
+	Allocate(4, 1024 * 1024);
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_EQ(0U, stats.nLiveSamples);
+}
+
+TEST_F(MemProfilerTest, PeriodicSnapshots)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(1024));
+	Allocate(1, 1024 * 1024);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStartPeriodicSnapshots(TEST_SNAPSHOT_PREFIX, 20));
+	xnOSSleep(200);
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStopPeriodicSnapshots());
+
+	XnBool bExists = FALSE;
+	ASSERT_EQ(XN_STATUS_OK, xnOSDoesFileExist(TEST_SNAPSHOT_PREFIX "-0000.txt", &bExists));
+	EXPECT_TRUE(bExists);
+
+	for (XnUInt32 i = 0; i < 100; ++i)
+	{
+		XnChar strFileName[XN_FILE_MAX_PATH];
+		XnUInt32 nChars;
+		xnOSStrFormat(strFileName, sizeof(strFileName), &nChars, "%s-%04u.txt", TEST_SNAPSHOT_PREFIX, i);
+		xnOSDeleteFile(strFileName);
+	}
+}
+
+TEST_F(MemProfilerTest, CountsDroppedSamplesByCause)
+{
+	// every allocation is sampled
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(1));
+
+	// more distinct call sites than the table holds. The blocks are never dereferenced, so fake addresses do.
+	for (XnUInt32 i = 0; i < 2048; ++i)
+	{
+		xnOSLogMemAlloc((void*)(XnSizeT)(0x100000 + i * 64), XN_ALLOCATION_MALLOC, 64, __FUNCTION__, __FILE__, i + 1, NULL);
+	}
+
+	XnMemProfilerStats stats;
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_GT(stats.nDroppedForCallSites, 0ULL);
+	EXPECT_EQ(0ULL, stats.nDroppedForSampleSlots);
+	EXPECT_EQ(2048ULL, stats.nSampledAllocations + stats.nDroppedForCallSites);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStop());
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerStart(1));
+
+	// more live blocks (of a single call site) than there are samples
+	for (XnUInt32 i = 0; i < 40000; ++i)
+	{
+		xnOSLogMemAlloc((void*)(XnSizeT)(0x100000 + i * 64), XN_ALLOCATION_MALLOC, 64, __FUNCTION__, __FILE__, __LINE__, NULL);
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerGetStats(&stats));
+	EXPECT_EQ(0ULL, stats.nDroppedForCallSites);
+	EXPECT_GT(stats.nDroppedForSampleSlots, 0ULL);
+	EXPECT_EQ(40000ULL, stats.nSampledAllocations + stats.nDroppedForSampleSlots);
+	EXPECT_EQ(stats.nDroppedForSampleSlots, stats.nDroppedSamples);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSMemProfilerWriteSnapshot(TEST_SNAPSHOT_FILE));
+	std::string report = ReadFile(TEST_SNAPSHOT_FILE);
+	EXPECT_NE(std::string::npos, report.find("sample stripe full"));
+}
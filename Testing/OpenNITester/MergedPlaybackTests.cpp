@@ -0,0 +1,371 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+
+using namespace xn;
+
+#define TEST_X_RES			64
+#define TEST_Y_RES			48
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAMES_A		30
+#define TEST_INTERVAL_A		33333
+#define TEST_FRAMES_B		15
+#define TEST_INTERVAL_B		66666
+// the second device stamps every other frame a bit later than the first device
+#define TEST_JITTER_B		1500
+// merged playback doesn't wait for the players to read ahead, so a step might take a few calls
+#define TEST_STEP_TIMEOUT	5000
+
+#define TEST_LIVE_ADDRESS	"127.0.0.1:19571"
+
+typedef struct LiveSourceContext
+{
+	Player* pPlayer;
+	XnStatus nSetSourceStatus;
+} LiveSourceContext;
+
+// the player only returns from SetSource() once a recorder connected
+static XN_THREAD_PROC SetLiveSourceThreadProc(XN_THREAD_PARAM pParam)
+{
+	LiveSourceContext* pContext = (LiveSourceContext*)pParam;
+	pContext->nSetSourceStatus = pContext->pPlayer->SetSource(XN_RECORD_MEDIUM_NETWORK, TEST_LIVE_ADDRESS);
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+class MergedPlaybackTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		Record("MergedPlaybackTestA.oni", "DepthA", TEST_FRAMES_A, TEST_INTERVAL_A, 0);
+		Record("MergedPlaybackTestB.oni", "DepthB", TEST_FRAMES_B, TEST_INTERVAL_B, TEST_JITTER_B);
+
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+		ASSERT_EQ(XN_STATUS_OK, m_context.OpenFileRecording("MergedPlaybackTestA.oni", m_playerA));
+		ASSERT_EQ(XN_STATUS_OK, m_context.OpenFileRecording("MergedPlaybackTestB.oni", m_playerB));
+		ASSERT_EQ(XN_STATUS_OK, m_playerA.SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST));
+		ASSERT_EQ(XN_STATUS_OK, m_playerB.SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST));
+		ASSERT_EQ(XN_STATUS_OK, m_context.GetProductionNodeByName("DepthA", m_depthA));
+		ASSERT_EQ(XN_STATUS_OK, m_context.GetProductionNodeByName("DepthB", m_depthB));
+
+		m_nFramesA = 0;
+		m_nFramesB = 0;
+	}
+
+	virtual void TearDown()
+	{
+		m_depthA.Release();
+		m_depthB.Release();
+		m_playerA.Release();
+		m_playerB.Release();
+		m_context.Release();
+		xnOSDeleteFile("MergedPlaybackTestA.oni");
+		xnOSDeleteFile("MergedPlaybackTestB.oni");
+	}
+
+	// frame i (zero-based) has ID i + 1, timestamp i * nInterval (plus nJitter for odd frames), and all its 
+	// pixels equal to its ID
+	static void Record(const XnChar* strFileName, const XnChar* strNodeName, XnUInt32 nFrames, XnUInt64 nInterval, XnUInt64 nJitter)
+	{
+		Context context;
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		MockDepthGenerator depth;
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context, strNodeName));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+		Recorder recorder;
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, strFileName));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, XN_CODEC_16Z));
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		for (XnUInt32 i = 0; i < nFrames; ++i)
+		{
+			for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+			{
+				aDepth[p] = (XnDepthPixel)(i + 1);
+			}
+
+			ASSERT_EQ(XN_STATUS_OK, depth.SetData(i + 1, i * nInterval + (i % 2) * nJitter, sizeof(aDepth), aDepth));
+			ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+		}
+
+		recorder.Release();
+		depth.Release();
+		context.Release();
+	}
+
+	// calls WaitNoneUpdateAll() until one of the nodes has new data
+	XnStatus UpdateUntilNewData(DepthMetaData& mdA, DepthMetaData& mdB)
+	{
+		XnUInt64 nStart;
+		xnOSGetTimeStamp(&nStart);
+
+		for (;;)
+		{
+			XnStatus nRetVal = m_context.WaitNoneUpdateAll();
+			if (nRetVal != XN_STATUS_OK)
+			{
+				return (nRetVal);
+			}
+
+			m_depthA.GetMetaData(mdA);
+			m_depthB.GetMetaData(mdB);
+			if (mdA.IsDataNew() || mdB.IsDataNew())
+			{
+				return (XN_STATUS_OK);
+			}
+
+			XnUInt64 nNow;
+			xnOSGetTimeStamp(&nNow);
+			if (nNow - nStart > TEST_STEP_TIMEOUT)
+			{
+				return (XN_STATUS_WAIT_DATA_TIMEOUT);
+			}
+
+			xnOSSleep(1);
+		}
+	}
+
+	// plays a single merge step. Checks that frames come in timestamp order, and that frames of the two 
+	// recordings that were taken together are played together.
+	XnStatus PlayStep()
+	{
+		DepthMetaData mdA;
+		DepthMetaData mdB;
+		XnStatus nRetVal = UpdateUntilNewData(mdA, mdB);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			return (nRetVal);
+		}
+
+		if (mdA.IsDataNew())
+		{
+			++m_nFramesA;
+			EXPECT_EQ(mdA.FrameID(), (XnUInt32)mdA(0, 0));
+		}
+
+		if (mdB.IsDataNew())
+		{
+			++m_nFramesB;
+			EXPECT_EQ(mdB.FrameID(), (XnUInt32)mdB(0, 0));
+
+			// every frame of B has a frame of A taken at (almost) the same time
+			EXPECT_TRUE(mdA.IsDataNew());
+			EXPECT_EQ(mdB.Timestamp(), mdA.Timestamp() + ((mdB.FrameID() - 1) % 2) * TEST_JITTER_B);
+		}
+
+		return (XN_STATUS_OK);
+	}
+
+	Context m_context;
+	Player m_playerA;
+	Player m_playerB;
+	DepthGenerator m_depthA;
+	DepthGenerator m_depthB;
+	XnUInt32 m_nFramesA;
+	XnUInt32 m_nFramesB;
+};
+
+TEST_F(MergedPlaybackTest, MergesDifferentFrameRatesUntilEOF)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_playerA.SetRepeat(FALSE));
+	ASSERT_EQ(XN_STATUS_OK, m_playerB.SetRepeat(FALSE));
+
+	XnStatus nRetVal = XN_STATUS_OK;
+	XnUInt32 nSteps = 0;
+	while ((nRetVal = PlayStep()) == XN_STATUS_OK)
+	{
+		++nSteps;
+		ASSERT_LE(nSteps, (XnUInt32)(TEST_FRAMES_A + TEST_FRAMES_B));
+	}
+
+	EXPECT_EQ(XN_STATUS_EOF, nRetVal);
+	EXPECT_EQ((XnUInt32)TEST_FRAMES_A, m_nFramesA);
+	EXPECT_EQ((XnUInt32)TEST_FRAMES_B, m_nFramesB);
+	// synced frames share a step
+	EXPECT_EQ((XnUInt32)TEST_FRAMES_A, nSteps);
+	EXPECT_TRUE(m_playerA.IsEOF());
+	EXPECT_TRUE(m_playerB.IsEOF());
+}
+
+TEST_F(MergedPlaybackTest, SeekRestartsMergeFromNewPosition)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_playerA.SetRepeat(FALSE));
+	ASSERT_EQ(XN_STATUS_OK, m_playerB.SetRepeat(FALSE));
+
+	// play a few frames, so both players have frames read ahead
+	for (XnUInt32 i = 0; i < 5; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, PlayStep());
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, m_playerA.SeekToFrame("DepthA", 20, XN_PLAYER_SEEK_SET));
+	ASSERT_EQ(XN_STATUS_OK, m_playerB.SeekToFrame("DepthB", 10, XN_PLAYER_SEEK_SET));
+
+	XnUInt32 nFrame = 0;
+	ASSERT_EQ(XN_STATUS_OK, m_playerA.TellFrame("DepthA", nFrame));
+	EXPECT_EQ(20U, nFrame);
+	ASSERT_EQ(XN_STATUS_OK, m_playerB.TellFrame("DepthB", nFrame));
+	EXPECT_EQ(10U, nFrame);
+
+	// the frames the seek got to come first (merged playback might not be ready to play anything yet)
+	DepthMetaData mdA;
+	DepthMetaData mdB;
+	ASSERT_EQ(XN_STATUS_OK, m_context.WaitAnyUpdateAll());
+	m_depthA.GetMetaData(mdA);
+	m_depthB.GetMetaData(mdB);
+	EXPECT_EQ(20U, mdA.FrameID());
+	EXPECT_EQ(10U, mdB.FrameID());
+
+	m_nFramesA = 0;
+	m_nFramesB = 0;
+	XnStatus nRetVal = XN_STATUS_OK;
+	while ((nRetVal = PlayStep()) == XN_STATUS_OK)
+	{
+		ASSERT_LE(m_nFramesA, (XnUInt32)TEST_FRAMES_A);
+	}
+
+	EXPECT_EQ(XN_STATUS_EOF, nRetVal);
+	EXPECT_EQ((XnUInt32)(TEST_FRAMES_A - 20), m_nFramesA);
+	EXPECT_EQ((XnUInt32)(TEST_FRAMES_B - 10), m_nFramesB);
+}
+
+TEST_F(MergedPlaybackTest, RepeatContinuesMergedTimeline)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_playerA.SetRepeat(TRUE));
+	ASSERT_EQ(XN_STATUS_OK, m_playerB.SetRepeat(TRUE));
+
+	// play the length of three loops of A
+	for (XnUInt32 i = 0; i < 3 * TEST_FRAMES_A; ++i)
+	{
+		DepthMetaData mdA;
+		DepthMetaData mdB;
+		ASSERT_EQ(XN_STATUS_OK, UpdateUntilNewData(mdA, mdB));
+		m_nFramesA += mdA.IsDataNew() ? 1 : 0;
+		m_nFramesB += mdB.IsDataNew() ? 1 : 0;
+	}
+
+	// both looped, and each one kept the frame rate of its own recording (a looping player is neither starved
+	// nor played ahead of the other)
+	EXPECT_GT(m_nFramesA, 2U * TEST_FRAMES_A);
+	EXPECT_GT(m_nFramesB, 2U * TEST_FRAMES_B);
+	XnDouble dLoopA = (TEST_FRAMES_A - 1) * (XnDouble)TEST_INTERVAL_A;
+	XnDouble dLoopB = (TEST_FRAMES_B - 1) * (XnDouble)TEST_INTERVAL_B;
+	XnDouble dExpectedB = m_nFramesA * (dLoopA / TEST_FRAMES_A) / (dLoopB / TEST_FRAMES_B);
+	EXPECT_NEAR(dExpectedB, (XnDouble)m_nFramesB, 2.0);
+	EXPECT_FALSE(m_playerA.IsEOF());
+	EXPECT_FALSE(m_playerB.IsEOF());
+}
+
+TEST_F(MergedPlaybackTest, NoneUpdateAllDoesNotWaitForReadAhead)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_playerA.SetRepeat(FALSE));
+	ASSERT_EQ(XN_STATUS_OK, m_playerB.SetRepeat(FALSE));
+
+	// a third, live player. As long as its recorder sends nothing, its read-ahead can't get to a frame.
+	Context recordContext;
+	ASSERT_EQ(XN_STATUS_OK, recordContext.Init());
+	MockDepthGenerator depth;
+	XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+	ASSERT_EQ(XN_STATUS_OK, depth.Create(recordContext, "DepthLive"));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+	Player live;
+	ASSERT_EQ(XN_STATUS_OK, live.Create(m_context, "oni"));
+	LiveSourceContext liveContext = { &live, XN_STATUS_ERROR };
+	XN_THREAD_HANDLE hThread = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(SetLiveSourceThreadProc, &liveContext, &hThread));
+
+	Recorder recorder;
+	ASSERT_EQ(XN_STATUS_OK, recorder.Create(recordContext));
+	XnStatus nRetVal = XN_STATUS_ERROR;
+	for (XnUInt32 nTry = 0; nTry < 500 && nRetVal != XN_STATUS_OK; ++nTry)
+	{
+		nRetVal = recorder.SetDestination(XN_RECORD_MEDIUM_NETWORK, TEST_LIVE_ADDRESS);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			xnOSSleep(10);
+		}
+	}
+	ASSERT_EQ(XN_STATUS_OK, nRetVal);
+	ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, XN_CODEC_16Z));
+
+	// opening the source reads up to the first frame
+	XnDepthPixel aDepth[TEST_PIXELS] = { 0 };
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(1, 0, sizeof(aDepth), aDepth));
+	ASSERT_EQ(XN_STATUS_OK, recordContext.WaitNoneUpdateAll());
+	ASSERT_EQ(XN_STATUS_OK, xnOSWaitForThreadExit(hThread, 10000));
+	xnOSCloseThread(&hThread);
+	ASSERT_EQ(XN_STATUS_OK, liveContext.nSetSourceStatus);
+
+	// the first frames of all three were taken together. After them, the other players have their frames 
+	// ready, but the merge order depends on the live one.
+	ASSERT_EQ(XN_STATUS_OK, PlayStep());
+	ASSERT_EQ(1U, m_nFramesA);
+	ASSERT_EQ(1U, m_nFramesB);
+
+	for (XnUInt32 i = 0; i < 10; ++i)
+	{
+		XnUInt64 nStart;
+		XnUInt64 nEnd;
+		xnOSGetTimeStamp(&nStart);
+		ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+		xnOSGetTimeStamp(&nEnd);
+		EXPECT_LT(nEnd - nStart, 50U);
+
+		DepthMetaData mdA;
+		DepthMetaData mdB;
+		m_depthA.GetMetaData(mdA);
+		m_depthB.GetMetaData(mdB);
+		EXPECT_FALSE(mdA.IsDataNew());
+		EXPECT_FALSE(mdB.IsDataNew());
+		xnOSSleep(5);
+	}
+
+	// once the live stream ends, the recordings are merged as usual
+	recorder.Release();
+	while ((nRetVal = PlayStep()) == XN_STATUS_OK)
+	{
+		ASSERT_LE(m_nFramesA, (XnUInt32)TEST_FRAMES_A);
+	}
+
+	EXPECT_EQ(XN_STATUS_EOF, nRetVal);
+	EXPECT_EQ((XnUInt32)TEST_FRAMES_A, m_nFramesA);
+	EXPECT_EQ((XnUInt32)TEST_FRAMES_B, m_nFramesB);
+
+	live.Release();
+	depth.Release();
+	recordContext.Release();
+}
@@ -0,0 +1,262 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <string>
+
+using namespace xn;
+
+#define TEST_X_RES	32
+#define TEST_Y_RES	24
+#define TEST_PIXELS	(TEST_X_RES * TEST_Y_RES)
+
+class MetricsTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_context.Init());
+		ASSERT_EQ(XN_STATUS_OK, m_depth.Create(m_context, "MetricsDepth"));
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetMapOutputMode(mode));
+		xnOSMemSet(m_frame, 0, sizeof(m_frame));
+	}
+
+	virtual void TearDown()
+	{
+		m_depth.Release();
+		m_context.Release();
+	}
+
+	void PushFrame(XnUInt32 nFrameID)
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetData(nFrameID, nFrameID * 1000, sizeof(m_frame), m_frame));
+		ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+	}
+
+	std::string Format()
+	{
+		XnChar csBuffer[16 * 1024];
+		XnUInt32 nWritten = 0;
+		EXPECT_EQ(XN_STATUS_OK, xnFormatContextMetrics(m_context.GetUnderlyingObject(), csBuffer, sizeof(csBuffer), &nWritten));
+		return std::string(csBuffer, nWritten);
+	}
+
+	Context m_context;
+	MockDepthGenerator m_depth;
+	XnDepthPixel m_frame[TEST_PIXELS];
+};
+
+TEST_F(MetricsTest, CountsFramesAndSkips)
+{
+	PushFrame(1);
+	PushFrame(2);
+	// frames 3 and 4 never reach the application
+	PushFrame(5);
+
+	XnNodeMetrics metrics;
+	ASSERT_EQ(XN_STATUS_OK, xnGetNodeMetrics(m_depth.GetHandle(), &metrics));
+	EXPECT_STREQ("MetricsDepth", metrics.strName);
+	EXPECT_EQ(XN_NODE_TYPE_DEPTH, metrics.type);
+	EXPECT_EQ(3U, metrics.nFramesGenerated);
+	EXPECT_EQ(3U, metrics.nFramesConsumed);
+	EXPECT_EQ(2U, metrics.nFramesSkipped);
+	EXPECT_EQ(3 * sizeof(m_frame), metrics.nBytesConsumed);
+	EXPECT_EQ(3U, metrics.dataLatency.nCount);
+	EXPECT_LE(metrics.updateLatency.nMax, metrics.updateLatency.nTotal);
+	EXPECT_GE(metrics.updateLatency.nCount, 3U);
+
+	// updating again without new data consumes nothing
+	ASSERT_EQ(XN_STATUS_OK, m_context.WaitNoneUpdateAll());
+	ASSERT_EQ(XN_STATUS_OK, xnGetNodeMetrics(m_depth.GetHandle(), &metrics));
+	EXPECT_EQ(3U, metrics.nFramesConsumed);
+}
+
+TEST_F(MetricsTest, ContextSnapshotListsNodes)
+{
+	MockImageGenerator image;
+	ASSERT_EQ(XN_STATUS_OK, image.Create(m_context, "MetricsImage"));
+
+	XnContextMetrics context;
+	XnNodeMetrics aNodes[4];
+	XnUInt32 nNodes = 1;
+	EXPECT_EQ(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, m_context.GetMetrics(context, aNodes, &nNodes));
+	EXPECT_EQ(1U, nNodes);
+	EXPECT_EQ(2U, context.nNodeCount);
+
+	nNodes = 4;
+	ASSERT_EQ(XN_STATUS_OK, m_context.GetMetrics(context, aNodes, &nNodes));
+	ASSERT_EQ(2U, nNodes);
+	XnBool bFoundImage = FALSE;
+	for (XnUInt32 i = 0; i < nNodes; ++i)
+	{
+		if (strcmp(aNodes[i].strName, "MetricsImage") == 0)
+		{
+			bFoundImage = TRUE;
+			EXPECT_EQ(XN_NODE_TYPE_IMAGE, aNodes[i].type);
+		}
+	}
+	EXPECT_TRUE(bFoundImage);
+
+	image.Release();
+	ASSERT_EQ(XN_STATUS_OK, m_context.GetMetrics(context));
+	EXPECT_EQ(1U, context.nNodeCount);
+}
+
+TEST_F(MetricsTest, WaitsAreTimed)
+{
+	ASSERT_EQ(XN_STATUS_OK, m_depth.StartGenerating());
+	PushFrame(1);
+
+	XnContextMetrics before;
+	ASSERT_EQ(XN_STATUS_OK, m_context.GetMetrics(before));
+
+	// only make the frame available (SetData() would also update the node)
+	ASSERT_EQ(XN_STATUS_OK, m_depth.SetGeneralProperty(XN_PROP_NEWDATA, sizeof(m_frame), m_frame));
+	ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_FRAME_ID, 2));
+	ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_TIMESTAMP, 2000));
+	ASSERT_EQ(XN_STATUS_OK, m_context.WaitOneUpdateAll(m_depth));
+	EXPECT_EQ(2U, m_depth.GetFrameID());
+
+	XnContextMetrics after;
+	ASSERT_EQ(XN_STATUS_OK, m_context.GetMetrics(after));
+	EXPECT_EQ(before.waitLatency.nCount + 1, after.waitLatency.nCount);
+	EXPECT_GE(after.waitLatency.nTotal, before.waitLatency.nTotal);
+	EXPECT_GT(after.nTimestamp, before.nTimestamp);
+
+	XnNodeMetrics metrics;
+	ASSERT_EQ(XN_STATUS_OK, xnGetNodeMetrics(m_depth.GetHandle(), &metrics));
+	EXPECT_EQ(2U, metrics.nFramesConsumed);
+	EXPECT_EQ(0U, metrics.nFramesSkipped);
+}
+
+TEST_F(MetricsTest, PrometheusFormat)
+{
+	PushFrame(1);
+	PushFrame(3);
+
+	std::string text = Format();
+	EXPECT_NE(std::string::npos, text.find("# TYPE openni_node_frames_consumed_total counter\n"));
+	EXPECT_NE(std::string::npos, text.find("openni_node_frames_consumed_total{node=\"MetricsDepth\",type=\"Depth\"} 2\n"));
+	EXPECT_NE(std::string::npos, text.find("openni_node_frames_skipped_total{node=\"MetricsDepth\",type=\"Depth\"} 1\n"));
+	EXPECT_NE(std::string::npos, text.find("openni_node_update_seconds_count{node=\"MetricsDepth\",type=\"Depth\"} "));
+	EXPECT_NE(std::string::npos, text.find("openni_nodes 1\n"));
+	// no codec or recorder in the context
+	EXPECT_EQ(std::string::npos, text.find("openni_codec_"));
+	EXPECT_EQ(std::string::npos, text.find("openni_recorder_"));
+
+	XnChar csSmall[64];
+	XnUInt32 nWritten = 0;
+	EXPECT_EQ(XN_STATUS_OUTPUT_BUFFER_OVERFLOW, xnFormatContextMetrics(m_context.GetUnderlyingObject(), csSmall, sizeof(csSmall), &nWritten));
+}
+
+#if XN_PLATFORM != XN_PLATFORM_WIN32
+TEST_F(MetricsTest, ExporterServesMetrics)
+{
+	const XnChar* strPath = "MetricsTest.sock";
+	PushFrame(1);
+
+	ASSERT_EQ(XN_STATUS_OK, m_context.StartMetricsExporter(strPath));
+	EXPECT_EQ(XN_STATUS_INVALID_OPERATION, m_context.StartMetricsExporter(strPath));
+
+	// two scrapes, to see the exporter keeps serving
+	for (XnUInt32 nScrape = 0; nScrape < 2; ++nScrape)
+	{
+		XN_SOCKET_HANDLE hSocket = NULL;
+		ASSERT_EQ(XN_STATUS_OK, xnOSCreateSocket(XN_OS_LOCAL_SOCKET, strPath, 0, &hSocket));
+		ASSERT_EQ(XN_STATUS_OK, xnOSConnectSocket(hSocket, 1000));
+
+		const XnChar* strRequest = "GET /metrics HTTP/1.0\r\n\r\n";
+		ASSERT_EQ(XN_STATUS_OK, xnOSSendNetworkBuffer(hSocket, strRequest, xnOSStrLen(strRequest)));
+
+		std::string response;
+		for (;;)
+		{
+			XnChar csBuffer[4096];
+			XnUInt32 nRead = sizeof(csBuffer);
+			if (xnOSReceiveNetworkBuffer(hSocket, csBuffer, &nRead, 2000) != XN_STATUS_OK)
+			{
+				break;
+			}
+			response.append(csBuffer, nRead);
+		}
+		xnOSCloseSocket(hSocket);
+
+		EXPECT_EQ(0U, response.find("HTTP/1.0 200 OK\r\n"));
+		EXPECT_NE(std::string::npos, response.find("openni_node_frames_consumed_total{node=\"MetricsDepth\",type=\"Depth\"} 1\n"));
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, m_context.StopMetricsExporter());
+
+	XnBool bExists = TRUE;
+	ASSERT_EQ(XN_STATUS_OK, xnOSDoesFileExist(strPath, &bExists));
+	EXPECT_FALSE(bExists);
+}
+
+TEST_F(MetricsTest, ExporterBoundsSlowRequests)
+{
+	const XnChar* strPath = "MetricsTest.sock";
+	PushFrame(1);
+	ASSERT_EQ(XN_STATUS_OK, m_context.StartMetricsExporter(strPath));
+
+	// a client sending its request a byte at a time, never finishing it, is answered once the request times out
+	XN_SOCKET_HANDLE hSocket = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateSocket(XN_OS_LOCAL_SOCKET, strPath, 0, &hSocket));
+	ASSERT_EQ(XN_STATUS_OK, xnOSConnectSocket(hSocket, 1000));
+
+	XnUInt64 nStart;
+	xnOSGetTimeStamp(&nStart);
+	std::string response;
+	for (XnUInt32 i = 0; i < 100 && response.empty(); ++i)
+	{
+		xnOSSendNetworkBuffer(hSocket, "G", 1);
+
+		XnChar csBuffer[4096];
+		XnUInt32 nRead = sizeof(csBuffer);
+		if (xnOSReceiveNetworkBuffer(hSocket, csBuffer, &nRead, 50) == XN_STATUS_OK)
+		{
+			response.append(csBuffer, nRead);
+		}
+	}
+	XnUInt64 nNow;
+	xnOSGetTimeStamp(&nNow);
+	xnOSCloseSocket(hSocket);
+
+	EXPECT_EQ(0U, response.find("HTTP/1.0 200 OK\r\n"));
+	EXPECT_GT(2000U, nNow - nStart);
+
+	// stopping doesn't wait for a client in the middle of its request, and leaves the context usable
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateSocket(XN_OS_LOCAL_SOCKET, strPath, 0, &hSocket));
+	ASSERT_EQ(XN_STATUS_OK, xnOSConnectSocket(hSocket, 1000));
+	ASSERT_EQ(XN_STATUS_OK, xnOSSendNetworkBuffer(hSocket, "G", 1));
+	xnOSSleep(50);
+
+	xnOSGetTimeStamp(&nStart);
+	ASSERT_EQ(XN_STATUS_OK, m_context.StopMetricsExporter());
+	xnOSGetTimeStamp(&nNow);
+	EXPECT_GT(400U, nNow - nStart);
+	xnOSCloseSocket(hSocket);
+
+	PushFrame(2);
+	EXPECT_NE(std::string::npos, Format().find("openni_node_frames_consumed_total{node=\"MetricsDepth\",type=\"Depth\"} 2\n"));
+}
+#endif
@@ -0,0 +1,256 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+
+using namespace xn;
+
+#define TEST_X_RES			64
+#define TEST_Y_RES			48
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAME_INTERVAL	33333
+
+typedef struct PlayerThreadContext
+{
+	Player* pPlayer;
+	const XnChar* strAddress;
+	XnUInt32 nStartDelay; // how long to wait before reading frames
+	XnStatus nSetSourceStatus;
+	XnUInt32 nFrames;
+	XnUInt32 nBadFrames;
+	XnUInt32 nLastFrameID;
+	volatile XnBool bReading;
+} PlayerThreadContext;
+
+// sets the network source and plays all frames until the recorder disconnects. Every depth pixel of
+// a frame should be equal to its frame ID.
+static XN_THREAD_PROC PlayNetworkThreadProc(XN_THREAD_PARAM pParam)
+{
+	PlayerThreadContext* pContext = (PlayerThreadContext*)pParam;
+	pContext->nSetSourceStatus = pContext->pPlayer->SetSource(XN_RECORD_MEDIUM_NETWORK, pContext->strAddress);
+	if (pContext->nSetSourceStatus != XN_STATUS_OK)
+	{
+		XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+	}
+
+	Context context;
+	pContext->pPlayer->GetContext(context);
+	DepthGenerator depth;
+	if (context.FindExistingNode(XN_NODE_TYPE_DEPTH, depth) != XN_STATUS_OK)
+	{
+		XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+	}
+
+	xnOSSleep(pContext->nStartDelay);
+	pContext->bReading = TRUE;
+
+	DepthMetaData md;
+	while (!pContext->pPlayer->IsEOF())
+	{
+		if (context.WaitOneUpdateAll(depth) != XN_STATUS_OK)
+		{
+			break;
+		}
+
+		depth.GetMetaData(md);
+		if (md.IsDataNew())
+		{
+			++pContext->nFrames;
+			pContext->nLastFrameID = md.FrameID();
+			if (md(0, 0) != md.FrameID() || md(TEST_X_RES - 1, TEST_Y_RES - 1) != md.FrameID())
+			{
+				++pContext->nBadFrames;
+			}
+		}
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+class NetworkRecordingTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_recordContext.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, m_depth.Create(m_recordContext, "Depth"));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, m_depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+		ASSERT_EQ(XN_STATUS_OK, m_playContext.Init());
+		ASSERT_EQ(XN_STATUS_OK, m_player.Create(m_playContext, "oni"));
+		ASSERT_EQ(XN_STATUS_OK, m_player.SetRepeat(FALSE));
+
+		xnOSMemSet(&m_threadContext, 0, sizeof(m_threadContext));
+		m_threadContext.pPlayer = &m_player;
+		m_hThread = NULL;
+	}
+
+	virtual void TearDown()
+	{
+		m_recorder.Release();
+		if (m_hThread != NULL)
+		{
+			xnOSWaitForThreadExit(m_hThread, 10000);
+			xnOSCloseThread(&m_hThread);
+		}
+		m_depth.Release();
+		m_recordContext.Release();
+		m_player.Release();
+		m_playContext.Release();
+	}
+
+	void StartPlayer(const XnChar* strAddress, XnUInt32 nStartDelay)
+	{
+		m_threadContext.strAddress = strAddress;
+		m_threadContext.nStartDelay = nStartDelay;
+		ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(PlayNetworkThreadProc, &m_threadContext, &m_hThread));
+	}
+
+	// the player only listens once its thread got to SetSource()
+	void ConnectRecorder(const XnChar* strAddress)
+	{
+		ASSERT_EQ(XN_STATUS_OK, m_recorder.Create(m_recordContext));
+
+		XnStatus nRetVal = XN_STATUS_ERROR;
+		for (XnUInt32 nTry = 0; nTry < 500 && nRetVal != XN_STATUS_OK; ++nTry)
+		{
+			nRetVal = m_recorder.SetDestination(XN_RECORD_MEDIUM_NETWORK, strAddress);
+			if (nRetVal != XN_STATUS_OK)
+			{
+				xnOSSleep(10);
+			}
+		}
+		ASSERT_EQ(XN_STATUS_OK, nRetVal);
+		ASSERT_EQ(XN_STATUS_OK, m_recorder.AddNodeToRecording(m_depth, XN_CODEC_16Z));
+	}
+
+	void RecordFrames(XnUInt32 nFirstFrameID, XnUInt32 nFrames, XnUInt32 nSleep)
+	{
+		XnDepthPixel aDepth[TEST_PIXELS];
+		for (XnUInt32 nFrameID = nFirstFrameID; nFrameID < nFirstFrameID + nFrames; ++nFrameID)
+		{
+			for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+			{
+				aDepth[p] = (XnDepthPixel)nFrameID;
+			}
+
+			ASSERT_EQ(XN_STATUS_OK, m_depth.SetData(nFrameID, nFrameID * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+			ASSERT_EQ(XN_STATUS_OK, m_recordContext.WaitNoneUpdateAll());
+			xnOSSleep(nSleep);
+		}
+	}
+
+	// closing the connection ends the stream
+	void StopRecorder()
+	{
+		m_recorder.Release();
+		ASSERT_EQ(XN_STATUS_OK, xnOSWaitForThreadExit(m_hThread, 10000));
+		xnOSCloseThread(&m_hThread);
+		m_hThread = NULL;
+	}
+
+	Context m_recordContext;
+	MockDepthGenerator m_depth;
+	Recorder m_recorder;
+	Context m_playContext;
+	Player m_player;
+	PlayerThreadContext m_threadContext;
+	XN_THREAD_HANDLE m_hThread;
+};
+
+TEST_F(NetworkRecordingTest, LoopbackPlaysAllFrames)
+{
+	StartPlayer("127.0.0.1:19561", 0);
+	ConnectRecorder("127.0.0.1:19561");
+	RecordFrames(1, 30, 5);
+	StopRecorder();
+
+	ASSERT_EQ(XN_STATUS_OK, m_threadContext.nSetSourceStatus);
+	EXPECT_EQ(30U, m_threadContext.nFrames);
+	EXPECT_EQ(30U, m_threadContext.nLastFrameID);
+	EXPECT_EQ(0U, m_threadContext.nBadFrames);
+
+	// a live source cannot be seeked
+	EXPECT_NE(XN_STATUS_OK, m_player.SeekToFrame("Depth", 0, XN_PLAYER_SEEK_SET));
+}
+
+TEST_F(NetworkRecordingTest, LatencyLimitDropsQueuedFrames)
+{
+	XnPlayerNetworkOptions options = { 0, 0, 50 };
+	ASSERT_EQ(XN_STATUS_OK, m_player.SetNetworkOptions(options));
+
+	// frames recorded while the player is busy wait in its receive queue
+	StartPlayer("127.0.0.1:19562", 500);
+	ConnectRecorder("127.0.0.1:19562");
+	RecordFrames(1, 30, 1);
+	while (!m_threadContext.bReading)
+	{
+		xnOSSleep(1);
+	}
+
+	// once it caught up, frames are played as they arrive
+	xnOSSleep(100);
+	RecordFrames(31, 10, 30);
+	StopRecorder();
+
+	ASSERT_EQ(XN_STATUS_OK, m_threadContext.nSetSourceStatus);
+	EXPECT_LT(m_threadContext.nFrames, 40U);
+	EXPECT_GE(m_threadContext.nFrames, 10U);
+	EXPECT_EQ(40U, m_threadContext.nLastFrameID);
+	EXPECT_EQ(0U, m_threadContext.nBadFrames);
+}
+
+TEST_F(NetworkRecordingTest, AcceptTimesOut)
+{
+	XnPlayerNetworkOptions options = { 200, 0, 0 };
+	ASSERT_EQ(XN_STATUS_OK, m_player.SetNetworkOptions(options));
+
+	XnUInt64 nStart;
+	xnOSGetTimeStamp(&nStart);
+	EXPECT_EQ(XN_STATUS_OS_NETWORK_TIMEOUT, m_player.SetSource(XN_RECORD_MEDIUM_NETWORK, "127.0.0.1:19563"));
+	XnUInt64 nEnd;
+	xnOSGetTimeStamp(&nEnd);
+
+	EXPECT_GE(nEnd - nStart, 150U);
+	EXPECT_LT(nEnd - nStart, 2000U);
+}
+
+TEST_F(NetworkRecordingTest, AbortCancelsAccept)
+{
+	XnPlayerNetworkOptions options = { 60000, 0, 0 };
+	ASSERT_EQ(XN_STATUS_OK, m_player.SetNetworkOptions(options));
+
+	StartPlayer("127.0.0.1:19564", 0);
+	xnOSSleep(100);
+	ASSERT_EQ(XN_STATUS_OK, m_player.AbortSource());
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSWaitForThreadExit(m_hThread, 2000));
+	xnOSCloseThread(&m_hThread);
+	m_hThread = NULL;
+	EXPECT_EQ(XN_STATUS_OS_EVENT_CANCELED, m_threadContext.nSetSourceStatus);
+}
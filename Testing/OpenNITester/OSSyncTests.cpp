@@ -0,0 +1,169 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnOS.h>
+
+#define TEST_CONTENDED_LOCKS	100000
+
+typedef struct LockTestContext
+{
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	volatile XnUInt32 nCounter;
+} LockTestContext;
+
+typedef struct TryLockContext
+{
+	XN_MUTEX_HANDLE hMutex;
+	XnStatus nResult;
+} TryLockContext;
+
+static XN_THREAD_PROC SetEventThreadProc(XN_THREAD_PARAM pParam)
+{
+	XN_EVENT_HANDLE hEvent = (XN_EVENT_HANDLE)pParam;
+	xnOSSleep(20);
+	xnOSSetEvent(hEvent);
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+static XN_THREAD_PROC CountingThreadProc(XN_THREAD_PARAM pParam)
+{
+	LockTestContext* pContext = (LockTestContext*)pParam;
+	for (XnUInt32 i = 0; i < TEST_CONTENDED_LOCKS; ++i)
+	{
+		xnOSEnterCriticalSection(&pContext->hLock);
+		++pContext->nCounter;
+		xnOSLeaveCriticalSection(&pContext->hLock);
+	}
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+static XN_THREAD_PROC TryLockThreadProc(XN_THREAD_PARAM pParam)
+{
+	TryLockContext* pContext = (TryLockContext*)pParam;
+	pContext->nResult = xnOSLockMutex(pContext->hMutex, 10);
+	if (pContext->nResult == XN_STATUS_OK)
+	{
+		xnOSUnLockMutex(pContext->hMutex);
+	}
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+TEST(OSSyncTests, AutoResetEventReleasesOneWait)
+{
+	XN_EVENT_HANDLE hEvent = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateEvent(&hEvent, FALSE));
+
+	EXPECT_EQ(XN_STATUS_OS_EVENT_TIMEOUT, xnOSWaitEvent(hEvent, 0));
+	EXPECT_EQ(XN_STATUS_OK, xnOSSetEvent(hEvent));
+	EXPECT_EQ(XN_STATUS_OK, xnOSWaitEvent(hEvent, 0));
+	EXPECT_EQ(XN_STATUS_OS_EVENT_TIMEOUT, xnOSWaitEvent(hEvent, 10));
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSCloseEvent(&hEvent));
+}
+
+TEST(OSSyncTests, ManualResetEventStaysSet)
+{
+	XN_EVENT_HANDLE hEvent = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateEvent(&hEvent, TRUE));
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSSetEvent(hEvent));
+	EXPECT_EQ(XN_STATUS_OK, xnOSWaitEvent(hEvent, 0));
+	EXPECT_EQ(XN_STATUS_OK, xnOSWaitEvent(hEvent, 10));
+	EXPECT_EQ(XN_STATUS_OK, xnOSResetEvent(hEvent));
+	EXPECT_EQ(XN_STATUS_OS_EVENT_TIMEOUT, xnOSWaitEvent(hEvent, 10));
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSCloseEvent(&hEvent));
+}
+
+TEST(OSSyncTests, WaitIsWokenBySetFromAnotherThread)
+{
+	XN_EVENT_HANDLE hEvent = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateEvent(&hEvent, FALSE));
+
+	XN_THREAD_HANDLE hThread = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(SetEventThreadProc, hEvent, &hThread));
+	EXPECT_EQ(XN_STATUS_OK, xnOSWaitEvent(hEvent, 5000));
+
+	xnOSWaitForThreadExit(hThread, XN_WAIT_INFINITE);
+	xnOSCloseThread(&hThread);
+	EXPECT_EQ(XN_STATUS_OK, xnOSCloseEvent(&hEvent));
+}
+
+TEST(OSSyncTests, CriticalSectionIsRecursive)
+{
+	XN_CRITICAL_SECTION_HANDLE hLock;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateCriticalSection(&hLock));
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSEnterCriticalSection(&hLock));
+	EXPECT_EQ(XN_STATUS_OK, xnOSEnterCriticalSection(&hLock));
+	EXPECT_EQ(XN_STATUS_OK, xnOSLeaveCriticalSection(&hLock));
+	EXPECT_EQ(XN_STATUS_OK, xnOSLeaveCriticalSection(&hLock));
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSCloseCriticalSection(&hLock));
+}
+
+TEST(OSSyncTests, LockedMutexTimesOutInOtherThread)
+{
+	XN_MUTEX_HANDLE hMutex = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateMutex(&hMutex));
+	TryLockContext context;
+	context.hMutex = hMutex;
+	context.nResult = XN_STATUS_OK;
+
+	// held twice (recursively), so releasing it once must not let the other thread in
+	EXPECT_EQ(XN_STATUS_OK, xnOSLockMutex(hMutex, XN_WAIT_INFINITE));
+	EXPECT_EQ(XN_STATUS_OK, xnOSLockMutex(hMutex, XN_WAIT_INFINITE));
+	EXPECT_EQ(XN_STATUS_OK, xnOSUnLockMutex(hMutex));
+
+	XN_THREAD_HANDLE hThread = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(TryLockThreadProc, &context, &hThread));
+	xnOSWaitForThreadExit(hThread, XN_WAIT_INFINITE);
+	xnOSCloseThread(&hThread);
+	EXPECT_EQ(XN_STATUS_OS_MUTEX_TIMEOUT, context.nResult);
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSUnLockMutex(hMutex));
+	EXPECT_EQ(XN_STATUS_OK, xnOSLockMutex(hMutex, 0));
+	EXPECT_EQ(XN_STATUS_OK, xnOSUnLockMutex(hMutex));
+
+	EXPECT_EQ(XN_STATUS_OK, xnOSCloseMutex(&hMutex));
+}
+
+TEST(OSSyncTests, CriticalSectionUnderContention)
+{
+	LockTestContext context;
+	context.nCounter = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateCriticalSection(&context.hLock));
+
+	XN_THREAD_HANDLE ahThreads[4];
+	for (XnUInt32 i = 0; i < 4; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(CountingThreadProc, &context, &ahThreads[i]));
+	}
+
+	for (XnUInt32 i = 0; i < 4; ++i)
+	{
+		xnOSWaitForThreadExit(ahThreads[i], XN_WAIT_INFINITE);
+		xnOSCloseThread(&ahThreads[i]);
+	}
+
+	EXPECT_EQ(4 * TEST_CONTENDED_LOCKS, context.nCounter);
+	EXPECT_EQ(XN_STATUS_OK, xnOSCloseCriticalSection(&context.hLock));
+}
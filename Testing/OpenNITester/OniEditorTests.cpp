@@ -0,0 +1,273 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <XnOniEditor.h>
+
+using namespace xn;
+
+#define TEST_X_RES			64
+#define TEST_Y_RES			48
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAMES			30
+#define TEST_FRAME_INTERVAL	33333
+
+class OniEditorTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnOSDeleteFile("OniEditorTest1.oni");
+		xnOSDeleteFile("OniEditorTest2.oni");
+		xnOSDeleteFile("OniEditorTestOut.oni");
+	}
+
+	// frame i has timestamp i * TEST_FRAME_INTERVAL, and all its depth pixels are nFirstValue + i
+	static void Record(const XnChar* strFileName, XnCodecID depthCodec, XnBool bWithImage, XnDepthPixel nFirstValue)
+	{
+		Context context;
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		MockDepthGenerator depth;
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context, "Depth"));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+		MockImageGenerator image;
+		if (bWithImage)
+		{
+			ASSERT_EQ(XN_STATUS_OK, image.Create(context, "Image"));
+			ASSERT_EQ(XN_STATUS_OK, image.SetMapOutputMode(mode));
+			ASSERT_EQ(XN_STATUS_OK, image.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+			ASSERT_EQ(XN_STATUS_OK, image.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+			ASSERT_EQ(XN_STATUS_OK, image.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+		}
+
+		Recorder recorder;
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, strFileName));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, depthCodec));
+		if (bWithImage)
+		{
+			ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(image, XN_CODEC_UNCOMPRESSED));
+		}
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		XnRGB24Pixel aImage[TEST_PIXELS];
+		for (XnUInt32 i = 0; i < TEST_FRAMES; ++i)
+		{
+			for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+			{
+				aDepth[p] = (XnDepthPixel)(nFirstValue + i);
+				aImage[p].nRed = aImage[p].nGreen = aImage[p].nBlue = (XnUInt8)i;
+			}
+
+			ASSERT_EQ(XN_STATUS_OK, depth.SetData(i + 1, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+			if (bWithImage)
+			{
+				ASSERT_EQ(XN_STATUS_OK, image.SetData(i + 1, i * TEST_FRAME_INTERVAL, sizeof(aImage), (const XnUInt8*)aImage));
+			}
+			ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+		}
+
+		recorder.Release();
+		image.Release();
+		depth.Release();
+		context.Release();
+	}
+
+	// plays the depth node of a recording, returning its pixel values and timestamps
+	static void PlayDepth(const XnChar* strFileName, XnUInt32& nFrames, XnDepthPixel* aValues, XnUInt64* aTimestamps)
+	{
+		Context context;
+		Player player;
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+		ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording(strFileName, player));
+		ASSERT_EQ(XN_STATUS_OK, player.SetRepeat(FALSE));
+		ASSERT_EQ(XN_STATUS_OK, player.SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST));
+
+		DepthGenerator depth;
+		ASSERT_EQ(XN_STATUS_OK, context.FindExistingNode(XN_NODE_TYPE_DEPTH, depth));
+		ASSERT_EQ(XN_STATUS_OK, player.GetNumFrames("Depth", nFrames));
+
+		for (XnUInt32 i = 0; i < nFrames; ++i)
+		{
+			ASSERT_EQ(XN_STATUS_OK, context.WaitOneUpdateAll(depth));
+			DepthMetaData md;
+			depth.GetMetaData(md);
+			ASSERT_EQ((XnUInt32)TEST_X_RES, md.XRes());
+			aValues[i] = md(TEST_X_RES - 1, TEST_Y_RES - 1);
+			aTimestamps[i] = md.Timestamp();
+		}
+
+		depth.Release();
+		player.Release();
+		context.Release();
+	}
+};
+
+TEST_F(OniEditorTest, TrimKeepsRangeAndRebasesTimestamps)
+{
+	Record("OniEditorTest1.oni", XN_CODEC_16Z_EMB_TABLES, FALSE, 100);
+
+	XnOniCopyOptions options = { 10 * TEST_FRAME_INTERVAL, 19 * TEST_FRAME_INTERVAL, NULL, 0 };
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorCopy("OniEditorTest1.oni", "OniEditorTestOut.oni", &options));
+
+	XnUInt32 nFrames = 0;
+	XnDepthPixel aValues[TEST_FRAMES];
+	XnUInt64 aTimestamps[TEST_FRAMES];
+	PlayDepth("OniEditorTestOut.oni", nFrames, aValues, aTimestamps);
+
+	ASSERT_EQ(10U, nFrames);
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		EXPECT_EQ(110 + i, aValues[i]);
+		EXPECT_EQ(i * TEST_FRAME_INTERVAL, aTimestamps[i]);
+	}
+}
+
+TEST_F(OniEditorTest, KeepsTimestampsWhenAsked)
+{
+	Record("OniEditorTest1.oni", XN_CODEC_16Z_EMB_TABLES, FALSE, 100);
+
+	XnOniEditor* pEditor = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorCreate("OniEditorTestOut.oni", &pEditor));
+	XnOniCopyOptions options = { 10 * TEST_FRAME_INTERVAL, 19 * TEST_FRAME_INTERVAL, NULL, 0, TRUE };
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorAppend(pEditor, "OniEditorTest1.oni", &options));
+
+	// a later part of the same recording goes on from there
+	options.nStartTime = 25 * TEST_FRAME_INTERVAL;
+	options.nEndTime = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorAppend(pEditor, "OniEditorTest1.oni", &options));
+
+	// but an earlier one would go back in time, and nothing of it is copied
+	options.nStartTime = 0;
+	EXPECT_EQ(XN_STATUS_INVALID_OPERATION, xnOniEditorAppend(pEditor, "OniEditorTest1.oni", &options));
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorClose(&pEditor));
+
+	XnUInt32 nFrames = 0;
+	XnDepthPixel aValues[TEST_FRAMES];
+	XnUInt64 aTimestamps[TEST_FRAMES];
+	PlayDepth("OniEditorTestOut.oni", nFrames, aValues, aTimestamps);
+
+	ASSERT_EQ(15U, nFrames);
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		XnUInt32 nSourceFrame = (i < 10) ? (10 + i) : (15 + i);
+		EXPECT_EQ(100 + nSourceFrame, aValues[i]);
+		EXPECT_EQ(nSourceFrame * TEST_FRAME_INTERVAL, aTimestamps[i]);
+	}
+}
+
+TEST_F(OniEditorTest, ConcatenationContinuesAndSeeks)
+{
+	Record("OniEditorTest1.oni", XN_CODEC_16Z_EMB_TABLES, FALSE, 100);
+	Record("OniEditorTest2.oni", XN_CODEC_16Z_EMB_TABLES, FALSE, 200);
+
+	XnOniEditor* pEditor = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorCreate("OniEditorTestOut.oni", &pEditor));
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorAppend(pEditor, "OniEditorTest1.oni", NULL));
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorAppend(pEditor, "OniEditorTest2.oni", NULL));
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorClose(&pEditor));
+
+	XnUInt32 nFrames = 0;
+	XnDepthPixel aValues[2 * TEST_FRAMES];
+	XnUInt64 aTimestamps[2 * TEST_FRAMES];
+	PlayDepth("OniEditorTestOut.oni", nFrames, aValues, aTimestamps);
+
+	ASSERT_EQ(2U * TEST_FRAMES, nFrames);
+	for (XnUInt32 i = 0; i < TEST_FRAMES; ++i)
+	{
+		EXPECT_EQ(100 + i, aValues[i]);
+		EXPECT_EQ(200 + i, aValues[TEST_FRAMES + i]);
+	}
+	for (XnUInt32 i = 0; i < nFrames; ++i)
+	{
+		EXPECT_EQ(i * TEST_FRAME_INTERVAL, aTimestamps[i]);
+	}
+
+	// the rebuilt seek table reaches into the second recording
+	Context context;
+	Player player;
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording("OniEditorTestOut.oni", player));
+	DepthGenerator depth;
+	ASSERT_EQ(XN_STATUS_OK, context.FindExistingNode(XN_NODE_TYPE_DEPTH, depth));
+	ASSERT_EQ(XN_STATUS_OK, player.SeekToFrame("Depth", TEST_FRAMES + 5, XN_PLAYER_SEEK_SET));
+	ASSERT_EQ(XN_STATUS_OK, depth.WaitAndUpdateData());
+	DepthMetaData md;
+	depth.GetMetaData(md);
+	EXPECT_EQ(TEST_FRAMES + 5, md.FrameID());
+	EXPECT_EQ(204, md(0, 0));
+	depth.Release();
+	player.Release();
+	context.Release();
+}
+
+TEST_F(OniEditorTest, SelectsNodes)
+{
+	Record("OniEditorTest1.oni", XN_CODEC_16Z_EMB_TABLES, TRUE, 100);
+
+	const XnChar* astrNodes[] = { "Depth" };
+	XnOniCopyOptions options = { 0, 0, astrNodes, 1 };
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorCopy("OniEditorTest1.oni", "OniEditorTestOut.oni", &options));
+
+	Context context;
+	Player player;
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording("OniEditorTestOut.oni", player));
+	ImageGenerator image;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, context.FindExistingNode(XN_NODE_TYPE_IMAGE, image));
+	XnUInt32 nFrames = 0;
+	EXPECT_EQ(XN_STATUS_OK, player.GetNumFrames("Depth", nFrames));
+	EXPECT_EQ((XnUInt32)TEST_FRAMES, nFrames);
+	player.Release();
+	context.Release();
+
+	const XnChar* astrMissing[] = { "Audio" };
+	options.astrNodeNames = astrMissing;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOniEditorCopy("OniEditorTest1.oni", "OniEditorTestOut.oni", &options));
+}
+
+TEST_F(OniEditorTest, RefusesToMixCodecs)
+{
+	Record("OniEditorTest1.oni", XN_CODEC_16Z_EMB_TABLES, FALSE, 100);
+	Record("OniEditorTest2.oni", XN_CODEC_UNCOMPRESSED, FALSE, 200);
+
+	XnOniEditor* pEditor = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorCreate("OniEditorTestOut.oni", &pEditor));
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorAppend(pEditor, "OniEditorTest1.oni", NULL));
+	EXPECT_EQ(XN_STATUS_INVALID_OPERATION, xnOniEditorAppend(pEditor, "OniEditorTest2.oni", NULL));
+	ASSERT_EQ(XN_STATUS_OK, xnOniEditorClose(&pEditor));
+
+	// the failed append left the file as it was
+	XnUInt32 nFrames = 0;
+	XnDepthPixel aValues[TEST_FRAMES];
+	XnUInt64 aTimestamps[TEST_FRAMES];
+	PlayDepth("OniEditorTestOut.oni", nFrames, aValues, aTimestamps);
+	EXPECT_EQ((XnUInt32)TEST_FRAMES, nFrames);
+}
@@ -0,0 +1,229 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+#include <XnOniFrameReader.h>
+
+using namespace xn;
+
+#define TEST_FILE_NAME		"OniFrameReaderTest.oni"
+#define TEST_X_RES			64
+#define TEST_Y_RES			48
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAMES			40
+#define TEST_FRAME_INTERVAL	33333
+#define TEST_THREADS		8
+
+typedef struct ReaderThreadContext
+{
+	XnOniFrameReader* pReader;
+	XnUInt32 nNode;
+	XnUInt32 nSeed;
+	XnUInt32 nMismatches;
+	XnStatus nRetVal;
+} ReaderThreadContext;
+
+// every thread reads all frames, each in its own order, and checks their content
+static XN_THREAD_PROC ReadAllFramesThreadProc(XN_THREAD_PARAM pParam)
+{
+	ReaderThreadContext* pContext = (ReaderThreadContext*)pParam;
+	XnDepthPixel aDepth[TEST_PIXELS];
+
+	for (XnUInt32 i = 0; i < TEST_FRAMES; ++i)
+	{
+		XnUInt32 nFrame = (i * 7 + pContext->nSeed) % TEST_FRAMES;
+		XnOniFrameInfo info;
+		XnStatus nRetVal = xnOniFrameReaderReadFrame(pContext->pReader, pContext->nNode, nFrame, aDepth, sizeof(aDepth), &info);
+		if (nRetVal != XN_STATUS_OK)
+		{
+			pContext->nRetVal = nRetVal;
+			break;
+		}
+
+		if (info.nDataSize != sizeof(aDepth) || aDepth[0] != 1000 + nFrame || aDepth[TEST_PIXELS - 1] != 1000 + nFrame)
+		{
+			pContext->nMismatches++;
+		}
+	}
+
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+class OniFrameReaderTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		Record();
+	}
+
+	virtual void TearDown()
+	{
+		xnOSDeleteFile(TEST_FILE_NAME);
+	}
+
+	// frame i has timestamp i * TEST_FRAME_INTERVAL. Its depth pixels are all 1000 + i, and its image pixels all i.
+	static void Record()
+	{
+		Context context;
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		MockDepthGenerator depth;
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context, "Depth"));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+		MockImageGenerator image;
+		ASSERT_EQ(XN_STATUS_OK, image.Create(context, "Image"));
+		ASSERT_EQ(XN_STATUS_OK, image.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, image.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, image.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, image.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+		Recorder recorder;
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, TEST_FILE_NAME));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, XN_CODEC_16Z_EMB_TABLES));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(image, XN_CODEC_UNCOMPRESSED));
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		XnRGB24Pixel aImage[TEST_PIXELS];
+		for (XnUInt32 i = 0; i < TEST_FRAMES; ++i)
+		{
+			for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+			{
+				aDepth[p] = (XnDepthPixel)(1000 + i);
+				aImage[p].nRed = aImage[p].nGreen = aImage[p].nBlue = (XnUInt8)i;
+			}
+
+			ASSERT_EQ(XN_STATUS_OK, depth.SetData(i + 1, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+			ASSERT_EQ(XN_STATUS_OK, image.SetData(i + 1, i * TEST_FRAME_INTERVAL, sizeof(aImage), (const XnUInt8*)aImage));
+			ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+		}
+
+		recorder.Release();
+		image.Release();
+		depth.Release();
+		context.Release();
+	}
+};
+
+TEST_F(OniFrameReaderTest, IndexesNodes)
+{
+	XnOniFrameReader* pReader = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderOpen(TEST_FILE_NAME, &pReader));
+	EXPECT_EQ(2U, xnOniFrameReaderGetNodeCount(pReader));
+
+	XnUInt32 nDepth = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Depth", &nDepth));
+	XnOniNodeInfo info;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderGetNodeInfo(pReader, nDepth, &info));
+	EXPECT_STREQ("Depth", info.strName);
+	EXPECT_EQ(XN_NODE_TYPE_DEPTH, info.type);
+	EXPECT_EQ(XN_CODEC_16Z_EMB_TABLES, info.codec);
+	EXPECT_EQ((XnUInt32)TEST_FRAMES, info.nFrames);
+	EXPECT_EQ(0U, info.nMinTimestamp);
+	EXPECT_EQ((XnUInt64)(TEST_FRAMES - 1) * TEST_FRAME_INTERVAL, info.nMaxTimestamp);
+	EXPECT_EQ(TEST_PIXELS * sizeof(XnDepthPixel), info.nMaxFrameSize);
+
+	XnUInt32 nNode = 0;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOniFrameReaderFindNode(pReader, "Audio", &nNode));
+
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderClose(&pReader));
+	EXPECT_TRUE(pReader == NULL);
+}
+
+TEST_F(OniFrameReaderTest, ReadsFramesInAnyOrder)
+{
+	XnOniFrameReader* pReader = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderOpen(TEST_FILE_NAME, &pReader));
+	XnUInt32 nDepth = 0;
+	XnUInt32 nImage = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Depth", &nDepth));
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Image", &nImage));
+
+	XnDepthPixel aDepth[TEST_PIXELS];
+	XnRGB24Pixel aImage[TEST_PIXELS];
+	XnUInt32 anFrames[] = { 25, 3, 39, 0, 17 };
+	for (XnUInt32 i = 0; i < sizeof(anFrames) / sizeof(anFrames[0]); ++i)
+	{
+		XnUInt32 nFrame = anFrames[i];
+		XnOniFrameInfo info;
+		ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderReadFrame(pReader, nDepth, nFrame, aDepth, sizeof(aDepth), &info));
+		EXPECT_EQ(nFrame + 1, info.nFrameID);
+		EXPECT_EQ((XnUInt64)nFrame * TEST_FRAME_INTERVAL, info.nTimestamp);
+		EXPECT_EQ(sizeof(aDepth), info.nDataSize);
+		EXPECT_EQ((XnUInt32)TEST_X_RES, info.nXRes);
+		EXPECT_EQ((XnUInt32)TEST_Y_RES, info.nYRes);
+		EXPECT_EQ(1000 + nFrame, aDepth[TEST_PIXELS / 2]);
+
+		ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderReadFrame(pReader, nImage, nFrame, aImage, sizeof(aImage), &info));
+		EXPECT_EQ(sizeof(aImage), info.nDataSize);
+		EXPECT_EQ(nFrame, aImage[TEST_PIXELS - 1].nGreen);
+	}
+
+	// the raw frame is the compressed one
+	XnOniFrameInfo info;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderReadRawFrame(pReader, nDepth, 5, aDepth, sizeof(aDepth), &info));
+	EXPECT_LT(info.nDataSize, sizeof(aDepth));
+
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, xnOniFrameReaderReadFrame(pReader, nDepth, TEST_FRAMES, aDepth, sizeof(aDepth), NULL));
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, xnOniFrameReaderReadFrame(pReader, 2, 0, aDepth, sizeof(aDepth), NULL));
+	EXPECT_NE(XN_STATUS_OK, xnOniFrameReaderReadFrame(pReader, nImage, 0, aImage, sizeof(aImage) / 2, NULL));
+
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderClose(&pReader));
+}
+
+TEST_F(OniFrameReaderTest, ReadsFromManyThreads)
+{
+	XnOniFrameReader* pReader = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderOpen(TEST_FILE_NAME, &pReader));
+	XnUInt32 nDepth = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderFindNode(pReader, "Depth", &nDepth));
+
+	ReaderThreadContext aContexts[TEST_THREADS];
+	XN_THREAD_HANDLE ahThreads[TEST_THREADS];
+	for (XnUInt32 i = 0; i < TEST_THREADS; ++i)
+	{
+		aContexts[i].pReader = pReader;
+		aContexts[i].nNode = nDepth;
+		aContexts[i].nSeed = i * 5;
+		aContexts[i].nMismatches = 0;
+		aContexts[i].nRetVal = XN_STATUS_OK;
+		ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(ReadAllFramesThreadProc, &aContexts[i], &ahThreads[i]));
+	}
+
+	for (XnUInt32 i = 0; i < TEST_THREADS; ++i)
+	{
+		xnOSWaitForThreadExit(ahThreads[i], XN_WAIT_INFINITE);
+		xnOSCloseThread(&ahThreads[i]);
+		EXPECT_EQ(XN_STATUS_OK, aContexts[i].nRetVal);
+		EXPECT_EQ(0U, aContexts[i].nMismatches);
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, xnOniFrameReaderClose(&pReader));
+}
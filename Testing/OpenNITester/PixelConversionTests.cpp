@@ -0,0 +1,211 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnUtils.h>
+#include <XnOS.h>
+#include <stdlib.h>
+
+// odd, and not a multiple of any vector width, so that every tail path runs
+#define TEST_PIXELS			1001
+#define TEST_MAX_DEPTH		10000
+
+static XnUInt8 ClampToByte(XnInt32 nValue)
+{
+	return (XnUInt8)XN_MIN(XN_MAX(nValue, 0), 255);
+}
+
+static void ReferenceYUVToRGB(XnUInt8 nY, XnUInt8 nU, XnUInt8 nV, XnUInt8* pRGB)
+{
+	XnInt32 nC = (nY - 16) * 298 + 128;
+	XnInt32 nD = nU - 128;
+	XnInt32 nE = nV - 128;
+	pRGB[0] = ClampToByte((nC + 409 * nE) >> 8);
+	pRGB[1] = ClampToByte((nC - 100 * nD - 208 * nE) >> 8);
+	pRGB[2] = ClampToByte((nC + 516 * nD) >> 8);
+}
+
+static void FillRandom(XnUInt8* pBuffer, XnUInt32 nSize)
+{
+	srand(1234);
+	for (XnUInt32 i = 0; i < nSize; ++i)
+	{
+		pBuffer[i] = (XnUInt8)(rand() & 0xFF);
+	}
+}
+
+static void FillDepth(XnDepthPixel* pDepth, XnUInt32 nPixels)
+{
+	srand(5678);
+	for (XnUInt32 i = 0; i < nPixels; ++i)
+	{
+		// runs of equal values and holes, like a real depth map
+		pDepth[i] = (rand() % 8 == 0) ? 0 : (XnDepthPixel)(500 + (i / 7) * 13 % 3000);
+	}
+}
+
+// runs every test with each implementation: scalar only, SSE2 only and the best available
+class PixelConversionTests : public ::testing::TestWithParam<const XnChar*>
+{
+protected:
+	virtual void SetUp()
+	{
+		ASSERT_EQ(XN_STATUS_OK, xnSetPixelConversionSIMDLimit(GetParam()));
+	}
+
+	virtual void TearDown()
+	{
+		xnSetPixelConversionSIMDLimit(NULL);
+	}
+};
+
+INSTANTIATE_TEST_CASE_P(Kernels, PixelConversionTests, ::testing::Values("none", "sse2", (const XnChar*)NULL));
+
+TEST_P(PixelConversionTests, YUV422ToRGBMatchesReference)
+{
+	XnUInt8 aYUV[(TEST_PIXELS + 1) * 2];
+	XnUInt8 aRGB[TEST_PIXELS * 3];
+	XnUInt8 aRGBA[TEST_PIXELS * 4];
+	FillRandom(aYUV, sizeof(aYUV));
+
+	ASSERT_EQ(XN_STATUS_OK, xnConvertYUV422ToRGB24(aYUV, aRGB, TEST_PIXELS));
+	ASSERT_EQ(XN_STATUS_OK, xnConvertYUV422ToRGBA32(aYUV, aRGBA, TEST_PIXELS));
+
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		const XnUInt8* pMacroPixel = aYUV + (i / 2) * 4;
+		XnUInt8 aExpected[3];
+		ReferenceYUVToRGB(pMacroPixel[(i % 2 == 0) ? 1 : 3], pMacroPixel[0], pMacroPixel[2], aExpected);
+		for (XnUInt32 nChannel = 0; nChannel < 3; ++nChannel)
+		{
+			ASSERT_EQ(aExpected[nChannel], aRGB[i * 3 + nChannel]) << "pixel " << i;
+			ASSERT_EQ(aExpected[nChannel], aRGBA[i * 4 + nChannel]) << "pixel " << i;
+		}
+		ASSERT_EQ(255, aRGBA[i * 4 + 3]);
+	}
+}
+
+TEST_P(PixelConversionTests, YUV422ToGray8ExpandsLuma)
+{
+	XnUInt8 aYUV[(TEST_PIXELS + 1) * 2];
+	XnUInt8 aGray[TEST_PIXELS];
+	FillRandom(aYUV, sizeof(aYUV));
+
+	ASSERT_EQ(XN_STATUS_OK, xnConvertYUV422ToGray8(aYUV, aGray, TEST_PIXELS));
+
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		XnUInt8 nY = aYUV[(i / 2) * 4 + ((i % 2 == 0) ? 1 : 3)];
+		ASSERT_EQ(ClampToByte(((nY - 16) * 298 + 128) >> 8), aGray[i]) << "pixel " << i;
+	}
+}
+
+TEST_P(PixelConversionTests, Gray16Window)
+{
+	XnUInt16 aGray16[TEST_PIXELS];
+	XnUInt8 aGray8[TEST_PIXELS];
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		aGray16[i] = (XnUInt16)(1000 + i * 60);
+	}
+
+	XnUInt16 nMin = 0;
+	XnUInt16 nMax = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnGetGray16Range(aGray16, TEST_PIXELS, &nMin, &nMax));
+	EXPECT_EQ(1000, nMin);
+	EXPECT_EQ(1000 + (TEST_PIXELS - 1) * 60, nMax);
+
+	// values outside the window are clamped
+	XnUInt16 nWindowMin = 11000;
+	XnUInt16 nWindowMax = 11000 + 255 * 100;
+	ASSERT_EQ(XN_STATUS_OK, xnConvertGray16ToGray8(aGray16, aGray8, TEST_PIXELS, nWindowMin, nWindowMax));
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		XnInt32 nExpected = ((XnInt32)aGray16[i] - nWindowMin + 50) / 100;
+		ASSERT_EQ(ClampToByte(nExpected), aGray8[i]) << "pixel " << i;
+	}
+}
+
+TEST_P(PixelConversionTests, DepthHistogramMatchesCumulativeCount)
+{
+	XnDepthPixel aDepth[TEST_PIXELS];
+	FillDepth(aDepth, TEST_PIXELS);
+	// out of range values are ignored
+	aDepth[3] = TEST_MAX_DEPTH + 100;
+
+	XnFloat* pHistogram = XN_NEW_ARR(XnFloat, TEST_MAX_DEPTH + 1);
+	ASSERT_EQ(XN_STATUS_OK, xnCalculateDepthHistogram(aDepth, TEST_PIXELS, pHistogram, TEST_MAX_DEPTH + 1));
+
+	XnUInt32 nPoints = 0;
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		if (aDepth[i] != 0 && aDepth[i] <= TEST_MAX_DEPTH)
+		{
+			++nPoints;
+		}
+	}
+
+	EXPECT_EQ(0, pHistogram[0]);
+	XnUInt32 nCumulative = 0;
+	for (XnUInt32 nDepth = 1; nDepth <= TEST_MAX_DEPTH; ++nDepth)
+	{
+		for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+		{
+			if (aDepth[i] == nDepth)
+			{
+				++nCumulative;
+			}
+		}
+		XnFloat fExpected = (nCumulative == 0) ? 0 : (XnFloat)(nPoints - nCumulative) / nPoints;
+		ASSERT_EQ(fExpected, pHistogram[nDepth]) << "depth " << nDepth;
+	}
+
+	XN_DELETE_ARR(pHistogram);
+}
+
+TEST_P(PixelConversionTests, ColorizeDepthScalesColor)
+{
+	XnDepthPixel aDepth[TEST_PIXELS];
+	XnUInt8 aRGB[TEST_PIXELS * 3];
+	XnUInt8 aRGBA[TEST_PIXELS * 4];
+	FillDepth(aDepth, TEST_PIXELS);
+	aDepth[5] = TEST_MAX_DEPTH + 100;
+
+	XnFloat* pHistogram = XN_NEW_ARR(XnFloat, TEST_MAX_DEPTH + 1);
+	ASSERT_EQ(XN_STATUS_OK, xnCalculateDepthHistogram(aDepth, TEST_PIXELS, pHistogram, TEST_MAX_DEPTH + 1));
+
+	XnRGB24Pixel color = { 255, 128, 0 };
+	ASSERT_EQ(XN_STATUS_OK, xnColorizeDepthToRGB24(aDepth, TEST_PIXELS, pHistogram, TEST_MAX_DEPTH + 1, color, aRGB));
+	ASSERT_EQ(XN_STATUS_OK, xnColorizeDepthToRGBA32(aDepth, TEST_PIXELS, pHistogram, TEST_MAX_DEPTH + 1, color, 200, aRGBA));
+
+	for (XnUInt32 i = 0; i < TEST_PIXELS; ++i)
+	{
+		XnUInt32 nIntensity = (aDepth[i] <= TEST_MAX_DEPTH) ? (XnUInt32)(pHistogram[aDepth[i]] * 255.0f) : 0;
+		XnUInt8 aExpected[3] = { (XnUInt8)nIntensity, (XnUInt8)((nIntensity * 128 + 127) / 255), 0 };
+		for (XnUInt32 nChannel = 0; nChannel < 3; ++nChannel)
+		{
+			ASSERT_EQ(aExpected[nChannel], aRGB[i * 3 + nChannel]) << "pixel " << i;
+			ASSERT_EQ(aExpected[nChannel], aRGBA[i * 4 + nChannel]) << "pixel " << i;
+		}
+		ASSERT_EQ((aDepth[i] == 0) ? 0 : 200, aRGBA[i * 4 + 3]) << "pixel " << i;
+	}
+
+	XN_DELETE_ARR(pHistogram);
+}
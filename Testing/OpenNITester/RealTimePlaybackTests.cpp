@@ -0,0 +1,278 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+
+using namespace xn;
+
+#define TEST_X_RES			8
+#define TEST_Y_RES			6
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAME_INTERVAL	33333
+#define TEST_FRAMES			45
+// a consumer that needs this long per frame can't keep up with TEST_FRAME_INTERVAL
+#define TEST_SLOW_CONSUMER_MS	100
+// allowed error of the total playback time (the sandboxes these run in are noisy)
+#define TEST_PACE_TOLERANCE	0.15
+
+// timestamp offset of the frame synced node (within the context's frame sync threshold)
+#define TEST_SYNC_OFFSET	2000
+// how far behind the frame synced consumer falls
+#define TEST_LATE_FRAMES	4
+
+#define TEST_FILE			"RealTimePlaybackTest.oni"
+
+class RealTimePlaybackTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnOSDeleteFile(TEST_FILE);
+	}
+
+	static void CreateDepth(Context& context, const XnChar* strName, const XnChar* strSyncedWith, MockDepthGenerator& depth)
+	{
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context, strName));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		if (strSyncedWith != NULL)
+		{
+			ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_CAPABILITY_FRAME_SYNC, TRUE));
+			ASSERT_EQ(XN_STATUS_OK, depth.SetStringProperty(XN_PROP_FRAME_SYNCED_WITH, strSyncedWith));
+		}
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+	}
+
+	// records TEST_FRAMES frames of "Depth" (and of "Synced", frame synced with it, if bSynced)
+	static void Record(XnBool bSynced)
+	{
+		Context context;
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+
+		MockDepthGenerator depth;
+		MockDepthGenerator synced;
+		CreateDepth(context, "Depth", bSynced ? "Synced" : NULL, depth);
+		if (bSynced)
+		{
+			CreateDepth(context, "Synced", "Depth", synced);
+		}
+
+		Recorder recorder;
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, TEST_FILE));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, XN_CODEC_UNCOMPRESSED));
+		if (bSynced)
+		{
+			ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(synced, XN_CODEC_UNCOMPRESSED));
+		}
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		xnOSMemSet(aDepth, 0, sizeof(aDepth));
+		for (XnUInt32 i = 1; i <= TEST_FRAMES; ++i)
+		{
+			ASSERT_EQ(XN_STATUS_OK, depth.SetData(i, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+			if (bSynced)
+			{
+				// a bit after the frame it is synced with, like a camera that exposes later
+				ASSERT_EQ(XN_STATUS_OK, synced.SetData(i, i * TEST_FRAME_INTERVAL + TEST_SYNC_OFFSET, sizeof(aDepth), aDepth));
+			}
+			ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+		}
+
+		recorder.Release();
+		synced.Release();
+		depth.Release();
+		context.Release();
+	}
+
+	static void Open(Context& context, Player& player, XnDouble dSpeed, XnBool bRealTime)
+	{
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+		ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording(TEST_FILE, player));
+		ASSERT_EQ(XN_STATUS_OK, player.SetRepeat(FALSE));
+		ASSERT_EQ(XN_STATUS_OK, player.SetPlaybackSpeed(dSpeed));
+		ASSERT_EQ(XN_STATUS_OK, player.SetRealTime(bRealTime));
+	}
+
+	static void CheckPace(XnDouble dSpeed)
+	{
+		Record(FALSE);
+
+		Context context;
+		Player player;
+		Open(context, player, dSpeed, FALSE);
+
+		DepthGenerator depth;
+		ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Depth", depth));
+
+		XnUInt64 nStart = 0;
+		XnUInt32 nFrames = 0;
+		while (context.WaitOneUpdateAll(depth) == XN_STATUS_OK)
+		{
+			if (nFrames == 0)
+			{
+				// the first frame is the time reference
+				xnOSGetHighResTimeStamp(&nStart);
+			}
+			++nFrames;
+			ASSERT_EQ(nFrames, depth.GetFrameID());
+		}
+
+		XnUInt64 nEnd = 0;
+		xnOSGetHighResTimeStamp(&nEnd);
+
+		// every frame was played, and the whole recording took as long as it was recorded (scaled by the speed)
+		EXPECT_EQ((XnUInt32)TEST_FRAMES, nFrames);
+		XnDouble dExpected = (TEST_FRAMES - 1) * TEST_FRAME_INTERVAL / dSpeed;
+		EXPECT_NEAR(dExpected, (XnDouble)(nEnd - nStart), dExpected * TEST_PACE_TOLERANCE);
+	}
+};
+
+TEST_F(RealTimePlaybackTest, KeepsRecordedPace)
+{
+	CheckPace(1.0);
+}
+
+TEST_F(RealTimePlaybackTest, KeepsPaceOfPlaybackSpeed)
+{
+	CheckPace(2.0);
+}
+
+TEST_F(RealTimePlaybackTest, DropsFramesWhenConsumerFallsBehind)
+{
+	Record(FALSE);
+
+	Context context;
+	Player player;
+	Open(context, player, 1.0, TRUE);
+
+	DepthGenerator depth;
+	ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Depth", depth));
+
+	XnUInt64 nStart = 0;
+	xnOSGetHighResTimeStamp(&nStart);
+
+	XnUInt32 nPlayed = 0;
+	XnUInt32 nLastFrame = 0;
+	while (context.WaitOneUpdateAll(depth) == XN_STATUS_OK)
+	{
+		ASSERT_GT(depth.GetFrameID(), nLastFrame);
+		nLastFrame = depth.GetFrameID();
+		++nPlayed;
+		xnOSSleep(TEST_SLOW_CONSUMER_MS);
+	}
+
+	XnUInt64 nEnd = 0;
+	xnOSGetHighResTimeStamp(&nEnd);
+
+	// late frames were skipped, so playback still ended (roughly) when the recording does
+	EXPECT_EQ((XnUInt32)TEST_FRAMES, nLastFrame);
+	EXPECT_LT(nPlayed, (XnUInt32)TEST_FRAMES / 2);
+	XnDouble dRecording = (TEST_FRAMES - 1) * TEST_FRAME_INTERVAL;
+	EXPECT_LT((XnDouble)(nEnd - nStart), dRecording + TEST_SLOW_CONSUMER_MS * 1000 * 3);
+}
+
+TEST_F(RealTimePlaybackTest, PlaysEveryFrameWhenNotRealTime)
+{
+	Record(FALSE);
+
+	Context context;
+	Player player;
+	Open(context, player, 1.0, FALSE);
+
+	DepthGenerator depth;
+	ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Depth", depth));
+
+	// a slow consumer just slows playback down
+	XnUInt32 nPlayed = 0;
+	while (context.WaitOneUpdateAll(depth) == XN_STATUS_OK)
+	{
+		++nPlayed;
+		ASSERT_EQ(nPlayed, depth.GetFrameID());
+		xnOSSleep(TEST_SLOW_CONSUMER_MS / 2);
+	}
+
+	EXPECT_EQ((XnUInt32)TEST_FRAMES, nPlayed);
+}
+
+static void XN_CALLBACK_TYPE CountNewData(ProductionNode& /*node*/, void* pCookie)
+{
+	++*(XnUInt32*)pCookie;
+}
+
+TEST_F(RealTimePlaybackTest, DropsFrameSyncedNodesTogether)
+{
+	Record(TRUE);
+
+	Context context;
+	Player player;
+	Open(context, player, 1.0, TRUE);
+
+	DepthGenerator depth;
+	DepthGenerator synced;
+	ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Depth", depth));
+	ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Synced", synced));
+
+	// counts the frames the player decoded (dropped frames raise no event)
+	XnUInt32 nDepthFrames = 0;
+	XnUInt32 nSyncedFrames = 0;
+	XnCallbackHandle hDepthCallback;
+	XnCallbackHandle hSyncedCallback;
+	ASSERT_EQ(XN_STATUS_OK, depth.RegisterToNewDataAvailable(CountNewData, &nDepthFrames, hDepthCallback));
+	ASSERT_EQ(XN_STATUS_OK, synced.RegisterToNewDataAvailable(CountNewData, &nSyncedFrames, hSyncedCallback));
+
+	XnUInt64 nStart = 0;
+	XnUInt64 nFirstTimestamp = 0;
+	XnUInt32 nPlayed = 0;
+	while (context.WaitAndUpdateAll() == XN_STATUS_OK)
+	{
+		ASSERT_EQ(depth.GetFrameID(), synced.GetFrameID());
+		++nPlayed;
+
+		if (nPlayed == 1)
+		{
+			// the first pair was returned once its synced frame was due, TEST_SYNC_OFFSET after the player's
+			// time reference
+			xnOSGetHighResTimeStamp(&nStart);
+			nStart -= TEST_SYNC_OFFSET;
+			nFirstTimestamp = depth.GetTimestamp();
+		}
+
+		// fall a few frames behind, and continue right after a depth frame is due, but before its synced
+		// frame is - the worst time to decide about each node on its own
+		XnUInt64 nDueTimestamp = (depth.GetFrameID() + TEST_LATE_FRAMES) * TEST_FRAME_INTERVAL;
+		xnOSSleepUntilHighResTimeStamp(nStart + (nDueTimestamp - nFirstTimestamp) + TEST_SYNC_OFFSET / 2);
+	}
+
+	depth.UnregisterFromNewDataAvailable(hDepthCallback);
+	synced.UnregisterFromNewDataAvailable(hSyncedCallback);
+
+	// a frame is either decoded for both nodes or for none, even when only one of them was already late
+	EXPECT_EQ((XnUInt32)TEST_FRAMES, depth.GetFrameID());
+	EXPECT_LT(nPlayed, (XnUInt32)TEST_FRAMES / 2);
+	EXPECT_EQ(nDepthFrames, nSyncedFrames);
+	EXPECT_LT(nDepthFrames, (XnUInt32)TEST_FRAMES / 2);
+}
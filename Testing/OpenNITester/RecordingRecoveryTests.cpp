@@ -0,0 +1,234 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+
+using namespace xn;
+
+#define TEST_X_RES			8
+#define TEST_Y_RES			6
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAME_INTERVAL	33333
+// a bit more than one seek table chunk of the fast node
+#define TEST_FRAMES			1200
+// the slow node gets a frame every TEST_SLOW_RATIO frames, so it never fills a chunk
+#define TEST_SLOW_RATIO		4
+// played before seeking past the checkpoint
+#define TEST_PLAYED_FRAMES	1100
+// chops the last record in the middle
+#define TEST_TRUNCATE_BYTES	7
+
+#define TEST_FILE			"RecordingRecoveryTest.oni"
+#define TEST_TRUNCATED_FILE	"RecordingRecoveryTestTruncated.oni"
+
+// Records without finalizing the file, the way a crashed recorder leaves it: what the recorder already wrote
+// is copied aside (cutting the last record short) while it is still recording.
+class RecordingRecoveryTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnOSDeleteFile(TEST_FILE);
+		xnOSDeleteFile(TEST_TRUNCATED_FILE);
+	}
+
+	static void CreateDepth(Context& context, const XnChar* strName, MockDepthGenerator& depth)
+	{
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context, strName));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, 10000));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+	}
+
+	// all depth pixels of fast frame i are i, and of slow frame i are 10000 - i
+	static void RecordTruncated()
+	{
+		Context context;
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+
+		MockDepthGenerator fast;
+		MockDepthGenerator slow;
+		CreateDepth(context, "Fast", fast);
+		CreateDepth(context, "Slow", slow);
+
+		Recorder recorder;
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		// a small write buffer, so most of the recording reaches the file while recording
+		XnRecorderFileOptions options = { 0 };
+		options.nWriteBufferSize = 4096;
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetFileOptions(options));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, TEST_FILE));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(fast, XN_CODEC_UNCOMPRESSED));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(slow, XN_CODEC_UNCOMPRESSED));
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		for (XnUInt32 i = 1; i <= TEST_FRAMES; ++i)
+		{
+			for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+			{
+				aDepth[p] = (XnDepthPixel)i;
+			}
+			ASSERT_EQ(XN_STATUS_OK, fast.SetData(i, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+
+			if (i % TEST_SLOW_RATIO == 0)
+			{
+				XnUInt32 nSlowFrame = i / TEST_SLOW_RATIO;
+				for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+				{
+					aDepth[p] = (XnDepthPixel)(10000 - nSlowFrame);
+				}
+				ASSERT_EQ(XN_STATUS_OK, slow.SetData(nSlowFrame, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+			}
+
+			ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+		}
+
+		// copy what's on disk so far
+		XnUInt64 nFileSize = 0;
+		ASSERT_EQ(XN_STATUS_OK, xnOSGetFileSize64(TEST_FILE, &nFileSize));
+		ASSERT_GT(nFileSize, (XnUInt64)(TEST_FRAMES / 2 * sizeof(aDepth)));
+
+		XnUInt32 nTruncatedSize = (XnUInt32)nFileSize - TEST_TRUNCATE_BYTES;
+		XnUChar* pFile = new XnUChar[nTruncatedSize];
+		ASSERT_EQ(XN_STATUS_OK, xnOSLoadFile(TEST_FILE, pFile, nTruncatedSize));
+		XnStatus nRetVal = xnOSSaveFile(TEST_TRUNCATED_FILE, pFile, nTruncatedSize);
+		delete[] pFile;
+		ASSERT_EQ(XN_STATUS_OK, nRetVal);
+
+		recorder.Release();
+		slow.Release();
+		fast.Release();
+		context.Release();
+	}
+
+	static void OpenTruncated(Context& context, Player& player, DepthGenerator& fast, DepthGenerator& slow)
+	{
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+		ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording(TEST_TRUNCATED_FILE, player));
+		ASSERT_EQ(XN_STATUS_OK, player.SetRepeat(FALSE));
+		ASSERT_EQ(XN_STATUS_OK, player.SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST));
+		ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Fast", fast));
+		ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Slow", slow));
+	}
+
+	static void ExpectSeek(Player& player, DepthGenerator& depth, const XnChar* strName, XnUInt32 nFrame, XnDepthPixel nValue)
+	{
+		ASSERT_EQ(XN_STATUS_OK, player.SeekToFrame(strName, nFrame, XN_PLAYER_SEEK_SET));
+
+		XnUInt32 nTold = 0;
+		ASSERT_EQ(XN_STATUS_OK, player.TellFrame(strName, nTold));
+		EXPECT_EQ(nFrame, nTold);
+
+		// the frame seeked to is the node's new data
+		ASSERT_EQ(XN_STATUS_OK, depth.WaitAndUpdateData());
+		DepthMetaData md;
+		depth.GetMetaData(md);
+		EXPECT_EQ(nFrame, md.FrameID());
+		EXPECT_EQ(nValue, md.Data()[0]);
+		EXPECT_EQ(nValue, md.Data()[TEST_PIXELS - 1]);
+	}
+
+	// plays the fast node on from frame nFrame, until nLastFrame or the end of the recording
+	static void PlayFast(Context& context, DepthGenerator& fast, XnUInt32& nFrame, XnUInt32 nLastFrame)
+	{
+		DepthMetaData md;
+		while (nFrame < nLastFrame && context.WaitOneUpdateAll(fast) == XN_STATUS_OK)
+		{
+			fast.GetMetaData(md);
+			if (md.FrameID() == nFrame)
+			{
+				// only the slow node had new data
+				continue;
+			}
+
+			++nFrame;
+			ASSERT_EQ(nFrame, md.FrameID());
+			ASSERT_EQ((XnDepthPixel)nFrame, md.Data()[0]);
+		}
+	}
+};
+
+TEST_F(RecordingRecoveryTest, SeeksThroughCheckpointedSeekTable)
+{
+	RecordTruncated();
+
+	Context context;
+	Player player;
+	DepthGenerator fast;
+	DepthGenerator slow;
+	OpenTruncated(context, player, fast, slow);
+
+	// the fast node's first chunk was checkpointed
+	XnUInt32 nFrames = 0;
+	ASSERT_EQ(XN_STATUS_OK, player.GetNumFrames("Fast", nFrames));
+	EXPECT_GE(nFrames, 1024U);
+
+	// and only it - the slow node's record was never rewritten, so its frames are not known until played
+	ASSERT_EQ(XN_STATUS_OK, player.GetNumFrames("Slow", nFrames));
+	EXPECT_EQ(0U, nFrames);
+
+	// backwards and forwards through the seek table
+	ExpectSeek(player, fast, "Fast", 1000, (XnDepthPixel)1000);
+	ExpectSeek(player, fast, "Fast", 10, (XnDepthPixel)10);
+	ExpectSeek(player, fast, "Fast", 700, (XnDepthPixel)700);
+	ExpectSeek(player, fast, "Fast", 1024, (XnDepthPixel)1024);
+	ExpectSeek(player, fast, "Fast", 1, (XnDepthPixel)1);
+}
+
+TEST_F(RecordingRecoveryTest, PlaysPastLastCheckpointUntilTruncation)
+{
+	RecordTruncated();
+
+	Context context;
+	Player player;
+	DepthGenerator fast;
+	DepthGenerator slow;
+	OpenTruncated(context, player, fast, slow);
+
+	// play past the last checkpoint
+	XnUInt32 nFrame = 0;
+	PlayFast(context, fast, nFrame, TEST_PLAYED_FRAMES);
+	ASSERT_EQ((XnUInt32)TEST_PLAYED_FRAMES, nFrame);
+
+	XnUInt32 nFrames = 0;
+	ASSERT_EQ(XN_STATUS_OK, player.GetNumFrames("Fast", nFrames));
+	EXPECT_EQ((XnUInt32)TEST_PLAYED_FRAMES, nFrames);
+
+	// frames that were played can be seeked to, including the ones past the last checkpoint, and the ones of the 
+	// slow node (which has no seek table at all)
+	ExpectSeek(player, fast, "Fast", TEST_PLAYED_FRAMES - 10, (XnDepthPixel)(TEST_PLAYED_FRAMES - 10));
+	ExpectSeek(player, slow, "Slow", 200, (XnDepthPixel)(10000 - 200));
+	ExpectSeek(player, fast, "Fast", 500, (XnDepthPixel)500);
+
+	// and play on until the truncated tail
+	ExpectSeek(player, fast, "Fast", TEST_PLAYED_FRAMES, (XnDepthPixel)TEST_PLAYED_FRAMES);
+	nFrame = TEST_PLAYED_FRAMES;
+	PlayFast(context, fast, nFrame, TEST_FRAMES);
+	EXPECT_GT(nFrame, (XnUInt32)TEST_PLAYED_FRAMES);
+	EXPECT_LT(nFrame, (XnUInt32)TEST_FRAMES);
+
+	EXPECT_EQ(XN_STATUS_EOF, context.WaitOneUpdateAll(fast));
+}
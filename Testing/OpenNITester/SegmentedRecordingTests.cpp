@@ -0,0 +1,303 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnPropNames.h>
+#include <XnCodecIDs.h>
+
+using namespace xn;
+
+#define TEST_X_RES			32
+#define TEST_Y_RES			24
+#define TEST_PIXELS			(TEST_X_RES * TEST_Y_RES)
+#define TEST_FRAME_INTERVAL	33333
+#define TEST_FRAMES			300
+// a few dozen frames per segment
+#define TEST_SEGMENT_BYTES	(64 * 1024)
+#define TEST_SEGMENT_SECONDS	3
+#define TEST_WRITE_BUFFER_SIZE	4096
+#define TEST_MAX_DEPTH		10000
+
+#define TEST_FILE			"SegmentedRecordingTest.oni"
+#define TEST_BASE_NAME		"SegmentedRecordingTest"
+#define TEST_MAX_SEGMENTS	100
+
+class SegmentedRecordingTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnOSDeleteFile(TEST_FILE);
+		for (XnUInt32 i = 0; i < TEST_MAX_SEGMENTS; ++i)
+		{
+			XnChar strSegment[XN_FILE_MAX_PATH];
+			GetSegmentName(i, strSegment);
+			xnOSDeleteFile(strSegment);
+		}
+	}
+
+	static void GetSegmentName(XnUInt32 nSegment, XnChar* strSegment)
+	{
+		XnUInt32 nCharsWritten = 0;
+		xnOSStrFormat(strSegment, XN_FILE_MAX_PATH, &nCharsWritten, "%s-%05u.oni", TEST_BASE_NAME, nSegment);
+	}
+
+	static XnUInt32 CountSegments()
+	{
+		XnUInt32 nSegments = 0;
+		for (;;)
+		{
+			XnChar strSegment[XN_FILE_MAX_PATH];
+			GetSegmentName(nSegments, strSegment);
+			XnBool bExists = FALSE;
+			xnOSDoesFileExist(strSegment, &bExists);
+			if (!bExists)
+			{
+				return nSegments;
+			}
+			++nSegments;
+		}
+	}
+
+	static void CreateRecording(Context& context, MockDepthGenerator& depth, Recorder& recorder, const XnRecorderFileOptions& options)
+	{
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+
+		XnMapOutputMode mode = { TEST_X_RES, TEST_Y_RES, 30 };
+		ASSERT_EQ(XN_STATUS_OK, depth.Create(context, "Depth"));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_DEVICE_MAX_DEPTH, TEST_MAX_DEPTH));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES_COUNT, 1));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetGeneralProperty(XN_PROP_SUPPORTED_MAP_OUTPUT_MODES, sizeof(mode), &mode));
+		ASSERT_EQ(XN_STATUS_OK, depth.SetIntProperty(XN_PROP_STATE_READY, TRUE));
+
+		ASSERT_EQ(XN_STATUS_OK, recorder.Create(context));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetFileOptions(options));
+		ASSERT_EQ(XN_STATUS_OK, recorder.SetDestination(XN_RECORD_MEDIUM_FILE, TEST_FILE));
+		ASSERT_EQ(XN_STATUS_OK, recorder.AddNodeToRecording(depth, XN_CODEC_UNCOMPRESSED));
+	}
+
+	// all depth pixels of frame i are i
+	static void Record(const XnRecorderFileOptions& options, XnUInt32 nFrames)
+	{
+		Context context;
+		MockDepthGenerator depth;
+		Recorder recorder;
+		CreateRecording(context, depth, recorder, options);
+
+		XnDepthPixel aDepth[TEST_PIXELS];
+		for (XnUInt32 i = 1; i <= nFrames; ++i)
+		{
+			for (XnUInt32 p = 0; p < TEST_PIXELS; ++p)
+			{
+				aDepth[p] = (XnDepthPixel)i;
+			}
+			ASSERT_EQ(XN_STATUS_OK, depth.SetData(i, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+			ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+		}
+
+		recorder.Release();
+		depth.Release();
+		context.Release();
+	}
+
+	static void Open(Context& context, Player& player, DepthGenerator& depth)
+	{
+		ASSERT_EQ(XN_STATUS_OK, context.Init());
+		ASSERT_EQ(XN_STATUS_OK, context.OpenFileRecording(TEST_FILE, player));
+		ASSERT_EQ(XN_STATUS_OK, player.SetRepeat(FALSE));
+		ASSERT_EQ(XN_STATUS_OK, player.SetPlaybackSpeed(XN_PLAYBACK_SPEED_FASTEST));
+		ASSERT_EQ(XN_STATUS_OK, context.GetProductionNodeByName("Depth", depth));
+	}
+
+	// plays the whole recording, checking frames go on from one segment to the next
+	static void ExpectPlayback(XnUInt32 nFrames)
+	{
+		Context context;
+		Player player;
+		DepthGenerator depth;
+		Open(context, player, depth);
+
+		XnUInt32 nRecordedFrames = 0;
+		ASSERT_EQ(XN_STATUS_OK, player.GetNumFrames("Depth", nRecordedFrames));
+		EXPECT_EQ(nFrames, nRecordedFrames);
+
+		DepthMetaData md;
+		for (XnUInt32 i = 1; i <= nFrames; ++i)
+		{
+			ASSERT_EQ(XN_STATUS_OK, context.WaitOneUpdateAll(depth));
+			depth.GetMetaData(md);
+			ASSERT_EQ(i, md.FrameID());
+			// timestamps are recorded from the first frame
+			ASSERT_EQ((XnUInt64)(i - 1) * TEST_FRAME_INTERVAL, md.Timestamp());
+			ASSERT_EQ((XnDepthPixel)i, md.Data()[0]);
+			ASSERT_EQ((XnDepthPixel)i, md.Data()[TEST_PIXELS - 1]);
+		}
+
+		EXPECT_EQ(XN_STATUS_EOF, context.WaitOneUpdateAll(depth));
+	}
+
+	static void ExpectSeek(Player& player, DepthGenerator& depth, XnUInt32 nFrame)
+	{
+		ASSERT_EQ(XN_STATUS_OK, player.SeekToFrame("Depth", nFrame, XN_PLAYER_SEEK_SET));
+
+		XnUInt32 nTold = 0;
+		ASSERT_EQ(XN_STATUS_OK, player.TellFrame("Depth", nTold));
+		EXPECT_EQ(nFrame, nTold);
+
+		ASSERT_EQ(XN_STATUS_OK, depth.WaitAndUpdateData());
+		DepthMetaData md;
+		depth.GetMetaData(md);
+		EXPECT_EQ(nFrame, md.FrameID());
+		EXPECT_EQ((XnDepthPixel)nFrame, md.Data()[0]);
+
+		// and the node is the one recorded, whichever segment it was added in
+		EXPECT_EQ((XnUInt32)TEST_X_RES, md.XRes());
+		EXPECT_EQ((XnUInt32)TEST_Y_RES, md.YRes());
+		EXPECT_EQ((XnDepthPixel)TEST_MAX_DEPTH, depth.GetDeviceMaxDepth());
+	}
+};
+
+TEST_F(SegmentedRecordingTest, RollsOverBySize)
+{
+	XnRecorderFileOptions options = { 0 };
+	options.nSegmentBytes = TEST_SEGMENT_BYTES;
+	Record(options, TEST_FRAMES);
+
+	// the recording is a manifest of its segments
+	XnBool bExists = FALSE;
+	ASSERT_EQ(XN_STATUS_OK, xnOSDoesFileExist(TEST_FILE, &bExists));
+	EXPECT_TRUE(bExists);
+
+	XnUInt32 nSegments = CountSegments();
+	EXPECT_GE(nSegments, (XnUInt32)(TEST_FRAMES * TEST_PIXELS * sizeof(XnDepthPixel) / TEST_SEGMENT_BYTES));
+
+	for (XnUInt32 i = 0; i < nSegments; ++i)
+	{
+		XnChar strSegment[XN_FILE_MAX_PATH];
+		GetSegmentName(i, strSegment);
+		XnUInt64 nSize = 0;
+		ASSERT_EQ(XN_STATUS_OK, xnOSGetFileSize64(strSegment, &nSize));
+		// a segment is closed once it passes the limit, with the record that did it
+		EXPECT_LT(nSize, (XnUInt64)(TEST_SEGMENT_BYTES + 2 * TEST_PIXELS * sizeof(XnDepthPixel)));
+	}
+}
+
+TEST_F(SegmentedRecordingTest, RollsOverByTime)
+{
+	XnRecorderFileOptions options = { 0 };
+	options.nSegmentSeconds = TEST_SEGMENT_SECONDS;
+	Record(options, TEST_FRAMES);
+
+	// 10 seconds of frames
+	EXPECT_EQ((XnUInt32)(TEST_FRAMES * TEST_FRAME_INTERVAL / (TEST_SEGMENT_SECONDS * 1000000) + 1), CountSegments());
+}
+
+TEST_F(SegmentedRecordingTest, FlushesBufferWhileRecording)
+{
+	XnRecorderFileOptions options = { 0 };
+	options.nWriteBufferSize = TEST_WRITE_BUFFER_SIZE;
+	Context context;
+	MockDepthGenerator depth;
+	Recorder recorder;
+	CreateRecording(context, depth, recorder, options);
+
+	XnDepthPixel aDepth[TEST_PIXELS] = { 0 };
+	XnUInt64 nLastSize = 0;
+	for (XnUInt32 i = 1; i <= TEST_FRAMES; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, depth.SetData(i, i * TEST_FRAME_INTERVAL, sizeof(aDepth), aDepth));
+		ASSERT_EQ(XN_STATUS_OK, context.WaitNoneUpdateAll());
+
+		// frames reach the file as they are recorded (no more than a buffer behind), not only when the recorder
+		// is closed
+		XnUInt64 nSize = 0;
+		ASSERT_EQ(XN_STATUS_OK, xnOSGetFileSize64(TEST_FILE, &nSize));
+		ASSERT_GE(nSize + TEST_WRITE_BUFFER_SIZE, (XnUInt64)i * sizeof(aDepth));
+		ASSERT_GE(nSize, nLastSize);
+		nLastSize = nSize;
+	}
+
+	recorder.Release();
+	depth.Release();
+	context.Release();
+}
+
+TEST_F(SegmentedRecordingTest, PlaysSegmentsAsOneRecording)
+{
+	XnRecorderFileOptions options = { 0 };
+	options.nSegmentBytes = TEST_SEGMENT_BYTES;
+	options.nWriteBufferSize = TEST_WRITE_BUFFER_SIZE;
+	Record(options, TEST_FRAMES);
+	ASSERT_GT(CountSegments(), 1U);
+
+	ExpectPlayback(TEST_FRAMES);
+}
+
+TEST_F(SegmentedRecordingTest, SeeksAcrossSegments)
+{
+	XnRecorderFileOptions options = { 0 };
+	options.nSegmentBytes = TEST_SEGMENT_BYTES;
+	Record(options, TEST_FRAMES);
+	ASSERT_GT(CountSegments(), 1U);
+
+	Context context;
+	Player player;
+	DepthGenerator depth;
+	Open(context, player, depth);
+
+	// forwards, backwards, and within a segment
+	ExpectSeek(player, depth, TEST_FRAMES - 5);
+	ExpectSeek(player, depth, 3);
+	ExpectSeek(player, depth, TEST_FRAMES / 2);
+	ExpectSeek(player, depth, TEST_FRAMES / 2 + 1);
+	ExpectSeek(player, depth, TEST_FRAMES);
+	ExpectSeek(player, depth, 1);
+
+	// relative to the current frame
+	ASSERT_EQ(XN_STATUS_OK, player.SeekToFrame("Depth", TEST_FRAMES / 2, XN_PLAYER_SEEK_CUR));
+	XnUInt32 nTold = 0;
+	ASSERT_EQ(XN_STATUS_OK, player.TellFrame("Depth", nTold));
+	EXPECT_EQ((XnUInt32)(1 + TEST_FRAMES / 2), nTold);
+
+	// and play on through the following segments
+	DepthMetaData md;
+	for (XnUInt32 i = nTold; i <= TEST_FRAMES; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, context.WaitOneUpdateAll(depth));
+		depth.GetMetaData(md);
+		ASSERT_EQ(i, md.FrameID());
+		ASSERT_EQ((XnDepthPixel)i, md.Data()[0]);
+	}
+}
+
+TEST_F(SegmentedRecordingTest, DirectIO)
+{
+	// falls back to cached writes where the file system does not support it, either way the recording is the same
+	XnRecorderFileOptions options = { 0 };
+	options.nSegmentBytes = TEST_SEGMENT_BYTES;
+	options.nWriteBufferSize = TEST_WRITE_BUFFER_SIZE;
+	options.bDirectIO = TRUE;
+	Record(options, TEST_FRAMES);
+	ASSERT_GT(CountSegments(), 1U);
+
+	ExpectPlayback(TEST_FRAMES);
+}
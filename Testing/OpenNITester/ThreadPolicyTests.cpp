@@ -0,0 +1,229 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnOS.h>
+#include <XnOpenNI.h>
+
+#define TEST_POLICY_INI_FILE	"ThreadPolicyTest.ini"
+#define TEST_POLICY_XML_FILE	"ThreadPolicyTest.xml"
+
+static XN_THREAD_PROC TestThreadProc(XN_THREAD_PARAM pParam)
+{
+	XN_EVENT_HANDLE hEvent = (XN_EVENT_HANDLE)pParam;
+	xnOSWaitEvent(hEvent, XN_WAIT_INFINITE);
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+class ThreadPolicyTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnOSClearThreadPolicies();
+		xnOSDeleteFile(TEST_POLICY_INI_FILE);
+		xnOSDeleteFile(TEST_POLICY_XML_FILE);
+	}
+};
+
+TEST_F(ThreadPolicyTest, ParsesAffinityListsAndMasks)
+{
+	XnThreadPolicy policy;
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSParseThreadPolicy("0,2-3", NULL, &policy));
+	EXPECT_EQ(0xDULL, policy.nAffinityMask);
+	EXPECT_FALSE(policy.bOverridePriority);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSParseThreadPolicy("0xF0", "critical", &policy));
+	EXPECT_EQ(0xF0ULL, policy.nAffinityMask);
+	EXPECT_TRUE(policy.bOverridePriority);
+	EXPECT_EQ(XN_PRIORITY_CRITICAL, policy.nPriority);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSParseThreadPolicy("63", "Low", &policy));
+	EXPECT_EQ(1ULL << 63, policy.nAffinityMask);
+	EXPECT_EQ(XN_PRIORITY_LOW, policy.nPriority);
+
+	EXPECT_EQ(XN_STATUS_OS_THREAD_POLICY_INVALID, xnOSParseThreadPolicy("3-1", NULL, &policy));
+	EXPECT_EQ(XN_STATUS_OS_THREAD_POLICY_INVALID, xnOSParseThreadPolicy("64", NULL, &policy));
+	EXPECT_EQ(XN_STATUS_OS_THREAD_POLICY_INVALID, xnOSParseThreadPolicy("1;2", NULL, &policy));
+	EXPECT_EQ(XN_STATUS_OS_THREAD_POLICY_INVALID, xnOSParseThreadPolicy(NULL, "Urgent", &policy));
+}
+
+TEST_F(ThreadPolicyTest, SetAndGetByRole)
+{
+	XnThreadPolicy policy = {0};
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+
+	policy.nAffinityMask = 0x3;
+	ASSERT_EQ(XN_STATUS_OK, xnOSSetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+
+	XnThreadPolicy result;
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy("playback", &result));
+	EXPECT_EQ(0x3ULL, result.nAffinityMask);
+
+	// setting a role again replaces its policy
+	policy.nAffinityMask = 0x1;
+	ASSERT_EQ(XN_STATUS_OK, xnOSSetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &result));
+	EXPECT_EQ(0x1ULL, result.nAffinityMask);
+
+	xnOSClearThreadPolicies();
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &result));
+}
+
+TEST_F(ThreadPolicyTest, LoadsFromINI)
+{
+	const XnChar strINI[] = 
+		"[Threads]\n"
+		"USBRead.Affinity=1-2\n"
+		"USBRead.Priority=High\n"
+		"Scheduler.Priority=Low\n";
+	ASSERT_EQ(XN_STATUS_OK, xnOSSaveFile(TEST_POLICY_INI_FILE, strINI, sizeof(strINI) - 1));
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSLoadThreadPoliciesFromINI(TEST_POLICY_INI_FILE, "Threads"));
+
+	XnThreadPolicy policy;
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_USB_READ, &policy));
+	EXPECT_EQ(0x6ULL, policy.nAffinityMask);
+	EXPECT_EQ(XN_PRIORITY_HIGH, policy.nPriority);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_SCHEDULER, &policy));
+	EXPECT_EQ(0ULL, policy.nAffinityMask);
+	EXPECT_EQ(XN_PRIORITY_LOW, policy.nPriority);
+
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+}
+
+TEST_F(ThreadPolicyTest, LoadsFromXml)
+{
+	const XnChar strXml[] = 
+		"<OpenNI>\n"
+		"	<Threads>\n"
+		"		<Thread role=\"Playback\" affinity=\"0x2\"/>\n"
+		"		<Thread role=\"MyModuleWorker\" priority=\"Normal\"/>\n"
+		"	</Threads>\n"
+		"</OpenNI>\n";
+	ASSERT_EQ(XN_STATUS_OK, xnOSSaveFile(TEST_POLICY_XML_FILE, strXml, sizeof(strXml) - 1));
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSLoadThreadPoliciesFromXmlFile(TEST_POLICY_XML_FILE));
+
+	XnThreadPolicy policy;
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+	EXPECT_EQ(0x2ULL, policy.nAffinityMask);
+	EXPECT_FALSE(policy.bOverridePriority);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy("MyModuleWorker", &policy));
+	EXPECT_TRUE(policy.bOverridePriority);
+	EXPECT_EQ(XN_PRIORITY_NORMAL, policy.nPriority);
+}
+
+TEST_F(ThreadPolicyTest, AppliesAffinityToThread)
+{
+	XN_EVENT_HANDLE hEvent;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateEvent(&hEvent, TRUE));
+
+	XN_THREAD_HANDLE hThread;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(TestThreadProc, hEvent, &hThread));
+
+	XnThreadPolicy policy = {0};
+	policy.nAffinityMask = 0x1;
+	ASSERT_EQ(XN_STATUS_OK, xnOSSetThreadPolicy("Test", &policy));
+
+	// CPU 0 always exists, so pinning to it should work wherever affinity is supported
+	XnStatus nRetVal = xnOSApplyThreadPolicy(hThread, "Test", "XnPolicyTest");
+	EXPECT_TRUE(nRetVal == XN_STATUS_OK || nRetVal == XN_STATUS_OS_UNSUPPORTED_FUNCTION);
+
+	xnOSSetEvent(hEvent);
+	EXPECT_EQ(XN_STATUS_OK, xnOSWaitForThreadExit(hThread, 5000));
+	xnOSCloseThread(&hThread);
+	xnOSCloseEvent(&hEvent);
+}
+
+TEST_F(ThreadPolicyTest, INIKeepsSettingsOfMissingKeys)
+{
+	XnThreadPolicy policy = {0};
+	policy.nAffinityMask = 0x3;
+	policy.nPriority = XN_PRIORITY_HIGH;
+	policy.bOverridePriority = TRUE;
+	ASSERT_EQ(XN_STATUS_OK, xnOSSetThreadPolicy(XN_THREAD_ROLE_USB_READ, &policy));
+	ASSERT_EQ(XN_STATUS_OK, xnOSSetThreadPolicy(XN_THREAD_ROLE_SCHEDULER, &policy));
+
+	const XnChar strINI[] = 
+		"[Threads]\n"
+		"USBRead.Affinity=4\n"
+		"Scheduler.Priority=Low\n";
+	ASSERT_EQ(XN_STATUS_OK, xnOSSaveFile(TEST_POLICY_INI_FILE, strINI, sizeof(strINI) - 1));
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSLoadThreadPoliciesFromINI(TEST_POLICY_INI_FILE, "Threads"));
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_USB_READ, &policy));
+	EXPECT_EQ(0x10ULL, policy.nAffinityMask);
+	EXPECT_TRUE(policy.bOverridePriority);
+	EXPECT_EQ(XN_PRIORITY_HIGH, policy.nPriority);
+
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_SCHEDULER, &policy));
+	EXPECT_EQ(0x3ULL, policy.nAffinityMask);
+	EXPECT_TRUE(policy.bOverridePriority);
+	EXPECT_EQ(XN_PRIORITY_LOW, policy.nPriority);
+}
+
+TEST_F(ThreadPolicyTest, XmlSkipsInvalidEntries)
+{
+	const XnChar strXml[] = 
+		"<OpenNI>\n"
+		"	<Threads>\n"
+		"		<Thread affinity=\"0x1\"/>\n"
+		"		<Thread role=\"Playback\" affinity=\"0-\"/>\n"
+		"		<Thread role=\"Scheduler\" affinity=\"0x4\"/>\n"
+		"	</Threads>\n"
+		"</OpenNI>\n";
+	ASSERT_EQ(XN_STATUS_OK, xnOSSaveFile(TEST_POLICY_XML_FILE, strXml, sizeof(strXml) - 1));
+
+	EXPECT_NE(XN_STATUS_OK, xnOSLoadThreadPoliciesFromXmlFile(TEST_POLICY_XML_FILE));
+
+	XnThreadPolicy policy;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_SCHEDULER, &policy));
+	EXPECT_EQ(0x4ULL, policy.nAffinityMask);
+}
+
+TEST_F(ThreadPolicyTest, InitFromXmlIgnoresInvalidPolicies)
+{
+	const XnChar strXml[] = 
+		"<OpenNI>\n"
+		"	<Threads>\n"
+		"		<Thread role=\"Playback\" priority=\"Urgent\"/>\n"
+		"		<Thread role=\"Scheduler\" priority=\"High\"/>\n"
+		"	</Threads>\n"
+		"</OpenNI>\n";
+	ASSERT_EQ(XN_STATUS_OK, xnOSSaveFile(TEST_POLICY_XML_FILE, strXml, sizeof(strXml) - 1));
+
+	XnContext* pContext = NULL;
+	XnNodeHandle hScriptNode = NULL;
+	ASSERT_EQ(XN_STATUS_OK, xnInitFromXmlFileEx(TEST_POLICY_XML_FILE, &pContext, NULL, &hScriptNode));
+
+	XnThreadPolicy policy;
+	EXPECT_EQ(XN_STATUS_NO_MATCH, xnOSGetThreadPolicy(XN_THREAD_ROLE_PLAYBACK, &policy));
+	ASSERT_EQ(XN_STATUS_OK, xnOSGetThreadPolicy(XN_THREAD_ROLE_SCHEDULER, &policy));
+	EXPECT_EQ(XN_PRIORITY_HIGH, policy.nPriority);
+
+	xnProductionNodeRelease(hScriptNode);
+	xnContextRelease(pContext);
+}
@@ -0,0 +1,333 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnCppWrapper.h>
+#include <XnTrace.h>
+#include <string>
+
+using namespace xn;
+
+#define TEST_TRACE_FILE	"TraceTest.json"
+
+static std::string ReadTraceFile()
+{
+	std::string result;
+	FILE* pFile = fopen(TEST_TRACE_FILE, "rb");
+	if (pFile == NULL)
+	{
+		return result;
+	}
+
+	char buffer[4096];
+	size_t nRead;
+	while ((nRead = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+	{
+		result.append(buffer, nRead);
+	}
+	fclose(pFile);
+	return result;
+}
+
+static int CountOccurrences(const std::string& str, const std::string& what)
+{
+	int nCount = 0;
+	for (size_t pos = str.find(what); pos != std::string::npos; pos = str.find(what, pos + what.size()))
+	{
+		++nCount;
+	}
+	return nCount;
+}
+
+class TraceTest : public ::testing::Test
+{
+protected:
+	virtual void TearDown()
+	{
+		xnTraceStop();
+		xnOSDeleteFile(TEST_TRACE_FILE);
+	}
+};
+
+TEST_F(TraceTest, EventsAreExportedAsChromeTrace)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+	EXPECT_TRUE(xnTraceIsActive());
+
+	XN_TRACE_BEGIN(XN_TRACE_ENCODE, "Codec1", 1000, 7, 1234);
+	XN_TRACE_END(XN_TRACE_ENCODE, "Codec1", 1000, 7, 1234);
+	XN_TRACE_INSTANT(XN_TRACE_NEW_DATA_AVAILABLE, "Depth1", 1000, 7, 0);
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+
+	EXPECT_EQ(0u, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+	EXPECT_EQ(1, CountOccurrences(trace, "\"name\":\"Encode\",\"cat\":\"OpenNI\",\"ph\":\"B\""));
+	EXPECT_EQ(1, CountOccurrences(trace, "\"name\":\"Encode\",\"cat\":\"OpenNI\",\"ph\":\"E\""));
+	EXPECT_EQ(1, CountOccurrences(trace, "\"name\":\"NewDataAvailable\",\"cat\":\"OpenNI\",\"ph\":\"i\""));
+	EXPECT_EQ(2, CountOccurrences(trace, "\"object\":\"Codec1\",\"dataTimestamp\":1000,\"frameID\":7,\"size\":1234"));
+	// new data starts a flow
+	EXPECT_EQ(1, CountOccurrences(trace, "\"ph\":\"s\""));
+}
+
+TEST_F(TraceTest, NothingIsRecordedWhenStopped)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStop());
+	EXPECT_FALSE(xnTraceIsActive());
+
+	XN_TRACE_INSTANT(XN_TRACE_WAIT, "Ignored", 0, 0, 0);
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	EXPECT_EQ(0, CountOccurrences(ReadTraceFile(), "Ignored"));
+}
+
+TEST_F(TraceTest, RingKeepsNewestEvents)
+{
+	// rounded up to 4
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(3));
+
+	for (XnUInt32 i = 0; i < 10; ++i)
+	{
+		xnTraceWrite(XN_TRACE_RECORD, XN_TRACE_PHASE_INSTANT, "Ring", 0, i, 0);
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+
+	EXPECT_EQ(4, CountOccurrences(trace, "\"object\":\"Ring\""));
+	EXPECT_EQ(0, CountOccurrences(trace, "\"frameID\":5,"));
+	for (XnUInt32 i = 6; i < 10; ++i)
+	{
+		XnChar strFrame[32];
+		sprintf(strFrame, "\"frameID\":%u,", i);
+		EXPECT_EQ(1, CountOccurrences(trace, strFrame));
+	}
+}
+
+TEST_F(TraceTest, NewSessionDiscardsOldEvents)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+	XN_TRACE_INSTANT(XN_TRACE_WAIT, "OldSession", 0, 0, 0);
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+	XN_TRACE_INSTANT(XN_TRACE_WAIT, "NewSession", 0, 0, 0);
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+	EXPECT_EQ(0, CountOccurrences(trace, "OldSession"));
+	EXPECT_EQ(1, CountOccurrences(trace, "NewSession"));
+}
+
+static XN_THREAD_PROC TraceTestThread(XN_THREAD_PARAM /*pParam*/)
+{
+	for (XnUInt32 i = 0; i < 100; ++i)
+	{
+		XN_TRACE_INSTANT(XN_TRACE_USB_TRANSFER, "OtherThread", 0, i, 0);
+	}
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+TEST_F(TraceTest, EachThreadHasItsOwnBuffer)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(64));
+
+	XN_THREAD_HANDLE hThread;
+	ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(TraceTestThread, NULL, &hThread));
+	for (XnUInt32 i = 0; i < 100; ++i)
+	{
+		XN_TRACE_INSTANT(XN_TRACE_USB_TRANSFER, "MainThread", 0, i, 0);
+	}
+	ASSERT_EQ(XN_STATUS_OK, xnOSWaitForThreadExit(hThread, XN_WAIT_INFINITE));
+	xnOSCloseThread(&hThread);
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+	EXPECT_EQ(64, CountOccurrences(trace, "\"object\":\"MainThread\""));
+	EXPECT_EQ(64, CountOccurrences(trace, "\"object\":\"OtherThread\""));
+}
+
+TEST_F(TraceTest, UpdateDataIsTraced)
+{
+	Context context;
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	MockDepthGenerator depth;
+	ASSERT_EQ(XN_STATUS_OK, depth.Create(context, "TracedDepth"));
+	XnMapOutputMode mode = { 4, 4, 30 };
+	ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+
+	XnDepthPixel frame[16] = {0};
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(3, 3000, sizeof(frame), frame));
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+	EXPECT_EQ(1, CountOccurrences(trace, "\"name\":\"UpdateData\",\"cat\":\"OpenNI\",\"ph\":\"B\""));
+	EXPECT_EQ(1, CountOccurrences(trace, "\"object\":\"TracedDepth\",\"dataTimestamp\":3000,\"frameID\":3,\"size\":32"));
+	// the update ends the frame's flow
+	EXPECT_EQ(1, CountOccurrences(trace, "\"ph\":\"f\""));
+
+	depth.Release();
+	context.Release();
+}
+
+TEST_F(TraceTest, EventsAreKeptAfterStop)
+{
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(8));
+	for (XnUInt32 i = 0; i < 10; ++i)
+	{
+		xnTraceWrite(XN_TRACE_RECORD, XN_TRACE_PHASE_INSTANT, "Stopped", 0, i, 0);
+	}
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStop());
+
+	// written after the stop, so not recorded
+	xnTraceWrite(XN_TRACE_RECORD, XN_TRACE_PHASE_INSTANT, "Stopped", 0, 100, 0);
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+
+	// the newest events, oldest first
+	EXPECT_EQ(8, CountOccurrences(trace, "\"object\":\"Stopped\""));
+	size_t nLastPos = 0;
+	for (XnUInt32 i = 2; i < 10; ++i)
+	{
+		XnChar strFrame[32];
+		sprintf(strFrame, "\"frameID\":%u,", i);
+		size_t nPos = trace.find(strFrame);
+		ASSERT_NE(std::string::npos, nPos);
+		EXPECT_GT(nPos, nLastPos);
+		nLastPos = nPos;
+	}
+
+	// until tracing starts again
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(8));
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	EXPECT_EQ(0, CountOccurrences(ReadTraceFile(), "Stopped"));
+}
+
+static XN_THREAD_PROC TraceTestWriterThread(XN_THREAD_PARAM pParam)
+{
+	volatile XnBool* pbStop = (volatile XnBool*)pParam;
+	for (XnUInt32 i = 0; !*pbStop; ++i)
+	{
+		XN_TRACE_INSTANT(XN_TRACE_USB_TRANSFER, "Writer", 0, i, 0);
+	}
+	XN_THREAD_PROC_RETURN(XN_STATUS_OK);
+}
+
+TEST_F(TraceTest, SessionsCanEndWhileThreadsWrite)
+{
+	volatile XnBool bStop = FALSE;
+	XN_THREAD_HANDLE ahThreads[4];
+	for (XnUInt32 i = 0; i < 4; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, xnOSCreateThread(TraceTestWriterThread, (XN_THREAD_PARAM)&bStop, &ahThreads[i]));
+	}
+
+	// each stop and start frees the buffers the threads are writing to
+	for (XnUInt32 i = 0; i < 200; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, xnTraceStart(64));
+		xnOSSleep(0);
+		if (i % 2 == 0)
+		{
+			ASSERT_EQ(XN_STATUS_OK, xnTraceStop());
+		}
+	}
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+
+	bStop = TRUE;
+	for (XnUInt32 i = 0; i < 4; ++i)
+	{
+		ASSERT_EQ(XN_STATUS_OK, xnOSWaitForThreadExit(ahThreads[i], XN_WAIT_INFINITE));
+		xnOSCloseThread(&ahThreads[i]);
+	}
+
+	// every event of the last session belongs to one of the threads
+	std::string trace = ReadTraceFile();
+	EXPECT_LE(CountOccurrences(trace, "\"object\":\"Writer\""), 4 * 64);
+}
+
+TEST_F(TraceTest, NewDataReportsAreNumberedPerObject)
+{
+	// nothing is numbered while not tracing
+	EXPECT_EQ(0U, xnTraceReportNewData("Numbered1"));
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+	EXPECT_EQ(0U, xnTraceConsumeNewData("Numbered1"));
+
+	EXPECT_EQ(1U, xnTraceReportNewData("Numbered1"));
+	EXPECT_EQ(2U, xnTraceReportNewData("Numbered1"));
+	EXPECT_EQ(1U, xnTraceReportNewData("Numbered2"));
+
+	// an update consumes the last report, and only once
+	EXPECT_EQ(2U, xnTraceConsumeNewData("Numbered1"));
+	EXPECT_EQ(0U, xnTraceConsumeNewData("Numbered1"));
+	EXPECT_EQ(1U, xnTraceConsumeNewData("Numbered2"));
+
+	// a new session numbers from the start
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+	EXPECT_EQ(1U, xnTraceReportNewData("Numbered1"));
+}
+
+static std::string GetFlowID(const std::string& trace, const std::string& strPhase, size_t nFrom)
+{
+	size_t nPos = trace.find("\"ph\":\"" + strPhase + "\"", nFrom);
+	if (nPos == std::string::npos)
+	{
+		return std::string();
+	}
+
+	size_t nStart = trace.find("\"id\":\"", nPos) + 6;
+	return trace.substr(nStart, trace.find('"', nStart) - nStart);
+}
+
+TEST_F(TraceTest, FlowConnectsNewDataToItsUpdate)
+{
+	Context context;
+	ASSERT_EQ(XN_STATUS_OK, context.Init());
+	MockDepthGenerator depth;
+	ASSERT_EQ(XN_STATUS_OK, depth.Create(context, "FlowDepth"));
+	XnMapOutputMode mode = { 4, 4, 30 };
+	ASSERT_EQ(XN_STATUS_OK, depth.SetMapOutputMode(mode));
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceStart(0));
+
+	XnDepthPixel frame[16] = {0};
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(1, 1000, sizeof(frame), frame));
+	ASSERT_EQ(XN_STATUS_OK, depth.SetData(2, 2000, sizeof(frame), frame));
+
+	ASSERT_EQ(XN_STATUS_OK, xnTraceExportChromeJSON(TEST_TRACE_FILE));
+	std::string trace = ReadTraceFile();
+
+	ASSERT_EQ(2, CountOccurrences(trace, "\"ph\":\"s\""));
+	ASSERT_EQ(2, CountOccurrences(trace, "\"ph\":\"f\""));
+
+	// each new data report goes to its own update
+	std::string strFirst = GetFlowID(trace, "s", 0);
+	std::string strSecond = GetFlowID(trace, "s", trace.find("\"ph\":\"s\"") + 1);
+	EXPECT_NE(strFirst, strSecond);
+	EXPECT_EQ(strFirst, GetFlowID(trace, "f", 0));
+	EXPECT_EQ(strSecond, GetFlowID(trace, "f", trace.find("\"ph\":\"f\"") + 1));
+
+	depth.Release();
+	context.Release();
+}
@@ -0,0 +1,239 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnUSB.h>
+#include <XnUSBSimulator.h>
+
+#if XN_PLATFORM != XN_PLATFORM_WIN32
+
+#define TEST_END_POINT		0x81
+#define TEST_NUM_BUFFERS	4
+#define TEST_WAIT_TIMEOUT	5000
+
+class USBReadThreadTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		// USB may already have been initialized by someone else in this process
+		XnStatus nRetVal = xnUSBInit();
+		ASSERT_TRUE(nRetVal == XN_STATUS_OK || nRetVal == XN_STATUS_USB_ALREADY_INIT);
+		m_bShutdown = (nRetVal == XN_STATUS_OK);
+		m_pEndPoint = NULL;
+		m_nBytes = 0;
+		m_nCalls = 0;
+		m_nBadBuffers = 0;
+		m_nPacketCalls = 0;
+		m_nMaxPacketSize = 0;
+	}
+
+	virtual void TearDown()
+	{
+		if (m_pEndPoint != NULL)
+		{
+			xnUSBCloseEndPoint(m_pEndPoint);
+		}
+
+		if (m_bShutdown)
+		{
+			xnUSBShutdown();
+		}
+	}
+
+	void Open(XnUSBEndPointType type, XnUInt32 nMaxPacketSize, XnUInt32 nBytesPerSecond, XnUInt32 nBytesPerPacket, XnUSBReadThreadMode mode)
+	{
+		XnUSBSimulatedEndPointConfig config = { TEST_END_POINT, type, nMaxPacketSize, nBytesPerSecond, nBytesPerPacket };
+		ASSERT_EQ(XN_STATUS_OK, xnUSBSimulatorOpenEndPoint(&config, &m_pEndPoint));
+		ASSERT_EQ(XN_STATUS_OK, xnUSBSetReadThreadMode(m_pEndPoint, mode));
+	}
+
+	void WaitForBytes(XnUInt64 nBytes)
+	{
+		for (XnUInt32 i = 0; i < TEST_WAIT_TIMEOUT && m_nBytes < nBytes; ++i)
+		{
+			xnOSSleep(1);
+		}
+		ASSERT_GE(m_nBytes, nBytes);
+	}
+
+	// the callback is never called concurrently for the same endpoint, in either mode
+	static XnBool XN_CALLBACK_TYPE OnRead(XnUChar* pBuffer, XnUInt32 nBufferSize, void* pCallbackData)
+	{
+		USBReadThreadTest* pThis = (USBReadThreadTest*)pCallbackData;
+
+		for (XnUInt32 i = 0; i < nBufferSize; ++i)
+		{
+			if (pBuffer[i] != (XnUChar)((pThis->m_nBytes + i) % XN_USB_SIMULATOR_PATTERN_PERIOD))
+			{
+				++pThis->m_nBadBuffers;
+				break;
+			}
+		}
+
+		pThis->m_nBytes += nBufferSize;
+		++pThis->m_nCalls;
+		return TRUE;
+	}
+
+	// packets are handed over where the endpoint wrote them, so each one starts a max packet size apart
+	static XnBool XN_CALLBACK_TYPE OnPackets(const XnUSBPacket* aPackets, XnUInt32 nCount, void* pCallbackData)
+	{
+		USBReadThreadTest* pThis = (USBReadThreadTest*)pCallbackData;
+
+		for (XnUInt32 i = 0; i < nCount; ++i)
+		{
+			if (aPackets[i].nStatus != XN_STATUS_OK || aPackets[i].pData != aPackets[0].pData + i * pThis->m_nMaxPacketSize)
+			{
+				++pThis->m_nBadBuffers;
+			}
+
+			OnRead(aPackets[i].pData, aPackets[i].nSize, pCallbackData);
+		}
+
+		++pThis->m_nPacketCalls;
+		return TRUE;
+	}
+
+	// reads a few megabytes of an unpaced bulk endpoint, and checks they arrived in order
+	void CheckStreamInOrder(XnUSBReadThreadMode mode)
+	{
+		Open(XN_USB_EP_BULK, 512, 0, 0, mode);
+		ASSERT_EQ(XN_STATUS_OK, xnUSBInitReadThread(m_pEndPoint, 16 * 1024, TEST_NUM_BUFFERS, 1000, OnRead, this));
+		WaitForBytes(4 * 1024 * 1024);
+		ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+
+		XnUInt64 nBytes = m_nBytes;
+		xnOSSleep(20);
+		EXPECT_EQ(nBytes, m_nBytes);
+		EXPECT_EQ(0U, m_nBadBuffers);
+
+		XnUSBEndPointStatistics stats;
+		ASSERT_EQ(XN_STATUS_OK, xnUSBGetEndPointStatistics(m_pEndPoint, &stats));
+		EXPECT_EQ(m_nBytes, stats.nBytes);
+		EXPECT_EQ(m_nCalls, stats.nTransfers);
+		EXPECT_EQ(stats.nTransfers, stats.transferLatency.nCount);
+		EXPECT_EQ(m_nCalls, stats.callbackDuration.nCount);
+		EXPECT_EQ(m_nCalls, stats.dispatchLatency.nCount);
+		EXPECT_GE(stats.transferLatency.nTotal, stats.transferLatency.nMax);
+		EXPECT_EQ(0U, stats.nTimeouts);
+		EXPECT_EQ(0U, stats.nFailedTransfers);
+		EXPECT_EQ(0U, stats.nSubmitFailures);
+	}
+
+	// reads an isochronous endpoint with short packets through the scatter-gather callback
+	void CheckPacketsInPlace(XnUSBReadThreadMode mode)
+	{
+		// 32 packets of 1024 bytes per buffer, each holding only 700
+		m_nMaxPacketSize = 1024;
+		Open(XN_USB_EP_ISOCHRONOUS, m_nMaxPacketSize, 0, 700, mode);
+		ASSERT_EQ(XN_STATUS_OK, xnUSBInitPacketReadThread(m_pEndPoint, 32 * 1024, TEST_NUM_BUFFERS, 1000, OnPackets, this));
+		WaitForBytes(1024 * 1024);
+		ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+
+		EXPECT_EQ(0U, m_nBadBuffers);
+		EXPECT_EQ(m_nPacketCalls * 32, m_nCalls);
+		EXPECT_EQ(m_nCalls * 700, m_nBytes);
+	}
+
+	// reads a paced endpoint that cannot fill a buffer within the timeout
+	void CheckSlowTransfersTimeOut(XnUSBReadThreadMode mode)
+	{
+		Open(XN_USB_EP_BULK, 512, 200 * 1024, 0, mode);
+		ASSERT_EQ(XN_STATUS_OK, xnUSBInitReadThread(m_pEndPoint, 64 * 1024, TEST_NUM_BUFFERS, 20, OnRead, this));
+		WaitForBytes(32 * 1024);
+		ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+
+		EXPECT_EQ(0U, m_nBadBuffers);
+
+		XnUSBEndPointStatistics stats;
+		ASSERT_EQ(XN_STATUS_OK, xnUSBGetEndPointStatistics(m_pEndPoint, &stats));
+		EXPECT_LT(0U, stats.nTimeouts);
+		EXPECT_EQ(m_nBytes, stats.nBytes);
+		EXPECT_EQ(0U, stats.nFailedTransfers);
+	}
+
+	XN_USB_EP_HANDLE m_pEndPoint;
+	XnBool m_bShutdown;
+	volatile XnUInt64 m_nBytes;
+	volatile XnUInt64 m_nCalls;
+	volatile XnUInt32 m_nBadBuffers;
+	volatile XnUInt64 m_nPacketCalls;
+	XnUInt32 m_nMaxPacketSize;
+};
+
+TEST_F(USBReadThreadTest, OrderedModeDeliversStreamInOrder)
+{
+	CheckStreamInOrder(XN_USB_READ_THREAD_MODE_ORDERED);
+}
+
+TEST_F(USBReadThreadTest, CompletionModeDeliversStreamInOrder)
+{
+	CheckStreamInOrder(XN_USB_READ_THREAD_MODE_COMPLETION);
+}
+
+TEST_F(USBReadThreadTest, CompletionModeCompactsIsochronousPackets)
+{
+	// 32 packets of 1024 bytes per buffer, each holding only 700
+	Open(XN_USB_EP_ISOCHRONOUS, 1024, 0, 700, XN_USB_READ_THREAD_MODE_COMPLETION);
+	ASSERT_EQ(XN_STATUS_OK, xnUSBInitReadThread(m_pEndPoint, 32 * 1024, TEST_NUM_BUFFERS, 1000, OnRead, this));
+	WaitForBytes(1024 * 1024);
+	ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+
+	EXPECT_EQ(0U, m_nBadBuffers);
+	EXPECT_EQ(m_nCalls * 32 * 700, m_nBytes);
+}
+
+TEST_F(USBReadThreadTest, OrderedModePassesIsochronousPacketsInPlace)
+{
+	CheckPacketsInPlace(XN_USB_READ_THREAD_MODE_ORDERED);
+}
+
+TEST_F(USBReadThreadTest, CompletionModePassesIsochronousPacketsInPlace)
+{
+	CheckPacketsInPlace(XN_USB_READ_THREAD_MODE_COMPLETION);
+}
+
+TEST_F(USBReadThreadTest, OrderedModeTimesOutSlowTransfers)
+{
+	CheckSlowTransfersTimeOut(XN_USB_READ_THREAD_MODE_ORDERED);
+}
+
+TEST_F(USBReadThreadTest, CompletionModeTimesOutSlowTransfers)
+{
+	CheckSlowTransfersTimeOut(XN_USB_READ_THREAD_MODE_COMPLETION);
+}
+
+TEST_F(USBReadThreadTest, ModeIsSetBeforeStarting)
+{
+	Open(XN_USB_EP_BULK, 512, 0, 0, XN_USB_READ_THREAD_MODE_COMPLETION);
+
+	XnUSBReadThreadMode mode;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBGetReadThreadMode(m_pEndPoint, &mode));
+	EXPECT_EQ(XN_USB_READ_THREAD_MODE_COMPLETION, mode);
+	EXPECT_EQ(XN_STATUS_BAD_PARAM, xnUSBSetReadThreadMode(m_pEndPoint, (XnUSBReadThreadMode)7));
+
+	ASSERT_EQ(XN_STATUS_OK, xnUSBInitReadThread(m_pEndPoint, 16 * 1024, TEST_NUM_BUFFERS, 1000, OnRead, this));
+	EXPECT_EQ(XN_STATUS_USB_READTHREAD_ALREADY_INIT, xnUSBSetReadThreadMode(m_pEndPoint, XN_USB_READ_THREAD_MODE_ORDERED));
+	ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+	EXPECT_EQ(XN_STATUS_OK, xnUSBSetReadThreadMode(m_pEndPoint, XN_USB_READ_THREAD_MODE_ORDERED));
+}
+
+#endif // XN_PLATFORM != XN_PLATFORM_WIN32
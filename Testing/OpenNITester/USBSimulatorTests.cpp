@@ -0,0 +1,265 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+#include <gtest/gtest.h>
+#include <XnUSB.h>
+#include <XnUSBSimulator.h>
+
+#if XN_PLATFORM != XN_PLATFORM_WIN32
+
+#define TEST_VENDOR_ID		0x1d27
+#define TEST_PRODUCT_ID		0x0601
+#define TEST_BULK_IN		0x81
+#define TEST_ISO_IN			0x82
+#define TEST_BULK_OUT		0x02
+#define TEST_WAIT_TIMEOUT	5000
+
+class USBSimulatorTest : public ::testing::Test
+{
+protected:
+	virtual void SetUp()
+	{
+		// USB may already have been initialized by someone else in this process
+		XnStatus nRetVal = xnUSBInit();
+		ASSERT_TRUE(nRetVal == XN_STATUS_OK || nRetVal == XN_STATUS_USB_ALREADY_INIT);
+		m_bShutdown = (nRetVal == XN_STATUS_OK);
+		m_pDevice = NULL;
+		m_pEndPoint = NULL;
+		m_strPath[0] = '\0';
+		m_nBytes = 0;
+		m_nPackets = 0;
+		m_nFailedPackets = 0;
+		m_nDisconnects = 0;
+
+		xnOSMemSet(m_aEndPoints, 0, sizeof(m_aEndPoints));
+		m_aEndPoints[0].nEndPointID = TEST_BULK_IN;
+		m_aEndPoints[0].nType = XN_USB_EP_BULK;
+		m_aEndPoints[0].nMaxPacketSize = 512;
+		m_aEndPoints[1].nEndPointID = TEST_ISO_IN;
+		m_aEndPoints[1].nType = XN_USB_EP_ISOCHRONOUS;
+		m_aEndPoints[1].nMaxPacketSize = 1024;
+		m_aEndPoints[2].nEndPointID = TEST_BULK_OUT;
+		m_aEndPoints[2].nType = XN_USB_EP_BULK;
+		m_aEndPoints[2].nMaxPacketSize = 512;
+	}
+
+	virtual void TearDown()
+	{
+		if (m_pEndPoint != NULL)
+		{
+			xnUSBCloseEndPoint(m_pEndPoint);
+		}
+
+		if (m_pDevice != NULL)
+		{
+			xnUSBCloseDevice(m_pDevice);
+		}
+
+		if (m_strPath[0] != '\0')
+		{
+			xnUSBSimulatorDisconnectDevice(m_strPath);
+		}
+
+		if (m_bShutdown)
+		{
+			xnUSBShutdown();
+		}
+	}
+
+	void Connect()
+	{
+		XnUSBSimulatedDeviceConfig config = { TEST_VENDOR_ID, TEST_PRODUCT_ID, XN_USB_DEVICE_HIGH_SPEED, m_aEndPoints, 3, NULL, NULL };
+		ASSERT_EQ(XN_STATUS_OK, xnUSBSimulatorConnectDevice(&config, m_strPath));
+		ASSERT_EQ(XN_STATUS_OK, xnUSBOpenDeviceByPath(m_strPath, &m_pDevice));
+	}
+
+	void WaitFor(volatile XnUInt64& nValue, XnUInt64 nExpected)
+	{
+		for (XnUInt32 i = 0; i < TEST_WAIT_TIMEOUT && nValue < nExpected; ++i)
+		{
+			xnOSSleep(1);
+		}
+		ASSERT_GE(nValue, nExpected);
+	}
+
+	static XnBool XN_CALLBACK_TYPE OnRead(XnUChar* /*pBuffer*/, XnUInt32 nBufferSize, void* pCallbackData)
+	{
+		USBSimulatorTest* pThis = (USBSimulatorTest*)pCallbackData;
+		pThis->m_nBytes += nBufferSize;
+		return TRUE;
+	}
+
+	static XnBool XN_CALLBACK_TYPE OnPackets(const XnUSBPacket* aPackets, XnUInt32 nCount, void* pCallbackData)
+	{
+		USBSimulatorTest* pThis = (USBSimulatorTest*)pCallbackData;
+
+		for (XnUInt32 i = 0; i < nCount; ++i)
+		{
+			if (aPackets[i].nStatus != XN_STATUS_OK)
+			{
+				++pThis->m_nFailedPackets;
+			}
+			pThis->m_nBytes += aPackets[i].nSize;
+		}
+
+		pThis->m_nPackets += nCount;
+		return TRUE;
+	}
+
+	static void XN_CALLBACK_TYPE OnConnectivity(XnUSBEventArgs* pArgs, void* pCookie)
+	{
+		USBSimulatorTest* pThis = (USBSimulatorTest*)pCookie;
+		if (pArgs->eventType == XN_USB_EVENT_DEVICE_DISCONNECT)
+		{
+			++pThis->m_nDisconnects;
+		}
+	}
+
+	XnUSBSimulatedEndPointConfig m_aEndPoints[3];
+	XnUSBConnectionString m_strPath;
+	XN_USB_DEV_HANDLE m_pDevice;
+	XN_USB_EP_HANDLE m_pEndPoint;
+	XnBool m_bShutdown;
+	volatile XnUInt64 m_nBytes;
+	volatile XnUInt64 m_nPackets;
+	volatile XnUInt64 m_nFailedPackets;
+	volatile XnUInt64 m_nDisconnects;
+};
+
+TEST_F(USBSimulatorTest, ConnectedDeviceIsEnumeratedUntilDisconnected)
+{
+	Connect();
+
+	const XnUSBConnectionString* astrPaths = NULL;
+	XnUInt32 nCount = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBEnumerateDevices(TEST_VENDOR_ID, TEST_PRODUCT_ID, &astrPaths, &nCount));
+	ASSERT_EQ(1U, nCount);
+	EXPECT_STREQ(m_strPath, astrPaths[0]);
+	xnUSBFreeDevicesList(astrPaths);
+
+	XnUSBDeviceSpeed speed;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBGetDeviceSpeed(m_pDevice, &speed));
+	EXPECT_EQ(XN_USB_DEVICE_HIGH_SPEED, speed);
+	EXPECT_EQ(XN_STATUS_OK, xnUSBSetInterface(m_pDevice, 0, 1));
+
+	// without a control handler, the device answers with what it was sent
+	XnUChar aSent[] = { 1, 2, 3, 4, 5 };
+	XnUChar aReceived[16];
+	XnUInt32 nReceived = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBSendControl(m_pDevice, XN_USB_CONTROL_TYPE_VENDOR, 0, 0, 0, aSent, sizeof(aSent), 1000));
+	ASSERT_EQ(XN_STATUS_OK, xnUSBReceiveControl(m_pDevice, XN_USB_CONTROL_TYPE_VENDOR, 0, 0, 0, aReceived, sizeof(aReceived), &nReceived, 1000));
+	ASSERT_EQ(sizeof(aSent), nReceived);
+	EXPECT_EQ(0, memcmp(aSent, aReceived, sizeof(aSent)));
+
+	EXPECT_EQ(XN_STATUS_USB_ENDPOINT_NOT_FOUND, xnUSBOpenEndPoint(m_pDevice, 0x85, XN_USB_EP_BULK, XN_USB_DIRECTION_IN, &m_pEndPoint));
+	EXPECT_EQ(XN_STATUS_USB_WRONG_ENDPOINT_TYPE, xnUSBOpenEndPoint(m_pDevice, TEST_BULK_IN, XN_USB_EP_INTERRUPT, XN_USB_DIRECTION_IN, &m_pEndPoint));
+
+	ASSERT_EQ(XN_STATUS_OK, xnUSBSimulatorDisconnectDevice(m_strPath));
+	EXPECT_EQ(XN_STATUS_USB_DEVICE_NOT_FOUND, xnUSBSimulatorDisconnectDevice(m_strPath));
+	m_strPath[0] = '\0';
+
+	ASSERT_EQ(XN_STATUS_OK, xnUSBEnumerateDevices(TEST_VENDOR_ID, TEST_PRODUCT_ID, &astrPaths, &nCount));
+	EXPECT_EQ(0U, nCount);
+	xnUSBFreeDevicesList(astrPaths);
+
+	// the open handle fails from now on, but must still be closed
+	EXPECT_NE(XN_STATUS_OK, xnUSBSendControl(m_pDevice, XN_USB_CONTROL_TYPE_VENDOR, 0, 0, 0, aSent, sizeof(aSent), 1000));
+	EXPECT_NE(XN_STATUS_OK, xnUSBOpenEndPoint(m_pDevice, TEST_BULK_IN, XN_USB_EP_BULK, XN_USB_DIRECTION_IN, &m_pEndPoint));
+}
+
+TEST_F(USBSimulatorTest, BulkEndPointsTransferSynchronously)
+{
+	Connect();
+
+	XnUChar aBuffer[1000];
+	XnUInt32 nReceived = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBOpenEndPoint(m_pDevice, TEST_BULK_IN, XN_USB_EP_BULK, XN_USB_DIRECTION_IN, &m_pEndPoint));
+	ASSERT_EQ(XN_STATUS_OK, xnUSBReadEndPoint(m_pEndPoint, aBuffer, sizeof(aBuffer), &nReceived, 1000));
+	ASSERT_EQ(sizeof(aBuffer), nReceived);
+	for (XnUInt32 i = 0; i < nReceived; ++i)
+	{
+		ASSERT_EQ(i % XN_USB_SIMULATOR_PATTERN_PERIOD, aBuffer[i]);
+	}
+	ASSERT_EQ(XN_STATUS_OK, xnUSBCloseEndPoint(m_pEndPoint));
+	m_pEndPoint = NULL;
+
+	ASSERT_EQ(XN_STATUS_OK, xnUSBOpenEndPoint(m_pDevice, TEST_BULK_OUT, XN_USB_EP_BULK, XN_USB_DIRECTION_OUT, &m_pEndPoint));
+	ASSERT_EQ(XN_STATUS_OK, xnUSBWriteEndPoint(m_pEndPoint, aBuffer, sizeof(aBuffer), 1000));
+
+	XnUSBSimulatedEndPointStatistics stats;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBSimulatorGetEndPointStatistics(m_pEndPoint, &stats));
+	EXPECT_EQ(sizeof(aBuffer), stats.nBytesTransferred);
+}
+
+TEST_F(USBSimulatorTest, DisconnectEndsTheStreamOnce)
+{
+	const XnUInt64 nDisconnectAfter = 1000 * 1000 + 7;
+	m_aEndPoints[0].nDisconnectAfterBytes = nDisconnectAfter;
+	Connect();
+
+	XnRegistrationHandle hRegistration;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBRegisterToConnectivityEvents(TEST_VENDOR_ID, TEST_PRODUCT_ID, OnConnectivity, this, &hRegistration));
+
+	ASSERT_EQ(XN_STATUS_OK, xnUSBOpenEndPoint(m_pDevice, TEST_BULK_IN, XN_USB_EP_BULK, XN_USB_DIRECTION_IN, &m_pEndPoint));
+	ASSERT_EQ(XN_STATUS_OK, xnUSBInitReadThread(m_pEndPoint, 16 * 1024, 4, 100, OnRead, this));
+	WaitFor(m_nDisconnects, 1);
+	ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+	xnUSBUnregisterFromConnectivityEvents(hRegistration);
+
+	// everything the device sent arrived, and the disconnection was reported once for all the buffers
+	EXPECT_EQ(nDisconnectAfter, m_nBytes);
+	EXPECT_EQ(1U, m_nDisconnects);
+
+	const XnUSBConnectionString* astrPaths = NULL;
+	XnUInt32 nCount = 0;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBEnumerateDevices(TEST_VENDOR_ID, TEST_PRODUCT_ID, &astrPaths, &nCount));
+	EXPECT_EQ(0U, nCount);
+	xnUSBFreeDevicesList(astrPaths);
+	m_strPath[0] = '\0';
+}
+
+TEST_F(USBSimulatorTest, LostPacketsAreReported)
+{
+	// 2% of the packets are lost
+	m_aEndPoints[1].nBytesPerPacket = 700;
+	m_aEndPoints[1].nLossPerMillion = 20000;
+	m_aEndPoints[1].nJitter = 2000;
+	m_aEndPoints[1].nSeed = 1234;
+	Connect();
+
+	ASSERT_EQ(XN_STATUS_OK, xnUSBOpenEndPoint(m_pDevice, TEST_ISO_IN, XN_USB_EP_ISOCHRONOUS, XN_USB_DIRECTION_IN, &m_pEndPoint));
+	ASSERT_EQ(XN_STATUS_OK, xnUSBInitPacketReadThread(m_pEndPoint, 32 * 1024, 4, 1000, OnPackets, this));
+	WaitFor(m_nPackets, 4096);
+	ASSERT_EQ(XN_STATUS_OK, xnUSBShutdownReadThread(m_pEndPoint));
+
+	XnUSBSimulatedEndPointStatistics simulated;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBSimulatorGetEndPointStatistics(m_pEndPoint, &simulated));
+	XnUSBEndPointStatistics received;
+	ASSERT_EQ(XN_STATUS_OK, xnUSBGetEndPointStatistics(m_pEndPoint, &received));
+
+	EXPECT_LT(0U, m_nFailedPackets);
+	EXPECT_EQ(simulated.nPacketsLost, m_nFailedPackets);
+	EXPECT_EQ(simulated.nPacketsLost, received.nFailedPackets);
+	EXPECT_EQ(simulated.nPacketsLost * 700, simulated.nBytesLost);
+	EXPECT_EQ(simulated.nBytesTransferred, m_nBytes);
+	EXPECT_EQ(0U, simulated.nBytesOverrun);
+}
+
+#endif // XN_PLATFORM != XN_PLATFORM_WIN32
@@ -94,6 +94,32 @@ public class AudioMetaData extends OutputMetaData
 		NativeMethods.copyToBuffer(buffer, getDataPtr(), size);
 		return buffer;
 	}
+	
+	/**
+	 * Copies the audio data into a buffer taken from a pool. The caller owns the buffer, and
+	 * should return it to the pool when done with it.
+	 * @param pool Pool to take the buffer from
+	 * @return The buffer holding a copy of the audio data
+	 */
+	public ByteBuffer createByteBuffer(ByteBufferPool pool)
+	{
+		int size = getDataSize();
+		ByteBuffer buffer = pool.acquire(size);
+		NativeMethods.copyToBuffer(buffer, getDataPtr(), size);
+		return buffer;
+	}
+	
+	/**
+	 * Provides a read-only view of the audio data, without copying it. The view is only valid
+	 * until the audio generator is next updated.
+	 * @return A buffer wrapping the native data
+	 */
+	public ByteBuffer wrapByteBuffer()
+	{
+		ByteBuffer buffer = NativeMethods.createDirectBuffer(getDataPtr(), getDataSize()).asReadOnlyBuffer();
+		buffer.order(ByteOrder.LITTLE_ENDIAN);
+		return buffer;
+	}
 
 	private int sampleRate;
 	private short bitsPerSample;
@@ -0,0 +1,134 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+package org.openni;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayList;
+
+/**
+ * A pool of reusable direct buffers. <BR><BR>
+ * 
+ * Allocating a direct buffer is expensive, and its memory is only reclaimed after it is garbage
+ * collected. Applications that need to own a copy of every frame (for example, to pass it to
+ * another thread) can copy frames into buffers taken from a pool, and return the buffers to the
+ * pool once done with them, so that steady-state streaming allocates nothing.<BR><BR>
+ * 
+ * This class is thread safe.
+ *
+ */
+public class ByteBufferPool
+{
+	/**
+	 * Creates a new, empty pool.
+	 * @param maxFreeBuffers Maximum number of free buffers the pool keeps. Buffers released when the
+	 * pool is full are left for the garbage collector.
+	 */
+	public ByteBufferPool(int maxFreeBuffers)
+	{
+		this.maxFreeBuffers = maxFreeBuffers;
+	}
+	
+	/**
+	 * Takes a buffer from the pool, allocating a new one if no free buffer is large enough.
+	 * The returned buffer is positioned at zero, its limit is set to the requested size, and its
+	 * byte order is little endian.
+	 * @param size Required size, in bytes
+	 * @return A direct buffer of at least the requested capacity
+	 */
+	public synchronized ByteBuffer acquire(int size)
+	{
+		ByteBuffer buffer = null;
+		
+		// take the smallest free buffer that is large enough
+		int bestIndex = -1;
+		for (int i = 0; i < this.freeBuffers.size(); ++i)
+		{
+			int capacity = this.freeBuffers.get(i).capacity();
+			if (capacity >= size && (bestIndex == -1 || capacity < this.freeBuffers.get(bestIndex).capacity()))
+			{
+				bestIndex = i;
+			}
+		}
+		
+		if (bestIndex != -1)
+		{
+			buffer = this.freeBuffers.remove(bestIndex);
+		}
+		else
+		{
+			buffer = ByteBuffer.allocateDirect(size);
+			++this.allocationCount;
+		}
+		
+		buffer.clear();
+		buffer.limit(size);
+		buffer.order(ByteOrder.LITTLE_ENDIAN);
+		return buffer;
+	}
+	
+	/**
+	 * Returns a buffer to the pool. The buffer must not be used afterwards.
+	 * @param buffer A buffer previously returned by {@link #acquire(int)}
+	 */
+	public synchronized void release(ByteBuffer buffer)
+	{
+		if (!buffer.isDirect())
+		{
+			throw new IllegalArgumentException("Only direct buffers can be returned to the pool");
+		}
+		
+		if (this.freeBuffers.size() < this.maxFreeBuffers)
+		{
+			this.freeBuffers.add(buffer);
+		}
+	}
+	
+	/**
+	 * Drops all free buffers held by the pool.
+	 */
+	public synchronized void clear()
+	{
+		this.freeBuffers.clear();
+	}
+	
+	/**
+	 * Gets the number of free buffers currently held by the pool
+	 * @return Number of free buffers
+	 */
+	public synchronized int getFreeCount()
+	{
+		return this.freeBuffers.size();
+	}
+	
+	/**
+	 * Gets the number of buffers this pool has allocated since it was created
+	 * @return Number of allocations
+	 */
+	public synchronized long getAllocationCount()
+	{
+		return this.allocationCount;
+	}
+	
+	private final int maxFreeBuffers;
+	private final ArrayList<ByteBuffer> freeBuffers = new ArrayList<ByteBuffer>();
+	private long allocationCount;
+}
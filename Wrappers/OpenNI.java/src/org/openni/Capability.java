@@ -54,7 +54,8 @@ public enum Capability
 	Iris ("Iris"),
 	Focus ("Focus"),
 	LowLightCompensation ("LowLightCompensation"),
-	AntiFlicker ("AntiFlicker");
+	AntiFlicker ("AntiFlicker"),
+	FrameLease ("FrameLease");
 	
 	Capability(String name)
 	{
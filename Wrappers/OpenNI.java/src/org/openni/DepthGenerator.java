@@ -272,6 +272,35 @@ public class DepthGenerator extends MapGenerator
 		return depthMD;
 	}
 
+	/**
+	 * Creates a filter of this generator: a depth generator which, on each update, runs a chain of stages
+	 * over this generator's current frame (see xnCreateFilter() for the stages)
+	 * @param stages Stages to run, e.g. "crop:0,0,320,240;threshold:500,3000;median:5". null passes frames through.
+	 * @param name Name of the new node, or null to derive it from the name of this one
+	 * @return The new filter
+	 * @throws GeneralException If underlying native code returns errors, General Exception is thrown by this function
+	 */
+	public DepthGenerator createFilter(String stages, String name) throws GeneralException
+	{
+		OutArg<Long> handle = new OutArg<Long>();
+		int status = NativeMethods.xnCreateFilter(getContext().toNative(), toNative(), stages, name, handle);
+		WrapperUtils.throwOnError(status);
+		DepthGenerator result = (DepthGenerator)getContext().createProductionNodeObject(handle.value, NodeType.DEPTH);
+		NativeMethods.xnProductionNodeRelease(handle.value);
+		return result;
+	}
+
+	/**
+	 * Creates a filter of this generator, naming it after this one
+	 * @param stages Stages to run. null passes frames through.
+	 * @return The new filter
+	 * @throws GeneralException If underlying native code returns errors, General Exception is thrown by this function
+	 */
+	public DepthGenerator createFilter(String stages) throws GeneralException
+	{
+		return createFilter(stages, null);
+	}
+
 	private StateChangedObservable fovChanged;
 	private DepthMap currDepthMap;
 	private int currDepthMapFrameID;
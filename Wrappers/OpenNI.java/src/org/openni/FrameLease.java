@@ -0,0 +1,142 @@
+/*****************************************************************************
+*                                                                            *
+*  OpenNI 1.x Alpha                                                          *
+*  Copyright (C) 2012 PrimeSense Ltd.                                        *
+*                                                                            *
+*  This file is part of OpenNI.                                              *
+*                                                                            *
+*  Licensed under the Apache License, Version 2.0 (the "License");           *
+*  you may not use this file except in compliance with the License.          *
+*  You may obtain a copy of the License at                                   *
+*                                                                            *
+*      http://www.apache.org/licenses/LICENSE-2.0                            *
+*                                                                            *
+*  Unless required by applicable law or agreed to in writing, software       *
+*  distributed under the License is distributed on an "AS IS" BASIS,         *
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  *
+*  See the License for the specific language governing permissions and       *
+*  limitations under the License.                                            *
+*                                                                            *
+*****************************************************************************/
+package org.openni;
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+
+/**
+ * A frame leased from a generator. <BR><BR>
+ * 
+ * The frame memory stays valid (and unchanged) until {@link #release()} is called, no matter
+ * how many times the generator is updated meanwhile. This allows reading the frame directly
+ * from native memory, with no copy, for longer than a single update cycle.<BR><BR>
+ * 
+ * Leases are created using {@link Generator#acquireFrame()}. Only generators supporting the
+ * FrameLease capability can lease frames.
+ *
+ */
+public class FrameLease
+{
+	FrameLease(Generator generator, long ptr, int dataSize, long timestamp, int frameID)
+	{
+		this.generator = generator;
+		this.ptr = ptr;
+		this.dataSize = dataSize;
+		this.timestamp = timestamp;
+		this.frameID = frameID;
+	}
+	
+	/**
+	 * Provides a read-only view of the leased frame, without copying it. The view must not be
+	 * used after the lease is released.
+	 * @return A buffer wrapping the native frame memory
+	 */
+	public ByteBuffer getData()
+	{
+		if (this.buffer == null)
+		{
+			this.buffer = NativeMethods.createDirectBuffer(this.ptr, this.dataSize).asReadOnlyBuffer();
+			this.buffer.order(ByteOrder.LITTLE_ENDIAN);
+		}
+		
+		return this.buffer;
+	}
+	
+	/**
+	 * Provides native pointer to the leased frame
+	 * @return Pointer to the frame data, stored as a long integer
+	 */
+	public long getDataPtr()
+	{
+		return this.ptr;
+	}
+	
+	/**
+	 * Gets the size of the leased frame
+	 * @return Size of the frame, in bytes
+	 */
+	public int getDataSize()
+	{
+		return this.dataSize;
+	}
+	
+	/**
+	 * Gets the timestamp of the leased frame
+	 * @return Timestamp of the frame, in microseconds
+	 */
+	public long getTimestamp()
+	{
+		return this.timestamp;
+	}
+	
+	/**
+	 * Gets the frame ID of the leased frame
+	 * @return Frame ID
+	 */
+	public int getFrameID()
+	{
+		return this.frameID;
+	}
+	
+	/**
+	 * Gets the generator this frame was leased from
+	 * @return The generator
+	 */
+	public Generator getGenerator()
+	{
+		return this.generator;
+	}
+	
+	/**
+	 * Checks whether this lease was not released yet
+	 * @return TRUE if the frame is still leased, FALSE otherwise
+	 */
+	public boolean isValid()
+	{
+		return this.ptr != 0;
+	}
+	
+	/**
+	 * Returns the frame to the generator. Any buffer returned by {@link #getData()} must not be
+	 * used afterwards. Calling this function more than once has no effect.
+	 * @throws StatusException If underlying native code returns errors, a Status Exception will be generated
+	 */
+	public void release() throws StatusException
+	{
+		if (this.ptr == 0)
+		{
+			return;
+		}
+		
+		int status = NativeMethods.xnReleaseFrame(this.generator.toNative(), this.ptr, this.dataSize, this.timestamp, this.frameID);
+		this.ptr = 0;
+		this.buffer = null;
+		WrapperUtils.throwOnError(status);
+	}
+	
+	private final Generator generator;
+	private long ptr;
+	private final int dataSize;
+	private final long timestamp;
+	private final int frameID;
+	private ByteBuffer buffer;
+}
@@ -199,6 +199,51 @@ public class Generator extends ProductionNode
 		return buffer;
 	}
 	
+	/**
+	 * Copies this node's data into a buffer taken from a pool. The caller owns the buffer, and
+	 * should return it to the pool when done with it.
+	 * @param pool Pool to take the buffer from
+	 * @return The buffer holding a copy of the data
+	 */
+	public ByteBuffer createDataByteBuffer(ByteBufferPool pool)
+	{
+		int size = getDataSize();
+		ByteBuffer buffer = pool.acquire(size);
+		NativeMethods.copyToBuffer(buffer, getDataPtr(), size);
+		return buffer;
+	}
+	
+	/**
+	 * Provides a read-only view of this node's data, without copying it. The view is only valid
+	 * until the next time this node is updated. To keep a frame for longer, use {@link #acquireFrame()}
+	 * or one of the copying functions.
+	 * @return A buffer wrapping the native data
+	 */
+	public ByteBuffer wrapDataByteBuffer()
+	{
+		ByteBuffer buffer = NativeMethods.createDirectBuffer(getDataPtr(), getDataSize()).asReadOnlyBuffer();
+		buffer.order(ByteOrder.LITTLE_ENDIAN);
+		return buffer;
+	}
+	
+	/**
+	 * Leases the current frame of this node. The frame stays valid, and can be read with no
+	 * copy, until the lease is released, even if the node is updated meanwhile. The node must
+	 * support the FrameLease capability.
+	 * @return The lease
+	 * @throws StatusException If underlying native code returns errors, a Status Exception will be generated
+	 */
+	public FrameLease acquireFrame() throws StatusException
+	{
+		OutArg<Long> ptr = new OutArg<Long>();
+		OutArg<Integer> dataSize = new OutArg<Integer>();
+		OutArg<Long> timestamp = new OutArg<Long>();
+		OutArg<Integer> frameID = new OutArg<Integer>();
+		int status = NativeMethods.xnAcquireFrame(toNative(), ptr, dataSize, timestamp, frameID);
+		WrapperUtils.throwOnError(status);
+		return new FrameLease(this, ptr.value, dataSize.value, timestamp.value, frameID.value);
+	}
+	
 	/**
 	 * Copies the current data from this node into a given buffer
 	 * @param buffer Buffer to copy the data into
@@ -175,6 +175,35 @@ public class ImageGenerator extends MapGenerator
 		return ImageMD;
 	}
 
+	/**
+	 * Creates a filter of this generator: an image generator which, on each update, runs a chain of stages
+	 * over this generator's current frame (see xnCreateFilter() for the stages)
+	 * @param stages Stages to run, e.g. "crop:0,0,320,240;mirror". null passes frames through.
+	 * @param name Name of the new node, or null to derive it from the name of this one
+	 * @return The new filter
+	 * @throws GeneralException If underlying native code returns errors, General Exception is thrown by this function
+	 */
+	public ImageGenerator createFilter(String stages, String name) throws GeneralException
+	{
+		OutArg<Long> handle = new OutArg<Long>();
+		int status = NativeMethods.xnCreateFilter(getContext().toNative(), toNative(), stages, name, handle);
+		WrapperUtils.throwOnError(status);
+		ImageGenerator result = (ImageGenerator)getContext().createProductionNodeObject(handle.value, NodeType.IMAGE);
+		NativeMethods.xnProductionNodeRelease(handle.value);
+		return result;
+	}
+
+	/**
+	 * Creates a filter of this generator, naming it after this one
+	 * @param stages Stages to run. null passes frames through.
+	 * @return The new filter
+	 * @throws GeneralException If underlying native code returns errors, General Exception is thrown by this function
+	 */
+	public ImageGenerator createFilter(String stages) throws GeneralException
+	{
+		return createFilter(stages, null);
+	}
+
 	private ImageMap currImageMap;
 	private int currImageMapFrameID;
 	private StateChangedObservable pixelFormatChanged;
@@ -55,4 +55,24 @@ public class ImageMap extends Map
 	{
 		return super.createByteBuffer();
 	}
+	
+	/**
+	 * Copies the data in this map into a buffer taken from a pool
+	 * @param pool Pool to take the buffer from. The buffer should be returned to it when no longer needed.
+	 * @return The buffer holding a copy of the map
+	 */
+	public ByteBuffer createByteBuffer(ByteBufferPool pool)
+	{
+		return super.createByteBuffer(pool);
+	}
+	
+	/**
+	 * Provides a read-only view of the data in this map, without copying it. Valid until the
+	 * generator is next updated.
+	 * @return A buffer wrapping the native data
+	 */
+	public ByteBuffer wrapByteBuffer()
+	{
+		return super.wrapByteBuffer();
+	}
 }
@@ -88,6 +88,33 @@ public class Map
 		return buffer;
 	}
 	
+	/**
+	 * Copies the data of this map into a buffer taken from a pool. The caller owns the buffer,
+	 * and should return it to the pool when done with it.
+	 * @param pool Pool to take the buffer from
+	 * @return The buffer holding a copy of the map
+	 */
+	protected ByteBuffer createByteBuffer(ByteBufferPool pool)
+	{
+		int size = this.xRes * this.yRes * this.bytesPerPixel;
+		ByteBuffer buffer = pool.acquire(size);
+		NativeMethods.copyToBuffer(buffer, this.ptr, size);
+		return buffer;
+	}
+	
+	/**
+	 * Provides a read-only view of the native data of this map, without copying it. The view is
+	 * only valid as long as the native data is, that is, until the generator is next updated.
+	 * @return A buffer wrapping the native data
+	 */
+	protected ByteBuffer wrapByteBuffer()
+	{
+		int size = this.xRes * this.yRes * this.bytesPerPixel;
+		ByteBuffer buffer = NativeMethods.createDirectBuffer(this.ptr, size).asReadOnlyBuffer();
+		buffer.order(ByteOrder.LITTLE_ENDIAN);
+		return buffer;
+	}
+	
 	/**
 	 * Copies data from native code to a buffer available in Java
 	 * @param buffer The buffer to copy into 
@@ -47,6 +47,7 @@ class NativeMethods
 	static native int readInt(long ptr);
 	static native long readLong(long ptr);
 	static native void copyToBuffer(ByteBuffer buffer, long ptr, int size);
+	static native ByteBuffer createDirectBuffer(long ptr, int size);
 	static native long createProductionNodeDescription(int type, String vendor, String name, byte major, byte minor, short maintenance, int build);
 	static native void freeProductionNodeDescription(long pDescription);
 
@@ -66,6 +67,7 @@ class NativeMethods
 	static native int xnCreateAnyProductionTree(long pContext, int type, long pQuery, OutArg<Long> phNode, long pErrors);
 	//static native int xnCreateMockNode(long pContext, int type, String strName, OutArg<Long> phNode);
 	//static native int xnCreateMockNodeBasedOn(long pContext, long hOriginalNode, String strName, OutArg<Long> phMockNode);
+	static native int xnCreateFilter(long pContext, long hInput, String strStages, String strName, OutArg<Long> phFilter);
 	static native int xnEnumerateExistingNodes(long pContext, OutArg<Long> ppList);
 	static native int xnEnumerateExistingNodesByType(long pContext, int type, OutArg<Long> ppList);
 	static native int xnFindExistingRefNodeByType(long pContext, int type, OutArg<Long> phNode);
@@ -208,6 +210,8 @@ class NativeMethods
 	static native int xnGetDataSize(long hInstance);
 	static native long xnGetTimestamp(long hInstance);
 	static native int xnGetFrameID(long hInstance);
+	static native int xnAcquireFrame(long hInstance, OutArg<Long> pData, OutArg<Integer> pDataSize, OutArg<Long> pTimestamp, OutArg<Integer> pFrameID);
+	static native int xnReleaseFrame(long hInstance, long pData, int nDataSize, long nTimestamp, int nFrameID);
 
 	// Mirror Capability
 	static native int xnSetMirror(long hInstance, boolean bMirror);
@@ -464,6 +468,8 @@ class NativeMethods
 	static native void xnUnregisterFromEndOfFileReached(long hInstance, long hCallback);
 	static native int xnSetPlaybackSpeed(long hInstance, double dSpeed);
 	static native double xnGetPlaybackSpeed(long hInstance);
+	static native int xnSetPlayerRealTime(long hInstance, boolean bRealTime);
+	static native boolean xnIsPlayerRealTime(long hInstance);
 
 	// Script
 	static native int xnCreateScriptNode(long pContext, String strFormat, OutArg<Long> phScript);
@@ -188,5 +188,26 @@ public class Player extends ProductionNode
 		WrapperUtils.throwOnError(status);
 	}
 	
+	/**
+	 * Checks if the player drops frames that are already late (see setRealTime())
+	 * @return true if the player is in real-time mode
+	 */
+	public boolean isRealTime()
+	{
+		return NativeMethods.xnIsPlayerRealTime(toNative());
+	}
+	
+	/**
+	 * Turns real-time playback on or off. In real-time mode, the player keeps up with the wall clock by not
+	 * decoding frames which are superseded by a newer frame that is already due.
+	 * @param realTime true to drop late frames, false to play all frames
+	 * @throws StatusException If underlying native code returns errors, a Status Exception will be generated
+	 */
+	public void setRealTime(boolean realTime) throws StatusException
+	{
+		int status = NativeMethods.xnSetPlayerRealTime(toNative(), realTime);
+		WrapperUtils.throwOnError(status);
+	}
+	
 	private StateChangedObservable eofReached;
 }
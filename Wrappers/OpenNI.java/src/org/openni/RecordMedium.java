@@ -25,13 +25,13 @@ import java.util.NoSuchElementException;
 /**
  * Provides string names for all possible recording medium types. <BR><BR>
  * 
- * Currently, the only available recording medium is to record to a file,
- * so this enumeration is largely redundant until additional mediums are 
- * added.
+ * A recording can be written to a file, or streamed over a TCP connection
+ * to a listening player (in which case the medium name is "host:port").
  */
 public enum RecordMedium
 {
-	FILE (0);
+	FILE (0),
+	NETWORK (1);
 	
 	RecordMedium(int val)
 	{
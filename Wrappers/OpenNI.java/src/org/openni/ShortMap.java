@@ -72,5 +72,15 @@ public class ShortMap extends Map
 		return createByteBuffer().asShortBuffer();
 	}
 	
+	/**
+	 * Provides a read-only view of this map, without copying it. Valid until the generator is
+	 * next updated.
+	 * @return A buffer wrapping the native data
+	 */
+	public ShortBuffer wrapShortBuffer()
+	{
+		return wrapByteBuffer().asShortBuffer();
+	}
+	
 	private static final int BYTES_PER_PIXEL = Short.SIZE / 8;
 }
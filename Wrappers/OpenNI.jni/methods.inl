@@ -24,6 +24,7 @@ static JNINativeMethod methods[] = {
 	{ "readInt", "(J)I", (void*)&Java_org_openni_NativeMethods_readInt },
 	{ "readLong", "(J)J", (void*)&Java_org_openni_NativeMethods_readLong },
 	{ "copyToBuffer", "(Ljava/nio/ByteBuffer;JI)V", (void*)&Java_org_openni_NativeMethods_copyToBuffer },
+	{ "createDirectBuffer", "(JI)Ljava/nio/ByteBuffer;", (void*)&Java_org_openni_NativeMethods_createDirectBuffer },
 	{ "createProductionNodeDescription", "(ILjava/lang/String;Ljava/lang/String;BBSI)J", (void*)&Java_org_openni_NativeMethods_createProductionNodeDescription },
 	{ "freeProductionNodeDescription", "(J)V", (void*)&Java_org_openni_NativeMethods_freeProductionNodeDescription },
 	{ "xnGetStatusString", "(I)Ljava/lang/String;", (void*)&Java_org_openni_NativeMethods_xnGetStatusString },
@@ -37,6 +38,7 @@ static JNINativeMethod methods[] = {
 	{ "xnEnumerateProductionTrees", "(JIJLorg/openni/OutArg;J)I", (void*)&Java_org_openni_NativeMethods_xnEnumerateProductionTrees },
 	{ "xnCreateProductionTree", "(JJLorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnCreateProductionTree },
 	{ "xnCreateAnyProductionTree", "(JIJLorg/openni/OutArg;J)I", (void*)&Java_org_openni_NativeMethods_xnCreateAnyProductionTree },
+	{ "xnCreateFilter", "(JJLjava/lang/String;Ljava/lang/String;Lorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnCreateFilter },
 	{ "xnEnumerateExistingNodes", "(JLorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnEnumerateExistingNodes },
 	{ "xnEnumerateExistingNodesByType", "(JILorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnEnumerateExistingNodesByType },
 	{ "xnFindExistingRefNodeByType", "(JILorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnFindExistingRefNodeByType },
@@ -146,6 +148,8 @@ static JNINativeMethod methods[] = {
 	{ "xnGetDataSize", "(J)I", (void*)&Java_org_openni_NativeMethods_xnGetDataSize },
 	{ "xnGetTimestamp", "(J)J", (void*)&Java_org_openni_NativeMethods_xnGetTimestamp },
 	{ "xnGetFrameID", "(J)I", (void*)&Java_org_openni_NativeMethods_xnGetFrameID },
+	{ "xnAcquireFrame", "(JLorg/openni/OutArg;Lorg/openni/OutArg;Lorg/openni/OutArg;Lorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnAcquireFrame },
+	{ "xnReleaseFrame", "(JJIJI)I", (void*)&Java_org_openni_NativeMethods_xnReleaseFrame },
 	{ "xnSetMirror", "(JZ)I", (void*)&Java_org_openni_NativeMethods_xnSetMirror },
 	{ "xnIsMirrored", "(J)Z", (void*)&Java_org_openni_NativeMethods_xnIsMirrored },
 	{ "xnRegisterToMirrorChange", "(JLjava/lang/Object;Ljava/lang/String;Lorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnRegisterToMirrorChange },
@@ -328,6 +332,8 @@ static JNINativeMethod methods[] = {
 	{ "xnUnregisterFromEndOfFileReached", "(JJ)V", (void*)&Java_org_openni_NativeMethods_xnUnregisterFromEndOfFileReached },
 	{ "xnSetPlaybackSpeed", "(JD)I", (void*)&Java_org_openni_NativeMethods_xnSetPlaybackSpeed },
 	{ "xnGetPlaybackSpeed", "(J)D", (void*)&Java_org_openni_NativeMethods_xnGetPlaybackSpeed },
+	{ "xnSetPlayerRealTime", "(JZ)I", (void*)&Java_org_openni_NativeMethods_xnSetPlayerRealTime },
+	{ "xnIsPlayerRealTime", "(J)Z", (void*)&Java_org_openni_NativeMethods_xnIsPlayerRealTime },
 	{ "xnCreateScriptNode", "(JLjava/lang/String;Lorg/openni/OutArg;)I", (void*)&Java_org_openni_NativeMethods_xnCreateScriptNode },
 	{ "xnScriptNodeGetSupportedFormat", "(J)Ljava/lang/String;", (void*)&Java_org_openni_NativeMethods_xnScriptNodeGetSupportedFormat },
 	{ "xnLoadScriptFromFile", "(JLjava/lang/String;)I", (void*)&Java_org_openni_NativeMethods_xnLoadScriptFromFile },
@@ -146,6 +146,12 @@ JNIEXPORT void JNICALL Java_org_openni_NativeMethods_copyToBuffer(JNIEnv *env, j
 	memcpy(pDest, (const void*)ptr, size);
 }
 
+JNIEXPORT jobject JNICALL Java_org_openni_NativeMethods_createDirectBuffer(JNIEnv *env, jclass, jlong ptr, jint size)
+{
+	// no copy - the buffer is a view of native memory, and is only valid as long as that memory is
+	return env->NewDirectByteBuffer((void*)ptr, size);
+}
+
 JNIEXPORT jlong JNICALL 
 Java_org_openni_NativeMethods_createProductionNodeDescription(JNIEnv *env, jclass /*cls*/, jint type, jstring vendor, jstring name, jbyte major, jbyte minor, jshort maintenance, jint build)
 {
@@ -533,6 +539,29 @@ JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnCreateAnyProductionTree(J
 	return XN_STATUS_OK;
 }
 
+JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnCreateFilter(JNIEnv *env, jclass, jlong pContext, jlong hInput, jstring strStages, jstring strName, jobject phFilter)
+{
+	// both strings are optional (and JavaString can't take null)
+	const XnChar* strStagesUTF = (strStages == NULL) ? NULL : env->GetStringUTFChars(strStages, NULL);
+	const XnChar* strNameUTF = (strName == NULL) ? NULL : env->GetStringUTFChars(strName, NULL);
+
+	XnNodeHandle hFilter = NULL;
+	XnStatus nRetVal = xnCreateFilter((XnContext*)pContext, (XnNodeHandle)hInput, strStagesUTF, strNameUTF, &hFilter);
+
+	if (strStagesUTF != NULL)
+	{
+		env->ReleaseStringUTFChars(strStages, strStagesUTF);
+	}
+	if (strNameUTF != NULL)
+	{
+		env->ReleaseStringUTFChars(strName, strNameUTF);
+	}
+
+	XN_IS_STATUS_OK(nRetVal);
+	SetOutArgPointerValue(env, phFilter, hFilter);
+	return XN_STATUS_OK;
+}
+
 static void XN_CALLBACK_TYPE ErrorStateChangedHandler(XnStatus errorState, void* pCookie)
 {
 	CallbackCookie* pCallback = (CallbackCookie*)pCookie;
@@ -1389,6 +1418,30 @@ Java_org_openni_NativeMethods_xnGetFrameID(JNIEnv *, jclass, jlong hNode)
 	return xnGetFrameID((XnNodeHandle)hNode);
 }
 
+JNIEXPORT jint JNICALL
+Java_org_openni_NativeMethods_xnAcquireFrame(JNIEnv *env, jclass, jlong hNode, jobject pData, jobject pDataSize, jobject pTimestamp, jobject pFrameID)
+{
+	XnFrameLease lease;
+	XnStatus nRetVal = xnAcquireFrame((XnNodeHandle)hNode, &lease);
+	XN_IS_STATUS_OK(nRetVal);
+	SetOutArgPointerValue(env, pData, lease.pData);
+	SetOutArgIntValue(env, pDataSize, lease.nDataSize);
+	SetOutArgLongValue(env, pTimestamp, lease.nTimestamp);
+	SetOutArgIntValue(env, pFrameID, lease.nFrameID);
+	return XN_STATUS_OK;
+}
+
+JNIEXPORT jint JNICALL
+Java_org_openni_NativeMethods_xnReleaseFrame(JNIEnv *, jclass, jlong hNode, jlong pData, jint nDataSize, jlong nTimestamp, jint nFrameID)
+{
+	XnFrameLease lease;
+	lease.pData = (const void*)pData;
+	lease.nDataSize = nDataSize;
+	lease.nTimestamp = nTimestamp;
+	lease.nFrameID = nFrameID;
+	return xnReleaseFrame((XnNodeHandle)hNode, &lease);
+}
+
 //---------------------------------------------------------------------------
 // Mirror
 //---------------------------------------------------------------------------
@@ -2933,6 +2986,16 @@ JNIEXPORT jdouble JNICALL Java_org_openni_NativeMethods_xnGetPlaybackSpeed(JNIEn
 	return xnGetPlaybackSpeed((XnNodeHandle)hNode);
 }
 
+JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnSetPlayerRealTime(JNIEnv *, jclass, jlong hNode, jboolean bRealTime)
+{
+	return xnSetPlayerRealTime((XnNodeHandle)hNode, bRealTime);
+}
+
+JNIEXPORT jboolean JNICALL Java_org_openni_NativeMethods_xnIsPlayerRealTime(JNIEnv *, jclass, jlong hNode)
+{
+	return (jboolean)xnIsPlayerRealTime((XnNodeHandle)hNode);
+}
+
 
 //---------------------------------------------------------------------------
 // ScriptNode
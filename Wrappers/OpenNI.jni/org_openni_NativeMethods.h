@@ -67,6 +67,14 @@ JNIEXPORT jlong JNICALL Java_org_openni_NativeMethods_readLong
 JNIEXPORT void JNICALL Java_org_openni_NativeMethods_copyToBuffer
   (JNIEnv *, jclass, jobject, jlong, jint);
 
+/*
+ * Class:     org_openni_NativeMethods
+ * Method:    createDirectBuffer
+ * Signature: (JI)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_org_openni_NativeMethods_createDirectBuffer
+  (JNIEnv *, jclass, jlong, jint);
+
 /*
  * Class:     org_openni_NativeMethods
  * Method:    createProductionNodeDescription
@@ -171,6 +179,14 @@ JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnCreateProductionTree
 JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnCreateAnyProductionTree
   (JNIEnv *, jclass, jlong, jint, jlong, jobject, jlong);
 
+/*
+ * Class:     org_openni_NativeMethods
+ * Method:    xnCreateFilter
+ * Signature: (JJLjava/lang/String;Ljava/lang/String;Lorg/openni/OutArg;)I
+ */
+JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnCreateFilter
+  (JNIEnv *, jclass, jlong, jlong, jstring, jstring, jobject);
+
 /*
  * Class:     org_openni_NativeMethods
  * Method:    xnEnumerateExistingNodes
@@ -1043,6 +1059,22 @@ JNIEXPORT jlong JNICALL Java_org_openni_NativeMethods_xnGetTimestamp
 JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnGetFrameID
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_openni_NativeMethods
+ * Method:    xnAcquireFrame
+ * Signature: (JLorg/openni/OutArg;Lorg/openni/OutArg;Lorg/openni/OutArg;Lorg/openni/OutArg;)I
+ */
+JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnAcquireFrame
+  (JNIEnv *, jclass, jlong, jobject, jobject, jobject, jobject);
+
+/*
+ * Class:     org_openni_NativeMethods
+ * Method:    xnReleaseFrame
+ * Signature: (JJIJI)I
+ */
+JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnReleaseFrame
+  (JNIEnv *, jclass, jlong, jlong, jint, jlong, jint);
+
 /*
  * Class:     org_openni_NativeMethods
  * Method:    xnSetMirror
@@ -2499,6 +2531,22 @@ JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnSetPlaybackSpeed
 JNIEXPORT jdouble JNICALL Java_org_openni_NativeMethods_xnGetPlaybackSpeed
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     org_openni_NativeMethods
+ * Method:    xnSetPlayerRealTime
+ * Signature: (JZ)I
+ */
+JNIEXPORT jint JNICALL Java_org_openni_NativeMethods_xnSetPlayerRealTime
+  (JNIEnv *, jclass, jlong, jboolean);
+
+/*
+ * Class:     org_openni_NativeMethods
+ * Method:    xnIsPlayerRealTime
+ * Signature: (J)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_openni_NativeMethods_xnIsPlayerRealTime
+  (JNIEnv *, jclass, jlong);
+
 /*
  * Class:     org_openni_NativeMethods
  * Method:    xnCreateScriptNode
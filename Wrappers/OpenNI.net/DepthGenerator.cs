@@ -164,6 +164,19 @@ namespace OpenNI
 			return depthMD;
 		}
 
+		public DepthGenerator CreateFilter(string stages, string name)
+		{
+			IntPtr handle;
+			int status = SafeNativeMethods.xnCreateFilter(this.Context.InternalObject, this.InternalObject, stages, name, out handle);
+			WrapperUtils.ThrowOnError(status);
+			return new DepthGenerator(this.Context, handle, false);
+		}
+
+		public DepthGenerator CreateFilter(string stages)
+		{
+			return CreateFilter(stages, null);
+		}
+
 		private static IntPtr Create(Context context, Query query, EnumerationErrors errors)
 		{
 			IntPtr handle;
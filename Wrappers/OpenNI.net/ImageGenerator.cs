@@ -106,6 +106,19 @@ namespace OpenNI
 			return imageMD;
 		}
 
+		public ImageGenerator CreateFilter(string stages, string name)
+		{
+			IntPtr handle;
+			int status = SafeNativeMethods.xnCreateFilter(this.Context.InternalObject, this.InternalObject, stages, name, out handle);
+			WrapperUtils.ThrowOnError(status);
+			return new ImageGenerator(this.Context, handle, false);
+		}
+
+		public ImageGenerator CreateFilter(string stages)
+		{
+			return CreateFilter(stages, null);
+		}
+
 		public event EventHandler PixelFormatChanged
 		{
 			add { this.pixelFormatChanged.Event += value; }
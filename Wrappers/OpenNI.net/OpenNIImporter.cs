@@ -193,6 +193,9 @@ namespace OpenNI
 	{
 		/** Recording medium is a file **/
 		File = 0,
+
+		/** Recording medium is a TCP connection ("host:port") **/
+		Network = 1,
 	};
 
 	public enum PlayerSeekOrigin
@@ -971,6 +974,8 @@ namespace OpenNI
 		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
 		public static extern XnStatus xnCreateMockNodeBasedOn(XnContext pContext, XnNodeHandle hOriginalNode, string strName, out XnNodeHandle phMockNode);
 		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
+		public static extern XnStatus xnCreateFilter(XnContext pContext, XnNodeHandle hInput, string strStages, string strName, out XnNodeHandle phFilter);
+		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
 		public static extern XnStatus xnProductionNodeAddRef(XnNodeHandle hNode);
 		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
 		public static extern void xnProductionNodeRelease(XnNodeHandle hNode);
@@ -1579,6 +1584,10 @@ namespace OpenNI
 		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
 		public static extern XnDouble xnGetPlaybackSpeed(XnNodeHandle hInstance);
 		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
+		public static extern XnStatus xnSetPlayerRealTime(XnNodeHandle hInstance, XnBool bRealTime);
+		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
+		public static extern XnBool xnIsPlayerRealTime(XnNodeHandle hInstance);
+		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
 		public static extern XnStatus xnNodeInfoSetInstanceName(XnNodeInfo pNodeInfo, string strInstanceName);
 		[DllImport(openNILibraryName, CallingConvention = CallingConvention.Cdecl)]
 		public static extern IntPtr xnNodeInfoGetDescription(XnNodeInfo pNodeInfo);
@@ -172,6 +172,19 @@ namespace OpenNI
 			}
 		}
 
+		public bool RealTime
+		{
+			get
+			{
+				return SafeNativeMethods.xnIsPlayerRealTime(this.InternalObject);
+			}
+			set
+			{
+				int status = SafeNativeMethods.xnSetPlayerRealTime(this.InternalObject, value);
+				WrapperUtils.ThrowOnError(status);
+			}
+		}
+
 		private static IntPtr Create(Context context, string formatName)
 		{
 			IntPtr nodeHandle;